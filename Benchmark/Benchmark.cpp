@@ -0,0 +1,327 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+// Headless DSP benchmark: renders a patch offline, without an editor and without running the message loop
+// Usage: plugdata_bench <patch.pd> [--seconds 10] [--samplerate 48000] [--blocksize 64] [--channels 2] [--compare]
+// With --compare, the patch is also compiled with Heavy and rendered through the generated C code, to show what compiling it would gain
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+// Workaround for naming issue on windows
+#include <juce_graphics/juce_graphics.h>
+#define Rectangle juce::Rectangle
+
+#include <PluginProcessor.h>
+
+#include <new>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+
+// Counts allocations made by the thread that renders audio, every allocation there is a potential dropout
+static thread_local bool isRenderingAudio = false;
+static std::atomic<int64> numAudioThreadAllocations = 0;
+
+// With the realtime-safety checks, the plugin already replaces the global operator new, and there can only be one
+#if !PLUGDATA_REALTIME_SAFETY_CHECKS
+static void* countedAllocation(std::size_t size)
+{
+    if (isRenderingAudio)
+        numAudioThreadAllocations++;
+
+    if (auto* ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return countedAllocation(size); }
+void* operator new[](std::size_t size) { return countedAllocation(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
+
+static void printAudioThreadAllocations()
+{
+#if PLUGDATA_REALTIME_SAFETY_CHECKS
+    std::cout << "Allocations on the audio thread: see the realtime-safety report" << std::endl;
+#else
+    std::cout << "Allocations on the audio thread: " << numAudioThreadAllocations.load() << std::endl;
+#endif
+}
+
+struct BenchmarkSettings {
+    File patchFile;
+    double seconds = 10.0;
+    double sampleRate = 48000.0;
+    int blockSize = 64;
+    int numChannels = 2;
+    bool compareWithHeavy = false;
+
+    static std::optional<BenchmarkSettings> fromArguments(ArgumentList const& args)
+    {
+        if (args.size() < 1 || args[0].isOption())
+            return std::nullopt;
+
+        BenchmarkSettings settings;
+        settings.patchFile = args[0].resolveAsFile();
+
+        auto getValue = [&args](String const& option, auto defaultValue) {
+            auto value = args.getValueForOption(option);
+            return value.isEmpty() ? defaultValue : static_cast<decltype(defaultValue)>(value.getDoubleValue());
+        };
+
+        settings.seconds = getValue("--seconds", settings.seconds);
+        settings.sampleRate = getValue("--samplerate", settings.sampleRate);
+        settings.blockSize = getValue("--blocksize", settings.blockSize);
+        settings.numChannels = getValue("--channels", settings.numChannels);
+        settings.compareWithHeavy = args.containsOption("--compare");
+
+        if (!settings.patchFile.existsAsFile() || settings.seconds <= 0.0 || settings.sampleRate <= 0.0 || settings.blockSize <= 0 || settings.numChannels <= 0)
+            return std::nullopt;
+
+        return settings;
+    }
+};
+
+static double getPercentile(std::vector<double> values, double percentile)
+{
+    if (values.empty())
+        return 0.0;
+
+    auto const index = std::min(values.size() - 1, static_cast<size_t>(percentile * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+struct RenderResult {
+    double totalTime = 0.0;
+    std::vector<double> blockTimes;
+
+    // Only kept when comparing, so the outputs can be compared afterwards
+    AudioBuffer<float> output;
+};
+
+static void printBlockTimes(RenderResult const& result)
+{
+    std::cout << "Block time p50: " << getPercentile(result.blockTimes, 0.5) * 1e6 << "us, p99: " << getPercentile(result.blockTimes, 0.99) * 1e6 << "us, max: " << *std::max_element(result.blockTimes.begin(), result.blockTimes.end()) * 1e6 << "us" << std::endl;
+}
+
+static std::optional<RenderResult> renderWithPd(BenchmarkSettings const& settings, int64 numBlocks)
+{
+    auto processor = std::make_unique<PluginProcessor>();
+    processor->setPlayConfigDetails(settings.numChannels, settings.numChannels, settings.sampleRate, settings.blockSize);
+    processor->setNonRealtime(true);
+    processor->prepareToPlay(settings.sampleRate, settings.blockSize);
+
+    if (!processor->loadPatch(settings.patchFile, nullptr)) {
+        std::cerr << "Couldn't open patch: " << settings.patchFile.getFullPathName() << std::endl;
+        return std::nullopt;
+    }
+
+    RenderResult result;
+    result.blockTimes.reserve(static_cast<size_t>(numBlocks));
+    if (settings.compareWithHeavy)
+        result.output.setSize(settings.numChannels, static_cast<int>(numBlocks * settings.blockSize));
+
+    AudioBuffer<float> buffer(settings.numChannels, settings.blockSize);
+    MidiBuffer midiBuffer;
+
+    auto const startTime = Time::getHighResolutionTicks();
+
+    isRenderingAudio = true;
+    for (int64 block = 0; block < numBlocks; block++) {
+        buffer.clear();
+        midiBuffer.clear();
+
+        auto const blockStart = Time::getHighResolutionTicks();
+        processor->processBlock(buffer, midiBuffer);
+        result.blockTimes.push_back(Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - blockStart));
+
+        if (settings.compareWithHeavy) {
+            for (int ch = 0; ch < settings.numChannels; ch++)
+                result.output.copyFrom(ch, static_cast<int>(block * settings.blockSize), buffer, ch, 0, settings.blockSize);
+        }
+    }
+    isRenderingAudio = false;
+
+    result.totalTime = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTime);
+
+    processor->releaseResources();
+    return result;
+}
+
+// Generates C code for the patch with hvcc, and compiles it into a shared library we can load
+// Uses the Heavy from plugdata's toolchain, and the system's C and C++ compilers (or $CC and $CXX)
+static std::optional<File> buildHeavyLibrary(BenchmarkSettings const& settings, File const& buildDir, String const& name)
+{
+#if JUCE_WINDOWS
+    ignoreUnused(settings, buildDir, name);
+    std::cerr << "Comparing with Heavy isn't supported on Windows yet" << std::endl;
+    return std::nullopt;
+#else
+    auto const heavyExecutable = ProjectInfo::appDataDir.getChildFile("Toolchain").getChildFile("bin").getChildFile("Heavy").getChildFile("Heavy");
+    if (!heavyExecutable.existsAsFile()) {
+        std::cerr << "Heavy not found, install the toolchain from the compiled mode export dialog first" << std::endl;
+        return std::nullopt;
+    }
+
+    auto const library = buildDir.getChildFile("lib" + name + ".so");
+    auto const quoted = [](File const& file) { return file.getFullPathName().quoted(); };
+
+    String script;
+    script << quoted(heavyExecutable) << " " << quoted(settings.patchFile) << " -o " << quoted(buildDir) << " -n " << name << " -p " << quoted(settings.patchFile.getParentDirectory()) << " && ";
+    script << "cd " << quoted(buildDir.getChildFile("c")) << " && ";
+    script << "${CC:-cc} -O3 -fPIC -c *.c && ";
+    script << "${CXX:-c++} -O3 -fPIC -std=c++11 -c *.cpp && ";
+    script << "${CXX:-c++} -shared *.o -o " << quoted(library);
+
+    ChildProcess process;
+    if (!process.start(StringArray { "/bin/sh", "-c", script })) {
+        std::cerr << "Couldn't start the Heavy build" << std::endl;
+        return std::nullopt;
+    }
+
+    auto const output = process.readAllProcessOutput();
+    if (process.getExitCode() != 0 || !library.existsAsFile()) {
+        std::cerr << "Compiling the patch with Heavy failed:" << std::endl
+                  << output << std::endl;
+        return std::nullopt;
+    }
+
+    return library;
+#endif
+}
+
+static std::optional<RenderResult> renderWithHeavy(BenchmarkSettings const& settings, int64 numBlocks)
+{
+    // Heavy's C API, see HvHeavy.h in the generated code
+    using NewFunction = void* (*)(double);
+    using ProcessFunction = int (*)(void*, float*, float*, int);
+    using ChannelsFunction = int (*)(void*);
+    using DeleteFunction = void (*)(void*);
+
+    auto const name = String("bench");
+    auto const buildDir = File::createTempFile("_heavy_bench");
+    buildDir.createDirectory();
+
+    auto const library = buildHeavyLibrary(settings, buildDir, name);
+    if (!library) {
+        buildDir.deleteRecursively();
+        return std::nullopt;
+    }
+
+    DynamicLibrary heavy;
+    heavy.open(library->getFullPathName());
+
+    auto const createContext = reinterpret_cast<NewFunction>(heavy.getFunction("hv_" + name + "_new"));
+    auto const process = reinterpret_cast<ProcessFunction>(heavy.getFunction("hv_processInline"));
+    auto const getNumOutputs = reinterpret_cast<ChannelsFunction>(heavy.getFunction("hv_getNumOutputChannels"));
+    auto const getNumInputs = reinterpret_cast<ChannelsFunction>(heavy.getFunction("hv_getNumInputChannels"));
+    auto const deleteContext = reinterpret_cast<DeleteFunction>(heavy.getFunction("hv_delete"));
+
+    if (!createContext || !process || !getNumOutputs || !getNumInputs || !deleteContext) {
+        std::cerr << "The library Heavy generated doesn't have the functions we need" << std::endl;
+        buildDir.deleteRecursively();
+        return std::nullopt;
+    }
+
+    auto* context = createContext(settings.sampleRate);
+    auto const numInputs = std::max(1, getNumInputs(context));
+    auto const numOutputs = std::max(1, getNumOutputs(context));
+
+    RenderResult result;
+    result.blockTimes.reserve(static_cast<size_t>(numBlocks));
+    result.output.setSize(settings.numChannels, static_cast<int>(numBlocks * settings.blockSize));
+
+    // Heavy takes all channels of a block after each other in a single buffer
+    std::vector<float> inputs(static_cast<size_t>(numInputs * settings.blockSize), 0.0f);
+    std::vector<float> outputs(static_cast<size_t>(numOutputs * settings.blockSize), 0.0f);
+
+    auto const startTime = Time::getHighResolutionTicks();
+
+    isRenderingAudio = true;
+    for (int64 block = 0; block < numBlocks; block++) {
+        std::fill(inputs.begin(), inputs.end(), 0.0f);
+
+        auto const blockStart = Time::getHighResolutionTicks();
+        process(context, inputs.data(), outputs.data(), settings.blockSize);
+        result.blockTimes.push_back(Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - blockStart));
+
+        for (int ch = 0; ch < std::min(numOutputs, settings.numChannels); ch++)
+            result.output.copyFrom(ch, static_cast<int>(block * settings.blockSize), outputs.data() + ch * settings.blockSize, settings.blockSize);
+    }
+    isRenderingAudio = false;
+
+    result.totalTime = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTime);
+
+    deleteContext(context);
+    heavy.close();
+    buildDir.deleteRecursively();
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    auto const args = ArgumentList(argc, argv);
+    auto const settings = BenchmarkSettings::fromArguments(args);
+    if (!settings) {
+        std::cerr << "Usage: plugdata_bench <patch.pd> [--seconds 10] [--samplerate 48000] [--blocksize 64] [--channels 2] [--compare]" << std::endl;
+        return 1;
+    }
+
+    // The processor needs a MessageManager to exist, but we never run its loop
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    auto const numBlocks = static_cast<int64>(std::ceil(settings->seconds * settings->sampleRate / settings->blockSize));
+    auto const renderedTime = static_cast<double>(numBlocks * settings->blockSize) / settings->sampleRate;
+
+    auto const pdResult = renderWithPd(*settings, numBlocks);
+    if (!pdResult)
+        return 1;
+
+    std::cout << "Patch: " << settings->patchFile.getFileName() << std::endl;
+    std::cout << "Rendered " << renderedTime << "s at " << settings->sampleRate << "Hz, block size " << settings->blockSize << ", " << settings->numChannels << " channels" << std::endl;
+    std::cout << "Realtime factor: " << (pdResult->totalTime > 0.0 ? renderedTime / pdResult->totalTime : 0.0) << "x" << std::endl;
+    printBlockTimes(*pdResult);
+    printAudioThreadAllocations();
+
+    if (!settings->compareWithHeavy)
+        return 0;
+
+    numAudioThreadAllocations = 0;
+    auto const heavyResult = renderWithHeavy(*settings, numBlocks);
+    if (!heavyResult)
+        return 1;
+
+    std::cout << std::endl
+              << "Compiled with Heavy:" << std::endl;
+    std::cout << "Realtime factor: " << (heavyResult->totalTime > 0.0 ? renderedTime / heavyResult->totalTime : 0.0) << "x" << std::endl;
+    printBlockTimes(*heavyResult);
+    printAudioThreadAllocations();
+    std::cout << "Speedup: " << (heavyResult->totalTime > 0.0 ? pdResult->totalTime / heavyResult->totalTime : 0.0) << "x" << std::endl;
+
+    // The processor applies its own output gain and limiter, so expect small differences on loud patches
+    for (int ch = 0; ch < settings->numChannels; ch++) {
+        double maxDifference = 0.0;
+        double squaredDifference = 0.0;
+        auto const* pd = pdResult->output.getReadPointer(ch);
+        auto const* hv = heavyResult->output.getReadPointer(ch);
+        auto const numSamples = pdResult->output.getNumSamples();
+        for (int i = 0; i < numSamples; i++) {
+            auto const difference = std::abs(static_cast<double>(pd[i]) - static_cast<double>(hv[i]));
+            maxDifference = std::max(maxDifference, difference);
+            squaredDifference += difference * difference;
+        }
+
+        auto const rmsDifference = numSamples > 0 ? std::sqrt(squaredDifference / numSamples) : 0.0;
+        std::cout << "Channel " << ch + 1 << " difference, max: " << maxDifference << ", rms: " << rmsDifference << std::endl;
+    }
+
+    return 0;
+}
@@ -3,6 +3,7 @@
 #     By doing this at compile time, we can save having to parse all the docs on startup
 
 import os
+import struct
 import xml.etree.cElementTree as ET
 
 # Write n bytes from a number
@@ -60,6 +61,50 @@ def writeToStream(stream, object):
     for child in object:
       writeToStream(stream, child)
 
+# 64-bit FNV-1a hash of the object name, must match the one in Library.cpp
+def hashName(name):
+  result = 0xcbf29ce484222325
+  for b in name.encode('utf-8'):
+    result ^= b
+    result = (result * 0x100000001b3) & 0xFFFFFFFFFFFFFFFF
+  return result
+
+# Write the documentation in plugdata's compact format, so that objects can be looked up without decoding everything:
+#   header:     "PDDC", version, number of objects, number of categories (all uint32)
+#   table:      for every object: name hash (uint64), offset and size of its documentation (uint32), sorted by hash
+#   categories: null-terminated UTF8 strings
+#   objects:    the documentation of each object, in JUCE's ValueTree binary format
+def writeCompactStream(stream, root):
+  objects = []
+  categories = []
+  for child in root:
+    objectStream = bytearray()
+    writeToStream(objectStream, child)
+    objects.append((hashName(child.get("name", "").strip()), objectStream))
+
+    for category in child.iter("category"):
+      name = category.get("name", "").strip()
+      if name not in categories:
+        categories.append(name)
+
+  objects.sort(key=lambda entry: entry[0])
+
+  categoryBytes = bytearray()
+  for category in categories:
+    categoryBytes += cString(category)
+
+  stream += b"PDDC"
+  stream += struct.pack("<III", 1, len(objects), len(categories))
+
+  offset = len(stream) + len(objects) * 16 + len(categoryBytes)
+  for nameHash, objectStream in objects:
+    stream += struct.pack("<QII", nameHash, offset, len(objectStream))
+    offset += len(objectStream)
+
+  stream += categoryBytes
+  for nameHash, objectStream in objects:
+    stream += objectStream
+
 # Separate markdown by "-"
 def sectionsFromHyphens(text):
     lastIdx = 0
@@ -280,9 +325,9 @@ def parseFilesInDir(dir, generateXml, generateWebsite):
     tree = ET.ElementTree(root)
     tree.write("../Documentation/Documentation.xml")
 
-  # Convert xml to JUCE ValueTree binary format
+  # Convert xml to our compact binary format
   stream = bytearray()
-  writeToStream(stream, root)
+  writeCompactStream(stream, root)
 
   if generateWebsite:
     for child in root:
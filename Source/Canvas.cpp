@@ -24,6 +24,7 @@
 #include "Dialogs/Dialogs.h"
 #include "Components/GraphArea.h"
 #include "Utility/RateReducer.h"
+#include "Utility/Tracing.h"
 
 extern "C" {
 void canvas_setgraph(t_glist* x, int flag, int nogoprect);
@@ -48,6 +49,9 @@ Canvas::Canvas(PluginEditor* parent, pd::Patch::Ptr p, Component* parentGraph)
 
     pd->registerMessageListener(patch.getPointer().get(), this);
 
+    if (!parentGraph)
+        pd->registerCanvas(this, patch.getUncheckedPointer());
+
     isGraphChild.addListener(this);
     hideNameAndArgs.addListener(this);
     xRange.addListener(this);
@@ -114,6 +118,9 @@ Canvas::Canvas(PluginEditor* parent, pd::Patch::Ptr p, Component* parentGraph)
     zoomScale.setValue(getValue<float>(defaultZoom) / 100.0f);
     zoomScale.addListener(this);
 
+    levelOfDetailZoom.referTo(SettingsFile::getInstance()->getPropertyAsValue("level_of_detail_zoom"));
+    levelOfDetailZoom.addListener(this);
+
     // Add lasso component
     addAndMakeVisible(&lasso);
     lasso.setAlwaysOnTop(true);
@@ -125,6 +132,9 @@ Canvas::Canvas(PluginEditor* parent, pd::Patch::Ptr p, Component* parentGraph)
     } else {
         presentationMode = false;
     }
+
+    // Graphs are created by the object that contains them, they are never large enough to be worth populating in steps
+    isLoading = !isGraph;
     performSynchronise();
 
     // Start in unlocked mode if the patch is empty
@@ -137,6 +147,11 @@ Canvas::Canvas(PluginEditor* parent, pd::Patch::Ptr p, Component* parentGraph)
 
     locked.addListener(this);
 
+    updateLevelOfDetail();
+
+    if (!isGraph)
+        suspensionTimer.startTimer(suspensionCheckInterval);
+
     editor->addModifierKeyListener(this);
     parameters.addParamBool("Is graph", cGeneral, &isGraphChild, { "No", "Yes" }, 0);
     parameters.addParamBool("Hide name and arguments", cGeneral, &hideNameAndArgs, { "No", "Yes" }, 0);
@@ -149,8 +164,31 @@ Canvas::Canvas(PluginEditor* parent, pd::Patch::Ptr p, Component* parentGraph)
 Canvas::~Canvas()
 {
     zoomScale.removeListener(this);
+    levelOfDetailZoom.removeListener(this);
     editor->removeModifierKeyListener(this);
     pd->unregisterMessageListener(patch.getPointer().get(), this);
+
+    if (!isGraph)
+        pd->unregisterCanvas(this, patch.getUncheckedPointer());
+}
+
+void Canvas::registerObject(Object* object, t_gobj* ptr)
+{
+    if (ptr)
+        objectsByPointer[ptr] = object;
+}
+
+void Canvas::unregisterObject(Object* object, t_gobj* ptr)
+{
+    auto it = objectsByPointer.find(ptr);
+    if (it != objectsByPointer.end() && it->second == object)
+        objectsByPointer.erase(it);
+}
+
+Object* Canvas::getObjectForPointer(t_gobj* ptr) const
+{
+    auto it = objectsByPointer.find(ptr);
+    return it != objectsByPointer.end() ? it->second : nullptr;
 }
 
 void Canvas::propertyChanged(String const& name, var const& value)
@@ -272,6 +310,10 @@ void Canvas::paint(Graphics& g)
     if (isGraph)
         return;
 
+    Tracing::ScopedEvent traceEvent("Canvas repaint");
+
+    repaintCoordinator.paintStarted();
+
     g.fillAll(findColour(PlugDataColour::canvasBackgroundColourId));
 
     if (viewport)
@@ -296,39 +338,26 @@ void Canvas::paint(Graphics& g)
 
     if (!getValue<bool>(locked)) {
 
-        auto startX = (canvasOrigin.x % objectGrid.gridSize);
-        startX += ((clipBounds.getX() / objectGrid.gridSize) * objectGrid.gridSize);
-
-        auto startY = (canvasOrigin.y % objectGrid.gridSize);
-        startY += ((clipBounds.getY() / objectGrid.gridSize) * objectGrid.gridSize);
+        auto const pixelScale = static_cast<float>(g.getInternalContext().getPhysicalPixelScaleFactor());
+        auto const& tile = getGridTile(scale, pixelScale, findColour(PlugDataColour::canvasDotsColourId));
 
-        g.setColour(findColour(PlugDataColour::canvasDotsColourId));
+        // The tile is offset by half a grid step, so the dots on the grid lines aren't cut in half by the tile's edges
+        auto const period = static_cast<float>(objectGrid.gridSize * 4);
+        auto const tileOrigin = canvasOrigin.toFloat() - Point<float>(objectGrid.gridSize, objectGrid.gridSize) * 0.5f;
 
-        for (int x = startX; x < clipBounds.getRight(); x += objectGrid.gridSize) {
-            // calculate the x here, once per iteration, as it won't change for y
-            auto const gridSpacing = objectGrid.gridSize * 4;
-            auto const xGridSpacing = (x - canvasOrigin.x) % gridSpacing == 0;
+        g.setFillType(FillType(tile, AffineTransform::scale(period / static_cast<float>(tile.getWidth())).translated(tileOrigin)));
+        g.fillRect(clipBounds);
 
-            for (int y = startY; y < clipBounds.getBottom(); y += objectGrid.gridSize) {
+        // Don't draw over origin or border line
+        if (showBorder || showOrigin) {
+            auto const maxDotWidth = 3.0f;
+            auto const right = showOrigin ? static_cast<float>(clipBounds.getRight()) : patchWidthCanvas;
+            auto const bottom = showOrigin ? static_cast<float>(clipBounds.getBottom()) : patchHeightCanvas;
+            auto const origin = canvasOrigin.toFloat() - Point<float>(maxDotWidth, maxDotWidth) * 0.5f;
 
-                // Don't draw over origin or border line
-                if (showBorder || showOrigin) {
-                    if ((x == canvasOrigin.x && y >= canvasOrigin.y && (showOrigin || (y <= patchHeightCanvas))) || (y == canvasOrigin.y && x >= canvasOrigin.x && (showOrigin || (x <= patchWidthCanvas))))
-                        continue;
-                }
-                auto dotWidth = 1.0f;
-                if (scale < 1.0f) {
-                    if (((y - canvasOrigin.y) % gridSpacing == 0) || xGridSpacing) {
-                        dotWidth = 1.0f / jmap(scale, 0.3f, 1.0f, 0.4f, 1.0f);
-                    } else {
-                        // TIM: draw the dot's differently for some grid sizes, or not at all?
-                        if (objectGrid.gridSize == 5)
-                            continue;
-                    }
-                }
-                auto halfDotWidth = dotWidth * 0.5f;
-                g.fillRect(static_cast<float>(x) - halfDotWidth, static_cast<float>(y) - halfDotWidth, dotWidth, dotWidth);
-            }
+            g.setColour(findColour(PlugDataColour::canvasBackgroundColourId));
+            g.fillRect(Rectangle<float>(origin.x, origin.y, right - origin.x + maxDotWidth * 0.5f, maxDotWidth));
+            g.fillRect(Rectangle<float>(origin.x, origin.y, maxDotWidth, bottom - origin.y + maxDotWidth * 0.5f));
         }
     }
 
@@ -385,6 +414,78 @@ void Canvas::paint(Graphics& g)
     }
 }
 
+Image const& Canvas::getGridTile(float zoom, float pixelScale, Colour colour)
+{
+    auto const gridSize = objectGrid.gridSize;
+    if (gridTile.image.isValid() && gridTile.gridSize == gridSize && gridTile.zoom == zoom && gridTile.pixelScale == pixelScale && gridTile.colour == colour)
+        return gridTile.image;
+
+    // One period of the grid is 4 grid steps, every 4th row and column has bigger dots when zoomed out
+    auto const period = gridSize * 4;
+    auto const tileSize = std::max(1, roundToInt(static_cast<float>(period) * pixelScale));
+
+    gridTile = { Image(Image::ARGB, tileSize, tileSize, true), gridSize, zoom, pixelScale, colour };
+
+    Graphics g(gridTile.image);
+    g.addTransform(AffineTransform::scale(static_cast<float>(tileSize) / static_cast<float>(period)));
+    g.setColour(colour);
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            auto dotWidth = 1.0f;
+            if (zoom < 1.0f) {
+                if (i == 0 || j == 0) {
+                    dotWidth = 1.0f / jmap(zoom, 0.3f, 1.0f, 0.4f, 1.0f);
+                } else {
+                    // TIM: draw the dot's differently for some grid sizes, or not at all?
+                    if (gridSize == 5)
+                        continue;
+                }
+            }
+
+            auto const halfDotWidth = dotWidth * 0.5f;
+            auto const x = (static_cast<float>(i) + 0.5f) * static_cast<float>(gridSize);
+            auto const y = (static_cast<float>(j) + 0.5f) * static_cast<float>(gridSize);
+            g.fillRect(x - halfDotWidth, y - halfDotWidth, dotWidth, dotWidth);
+        }
+    }
+
+    return gridTile.image;
+}
+
+void Canvas::paintOverChildren(Graphics& g)
+{
+    if (!isGraph)
+        repaintCoordinator.paintFinished();
+
+    // Show the progress of populating the canvas at the top of the view
+    if (isLoading && viewport) {
+        auto const viewArea = viewport->getViewArea().transformedBy(getTransform().inverted()).toFloat();
+        auto const barHeight = 3.0f / getValue<float>(zoomScale);
+        auto const barBounds = viewArea.withHeight(barHeight);
+
+        g.setColour(findColour(PlugDataColour::canvasBackgroundColourId).contrasting(0.1f));
+        g.fillRect(barBounds);
+        g.setColour(findColour(PlugDataColour::objectSelectedOutlineColourId));
+        g.fillRect(barBounds.withWidth(barBounds.getWidth() * loadingProgress));
+    }
+
+    // Summary of what compiling this patch would involve, at the bottom of the view
+    if (!isGraph && viewport && heavyFootprint.numObjects > 0 && getValue<bool>(editor->hvccMode)) {
+        auto const scale = getValue<float>(zoomScale);
+        auto viewArea = viewport->getViewArea().transformedBy(getTransform().inverted());
+        auto const textBounds = viewArea.removeFromBottom(static_cast<int>(24 / scale)).reduced(static_cast<int>(8 / scale), 0);
+
+        String summary;
+        if (heavyFootprint.numIncompatible > 0)
+            summary << String(heavyFootprint.numIncompatible) << " unsupported " << (heavyFootprint.numIncompatible == 1 ? "object" : "objects") << ", ";
+        summary << String(heavyFootprint.numSignalObjects) << " signal objects, ~" << File::descriptionOfSizeInBytes(heavyFootprint.memoryBytes);
+
+        auto const colour = heavyFootprint.numIncompatible > 0 ? Colours::orange : findColour(PlugDataColour::canvasTextColourId).withAlpha(0.6f);
+        Fonts::drawText(g, "Compiled Mode: " + summary, textBounds, colour, static_cast<int>(13 / scale));
+    }
+}
+
 TabComponent* Canvas::getTabbar()
 {
     for (auto* split : editor->splitView.splits) {
@@ -398,6 +499,9 @@ TabComponent* Canvas::getTabbar()
 
 void Canvas::tabChanged()
 {
+    // Start resuming straight away, instead of waiting for the next suspension check
+    updateSuspension();
+
     patch.setCurrent();
 
     synchronise();
@@ -413,6 +517,52 @@ void Canvas::tabChanged()
     }
 }
 
+void Canvas::updateSuspension()
+{
+    // Only the objects of the canvas itself are suspended. The contents of graph-on-parent subpatches are a separate canvas,
+    // which isn't suspended, so those objects keep listening to pd while the canvas that shows them is hidden
+    if (isGraph)
+        return;
+
+    auto const currentTime = Time::getMillisecondCounterHiRes();
+
+    if (!isShowing()) {
+        if (!isSuspended && currentTime - lastShowingTime > suspendDelay) {
+            for (auto* object : objects) {
+                if (object->gui)
+                    object->gui->setSuspended(true);
+            }
+
+            isSuspended = true;
+        }
+
+        suspensionTimer.startTimer(suspensionCheckInterval);
+        return;
+    }
+
+    lastShowingTime = currentTime;
+
+    if (!isSuspended)
+        return;
+
+    // Resume objects a few at a time, objects that were created while suspended were never suspended
+    int numResumed = 0;
+    for (auto* object : objects) {
+        if (object->gui && object->gui->isSuspended()) {
+            object->gui->setSuspended(false);
+            if (++numResumed >= objectsPerResumeStep)
+                break;
+        }
+    }
+
+    if (numResumed < objectsPerResumeStep) {
+        isSuspended = false;
+        suspensionTimer.startTimer(suspensionCheckInterval);
+    } else {
+        suspensionTimer.startTimer(resumeInterval);
+    }
+}
+
 int Canvas::getTabIndex()
 {
     if (auto* tabbar = getTabbar()) {
@@ -444,13 +594,48 @@ void Canvas::synchroniseSplitCanvas()
 // Used for loading and for complicated actions like undo/redo
 void Canvas::performSynchronise()
 {
+    Tracing::ScopedEvent traceEvent("Canvas sync");
     pd->lockAudioThread();
 
     patch.setCurrent();
-    pd->sendMessagesFromQueue();
+    pd->sendCommandsFromQueue();
 
     pd->unlockAudioThread();
 
+    PatchContent content;
+    content.objects = patch.getObjects();
+    content.connections = patch.getConnections();
+
+    // Position of every pd object in the patch, so we don't need to search through the patch for every object
+    content.objectIndices.reserve(content.objects.size());
+    for (size_t i = 0; i < content.objects.size(); i++) {
+        content.objectIndices[content.objects[i].getRawUnchecked<void>()] = i;
+    }
+
+    // When the same patch is open in the other half of the split view or in another window, those canvases
+    // would read exactly the same from pd. Update them with what we just read, instead of letting them read it again
+    for (auto* editorWindow : pd->getEditors()) {
+        for (auto* cnv : editorWindow->canvases) {
+            if (cnv != this && cnv->patch.getUncheckedPointer() == patch.getUncheckedPointer()) {
+                cnv->cancelPendingUpdate();
+                cnv->synchroniseWith(content);
+            }
+        }
+    }
+
+    synchroniseWith(content);
+
+    if (auto p = patch.getPointer()) {
+        pd->updateObjectImplementations(p.get());
+    }
+}
+
+// Updates the objects and connections of this view to match the content of the patch
+void Canvas::synchroniseWith(PatchContent const& content)
+{
+    auto const& pdObjects = content.objects;
+    auto const& pdObjectIndices = content.objectIndices;
+
     // Remove deleted connections
     for (int n = connections.size() - 1; n >= 0; n--) {
         if (!connections[n]->getPointer()) {
@@ -458,17 +643,38 @@ void Canvas::performSynchronise()
         }
     }
 
-    // Remove deleted objects
+    // Take out the objects of which the pd object was deleted
+    // When the patch is reloaded or changed by undo/redo, a pd object is often replaced by a new one of the same class.
+    // Instead of deleting and recreating those, we reassign them to the new pd object, which keeps the component and its iolets
+    std::unordered_map<hash32, std::vector<std::unique_ptr<Object>>> reusableObjects;
     for (int n = objects.size() - 1; n >= 0; n--) {
         auto* object = objects[n];
 
         // If the object is showing it's initial editor, meaning no object was assigned yet, allow it to exist without pointing to an object
-        if ((!object->getPointer() || patch.objectWasDeleted(object->getPointer())) && !object->isInitialEditorShown()) {
+        if ((!object->getPointer() || !pdObjectIndices.count(object->getPointer())) && !object->isInitialEditorShown()) {
             setSelected(object, false, false);
-            objects.remove(n);
+            auto const classHash = object->getClassHash();
+            reusableObjects[classHash].emplace_back(objects.removeAndReturn(n));
         }
     }
 
+    auto const takeReusableObject = [&reusableObjects](pd::WeakReference& object) -> Object* {
+        if (reusableObjects.empty())
+            return nullptr;
+
+        auto checked = object.get<t_pd>();
+        if (!checked)
+            return nullptr;
+
+        auto it = reusableObjects.find(hash(pd::Interface::getObjectClassName(checked.get())));
+        if (it == reusableObjects.end() || it->second.empty())
+            return nullptr;
+
+        auto* reused = it->second.back().release();
+        it->second.pop_back();
+        return reused;
+    };
+
     // Check for connections that need to be remade because of invalid iolets
     for (int n = connections.size() - 1; n >= 0; n--) {
         if (!connections[n]->inlet || !connections[n]->outlet) {
@@ -476,22 +682,39 @@ void Canvas::performSynchronise()
         }
     }
 
-    auto pdObjects = patch.getObjects();
-
+    int numCreatedObjects = 0;
+    bool finishedLoading = true;
     for (auto object : pdObjects) {
-        auto* it = std::find_if(objects.begin(), objects.end(), [&object](Object* b) { return b->getPointer() && b->getPointer() == object.getRawUnchecked<void>(); });
         if (!object.isValid())
             continue;
 
-        if (it == objects.end()) {
-            auto* newBox = objects.add(new Object(object, this));
+        auto* existingObject = getObjectForPointer(object.getRawUnchecked<t_gobj>());
+        if (!existingObject) {
+            // Create the rest of the objects on the next synchronise, so we can draw what we have so far
+            if (isLoading && numCreatedObjects >= objectsPerLoadingStep) {
+                finishedLoading = false;
+                continue;
+            }
+            // Plugin mode already decided it doesn't need this one
+            if (pluginModeView && pluginModeHiddenObjects.count(object.getRawUnchecked<void>()))
+                continue;
+
+            numCreatedObjects++;
+
+            Object* newBox;
+            if (auto* reused = takeReusableObject(object)) {
+                newBox = objects.add(reused);
+                newBox->setType("", object);
+            } else {
+                newBox = objects.add(new Object(object, this));
+            }
             newBox->toFront(false);
 
             // TODO: don't do this on Canvas!!
             if (newBox->gui && newBox->gui->getLabel())
                 newBox->gui->getLabel()->toFront(false);
         } else {
-            auto* object = *it;
+            auto* object = existingObject;
 
             // Check if number of inlets/outlets is correct
             object->updateIolets();
@@ -505,66 +728,83 @@ void Canvas::performSynchronise()
         }
     }
 
+    if (pluginModeView) {
+        std::unordered_set<void*> hiddenObjects;
+        for (int n = objects.size() - 1; n >= 0; n--) {
+            if (!isShownInPluginMode(objects[n])) {
+                hiddenObjects.insert(objects[n]->getPointer());
+                objects.remove(n);
+            }
+        }
+
+        // Objects that were hidden before and still exist stay hidden
+        for (auto* hidden : pluginModeHiddenObjects) {
+            if (pdObjectIndices.count(hidden))
+                hiddenObjects.insert(hidden);
+        }
+        pluginModeHiddenObjects = std::move(hiddenObjects);
+    }
+
     // Make sure objects have the same order
-    std::sort(objects.begin(), objects.end(),
-        [&pdObjects](Object* first, Object* second) mutable {
-            size_t idx1 = std::find(pdObjects.begin(), pdObjects.end(), first->getPointer()) - pdObjects.begin();
-            size_t idx2 = std::find(pdObjects.begin(), pdObjects.end(), second->getPointer()) - pdObjects.begin();
+    auto const getPdObjectIndex = [&pdObjectIndices, numPdObjects = pdObjects.size()](Object* object) {
+        auto it = pdObjectIndices.find(object->getPointer());
+        return it != pdObjectIndices.end() ? it->second : numPdObjects;
+    };
 
-            return idx1 < idx2;
+    std::sort(objects.begin(), objects.end(),
+        [&getPdObjectIndex](Object* first, Object* second) {
+            return getPdObjectIndex(first) < getPdObjectIndex(second);
         });
 
-    auto pdConnections = patch.getConnections();
+    std::unordered_map<t_outconnect*, int> connectionIndices;
+    connectionIndices.reserve(connections.size());
+    for (int i = 0; i < connections.size(); i++) {
+        connectionIndices[connections[i]->getPointer()] = i;
+    }
+
+    // Connections are never shown in plugin mode
+    static pd::Connections const noConnections;
+    auto const& pdConnections = pluginModeView ? noConnections : content.connections;
 
-    for (auto& connection : pdConnections) {
-        auto& [ptr, inno, inobj, outno, outobj] = connection;
+    for (auto const& connection : pdConnections) {
+        auto const& [ptr, inno, inobj, outno, outobj] = connection;
 
         Iolet *inlet = nullptr, *outlet = nullptr;
 
         // Find the objects that this connection is connected to
-        for (auto* obj : objects) {
-            if (outobj && &outobj->te_g == obj->getPointer()) {
-
-                // Check if we have enough outlets, should never return false
-                if (isPositiveAndBelow(obj->numInputs + outno, obj->iolets.size())) {
-                    outlet = obj->iolets[obj->numInputs + outno];
-                } else {
-                    break;
-                }
+        if (auto* obj = outobj ? getObjectForPointer(&outobj->te_g) : nullptr) {
+            // Check if we have enough outlets, should never return false
+            if (isPositiveAndBelow(obj->numInputs + outno, obj->iolets.size())) {
+                outlet = obj->iolets[obj->numInputs + outno];
             }
-            if (inobj && &inobj->te_g == obj->getPointer()) {
-
-                // Check if we have enough inlets, should never return false
-                if (isPositiveAndBelow(inno, obj->iolets.size())) {
-                    inlet = obj->iolets[inno];
-                } else {
-                    break;
-                }
+        }
+        if (auto* obj = inobj ? getObjectForPointer(&inobj->te_g) : nullptr) {
+            // Check if we have enough inlets, should never return false
+            if (isPositiveAndBelow(inno, obj->iolets.size())) {
+                inlet = obj->iolets[inno];
             }
         }
 
         // This shouldn't be necessary, but just to be sure...
+        // While loading, one of the objects might not be created yet
         if (!inlet || !outlet) {
-            jassertfalse;
+            jassert(isLoading);
             continue;
         }
 
-        auto* it = std::find_if(connections.begin(), connections.end(),
-            [c_ptr = ptr](auto* c) {
-                return c_ptr == c->getPointer();
-            });
+        auto it = connectionIndices.find(ptr);
 
-        if (it == connections.end()) {
+        if (it == connectionIndices.end()) {
             connections.add(new Connection(this, inlet, outlet, ptr));
         } else {
-            auto& c = *(*it);
+            auto& c = *connections[it->second];
 
             // This is necessary to make resorting a subpatchers iolets work
             // And it can't hurt to check if the connection is valid anyway
             if (c.inlet != inlet || c.outlet != outlet) {
-                int idx = connections.indexOf(*it);
-                connections.removeObject(*it);
-                connections.insert(idx, new Connection(this, inlet, outlet, ptr));
+                // Replace it at the same index, so the indices of the other connections stay valid
+                connections.remove(it->second);
+                connections.insert(it->second, new Connection(this, inlet, outlet, ptr));
             } else {
                 c.popPathState();
             }
@@ -578,12 +818,94 @@ void Canvas::performSynchronise()
     if (graphArea)
         graphArea->updateBounds();
 
+    heavyFootprint = HeavyFootprint();
+    if (getValue<bool>(editor->hvccMode)) {
+        for (auto* object : objects) {
+            // The contents of subpatches can be edited without their object changing, so count them again
+            if (object->gui && object->gui->getPatch())
+                object->updateHeavyFootprint();
+
+            heavyFootprint += object->heavyFootprint;
+        }
+    }
+
     editor->updateCommandStatus();
     repaint();
     
     needsSearchUpdate = true;
 
-    pd->updateObjectImplementations();
+    if (auto* canvasViewport = dynamic_cast<CanvasViewport*>(viewport.get()))
+        canvasViewport->patchChanged();
+
+    if (isLoading) {
+        loadingProgress = pdObjects.empty() ? 1.0f : static_cast<float>(objects.size()) / static_cast<float>(pdObjects.size());
+        isLoading = !finishedLoading;
+        if (isLoading)
+            triggerAsyncUpdate();
+        else if (auto* target = std::exchange(pendingSearchTarget, nullptr))
+            editor->highlightSearchTarget(target, false);
+    }
+}
+
+void Canvas::setPluginModeView(bool enabled)
+{
+    if (pluginModeView == enabled || isGraph)
+        return;
+
+    pluginModeView = enabled;
+    pluginModeHiddenObjects.clear();
+
+    hideSuggestions();
+    lasso.setVisible(!enabled);
+    if (graphArea)
+        graphArea->setVisible(!enabled);
+
+    if (enabled) {
+        deselectAll();
+        connections.clear();
+
+        for (int n = objects.size() - 1; n >= 0; n--) {
+            if (!isShownInPluginMode(objects[n])) {
+                pluginModeHiddenObjects.insert(objects[n]->getPointer());
+                objects.remove(n);
+            }
+        }
+
+        repaint();
+    } else {
+        // Bring back everything that plugin mode left out
+        performSynchronise();
+    }
+}
+
+bool Canvas::isShownInPluginMode(Object* object) const
+{
+    if (!object->gui || object->gui->hideInGraph())
+        return false;
+
+    auto const pluginArea = Rectangle<int>(canvasOrigin.x, canvasOrigin.y, getValue<int>(patchWidth) + 1, getValue<int>(patchHeight) + 1);
+    return object->getBounds().reduced(Object::margin).intersects(pluginArea);
+}
+
+void Canvas::updateLevelOfDetail()
+{
+    // Graphs are drawn at the level of detail of the canvas they're in
+    auto const shouldSimplify = !isGraph && getValue<float>(zoomScale) < getValue<float>(levelOfDetailZoom) / 100.0f;
+    if (shouldSimplify == simplifiedRendering)
+        return;
+
+    simplifiedRendering = shouldSimplify;
+
+    for (auto* object : objects) {
+        object->updateLevelOfDetail();
+    }
+    for (auto* connection : connections) {
+        if (auto* cachedImage = connection->getCachedComponentImage())
+            cachedImage->invalidateAll();
+    }
+
+    // Every object and connection changes how it's drawn, so one repaint of the canvas is cheaper than repainting each of them
+    repaint();
 }
 
 void Canvas::updateDrawables()
@@ -1005,6 +1327,7 @@ void Canvas::dragAndDropPaste(String const& patchString, Point<int> mousePos, in
     String translatedObjects = pd::Patch::translatePatchAsString(patchString, mousePos - (patchSize / 2.0f));
 
     if (auto patchPtr = patch.getPointer()) {
+        pd::Patch::ScopedDspSuspend dspSuspend;
         pd::Interface::paste(patchPtr.get(), translatedObjects.toRawUTF8());
     }
 
@@ -1200,27 +1523,33 @@ void Canvas::removeSelection()
         }
     }
 
-    auto wasDeleted = [&objects](t_gobj* ptr) {
-        return std::find(objects.begin(), objects.end(), ptr) != objects.end();
+    auto const deleted = std::unordered_set<t_gobj*>(objects.begin(), objects.end());
+    auto wasDeleted = [&deleted](t_gobj* ptr) {
+        return deleted.contains(ptr);
     };
 
-    // remove selection
-    patch.removeObjects(objects);
-
-    // Remove connection afterwards and make sure they aren't already deleted
-    for (auto* con : connections) {
-        if (con->isSelected()) {
-            auto* outPtr = con->outobj->getPointer();
-            auto* inPtr = con->inobj->getPointer();
-            auto* checkedOutPtr = pd::Interface::checkObject(outPtr);
-            auto* checkedInPtr = pd::Interface::checkObject(inPtr);
-            if (checkedOutPtr && checkedInPtr && (!(wasDeleted(outPtr) || wasDeleted(inPtr)))) {
-                patch.removeConnection(checkedOutPtr, con->outIdx, checkedInPtr, con->inIdx, con->getPathState());
+    {
+        // Lock once for the whole selection, and rebuild the DSP chain only once
+        pd::Patch::ScopedBatchEdit batch(pd);
+
+        // remove selection
+        patch.removeObjects(objects);
+
+        // Remove connection afterwards and make sure they aren't already deleted
+        for (auto* con : connections) {
+            if (con->isSelected()) {
+                auto* outPtr = con->outobj->getPointer();
+                auto* inPtr = con->inobj->getPointer();
+                auto* checkedOutPtr = pd::Interface::checkObject(outPtr);
+                auto* checkedInPtr = pd::Interface::checkObject(inPtr);
+                if (checkedOutPtr && checkedInPtr && (!(wasDeleted(outPtr) || wasDeleted(inPtr)))) {
+                    patch.removeConnection(checkedOutPtr, con->outIdx, checkedInPtr, con->inIdx, con->getPathState());
+                }
             }
         }
-    }
 
-    patch.finishRemove(); // Makes sure that the extra removed connections will be grouped in the same undo action
+        patch.finishRemove(); // Makes sure that the extra removed connections will be grouped in the same undo action
+    }
 
     deselectAll();
 
@@ -1354,47 +1683,42 @@ void Canvas::encapsulateSelection()
     if (!patchPtr)
         return;
 
-    // Apply the changed on Pd's thread
-    pd->lockAudioThread();
+    // Apply all changes in one batch, so Pd only rebuilds the DSP chain once
+    {
+        pd::Patch::ScopedBatchEdit batch(pd);
 
-    int size;
-    char const* text = pd::Interface::copy(patchPtr, &size, objects);
-    auto copied = String::fromUTF8(text, size);
+        int size;
+        char const* text = pd::Interface::copy(patchPtr, &size, objects);
+        auto copied = String::fromUTF8(text, size);
 
-    // Wrap it in an undo sequence, to allow undoing everything in 1 step
-    patch.startUndoSequence("Encapsulate");
+        // Wrap it in an undo sequence, to allow undoing everything in 1 step
+        patch.startUndoSequence("Encapsulate");
 
-    pd::Interface::removeObjects(patchPtr, objects);
+        pd::Interface::removeObjects(patchPtr, objects);
 
-    auto replacement = copypasta.replace("$$_COPY_HERE_$$", copied);
+        auto replacement = copypasta.replace("$$_COPY_HERE_$$", copied);
 
-    pd::Interface::paste(patchPtr, replacement.toRawUTF8());
-    auto lastObject = patch.getObjects().back();
-    if (!lastObject.isValid())
-        return;
+        pd::Interface::paste(patchPtr, replacement.toRawUTF8());
 
-    auto* newObject = pd::Interface::checkObject(lastObject.getRaw<t_pd>());
-    if (!newObject) {
-        patch.endUndoSequence("Encapsulate");
-        pd->unlockAudioThread();
-        return;
-    }
+        auto objectsAfterPaste = patch.getObjects();
+        auto* newObject = !objectsAfterPaste.empty() && objectsAfterPaste.back().isValid() ? pd::Interface::checkObject(objectsAfterPaste.back().getRaw<t_pd>()) : nullptr;
 
-    for (auto& [idx, iolets] : newExternalConnections) {
-        for (auto* iolet : iolets) {
-            if (auto* externalObject = reinterpret_cast<t_object*>(iolet->object->getPointer())) {
-                if (iolet->isInlet) {
-                    pd::Interface::createConnection(patchPtr, newObject, idx - numIn, externalObject, iolet->ioletIdx);
-                } else {
-                    pd::Interface::createConnection(patchPtr, externalObject, iolet->ioletIdx, newObject, idx);
+        if (newObject) {
+            for (auto& [idx, iolets] : newExternalConnections) {
+                for (auto* iolet : iolets) {
+                    if (auto* externalObject = reinterpret_cast<t_object*>(iolet->object->getPointer())) {
+                        if (iolet->isInlet) {
+                            pd::Interface::createConnection(patchPtr, newObject, idx - numIn, externalObject, iolet->ioletIdx);
+                        } else {
+                            pd::Interface::createConnection(patchPtr, externalObject, iolet->ioletIdx, newObject, idx);
+                        }
+                    }
                 }
             }
         }
-    }
-
-    patch.endUndoSequence("Encapsulate");
 
-    pd->unlockAudioThread();
+        patch.endUndoSequence("Encapsulate");
+    }
 
     synchronise();
     handleUpdateNowIfNeeded();
@@ -1497,6 +1821,10 @@ void Canvas::alignObjects(Align alignment)
 
     patch.startUndoSequence("Align objects");
 
+    // Moves all objects while holding the lock once
+    std::optional<pd::Patch::ScopedBatchEdit> batch;
+    batch.emplace(pd);
+
     // mark canvas as dirty, and set undo for all positions
     auto patchPtr = patch.getPointer().get();
     canvas_dirty(patch.getPointer().get(), 1);
@@ -1601,6 +1929,8 @@ void Canvas::alignObjects(Align alignment)
         break;
     }
 
+    batch.reset();
+
     performSynchronise();
 
     for (auto* connection : connections) {
@@ -1653,6 +1983,7 @@ void Canvas::valueChanged(Value& v)
         }
 
         hideSuggestions();
+        updateLevelOfDetail();
 
         if (!viewport)
             return;
@@ -1675,6 +2006,8 @@ void Canvas::valueChanged(Value& v)
         // set and trigger the zoom labsetValueExcludingListenerel popup in the bottom left corner
         // TODO: move this to viewport, and have one per viewport?
         editor->setZoomLabelLevel(newScaleFactor);
+    } else if (v.refersToSameSourceAs(levelOfDetailZoom)) {
+        updateLevelOfDetail();
     } else if (v.refersToSameSourceAs(patchWidth)) {
         // limit canvas width to smallest object (11px)
         patchWidth = jmax(11, getValue<int>(patchWidth));
@@ -1847,28 +2180,36 @@ bool Canvas::setPanDragMode(bool shouldPan)
 
 void Canvas::findLassoItemsInArea(Array<WeakReference<Component>>& itemsFound, Rectangle<int> const& area)
 {
-    for (auto* object : objects) {
+    std::unordered_set<Component*> found;
+
+    // Only look at objects whose bounds intersect the area
+    objectIndex.forEachItemIn(area, [&found, &itemsFound, &area](Object* object) {
         if (area.intersects(object->getSelectableBounds())) {
             itemsFound.add(object);
-        } else if (!ModifierKeys::getCurrentModifiers().isAnyModifierKeyDown()) {
-            setSelected(object, false, false);
-        }
-    }
-
-    for (auto& connection : connections) {
-        // If total bounds don't intersect, there can't be an intersection with the line
-        // This is cheaper than checking the path intersection, so do this first
-        if (!connection->getBounds().intersects(lasso.getBounds())) {
-            setSelected(connection, false, false);
-            continue;
+            found.insert(object);
         }
+    });
 
+    // If total bounds don't intersect, there can't be an intersection with the line
+    // This is cheaper than checking the path intersection, so do this first
+    connectionIndex.forEachItemIn(lasso.getBounds(), [this, &found, &itemsFound](Connection* connection) {
         // Check if path intersects with lasso
         if (connection->intersects(lasso.getBounds().toFloat())) {
             itemsFound.add(connection);
-        } else if (!ModifierKeys::getCurrentModifiers().isAnyModifierKeyDown()) {
-            setSelected(connection, false, false);
+            found.insert(connection);
         }
+    });
+
+    // Deselect everything that is no longer inside the lasso
+    // Connections outside of the lasso bounds are always deselected, objects only if no modifier key is held
+    auto const keepSelection = ModifierKeys::getCurrentModifiers().isAnyModifierKeyDown();
+    for (auto* object : getSelectionOfType<Object>()) {
+        if (!keepSelection && !found.count(object))
+            setSelected(object, false, false);
+    }
+    for (auto* connection : getSelectionOfType<Connection>()) {
+        if (!found.count(connection) && (!keepSelection || !connection->getBounds().intersects(lasso.getBounds())))
+            setSelected(connection, false, false);
     }
 }
 
@@ -8,12 +8,15 @@
 
 #include "ObjectGrid.h"          // move to impl
 #include "Utility/RateReducer.h" // move to impl
+#include "Utility/SpatialGrid.h"
+#include "Utility/RepaintCoordinator.h"
 #include "Utility/ModifierKeyListener.h"
 #include "Components/CheckedTooltip.h"
 #include "Pd/MessageListener.h"
 #include "Pd/Patch.h"
 #include "Constants.h"
 #include "Objects/ObjectParameters.h"
+#include "Heavy/CompatibleObjects.h"
 
 namespace pd {
 class Patch;
@@ -58,6 +61,7 @@ public:
 
     void lookAndFeelChanged() override;
     void paint(Graphics& g) override;
+    void paintOverChildren(Graphics& g) override;
 
     void mouseDown(MouseEvent const& e) override;
     void mouseDrag(MouseEvent const& e) override;
@@ -76,15 +80,31 @@ public:
     int getOverlays() const;
     void updateOverlays();
 
+    // What a synchronise reads from pd, shared by all canvases that show the same patch
+    struct PatchContent {
+        std::vector<pd::WeakReference> objects;
+        pd::Connections connections;
+        std::unordered_map<void*, size_t> objectIndices;
+    };
+
     void synchroniseSplitCanvas();
     void synchronise();
     void performSynchronise();
+    void synchroniseWith(PatchContent const& content);
     void handleAsyncUpdate() override;
 
+    // Keeps track of which Object belongs to which pd object, so we can find them without searching through all objects
+    void registerObject(Object* object, t_gobj* ptr);
+    void unregisterObject(Object* object, t_gobj* ptr);
+    Object* getObjectForPointer(t_gobj* ptr) const;
+
     void moveToWindow(PluginEditor* newWindow);
 
     void updateDrawables();
 
+    // Switches between full and simplified drawing of objects and connections, depending on the zoom level
+    void updateLevelOfDetail();
+
     bool keyPressed(KeyPress const& key) override;
     void valueChanged(Value& v) override;
 
@@ -167,6 +187,16 @@ public:
 
     // Needs to be allocated before object and connection so they can deselect themselves in the destructor
     SelectedItemSet<WeakReference<Component>> selectedComponents;
+    std::unordered_map<t_gobj*, Object*> objectsByPointer;
+
+    // Spatial index over the bounds of all objects and connections, for hit-testing, lasso selection and snapping
+    SpatialGrid<Object*> objectIndex;
+    SpatialGrid<Connection*> connectionIndex;
+
+    // TODO: only create full Object components for the visible area of the canvas
+    // This currently can't be done, because Connections point to the Iolets of both objects, and an Object needs its GUI to know
+    // which pd object it belongs to. Painting and periodic GUI updates of offscreen objects are already skipped (by JUCE's clipping
+    // and GuiRefreshScheduler), so what's left to gain is construction time and memory of huge patches
     OwnedArray<Object> objects;
     OwnedArray<Connection> connections;
     OwnedArray<ConnectionBeingCreated> connectionsBeingCreated;
@@ -186,6 +216,22 @@ public:
     
     bool needsSearchUpdate = false;
 
+    // While a patch is being opened, its objects are created over multiple synchronise calls, so large patches don't freeze the UI
+    bool isLoading = false;
+    float loadingProgress = 0.0f;
+    static constexpr int objectsPerLoadingStep = 150;
+
+    // Object that a search tried to highlight before it was created, see PluginEditor::highlightSearchTarget
+    void* pendingSearchTarget = nullptr;
+
+    // In plugin mode, the canvas only keeps the GUI objects inside the patch area, and doesn't create connections
+    // Nothing can be edited in plugin mode, the rest of the patch is recreated when plugin mode is closed
+    void setPluginModeView(bool enabled);
+    bool pluginModeView = false;
+
+    // Estimate of the whole patch in compiled mode, added up from the objects on every sync
+    HeavyFootprint heavyFootprint;
+
     Value isGraphChild = SynchronousValue(var(false));
     Value hideNameAndArgs = SynchronousValue(var(false));
     Value xRange = SynchronousValue();
@@ -195,6 +241,10 @@ public:
 
     Value zoomScale;
 
+    // Zoom level in percent below which objects and connections are drawn without any detail
+    Value levelOfDetailZoom;
+    bool simplifiedRendering = false;
+
     ObjectGrid objectGrid = ObjectGrid(this);
 
     Point<int> const canvasOrigin;
@@ -209,6 +259,7 @@ public:
     Point<int> pastedPadding;
 
     std::unique_ptr<ConnectionPathUpdater> pathUpdater;
+    RepaintCoordinator repaintCoordinator;
     RateReducer objectRateReducer = RateReducer(90);
 
     ObjectDragState dragState;
@@ -216,6 +267,51 @@ public:
     inline static constexpr int infiniteCanvasSize = 128000;
 
 private:
+    // Canvases that haven't been on screen for a while are suspended: their objects stop listening to messages from pd
+    // When the canvas is shown again, objects are resumed a few at a time, so switching to a large patch doesn't block
+    void updateSuspension();
+
+    struct SuspensionTimer : public Timer {
+        explicit SuspensionTimer(Canvas& canvas)
+            : cnv(canvas)
+        {
+        }
+
+        void timerCallback() override
+        {
+            cnv.updateSuspension();
+        }
+
+        Canvas& cnv;
+    };
+
+    SuspensionTimer suspensionTimer { *this };
+    double lastShowingTime = Time::getMillisecondCounterHiRes();
+    bool isSuspended = false;
+
+    static constexpr int suspendDelay = 10000;
+    static constexpr int suspensionCheckInterval = 1000;
+    static constexpr int resumeInterval = 16;
+    static constexpr int objectsPerResumeStep = 64;
+
+    // The edit mode grid dots for one period of the grid, so paint can fill the clip with it instead of drawing every dot
+    // It's drawn again when the grid size, zoom, display scale or colour changes
+    struct GridTile {
+        Image image;
+        int gridSize = 0;
+        float zoom = 0.0f;
+        float pixelScale = 0.0f;
+        Colour colour;
+    };
+
+    Image const& getGridTile(float zoom, float pixelScale, Colour colour);
+    GridTile gridTile;
+
+    bool isShownInPluginMode(Object* object) const;
+
+    // Pd objects that plugin mode doesn't show, so the next synchronise doesn't create them again
+    std::unordered_set<void*> pluginModeHiddenObjects;
+
     LassoComponent<WeakReference<Component>> lasso;
 
     RateReducer canvasRateReducer = RateReducer(90);
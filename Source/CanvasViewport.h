@@ -19,7 +19,8 @@
 #include "Utility/SettingsFile.h"
 
 // Special viewport that shows scrollbars on top of content instead of next to it
-class CanvasViewport : public Viewport {
+class CanvasViewport : public Viewport
+    , public Value::Listener {
 
     class MousePanner : public MouseListener {
     public:
@@ -63,7 +64,7 @@ class CanvasViewport : public Viewport {
         {
             e.originalComponent->setMouseCursor(MouseCursor::NormalCursor);
             for (auto* object : viewport->cnv->objects) {
-                object->setBufferedToImage(false);
+                object->updateBufferedToImage();
             }
         }
 
@@ -285,6 +286,214 @@ class CanvasViewport : public Viewport {
         int inset;
     };
 
+    // Overview of the whole patch in the bottom right corner, for navigating big patches without zooming out and back in
+    // The patch is drawn into a small cached image, which is only redrawn after the patch has changed
+    // Scrolling and zooming only move the rectangle that shows the visible area
+    class Minimap : public Component
+        , public Timer {
+    public:
+        explicit Minimap(CanvasViewport* parent)
+            : viewport(parent)
+        {
+            setAlwaysOnTop(true);
+        }
+
+        void patchChanged()
+        {
+            // Wait a bit, so a burst of changes only redraws the image once
+            if (!isTimerRunning())
+                startTimer(100);
+        }
+
+        void paint(Graphics& g) override
+        {
+            auto bounds = getLocalBounds().toFloat();
+
+            g.setColour(findColour(PlugDataColour::canvasBackgroundColourId).contrasting(0.05f).withAlpha(0.9f));
+            g.fillRoundedRectangle(bounds, Corners::defaultCornerRadius);
+
+            g.drawImage(cachedImage, bounds);
+
+            // Show which part of the patch is visible
+            g.setColour(findColour(PlugDataColour::objectSelectedOutlineColourId));
+            g.drawRect(canvasToMinimap(viewport->getVisibleCanvasArea().toFloat()).getIntersection(bounds), 1.0f);
+
+            g.setColour(findColour(PlugDataColour::outlineColourId));
+            g.drawRoundedRectangle(bounds.reduced(0.5f), Corners::defaultCornerRadius, 1.0f);
+        }
+
+        void mouseDown(MouseEvent const& e) override
+        {
+            viewport->centreOnCanvasPoint(minimapToCanvas(e.position));
+        }
+
+        void mouseDrag(MouseEvent const& e) override
+        {
+            viewport->centreOnCanvasPoint(minimapToCanvas(e.position));
+        }
+
+        void timerCallback() override
+        {
+            stopTimer();
+            updateImage();
+            repaint();
+        }
+
+        void resized() override
+        {
+            if (isVisible())
+                updateImage();
+        }
+
+    private:
+        void updateImage()
+        {
+            auto* cnv = viewport->cnv;
+            if (getWidth() <= 0 || getHeight() <= 0)
+                return;
+
+            // The area that we show is the area that the patch covers
+            auto patchArea = Rectangle<int>(cnv->canvasOrigin, cnv->canvasOrigin + Point<int>(1, 1));
+            for (auto* object : cnv->objects) {
+                patchArea = patchArea.getUnion(object->getBounds().reduced(Object::margin));
+            }
+            mappedArea = patchArea.expanded(50).toFloat();
+
+            auto const pixelScale = Component::getApproximateScaleFactorForComponent(this);
+            auto const imageBounds = getLocalBounds() * pixelScale;
+
+            cachedImage = Image(Image::ARGB, imageBounds.getWidth(), imageBounds.getHeight(), true);
+            Graphics g(cachedImage);
+            g.addTransform(AffineTransform::scale(pixelScale));
+
+            g.setColour(cnv->findColour(PlugDataColour::connectionColourId));
+            for (auto* connection : cnv->connections) {
+                g.drawLine(Line<float>(canvasToMinimap(connection->getStartPoint()), canvasToMinimap(connection->getEndPoint())), 1.0f);
+            }
+
+            g.setColour(cnv->findColour(PlugDataColour::objectOutlineColourId));
+            for (auto* object : cnv->objects) {
+                g.fillRect(canvasToMinimap(object->getBounds().reduced(Object::margin).toFloat()));
+            }
+        }
+
+        float getMapScale() const
+        {
+            return std::min(getWidth() / mappedArea.getWidth(), getHeight() / mappedArea.getHeight());
+        }
+
+        template<typename T>
+        T canvasToMinimap(T canvasCoordinates) const
+        {
+            auto const scale = getMapScale();
+            auto const offset = mappedArea.getPosition() - Point<float>((getWidth() / scale - mappedArea.getWidth()) / 2.0f, (getHeight() / scale - mappedArea.getHeight()) / 2.0f);
+            return (canvasCoordinates - offset) * scale;
+        }
+
+        Point<float> minimapToCanvas(Point<float> minimapCoordinates) const
+        {
+            auto const scale = getMapScale();
+            auto const offset = mappedArea.getPosition() - Point<float>((getWidth() / scale - mappedArea.getWidth()) / 2.0f, (getHeight() / scale - mappedArea.getHeight()) / 2.0f);
+            return minimapCoordinates / scale + offset;
+        }
+
+        CanvasViewport* viewport;
+        Image cachedImage;
+        Rectangle<float> mappedArea = { 0.0f, 0.0f, 1.0f, 1.0f };
+    };
+
+    // While zooming with a gesture or the scroll wheel, this shows a scaled snapshot of the visible canvas on top of it
+    // Redrawing every object, connection and the grid at each zoom step is slow on big patches, so the real zoom is only
+    // applied once the gesture settles, which gives us a single full-resolution repaint
+    class ZoomSnapshot : public Component
+        , private ::Timer {
+    public:
+        explicit ZoomSnapshot(CanvasViewport* parent)
+            : viewport(parent)
+        {
+            setOpaque(true);
+            setInterceptsMouseClicks(false, false);
+        }
+
+        bool isZooming() const
+        {
+            return isVisible();
+        }
+
+        // Zooms the snapshot to newScale, around a point in viewport coordinates
+        void zoomTo(float newScale, Point<float> centre)
+        {
+            if (!isVisible() && !takeSnapshot())
+                return;
+
+            targetScale = newScale;
+            anchor = centre;
+            repaint();
+
+            // Apply the zoom when there haven't been any new zoom steps for a while
+            startTimer(150);
+        }
+
+        float getTargetScale() const
+        {
+            return targetScale;
+        }
+
+        // Applies the pending zoom to the canvas and removes the snapshot
+        void finish()
+        {
+            stopTimer();
+
+            if (!isVisible())
+                return;
+
+            snapshot = Image();
+            setVisible(false);
+            viewport->cnv->zoomScale = targetScale;
+        }
+
+        void paint(Graphics& g) override
+        {
+            g.fillAll(findColour(PlugDataColour::canvasBackgroundColourId));
+
+            auto const relativeScale = targetScale / startScale;
+            g.drawImageTransformed(snapshot, AffineTransform::scale(1.0f / pixelScale).scaled(relativeScale, relativeScale, anchor.x, anchor.y));
+        }
+
+    private:
+        bool takeSnapshot()
+        {
+            auto* contentHolder = viewport->getViewedComponent() ? viewport->getViewedComponent()->getParentComponent() : nullptr;
+            if (!contentHolder || contentHolder->getLocalBounds().isEmpty())
+                return false;
+
+            pixelScale = Component::getApproximateScaleFactorForComponent(viewport);
+            if (auto const* display = Desktop::getInstance().getDisplays().getDisplayForRect(viewport->getScreenBounds()))
+                pixelScale *= static_cast<float>(display->scale);
+
+            snapshot = contentHolder->createComponentSnapshot(contentHolder->getLocalBounds(), true, pixelScale);
+            startScale = std::max(getValue<float>(viewport->cnv->zoomScale), 0.01f);
+            targetScale = startScale;
+
+            setBounds(contentHolder->getBounds());
+            toBehind(&viewport->vbar);
+            setVisible(true);
+            return true;
+        }
+
+        void timerCallback() override
+        {
+            finish();
+        }
+
+        CanvasViewport* viewport;
+        Image snapshot;
+        Point<float> anchor;
+        float pixelScale = 1.0f;
+        float startScale = 1.0f;
+        float targetScale = 1.0f;
+    };
+
 public:
     CanvasViewport(PluginEditor* parent, Canvas* cnv)
         : editor(parent)
@@ -302,6 +511,46 @@ public:
 
         addAndMakeVisible(vbar);
         addAndMakeVisible(hbar);
+
+        showMinimap.referTo(SettingsFile::getInstance()->getPropertyAsValue("show_minimap"));
+        showMinimap.addListener(this);
+        addChildComponent(minimap);
+        minimap.setVisible(getValue<bool>(showMinimap));
+
+        addChildComponent(zoomSnapshot);
+    }
+
+    ~CanvasViewport() override
+    {
+        showMinimap.removeListener(this);
+    }
+
+    void valueChanged(Value& v) override
+    {
+        if (v.refersToSameSourceAs(showMinimap)) {
+            minimap.setVisible(getValue<bool>(showMinimap));
+            minimap.patchChanged();
+        }
+    }
+
+    // Called after the canvas has synchronised with pd, so the minimap can redraw
+    void patchChanged()
+    {
+        if (minimap.isVisible())
+            minimap.patchChanged();
+    }
+
+    // The visible area, in canvas coordinates
+    Rectangle<int> getVisibleCanvasArea() const
+    {
+        float scale = 1.0f / std::sqrt(std::abs(cnv->getTransform().getDeterminant()));
+        return getViewArea() * scale;
+    }
+
+    void centreOnCanvasPoint(Point<float> canvasPoint)
+    {
+        float scale = std::sqrt(std::abs(cnv->getTransform().getDeterminant()));
+        setViewPosition((canvasPoint * scale).roundToInt() - Point<int>(getViewWidth() / 2, getViewHeight() / 2));
     }
 
     void lookAndFeelChanged() override
@@ -324,6 +573,10 @@ public:
 
         if (e.mods.isCommandDown() && !editor->pd->isInPluginMode()) {
             mouseMagnify(e, 1.0f / (1.0f - wheel.deltaY));
+
+            // Scrolling while the zoom is pending would move the canvas underneath the snapshot
+            lastScrollTime = e.eventTime;
+            return;
         }
 
         Viewport::mouseWheelMove(e, wheel);
@@ -335,14 +588,18 @@ public:
         if (!cnv)
             return;
 
-        auto& scale = cnv->zoomScale;
-
-        auto value = getValue<float>(scale);
+        auto value = zoomSnapshot.isZooming() ? zoomSnapshot.getTargetScale() : getValue<float>(cnv->zoomScale);
 
         // Apply and limit zoom
         value = std::clamp(value * scrollFactor, 0.2f, 3.0f);
 
-        scale = value;
+        // Zoom around the mouse position, like the canvas does when the zoom gets applied
+        auto const mousePosition = getLocalPoint(nullptr, Desktop::getInstance().getMainMouseSource().getScreenPosition());
+        zoomSnapshot.zoomTo(value, mousePosition);
+
+        // No snapshot could be taken, zoom right away
+        if (!zoomSnapshot.isZooming())
+            cnv->zoomScale = value;
     }
 
     void adjustScrollbarBounds()
@@ -356,6 +613,8 @@ public:
         vbar.setBounds(localArea.removeFromRight(thickness).withTrimmedBottom(thickness).translated(-1, 0));
         hbar.setBounds(localArea.removeFromBottom(thickness));
 
+        minimap.setBounds(getLocalBounds().reduced(8).removeFromBottom(110).removeFromRight(160).translated(-(thickness + 4), -(thickness + 4)));
+
         float scale = 1.0f / std::sqrt(std::abs(cnv->getTransform().getDeterminant()));
         auto contentArea = getViewArea() * scale;
 
@@ -383,10 +642,17 @@ public:
     {
         onScroll();
         adjustScrollbarBounds();
+
+        // Only the visible area rectangle moves, the cached image stays the same
+        if (minimap.isVisible())
+            minimap.repaint();
     }
 
     void resized() override
     {
+        // The snapshot doesn't match the new bounds anymore
+        zoomSnapshot.finish();
+
         vbar.setVisible(isVerticalScrollBarShown());
         hbar.setVisible(isHorizontalScrollBarShown());
 
@@ -436,4 +702,7 @@ private:
     MousePanner panner = MousePanner(this);
     ViewportScrollBar vbar = ViewportScrollBar(true, this);
     ViewportScrollBar hbar = ViewportScrollBar(false, this);
+    Minimap minimap = Minimap(this);
+    ZoomSnapshot zoomSnapshot = ZoomSnapshot(this);
+    Value showMinimap;
 };
@@ -35,6 +35,25 @@ public:
         errorImage.image = Image();
     }
 
+    // Starts rendering the drag images in the background, so they are ready when a drag starts
+    void prepareDragAndDropImage(OfflineObjectRenderer* offlineObjectRenderer)
+    {
+        if (!dragImage.image.isNull() && !errorImage.image.isNull())
+            return;
+
+        // The object can change before the images are ready, then they're not ours anymore
+        auto scale = 3.0f;
+        auto patch = getObjectString();
+        offlineObjectRenderer->patchToMaskedImageAsync(patch, scale, false, [_this = SafePointer(this), patch](ImageWithOffset image) {
+            if (_this && _this->dragImage.image.isNull() && _this->getObjectString() == patch)
+                _this->dragImage = image;
+        });
+        offlineObjectRenderer->patchToMaskedImageAsync(patch, scale, true, [_this = SafePointer(this), patch](ImageWithOffset image) {
+            if (_this && _this->errorImage.image.isNull() && _this->getObjectString() == patch)
+                _this->errorImage = image;
+        });
+    }
+
     void setIsReordering(bool isReordering)
     {
         reordering = isReordering;
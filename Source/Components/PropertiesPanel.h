@@ -31,6 +31,10 @@ public:
 
     virtual PropertiesPanelProperty* createCopy() { return nullptr; }
 
+    // Makes the component control a different value, so it can be reused for another object
+    // Returns false if the component doesn't support that
+    virtual bool bindToValue(Value& newValue) { return false; }
+
     void setHideLabel(bool labelHidden)
     {
         hideLabel = labelHidden;
@@ -283,6 +287,12 @@ public:
             return new ComboComponent(getName(), comboBox.getSelectedIdAsValue(), items);
         }
 
+        bool bindToValue(Value& newValue) override
+        {
+            comboBox.getSelectedIdAsValue().referTo(newValue);
+            return true;
+        }
+
         StringArray items;
         ComboBox comboBox;
     };
@@ -339,6 +349,13 @@ public:
             return new FontComponent(getName(), fontValue);
         }
 
+        bool bindToValue(Value& newValue) override
+        {
+            fontValue.referTo(newValue);
+            comboBox.setText(newValue.toString(), dontSendNotification);
+            return true;
+        }
+
         void setFont(String const& fontName)
         {
             fontValue.setValue(fontValue);
@@ -459,6 +476,12 @@ public:
             return new BoolComponent(getName(), toggleStateValue, textOptions);
         }
 
+        bool bindToValue(Value& newValue) override
+        {
+            toggleStateValue.referTo(newValue);
+            return true;
+        }
+
         bool hitTest(int x, int y) override
         {
             if (!isEnabled())
@@ -602,6 +625,14 @@ public:
             return new ColourComponent(getName(), currentColour);
         }
 
+        bool bindToValue(Value& newValue) override
+        {
+            swatchComponent.colourValue.referTo(newValue);
+            currentColour.referTo(newValue);
+            swatchComponent.repaint();
+            return true;
+        }
+
         void updateHexValue()
         {
             hexValueEditor.setText(String("#") + currentColour.toString().substring(2).toUpperCase());
@@ -694,6 +725,12 @@ public:
             return new RangeComponent(getName(), property, false);
         }
 
+        bool bindToValue(Value& newValue) override
+        {
+            property.referTo(newValue);
+            return true;
+        }
+
         DraggableNumber& getMinimumComponent()
         {
             return minLabel;
@@ -786,6 +823,17 @@ public:
             return new EditableComponent<T>(getName(), property);
         }
 
+        bool bindToValue(Value& newValue) override
+        {
+            property.referTo(newValue);
+
+            // Detach the label first, so setting its text can't change the previous value
+            label->getTextValue().referTo(Value());
+            label->setText(property.toString(), dontSendNotification);
+            label->getTextValue().referTo(property);
+            return true;
+        }
+
         void setInputRestrictions(String const& newAllowedCharacters)
         {
             allowedCharacters = newAllowedCharacters;
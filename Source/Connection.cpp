@@ -17,6 +17,7 @@
 #include "LookAndFeel.h"
 #include "Pd/Patch.h"
 #include "Dialogs/ConnectionMessageDisplay.h"
+#include "Utility/SignalTap.h"
 
 Connection::Connection(Canvas* parent, Iolet* s, Iolet* e, t_outconnect* oc)
     : inlet(s->isInlet ? s : e)
@@ -89,6 +90,10 @@ Connection::Connection(Canvas* parent, Iolet* s, Iolet* e, t_outconnect* oc)
 
 Connection::~Connection()
 {
+    if (pathfindingCancelled)
+        *pathfindingCancelled = true;
+
+    cnv->connectionIndex.remove(this);
     cnv->pd->unregisterMessageListener(ptr.getRawUnchecked<void>(), this);
     cnv->selectedComponents.removeChangeListener(this);
 
@@ -124,9 +129,17 @@ void Connection::valueChanged(Value& v)
 
 void Connection::lookAndFeelChanged()
 {
-    updatePath();
-    resizeToFit();
-    repaint();
+    // Colours and strokes are read while painting, only the shape of the path depends on the theme
+    if (pathUsesStraightConnections != PlugDataLook::getUseStraightConnections()) {
+        updatePath();
+        resizeToFit();
+        repaint();
+        return;
+    }
+
+    // The window is repainted once after a theme change, but that doesn't invalidate the image we're buffered to
+    if (auto* cachedImage = getCachedComponentImage())
+        cachedImage->invalidateAll();
 }
 
 void Connection::pushPathState()
@@ -194,8 +207,24 @@ void Connection::setPointer(t_outconnect* newPtr)
     if (originalPointer != newPtr) {
         ptr = pd::WeakReference(newPtr, cnv->pd);
 
-        cnv->pd->unregisterMessageListener(originalPointer, this);
-        cnv->pd->registerMessageListener(newPtr, this);
+        if (tracing) {
+            cnv->pd->unregisterMessageListener(originalPointer, this);
+            cnv->pd->registerMessageListener(newPtr, this);
+        }
+    }
+}
+
+void Connection::updateTracing()
+{
+    auto const shouldTrace = selectedFlag || isHovering || showActiveState;
+    if (tracing == shouldTrace)
+        return;
+
+    tracing = shouldTrace;
+    if (tracing) {
+        cnv->pd->registerMessageListener(ptr.getRawUnchecked<void>(), this);
+    } else {
+        cnv->pd->unregisterMessageListener(ptr.getRawUnchecked<void>(), this);
     }
 }
 
@@ -270,6 +299,33 @@ bool Connection::intersects(Rectangle<float> toCheck, int accuracy) const
     return false;
 }
 
+Connection::StrokedPaths Connection::createStrokedPaths(Path const& connectionPath, bool isSignal, int numSignalChannels)
+{
+    // We don't know the zoom level that these will be drawn at, so flatten curves with some extra accuracy
+    constexpr float extraAccuracy = 4.0f;
+
+    bool useThinConnection = PlugDataLook::getUseThinConnections();
+
+    StrokedPaths strokes;
+    PathStrokeType(useThinConnection ? 1.0f : 2.5f, PathStrokeType::mitered, PathStrokeType::rounded).createStrokedPath(strokes.outer, connectionPath, AffineTransform(), extraAccuracy);
+
+    Path innerPath = connectionPath;
+    PathStrokeType innerStroke(useThinConnection ? 1.0f : 1.5f);
+
+    if (PlugDataLook::getUseDashedConnections() && isSignal) {
+        PathStrokeType dashedStroke(useThinConnection ? 0.5f : 0.8f);
+        float dash[1] = { numSignalChannels > 1 ? 2.5f : 5.0f };
+        Path dashedPath;
+        dashedStroke.createDashedStroke(dashedPath, connectionPath, dash, 1, AffineTransform(), extraAccuracy);
+        innerPath = dashedPath;
+        innerStroke = dashedStroke;
+    }
+    innerStroke.setEndStyle(PathStrokeType::EndCapStyle::rounded);
+    innerStroke.createStrokedPath(strokes.inner, innerPath, AffineTransform(), extraAccuracy);
+
+    return strokes;
+}
+
 void Connection::renderConnectionPath(Graphics& g,
     Canvas* cnv,
     Path const& connectionPath,
@@ -282,7 +338,8 @@ void Connection::renderConnectionPath(Graphics& g,
     bool isHovering,
     int connectionCount,
     int multiConnectNumber,
-    int numSignalChannels)
+    int numSignalChannels,
+    StrokedPaths const* cachedStrokes)
 {
     auto baseColour = cnv->findColour(PlugDataColour::connectionColourId);
     auto dataColour = cnv->findColour(PlugDataColour::dataColourId);
@@ -298,27 +355,19 @@ void Connection::renderConnectionPath(Graphics& g,
         baseColour = baseColour.brighter(0.6f);
     }
 
-    bool useThinConnection = PlugDataLook::getUseThinConnections();
+    StrokedPaths strokes;
+    if (!cachedStrokes) {
+        strokes = createStrokedPaths(connectionPath, isSignal, numSignalChannels);
+        cachedStrokes = &strokes;
+    }
 
     // outer stroke
     g.setColour(baseColour.darker(1.0f));
-    g.strokePath(connectionPath, PathStrokeType(useThinConnection ? 1.0f : 2.5f, PathStrokeType::mitered, PathStrokeType::rounded));
+    g.fillPath(cachedStrokes->outer);
 
     // inner stroke
     g.setColour(baseColour);
-    Path innerPath = connectionPath;
-    PathStrokeType innerStroke(useThinConnection ? 1.0f : 1.5f);
-
-    if (PlugDataLook::getUseDashedConnections() && isSignal) {
-        PathStrokeType dashedStroke(useThinConnection ? 0.5f : 0.8f);
-        float dash[1] = { numSignalChannels > 1 ? 2.5f : 5.0f };
-        Path dashedPath;
-        dashedStroke.createDashedStroke(dashedPath, connectionPath, dash, 1);
-        innerPath = dashedPath;
-        innerStroke = dashedStroke;
-    }
-    innerStroke.setEndStyle(PathStrokeType::EndCapStyle::rounded);
-    g.strokePath(innerPath, innerStroke);
+    g.fillPath(cachedStrokes->inner);
 
     // draw direction arrow if button is toggled (per canvas, default state is false)
     //            c
@@ -398,6 +447,7 @@ void Connection::updateOverlays(int overlay)
     showDirection = overlay & Overlay::Direction;
     showConnectionOrder = overlay & Overlay::Order;
     showActiveState = overlay & Overlay::ActivationState;
+    updateTracing();
     updatePath();
     resizeToFit();
     repaint();
@@ -412,10 +462,31 @@ void Connection::forceUpdate()
 
 void Connection::paint(Graphics& g)
 {
+    auto const isSignal = outlet != nullptr && outlet->isSignal;
+
+    // When zoomed out too far to see any detail, a plain line between both ends is enough
+    if (cnv->simplifiedRendering) {
+        auto colour = cnv->findColour(PlugDataColour::connectionColourId);
+        if (selectedFlag)
+            colour = cnv->findColour(isSignal ? PlugDataColour::signalColourId : PlugDataColour::dataColourId);
+
+        g.setColour(colour);
+        g.drawLine(Line<float>(getLocalPoint(cnv, getStartPoint()), getLocalPoint(cnv, getEndPoint())), 3.0f);
+        return;
+    }
+
+    // Everything that affects the stroke geometry, besides the path itself
+    auto const strokeStyle = PlugDataLook::getUseThinConnections() | PlugDataLook::getUseDashedConnections() << 1 | isSignal << 2 | (numSignalChannels > 1) << 3;
+    if (!cachedStrokesValid || strokeStyle != cachedStrokeStyle) {
+        cachedStrokes = createStrokedPaths(toDrawLocalSpace, isSignal, numSignalChannels);
+        cachedStrokeStyle = strokeStyle;
+        cachedStrokesValid = true;
+    }
+
     renderConnectionPath(g,
         cnv,
         toDrawLocalSpace,
-        outlet != nullptr && outlet->isSignal,
+        isSignal,
         isMouseOver(),
         showDirection,
         showConnectionOrder,
@@ -424,7 +495,8 @@ void Connection::paint(Graphics& g)
         isHovering,
         getNumberOfConnections(),
         getMultiConnectNumber(),
-        numSignalChannels);
+        numSignalChannels,
+        &cachedStrokes);
 
     /* ENABLE_CONNECTION_GRAPHICS_DEBUGGING_REPAINT
         static Random rng;
@@ -465,6 +537,7 @@ void Connection::setSelected(bool shouldBeSelected)
 {
     if (selectedFlag != shouldBeSelected) {
         selectedFlag = shouldBeSelected;
+        updateTracing();
         updatePath();
         resizeToFit();
         repaint();
@@ -499,6 +572,9 @@ void Connection::mouseMove(MouseEvent const& e)
 
 StringArray Connection::getMessageFormated()
 {
+    if (cachedMessageValid)
+        return cachedMessage;
+
     auto args = lastValue;
     auto name = lastSelector ? String::fromUTF8(lastSelector->s_name) : "";
 
@@ -536,23 +612,28 @@ StringArray Connection::getMessageFormated()
             }
         }
     }
+
+    cachedMessage = formatedMessage;
+    cachedMessageValid = true;
     return formatedMessage;
 }
 
 void Connection::mouseEnter(MouseEvent const& e)
 {
     isHovering = true;
+    updateTracing();
     if (plugdata_debugging_enabled()) {
         cnv->editor->connectionMessageDisplay->setConnection(this, e.getScreenPosition());
     }
-    repaint();
+    cnv->repaintCoordinator.repaint(this);
 }
 
 void Connection::mouseExit(MouseEvent const& e)
 {
     cnv->editor->connectionMessageDisplay->setConnection(nullptr);
     isHovering = false;
-    repaint();
+    updateTracing();
+    cnv->repaintCoordinator.repaint(this);
 }
 
 void Connection::mouseDown(MouseEvent const& e)
@@ -729,16 +810,31 @@ void Connection::resizeToFit()
     toDrawLocalSpace = toDraw;
     auto offset = getLocalPoint(cnv, Point<int>());
     toDrawLocalSpace.applyTransform(AffineTransform::translation(offset));
+    cachedStrokesValid = false;
 
     startReconnectHandle = Rectangle<float>(5, 5).withCentre(toDrawLocalSpace.getPointAlongPath(8.5f));
     endReconnectHandle = Rectangle<float>(5, 5).withCentre(toDrawLocalSpace.getPointAlongPath(std::max(toDrawLocalSpace.getLength() - 8.5f, 9.5f)));
 }
 
+void Connection::moved()
+{
+    cnv->connectionIndex.insertOrUpdate(this, getBounds());
+}
+
+void Connection::resized()
+{
+    cnv->connectionIndex.insertOrUpdate(this, getBounds());
+}
+
 void Connection::componentMovedOrResized(Component& component, bool wasMoved, bool wasResized)
 {
     if (!inlet || !outlet)
         return;
 
+    // Restart a running path search, so it uses the new position
+    if (pathfindingCancelled)
+        cnv->pathUpdater->findPathAsync(this);
+
     auto pstart = getStartPoint();
     auto pend = getEndPoint();
 
@@ -866,20 +962,14 @@ int Connection::getMultiConnectNumber()
     return -1;
 }
 
-int Connection::getSignalData(t_float* output, int maxChannels)
+std::unique_ptr<SignalTap> Connection::createSignalTap(int numBlocksToQueue, int decimation)
 {
-    if (auto oc = ptr.get<t_outconnect>()) {
-        if (auto* signal = outconnect_get_signal(oc.get())) {
-            auto numChannels = std::min(signal->s_nchans, maxChannels);
-            auto* samples = signal->s_vec;
-            if (!samples)
-                return 0;
-            std::copy(samples, samples + (DEFDACBLKSIZE * numChannels), output);
-            return numChannels;
-        }
-    }
+    return std::make_unique<SignalTap>(cnv->pd, ptr, numBlocksToQueue, decimation);
+}
 
-    return 0;
+int64 Connection::getMessageCount() const
+{
+    return cnv->pd->getMessageCount(ptr.getRawUnchecked<void>());
 }
 
 int Connection::getNumSignalChannels()
@@ -902,6 +992,8 @@ void Connection::updatePath()
     if (!outlet || !inlet)
         return;
 
+    pathUsesStraightConnections = PlugDataLook::getUseStraightConnections();
+
     auto pstart = getStartPoint();
     auto pend = getEndPoint();
 
@@ -943,9 +1035,20 @@ void Connection::updatePath()
 }
 
 void Connection::applyBestPath()
+{
+    if (!outlet || !inlet)
+        return;
+
+    // The path will be applied once the search finishes on the pathfinding thread
+    cnv->pathUpdater->findPathAsync(this);
+}
+
+void Connection::setBestPath(PathPlan const& plan)
 {
     segmented = true;
-    findPath();
+    currentPlan = plan;
+    pushPathState();
+
     updatePath();
     resizeToFit();
     repaint();
@@ -959,6 +1062,37 @@ void Connection::findPath()
     auto pstart = getStartPoint();
     auto pend = getEndPoint();
 
+    std::atomic<bool> cancelled { false };
+    currentPlan = cnv->pathUpdater->findPath(pstart, pend, getPathObstacles(pstart, pend), cancelled);
+
+    pushPathState();
+}
+
+Array<Rectangle<float>> Connection::getPathObstacles(Point<float> pstart, Point<float> pend) const
+{
+    auto obstacles = Array<Rectangle<float>>();
+    auto searchBounds = Rectangle<float>(pstart, pend);
+    auto connectionBounds = getBounds();
+
+    cnv->objectIndex.forEachItemIn(searchBounds.getSmallestIntegerContainer(), [this, &obstacles, &searchBounds, &connectionBounds](Object* object) {
+        auto bounds = object->getBounds().expanded(1);
+
+        if (object == outobj || object == inobj || !bounds.intersects(connectionBounds) || !object->getBounds().toFloat().intersects(searchBounds))
+            return;
+
+        obstacles.add(bounds.toFloat());
+    });
+
+    // Sort the obstacles, so the same layout always results in the same list
+    std::sort(obstacles.begin(), obstacles.end(), [](Rectangle<float> const& a, Rectangle<float> const& b) {
+        return a.getY() != b.getY() ? a.getY() < b.getY() : a.getX() < b.getX();
+    });
+
+    return obstacles;
+}
+
+PathPlan Connection::findBestPath(Point<float> pstart, Point<float> pend, Array<Rectangle<float>> const& obstacles, std::atomic<bool> const& cancelled)
+{
     auto pathStack = PathPlan();
     auto bestPath = PathPlan();
 
@@ -978,23 +1112,14 @@ void Connection::findPath()
     int resolutionX = 6;
     int resolutionY = 6;
 
-    auto obstacles = Array<Rectangle<float>>();
-    auto searchBounds = Rectangle<float>(pstart, pend);
-
-    for (auto* object : cnv->objects) {
-        if (object->getBounds().toFloat().intersects(searchBounds)) {
-            obstacles.add(object->getBounds().toFloat());
-        }
-    }
-
     // Look for paths at an increasing resolution
-    while (!numFound && resolutionX < maxXResolution && distance > 40) {
+    while (!numFound && resolutionX < maxXResolution && distance > 40 && !cancelled) {
 
         // Find paths on a resolution*resolution lattice ObjectGrid
         incrementX = std::max<float>(1, distanceX / resolutionX);
         incrementY = std::max<float>(1, distanceY / resolutionY);
 
-        numFound = findLatticePaths(bestPath, pathStack, pend, pstart, { incrementX, incrementY });
+        numFound = findLatticePaths(bestPath, pathStack, pend, pstart, { incrementX, incrementY }, obstacles, cancelled);
 
         if (resolutionX < maxXResolution)
             resolutionX++;
@@ -1049,25 +1174,13 @@ void Connection::findPath()
     }
     std::reverse(simplifiedPath.begin(), simplifiedPath.end());
 
-    currentPlan = simplifiedPath;
-
-    pushPathState();
+    return simplifiedPath;
 }
 
-int Connection::findLatticePaths(PathPlan& bestPath, PathPlan& pathStack, Point<float> pstart, Point<float> pend, Point<float> increment)
+int Connection::findLatticePaths(PathPlan& bestPath, PathPlan& pathStack, Point<float> pstart, Point<float> pend, Point<float> increment, Array<Rectangle<float>> const& obstacles, std::atomic<bool> const& cancelled)
 {
-
-    auto obstacles = Array<Object*>();
-    auto searchBounds = Rectangle<float>(pstart, pend);
-
-    for (auto* object : cnv->objects) {
-        if (object->getBounds().toFloat().intersects(searchBounds)) {
-            obstacles.add(object);
-        }
-    }
-
-    // Stop after we've found a path
-    if (!bestPath.empty())
+    // Stop after we've found a path, or if the search is no longer needed
+    if (!bestPath.empty() || cancelled)
         return 0;
 
     // Add point to path
@@ -1092,14 +1205,14 @@ int Connection::findLatticePaths(PathPlan& bestPath, PathPlan& pathStack, Point<
     // Get current stack to revert to after each trial
     auto pathCopy = pathStack;
 
-    auto followLine = [this, &count, &pathCopy, &bestPath, &pathStack, &increment](Point<float> currentOutlet, Point<float> currentInlet, bool isX) {
+    auto followLine = [&count, &pathCopy, &bestPath, &pathStack, &increment, &obstacles, &cancelled](Point<float> currentOutlet, Point<float> currentInlet, bool isX) {
         auto& coord1 = isX ? currentOutlet.x : currentOutlet.y;
         auto& coord2 = isX ? currentInlet.x : currentInlet.y;
         auto& incr = isX ? increment.x : increment.y;
 
         if (std::abs(coord1 - coord2) >= incr) {
             coord1 > coord2 ? coord1 -= incr : coord1 += incr;
-            count += findLatticePaths(bestPath, pathStack, currentOutlet, currentInlet, increment);
+            count += findLatticePaths(bestPath, pathStack, currentOutlet, currentInlet, increment, obstacles, cancelled);
             pathStack = pathCopy;
         }
     };
@@ -1136,14 +1249,10 @@ bool Connection::intersectsObject(Object* object) const
         || toDraw.intersectsLine({ b.getBottomRight(), b.getTopRight() });
 }
 
-bool Connection::straightLineIntersectsObject(Line<float> toCheck, Array<Object*>& objects)
+bool Connection::straightLineIntersectsObject(Line<float> toCheck, Array<Rectangle<float>> const& obstacles)
 {
 
-    for (auto const& object : objects) {
-        auto bounds = object->getBounds().expanded(1);
-
-        if (object == outobj || object == inobj || !bounds.intersects(getBounds()))
-            continue;
+    for (auto const& bounds : obstacles) {
 
         auto intersectV = [](Line<float> first, Line<float> second) {
             if (first.getStartY() > first.getEndY()) {
@@ -1161,9 +1270,9 @@ bool Connection::straightLineIntersectsObject(Line<float> toCheck, Array<Object*
             return first.getStartY() > second.getStartY() && first.getStartY() < second.getEndY() && second.getStartX() > first.getStartX() && second.getStartX() < first.getEndX();
         };
 
-        bool intersectsV = toCheck.isVertical() && (intersectV(toCheck, Line<float>(bounds.getTopLeft().toFloat(), bounds.getTopRight().toFloat())) || intersectV(toCheck, Line<float>(bounds.getBottomRight().toFloat(), bounds.getBottomLeft().toFloat())));
+        bool intersectsV = toCheck.isVertical() && (intersectV(toCheck, Line<float>(bounds.getTopLeft(), bounds.getTopRight())) || intersectV(toCheck, Line<float>(bounds.getBottomRight(), bounds.getBottomLeft())));
 
-        bool intersectsH = toCheck.isHorizontal() && (intersectH(toCheck, Line<float>(bounds.getTopRight().toFloat(), bounds.getBottomRight().toFloat())) || intersectH(toCheck, Line<float>(bounds.getTopLeft().toFloat(), bounds.getBottomLeft().toFloat())));
+        bool intersectsH = toCheck.isHorizontal() && (intersectH(toCheck, Line<float>(bounds.getTopRight(), bounds.getBottomRight())) || intersectH(toCheck, Line<float>(bounds.getTopLeft(), bounds.getBottomLeft())));
         if (intersectsV || intersectsH) {
             return true;
         }
@@ -1177,8 +1286,77 @@ bool Connection::straightLineIntersectsObject(Line<float> toCheck, Array<Object*
     return false;
 }
 
+PathPlan ConnectionPathUpdater::findPath(Point<float> start, Point<float> end, Array<Rectangle<float>> obstacles, std::atomic<bool> const& cancelled)
+{
+    // Make everything relative to the start point, so moving a group of objects can reuse the paths between them
+    end -= start;
+    for (auto& obstacle : obstacles)
+        obstacle -= start;
+
+    {
+        std::lock_guard<std::mutex> lock(pathCacheMutex);
+        for (auto& cached : pathCache) {
+            if (cached.end == end && cached.obstacles == obstacles) {
+                auto plan = cached.plan;
+                for (auto& point : plan)
+                    point += start;
+                return plan;
+            }
+        }
+    }
+
+    auto plan = Connection::findBestPath({ 0.0f, 0.0f }, end, obstacles, cancelled);
+
+    // A cancelled search can return an incomplete result
+    if (!cancelled) {
+        std::lock_guard<std::mutex> lock(pathCacheMutex);
+        pathCache.push_front({ end, obstacles, plan });
+        if (pathCache.size() > maxCachedPaths)
+            pathCache.pop_back();
+    }
+
+    for (auto& point : plan)
+        point += start;
+
+    return plan;
+}
+
+void ConnectionPathUpdater::findPathAsync(Connection* connection)
+{
+    if (connection->pathfindingCancelled)
+        *connection->pathfindingCancelled = true;
+
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    connection->pathfindingCancelled = cancelled;
+
+    auto start = connection->getStartPoint();
+    auto end = connection->getEndPoint();
+    auto obstacles = connection->getPathObstacles(start, end);
+
+    pathfindingPool.addJob([this, connection = Component::SafePointer<Connection>(connection), start, end, obstacles, cancelled]() {
+        auto plan = findPath(start, end, obstacles, *cancelled);
+        if (*cancelled)
+            return;
+
+        MessageManager::callAsync([connection, cancelled, plan]() {
+            if (!connection || *cancelled)
+                return;
+
+            connection->pathfindingCancelled.reset();
+            connection->setBestPath(plan);
+        });
+    });
+}
+
 void ConnectionPathUpdater::timerCallback()
 {
+    // Paths that are still being searched for are part of the same edit, like "Find best path" on a selection
+    // Wait for them, so the whole edit ends up in a single undo sequence
+    for (auto* connection : canvas->connections) {
+        if (connection->pathfindingCancelled && !*connection->pathfindingCancelled)
+            return;
+    }
+
     stopTimer();
 
     std::pair<Component::SafePointer<Connection>, t_symbol*> currentConnection;
@@ -1243,4 +1421,5 @@ void Connection::receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int n
     std::copy(atoms, atoms + numAtoms, lastValue);
     lastNumArgs = numAtoms;
     lastSelector = symbol;
+    cachedMessageValid = false;
 }
@@ -21,6 +21,7 @@ using PathPlan = std::vector<Point<float>>;
 
 class Canvas;
 class PathUpdater;
+class SignalTap;
 
 class Connection : public Component
     , public ComponentListener
@@ -45,6 +46,13 @@ public:
 
     void updateOverlays(int overlay);
 
+    // Stroked outlines of a connection path, so they can be filled directly instead of stroking the path on every paint
+    struct StrokedPaths {
+        Path outer, inner;
+    };
+
+    static StrokedPaths createStrokedPaths(Path const& connectionPath, bool isSignal, int numSignalChannels);
+
     static void renderConnectionPath(Graphics& g,
         Canvas* cnv,
         Path const& connectionPath,
@@ -57,11 +65,14 @@ public:
         bool isHovering = false,
         int connections = 0,
         int connectionNum = 0,
-        int numSignalChannels = 0);
+        int numSignalChannels = 0,
+        StrokedPaths const* cachedStrokes = nullptr);
 
     static Path getNonSegmentedPath(Point<float> start, Point<float> end);
 
     void paint(Graphics&) override;
+    void moved() override;
+    void resized() override;
 
     bool isSegmented() const;
     void setSegmented(bool segmented);
@@ -101,21 +112,30 @@ public:
     void componentMovedOrResized(Component& component, bool wasMoved, bool wasResized) override;
 
     // Pathfinding
-    int findLatticePaths(PathPlan& bestPath, PathPlan& pathStack, Point<float> start, Point<float> end, Point<float> increment);
+    static PathPlan findBestPath(Point<float> start, Point<float> end, Array<Rectangle<float>> const& obstacles, std::atomic<bool> const& cancelled);
+    static int findLatticePaths(PathPlan& bestPath, PathPlan& pathStack, Point<float> start, Point<float> end, Point<float> increment, Array<Rectangle<float>> const& obstacles, std::atomic<bool> const& cancelled);
+
+    Array<Rectangle<float>> getPathObstacles(Point<float> start, Point<float> end) const;
 
     void findPath();
 
+    // Finds the best path on a background thread, and applies it when done
     void applyBestPath();
 
     bool intersectsObject(Object* object) const;
-    bool straightLineIntersectsObject(Line<float> toCheck, Array<Object*>& objects);
+    static bool straightLineIntersectsObject(Line<float> toCheck, Array<Rectangle<float>> const& obstacles);
 
     void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms) override;
 
     bool isSelected() const;
 
     StringArray getMessageFormated();
-    int getSignalData(t_float* output, int maxChannels);
+
+    // Starts copying the signal that flows through this connection, until the tap is deleted
+    std::unique_ptr<SignalTap> createSignalTap(int numBlocksToQueue, int decimation = 1);
+
+    // Number of messages that passed through this connection while debugging was enabled
+    int64 getMessageCount() const;
 
 private:
     void resizeToFit();
@@ -128,6 +148,11 @@ private:
 
     void setSelected(bool shouldBeSelected);
 
+    void setBestPath(PathPlan const& plan);
+
+    // Only listens to the messages that pass through while someone can see them: when hovered, selected, or showing activity
+    void updateTracing();
+
     Array<SafePointer<Connection>> reconnecting;
     Rectangle<float> startReconnectHandle, endReconnectHandle, endCableOrderDisplay;
 
@@ -136,6 +161,16 @@ private:
 
     PathPlan currentPlan;
 
+    // Set when a background path search for this connection is running, so we can cancel it
+    std::shared_ptr<std::atomic<bool>> pathfindingCancelled;
+
+    // Cached stroke geometry of toDrawLocalSpace, only recreated when the path or the connection style changes
+    StrokedPaths cachedStrokes;
+    bool cachedStrokesValid = false;
+    int cachedStrokeStyle = -1;
+
+    bool pathUsesStraightConnections = false;
+
     Value locked;
     Value presentationMode;
 
@@ -157,6 +192,11 @@ private:
     pd::Atom lastValue[8];
     int lastNumArgs = 0;
     t_symbol* lastSelector = nullptr;
+    bool tracing = false;
+
+    // Formatted version of the last message, only rebuilt when a new message comes in
+    StringArray cachedMessage;
+    bool cachedMessageValid = false;
 
     friend class ConnectionPathUpdater;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Connection)
@@ -243,6 +283,20 @@ class ConnectionPathUpdater : public Timer {
 
     moodycamel::ReaderWriterQueue<std::pair<Component::SafePointer<Connection>, t_symbol*>> connectionUpdateQueue = moodycamel::ReaderWriterQueue<std::pair<Component::SafePointer<Connection>, t_symbol*>>(4096);
 
+    // Recently found paths, relative to the start point, with the obstacles that were around them
+    struct CachedPath {
+        Point<float> end;
+        Array<Rectangle<float>> obstacles;
+        PathPlan plan;
+    };
+
+    static constexpr int maxCachedPaths = 64;
+
+    std::mutex pathCacheMutex;
+    std::deque<CachedPath> pathCache;
+
+    ThreadPool pathfindingPool = ThreadPool(2);
+
     void timerCallback() override;
 
 public:
@@ -251,6 +305,12 @@ public:
     {
     }
 
+    // Finds a path, or returns a cached one if we've already seen the same endpoints and obstacles
+    PathPlan findPath(Point<float> start, Point<float> end, Array<Rectangle<float>> obstacles, std::atomic<bool> const& cancelled);
+
+    // Starts a path search on the pathfinding thread, cancelling any search still running for this connection
+    void findPathAsync(Connection* connection);
+
     void pushPathState(Connection* connection, t_symbol* newPathState)
     {
         connectionUpdateQueue.enqueue({ connection, newPathState });
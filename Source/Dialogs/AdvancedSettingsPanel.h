@@ -129,6 +129,12 @@ public:
         centreSidepanelButtons = settingsFile->getPropertyAsValue("centre_sidepanel_buttons");
         interfaceProperties.add(new PropertiesPanel::BoolComponent("Centre canvas sidepanel selectors", centreSidepanelButtons, { "No", "Yes" }));
 
+        hardwareRendering.referTo(settingsFile->getPropertyAsValue("hardware_rendering"));
+        interfaceProperties.add(new PropertiesPanel::BoolComponent("Use hardware rendering (OpenGL)", hardwareRendering, { "No", "Yes" }));
+
+        showMinimap.referTo(settingsFile->getPropertyAsValue("show_minimap"));
+        interfaceProperties.add(new PropertiesPanel::BoolComponent("Show minimap", showMinimap, { "No", "Yes" }));
+
         propertiesPanel.addSection("Interface", interfaceProperties);
         propertiesPanel.addSection("Autosave", autosaveProperties);
         propertiesPanel.addSection("Other", otherProperties);
@@ -183,6 +189,8 @@ public:
     Value defaultZoom;
     Value centreResized;
     Value centreSidepanelButtons;
+    Value hardwareRendering;
+    Value showMinimap;
 
     Value showPalettesValue;
     Value autoPatchingValue;
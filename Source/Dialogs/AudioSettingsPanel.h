@@ -7,6 +7,9 @@
 
 #include <utility>
 
+#include "Utility/RealtimeThreadSettings.h"
+#include "Utility/BufferSizeTuner.h"
+
 class DeviceManagerLevelMeter : public Component
     , public Timer {
 
@@ -166,11 +169,15 @@ class StandaloneAudioSettings : public SettingsDialogPanel
     , public Value::Listener {
 
 public:
-    explicit StandaloneAudioSettings(AudioDeviceManager& audioDeviceManager)
+    StandaloneAudioSettings(PluginProcessor* audioProcessor, AudioDeviceManager& audioDeviceManager)
         : inputLevelMeter(audioDeviceManager.getInputLevelGetter())
         , outputLevelMeter(audioDeviceManager.getOutputLevelGetter())
         , deviceManager(audioDeviceManager)
+        , processor(audioProcessor)
     {
+        autoTuneHeadroomValue.referTo(SettingsFile::getInstance()->getPropertyAsValue("buffer_autotune_headroom"));
+        bufferSizeTuner = std::make_unique<BufferSizeTuner>(deviceManager, processor->deadlineMonitor);
+
         deviceManager.addChangeListener(this);
         addAndMakeVisible(audioPropertiesPanel);
 
@@ -183,6 +190,17 @@ public:
 
         showAllAudioDeviceValues.addListener(this);
         showAllAudioDeviceValues.referTo(SettingsFile::getInstance()->getPropertyAsValue("show_all_audio_device_rates"));
+
+        workerThreadsValue.referTo(SettingsFile::getInstance()->getPropertyAsValue("realtime_worker_threads"));
+        workerThreadsValue.addListener(this);
+
+        for (int role = 0; role < RealtimeThreadSettings::NumRoles; role++) {
+            auto const threadRole = static_cast<RealtimeThreadSettings::Role>(role);
+            realtimePriorityValues[role].referTo(SettingsFile::getInstance()->getPropertyAsValue(RealtimeThreadSettings::getSettingName(threadRole, "priority")));
+            realtimePriorityValues[role].addListener(this);
+            realtimeCoreValues[role].referTo(SettingsFile::getInstance()->getPropertyAsValue(RealtimeThreadSettings::getSettingName(threadRole, "cores")));
+            realtimeCoreValues[role].addListener(this);
+        }
     }
 
     ~StandaloneAudioSettings() override
@@ -200,6 +218,15 @@ private:
     {
         if (v.refersToSameSourceAs(showAllAudioDeviceValues))
             updateDevices();
+
+        if (v.refersToSameSourceAs(workerThreadsValue))
+            RealtimeWorkerPool::getInstance()->setCoreBudget(::getValue<int>(workerThreadsValue));
+
+        for (int role = 0; role < RealtimeThreadSettings::NumRoles; role++) {
+            if (v.refersToSameSourceAs(realtimePriorityValues[role]) || v.refersToSameSourceAs(realtimeCoreValues[role])) {
+                RealtimeThreadSettings::getInstance().setThreadSettings(static_cast<RealtimeThreadSettings::Role>(role), ::getValue<int>(realtimePriorityValues[role]), realtimeCoreValues[role].toString());
+            }
+        }
     }
 
     void updateDevices()
@@ -289,6 +316,24 @@ private:
                 setup.bufferSize = selected.getIntValue();
                 updateConfig();
             }));
+
+            if (bufferSizeTuner) {
+                deviceConfigurationProperties.add(new PropertiesPanel::EditableComponent<int>("Auto-tune headroom (%)", autoTuneHeadroomValue, 5, 90));
+                deviceConfigurationProperties.add(new PropertiesPanel::ActionComponent([this]() {
+                    if (bufferSizeTuner->isRunning()) {
+                        bufferSizeTuner->cancel();
+                        processor->logMessage("Buffer size auto-tune: cancelled");
+                        return;
+                    }
+
+                    processor->logMessage("Buffer size auto-tune: measuring, this takes a few seconds per buffer size");
+                    bufferSizeTuner->start(::getValue<int>(autoTuneHeadroomValue) / 100.0f, [_this = SafePointer(this)](String const& result) {
+                        if (_this)
+                            _this->processor->logMessage(result);
+                    });
+                },
+                    Icons::Refresh, "Auto-tune buffer size"));
+            }
         }
 
         // This can possibly be empty if only one device type is available, and there is no device currently selected
@@ -380,6 +425,23 @@ private:
         audioPropertiesPanel.addSection("Audio Output", outputProperties);
         audioPropertiesPanel.addSection("Audio Input", inputProperties);
 
+        // Shared by everything that renders audio in parallel with Pd, like the internal synth
+        audioPropertiesPanel.addSection("Worker Threads", { new PropertiesPanel::EditableComponent<int>("DSP worker threads", workerThreadsValue, 0, 64) });
+
+#if JUCE_LINUX
+        // SCHED_FIFO priority from 1 to 99 (0 leaves the default), and a list of cores like "2,3" or "2-5"
+        Array<PropertiesPanelProperty*> realtimeProperties;
+        StringArray const threadNames = { "Audio callback", "MIDI output", "DSP worker" };
+        for (int role = 0; role < RealtimeThreadSettings::NumRoles; role++) {
+            realtimeProperties.add(new PropertiesPanel::EditableComponent<int>(threadNames[role] + " priority", realtimePriorityValues[role], 0, 99));
+
+            auto* coresProperty = new PropertiesPanel::EditableComponent<String>(threadNames[role] + " cores", realtimeCoreValues[role]);
+            coresProperty->setInputRestrictions("0123456789,-");
+            realtimeProperties.add(coresProperty);
+        }
+        audioPropertiesPanel.addSection("Realtime Threads", realtimeProperties);
+#endif
+
         auto* outputSection = audioPropertiesPanel.getSectionByName("Audio Output");
         auto* inputSection = audioPropertiesPanel.getSectionByName("Audio Input");
 
@@ -445,12 +507,19 @@ private:
     AudioDeviceManager::AudioDeviceSetup setup;
 
     AudioDeviceManager& deviceManager;
+    PluginProcessor* processor;
     PropertiesPanel audioPropertiesPanel;
 
     bool showAllInputChannels = false;
     bool showAllOutputChannels = false;
 
     Value showAllAudioDeviceValues;
+    Value autoTuneHeadroomValue;
+    Value workerThreadsValue;
+
+    std::unique_ptr<BufferSizeTuner> bufferSizeTuner;
+    Value realtimePriorityValues[RealtimeThreadSettings::NumRoles];
+    Value realtimeCoreValues[RealtimeThreadSettings::NumRoles];
 
     StringArray standardBufferSizes = { "16", "32", "64", "128", "256", "512", "1024", "2048" };
     StringArray standardSampleRates = { "44100", "48000", "88200", "96000", "176400", "192000" };
@@ -468,18 +537,44 @@ public:
         auto* proc = dynamic_cast<PluginProcessor*>(processor);
         tailLengthValue.referTo(proc->tailLength);
 
+        autoSleepValue = proc->dspSleepDetector.isEnabled();
+        autoSleepValue.addListener(this);
+
+        renderAheadValue = proc->isRenderAheadEnabled();
+        renderAheadValue.addListener(this);
+
+        exposedParametersValue.referTo(SettingsFile::getInstance()->getPropertyAsValue("exposed_parameters"));
+
         latencyValue.addListener(this);
 
         latencyValue = proc->getLatencySamples();
 
+        blockSizeValue = blockSizes.indexOf(String(proc->pd::Instance::getBlockSize())) + 1;
+        blockSizeValue.addListener(this);
+
+        oversamplingFilterValue = proc->oversamplingFilter + 1;
+        oversamplingFilterValue.addListener(this);
+
         latencyNumberBox = new PropertiesPanel::EditableComponent<int>("Latency (samples)", latencyValue);
         tailLengthNumberBox = new PropertiesPanel::EditableComponent<float>("Tail length (seconds)", tailLengthValue);
+        auto* blockSizeComboBox = new PropertiesPanel::ComboComponent("Pd block size", blockSizeValue, blockSizes);
+        auto* oversamplingFilterComboBox = new PropertiesPanel::ComboComponent("Oversampling filter", oversamplingFilterValue, { "Polyphase IIR (low latency)", "FIR half-band (linear phase)" });
+
+        // Stops Pd's DSP when there has been no input or output for the tail length, note that this also stops clocks like [metro]
+        auto* autoSleepToggle = new PropertiesPanel::BoolComponent("Sleep when silent", autoSleepValue, { "No", "Yes" });
+
+        // Renders patches that don't use any input ahead of time on a background thread, this adds latency
+        auto* renderAheadToggle = new PropertiesPanel::BoolComponent("Render ahead without input", renderAheadValue, { "No", "Yes" });
+
+        dawSettingsPanel.addSection("Audio", { latencyNumberBox, tailLengthNumberBox, blockSizeComboBox, oversamplingFilterComboBox, autoSleepToggle, renderAheadToggle });
 
-        dawSettingsPanel.addSection("Audio", { latencyNumberBox, tailLengthNumberBox });
+        // Number of automation parameters that new instances offer to the DAW, the others are still registered but not listed for automation
+        // This doesn't lower the host's overhead, since it still sees every parameter
+        dawSettingsPanel.addSection("Parameters", { new PropertiesPanel::EditableComponent<int>("Exposed parameters", exposedParametersValue, 1, PluginProcessor::numParameters) });
 
         addAndMakeVisible(dawSettingsPanel);
 
-        latencyNumberBox->setRangeMin(64);
+        latencyNumberBox->setRangeMin(proc->pd::Instance::getBlockSize());
     }
 
     PropertiesPanel* getPropertiesPanel() override
@@ -496,13 +591,38 @@ public:
     {
         if (v.refersToSameSourceAs(latencyValue)) {
             processor->setLatencySamples(getValue<int>(latencyValue));
+        } else if (v.refersToSameSourceAs(blockSizeValue)) {
+            auto* proc = dynamic_cast<PluginProcessor*>(processor);
+            auto newBlockSize = blockSizes[std::clamp(getValue<int>(blockSizeValue) - 1, 0, blockSizes.size() - 1)].getIntValue();
+            proc->setPdBlockSize(newBlockSize);
+
+            // Latency can't be lower than the block size, setPdBlockSize may have raised it
+            latencyNumberBox->setRangeMin(newBlockSize);
+            latencyValue = proc->getLatencySamples();
+        } else if (v.refersToSameSourceAs(oversamplingFilterValue)) {
+            auto* proc = dynamic_cast<PluginProcessor*>(processor);
+            proc->setOversamplingFilter(std::clamp(getValue<int>(oversamplingFilterValue) - 1, 0, 1));
+            latencyValue = proc->getLatencySamples();
+        } else if (v.refersToSameSourceAs(autoSleepValue)) {
+            auto* proc = dynamic_cast<PluginProcessor*>(processor);
+            proc->setAutoSleep(getValue<bool>(autoSleepValue));
+        } else if (v.refersToSameSourceAs(renderAheadValue)) {
+            auto* proc = dynamic_cast<PluginProcessor*>(processor);
+            proc->setRenderAhead(getValue<bool>(renderAheadValue));
+            latencyValue = proc->getLatencySamples();
         }
     }
 
     AudioProcessor* processor;
 
+    StringArray blockSizes = { "64", "128", "256", "512" };
+    Value blockSizeValue;
+    Value oversamplingFilterValue;
     Value latencyValue;
     Value tailLengthValue;
+    Value autoSleepValue;
+    Value renderAheadValue;
+    Value exposedParametersValue;
 
     PropertiesPanel dawSettingsPanel;
 
@@ -14,6 +14,7 @@
 #include "Connection.h"
 #include "PluginEditor.h"
 #include "CanvasViewport.h"
+#include "Utility/SignalTap.h"
 
 class ConnectionMessageDisplay
     : public Component
@@ -42,8 +43,6 @@ public:
             return;
 
         auto clearSignalDisplayBuffer = [this]() {
-            SignalBlock sample;
-            while (sampleQueue.try_dequeue(sample)) { };
             for (int ch = 0; ch < 8; ch++) {
                 std::fill(lastSamples[ch], lastSamples[ch] + signalBlockSize, 0.0f);
                 cycleLength[ch] = 0.0f;
@@ -60,11 +59,11 @@ public:
             stopTimer(MouseHoverExitDelay);
             if (isSignalDisplay) {
                 clearSignalDisplayBuffer();
-                auto* pd = activeConnection->outobj->cnv->pd;
-                pd->connectionListener = this;
+                signalTap = activeConnection->createSignalTap(numBlocks);
                 startTimer(RepaintTimer, 1000 / 5);
                 updateSignalGraph();
             } else {
+                signalTap.reset();
                 startTimer(RepaintTimer, 1000 / 60);
                 updateTextString(true);
             }
@@ -77,22 +76,9 @@ public:
         }
     }
 
-    void updateSignalData()
-    {
-        if (!activeConnection)
-            return;
-
-        float output[DEFDACBLKSIZE * 8];
-        if (auto numChannels = activeConnection->getSignalData(output, 8)) {
-            sampleQueue.try_enqueue(SignalBlock(output, numChannels));
-        }
-    }
-
 private:
     void updateTextString(bool isHoverEntered = false)
     {
-        messageItemsWithFormat.clear();
-
         auto haveMessage = true;
         auto textString = activeConnection->getMessageFormated();
 
@@ -101,6 +87,27 @@ private:
             textString = StringArray("no message yet");
         }
 
+        // Show how busy the connection is, measured over the last second
+        auto const currentTime = Time::getMillisecondCounter();
+        if (isHoverEntered || currentTime - lastMessageCountTime >= 1000) {
+            auto const messageCount = activeConnection->getMessageCount();
+            messagesPerSecond = isHoverEntered ? 0 : (messageCount - lastMessageCount) * 1000 / std::max<int64>(currentTime - lastMessageCountTime, 1);
+            lastMessageCount = messageCount;
+            lastMessageCountTime = currentTime;
+        }
+
+        if (haveMessage && messagesPerSecond > 0) {
+            auto const lastIndex = textString.size() - 1;
+            textString.set(lastIndex, textString[lastIndex] + "  (" + String(messagesPerSecond) + "/s)");
+        }
+
+        // This runs at 60Hz, only measure and repaint the text when it changed
+        if (!isHoverEntered && textString == lastTextString)
+            return;
+
+        lastTextString = textString;
+        messageItemsWithFormat.clear();
+
         auto halfEditorWidth = getParentComponent()->getWidth() / 2;
         auto fontStyle = haveMessage ? FontStyle::Semibold : FontStyle::Regular;
         auto textFont = Font(haveMessage ? Fonts::getSemiBoldFont() : Fonts::getDefaultFont());
@@ -155,10 +162,10 @@ private:
 
     void updateSignalGraph()
     {
-        if (activeConnection) {
+        if (activeConnection && signalTap) {
             int i = 0;
-            SignalBlock block;
-            while (sampleQueue.try_dequeue(block)) {
+            SignalTap::Block block;
+            while (signalTap->read(block)) {
                 if (i < numBlocks) {
                     lastNumChannels = block.numChannels;
                     for (int ch = 0; ch < block.numChannels; ch++) {
@@ -176,10 +183,7 @@ private:
 
     void hideDisplay()
     {
-        if (activeConnection) {
-            auto* pd = activeConnection->outobj->cnv->pd;
-            pd->connectionListener = nullptr;
-        }
+        signalTap.reset();
         stopTimer(RepaintTimer);
         setVisible(false);
         activeConnection = nullptr;
@@ -377,42 +381,15 @@ private:
 
     Rectangle<int> previousBounds;
 
-    struct SignalBlock {
-        SignalBlock()
-            : numChannels(0)
-        {
-        }
-
-        SignalBlock(float* input, int channels)
-            : numChannels(channels)
-        {
-            std::copy(input, input + (numChannels * DEFDACBLKSIZE), samples);
-        }
-
-        SignalBlock(SignalBlock&& toMove)
-        {
-            numChannels = toMove.numChannels;
-            std::copy(toMove.samples, toMove.samples + (numChannels * DEFDACBLKSIZE), samples);
-        }
-
-        SignalBlock& operator=(SignalBlock&& toMove)
-        {
-            if (&toMove != this) {
-                numChannels = toMove.numChannels;
-                std::copy(toMove.samples, toMove.samples + (numChannels * DEFDACBLKSIZE), samples);
-            }
-            return *this;
-        }
-
-        float samples[32 * DEFDACBLKSIZE];
-        int numChannels;
-    };
-
     Image oscilloscopeImage;
     static constexpr int signalBlockSize = 1024;
     static constexpr int numBlocks = 1024 / 64;
-    // 32*64 samples gives us space for 1024 samples across 8 channels
-    moodycamel::ReaderWriterQueue<SignalBlock> sampleQueue = moodycamel::ReaderWriterQueue<SignalBlock>(numBlocks);
+    std::unique_ptr<SignalTap> signalTap;
+
+    StringArray lastTextString;
+    int64 lastMessageCount = 0;
+    int64 messagesPerSecond = 0;
+    uint32 lastMessageCountTime = 0;
 
     float cycleLength[8] = { 0.0f };
     float lastSamples[8][1024] = { { 0.0f } };
@@ -78,66 +78,91 @@ class PackageManager : public Thread
     , public DeletedAtShutdown {
 
 public:
-    struct DownloadTask : public Thread {
+    // Downloads run on the manager's download pool, so only a few packages download at the same time
+    struct DownloadTask : public ThreadPoolJob {
         PackageManager& manager;
         PackageInfo packageInfo;
 
-        std::unique_ptr<InputStream> instream;
-
         DownloadTask(PackageManager& m, PackageInfo& info)
-            : Thread("Download Thread")
+            : ThreadPoolJob("Download Thread")
             , manager(m)
             , packageInfo(info)
         {
-            int statusCode = 0;
-            instream = URL(info.url).createInputStream(URL::InputStreamOptions(URL::ParameterHandling::inAddress)
-                                                           .withConnectionTimeoutMs(10000)
-                                                           .withStatusCode(&statusCode));
-
-            if (instream != nullptr && statusCode == 200) {
-                startThread();
-            } else {
-                finish(Result::fail("Failed to start download"));
-                return;
-            }
+            manager.downloadPool.addJob(this, false);
         }
 
         ~DownloadTask() override
         {
-            stopThread(-1);
+            manager.downloadPool.removeJob(this, true, -1);
         }
 
-        void run() override
+        JobStatus runJob() override
         {
-            MemoryBlock dekData;
+            // Downloads go into a file first, so a cancelled or failed download can continue where it left off
+            auto partialFile = downloadCache.getChildFile(String::toHexString(packageInfo.packageId.hashCode64()) + ".part");
+            downloadCache.createDirectory();
 
-            int64 totalBytes = instream->getTotalLength();
-            int64 bytesDownloaded = 0;
+            auto resumeFrom = partialFile.existsAsFile() ? partialFile.getSize() : 0;
+
+            int statusCode = 0;
+            auto instream = URL(packageInfo.url).createInputStream(URL::InputStreamOptions(URL::ParameterHandling::inAddress)
+                                                                       .withConnectionTimeoutMs(10000)
+                                                                       .withExtraHeaders(resumeFrom > 0 ? "Range: bytes=" + String(resumeFrom) + "-" : String())
+                                                                       .withStatusCode(&statusCode));
+
+            if (instream == nullptr || (statusCode != 200 && statusCode != 206)) {
+                // The partial file could be invalid, or already complete, start over next time
+                partialFile.deleteFile();
+                finish(Result::fail("Failed to start download"));
+                return jobHasFinished;
+            }
 
-            MemoryOutputStream mo(dekData, true);
+            // Servers that don't support range requests send the whole file again
+            if (statusCode == 200) {
+                partialFile.deleteFile();
+                resumeFrom = 0;
+            }
 
-            while (true) {
-                if (threadShouldExit()) {
-                    finish(Result::fail("Download cancelled"));
-                    return;
+            {
+                FileOutputStream output(partialFile);
+                if (output.failedToOpen()) {
+                    finish(Result::fail("Failed to write download"));
+                    return jobHasFinished;
                 }
 
-                auto written = mo.writeFromInputStream(*instream, 8192);
+                int64 totalBytes = resumeFrom + instream->getTotalLength();
+                int64 bytesDownloaded = resumeFrom;
+                float lastProgress = 0.0f;
 
-                if (written == 0)
-                    break;
+                while (true) {
+                    if (shouldExit()) {
+                        finish(Result::fail("Download cancelled"));
+                        return jobHasFinished;
+                    }
 
-                bytesDownloaded += written;
+                    auto written = output.writeFromInputStream(*instream, 65536);
 
-                float progress = static_cast<long double>(bytesDownloaded) / static_cast<long double>(totalBytes);
+                    if (written <= 0)
+                        break;
 
-                MessageManager::callAsync([this, progress]() mutable {
-                    onProgress(progress);
-                });
+                    bytesDownloaded += written;
+
+                    float progress = static_cast<long double>(bytesDownloaded) / static_cast<long double>(totalBytes);
+
+                    // No need to repaint for every chunk
+                    if (progress - lastProgress >= 0.01f) {
+                        lastProgress = progress;
+                        MessageManager::callAsync([this, progress]() mutable {
+                            if (onProgress)
+                                onProgress(progress);
+                        });
+                    }
+                }
             }
 
-            MemoryInputStream input(dekData, false);
-            ZipFile zip(input);
+            // Zip files keep their table of contents at the end, so we can only start extracting once everything is there
+            // We extract straight from the downloaded file, instead of keeping the whole archive in memory
+            ZipFile zip(partialFile);
 
             /* This check produces false positives sometimes, so I've disabled it
              if (zip.getNumEntries() == 0) {
@@ -148,27 +173,30 @@ public:
             auto extractedPath = filesystem.getChildFile(packageInfo.name).getFullPathName();
             auto result = zip.uncompressTo(filesystem);
 
+            // Whether it's completed or broken, we don't need to resume this one
+            partialFile.deleteFile();
+
             if (!result.wasOk()) {
                 finish(result);
-                return;
+                return jobHasFinished;
             }
 
             // Tell deken about the newly installed package
             manager.addPackageToRegister(packageInfo, extractedPath);
 
             finish(Result::ok());
+            return jobHasFinished;
         }
 
         void finish(Result result)
         {
             MessageManager::callAsync(
                 [this, result, finishCopy = onFinish]() mutable {
-                    waitForThreadToExit(-1);
-
-                    // Self-destruct
+                    // Self-destruct, this waits for the job to return
                     manager.downloads.removeObject(this);
 
-                    finishCopy(result);
+                    if (finishCopy)
+                        finishCopy(result);
                 });
         }
 
@@ -228,17 +256,39 @@ public:
         auto triplet = os + "-" + machine + "-" + floatsize;
         auto repoForArchitecture = "https://raw.githubusercontent.com/plugdata-team/plugdata-deken/main/bin/" + triplet + ".bin";
 
+        // Only download the index again if it changed since the last time
+        auto const cacheInfo = StringArray::fromLines(indexCacheInfo.loadFileAsString());
+        auto const hasCache = indexCache.existsAsFile() && cacheInfo.size() >= 2;
+
+        String headers;
+        if (hasCache && cacheInfo[0].isNotEmpty())
+            headers << "If-None-Match: " << cacheInfo[0] << "\r\n";
+        if (hasCache && cacheInfo[1].isNotEmpty())
+            headers << "If-Modified-Since: " << cacheInfo[1] << "\r\n";
+
         webstream = std::make_unique<WebInputStream>(URL(repoForArchitecture), false);
+        webstream->withExtraHeaders(headers);
         webstream->connect(nullptr);
 
-        if (webstream->isError()) {
+        MemoryBlock block;
+        auto const statusCode = webstream->getStatusCode();
+
+        if (!webstream->isError() && statusCode == 200) {
+            webstream->readIntoMemoryBlock(block);
+
+            auto const& responseHeaders = webstream->getResponseHeaders();
+            indexCache.getParentDirectory().createDirectory();
+            if (indexCache.replaceWithData(block.getData(), block.getSize())) {
+                indexCacheInfo.replaceWithText(responseHeaders["ETag"] + "\n" + responseHeaders["Last-Modified"] + "\n");
+            }
+        } else if (hasCache) {
+            // Either the index didn't change, or we're offline: in both cases the cached index is the best we have
+            indexCache.loadFileAsData(block);
+        } else {
             sendActionMessage("Failed to connect to server");
             return {};
         }
 
-        MemoryBlock block;
-        webstream->readIntoMemoryBlock(block);
-
         // Parse tree that was downloaded
         auto tree = ValueTree::readFromData(block.getData(), block.getSize());
 
@@ -366,6 +416,15 @@ public:
 
     std::unique_ptr<WebInputStream> webstream;
 
+    // The last package index we downloaded, together with its ETag and Last-Modified headers
+    static inline File const indexCache = ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("DekenIndex.bin");
+    static inline File const indexCacheInfo = ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("DekenIndex.info");
+
+    // Downloads that didn't finish, so they can be resumed
+    static inline File const downloadCache = filesystem.getChildFile(".downloads");
+
+    static constexpr int maxParallelDownloads = 3;
+
     static inline String const floatsize = String(PD_FLOATSIZE);
     static inline String const os =
 #if JUCE_LINUX
@@ -415,6 +474,9 @@ public:
     // continue downloading when the dialog closes
     // Inherits from deletedAtShutdown to handle cleaning up
     JUCE_DECLARE_SINGLETON(PackageManager, false)
+
+    // Declared last, so the downloads are cancelled before the rest of the manager is deleted
+    ThreadPool downloadPool = ThreadPool(maxParallelDownloads);
 };
 
 JUCE_IMPLEMENT_SINGLETON(PackageManager)
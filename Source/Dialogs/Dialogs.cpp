@@ -31,6 +31,7 @@
 #include "ObjectBrowserDialog.h"
 #include "ObjectReferenceDialog.h"
 #include "Heavy/HeavyExportDialog.h"
+#include "Heavy/HeavyCompiler.h"
 #include "MainMenu.h"
 #include "AddObjectMenu.h"
 #include "Canvas.h"
@@ -51,8 +52,7 @@ void Dialogs::appendTextToTextEditorDialog(Component* dialog, String const& text
     if (!dialog)
         return;
 
-    auto& editor = dynamic_cast<TextEditorDialog*>(dialog)->editor;
-    editor.setText(editor.getText() + text);
+    dynamic_cast<TextEditorDialog*>(dialog)->editor.appendText(text);
 }
 
 void Dialogs::showAskToSaveDialog(std::unique_ptr<Dialog>* target, Component* centre, String const& filename, std::function<void(int)> callback, int margin, bool withLogo)
@@ -482,7 +482,8 @@ void Dialogs::showCanvasRightClickMenu(Canvas* cnv, Component* originalComponent
         Forward,
         Backward,
         ToBack,
-        Properties
+        Properties,
+        CompileSubpatch
     };
     // Create popup menu
     PopupMenu popupMenu;
@@ -519,6 +520,9 @@ void Dialogs::showCanvasRightClickMenu(Canvas* cnv, Component* originalComponent
 
     popupMenu.addSeparator();
     addCommandItem(popupMenu, CommandIDs::Encapsulate);
+    if (getValue<bool>(editor->hvccMode)) {
+        popupMenu.addItem(CompileSubpatch, "Compile subpatch", !multiple && !locked && HeavyCompiler::canCompile(object.getComponent()));
+    }
     popupMenu.addSeparator();
 
     PopupMenu orderMenu;
@@ -651,6 +655,11 @@ void Dialogs::showCanvasRightClickMenu(Canvas* cnv, Component* originalComponent
         case Reference:
             Dialogs::showObjectReferenceDialog(&editor->openedDialog, editor, object->gui->getType());
             break;
+        case CompileSubpatch:
+            if (!editor->heavyCompiler)
+                editor->heavyCompiler = std::make_unique<HeavyCompiler>();
+            editor->heavyCompiler->compileSubpatch(cnv, object.getComponent());
+            break;
         default:
             break;
         }
@@ -57,7 +57,8 @@ public:
 };
 
 class StandaloneMIDISettings : public SettingsDialogPanel
-    , private ChangeListener {
+    , private ChangeListener
+    , private Value::Listener {
 public:
     StandaloneMIDISettings(PluginProcessor* audioProcessor, AudioDeviceManager& audioDeviceManager)
         : processor(audioProcessor)
@@ -65,6 +66,11 @@ public:
     {
         addAndMakeVisible(midiProperties);
 
+        synthWorkerThreadValue.referTo(processor->settingsFile->getPropertyAsValue("internal_synth_worker_thread"));
+        synthWorkerThreadValue.addListener(this);
+        synthVoicesValue.referTo(processor->settingsFile->getPropertyAsValue("internal_synth_voices"));
+        synthVoicesValue.addListener(this);
+
         deviceManager.addChangeListener(this);
         ProjectInfo::getMidiDeviceManager()->updateMidiDevices();
         updateDevices();
@@ -117,8 +123,22 @@ private:
 
         midiOutputProperties.add(new InternalSynthToggle(processor));
 
+        auto internalSynthProperties = Array<PropertiesPanelProperty*>();
+        internalSynthProperties.add(new PropertiesPanel::BoolComponent("Render on separate thread", synthWorkerThreadValue, { "No", "Yes" }));
+        internalSynthProperties.add(new PropertiesPanel::EditableComponent<int>("Maximum voices", synthVoicesValue, 1, 256));
+
         midiProperties.addSection("MIDI Inputs", midiInputProperties);
         midiProperties.addSection("MIDI Outputs", midiOutputProperties);
+        midiProperties.addSection("Internal GM Synth", internalSynthProperties);
+    }
+
+    void valueChanged(Value& v) override
+    {
+        if (v.refersToSameSourceAs(synthWorkerThreadValue)) {
+            processor->internalSynth->setRenderOnWorkerThread(getValue<bool>(synthWorkerThreadValue));
+        } else if (v.refersToSameSourceAs(synthVoicesValue)) {
+            processor->internalSynth->setMaxVoices(getValue<int>(synthVoicesValue));
+        }
     }
 
     void changeListenerCallback(ChangeBroadcaster*) override
@@ -129,4 +149,7 @@ private:
     PluginProcessor* processor;
     AudioDeviceManager& deviceManager;
     PropertiesPanel midiProperties;
+
+    Value synthWorkerThreadValue;
+    Value synthVoicesValue;
 };
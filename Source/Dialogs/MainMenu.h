@@ -8,6 +8,8 @@
 
 #include "PluginEditor.h"
 #include "Utility/Autosave.h"
+#include "Utility/Tracing.h"
+#include "Utility/MemoryReport.h"
 
 class MainMenu : public PopupMenu {
 
@@ -93,6 +95,33 @@ public:
 
         addCustomItem(getMenuItemID(MenuItem::FindExternals), std::unique_ptr<IconMenuItem>(menuItems[getMenuItemIndex(MenuItem::FindExternals)]), nullptr, "Find externals...");
 
+        // Records what the audio and message threads are doing, so we can find out what causes glitches
+        if (Tracing::isRecording()) {
+            addItem("Stop recording trace...", []() mutable {
+                static auto saveChooser = std::make_unique<FileChooser>("Choose save location", Tracing::getDefaultTraceFile(), "*.json", SettingsFile::getInstance()->wantsNativeDialog());
+
+                // Stop recording right away, so choosing a file doesn't end up in the trace
+                Tracing::setRecording(false);
+                saveChooser->launchAsync(FileBrowserComponent::saveMode | FileBrowserComponent::canSelectFiles, [](FileChooser const& f) {
+                    auto file = f.getResult();
+                    if (file.getParentDirectory().exists()) {
+                        Tracing::exportToFile(file);
+                    }
+                });
+            });
+        } else {
+            addItem("Record trace", []() {
+                Tracing::setRecording(true);
+            });
+        }
+
+        addItem("Memory report...", [editor]() {
+            static std::unique_ptr<Component> reportDialog;
+            reportDialog.reset(Dialogs::showTextEditorDialog(MemoryReport::create(editor), "Memory report", [](String const&, bool) {
+                reportDialog.reset(nullptr);
+            }));
+        });
+
         // addCustomItem(getMenuItemID(MenuItem::Discover), std::unique_ptr<IconMenuItem>(menuItems[getMenuItemIndex(MenuItem::Discover)]), nullptr, "Discover...");
 
         addCustomItem(getMenuItemID(MenuItem::Settings), std::unique_ptr<IconMenuItem>(menuItems[getMenuItemIndex(MenuItem::Settings)]), nullptr, "Settings...");
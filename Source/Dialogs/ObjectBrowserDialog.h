@@ -115,6 +115,10 @@ class ObjectsListBox : public ListBox
         {
             mouseHover = true;
             repaint();
+
+            // Only rows that we might drag need a preview, render it in the background while the mouse is on it
+            if (auto* offlineObjectRenderer = OfflineObjectRenderer::findParentOfflineObjectRendererFor(this))
+                prepareDragAndDropImage(offlineObjectRenderer);
         }
 
         void mouseExit(MouseEvent const& e) override
@@ -164,6 +168,10 @@ class ObjectsListBox : public ListBox
 
         void refresh(String name, String description, int rowNumber, bool isSelected)
         {
+            // The list box reuses this component for other rows when scrolling
+            if (name != objectName)
+                resetDragAndDropImage();
+
             objectName = name;
             objectDescription = description;
             row = rowNumber;
@@ -199,12 +207,7 @@ public:
         setColour(ListBox::backgroundColourId, Colours::transparentBlack);
         setColour(ListBox::outlineColourId, Colours::transparentBlack);
 
-        for (auto const& object : library.getAllObjects()) {
-            auto info = library.getObjectInfo(object);
-            if (info.hasProperty("name") && info.hasProperty("description")) {
-                descriptions[info.getProperty("name").toString()] = info.getProperty("description").toString();
-            }
-        }
+        browserIndex = library.getBrowserIndex();
     }
 
     int getNumRows() override
@@ -225,13 +228,13 @@ public:
     {
         if (existingComponentToUpdate == nullptr) {
             auto name = objects[rowNumber];
-            auto description = descriptions[name];
+            auto description = getDescription(name);
             return new ObjectListBoxItem(this, name, description, isRowSelected, dismiss);
         } else {
             auto* itemComponent = dynamic_cast<ObjectListBoxItem*>(existingComponentToUpdate);
             if (itemComponent != nullptr) {
                 auto name = objects[rowNumber];
-                auto description = descriptions[name];
+                auto description = getDescription(name);
                 itemComponent->refresh(name, description, rowNumber, isRowSelected);
             }
             return itemComponent;
@@ -247,7 +250,13 @@ public:
         selectRow(0, true, true);
     }
 
-    std::unordered_map<String, String> descriptions;
+    String getDescription(String const& name) const
+    {
+        auto it = browserIndex->descriptions.find(name);
+        return it != browserIndex->descriptions.end() ? it->second : String();
+    }
+
+    std::shared_ptr<pd::Library::BrowserIndex const> browserIndex;
     StringArray objects;
     std::function<void(String const&)> changeCallback;
 };
@@ -581,8 +590,9 @@ class ObjectSearchComponent : public Component
     , public KeyListener {
 
 public:
-    explicit ObjectSearchComponent(pd::Library& library)
+    explicit ObjectSearchComponent(pd::Library& objectLibrary)
         : bouncer(listBox.getViewport())
+        , library(objectLibrary)
     {
         listBox.setModel(this);
         listBox.setRowHeight(28);
@@ -612,14 +622,7 @@ public:
 
         setInterceptsMouseClicks(false, true);
 
-        for (auto& object : library.getAllObjects()) {
-            auto objectInfo = library.getObjectInfo(object);
-            if (objectInfo.isValid()) {
-                objectDescriptions[object] = objectInfo.getProperty("description").toString();
-            } else {
-                objectDescriptions[object] = "";
-            }
-        }
+        browserIndex = library.getBrowserIndex();
     }
 
     // Divert up/down key events from text editor to the listbox
@@ -684,7 +687,8 @@ public:
         if (textWidth > 0)
             Fonts::drawStyledText(g, item, leftIndent, yIndent, textWidth, h - yIndent * 2, colour, Semibold, 12, Justification::left);
 
-        auto objectDescription = objectDescriptions[item];
+        auto descriptionIter = browserIndex->descriptions.find(item);
+        auto objectDescription = descriptionIter != browserIndex->descriptions.end() ? descriptionIter->second : String();
 
         if (objectDescription.isNotEmpty()) {
             auto font = Font(12);
@@ -738,15 +742,8 @@ public:
         if (query.isEmpty())
             return;
 
-        for (auto& item : objectDescriptions) {
-            // Insert in front if the query matches a whole word
-            if (item.first.containsWholeWord(query) || item.second.containsWholeWord(query)) {
-                searchResult.insert(0, item.first);
-            }
-            // Insert in back if it contains the query
-            else if (item.first.containsIgnoreCase(query) || item.second.containsIgnoreCase(query)) {
-                searchResult.add(item.first);
-            }
+        for (auto const& object : library.searchObjects(query, maxSearchResults)) {
+            searchResult.add(object);
         }
 
         listBox.updateContent();
@@ -785,10 +782,14 @@ private:
     ListBox listBox;
     BouncingViewportAttachment bouncer;
 
+    pd::Library& library;
+
     Array<String> searchResult;
     SearchEditor input;
 
-    std::unordered_map<String, String> objectDescriptions;
+    std::shared_ptr<pd::Library::BrowserIndex const> browserIndex;
+
+    static constexpr int maxSearchResults = 500;
 };
 
 class ObjectBrowserDialog : public Component {
@@ -801,16 +802,8 @@ public:
         , objectViewer(editor, objectReference, [this](bool shouldFade) { dismiss(shouldFade); })
         , objectSearch(*editor->pd->objectLibrary)
     {
-        auto& library = *editor->pd->objectLibrary;
-
-        for (auto& object : library.getAllObjects()) {
-            auto categoriesTree = library.getObjectInfo(object).getChildWithName("categories");
-
-            for (auto category : categoriesTree) {
-                auto cat = category.getProperty("name").toString();
-                objectsByCategory[cat].add(object);
-            }
-        }
+        // Categories are sorted already, and "All" contains every object
+        objectsByCategory = editor->pd->objectLibrary->getBrowserIndex()->objectsByCategory;
 
         searchButton.setClickingTogglesState(true);
         searchButton.onClick = [this]() {
@@ -828,28 +821,13 @@ public:
         addAndMakeVisible(searchButton);
         addChildComponent(objectReference);
 
-        objectsByCategory["All"] = StringArray();
-
         StringArray categories;
         for (auto& [category, objects] : objectsByCategory) {
-            // Sort alphabetically
-            objects.sort(true);
-
-            // Add objects from every category to "All"
-            if (category != "All") {
-                objectsByCategory["All"].addArray(objects);
-            }
-
             if (!pd::Library::objectOrigins.contains(category))
                 categories.add(category);
         }
 
-        // Also include undocumented objects
-        objectsByCategory["All"].addArray(library.getAllObjects());
-        objectsByCategory["All"].removeDuplicates(true);
-
         // First sort alphabetically
-        objectsByCategory["All"].sort(true);
         categories.sort(true);
 
         // Make sure "All" is the first category
@@ -7,6 +7,7 @@
 #include "Constants.h"
 #include "PluginEditor.h"
 #include "LookAndFeel.h"
+#include "Components/DraggableNumber.h"
 
 class OverlayDisplaySettings : public Component {
 public:
@@ -113,6 +114,41 @@ public:
         }
     };
 
+    // Zoom level below which the canvas only draws object outlines and plain connections
+    class LevelOfDetailSelector : public Component {
+        Label textLabel;
+        DraggableNumber zoomThreshold = DraggableNumber(true);
+        Value levelOfDetailZoom;
+
+    public:
+        LevelOfDetailSelector()
+        {
+            levelOfDetailZoom.referTo(SettingsFile::getInstance()->getPropertyAsValue("level_of_detail_zoom"));
+
+            textLabel.setText("Simplify below", dontSendNotification);
+            textLabel.setTooltip("Below this zoom level (in %), objects are drawn as plain blocks, without text or iolets, and connections as plain lines. Set to 0 to always draw full detail");
+            textLabel.setFont(Font(14));
+            addAndMakeVisible(textLabel);
+
+            zoomThreshold.setMinMax(0, 100);
+            zoomThreshold.setEditableOnClick(true);
+            zoomThreshold.setValue(getValue<int>(levelOfDetailZoom), dontSendNotification);
+            zoomThreshold.onValueChange = [this](double newValue) {
+                levelOfDetailZoom = static_cast<int>(newValue);
+            };
+            addAndMakeVisible(zoomThreshold);
+
+            setSize(200, 30);
+        }
+
+        void resized() override
+        {
+            auto bounds = getLocalBounds().withTrimmedLeft(4);
+            textLabel.setBounds(bounds.removeFromLeft(getWidth() / 2));
+            zoomThreshold.setBounds(bounds.reduced(8, 4));
+        }
+    };
+
     OverlayDisplaySettings()
     {
         auto settingsTree = SettingsFile::getInstance()->getValueTree();
@@ -131,6 +167,11 @@ public:
         connectionLabel.setFont(Fonts::getSemiBoldFont().withHeight(14));
         addAndMakeVisible(connectionLabel);
 
+        levelOfDetailLabel.setText("Level of detail", dontSendNotification);
+        levelOfDetailLabel.setFont(Fonts::getSemiBoldFont().withHeight(14));
+        addAndMakeVisible(levelOfDetailLabel);
+        addAndMakeVisible(levelOfDetailSelector);
+
         buttonGroups.add(new OverlaySelector(overlayTree, Origin, "origin", "Origin", "0,0 point of canvas"));
         buttonGroups.add(new OverlaySelector(overlayTree, Border, "border", "Border", "Plugin / window workspace size"));
         buttonGroups.add(new OverlaySelector(overlayTree, Index, "index", "Index", "Object index in patch"));
@@ -169,6 +210,10 @@ public:
         connectionLabel.setBounds(bounds.removeFromTop(labelHeight));
         buttonGroups[OverlayDirection]->setBounds(bounds.removeFromTop(itemHeight));
         buttonGroups[OverlayOrder]->setBounds(bounds.removeFromTop(itemHeight));
+
+        bounds.removeFromTop(spacing);
+        levelOfDetailLabel.setBounds(bounds.removeFromTop(labelHeight));
+        levelOfDetailSelector.setBounds(bounds.removeFromTop(itemHeight));
         setSize(200, bounds.getY() + 5);
     }
 
@@ -178,13 +223,16 @@ public:
         auto secondPanelBounds = buttonGroups[OverlayIndex]->getBounds().getUnion(buttonGroups[OverlayActivationState]->getBounds());
         auto thirdPanelBounds = buttonGroups[OverlayDirection]->getBounds().getUnion(buttonGroups[OverlayOrder]->getBounds());
 
-        for (auto& bounds : std::vector<Rectangle<int>> { firstPanelBounds, secondPanelBounds, thirdPanelBounds }) {
+        for (auto& bounds : std::vector<Rectangle<int>> { firstPanelBounds, secondPanelBounds, thirdPanelBounds, levelOfDetailSelector.getBounds() }) {
             g.setColour(findColour(PlugDataColour::popupMenuBackgroundColourId).contrasting(0.035f));
             g.fillRoundedRectangle(bounds.toFloat(), Corners::largeCornerRadius);
 
             g.setColour(findColour(PlugDataColour::toolbarOutlineColourId));
             g.drawRoundedRectangle(bounds.toFloat(), Corners::largeCornerRadius, 1.0f);
-            g.drawHorizontalLine(bounds.getCentreY(), bounds.getX(), bounds.getRight());
+
+            // Panels with two rows get a separator in between
+            if (bounds.getHeight() > 30)
+                g.drawHorizontalLine(bounds.getCentreY(), bounds.getX(), bounds.getRight());
         }
     }
 
@@ -207,7 +255,8 @@ public:
 private:
     static inline bool isShowing = false;
 
-    Label canvasLabel, objectLabel, connectionLabel;
+    Label canvasLabel, objectLabel, connectionLabel, levelOfDetailLabel;
+    LevelOfDetailSelector levelOfDetailSelector;
 
     enum OverlayState {
         AllOff = 0,
@@ -84,7 +84,7 @@ public:
         panels.clear();
 
         if (auto* deviceManager = ProjectInfo::getDeviceManager()) {
-            panels.add(new StandaloneAudioSettings(*deviceManager));
+            panels.add(new StandaloneAudioSettings(processor, *deviceManager));
             panels.add(new StandaloneMIDISettings(processor, *deviceManager));
         } else {
             panels.add(new DAWAudioSettings(processor));
@@ -231,33 +231,66 @@ private:
 
 /**
  This class wraps a StringArray and memoizes the evaluation of glyph
- arrangements derived from the associated strings.
+ arrangements derived from the associated strings. Glyphs are only laid
+ out once a line is drawn or measured, and syntax tokens are kept per line,
+ so an edit only re-tokenises the lines it touched.
  */
 class GlyphArrangementArray {
 public:
     int size() const { return lines.size(); }
-    void clear() { lines.clear(); }
-    void add(String const& string) { lines.add(string); }
-    void insert(int index, String const& string) { lines.insert(index, string); }
-    void removeRange(int startIndex, int numberToRemove) { lines.removeRange(startIndex, numberToRemove); }
+    void clear()
+    {
+        lines.clear();
+        firstDirtyRow = 0;
+        lastDirtyRow = -1;
+    }
+    void add(String const& string)
+    {
+        lines.add(string);
+        markDirty(lines.size() - 1);
+    }
+    void insert(int index, String const& string);
+    void removeRange(int startIndex, int numberToRemove);
     String const& operator[](int index) const;
 
     int getToken(int row, int col, int defaultIfOutOfBounds) const;
-    void clearTokens(int index);
-    void applyTokens(int index, Selection zone);
     GlyphArrangement getGlyphs(int index,
         float baseline,
         int token,
         bool withTrailingSpace = false) const;
 
+    /** Return the width of a line, lines that haven't been laid out yet are estimated. */
+    float getWidth(int index) const;
+
+    /** Tokenise the given rows if they changed. The block comment state of the rows
+     above them may still be out of date, updateDirtyTokens() takes care of that.
+     */
+    void updateTokens(Range<int> rows);
+
+    /** Tokenise changed rows, starting from the first, until the deadline (in
+     milliseconds) is reached. Return true if there are rows left.
+     */
+    bool updateDirtyTokens(uint32 deadline);
+
 private:
     friend class TextDocument;
     friend class PlugDataTextEditor;
     Font font;
     bool cacheGlyphArrangement = true;
+    mutable float averageCharacterWidth = 0.f;
+
+    // Rows that may need to be tokenised again
+    int firstDirtyRow = 0;
+    int lastDirtyRow = -1;
 
     void ensureValid(int index) const;
     void invalidateAll();
+    void markDirty(int index);
+
+    /** Tokenise a single row if needed, return true if the next row starts
+     in a different block comment state because of it.
+     */
+    bool updateTokens(int index);
 
     struct Entry {
         Entry() = default;
@@ -269,8 +302,11 @@ private:
         GlyphArrangement glyphsWithTrailingSpace;
         GlyphArrangement glyphs;
         Array<int> tokens;
+        float width = 0.f;
         bool glyphsAreDirty = true;
         bool tokensAreDirty = true;
+        bool startsInComment = false;
+        bool endsInComment = false;
     };
     mutable Array<Entry> lines;
 };
@@ -378,6 +414,9 @@ public:
     /** Replace the whole document content. */
     void replaceAll(String const& content);
 
+    /** Add content to the end of the document, without touching the existing rows. */
+    void append(String const& content);
+
     /** Replace the list of selections with a new one. */
     void setSelections(Array<Selection> const& newSelections) { selections = newSelections; }
 
@@ -504,11 +543,11 @@ public:
      */
     Transaction fulfill(Transaction const& transaction);
 
-    /* Reset glyph token values on the given range of rows. */
-    void clearTokens(Range<int> rows);
+    /** Tokenise the given rows if they changed since they were last tokenised. */
+    void updateTokens(Range<int> rows) { lines.updateTokens(rows); }
 
-    /** Apply tokens from a set of zones to a range of rows. */
-    void applyTokens(Range<int> rows, Array<Selection> const& zones);
+    /** Tokenise changed rows in the background, see GlyphArrangementArray::updateDirtyTokens(). */
+    bool updateDirtyTokens(uint32 deadline) { return lines.updateDirtyTokens(deadline); }
 
 private:
     friend class PlugDataTextEditor;
@@ -571,7 +610,8 @@ private:
     Path outlinePath;
 };
 
-class PlugDataTextEditor : public Component {
+class PlugDataTextEditor : public Component
+    , private Timer {
 public:
     enum class RenderScheme {
         usingAttributedStringSingle,
@@ -584,6 +624,7 @@ public:
     void setFont(Font const& font);
 
     void setText(String const& text);
+    void appendText(String const& text);
     String getText() const;
 
     void translateView(float dx, float dy);
@@ -608,6 +649,8 @@ private:
     void updateViewTransform();
     void updateSelections();
     void translateToEnsureCaretIsVisible();
+    void timerCallback() override;
+    void appendHighlightedRow(AttributedString& s, int row, Font const& font, CodeEditorComponent::ColourScheme const& colourScheme) const;
 
     void renderTextUsingAttributedStringSingle(Graphics& g);
     void renderTextUsingAttributedString(Graphics& g);
@@ -993,43 +1036,147 @@ String const& GlyphArrangementArray::operator[](int index) const
     return empty;
 }
 
-int GlyphArrangementArray::getToken(int row, int col, int defaultIfOutOfBounds) const
+void GlyphArrangementArray::insert(int index, String const& string)
 {
-    if (!isPositiveAndBelow(row, lines.size())) {
-        return defaultIfOutOfBounds;
+    lines.insert(index, string);
+
+    // Rows below move down, together with their dirty state
+    if (firstDirtyRow <= lastDirtyRow) {
+        if (index <= firstDirtyRow)
+            firstDirtyRow++;
+        if (index <= lastDirtyRow)
+            lastDirtyRow++;
     }
-    return lines.getReference(row).tokens[col];
+
+    markDirty(index);
 }
 
-void GlyphArrangementArray::clearTokens(int index)
+void GlyphArrangementArray::removeRange(int startIndex, int numberToRemove)
 {
-    if (!isPositiveAndBelow(index, lines.size()))
-        return;
+    lines.removeRange(startIndex, numberToRemove);
 
-    auto& entry = lines.getReference(index);
+    // Rows below the removed ones move up, together with their dirty state. Dirty rows that were removed end up at the start of the range
+    if (firstDirtyRow <= lastDirtyRow) {
+        auto const shiftRow = [startIndex, numberToRemove](int row) {
+            return row >= startIndex + numberToRemove ? row - numberToRemove : std::min(row, startIndex);
+        };
+        firstDirtyRow = shiftRow(firstDirtyRow);
+        lastDirtyRow = shiftRow(lastDirtyRow);
+    }
 
-    ensureValid(index);
+    // The row that moved up could now start in a different comment state
+    if (startIndex < lines.size())
+        markDirty(startIndex);
+}
 
-    for (int col = 0; col < entry.tokens.size(); ++col) {
-        entry.tokens.setUnchecked(col, 0);
+void GlyphArrangementArray::markDirty(int index)
+{
+    if (lastDirtyRow < firstDirtyRow) {
+        firstDirtyRow = lastDirtyRow = index;
+    } else {
+        firstDirtyRow = std::min(firstDirtyRow, index);
+        lastDirtyRow = std::max(lastDirtyRow, index);
     }
 }
 
-void GlyphArrangementArray::applyTokens(int index, Selection zone)
+float GlyphArrangementArray::getWidth(int index) const
 {
     if (!isPositiveAndBelow(index, lines.size()))
-        return;
+        return 0.f;
+
+    auto const& entry = lines.getReference(index);
+    if (!entry.glyphsAreDirty)
+        return entry.width;
+
+    if (averageCharacterWidth == 0.f)
+        averageCharacterWidth = font.getStringWidthFloat("abcdefghijklmnopqrstuvwxyz") / 26.f;
 
+    return (entry.string.length() + 1) * averageCharacterWidth;
+}
+
+bool GlyphArrangementArray::updateTokens(int index)
+{
     auto& entry = lines.getReference(index);
-    auto range = zone.getColumnRangeOnRow(index, entry.tokens.size());
+    auto const startsInComment = index > 0 && lines.getReference(index - 1).endsInComment;
 
-    ensureValid(index);
+    if (!entry.tokensAreDirty && entry.startsInComment == startsInComment)
+        return false;
 
-    for (int col = range.getStart(); col < range.getEnd(); ++col) {
-        entry.tokens.setUnchecked(col, zone.token);
+    auto const& line = entry.string;
+    auto const wasInComment = entry.endsInComment;
+    int col = 0;
+
+    auto fill = [&entry, &col](int end, int token) {
+        while (col < end)
+            entry.tokens.setUnchecked(col++, token);
+    };
+
+    entry.tokens.resize(line.length());
+    entry.startsInComment = startsInComment;
+    entry.tokensAreDirty = false;
+    entry.endsInComment = false;
+
+    if (startsInComment) {
+        auto const commentEnd = line.indexOf("*/");
+        if (commentEnd < 0) {
+            fill(line.length(), CPlusPlusCodeTokeniser::tokenType_comment);
+            entry.endsInComment = true;
+            return !wasInComment;
+        }
+        fill(commentEnd + 2, CPlusPlusCodeTokeniser::tokenType_comment);
+    }
+
+    CppTokeniserFunctions::StringIterator si(line.getCharPointer() + col);
+    auto const offset = col;
+
+    while (!si.isEOF()) {
+        auto const tokenStart = col;
+        auto const tokenType = CppTokeniserFunctions::readNextToken(si);
+        fill(offset + si.numChars, tokenType);
+
+        // A block comment that isn't closed on this line continues on the next one
+        if (si.isEOF() && tokenType == CPlusPlusCodeTokeniser::tokenType_comment) {
+            auto const comment = line.substring(tokenStart);
+            entry.endsInComment = comment.startsWith("/*") && (comment.length() < 4 || !comment.endsWith("*/"));
+        }
+    }
+
+    return entry.endsInComment != wasInComment;
+}
+
+void GlyphArrangementArray::updateTokens(Range<int> rows)
+{
+    for (int n = std::max(rows.getStart(), 0); n < std::min(rows.getEnd(), lines.size()); ++n) {
+        updateTokens(n);
     }
 }
 
+bool GlyphArrangementArray::updateDirtyTokens(uint32 deadline)
+{
+    lastDirtyRow = std::min(lastDirtyRow, lines.size() - 1);
+
+    while (firstDirtyRow <= lastDirtyRow) {
+        // Opening or closing a block comment changes the rows below, until the state matches again
+        if (updateTokens(firstDirtyRow) && firstDirtyRow == lastDirtyRow && firstDirtyRow + 1 < lines.size())
+            lastDirtyRow++;
+
+        firstDirtyRow++;
+
+        if ((firstDirtyRow & 63) == 0 && Time::getMillisecondCounter() >= deadline)
+            break;
+    }
+
+    return firstDirtyRow <= lastDirtyRow;
+}
+
+int GlyphArrangementArray::getToken(int row, int col, int defaultIfOutOfBounds) const
+{
+    if (!isPositiveAndBelow(row, lines.size())) {
+        return defaultIfOutOfBounds;
+    }
+    return lines.getReference(row).tokens[col];
+}
+
 GlyphArrangement GlyphArrangementArray::getGlyphs(int index,
     float baseline,
     int token,
@@ -1070,6 +1217,7 @@ void GlyphArrangementArray::ensureValid(int index) const
         entry.tokens.resize(entry.string.length());
         entry.glyphs.addLineOfText(font, entry.string, 0.f, 0.f);
         entry.glyphsWithTrailingSpace.addLineOfText(font, entry.string + " ", 0.f, 0.f);
+        entry.width = entry.glyphsWithTrailingSpace.getBoundingBox(0, -1, true).getWidth();
         entry.glyphsAreDirty = !cacheGlyphArrangement;
     }
 }
@@ -1080,10 +1228,15 @@ void GlyphArrangementArray::invalidateAll()
         entry.glyphsAreDirty = true;
         entry.tokensAreDirty = true;
     }
+
+    averageCharacterWidth = 0.f;
+    firstDirtyRow = 0;
+    lastDirtyRow = lines.size() - 1;
 }
 
 void TextDocument::replaceAll(String const& content)
 {
+    cachedBounds = {};
     lines.clear();
 
     for (auto const& line : StringArray::fromLines(content)) {
@@ -1091,6 +1244,27 @@ void TextDocument::replaceAll(String const& content)
     }
 }
 
+void TextDocument::append(String const& content)
+{
+    cachedBounds = {};
+
+    auto newLines = StringArray::fromLines(content);
+    if (newLines.isEmpty())
+        return;
+
+    // The first new line continues the last row
+    if (auto lastRow = lines.size() - 1; lastRow >= 0) {
+        auto joined = lines[lastRow] + newLines[0];
+        lines.removeRange(lastRow, 1);
+        lines.insert(lastRow, joined);
+        newLines.remove(0);
+    }
+
+    for (auto const& line : newLines) {
+        lines.add(line);
+    }
+}
+
 StringArray TextDocument::getText() const
 {
     StringArray text;
@@ -1172,12 +1346,12 @@ Array<Rectangle<float>> TextDocument::getSelectionRegion(Selection selection, Re
 Rectangle<float> TextDocument::getBounds() const
 {
     if (cachedBounds.isEmpty()) {
-        auto bounds = Rectangle<float>();
-
+        // Doesn't lay out the glyphs of lines that were never drawn, so large documents open quickly
+        auto width = 0.f;
         for (int n = 0; n < getNumRows(); ++n) {
-            bounds = bounds.getUnion(getBoundsOnRow(n, Range<int>(0, std::max(1, getNumColumns(n)))));
+            width = std::max(width, lines.getWidth(n));
         }
-        return cachedBounds = bounds;
+        return cachedBounds = Rectangle<float>(TEXT_INDENT, 0.f, width, getHeight());
     }
     return cachedBounds;
 }
@@ -1503,24 +1677,6 @@ Transaction TextDocument::fulfill(Transaction const& transaction)
     return r;
 }
 
-void TextDocument::clearTokens(Range<int> rows)
-{
-    for (int n = rows.getStart(); n < rows.getEnd(); ++n) {
-        lines.clearTokens(n);
-    }
-}
-
-void TextDocument::applyTokens(Range<int> rows, Array<Selection> const& zones)
-{
-    for (int n = rows.getStart(); n < rows.getEnd(); ++n) {
-        for (auto const& zone : zones) {
-            if (zone.intersectsRow(n)) {
-                lines.applyTokens(n, zone);
-            }
-        }
-    }
-}
-
 class Transaction::Undoable : public UndoableAction {
 public:
     Undoable(TextDocument& document, Callback callback, Transaction forward)
@@ -1603,12 +1759,32 @@ void PlugDataTextEditor::paintOverChildren(Graphics& g)
 void PlugDataTextEditor::setFont(Font const& font)
 {
     document.setFont(font);
+    document.lines.invalidateAll();
     repaint();
 }
 
 void PlugDataTextEditor::setText(String const& text)
 {
     document.replaceAll(text);
+    if (enableSyntaxHighlighting)
+        startTimerHz(60);
+    repaint();
+}
+
+void PlugDataTextEditor::appendText(String const& text)
+{
+    document.append(text);
+    if (enableSyntaxHighlighting)
+        startTimerHz(60);
+    repaint();
+}
+
+void PlugDataTextEditor::timerCallback()
+{
+    // Re-highlight the rest of the document in small steps, so typing stays responsive
+    if (!document.updateDirtyTokens(Time::getMillisecondCounter() + 5))
+        stopTimer();
+
     repaint();
 }
 
@@ -1932,6 +2108,9 @@ bool PlugDataTextEditor::insert(String const& content)
     updateSelections();
     changed = true;
 
+    if (enableSyntaxHighlighting)
+        startTimerHz(60);
+
     return true;
 }
 
@@ -1940,6 +2119,22 @@ MouseCursor PlugDataTextEditor::getMouseCursor()
     return getMouseXYRelative().x < GUTTER_WIDTH ? MouseCursor::NormalCursor : MouseCursor::IBeamCursor;
 }
 
+void PlugDataTextEditor::appendHighlightedRow(AttributedString& s, int row, Font const& font, CodeEditorComponent::ColourScheme const& colourScheme) const
+{
+    auto const& line = document.getLine(row);
+
+    // Adds runs of characters with the same token in one go
+    int start = 0;
+    for (int col = 1; col <= line.length(); ++col) {
+        auto token = document.lines.getToken(row, start, 0);
+        if (col < line.length() && document.lines.getToken(row, col, 0) == token)
+            continue;
+
+        s.append(line.substring(start, col), font, colourScheme.types[token].colour);
+        start = col;
+    }
+}
+
 void PlugDataTextEditor::renderTextUsingAttributedStringSingle(Graphics& g)
 {
     g.saveState();
@@ -1952,21 +2147,18 @@ void PlugDataTextEditor::renderTextUsingAttributedStringSingle(Graphics& g)
     auto B = document.getVerticalPosition(rows.getEnd(), TextDocument::Metric::top);
     auto W = 10000;
     auto bounds = Rectangle<float>::leftTopRightBottom(TEXT_INDENT, T, W, B);
-    auto content = document.getSelectionContent(Selection(rows.getStart(), 0, rows.getEnd(), 0));
 
     AttributedString s;
     s.setLineSpacing((document.getLineSpacing() - 1.f) * font.getHeight());
 
-    CppTokeniserFunctions::StringIterator si(content);
-    auto previous = si.t;
-
-    while (!si.isEOF()) {
-        auto tokenType = CppTokeniserFunctions::readNextToken(si);
-        auto colour = enableSyntaxHighlighting ? colourScheme.types[tokenType].colour : findColour(PlugDataColour::panelTextColourId);
-        auto token = String(previous, si.t);
-
-        previous = si.t;
-        s.append(token, font, colour);
+    if (!enableSyntaxHighlighting) {
+        s.append(document.getSelectionContent(Selection(rows.getStart(), 0, rows.getEnd(), 0)), font, findColour(PlugDataColour::panelTextColourId));
+    } else {
+        document.updateTokens(rows);
+        for (int row = rows.getStart(); row < rows.getEnd(); ++row) {
+            appendHighlightedRow(s, row, font, colourScheme);
+            s.append("\n", font);
+        }
     }
 
     if (allowCoreGraphics) {
@@ -2002,17 +2194,8 @@ void PlugDataTextEditor::renderTextUsingAttributedString(Graphics& g)
         if (!enableSyntaxHighlighting) {
             s.append(line, font);
         } else {
-            CppTokeniserFunctions::StringIterator si(line);
-            auto previous = si.t;
-
-            while (!si.isEOF()) {
-                auto tokenType = CppTokeniserFunctions::readNextToken(si);
-                auto colour = enableSyntaxHighlighting ? colourScheme.types[tokenType].colour : findColour(PlugDataColour::panelTextColourId);
-                auto token = String(previous, si.t);
-
-                previous = si.t;
-                s.append(token, font, colour);
-            }
+            document.updateTokens({ r.rowNumber, r.rowNumber + 1 });
+            appendHighlightedRow(s, r.rowNumber, font, colourScheme);
         }
         if (allowCoreGraphics) {
             s.draw(g, bounds);
@@ -2031,21 +2214,7 @@ void PlugDataTextEditor::renderTextUsingGlyphArrangement(Graphics& g)
 
     if (enableSyntaxHighlighting) {
         auto colourScheme = CPlusPlusCodeTokeniser().getDefaultColourScheme();
-        auto rows = document.getRangeOfRowsIntersecting(g.getClipBounds().toFloat());
-        auto index = Point<int>(rows.getStart(), 0);
-        document.navigate(index, TextDocument::Target::token, TextDocument::Direction::backwardRow);
-
-        auto it = TextDocument::Iterator(document, index);
-        auto previous = it.getIndex();
-        auto zones = Array<Selection>();
-
-        while (it.getIndex().x < rows.getEnd() && !it.isEOF()) {
-            auto tokenType = CppTokeniserFunctions::readNextToken(it);
-            zones.add(Selection(previous, it.getIndex()).withStyle(tokenType));
-            previous = it.getIndex();
-        }
-        document.clearTokens(rows);
-        document.applyTokens(rows, zones);
+        document.updateTokens(document.getRangeOfRowsIntersecting(g.getClipBounds().toFloat()));
 
         for (int n = 0; n < colourScheme.types.size(); ++n) {
             g.setColour(colourScheme.types[n].colour);
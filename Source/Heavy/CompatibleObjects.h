@@ -6,6 +6,28 @@
 
 #pragma once
 
+// Rough estimate of what a patch costs once it's compiled with Heavy
+// Heavy preallocates all delay lines and tables, so those make up most of the memory
+struct HeavyFootprint {
+    int numObjects = 0;
+    int numIncompatible = 0;
+    int numSignalObjects = 0;
+    int64 memoryBytes = 0;
+
+    // Approximate size of the state Heavy generates for a single object
+    static constexpr int64 bytesPerObject = 64;
+    static constexpr double estimatedSampleRate = 48000.0;
+
+    HeavyFootprint& operator+=(HeavyFootprint const& other)
+    {
+        numObjects += other.numObjects;
+        numIncompatible += other.numIncompatible;
+        numSignalObjects += other.numSignalObjects;
+        memoryBytes += other.memoryBytes;
+        return *this;
+    }
+};
+
 struct HeavyCompatibleObjects {
     static inline StringArray const heavyObjects = {
         "!=",
@@ -230,4 +252,17 @@ struct HeavyCompatibleObjects {
 
         return allObjects;
     }
+
+    // Lookup by hash, since this is checked for every object in a patch whenever compiled mode is on
+    static bool isCompatible(String const& type)
+    {
+        static std::unordered_set<hash32> const compatibleHashes = [] {
+            std::unordered_set<hash32> hashes;
+            for (auto const& name : getAllCompatibleObjects())
+                hashes.insert(hash(name));
+            return hashes;
+        }();
+
+        return compatibleHashes.contains(hash(type));
+    }
 };
@@ -54,10 +54,7 @@ public:
         if (shouldQuit)
             return true;
 
-        start(args.joinIntoString(" "));
-
-        waitForProcessToFinish(-1);
-        exportingView->flushConsole();
+        auto const heavyExitCode = runHeavy(args, outdir, searchPaths);
 
         if (shouldQuit)
             return true;
@@ -66,9 +63,6 @@ public:
         outputFile.getChildFile("ir").deleteRecursively();
         outputFile.getChildFile("hv").deleteRecursively();
 
-        // Delay to get correct exit code
-        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
-
-        return getExitCode();
+        return heavyExitCode;
     }
 };
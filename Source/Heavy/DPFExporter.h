@@ -17,6 +17,7 @@ public:
 
     Value exportTypeValue = Value(var(2));
     Value pluginTypeValue = Value(var(1));
+    Value parallelSectionsValue = Value(var(0));
 
     PropertiesPanelProperty* midiinProperty;
     PropertiesPanelProperty* midioutProperty;
@@ -32,6 +33,7 @@ public:
         properties.add(midiinProperty);
         midioutProperty = new PropertiesPanel::BoolComponent("Midi Output", midioutEnableValue, { "No", "yes" });
         properties.add(midioutProperty);
+        properties.add(new PropertiesPanel::BoolComponent("Run [pd @hv_parallel] on separate cores", parallelSectionsValue, { "No", "Yes" }));
 
         Array<PropertiesPanelProperty*> pluginFormats;
 
@@ -76,6 +78,7 @@ public:
         stateTree.setProperty("jackEnableValue", getValue<int>(jackEnableValue), nullptr);
         stateTree.setProperty("exportTypeValue", getValue<int>(exportTypeValue), nullptr);
         stateTree.setProperty("pluginTypeValue", getValue<int>(pluginTypeValue), nullptr);
+        stateTree.setProperty("parallelSectionsValue", getValue<int>(parallelSectionsValue), nullptr);
 
         return stateTree;
     }
@@ -95,6 +98,7 @@ public:
         jackEnableValue = tree.getProperty("jackEnableValue");
         exportTypeValue = tree.getProperty("exportTypeValue");
         pluginTypeValue = tree.getProperty("pluginTypeValue");
+        parallelSectionsValue = tree.getProperty("parallelSectionsValue");
     }
 
     void valueChanged(Value& v) override
@@ -118,9 +122,46 @@ public:
     {
         exportingView->showState(ExportingProgressView::Busy);
 
+        auto outputFile = File(outdir);
+        name = name.replaceCharacter('-', '_');
+
+        // Subpatches marked with @hv_parallel are compiled into their own Heavy contexts, which the plugin runs on separate threads
+        Array<ParallelSection> parallelSections;
+        if (getValue<bool>(parallelSectionsValue)) {
+            String error;
+            auto const mainPatch = splitParallelSections(File(pdPatch).loadFileAsString(), parallelSections, error);
+            if (error.isNotEmpty()) {
+                exportingView->logToConsole(error + "\n");
+                return true;
+            }
+
+            if (!parallelSections.isEmpty()) {
+                // Don't touch the original patch, it might be the user's own file
+                auto const parallelDir = outputFile.getChildFile("parallel");
+                parallelDir.createDirectory();
+                auto const mainPatchFile = parallelDir.getChildFile(name + ".pd");
+                mainPatchFile.replaceWithText(mainPatch, false, false, "\n");
+                pdPatch = mainPatchFile.getFullPathName();
+
+                String paths = "-p";
+                for (auto& path : searchPaths) {
+                    paths += " " + path;
+                }
+
+                for (auto const& section : parallelSections) {
+                    auto const sectionDir = parallelDir.getChildFile(section.name);
+                    auto const sectionPatchFile = parallelDir.getChildFile(section.name + ".pd");
+                    sectionPatchFile.replaceWithText(section.patch, false, false, "\n");
+
+                    exportingView->logToConsole("Generating parallel section " + section.name + "...\n");
+                    if (runHeavy(StringArray { heavyExecutable.getFullPathName(), sectionPatchFile.getFullPathName(), "-o" + sectionDir.getFullPathName(), "-n" + section.name, paths }, sectionDir.getFullPathName(), searchPaths) || shouldQuit)
+                        return true;
+                }
+            }
+        }
+
         StringArray args = { heavyExecutable.getFullPathName(), pdPatch, "-o" + outdir };
 
-        name = name.replaceCharacter('-', '_');
         args.add("-n" + name);
 
         if (copyright.isNotEmpty()) {
@@ -183,28 +224,29 @@ public:
         if (shouldQuit)
             return true;
 
-        start(args.joinIntoString(" "));
-
-        waitForProcessToFinish(-1);
-        exportingView->flushConsole();
+        auto const heavyExitCode = runHeavy(args, outdir, searchPaths);
 
         if (shouldQuit)
             return true;
 
-        auto outputFile = File(outdir);
+        if (!heavyExitCode && !parallelSections.isEmpty() && !addParallelSections(outputFile, parallelSections)) {
+            exportingView->logToConsole("Couldn't add the parallel sections to the generated DPF plugin\n");
+            return true;
+        }
+
         outputFile.getChildFile("ir").deleteRecursively();
         outputFile.getChildFile("hv").deleteRecursively();
         outputFile.getChildFile("c").deleteRecursively();
 
+        // Keeps the modification times, so the DPF sources aren't rebuilt with every export
         auto DPF = Toolchain::dir.getChildFile("lib").getChildFile("dpf");
-        DPF.copyDirectoryTo(outputFile.getChildFile("dpf"));
+        syncDirectory(DPF, outputFile.getChildFile("dpf"));
 
-        // Delay to get correct exit code
-        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
-
-        bool generationExitCode = getExitCode();
+        bool generationExitCode = heavyExitCode;
         // Check if we need to compile
         if (!generationExitCode && getValue<int>(exportTypeValue) == 2) {
+            restoreObjectFiles(outputFile);
+
             auto workingDir = File::getCurrentWorkingDirectory();
 
             outputFile.setAsCurrentWorkingDirectory();
@@ -214,20 +256,20 @@ public:
             auto makefile = outputFile.getChildFile("Makefile");
 
 #if JUCE_MAC
-            Toolchain::startShellScript("make -j4 -f " + makefile.getFullPathName(), this);
+            Toolchain::startShellScript("make" + Toolchain::getParallelJobsArgument() + " -f " + makefile.getFullPathName(), this);
 #elif JUCE_WINDOWS
             auto path = "export PATH=\"$PATH:" + Toolchain::dir.getChildFile("bin").getFullPathName().replaceCharacter('\\', '/') + "\"\n";
             auto cc = "CC=" + Toolchain::dir.getChildFile("bin").getChildFile("gcc.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
             auto cxx = "CXX=" + Toolchain::dir.getChildFile("bin").getChildFile("g++.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
 
-            Toolchain::startShellScript(path + cc + cxx + make.getFullPathName().replaceCharacter('\\', '/') + " -j4 -f " + makefile.getFullPathName().replaceCharacter('\\', '/'), this);
+            Toolchain::startShellScript(path + cc + cxx + make.getFullPathName().replaceCharacter('\\', '/') + Toolchain::getParallelJobsArgument() + " -f " + makefile.getFullPathName().replaceCharacter('\\', '/'), this);
 
 #else // Linux or BSD
             auto prepareEnvironmentScript = Toolchain::dir.getChildFile("scripts").getChildFile("anywhere-setup.sh").getFullPathName() + "\n";
 
             auto buildScript = prepareEnvironmentScript
                 + make.getFullPathName()
-                + " -j4 -f " + makefile.getFullPathName();
+                + Toolchain::getParallelJobsArgument() + " -f " + makefile.getFullPathName();
 
             // For some reason we need to do this again
             outputFile.getChildFile("dpf").getChildFile("utils").getChildFile("generate-ttl.sh").setExecutePermission(true);
@@ -244,6 +286,8 @@ public:
 
             workingDir.setAsCurrentWorkingDirectory();
 
+            storeObjectFiles(outputFile);
+
             // Copy output
             if (lv2)
                 outputFile.getChildFile("bin").getChildFile(name + ".lv2").copyDirectoryTo(outputFile.getChildFile(name + ".lv2"));
@@ -272,6 +316,7 @@ public:
                 outputFile.getChildFile("build").deleteRecursively();
                 outputFile.getChildFile("plugin").deleteRecursively();
                 outputFile.getChildFile("bin").deleteRecursively();
+                outputFile.getChildFile("parallel").deleteRecursively();
                 outputFile.getChildFile("README.md").deleteFile();
                 outputFile.getChildFile("Makefile").deleteFile();
             }
@@ -281,4 +326,278 @@ public:
 
         return generationExitCode;
     }
+
+private:
+    struct ParallelSection {
+        String name;
+        String patch;
+    };
+
+    // Moves toplevel [pd @hv_parallel name] subpatches into patches of their own
+    // They're replaced by empty subpatches, so the indices of the other objects (and thus the connections) stay the same
+    static String splitParallelSections(String const& patchText, Array<ParallelSection>& sections, String& error)
+    {
+        // pd ends every message with an unescaped semicolon, messages can contain newlines
+        StringArray messages;
+        {
+            auto const text = patchText.toStdString();
+            size_t messageStart = 0;
+            for (size_t i = 0; i < text.size(); i++) {
+                if (text[i] == ';' && (i == 0 || text[i - 1] != '\\')) {
+                    messages.add(String(text.substr(messageStart, i - messageStart)).trim());
+                    messageStart = i + 1;
+                }
+            }
+        }
+
+        auto getTokens = [&messages](int index) {
+            auto tokens = StringArray::fromTokens(messages[index].replaceCharacters("\r\n", "  "), " ", "");
+            tokens.removeEmptyStrings();
+            return tokens;
+        };
+
+        std::vector<std::pair<int, int>> ranges;
+        std::vector<int> openCanvases;
+        for (int i = 0; i < messages.size(); i++) {
+            auto const tokens = getTokens(i);
+            if (tokens[0] == "#N" && tokens[1] == "canvas") {
+                openCanvases.push_back(i);
+            } else if (tokens[0] == "#X" && tokens[1] == "restore" && !openCanvases.empty()) {
+                auto const start = openCanvases.back();
+                openCanvases.pop_back();
+                if (openCanvases.size() == 1 && tokens[4] == "pd" && tokens[5] == "@hv_parallel")
+                    ranges.emplace_back(start, i);
+            }
+        }
+
+        for (auto const& [start, end] : ranges) {
+            auto const restoreTokens = getTokens(end);
+            auto name = String("parallel_") + String(sections.size());
+            if (restoreTokens.size() > 6)
+                name += "_" + restoreTokens[6].retainCharacters("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
+
+            String sectionPatch = "#N canvas 0 50 450 300 12;\n";
+            int depth = 0;
+            for (int i = start + 1; i < end; i++) {
+                auto const tokens = getTokens(i);
+                if (tokens[0] == "#N" && tokens[1] == "canvas") {
+                    depth++;
+                } else if (tokens[0] == "#X" && tokens[1] == "restore") {
+                    depth--;
+                } else if (depth == 0 && tokens[0] == "#X" && tokens[1] == "obj" && (tokens[4].startsWith("inlet") || tokens[4].startsWith("outlet"))) {
+                    error = "Parallel section " + name + " can't have inlets or outlets, use adc~ and dac~ instead";
+                    return {};
+                }
+                sectionPatch += messages[i] + ";\n";
+            }
+
+            sections.add({ name, sectionPatch });
+        }
+
+        String mainPatch;
+        size_t rangeIndex = 0;
+        for (int i = 0; i < messages.size(); i++) {
+            while (rangeIndex < ranges.size() && i > ranges[rangeIndex].second)
+                rangeIndex++;
+
+            auto const isInsideSection = rangeIndex < ranges.size() && i > ranges[rangeIndex].first && i < ranges[rangeIndex].second;
+            if (!isInsideSection && messages[i].isNotEmpty())
+                mainPatch += messages[i] + ";\n";
+        }
+
+        return mainPatch;
+    }
+
+    // Adds the parallel sections to the plugin source that hvcc generated for the main patch
+    static bool addParallelSections(File const& outputDir, Array<ParallelSection> const& sections)
+    {
+        auto sources = outputDir.getChildFile("plugin").findChildFiles(File::findFiles, true, "HeavyDPF_*.cpp");
+        if (sources.isEmpty())
+            return false;
+
+        auto const source = sources.getFirst();
+        auto const header = source.withFileExtension(".hpp");
+
+        auto sourceLines = StringArray::fromLines(source.loadFileAsString());
+        auto headerLines = StringArray::fromLines(header.loadFileAsString());
+
+        int processLine = -1, contextLine = -1, includeLine = -1;
+        for (int i = 0; i < sourceLines.size() && processLine < 0; i++) {
+            if (sourceLines[i].contains("_context->process("))
+                processLine = i;
+        }
+        for (int i = 0; i < headerLines.size(); i++) {
+            if (includeLine < 0 && headerLines[i].trim().startsWith("#include"))
+                includeLine = i;
+            if (contextLine < 0 && headerLines[i].contains("HeavyContextInterface") && headerLines[i].contains("_context;"))
+                contextLine = i;
+        }
+
+        // The sections are created in activate() and deleted in deactivate(), so the generated plugin can't already have those
+        auto const headerText = headerLines.joinIntoString("\n");
+        if (processLine < 0 || contextLine < 0 || includeLine < 0 || headerText.contains(" activate(") || headerText.contains(" deactivate("))
+            return false;
+
+        auto const indentation = sourceLines[processLine].initialSectionContainingOnly(" \t");
+        sourceLines.insert(processLine + 1, indentation + "_parallelSections.finish(outputs, frames);");
+        sourceLines.insert(processLine, indentation + "_parallelSections.start(inputs, frames);");
+
+        // DPF deactivates the plugin before the sample rate or the buffer size changes, and activates it again after
+        auto const memberIndentation = headerLines[contextLine].initialSectionContainingOnly(" \t");
+        headerLines.insert(contextLine + 1, memberIndentation + "void deactivate() override { _parallelSections.stop(); }");
+        headerLines.insert(contextLine + 1, memberIndentation + "void activate() override { _parallelSections.prepare(getSampleRate(), getBufferSize()); }");
+        headerLines.insert(contextLine + 1, memberIndentation + "ParallelSections _parallelSections;");
+        headerLines.insert(includeLine + 1, "#include \"ParallelSections.hpp\"");
+
+        String includes, workers;
+        for (auto const& section : sections) {
+            auto const sectionSource = outputDir.getChildFile("parallel").getChildFile(section.name).getChildFile("c").getChildFile("Heavy_" + section.name + ".cpp");
+            includes << "#include \"" << sectionSource.getRelativePathFrom(source.getParentDirectory()).replaceCharacter('\\', '/') << "\"\n";
+            workers << "        addWorker(new Heavy_" << section.name << "(sampleRate));\n";
+        }
+
+        auto const parallelSectionsHeader = String(parallelSectionsTemplate).replace("%INCLUDES%", includes).replace("%WORKERS%", workers);
+
+        return source.replaceWithText(sourceLines.joinIntoString("\n") + "\n", false, false, "\n")
+            && header.replaceWithText(headerLines.joinIntoString("\n") + "\n", false, false, "\n")
+            && source.getSiblingFile("ParallelSections.hpp").replaceWithText(parallelSectionsHeader, false, false, "\n");
+    }
+
+    static constexpr char const* parallelSectionsTemplate = R"(// Generated by plugdata
+// Runs the subpatches that were marked with @hv_parallel in their own Heavy contexts, each on its own thread
+// Blocks are handed over to the threads through atomic counters, so the audio thread never takes a lock
+// The contexts and threads are created in prepare, which the plugin calls from activate(), so the audio thread never allocates
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+%INCLUDES%
+class ParallelSections {
+public:
+    ~ParallelSections()
+    {
+        stop();
+    }
+
+    // Call before processing the main context
+    void start(float const** inputs, uint32_t frames)
+    {
+        // The host shouldn't send larger blocks than it told us about, but if it does, the sections stay silent
+        running = frames <= maxFrames;
+        if (!running)
+            return;
+
+        currentInputs = inputs;
+        currentFrames = frames;
+        currentBlock.fetch_add(1, std::memory_order_release);
+    }
+
+    // Call after processing the main context, waits for the sections and adds them to the output
+    void finish(float** outputs, uint32_t frames)
+    {
+        if (!running)
+            return;
+
+        auto const block = currentBlock.load(std::memory_order_relaxed);
+        for (auto& worker : workers) {
+            while (worker->finishedBlock.load(std::memory_order_acquire) != block)
+                std::this_thread::yield();
+
+            auto const numOutputs = std::min<int>(worker->context->getNumOutputChannels(), DISTRHO_PLUGIN_NUM_OUTPUTS);
+            for (int ch = 0; ch < numOutputs; ch++) {
+                for (uint32_t i = 0; i < frames; i++)
+                    outputs[ch][i] += worker->outputs[ch][i];
+            }
+        }
+    }
+
+    // Call while the plugin isn't processing
+    void prepare(double sampleRate, uint32_t frames)
+    {
+        stop();
+
+        maxFrames = frames;
+        shouldStop = false;
+
+%WORKERS%
+        for (auto& worker : workers)
+            worker->thread = std::thread([this, w = worker.get()]() { run(*w); });
+    }
+
+    // Call while the plugin isn't processing
+    void stop()
+    {
+        shouldStop = true;
+        for (auto& worker : workers) {
+            if (worker->thread.joinable())
+                worker->thread.join();
+        }
+        workers.clear();
+        maxFrames = 0;
+    }
+
+private:
+    struct Worker {
+        std::unique_ptr<HeavyContextInterface> context;
+        std::vector<std::vector<float>> outputs;
+        std::vector<float*> outputPointers;
+        std::vector<float*> inputPointers;
+        std::vector<float> silence;
+        std::atomic<uint32_t> finishedBlock { 0 };
+        std::thread thread;
+    };
+
+    void addWorker(HeavyContextInterface* context)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->context.reset(context);
+        worker->outputs.assign(std::max(1, context->getNumOutputChannels()), std::vector<float>(maxFrames, 0.0f));
+        for (auto& output : worker->outputs)
+            worker->outputPointers.push_back(output.data());
+        worker->inputPointers.resize(std::max(1, context->getNumInputChannels()));
+        worker->silence.assign(maxFrames, 0.0f);
+        worker->finishedBlock = currentBlock.load();
+        workers.push_back(std::move(worker));
+    }
+
+    void run(Worker& worker)
+    {
+        auto lastBlockTime = std::chrono::steady_clock::now();
+        while (!shouldStop.load(std::memory_order_relaxed)) {
+            auto const block = currentBlock.load(std::memory_order_acquire);
+            if (block == worker.finishedBlock.load(std::memory_order_relaxed)) {
+                // Stay ready while audio is running, but don't keep a core busy when the host stops processing
+                if (std::chrono::steady_clock::now() - lastBlockTime > std::chrono::milliseconds(100))
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                else
+                    std::this_thread::yield();
+                continue;
+            }
+
+            for (size_t ch = 0; ch < worker.inputPointers.size(); ch++)
+                worker.inputPointers[ch] = static_cast<int>(ch) < DISTRHO_PLUGIN_NUM_INPUTS ? const_cast<float*>(currentInputs[ch]) : worker.silence.data();
+
+            worker.context->process(worker.inputPointers.data(), worker.outputPointers.data(), static_cast<int>(currentFrames));
+            worker.finishedBlock.store(block, std::memory_order_release);
+            lastBlockTime = std::chrono::steady_clock::now();
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<uint32_t> currentBlock { 0 };
+    std::atomic<bool> shouldStop { false };
+
+    // Written before currentBlock is incremented, so the workers see them once they see the new block
+    float const** currentInputs = nullptr;
+    uint32_t currentFrames = 0;
+
+    uint32_t maxFrames = 0;
+    bool running = false;
+};
+)";
 };
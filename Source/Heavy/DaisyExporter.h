@@ -226,9 +226,9 @@ public:
         }
 
         // blocksize and samplerate
+        auto sampleRates = Array { 8000, 16000, 32000, 48000, 96000 };
+        auto const samplerate = sampleRates[rate];
         if (rate != 3) {
-            auto sampleRates = Array { 8000, 16000, 32000, 48000, 96000 };
-            auto const& samplerate = sampleRates[rate];
             metaDaisy.getDynamicObject()->setProperty("samplerate", samplerate);
         }
 
@@ -270,22 +270,18 @@ public:
 
         args.add(paths);
 
-        start(args.joinIntoString(" "));
-        waitForProcessToFinish(-1);
-        exportingView->flushConsole();
+        bool heavyExitCode = runHeavy(args, outdir, searchPaths);
 
         exportingView->logToConsole("Compiling for " + board + "...\n");
 
         if (shouldQuit)
             return true;
 
-        // Delay to get correct exit code
-        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
-
         auto outputFile = File(outdir);
         auto sourceDir = outputFile.getChildFile("daisy").getChildFile("source");
 
-        bool heavyExitCode = getExitCode();
+        HeavyExportReport report;
+        report.addHeavyIR(outputFile);
 
         if (compile) {
 
@@ -294,7 +290,8 @@ public:
             auto make = bin.getChildFile("make" + exeSuffix);
             auto compiler = bin.getChildFile("arm-none-eabi-gcc" + exeSuffix);
 
-            libDaisy.copyDirectoryTo(outputFile.getChildFile("libdaisy"));
+            // Keeps the modification times, so libdaisy headers don't make everything rebuild with every export
+            syncDirectory(libDaisy, outputFile.getChildFile("libdaisy"));
 
             outputFile.getChildFile("ir").deleteRecursively();
             outputFile.getChildFile("hv").deleteRecursively();
@@ -305,11 +302,12 @@ public:
             sourceDir.setAsCurrentWorkingDirectory();
 
             sourceDir.getChildFile("build").createDirectory();
+            restoreObjectFiles(sourceDir);
             auto const& gccPath = bin.getFullPathName();
 
 #if JUCE_WINDOWS
             auto buildScript = make.getFullPathName().replaceCharacter('\\', '/')
-                + " -j4 -f "
+                + Toolchain::getParallelJobsArgument() + " -f "
                 + sourceDir.getChildFile("Makefile").getFullPathName().replaceCharacter('\\', '/')
                 + " GCC_PATH="
                 + gccPath.replaceCharacter('\\', '/')
@@ -318,7 +316,7 @@ public:
             Toolchain::startShellScript(buildScript, this);
 #else
             String buildScript = make.getFullPathName()
-                + " -j4 -f " + sourceDir.getChildFile("Makefile").getFullPathName()
+                + Toolchain::getParallelJobsArgument() + " -f " + sourceDir.getChildFile("Makefile").getFullPathName()
                 + " GCC_PATH=" + gccPath
                 + " PROJECT_NAME=" + name;
 
@@ -335,6 +333,10 @@ public:
             Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
 
             auto compileExitCode = getExitCode();
+            storeObjectFiles(sourceDir);
+
+            report.addLinkerMap(sourceDir.getChildFile("build").getChildFile("HeavyDaisy_" + name + ".map"));
+            exportingView->logToConsole(report.toString(samplerate, blocksize));
             if (flash && !compileExitCode) {
 
                 auto dfuUtil = bin.getChildFile("dfu-util" + exeSuffix);
@@ -437,6 +439,8 @@ public:
             auto libDaisy = Toolchain::dir.getChildFile("lib").getChildFile("libdaisy");
             libDaisy.copyDirectoryTo(outputFile.getChildFile("libdaisy"));
 
+            exportingView->logToConsole(report.toString(samplerate, blocksize));
+
             outputFile.getChildFile("ir").deleteRecursively();
             outputFile.getChildFile("hv").deleteRecursively();
             outputFile.getChildFile("c").deleteRecursively();
@@ -9,7 +9,7 @@
 
 struct ExporterBase : public Component
     , public Value::Listener
-    , public ChildProcess
+    , public ToolchainProcess
     , public ThreadPool {
     TextButton exportButton = TextButton("Export");
 
@@ -25,6 +25,13 @@ struct ExporterBase : public Component
 
     inline static File heavyExecutable = Toolchain::dir.getChildFile("bin").getChildFile("Heavy").getChildFile("Heavy" + exeSuffix);
 
+    // Generated code and object files of earlier exports, so exporting a patch again only regenerates and recompiles what changed
+    inline static File const heavyCacheDir = ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("Heavy");
+    static constexpr int maxCachedGenerations = 16;
+
+    // Identifies the exporter, project and output directory of the current export, for finding the files of the previous export
+    String buildCacheName;
+
     bool validPatchSelected = false;
 
     File patchFile;
@@ -113,8 +120,7 @@ struct ExporterBase : public Component
         }
 
         shouldQuit = true;
-        if (isRunning())
-            kill();
+        killProcessTree();
         removeAllJobs(true, -1);
     }
 
@@ -155,6 +161,8 @@ struct ExporterBase : public Component
         // Make sure we don't add the file location twice
         searchPaths.removeDuplicates(false);
 
+        buildCacheName = getState().getType().toString() + "_" + projectTitle.replaceCharacter('-', '_') + "_" + String::toHexString(outPath.hashCode64());
+
         addJob([this, patchPath, outPath, projectTitle, projectCopyright, searchPaths]() mutable {
             exportingView->monitorProcessOutput(this);
 
@@ -216,6 +224,134 @@ struct ExporterBase : public Component
         return metadata.getFullPathName();
     }
 
+    // Runs hvcc, or copies its output from the cache if nothing it depends on changed since an earlier export
+    // Returns the exit code of hvcc
+    uint32 runHeavy(StringArray args, String const& outdir, StringArray const& searchPaths)
+    {
+        auto const generatedDir = heavyCacheDir.getChildFile("Generated");
+        auto const key = getHeavyCacheKey(args, searchPaths);
+        auto const cached = generatedDir.getChildFile(key);
+
+        if (cached.isDirectory()) {
+            exportingView->logToConsole("Patch hasn't changed, reusing generated code\n");
+            syncDirectory(cached, File(outdir));
+            cached.setLastModificationTime(Time::getCurrentTime());
+            return 0;
+        }
+
+        // Generate into a temporary directory, so a failed run never ends up in the cache
+        auto const generating = generatedDir.getChildFile(key + "_tmp");
+        generating.deleteRecursively();
+        for (auto& arg : args) {
+            if (arg.startsWith("-o"))
+                arg = "-o" + generating.getFullPathName();
+        }
+
+#if JUCE_WINDOWS
+        Toolchain::startShellScript(args.joinIntoString(" ").replaceCharacter('\\', '/'), this);
+#else
+        Toolchain::startShellScript(args.joinIntoString(" "), this);
+#endif
+        waitForProcessToFinish(-1);
+        exportingView->flushConsole();
+
+        // Delay to get correct exit code
+        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
+
+        auto const exitCode = getExitCode();
+        if (exitCode || shouldQuit) {
+            generating.deleteRecursively();
+            return exitCode;
+        }
+
+        // Files that are the same as in the previous export keep their modification time, so make doesn't rebuild them
+        auto const latestFile = generatedDir.getChildFile(buildCacheName + ".latest");
+        auto const previous = generatedDir.getChildFile(latestFile.loadFileAsString().trim());
+        if (previous.isDirectory() && latestFile.existsAsFile()) {
+            for (auto const& file : generating.findChildFiles(File::findFiles, true)) {
+                auto const previousFile = previous.getChildFile(file.getRelativePathFrom(generating));
+                if (previousFile.existsAsFile() && previousFile.hasIdenticalContentTo(file))
+                    file.setLastModificationTime(previousFile.getLastModificationTime());
+            }
+        }
+
+        generating.moveFileTo(cached);
+        latestFile.replaceWithText(key);
+
+        // Remove the generations that weren't used for the longest time
+        auto generations = generatedDir.findChildFiles(File::findDirectories, false);
+        std::sort(generations.begin(), generations.end(), [](File const& a, File const& b) { return a.getLastModificationTime() > b.getLastModificationTime(); });
+        for (int i = maxCachedGenerations; i < generations.size(); i++) {
+            generations[i].deleteRecursively();
+        }
+
+        syncDirectory(cached, File(outdir));
+        return 0;
+    }
+
+    // Object files from the previous build of this export, call before running make
+    void restoreObjectFiles(File const& buildDir)
+    {
+        auto const cacheDir = heavyCacheDir.getChildFile("Objects").getChildFile(buildCacheName);
+        if (cacheDir.isDirectory())
+            syncDirectory(cacheDir, buildDir);
+    }
+
+    // Keep the object files of this build for the next export, call after running make
+    void storeObjectFiles(File const& buildDir)
+    {
+        auto const cacheDir = heavyCacheDir.getChildFile("Objects").getChildFile(buildCacheName);
+        cacheDir.deleteRecursively();
+
+        for (auto const& file : buildDir.findChildFiles(File::findFiles, true, "*.o;*.d")) {
+            auto const target = cacheDir.getChildFile(file.getRelativePathFrom(buildDir));
+            target.getParentDirectory().createDirectory();
+            if (file.copyFileTo(target))
+                target.setLastModificationTime(file.getLastModificationTime());
+        }
+    }
+
+    // Copies a directory, keeping the modification times, and leaves files that are already the same alone
+    static void syncDirectory(File const& source, File const& target)
+    {
+        for (auto const& file : source.findChildFiles(File::findFiles, true)) {
+            auto const targetFile = target.getChildFile(file.getRelativePathFrom(source));
+            if (targetFile.existsAsFile() && targetFile.getSize() == file.getSize() && targetFile.getLastModificationTime() == file.getLastModificationTime())
+                continue;
+
+            targetFile.getParentDirectory().createDirectory();
+            if (file.copyFileTo(targetFile))
+                targetFile.setLastModificationTime(file.getLastModificationTime());
+        }
+    }
+
 private:
+    // Everything that changes the output of hvcc: its arguments, the patch, the metadata and the abstractions it could use
+    String getHeavyCacheKey(StringArray const& args, StringArray const& searchPaths) const
+    {
+        String key = String(heavyExecutable.getLastModificationTime().toMilliseconds());
+        for (int i = 1; i < args.size(); i++) {
+            auto const& arg = args[i];
+            if (arg.startsWith("-o"))
+                continue;
+
+            // The patch and metadata are temporary files, so their path changes with every export
+            if (i == 1)
+                key += File(arg).loadFileAsString();
+            else if (arg.startsWith("-m"))
+                key += File(arg.substring(2)).loadFileAsString();
+            else
+                key += arg;
+        }
+
+        for (auto const& path : searchPaths) {
+            for (auto const& abstraction : File(path).findChildFiles(File::findFiles, false, "*.pd")) {
+                key += abstraction.getFullPathName() + String(abstraction.getLastModificationTime().toMilliseconds());
+            }
+        }
+
+        return String::toHexString(key.hashCode64());
+    }
+
     virtual bool performExport(String pdPatch, String outdir, String name, String copyright, StringArray searchPaths) = 0;
 };
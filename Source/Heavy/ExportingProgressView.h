@@ -20,7 +20,8 @@ class ExportingProgressView : public Component
     , public Timer {
     TextEditor console;
 
-    ChildProcess* processToMonitor;
+    ToolchainProcess* processToMonitor = nullptr;
+    double exportStartTime = 0.0;
 
 public:
     enum ExportState {
@@ -39,9 +40,6 @@ public:
     WaitableEvent userInteractionWait;
     TextButton confirmButton = TextButton("Done!");
 
-    static constexpr int maxLength = 512;
-    char processOutput[maxLength];
-
     ExportingProgressView()
         : Thread("Console thread")
     {
@@ -81,37 +79,41 @@ public:
 
     void run() override
     {
+        bool wasRunning = false;
         while (processToMonitor && !threadShouldExit()) {
-            int len = processToMonitor->readProcessOutput(processOutput, maxLength);
-            if (len)
-                logToConsole(String::fromUTF8(processOutput, len));
+            logToConsole(processToMonitor->readNewOutput());
+
+            // Show how long every step took
+            auto const running = processToMonitor->isRunning();
+            if (wasRunning && !running) {
+                logToConsole(processToMonitor->readNewOutput(true));
+                logToConsole("Finished in " + String(processToMonitor->getSecondsSinceStart(), 1) + "s\n");
+            }
+            wasRunning = running;
 
-            Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 100);
+            wait(50);
         }
     }
 
-    void monitorProcessOutput(ChildProcess* process)
+    void monitorProcessOutput(ToolchainProcess* process)
     {
         startTimer(20);
         processToMonitor = process;
+        exportStartTime = Time::getMillisecondCounterHiRes();
         startThread();
     }
 
     void flushConsole()
     {
-        while (processToMonitor) {
-            int len = processToMonitor->readProcessOutput(processOutput, maxLength);
-            if (!len)
-                break;
-
-            logToConsole(String::fromUTF8(processOutput, len));
-        }
+        if (processToMonitor)
+            logToConsole(processToMonitor->readNewOutput(true));
     }
 
     void stopMonitoring()
     {
-        flushConsole();
         stopThread(-1);
+        flushConsole();
+        logToConsole("Export took " + String((Time::getMillisecondCounterHiRes() - exportStartTime) / 1000.0, 1) + "s\n");
         stopTimer();
     }
 
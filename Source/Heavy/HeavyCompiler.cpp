@@ -0,0 +1,253 @@
+/*
+ // Copyright (c) 2023 Timothy Schoen and Wasted Audio
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Utility/Config.h"
+#include "Utility/Fonts.h"
+
+#include "PluginEditor.h"
+#include "PluginProcessor.h"
+#include "Canvas.h"
+#include "Object.h"
+#include "Objects/ObjectBase.h"
+
+#include "Toolchain.h"
+#include "HeavyCompiler.h"
+
+#if JUCE_WINDOWS
+static String const exeSuffix = ".exe";
+#else
+static String const exeSuffix = "";
+#endif
+
+HeavyCompiler::HeavyCompiler()
+    : process(std::make_unique<ToolchainProcess>())
+{
+}
+
+HeavyCompiler::~HeavyCompiler()
+{
+    shouldQuit = true;
+    process->killProcessTree();
+    compileThread.removeAllJobs(true, -1);
+}
+
+bool HeavyCompiler::canCompile(Object* object)
+{
+    if (!object || !object->gui)
+        return false;
+
+    auto subpatch = object->gui->getPatch();
+    return subpatch && subpatch->isSubpatch();
+}
+
+File HeavyCompiler::getExternalFile(File const& dir, String const& name)
+{
+#if JUCE_MAC
+    return dir.getChildFile(name + "~.pd_darwin");
+#elif JUCE_WINDOWS
+    return dir.getChildFile(name + "~.dll");
+#else
+    return dir.getChildFile(name + "~.pd_linux");
+#endif
+}
+
+String HeavyCompiler::convertToCompilablePatch(String const& subpatchContent, String& error)
+{
+    auto lines = StringArray::fromLines(subpatchContent);
+    lines.removeEmptyStrings();
+
+    // Position and line index of the inlets and outlets of the subpatch itself, not those of nested subpatches
+    std::vector<std::pair<int, int>> inlets, outlets;
+
+    int depth = 0;
+    for (int i = 0; i < lines.size(); i++) {
+        auto tokens = StringArray::fromTokens(lines[i].upToLastOccurrenceOf(";", false, false), " ", "");
+
+        if (tokens[0] == "#N" && tokens[1] == "canvas") {
+            depth++;
+        } else if (tokens[0] == "#X" && tokens[1] == "restore") {
+            depth--;
+        } else if (depth == 1 && tokens[0] == "#X" && tokens[1] == "obj" && tokens.size() >= 5) {
+            auto const& type = tokens[4];
+            if (type == "inlet~") {
+                inlets.emplace_back(tokens[2].getIntValue(), i);
+            } else if (type == "outlet~") {
+                outlets.emplace_back(tokens[2].getIntValue(), i);
+            } else if (type == "inlet" || type == "outlet") {
+                error = "Subpatches with message inlets or outlets can't be compiled, use [r name @hv_param] instead";
+                return {};
+            }
+        }
+    }
+
+    // pd orders iolets from left to right, the compiled external will have its channels in the same order
+    auto const replaceIolets = [&lines](std::vector<std::pair<int, int>>& iolets, String const& replacement) {
+        std::stable_sort(iolets.begin(), iolets.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+        for (int channel = 0; channel < static_cast<int>(iolets.size()); channel++) {
+            auto tokens = StringArray::fromTokens(lines[iolets[channel].second], " ", "");
+            lines.set(iolets[channel].second, "#X obj " + tokens[2] + " " + tokens[3] + " " + replacement + " " + String(channel + 1) + ";");
+        }
+    };
+
+    replaceIolets(inlets, "adc~");
+    replaceIolets(outlets, "dac~");
+
+    // Make it a toplevel patch
+    if (lines.size() && lines[lines.size() - 1].startsWith("#X restore"))
+        lines.remove(lines.size() - 1);
+    if (lines.size())
+        lines.set(0, "#N canvas 0 50 450 300 12;");
+
+    return lines.joinIntoString("\n") + "\n";
+}
+
+void HeavyCompiler::compileSubpatch(Canvas* cnv, Object* object)
+{
+    auto* pd = cnv->pd;
+    auto const heavyExecutable = Toolchain::dir.getChildFile("bin").getChildFile("Heavy").getChildFile("Heavy" + exeSuffix);
+    if (!heavyExecutable.existsAsFile()) {
+        pd->logError("Compiling subpatches requires the toolchain, install it from the Compile dialog");
+        return;
+    }
+
+    if (!canCompile(object))
+        return;
+
+    auto const content = object->gui->getPatch()->getCanvasContent();
+
+    String error;
+    auto const patchText = convertToCompilablePatch(content, error);
+    if (patchText.isEmpty()) {
+        pd->logError(error);
+        return;
+    }
+
+    // Heavy needs a valid C identifier as the name
+    auto const name = "hv_" + String::toHexString(patchText.hashCode64()).replaceCharacter('-', '_');
+
+    auto searchPaths = StringArray();
+    if (cnv->patch.getCurrentFile().existsAsFile())
+        searchPaths.add(cnv->patch.getCurrentFile().getParentDirectory().getFullPathName());
+
+    char* paths[1024];
+    int numItems;
+    pd->lockAudioThread();
+    pd::Interface::getSearchPaths(paths, &numItems);
+    pd->unlockAudioThread();
+    for (int i = 0; i < numItems; i++) {
+        searchPaths.add(paths[i]);
+    }
+    searchPaths.removeDuplicates(false);
+
+    pd->logMessage("Compiling subpatch as [" + name + "~]...");
+
+    compileThread.addJob([this, name, patchText, searchPaths, cnv = Component::SafePointer<Canvas>(cnv), object = Component::SafePointer<Object>(object), objectPtr = object->getPointer()]() {
+        auto const external = getExternalFile(externalsDir, name);
+
+        // We might have compiled this before
+        String failureMessage;
+        if (!external.existsAsFile()) {
+            auto const buildDir = buildsDir.getChildFile(name);
+            buildDir.deleteRecursively();
+            buildDir.createDirectory();
+
+            auto const patchFile = buildDir.getChildFile(name + ".pd");
+            patchFile.replaceWithText(patchText, false, false, "\n");
+
+            if (buildExternal(patchFile, buildDir, name, searchPaths)) {
+                externalsDir.createDirectory();
+                getExternalFile(buildDir, name).copyFileTo(external);
+                external.setExecutePermission(true);
+            } else {
+                failureMessage = process->readNewOutput(true).trim().fromLastOccurrenceOf("\n", false, false);
+            }
+
+            buildDir.deleteRecursively();
+        }
+
+        if (shouldQuit)
+            return;
+
+        MessageManager::callAsync([name, external, failureMessage, cnv, object, objectPtr]() {
+            if (!cnv)
+                return;
+
+            auto* pd = cnv->pd;
+            if (!external.existsAsFile()) {
+                pd->logError("Failed to compile [" + name + "~]: " + failureMessage);
+                return;
+            }
+
+            // The subpatch could have been deleted or replaced while we were compiling
+            if (!object || object->getPointer() != objectPtr) {
+                pd->logError("Compiled [" + name + "~], but the subpatch doesn't exist anymore");
+                return;
+            }
+
+            // This swaps the subpatch for the external in between two audio blocks, and keeps its connections
+            pd->lockAudioThread();
+            cnv->patch.renameObject(pd::Interface::checkObject(objectPtr), name + "~");
+            pd->unlockAudioThread();
+
+            cnv->synchronise();
+            pd->logMessage("Replaced subpatch with compiled [" + name + "~], undo to go back to the subpatch");
+        });
+    });
+}
+
+bool HeavyCompiler::buildExternal(File const& patchFile, File const& buildDir, String const& name, StringArray const& searchPaths)
+{
+    auto const heavyExecutable = Toolchain::dir.getChildFile("bin").getChildFile("Heavy").getChildFile("Heavy" + exeSuffix);
+
+    StringArray args = { heavyExecutable.getFullPathName(), patchFile.getFullPathName(), "-o" + buildDir.getFullPathName() };
+    args.add("-n" + name);
+    args.add("-gpdext");
+
+    String paths = "-p";
+    for (auto& path : searchPaths) {
+        paths += " " + path;
+    }
+    args.add(paths);
+
+#if JUCE_WINDOWS
+    Toolchain::startShellScript(args.joinIntoString(" ").replaceCharacter('\\', '/'), process.get());
+#else
+    Toolchain::startShellScript(args.joinIntoString(" "), process.get());
+#endif
+    process->waitForProcessToFinish(-1);
+
+    if (shouldQuit || process->getExitCode() != 0)
+        return false;
+
+    // Same build steps as the pd external exporter
+    auto const make = Toolchain::dir.getChildFile("bin").getChildFile("make" + exeSuffix);
+    auto const changeDirectory = "cd \"" + buildDir.getFullPathName().replaceCharacter('\\', '/') + "\"\n";
+
+#if JUCE_MAC
+    Toolchain::startShellScript(changeDirectory + "make" + Toolchain::getParallelJobsArgument(), process.get());
+#elif JUCE_WINDOWS
+    File pdDll;
+    if (ProjectInfo::isStandalone) {
+        pdDll = File::getSpecialLocation(File::currentApplicationFile).getParentDirectory();
+    } else {
+        pdDll = File::getSpecialLocation(File::globalApplicationsDirectory).getChildFile("plugdata");
+    }
+
+    auto path = "export PATH=\"$PATH:" + Toolchain::dir.getChildFile("bin").getFullPathName().replaceCharacter('\\', '/') + "\"\n";
+    auto cc = "CC=" + Toolchain::dir.getChildFile("bin").getChildFile("gcc.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
+    auto cxx = "CXX=" + Toolchain::dir.getChildFile("bin").getChildFile("g++.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
+    auto pdbindir = "PDBINDIR=" + pdDll.getFullPathName().replaceCharacter('\\', '/') + " ";
+
+    Toolchain::startShellScript(changeDirectory + path + cc + cxx + pdbindir + make.getFullPathName().replaceCharacter('\\', '/') + Toolchain::getParallelJobsArgument(), process.get());
+#else // Linux or BSD
+    auto prepareEnvironmentScript = Toolchain::dir.getChildFile("scripts").getChildFile("anywhere-setup.sh").getFullPathName() + "\n";
+    Toolchain::startShellScript(changeDirectory + prepareEnvironmentScript + make.getFullPathName() + Toolchain::getParallelJobsArgument(), process.get());
+#endif
+
+    process->waitForProcessToFinish(-1);
+
+    return !shouldQuit && getExternalFile(buildDir, name).existsAsFile();
+}
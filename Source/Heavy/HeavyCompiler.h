@@ -0,0 +1,42 @@
+/*
+ // Copyright (c) 2023 Timothy Schoen and Wasted Audio
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+class Canvas;
+class Object;
+class ToolchainProcess;
+
+// Compiles a subpatch with Heavy into a pd external in the background, and then replaces the subpatch with that external
+// Compiled externals are named after a hash of the patch, so compiling the same subpatch again reuses the external we already built
+// Owned by the editor, compilations run one after another
+class HeavyCompiler {
+public:
+    HeavyCompiler();
+    ~HeavyCompiler();
+
+    // Only subpatches (not abstractions) with signal inlets and outlets can be compiled
+    static bool canCompile(Object* object);
+
+    void compileSubpatch(Canvas* cnv, Object* object);
+
+private:
+    // Turns a subpatch into a patch that Heavy can compile: inlet~ and outlet~ become adc~ and dac~ channels in the order pd gives them
+    static String convertToCompilablePatch(String const& subpatchContent, String& error);
+
+    bool buildExternal(File const& patchFile, File const& buildDir, String const& name, StringArray const& searchPaths);
+
+    static File getExternalFile(File const& dir, String const& name);
+
+    static inline File const buildsDir = ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("Compiled");
+    static inline File const externalsDir = ProjectInfo::appDataDir.getChildFile("Externals");
+
+    std::unique_ptr<ToolchainProcess> process;
+    std::atomic<bool> shouldQuit = false;
+
+    // Declared last, so it finishes the current compilation before the process is deleted
+    ThreadPool compileThread = ThreadPool(1);
+};
@@ -23,6 +23,7 @@
 
 #include "Toolchain.h"
 #include "ExportingProgressView.h"
+#include "HeavyExportReport.h"
 #include "ExporterBase.h"
 #include "CppExporter.h"
 #include "DPFExporter.h"
@@ -0,0 +1,187 @@
+/*
+ // Copyright (c) 2022 Timothy Schoen and Wasted Audio
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Summary of what an exported patch costs on the target, shown in the export console
+// Object counts and buffer sizes come from the intermediate representation hvcc writes, flash and RAM usage come from the linker map
+struct HeavyExportReport {
+
+    // Call before the exporter removes the "ir" directory
+    void addHeavyIR(File const& outputDir)
+    {
+        auto irFiles = outputDir.getChildFile("ir").findChildFiles(File::findFiles, false, "*.heavy.ir.json");
+        if (irFiles.isEmpty())
+            return;
+
+        auto const ir = JSON::parse(irFiles.getFirst());
+        if (auto* objects = ir["objects"].getDynamicObject()) {
+            for (auto const& object : objects->getProperties()) {
+                auto const type = object.value["type"].toString();
+                auto& info = objectTypes[type];
+                info.count++;
+
+                // Tables and delay lines get allocated when the patch is initialised
+                auto const size = object.value["args"]["size"];
+                if (size.isInt() || size.isInt64() || size.isDouble())
+                    info.bufferBytes += std::max<int64>(0, static_cast<int64>(size)) * static_cast<int64>(sizeof(float));
+            }
+        }
+
+        if (auto* processOrder = ir["signal"]["processOrder"].getArray())
+            numSignalOperations = processOrder->size();
+    }
+
+    void addLinkerMap(File const& mapFile)
+    {
+        StringArray lines;
+        mapFile.readLines(lines);
+
+        // Everything before this line is about discarded sections and memory regions
+        bool inMemoryMap = false;
+
+        // Long section names are on their own line, with the address, size and file on the next line
+        String pendingSection;
+
+        for (auto const& line : lines) {
+            if (line.startsWith("Linker script and memory map")) {
+                inMemoryMap = true;
+                continue;
+            }
+            if (!inMemoryMap || !line.startsWithChar(' '))
+                continue;
+
+            auto tokens = StringArray::fromTokens(line, " \t", "");
+            tokens.removeEmptyStrings();
+
+            String section, size, file;
+            if (tokens.size() == 1 && tokens[0].startsWithChar('.')) {
+                pendingSection = tokens[0];
+                continue;
+            }
+            if (tokens.size() == 4 && tokens[0].startsWithChar('.')) {
+                section = tokens[0];
+                size = tokens[2];
+                file = tokens[3];
+            } else if (tokens.size() == 3 && pendingSection.isNotEmpty() && tokens[0].startsWith("0x")) {
+                section = pendingSection;
+                size = tokens[1];
+                file = tokens[2];
+            }
+            pendingSection = {};
+
+            if (!size.startsWith("0x") || !file.contains(".o"))
+                continue;
+
+            auto const bytes = size.substring(2).getHexValue64();
+            if (bytes <= 0)
+                continue;
+
+            auto& part = parts[getPartName(file)];
+            if (section.contains("bss")) {
+                part.ram += bytes;
+            } else if (section.startsWith(".data")) {
+                // Initialised data is stored in flash, and copied to RAM on startup
+                part.flash += bytes;
+                part.ram += bytes;
+            } else if (section.startsWith(".text") || section.startsWith(".rodata") || section.startsWith(".ARM") || section.startsWith(".isr_vector") || section.endsWith("_array")) {
+                part.flash += bytes;
+            }
+        }
+    }
+
+    String toString(int sampleRate, int blockSize) const
+    {
+        String report = "\nExport report:\n";
+
+        if (!parts.empty()) {
+            std::vector<std::pair<String, MemoryUsage>> sortedParts(parts.begin(), parts.end());
+            std::sort(sortedParts.begin(), sortedParts.end(), [](auto const& a, auto const& b) {
+                return a.second.flash + a.second.ram > b.second.flash + b.second.ram;
+            });
+
+            report << "Memory usage (flash / RAM):\n";
+
+            MemoryUsage total, other;
+            for (int i = 0; i < static_cast<int>(sortedParts.size()); i++) {
+                auto const& [name, usage] = sortedParts[i];
+                total.flash += usage.flash;
+                total.ram += usage.ram;
+
+                if (i < maxListedParts) {
+                    report << "  " << name.paddedRight(' ', 32) << describe(usage) << "\n";
+                } else {
+                    other.flash += usage.flash;
+                    other.ram += usage.ram;
+                }
+            }
+
+            if (other.flash + other.ram > 0)
+                report << "  " << String("Other").paddedRight(' ', 32) << describe(other) << "\n";
+
+            report << "  " << String("Total").paddedRight(' ', 32) << describe(total) << "\n";
+        }
+
+        if (!objectTypes.empty()) {
+            int numObjects = 0;
+            int64 bufferBytes = 0;
+            for (auto const& [type, info] : objectTypes) {
+                numObjects += info.count;
+                bufferBytes += info.bufferBytes;
+            }
+
+            report << "Heavy objects: " << String(numObjects) << ", signal operations: " << String(numSignalOperations) << "\n";
+
+            if (bufferBytes > 0)
+                report << "Tables and delay lines allocate " << File::descriptionOfSizeInBytes(bufferBytes) << " of RAM on startup\n";
+
+            // Every signal operation runs once per sample, and has some overhead for every block
+            auto const blocksPerSecond = static_cast<double>(sampleRate) / static_cast<double>(std::max(1, blockSize));
+            auto const cyclesPerSecond = numSignalOperations * (cyclesPerSample * sampleRate + cyclesPerBlock * blocksPerSecond);
+            auto const load = cyclesPerSecond / targetClockSpeed * 100.0;
+
+            report << "Estimated DSP load at " << String(sampleRate) << " Hz with a block size of " << String(blockSize) << ": ~" << String(load, 1) << "% (rough estimate)\n";
+        }
+
+        return report;
+    }
+
+private:
+    struct MemoryUsage {
+        int64 flash = 0;
+        int64 ram = 0;
+    };
+
+    struct ObjectTypeInfo {
+        int count = 0;
+        int64 bufferBytes = 0;
+    };
+
+    // hvcc generates a source file for every kind of object, so those show up separately, archives are listed as a whole
+    static String getPartName(String const& file)
+    {
+        if (file.contains("("))
+            return File(file.upToFirstOccurrenceOf("(", false, false)).getFileName();
+
+        return File(file).getFileNameWithoutExtension();
+    }
+
+    static String describe(MemoryUsage const& usage)
+    {
+        return File::descriptionOfSizeInBytes(usage.flash) + " / " + File::descriptionOfSizeInBytes(usage.ram);
+    }
+
+    std::map<String, ObjectTypeInfo> objectTypes;
+    std::map<String, MemoryUsage> parts;
+    int numSignalOperations = 0;
+
+    static constexpr int maxListedParts = 12;
+
+    // Ballpark figures for the Daisy's Cortex-M7
+    static constexpr double cyclesPerSample = 6.0;
+    static constexpr double cyclesPerBlock = 40.0;
+    static constexpr double targetClockSpeed = 480000000.0;
+};
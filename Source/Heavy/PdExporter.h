@@ -87,10 +87,7 @@ public:
         if (shouldQuit)
             return true;
 
-        start(args.joinIntoString(" "));
-
-        waitForProcessToFinish(-1);
-        exportingView->flushConsole();
+        auto const heavyExitCode = runHeavy(args, outdir, searchPaths);
 
         if (shouldQuit)
             return true;
@@ -99,12 +96,11 @@ public:
         outputFile.getChildFile("ir").deleteRecursively();
         outputFile.getChildFile("hv").deleteRecursively();
 
-        // Delay to get correct exit code
-        Time::waitForMillisecondCounter(Time::getMillisecondCounter() + 300);
-
-        bool generationExitCode = getExitCode();
+        bool generationExitCode = heavyExitCode;
         // Check if we need to compile
         if (!generationExitCode && getValue<int>(exportTypeValue) == 2) {
+            restoreObjectFiles(outputFile);
+
             auto workingDir = File::getCurrentWorkingDirectory();
 
             outputFile.setAsCurrentWorkingDirectory();
@@ -114,7 +110,7 @@ public:
             auto makefile = outputFile.getChildFile("Makefile");
 
 #if JUCE_MAC
-            Toolchain::startShellScript("make -j4", this);
+            Toolchain::startShellScript("make" + Toolchain::getParallelJobsArgument(), this);
 #elif JUCE_WINDOWS
             File pdDll;
             if (ProjectInfo::isStandalone) {
@@ -128,14 +124,14 @@ public:
             auto cxx = "CXX=" + Toolchain::dir.getChildFile("bin").getChildFile("g++.exe").getFullPathName().replaceCharacter('\\', '/') + " ";
             auto pdbindir = "PDBINDIR=" + pdDll.getFullPathName().replaceCharacter('\\', '/') + " ";
 
-            Toolchain::startShellScript(path + cc + cxx + pdbindir + make.getFullPathName().replaceCharacter('\\', '/') + " -j4", this);
+            Toolchain::startShellScript(path + cc + cxx + pdbindir + make.getFullPathName().replaceCharacter('\\', '/') + Toolchain::getParallelJobsArgument(), this);
 
 #else // Linux or BSD
             auto prepareEnvironmentScript = Toolchain::dir.getChildFile("scripts").getChildFile("anywhere-setup.sh").getFullPathName() + "\n";
 
             auto buildScript = prepareEnvironmentScript
                 + make.getFullPathName()
-                + " -j4";
+                + Toolchain::getParallelJobsArgument();
 
             Toolchain::startShellScript(buildScript, this);
 #endif
@@ -148,6 +144,8 @@ public:
 
             workingDir.setAsCurrentWorkingDirectory();
 
+            storeObjectFiles(outputFile);
+
 #if JUCE_MAC
             auto external = outputFile.getChildFile(name + "~.pd_darwin");
 #elif JUCE_WINDOWS
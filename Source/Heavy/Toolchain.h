@@ -8,6 +8,8 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "Constants.h"
 
+class ToolchainProcess;
+
 struct Toolchain {
 #if JUCE_WINDOWS
     static inline File const dir = ProjectInfo::appDataDir.getChildFile("Toolchain").getChildFile("usr");
@@ -15,6 +17,12 @@ struct Toolchain {
     static inline File const dir = ProjectInfo::appDataDir.getChildFile("Toolchain");
 #endif
 
+    // Lets make compile on all cores
+    static String getParallelJobsArgument()
+    {
+        return " -j" + String(jmax(1, SystemStats::getNumCpus()));
+    }
+
     static void deleteTempFileLater(File script)
     {
         tempFilesToDelete.add(script);
@@ -30,61 +38,142 @@ struct Toolchain {
         }
     }
 
-    static void startShellScript(String scriptText, ChildProcess* processToUse = nullptr)
+    // Starts the script in processToUse, or runs it to completion when no process is given
+    static void startShellScript(String scriptText, ToolchainProcess* processToUse = nullptr);
+
+    String const startShellScriptWithOutput(String scriptText);
+
+private:
+    inline static Array<File> tempFilesToDelete;
+};
+
+// Runs toolchain scripts with their output going to a log file instead of a pipe
+// Reading the log never blocks, so the console can stream the output line by line, and the export thread can always be cancelled
+// The script reports its process id, so cancelling also stops everything it started (like make and the compilers)
+class ToolchainProcess : public ChildProcess {
+public:
+    ~ToolchainProcess()
+    {
+        killProcessTree();
+    }
+
+    bool startScript(String const& scriptText)
     {
-        File scriptFile = File::createTempFile(".sh");
+        ScopedLock lock(outputLock);
+
+        auto const scriptFile = File::createTempFile(".sh");
+        logFile = scriptFile.withFileExtension(".log");
+        pidFile = scriptFile.withFileExtension(".pid");
         Toolchain::deleteTempFileLater(scriptFile);
+        Toolchain::deleteTempFileLater(logFile);
+        Toolchain::deleteTempFileLater(pidFile);
 
-        auto bash = String("#!/bin/bash\n");
-        scriptFile.replaceWithText(bash + scriptText, false, false, "\n");
+        logFile.create();
+        readPosition = 0;
+        unfinishedLine.reset();
+
+        String header = "#!/bin/bash\n";
+        header << "echo $$ > \"" << toShellPath(pidFile) << "\"\n";
+        header << "exec > \"" << toShellPath(logFile) << "\" 2>&1\n";
+        scriptFile.replaceWithText(header + scriptText, false, false, "\n");
+
+        startTime = Time::getMillisecondCounterHiRes();
 
 #if JUCE_WINDOWS
         auto sh = Toolchain::dir.getChildFile("bin").getChildFile("sh.exe");
-
-        if (processToUse) {
-            processToUse->start(StringArray { sh.getFullPathName(), "--login", scriptFile.getFullPathName().replaceCharacter('\\', '/') });
-        } else {
-            ChildProcess process;
-            process.start(StringArray { sh.getFullPathName(), "--login", scriptFile.getFullPathName().replaceCharacter('\\', '/') });
-            process.waitForProcessToFinish(-1);
-        }
+        return start(StringArray { sh.getFullPathName(), "--login", toShellPath(scriptFile) }, 0);
 #else
         scriptFile.setExecutePermission(true);
-
-        if (processToUse) {
-            processToUse->start(scriptFile.getFullPathName());
-        } else {
-            ChildProcess process;
-            process.start(scriptFile.getFullPathName());
-            process.waitForProcessToFinish(-1);
-        }
+        return start(scriptFile.getFullPathName(), 0);
 #endif
     }
 
-    String const startShellScriptWithOutput(String scriptText)
+    // Returns the output that was written since the last call, without waiting for more
+    // Only returns complete lines, unless includeUnfinishedLine is set (for when the process has finished)
+    String readNewOutput(bool includeUnfinishedLine = false)
     {
-        File scriptFile = File::createTempFile(".sh");
-        Toolchain::deleteTempFileLater(scriptFile);
+        ScopedLock lock(outputLock);
 
-        auto bash = String("#!/bin/bash\n");
-        scriptFile.replaceWithText(bash + scriptText, false, false, "\n");
+        FileInputStream stream(logFile);
+        if (stream.openedOk() && stream.setPosition(readPosition)) {
+            auto const numRead = stream.readIntoMemoryBlock(unfinishedLine);
+            readPosition += static_cast<int64>(numRead);
+        }
 
-        ChildProcess process;
-#if JUCE_WINDOWS
-        auto sh = Toolchain::dir.getChildFile("bin").getChildFile("sh.exe");
-        auto arguments = StringArray { sh.getFullPathName(), "--login", scriptFile.getFullPathName().replaceCharacter('\\', '/') };
-#else
-        scriptFile.setExecutePermission(true);
-        auto arguments = scriptFile.getFullPathName();
+        auto const* data = static_cast<char const*>(unfinishedLine.getData());
+        auto end = static_cast<int>(unfinishedLine.getSize());
+        if (!includeUnfinishedLine) {
+            while (end > 0 && data[end - 1] != '\n')
+                end--;
+        }
+
+        if (end == 0)
+            return {};
+
+        auto const output = String::fromUTF8(data, end);
+        unfinishedLine.removeSection(0, static_cast<size_t>(end));
+        return output;
+    }
+
+    // Time since the last script was started
+    double getSecondsSinceStart() const
+    {
+        return (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    }
+
+    void killProcessTree()
+    {
+#if !JUCE_WINDOWS
+        auto const pid = pidFile.loadFileAsString().trim();
+        if (isRunning() && pid.isNotEmpty() && pid.containsOnly("0123456789")) {
+            // Pause every process before stopping it, so it can't start new children while we're going through them
+            ChildProcess killer;
+            killer.start(StringArray { "/bin/sh", "-c", "killtree() { kill -STOP $1 2>/dev/null; for child in $(pgrep -P $1); do killtree $child; done; kill -TERM $1 2>/dev/null; kill -CONT $1 2>/dev/null; }; killtree " + pid }, 0);
+            killer.waitForProcessToFinish(2000);
+        }
 #endif
-        process.start(arguments, ChildProcess::wantStdOut | ChildProcess::wantStdErr);
-        return process.readAllProcessOutput();
+        // On Windows, the msys shell doesn't tell us the native process ids, so we can only stop the shell itself
+        if (isRunning())
+            kill();
     }
 
 private:
-    inline static Array<File> tempFilesToDelete;
+    static String toShellPath(File const& file)
+    {
+        return file.getFullPathName().replaceCharacter('\\', '/');
+    }
+
+    CriticalSection outputLock;
+    File logFile;
+    File pidFile;
+    int64 readPosition = 0;
+    MemoryBlock unfinishedLine;
+    double startTime = 0.0;
 };
 
+inline void Toolchain::startShellScript(String scriptText, ToolchainProcess* processToUse)
+{
+    if (processToUse) {
+        processToUse->startScript(scriptText);
+    } else {
+        ToolchainProcess process;
+        process.startScript(scriptText);
+        process.waitForProcessToFinish(-1);
+    }
+}
+
+inline String const Toolchain::startShellScriptWithOutput(String scriptText)
+{
+    ToolchainProcess process;
+    process.startScript(scriptText);
+
+    // This is only used for quick queries, don't let a stuck tool hang the export
+    if (!process.waitForProcessToFinish(30000))
+        process.killProcessTree();
+
+    return process.readNewOutput(true);
+}
+
 class ToolchainInstaller : public Component
     , public Thread
     , public Timer {
@@ -35,7 +35,7 @@ Iolet::Iolet(Object* parent, bool inlet)
     presentationMode.addListener(this);
 
     bool isPresenting = getValue<bool>(presentationMode);
-    setVisible(!isPresenting && !insideGraph);
+    setVisible(!isPresenting && !insideGraph && !object->cnv->simplifiedRendering);
 
     // Drawing circles is more expensive than you might think, especially because there can be a lot of iolets!
     setBufferedToImage(true);
@@ -73,6 +73,13 @@ bool Iolet::hitTest(int x, int y)
     return getLocalBounds().contains(x, y);
 }
 
+void Iolet::lookAndFeelChanged()
+{
+    // The window is repainted once after a theme change, but that doesn't invalidate the image we're buffered to
+    if (auto* cachedImage = getCachedComponentImage())
+        cachedImage->invalidateAll();
+}
+
 void Iolet::paint(Graphics& g)
 {
     auto bounds = getLocalBounds().toFloat().reduced(0.5f);
@@ -293,12 +300,17 @@ void Iolet::mouseUp(MouseEvent const& e)
 
                 cnv->nearestIolet = nullptr;
                 cnv->connectingWithDrag = false;
-                cnv->repaint();
             }
+            // Removing the connections being created already repaints the area they covered,
+            // so we only need to update the iolets we started dragging from instead of the whole canvas
             if (!shiftIsDown || cnv->connectionsBeingCreated.size() != 1) {
                 cnv->connectionsBeingCreated.clear();
-                cnv->repaint();
                 cnv->connectingWithDrag = false;
+
+                if (_this) {
+                    for (auto& iolet : object->iolets)
+                        cnv->repaintCoordinator.repaint(iolet);
+                }
             }
             if (cnv->nearestIolet) {
                 cnv->nearestIolet->isTargeted = false;
@@ -312,14 +324,16 @@ void Iolet::mouseUp(MouseEvent const& e)
 
 void Iolet::mouseEnter(MouseEvent const& e)
 {
+    object->updateTooltipsIfNeeded();
+
     for (auto& iolet : object->iolets)
-        iolet->repaint();
+        cnv->repaintCoordinator.repaint(iolet);
 }
 
 void Iolet::mouseExit(MouseEvent const& e)
 {
     for (auto& iolet : object->iolets)
-        iolet->repaint();
+        cnv->repaintCoordinator.repaint(iolet);
 }
 
 void Iolet::createConnection()
@@ -421,15 +435,15 @@ Array<Connection*> Iolet::getConnections()
 
 Iolet* Iolet::findNearestIolet(Canvas* cnv, Point<int> position, bool inlet, Object* boxToExclude)
 {
-    // Find all iolets
+    // Find all iolets of objects that are close enough to the position
     Array<Iolet*> allEdges;
-    for (auto* object : cnv->objects) {
+    cnv->objectIndex.forEachItemIn(Rectangle<int>(position, position).expanded(51), [&allEdges, inlet, boxToExclude](Object* object) {
         for (auto* iolet : object->iolets) {
             if (iolet->isInlet == inlet && iolet->object != boxToExclude) {
                 allEdges.add(iolet);
             }
         }
-    }
+    });
 
     Iolet* nearestIolet = nullptr;
 
@@ -457,7 +471,7 @@ void Iolet::valueChanged(Value& v)
         repaint();
     }
     if (v.refersToSameSourceAs(presentationMode)) {
-        setVisible(!getValue<bool>(presentationMode) && !insideGraph && !hideIolet);
+        updateVisibility();
         repaint();
     }
 }
@@ -465,6 +479,11 @@ void Iolet::valueChanged(Value& v)
 void Iolet::setHidden(bool hidden)
 {
     hideIolet = hidden;
-    setVisible(!getValue<bool>(presentationMode) && !insideGraph && !hideIolet);
+    updateVisibility();
     repaint();
 }
+
+void Iolet::updateVisibility()
+{
+    setVisible(!getValue<bool>(presentationMode) && !insideGraph && !hideIolet && !object->cnv->simplifiedRendering);
+}
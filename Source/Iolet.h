@@ -19,6 +19,7 @@ public:
     Iolet(Object* parent, bool isInlet);
 
     void paint(Graphics&) override;
+    void lookAndFeelChanged() override;
 
     void mouseDrag(MouseEvent const& e) override;
     void mouseUp(MouseEvent const& e) override;
@@ -35,6 +36,7 @@ public:
     void createConnection();
 
     void setHidden(bool hidden);
+    void updateVisibility();
 
     void clearConnections();
     Array<Connection*> getConnections();
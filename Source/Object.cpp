@@ -29,6 +29,60 @@
 extern "C" {
 #include <m_pd.h>
 #include <m_imp.h>
+#include <g_canvas.h>
+}
+
+static HeavyFootprint estimateHeavyFootprint(t_gobj* obj)
+{
+    HeavyFootprint footprint;
+    String const type = pd::Interface::getObjectClassName(&obj->g_pd);
+
+    if (type == "canvas" || type == "graph") {
+        for (auto* y = reinterpret_cast<t_canvas*>(obj)->gl_list; y; y = y->g_next)
+            footprint += estimateHeavyFootprint(y);
+        return footprint;
+    }
+
+    // Comments, atoms and broken objects don't end up in the compiled patch
+    if (type == "text" || type == "gatom")
+        return footprint;
+
+    footprint.numObjects = 1;
+    footprint.numIncompatible = HeavyCompatibleObjects::isCompatible(type) ? 0 : 1;
+    footprint.numSignalObjects = type.endsWith("~") ? 1 : 0;
+    footprint.memoryBytes = HeavyFootprint::bytesPerObject;
+
+    if (type == "garray") {
+        footprint.memoryBytes += static_cast<int64>(garray_getarray(reinterpret_cast<t_garray*>(obj))->a_n) * sizeof(float);
+        return footprint;
+    }
+
+    auto* object = pd_checkobject(&obj->g_pd);
+    if (!object || !object->te_binbuf)
+        return footprint;
+
+    auto const argc = binbuf_getnatom(object->te_binbuf);
+    auto const* argv = binbuf_getvec(object->te_binbuf);
+
+    auto getFloatArgument = [argc, argv](int index) -> double {
+        return index < argc && argv[index].a_type == A_FLOAT ? std::max<double>(0.0, argv[index].a_w.w_float) : 0.0;
+    };
+
+    if (type == "delwrite~") {
+        // [delwrite~ name ms]
+        footprint.memoryBytes += static_cast<int64>(getFloatArgument(2) * HeavyFootprint::estimatedSampleRate / 1000.0) * sizeof(float);
+    } else if (type == "table") {
+        // [table name size]
+        footprint.memoryBytes += static_cast<int64>(getFloatArgument(2)) * sizeof(float);
+    } else if (type == "array define") {
+        // [array define -flags name size]
+        int index = 2;
+        while (index < argc && argv[index].a_type == A_SYMBOL && argv[index].a_w.w_symbol->s_name[0] == '-')
+            index++;
+        footprint.memoryBytes += static_cast<int64>(getFloatArgument(index + 1)) * sizeof(float);
+    }
+
+    return footprint;
 }
 
 Object::Object(Canvas* parent, String const& name, Point<int> position)
@@ -68,6 +122,11 @@ Object::~Object()
 {
     hideEditor(); // Make sure the editor is not still open, that could lead to issues with listeners attached to the editor (i.e. suggestioncomponent)
     cnv->selectedComponents.removeChangeListener(this);
+
+    if (gui)
+        cnv->unregisterObject(this, gui->ptr.getRawUnchecked<t_gobj>());
+
+    cnv->objectIndex.remove(this);
 }
 
 Rectangle<int> Object::getObjectBounds()
@@ -119,6 +178,7 @@ void Object::timerCallback()
     if (activeStateAlpha <= 0.0f) {
         activeStateAlpha = 0.0f;
         stopTimer();
+        updateBufferedToImage();
     }
 }
 
@@ -146,11 +206,14 @@ void Object::valueChanged(Value& v)
     if (v.refersToSameSourceAs(hvccMode)) {
 
         isHvccCompatible = checkIfHvccCompatible();
+        updateHeavyFootprint();
 
         if (gui && !isHvccCompatible) {
             cnv->pd->logWarning(String("Warning: object \"" + gui->getType() + "\" is not supported in Compiled Mode").toRawUTF8());
         }
 
+        // Let the canvas update its totals
+        cnv->synchronise();
         repaint();
     } else if (v.refersToSameSourceAs(cnv->presentationMode)) {
         // else it was a lock/unlock/presentation mode action
@@ -172,12 +235,30 @@ bool Object::checkIfHvccCompatible()
         // Check hvcc compatibility
         bool isSubpatch = gui->getPatch() != nullptr;
 
-        return !getValue<bool>(hvccMode) || isSubpatch || HeavyCompatibleObjects::getAllCompatibleObjects().contains(typeName);
+        return !getValue<bool>(hvccMode) || isSubpatch || HeavyCompatibleObjects::isCompatible(typeName);
     }
 
     return true;
 }
 
+void Object::updateHeavyFootprint()
+{
+    heavyFootprint = HeavyFootprint();
+
+    if (!gui || !getValue<bool>(hvccMode))
+        return;
+
+    // Walks through the contents of subpatches, which the audio thread could be changing
+    cnv->pd->lockAudioThread();
+    if (auto* object = gui->ptr.getRaw<t_gobj>())
+        heavyFootprint = estimateHeavyFootprint(object);
+    cnv->pd->unlockAudioThread();
+
+    // Use the same check as the warning on the object itself, subpatches count their contents
+    if (gui->getPatch() == nullptr)
+        heavyFootprint.numIncompatible = isHvccCompatible ? 0 : 1;
+}
+
 bool Object::hitTest(int x, int y)
 {
     if (Canvas::panningModifierDown())
@@ -214,6 +295,8 @@ bool Object::hitTest(int x, int y)
 // To make iolets show/hide
 void Object::mouseEnter(MouseEvent const& e)
 {
+    updateTooltipsIfNeeded();
+
     for (auto* iolet : iolets)
         iolet->repaint();
 }
@@ -294,6 +377,48 @@ void Object::applyBounds()
 
     cnv->pd->unlockAudioThread();
 }
+
+// While dragging, objects are only moved on the canvas. When the drag ends, this moves all of them in pd at once
+// That way, we only need a single call into pd and we end up with one motion undo step, no matter how many objects were moved
+void Object::applyDrag()
+{
+    std::vector<t_gobj*> pdObjects;
+    Point<int> offset;
+
+    for (auto* obj : cnv->getSelectionOfType<Object>()) {
+        auto* objPtr = obj->getPointer();
+        if (!obj->gui || !objPtr)
+            continue;
+
+        auto pdBounds = obj->gui->getPdBounds();
+        if (pdBounds.isEmpty())
+            continue;
+
+        auto objectOffset = obj->getObjectBounds().getPosition() - pdBounds.getPosition();
+
+        // Objects in a selection are always dragged together, if they somehow moved by different amounts, apply them one by one
+        if (!pdObjects.empty() && objectOffset != offset) {
+            applyBounds();
+            return;
+        }
+
+        offset = objectOffset;
+        pdObjects.push_back(objPtr);
+    }
+
+    if (pdObjects.empty() || offset.isOrigin())
+        return;
+
+    cnv->pd->lockAudioThread();
+    cnv->patch.moveObjects(pdObjects, offset.x, offset.y);
+    cnv->pd->unlockAudioThread();
+
+    MessageManager::callAsync([cnv = SafePointer(this->cnv)] {
+        if (cnv)
+            cnv->editor->updateCommandStatus();
+    });
+}
+
 void Object::updateBounds()
 {
     // only update if we have a gui and the object isn't been moved by the user
@@ -349,10 +474,17 @@ void Object::setType(String const& newType, pd::WeakReference existingObject)
         return;
     }
 
+    if (gui)
+        cnv->unregisterObject(this, gui->ptr.getRawUnchecked<t_gobj>());
+
+    if (auto checked = objectPtr.get<t_pd>())
+        pdClassHash = hash(pd::Interface::getObjectClassName(checked.get()));
+
     // Create gui for the object
     gui.reset(ObjectBase::createGui(objectPtr, this));
 
     if (gui) {
+        cnv->registerObject(this, objectPtr.getRawUnchecked<t_gobj>());
         gui->initialise();
         gui->lock(cnv->isGraph || locked == var(true) || commandLocked == var(true));
         gui->addMouseListener(this, true);
@@ -360,6 +492,7 @@ void Object::setType(String const& newType, pd::WeakReference existingObject)
     }
 
     isHvccCompatible = checkIfHvccCompatible();
+    updateHeavyFootprint();
 
     if (gui && !isHvccCompatible) {
         cnv->pd->logWarning(String("Warning: object \"" + gui->getType() + "\" is not supported in Compiled Mode").toRawUTF8());
@@ -369,6 +502,8 @@ void Object::setType(String const& newType, pd::WeakReference existingObject)
     updateIolets();
     updateBounds();
     resized(); // If bounds haven't changed, we'll still want to update gui and iolets bounds
+    updateBufferedToImage();
+    updateLevelOfDetail();
 
     // Auto patching
     if (getValue<bool>(cnv->editor->autoconnect) && numInputs && cnv->lastSelectedObject && cnv->lastSelectedObject != this && cnv->lastSelectedObject->numOutputs) {
@@ -410,7 +545,10 @@ void Object::setType(String const& newType, pd::WeakReference existingObject)
     cnv->editor->updateCommandStatus();
 
     cnv->synchroniseSplitCanvas();
-    cnv->pd->updateObjectImplementations();
+
+    if (auto patch = cnv->patch.getPointer()) {
+        cnv->pd->updateObjectImplementations(patch.get());
+    }
 }
 
 Array<Rectangle<float>> Object::getCorners() const
@@ -426,6 +564,9 @@ Array<Rectangle<float>> Object::getCorners() const
 
 void Object::paintOverChildren(Graphics& g)
 {
+    if (cnv->simplifiedRendering)
+        return;
+
     // If autoconnect is about to happen, draw a fake inlet with a dotted outline
     if (getValue<bool>(cnv->editor->autoconnect) && isInitialEditorShown() && cnv->lastSelectedObject && cnv->lastSelectedObject != this && cnv->lastSelectedObject->numOutputs) {
         auto outlet = cnv->lastSelectedObject->iolets[cnv->lastSelectedObject->numInputs];
@@ -474,16 +615,53 @@ void Object::triggerOverlayActiveState()
         return;
 
     activeStateAlpha = 1.0f;
+
+    bool wasAnimating = isTimerRunning();
     startTimer(1000 / ACTIVITY_UPDATE_RATE);
 
+    // Don't keep a cached image while animating, it would be redrawn on every frame anyway
+    if (!wasAnimating)
+        updateBufferedToImage();
+
     // Because the timer is being reset when new messages come in
     // it will not trigger it's callback until it's free-running
     // so we manually call the repaint here if this happens
     repaint();
 }
 
+void Object::updateBufferedToImage()
+{
+    setBufferedToImage(gui && gui->canBeBufferedToImage() && !isTimerRunning());
+}
+
+void Object::updateLevelOfDetail()
+{
+    if (gui)
+        gui->setVisible(!cnv->simplifiedRendering);
+
+    for (auto* iolet : iolets)
+        iolet->updateVisibility();
+
+    // The canvas repaints once for all objects, we only need to drop the image we might be buffered to
+    if (auto* cachedImage = getCachedComponentImage())
+        cachedImage->invalidateAll();
+}
+
+void Object::lookAndFeelChanged()
+{
+    // The window is repainted once after a theme change, but that doesn't invalidate the image we might be buffered to
+    if (auto* cachedImage = getCachedComponentImage())
+        cachedImage->invalidateAll();
+}
+
 void Object::paint(Graphics& g)
 {
+    if (cnv->simplifiedRendering) {
+        g.setColour(findColour(selectedFlag ? PlugDataColour::objectSelectedOutlineColourId : PlugDataColour::objectOutlineColourId));
+        g.fillRoundedRectangle(getLocalBounds().reduced(margin).toFloat(), Corners::objectCornerRadius);
+        return;
+    }
+
     if (gui && gui->isTransparent() && !getValue<bool>(locked)) {
         g.setColour(findColour(PlugDataColour::canvasBackgroundColourId).contrasting(0.35f).withAlpha(0.1f));
         
@@ -530,8 +708,15 @@ void Object::paint(Graphics& g)
     }
 }
 
+void Object::moved()
+{
+    cnv->objectIndex.insertOrUpdate(this, getBounds());
+}
+
 void Object::resized()
 {
+    cnv->objectIndex.insertOrUpdate(this, getBounds());
+
     setVisible(!((cnv->isGraph || cnv->presentationMode == var(true)) && gui && gui->hideInGraph()));
 
     if (gui) {
@@ -603,18 +788,26 @@ void Object::resized()
     }
 }
 
+void Object::updateTooltipsIfNeeded()
+{
+    if (tooltipsNeedUpdate)
+        updateTooltips();
+}
+
 void Object::updateTooltips()
 {
     if (!gui)
         return;
 
-    auto objectInfo = cnv->pd->objectLibrary->getObjectInfo(gui->getType());
+    tooltipsNeedUpdate = false;
+
+    auto const type = gui->getType();
 
     // Set object tooltip
-    gui->setTooltip(objectInfo.getProperty("description").toString());
+    gui->setTooltip(cnv->pd->objectLibrary->getObjectInfo(type).getProperty("description").toString());
 
     // Check pd library for pddp tooltips, those have priority
-    auto ioletTooltips = cnv->pd->objectLibrary->parseIoletTooltips(objectInfo.getChildWithName("iolets"), gui->getText(), numInputs, numOutputs);
+    auto const& ioletTooltips = cnv->pd->objectLibrary->getIoletTooltips(type, gui->getText(), numInputs, numOutputs);
 
     // First clear all tooltips, so we can see later if it has already been set or not
     for (auto iolet : iolets) {
@@ -625,7 +818,7 @@ void Object::updateTooltips()
     for (int i = 0; i < iolets.size(); i++) {
         auto* iolet = iolets[i];
 
-        auto& tooltip = ioletTooltips[!iolet->isInlet][iolet->isInlet ? i : i - numInputs];
+        auto const& tooltip = ioletTooltips[!iolet->isInlet][iolet->isInlet ? i : i - numInputs];
 
         // Don't overwrite custom documentation
         if (tooltip.isNotEmpty()) {
@@ -724,8 +917,9 @@ void Object::updateIolets()
         numOutputs = pd::Interface::numOutlets(ptr);
     }
     
-    // Looking up tooltips takes a bit of time, so we make sure we're not constantly updating them for no reason
-    bool tooltipsNeedUpdate = gui->getPatch() != nullptr || numInputs != oldNumInputs || numOutputs != oldNumOutputs;
+    // Looking up tooltips takes a bit of time, so we only mark them here, and update them when the mouse first enters the object
+    if (gui->getPatch() != nullptr || numInputs != oldNumInputs || numOutputs != oldNumOutputs)
+        tooltipsNeedUpdate = true;
 
     for (auto* iolet : iolets) {
         if (gui && !iolet->isInlet) {
@@ -767,7 +961,6 @@ void Object::updateIolets()
         numOut += !input;
     }
 
-    if(tooltipsNeedUpdate) updateTooltips();
     resized();
 }
 
@@ -834,7 +1027,7 @@ void Object::mouseUp(MouseEvent const& e)
 
     if (ds.wasResized) {
 
-        cnv->objectGrid.clearIndicators(false);
+        cnv->objectGrid.endDrag();
 
         applyBounds();
 
@@ -865,8 +1058,8 @@ void Object::mouseUp(MouseEvent const& e)
         cnv->updateSidebarSelection();
 
         if (ds.didStartDragging) {
-            cnv->objectGrid.clearIndicators(false);
-            applyBounds();
+            cnv->objectGrid.endDrag();
+            applyDrag();
             ds.didStartDragging = false;
         }
 
@@ -901,7 +1094,7 @@ void Object::mouseUp(MouseEvent const& e)
         }
 
         for (auto* object : cnv->getSelectionOfType<Object>()) {
-            object->setBufferedToImage(false);
+            object->updateBufferedToImage();
             object->repaint();
         }
 
@@ -1352,7 +1545,7 @@ void Object::openHelpPatch() const
         auto file = cnv->pd->objectLibrary->findHelpfile(ptr, cnv->patch.getCurrentFile());
 
         if (!file.existsAsFile()) {
-            cnv->pd->logMessage("Couldn't find help file");
+            cnv->pd->logMessage(FilesystemExtractor::isDocumentationReady() ? "Couldn't find help file" : "Couldn't find help file, the documentation is still being unpacked");
             return;
         }
 
@@ -11,6 +11,7 @@
 #include "Utility/SettingsFile.h"
 #include "Utility/RateReducer.h"
 #include "Pd/WeakReference.h"
+#include "Heavy/CompatibleObjects.h"
 
 #define ACTIVITY_UPDATE_RATE 15
 
@@ -40,13 +41,16 @@ public:
 
     void paint(Graphics&) override;
     void paintOverChildren(Graphics&) override;
+    void lookAndFeelChanged() override;
     void resized() override;
+    void moved() override;
 
     void updateIolets();
 
     void setType(String const& newType, pd::WeakReference existingObject = nullptr);
     void updateBounds();
     void applyBounds();
+    void applyDrag();
 
     void showEditor();
     void hideEditor();
@@ -80,6 +84,12 @@ public:
 
     void triggerOverlayActiveState();
 
+    // Static objects are drawn from a cached image, which JUCE only redraws when they repaint or the zoom changes
+    void updateBufferedToImage();
+
+    // Hides the GUI and iolets when the canvas is zoomed out too far to see them, and draws a plain rectangle instead
+    void updateLevelOfDetail();
+
     bool validResizeZone = false;
 
     Array<Rectangle<float>> getCorners() const;
@@ -109,14 +119,21 @@ public:
 
     bool isSelected() const;
 
+    hash32 getClassHash() const { return pdClassHash; }
+
+    // Tooltips are only looked up once the mouse is over the object or one of its iolets
+    void updateTooltipsIfNeeded();
+
 private:
     void initialise();
 
     void updateTooltips();
+    bool tooltipsNeedUpdate = false;
 
     void openNewObjectEditor();
 
     bool checkIfHvccCompatible();
+    void updateHeavyFootprint();
 
     void setSelected(bool shouldBeSelected);
     bool selectedFlag = false;
@@ -127,6 +144,12 @@ private:
     bool indexShown = false;
     bool isHvccCompatible = true;
 
+    // Only calculated in compiled mode, the canvas adds these up into an estimate for the whole patch
+    HeavyFootprint heavyFootprint;
+
+    // Hash of the pd class name, so the canvas can reuse this component for a new object of the same class
+    hash32 pdClassHash = 0;
+
     bool showActiveState = false;
     float activeStateAlpha = 0.0f;
 
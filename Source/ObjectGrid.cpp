@@ -26,31 +26,78 @@ ObjectGrid::ObjectGrid(Canvas* cnv)
     gridLines[1].setAlwaysOnTop(true);
 }
 
-Array<Object*> ObjectGrid::getSnappableObjects(Object* draggedObject)
+ObjectGrid::SnapTargets const& ObjectGrid::getSnapTargets(Object* draggedObject)
 {
     auto& cnv = draggedObject->cnv;
-    Array<Object*> snappable;
 
     auto scaleFactor = std::sqrt(std::abs(cnv->getTransform().getDeterminant()));
     auto viewBounds = cnv->viewport.get()->getViewArea() / scaleFactor;
 
-    for (auto* object : cnv->objects) {
-        if (draggedObject == object || object->isSelected() || !viewBounds.intersects(object->getBounds()))
-            continue; // don't look at dragged object, selected objects, or objects that are outside of view bounds
+    // Objects don't move while we drag, so we only need to look for them again if we start dragging something else, or if the view scrolled away
+    if (snapTargets.draggedObject == draggedObject && snapTargets.area.contains(viewBounds))
+        return snapTargets;
 
-        snappable.add(object);
-    }
+    snapTargets = SnapTargets();
+    snapTargets.draggedObject = draggedObject;
+
+    // Take some area around the view, so auto-scrolling while dragging doesn't need to collect them again straight away
+    snapTargets.area = viewBounds.expanded(viewBounds.getWidth() / 2, viewBounds.getHeight() / 2);
+
+    cnv->objectIndex.forEachItemIn(snapTargets.area, [this, draggedObject](Object* object) {
+        if (draggedObject == object || object->isSelected())
+            return; // don't look at dragged object or selected objects
+
+        snapTargets.objects.insert(object);
+
+        auto b = object->getBounds().reduced(Object::margin);
+        snapTargets.positions[Left].push_back({ b.getX(), b });
+        snapTargets.positions[Right].push_back({ b.getRight(), b });
+        snapTargets.positions[Top].push_back({ b.getY(), b });
+        snapTargets.positions[Bottom].push_back({ b.getBottom(), b });
+        snapTargets.positions[VerticalCentre].push_back({ b.getCentreY(), b });
+        snapTargets.positions[HorizontalCentre].push_back({ b.getCentreX(), b });
+    });
 
-    auto centre = draggedObject->getBounds().getCentre();
+    // When multiple objects share a position, prefer the one closest to the dragged object
+    auto centre = draggedObject->getBounds().reduced(Object::margin).getCentre();
+    for (auto& positions : snapTargets.positions) {
+        std::sort(positions.begin(), positions.end(), [centre](SnapPosition const& a, SnapPosition const& b) {
+            if (a.position != b.position)
+                return a.position < b.position;
 
-    std::sort(snappable.begin(), snappable.end(), [centre](Object* a, Object* b) {
-        auto distA = a->getBounds().getCentre().getDistanceFrom(centre);
-        auto distB = b->getBounds().getCentre().getDistanceFrom(centre);
+            return a.bounds.getCentre().getDistanceFrom(centre) < b.bounds.getCentre().getDistanceFrom(centre);
+        });
+    }
 
-        return distA < distB;
+    return snapTargets;
+}
+
+// Finds the closest snap position within the snapping tolerance
+ObjectGrid::SnapPosition const* ObjectGrid::findSnapPosition(std::vector<SnapPosition> const& positions, int position)
+{
+    auto it = std::lower_bound(positions.begin(), positions.end(), position, [](SnapPosition const& snapPosition, int value) {
+        return snapPosition.position < value;
     });
 
-    return snappable;
+    SnapPosition const* closest = nullptr;
+    if (it != positions.end())
+        closest = &*it;
+
+    // The previous position might be closer, if so, use the first object at that position
+    if (it != positions.begin()) {
+        auto previous = std::prev(it);
+        auto previousPosition = previous->position;
+        while (previous != positions.begin() && std::prev(previous)->position == previousPosition)
+            --previous;
+
+        if (!closest || position - previousPosition < closest->position - position)
+            closest = &*previous;
+    }
+
+    if (closest && std::abs(closest->position - position) < objectTolerance)
+        return closest;
+
+    return nullptr;
 }
 
 void ObjectGrid::propertyChanged(String const& name, var const& value)
@@ -75,7 +122,7 @@ Point<int> ObjectGrid::performMove(Object* toDrag, Point<int> dragOffset)
 
     auto [snapGrid, snapEdges, snapCentres] = std::tuple<bool, bool, bool> { gridType & 1, gridType & 2, gridType & 4 };
 
-    auto snappable = getSnappableObjects(toDrag);
+    auto const& targets = getSnapTargets(toDrag);
 
     Point<int> distance;
     Line<int> verticalIndicator, horizontalIndicator;
@@ -86,7 +133,7 @@ Point<int> ObjectGrid::performMove(Object* toDrag, Point<int> dragOffset)
         for (auto* connection : toDrag->getConnections()) {
 
             if (connection->inobj == toDrag) {
-                if (!snappable.contains(connection->outobj))
+                if (!targets.objects.count(connection->outobj))
                     continue;
 
                 auto outletBounds = connection->outobj->getBounds() + connection->outlet->getPosition();
@@ -104,7 +151,7 @@ Point<int> ObjectGrid::performMove(Object* toDrag, Point<int> dragOffset)
                 }
                 break;
             } else if (connection->outobj == toDrag) {
-                if (!snappable.contains(connection->inobj))
+                if (!targets.objects.count(connection->inobj))
                     continue;
 
                 auto inletBounds = connection->inobj->getBounds() + connection->inlet->getPosition();
@@ -129,46 +176,43 @@ Point<int> ObjectGrid::performMove(Object* toDrag, Point<int> dragOffset)
 
     bool objectSnapped = false;
     // Check for relative object snap
-    for (auto* object : snappable) {
-        auto b1 = object->getBounds().reduced(Object::margin);
-        auto topDiff = b1.getY() - desiredBounds.getY();
-        auto bottomDiff = b1.getBottom() - desiredBounds.getBottom();
-        auto leftDiff = b1.getX() - desiredBounds.getX();
-        auto rightDiff = b1.getRight() - desiredBounds.getRight();
-
-        auto vCentreDiff = b1.getCentreY() - desiredBounds.getCentreY();
-        auto hCentreDiff = b1.getCentreX() - desiredBounds.getCentreX();
-
-        if (snapEdges && std::abs(topDiff) < objectTolerance) {
-            verticalIndicator = getObjectIndicatorLine(Top, b1, desiredBounds.withY(b1.getY()));
-            distance.y = topDiff;
+    auto const* top = snapEdges ? findSnapPosition(targets.positions[Top], desiredBounds.getY()) : nullptr;
+    auto const* bottom = snapEdges ? findSnapPosition(targets.positions[Bottom], desiredBounds.getBottom()) : nullptr;
+    auto const* vCentre = snapCentres ? findSnapPosition(targets.positions[VerticalCentre], desiredBounds.getCentreY()) : nullptr;
+
+    if (top) {
+        verticalIndicator = getObjectIndicatorLine(Top, top->bounds, desiredBounds.withY(top->position));
+        distance.y = top->position - desiredBounds.getY();
+        objectSnapped = true;
+    } else if (bottom) {
+        verticalIndicator = getObjectIndicatorLine(Bottom, bottom->bounds, desiredBounds.withBottom(bottom->position));
+        distance.y = bottom->position - desiredBounds.getBottom();
+        objectSnapped = true;
+    } else if (vCentre) {
+        verticalIndicator = getObjectIndicatorLine(VerticalCentre, vCentre->bounds, desiredBounds.withCentre({ desiredBounds.getCentreX(), vCentre->position }));
+        distance.y = vCentre->position - desiredBounds.getCentreY();
+        objectSnapped = true;
+    }
+
+    // Skip horizontal snap if we've already found a connection snap
+    if (!connectionSnapped) {
+        auto const* left = snapEdges ? findSnapPosition(targets.positions[Left], desiredBounds.getX()) : nullptr;
+        auto const* right = snapEdges ? findSnapPosition(targets.positions[Right], desiredBounds.getRight()) : nullptr;
+        auto const* hCentre = snapCentres ? findSnapPosition(targets.positions[HorizontalCentre], desiredBounds.getCentreX()) : nullptr;
+
+        if (left) {
+            horizontalIndicator = getObjectIndicatorLine(Left, left->bounds, desiredBounds.withX(left->position));
+            distance.x = left->position - desiredBounds.getX();
             objectSnapped = true;
-        } else if (snapEdges && std::abs(bottomDiff) < objectTolerance) {
-            verticalIndicator = getObjectIndicatorLine(Bottom, b1, desiredBounds.withBottom(b1.getBottom()));
-            distance.y = bottomDiff;
+        } else if (right) {
+            horizontalIndicator = getObjectIndicatorLine(Right, right->bounds, desiredBounds.withRight(right->position));
+            distance.x = right->position - desiredBounds.getRight();
             objectSnapped = true;
-        } else if (snapCentres && std::abs(vCentreDiff) < objectTolerance) {
-            verticalIndicator = getObjectIndicatorLine(VerticalCentre, b1, desiredBounds.withCentre({ desiredBounds.getCentreX(), b1.getCentreY() }));
-            distance.y = vCentreDiff;
+        } else if (hCentre) {
+            horizontalIndicator = getObjectIndicatorLine(HorizontalCentre, hCentre->bounds, desiredBounds.withCentre({ hCentre->position, desiredBounds.getCentreY() }));
+            distance.x = hCentre->position - desiredBounds.getCentreX();
             objectSnapped = true;
         }
-
-        // Skip horizontal snap if we've already found a connection snap
-        if (!connectionSnapped) {
-            if (snapEdges && std::abs(leftDiff) < objectTolerance) {
-                horizontalIndicator = getObjectIndicatorLine(Left, b1, desiredBounds.withX(b1.getX()));
-                distance.x = leftDiff;
-                objectSnapped = true;
-            } else if (snapEdges && std::abs(rightDiff) < objectTolerance) {
-                horizontalIndicator = getObjectIndicatorLine(Right, b1, desiredBounds.withRight(b1.getRight()));
-                distance.x = rightDiff;
-                objectSnapped = true;
-            } else if (snapCentres && std::abs(hCentreDiff) < objectTolerance) {
-                horizontalIndicator = getObjectIndicatorLine(HorizontalCentre, b1, desiredBounds.withCentre({ b1.getCentreX(), desiredBounds.getCentreY() }));
-                distance.x = hCentreDiff;
-                objectSnapped = true;
-            }
-        }
     }
 
     // Snap to absolute grid
@@ -235,61 +279,63 @@ Point<int> ObjectGrid::performResize(Object* toDrag, Point<int> dragOffset, Rect
 
     if (snapEdges) {
         // Check for objects to relative snap to
-        for (auto* object : getSnappableObjects(toDrag)) {
-            auto b1 = object->getBounds().reduced(Object::margin);
-            float topDiff = b1.getY() - desiredBounds.getY();
-            float bottomDiff = b1.getBottom() - desiredBounds.getBottom();
-            float leftDiff = b1.getX() - desiredBounds.getX();
-            float rightDiff = b1.getRight() - desiredBounds.getRight();
-
-            if (isDraggingTop && std::abs(topDiff) < objectTolerance) {
-                verticalIndicator = getObjectIndicatorLine(Top, b1, actualBounds.withY(b1.getY()));
+        auto const& targets = getSnapTargets(toDrag);
+        auto const* top = isDraggingTop ? findSnapPosition(targets.positions[Top], desiredBounds.getY()) : nullptr;
+        auto const* bottom = isDraggingBottom ? findSnapPosition(targets.positions[Bottom], desiredBounds.getBottom()) : nullptr;
+        auto const* left = isDraggingLeft ? findSnapPosition(targets.positions[Left], desiredBounds.getX()) : nullptr;
+        auto const* right = isDraggingRight ? findSnapPosition(targets.positions[Right], desiredBounds.getRight()) : nullptr;
+
+        if (top) {
+            float topDiff = top->position - desiredBounds.getY();
+            verticalIndicator = getObjectIndicatorLine(Top, top->bounds, actualBounds.withY(top->position));
+            if (ratio != 0) {
+                if (isDraggingRight)
+                    distance.x = round(-topDiff * ratio);
+                if (isDraggingLeft)
+                    distance.x = round(topDiff * ratio);
+            }
+
+            distance.y = topDiff;
+            snapped = true;
+        } else if (bottom) {
+            float bottomDiff = bottom->position - desiredBounds.getBottom();
+            verticalIndicator = getObjectIndicatorLine(Bottom, bottom->bounds, actualBounds.withBottom(bottom->position));
+            if (ratio != 0) {
+                if (isDraggingRight)
+                    distance.x = round(bottomDiff * ratio);
+                if (isDraggingLeft)
+                    distance.x = round(-bottomDiff * ratio);
+            }
+
+            distance.y = bottomDiff;
+            snapped = true;
+        }
+        if (approximatelyEqual(ratio, 0.0) || !snapped) {
+            if (left) {
+                float leftDiff = left->position - desiredBounds.getX();
+                horizontalIndicator = getObjectIndicatorLine(Left, left->bounds, actualBounds.withX(left->position));
                 if (ratio != 0) {
-                    if (isDraggingRight)
-                        distance.x = round(-topDiff * ratio);
-                    if (isDraggingLeft)
-                        distance.x = round(topDiff * ratio);
+                    if (isDraggingBottom)
+                        distance.y = round(-leftDiff / ratio);
+                    if (isDraggingTop)
+                        distance.y = round(leftDiff / ratio);
                 }
 
-                distance.y = topDiff;
+                distance.x = leftDiff;
                 snapped = true;
-            } else if (isDraggingBottom && std::abs(bottomDiff) < objectTolerance) {
-                verticalIndicator = getObjectIndicatorLine(Bottom, b1, actualBounds.withBottom(b1.getBottom()));
+            } else if (right) {
+                float rightDiff = right->position - desiredBounds.getRight();
+                horizontalIndicator = getObjectIndicatorLine(Right, right->bounds, actualBounds.withRight(right->position));
                 if (ratio != 0) {
-                    if (isDraggingRight)
-                        distance.x = round(bottomDiff * ratio);
-                    if (isDraggingLeft)
-                        distance.x = round(-bottomDiff * ratio);
+                    if (isDraggingBottom)
+                        distance.y = round(rightDiff / ratio);
+                    if (isDraggingTop)
+                        distance.y = round(-rightDiff / ratio);
                 }
 
-                distance.y = bottomDiff;
+                distance.x = rightDiff;
                 snapped = true;
             }
-            if (approximatelyEqual(ratio, 0.0) || !snapped) {
-                if (isDraggingLeft && std::abs(leftDiff) < objectTolerance) {
-                    horizontalIndicator = getObjectIndicatorLine(Left, b1, actualBounds.withX(b1.getX()));
-                    if (ratio != 0) {
-                        if (isDraggingBottom)
-                            distance.y = round(-leftDiff / ratio);
-                        if (isDraggingTop)
-                            distance.y = round(leftDiff / ratio);
-                    }
-
-                    distance.x = leftDiff;
-                    snapped = true;
-                } else if (isDraggingRight && std::abs(rightDiff) < objectTolerance) {
-                    horizontalIndicator = getObjectIndicatorLine(Right, b1, actualBounds.withRight(b1.getRight()));
-                    if (ratio != 0) {
-                        if (isDraggingBottom)
-                            distance.y = round(rightDiff / ratio);
-                        if (isDraggingTop)
-                            distance.y = round(-rightDiff / ratio);
-                    }
-
-                    distance.x = rightDiff;
-                    snapped = true;
-                }
-            }
         }
 
         if (snapped) {
@@ -378,6 +424,12 @@ Line<int> ObjectGrid::getObjectIndicatorLine(Side side, Rectangle<int> b1, Recta
     return {};
 }
 
+void ObjectGrid::endDrag()
+{
+    clearIndicators(false);
+    snapTargets = SnapTargets();
+}
+
 void ObjectGrid::clearIndicators(bool fast)
 {
     gridLineAnimator.fadeOut(&gridLines[0], fast ? 20 : 125);
@@ -21,6 +21,9 @@ struct ObjectGrid : public SettingsFileListener {
 
     void clearIndicators(bool fast);
 
+    // Called when a drag or resize ends, clears the indicators and the snap positions that were collected for it
+    void endDrag();
+
 private:
     enum Side {
         Left,
@@ -31,9 +34,26 @@ private:
         HorizontalCentre,
     };
 
+    // Position of an edge or centre of an object that we can snap to, together with the bounds of that object
+    struct SnapPosition {
+        int position;
+        Rectangle<int> bounds;
+    };
+
+    // Snap positions of all objects that we can snap to, sorted by position for every side
+    // These are collected once when a drag starts and stay valid until the drag ends, unless the view moves too far away
+    struct SnapTargets {
+        Object* draggedObject = nullptr;
+        Rectangle<int> area;
+        std::unordered_set<Object*> objects;
+        std::array<std::vector<SnapPosition>, 6> positions;
+    };
+
     void propertyChanged(String const& name, var const& value) override;
 
-    Array<Object*> getSnappableObjects(Object* draggedObject);
+    SnapTargets const& getSnapTargets(Object* draggedObject);
+
+    static SnapPosition const* findSnapPosition(std::vector<SnapPosition> const& positions, int position);
 
     void setIndicator(int idx, Line<int> line, float lineScale);
 
@@ -47,4 +67,6 @@ private:
 
     int gridType;
     bool gridEnabled;
+
+    SnapTargets snapTargets;
 };
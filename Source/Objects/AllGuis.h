@@ -62,6 +62,13 @@ struct t_fake_button {
     unsigned char x_fgcolor[3];
 };
 
+// [dac~] and [adc~]
+struct t_fake_dac {
+    t_object x_obj;
+    t_int x_n;    /* number of channels */
+    t_int* x_vec; /* channel numbers, starting from 1 */
+};
+
 // [clone]
 struct t_fake_clone {
     t_object x_obj;
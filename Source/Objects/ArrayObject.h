@@ -11,10 +11,15 @@ void garray_arraydialog(t_fake_garray* x, t_symbol* name, t_floatarg fsize, t_fl
 }
 
 
-class GraphicalArray : public Component, public Value::Listener, public pd::MessageListener {
+class GraphicalArray : public Component, public Value::Listener, public pd::MessageListener, public FileDragAndDropTarget, private Timer {
 public:
     Object* object;
 
+    struct MinMax {
+        float min;
+        float max;
+    };
+
     enum DrawType {
         Points,
         Polygon,
@@ -36,12 +41,13 @@ public:
         , pd(instance)
     {
         vec.reserve(8192);
-        temp.reserve(8192);
+        pd->arrayChanges.getChangesSince(arr.getRawUnchecked<void>(), lastArrayChange);
         try {
-            read(vec);
+            readChanges({ 0, pd::ArrayChangeTracker::wholeArray });
         } catch (...) {
             error = true;
         }
+        updatePyramid(0, vec.size());
         
         updateParameters();
         
@@ -76,25 +82,91 @@ public:
         new (&arr) pd::WeakReference(array, pd);
     }
 
-    std::vector<float> rescale(std::vector<float> const& v, unsigned const newSize)
+    // Updates the minimum and maximum of all blocks in the pyramid that contain the samples from start to end
+    void updatePyramid(size_t start, size_t end)
     {
-        if (v.empty()) {
-            return {};
+        // Make sure we have the right amount of levels, with the right sizes
+        size_t numLevels = 0;
+        bool sizesChanged = false;
+        for (size_t levelSize = (vec.size() + 1) / 2; vec.size() > 1; levelSize = (levelSize + 1) / 2) {
+            if (pyramid.size() <= numLevels) {
+                pyramid.emplace_back();
+            }
+            if (pyramid[numLevels].size() != levelSize) {
+                pyramid[numLevels].resize(levelSize);
+                sizesChanged = true;
+            }
+
+            numLevels++;
+            if (levelSize == 1)
+                break;
+        }
+
+        if (pyramid.size() != numLevels) {
+            pyramid.resize(numLevels);
+            sizesChanged = true;
+        }
+
+        if (sizesChanged) {
+            start = 0;
+            end = vec.size();
+        }
+
+        for (size_t level = 0; level < pyramid.size() && start < end; level++) {
+            auto& blocks = pyramid[level];
+            auto const numChildren = level == 0 ? vec.size() : pyramid[level - 1].size();
+
+            start /= 2;
+            end = std::min((end + 1) / 2, blocks.size());
+
+            for (size_t i = start; i < end; i++) {
+                auto block = getBlock(level, i * 2);
+                if (i * 2 + 1 < numChildren) {
+                    auto const second = getBlock(level, i * 2 + 1);
+                    block.min = std::min(block.min, second.min);
+                    block.max = std::max(block.max, second.max);
+                }
+                blocks[i] = block;
+            }
         }
+    }
+
+    // Returns a block from the level below the given level of the pyramid, where the level below the first level are the samples themselves
+    MinMax getBlock(size_t levelAbove, size_t index) const
+    {
+        if (levelAbove == 0)
+            return { vec[index], vec[index] };
 
-        std::vector<float> result(newSize);
-        const std::size_t oldSize = v.size();
-        for (unsigned i = 0; i < newSize; i++) {
-            auto const idx = i * (oldSize - 1) / newSize;
-            auto const mod = i * (oldSize - 1) % newSize;
+        return pyramid[levelAbove - 1][index];
+    }
 
-            if (mod == 0)
-                result[i] = v[idx];
-            else {
-                float const part = float(mod) / float(newSize);
-                result[i] = v[idx] * (1.0 - part) + v[idx + 1] * part;
+    // Returns the minimum and maximum of the samples from first to last (inclusive), by combining the largest blocks that fit inside that range
+    MinMax getMinMax(size_t first, size_t last) const
+    {
+        MinMax result { vec[first], vec[first] };
+        auto const add = [&result](MinMax const& block) {
+            result.min = std::min(result.min, block.min);
+            result.max = std::max(result.max, block.max);
+        };
+
+        for (size_t level = 0; first <= last; level++) {
+            if (first & 1)
+                add(getBlock(level, first++));
+
+            if (first <= last && !(last & 1)) {
+                add(getBlock(level, last));
+                if (last == 0)
+                    break;
+                last--;
             }
+
+            if (first > last || level >= pyramid.size())
+                break;
+
+            first /= 2;
+            last /= 2;
         }
+
         return result;
     }
 
@@ -102,7 +174,7 @@ public:
     {
         auto const h = static_cast<float>(getHeight());
         auto const w = static_cast<float>(getWidth());
-        std::vector<float> points = vec;
+        auto const& points = vec;
 
         if (!points.empty()) {
             std::array<float, 2> scale = getScale();
@@ -113,13 +185,35 @@ public:
                 std::swap(scale[0], scale[1]);
             }
 
+            float const dh = h / (scale[1] - scale[0]);
+
             // More than a point per pixel will cause insane loads, and isn't actually helpful
-            // Instead, linearly interpolate the vector to a max size of width in pixels
-            if (vec.size() >= w) {
-                points = rescale(points, w);
+            // Instead, draw the range of values that falls within each pixel column, so peaks don't get lost
+            if (points.size() >= w) {
+                auto const numColumns = static_cast<size_t>(w);
+                auto const lineWidth = getLineWidth();
+
+                Path p;
+                for (size_t x = 0; x < numColumns; x++) {
+                    // Include the first sample of the next column, so neighbouring columns connect
+                    auto const first = x * points.size() / numColumns;
+                    auto const last = std::min((x + 1) * points.size() / numColumns, points.size() - 1);
+
+                    auto const [min, max] = getMinMax(first, std::max(first, last));
+                    float const top = h - (std::clamp(max, scale[0], scale[1]) - scale[0]) * dh;
+                    float const bottom = h - (std::clamp(min, scale[0], scale[1]) - scale[0]) * dh;
+
+                    p.addRectangle(static_cast<float>(x), top - lineWidth / 2.0f, 1.0f, bottom - top + lineWidth);
+                }
+
+                if (invert)
+                    p.applyTransform(AffineTransform::verticalFlip(getHeight()));
+
+                g.setColour(getContentColour());
+                g.fillPath(p);
+                return;
             }
 
-            float const dh = h / (scale[1] - scale[0]);
             float const dw = w / static_cast<float>(points.size() - 1);
 
             switch (getDrawType()) {
@@ -246,6 +340,10 @@ public:
         } else {
             paintGraph(g);
         }
+
+        if (soundFileLoader) {
+            Fonts::drawText(g, "Loading soundfile...", 0, 0, getWidth(), getHeight(), object->findColour(PlugDataColour::canvasTextColourId), 15, Justification::centred);
+        }
     }
 
     void mouseDown(MouseEvent const& e) override
@@ -261,6 +359,9 @@ public:
         lastIndex = std::round(std::clamp(x / w, 0.f, 1.f) * s);
 
         mouseDrag(e);
+
+        // Edits are collected while dragging, and written to the array once per frame
+        startTimerHz(60);
     }
 
     void mouseDrag(MouseEvent const& e) override
@@ -292,21 +393,13 @@ public:
             vec[n] = jmap<float>(n, interpStart, interpEnd + 1, min, max);
         }
 
-        // Don't want to touch vec on the other thread, so we copy the vector into the lambda
-        auto changed = std::vector<float>(vec.begin() + interpStart, vec.begin() + interpEnd + 1);
-
         lastIndex = index;
 
-        pd->lockAudioThread();
-        for (int n = 0; n < changed.size(); n++) {
-            write(interpStart + n, changed[n]);
-        }
+        updatePyramid(interpStart, interpEnd + 1);
 
-        if (auto ptr = arr.get<t_fake_garray>()) {
-            pd->sendDirectMessage(ptr.get(), stringArray);
-        }
+        auto const editedRange = Range<size_t>(interpStart, interpEnd + 1);
+        pendingEdit = pendingEdit.isEmpty() ? editedRange : pendingEdit.getUnionWith(editedRange);
 
-        pd->unlockAudioThread();
         repaint();
     }
 
@@ -314,34 +407,65 @@ public:
     {
         if (error || !getEditMode())
             return;
-        
-        if (auto ptr = arr.get<t_fake_garray>()) {
-            plugdata_forward_message(ptr->x_glist, gensym("redraw"), 0, NULL);
-        }
-        
+
+        stopTimer();
+        commitPendingEdit(true);
+
         edited = false;
     }
 
+    bool isInterestedInFileDrag(StringArray const& files) override
+    {
+        return files.size() == 1 && ArraySoundFileLoader::isSoundFile(File(files[0]));
+    }
+
+    // Loads a dropped soundfile into the array in the background
+    void filesDropped(StringArray const& files, int x, int y) override
+    {
+        soundFileLoader = std::make_unique<ArraySoundFileLoader>(pd, arr, File(files[0]), [_this = SafePointer(this), file = File(files[0])](bool success) {
+            if (!_this)
+                return;
+
+            if (!success) {
+                _this->pd->logError("Couldn't read soundfile: " + file.getFullPathName());
+            }
+
+            _this->soundFileLoader.reset(nullptr);
+            _this->repaint();
+        });
+
+        repaint();
+    }
+
     void update()
     {
+        auto changedRange = pd->arrayChanges.getChangesSince(arr.getRawUnchecked<void>(), lastArrayChange);
+
         // Check if size has changed
         int currentSize = getArraySize();
         if (vec.size() != currentSize) {
             vec.resize(currentSize);
+            updatePyramid(0, vec.size());
+            changedRange = { 0, pd::ArrayChangeTracker::wholeArray };
         }
         
         size = currentSize;
 
+        // Nothing was written to the array since we last read it
+        if (changedRange.isEmpty())
+            return;
+
         if (!edited) {
             error = false;
+            Range<size_t> changed;
             try {
-                read(temp);
+                changed = readChanges(changedRange);
             } catch (...) {
                 error = true;
             }
-            if (temp != vec) {
-                vec.swap(temp);
-                repaint();
+            if (!changed.isEmpty()) {
+                updatePyramid(changed.getStart(), changed.getEnd());
+                object->cnv->repaintCoordinator.repaint(this);
             }
         }
     }
@@ -556,35 +680,100 @@ public:
         }
     }
 
-    // Gets the values from the array.
-    void read(std::vector<float>& output) const
+    // Gets the values within the range from the array, and returns the range of values that actually changed since the last read
+    Range<size_t> readChanges(Range<size_t> rangeToRead)
     {
+        size_t firstChanged = vec.size(), lastChanged = 0;
+
         if (auto ptr = arr.get<t_garray>()) {
-            int const size = garray_getarray(ptr.get())->a_n;
-            output.resize(static_cast<size_t>(size));
+            auto const size = static_cast<size_t>(garray_getarray(ptr.get())->a_n);
+            if (vec.size() != size) {
+                vec.resize(size);
+                firstChanged = 0;
+                lastChanged = size;
+                rangeToRead = { 0, size };
+            }
 
-            t_word* vec = ((t_word*)garray_vec(ptr.get()));
-            for (int i = 0; i < size; i++)
-                output[i] = vec[i].w_float;
+            t_word* words = ((t_word*)garray_vec(ptr.get()));
+            for (size_t i = rangeToRead.getStart(); i < std::min(rangeToRead.getEnd(), size); i++) {
+                if (vec[i] != words[i].w_float) {
+                    vec[i] = words[i].w_float;
+                    firstChanged = std::min(firstChanged, i);
+                    lastChanged = std::max(lastChanged, i + 1);
+                }
+            }
         }
+
+        if (firstChanged >= lastChanged)
+            return {};
+
+        return { firstChanged, lastChanged };
     }
 
-    // Writes a value to the array.
-    void write(const size_t pos, float const input)
+    // Runs once per frame while dragging, and sends the samples that were edited since the last frame
+    void timerCallback() override
     {
-        if (auto ptr = arr.get<t_garray>()) {
-            t_word* vec = ((t_word*)garray_vec(ptr.get()));
-            vec[pos].w_float = input;
+        commitPendingEdit(false);
+    }
+
+    // Sends the samples that were edited since the last commit to pd in one go, so the audio thread is never locked from here
+    // If notifyGlist is true, the glist gets a redraw message after the samples were written, so all views of the array will update
+    void commitPendingEdit(bool notifyGlist)
+    {
+        if (pendingEdit.isEmpty() && !notifyGlist)
+            return;
+
+        auto const start = pendingEdit.getStart();
+        auto const end = std::min(pendingEdit.getEnd(), vec.size());
+        pendingEdit = {};
+
+        // Let other views of this array know what changed, we already have these values ourselves
+        // This happens before pd has written the samples, the redraw we send on mouse up makes the other views read them again
+        if (end > start) {
+            auto const changeCounter = pd->arrayChanges.markChanged(arr.getRawUnchecked<void>(), start, end);
+            if (lastArrayChange == changeCounter - 1)
+                lastArrayChange = changeCounter;
         }
+
+        // Don't want to touch vec on the other thread, so we copy the edited span into the lambda
+        auto changed = std::vector<float>(vec.begin() + start, vec.begin() + std::max(start, end));
+
+        pd->enqueueFunctionAsync([instance = pd, array = arr, start, changed = std::move(changed), notifyGlist]() {
+            auto ptr = array.get<t_fake_garray>();
+            if (!ptr)
+                return;
+
+            auto* garray = ptr.cast<t_garray>();
+            auto const arraySize = static_cast<size_t>(garray_getarray(garray)->a_n);
+            auto* words = ((t_word*)garray_vec(garray));
+            auto const numToWrite = std::min(changed.size(), arraySize - std::min(start, arraySize));
+            for (size_t n = 0; n < numToWrite; n++) {
+                words[start + n].w_float = changed[n];
+            }
+
+            if (numToWrite) {
+                instance->sendDirectMessage(ptr.get(), "array");
+            }
+            if (notifyGlist) {
+                plugdata_forward_message(ptr->x_glist, gensym("redraw"), 0, NULL);
+            }
+        });
     }
 
     pd::WeakReference arr;
 
     std::vector<float> vec;
-    std::vector<float> temp;
+    uint32 lastArrayChange = 0;
+
+    // Minimum and maximum values of the array in blocks of 2, 4, 8, ... samples, so we can draw large arrays at the cost of the number of pixels
+    std::vector<std::vector<MinMax>> pyramid;
     std::atomic<bool> edited;
     bool error = false;
-    const String stringArray = "array";
+
+    // Range of samples that were edited but not yet sent to pd
+    Range<size_t> pendingEdit;
+
+    std::unique_ptr<ArraySoundFileLoader> soundFileLoader;
 
     int lastIndex = 0;
 
@@ -747,7 +936,7 @@ struct ArrayPropertiesPanel : public PropertiesPanelProperty, public Value::List
 class ArrayListView : public PropertiesPanel, public Value::Listener
 {
 public:
-    ArrayListView(pd::Instance* instance, void* arr) : array(arr, instance)
+    ArrayListView(pd::Instance* instance, void* arr) : array(arr, instance), pd(instance)
     {
         update();
     }
@@ -759,6 +948,25 @@ public:
     
     void update()
     {
+        auto changedRange = pd->arrayChanges.getChangesSince(array.getRawUnchecked<void>(), lastArrayChange);
+        if (changedRange.isEmpty())
+            return;
+
+        // If the size is still the same, we only need to update the values that changed
+        if (auto ptr = array.get<t_fake_garray>()) {
+            auto* arr = garray_getarray(ptr.cast<t_garray>());
+            if (arr->a_n == arrayValues.size()) {
+                auto* vec = ((t_word*)garray_vec(ptr.cast<t_garray>()));
+                auto const end = std::min<size_t>(changedRange.getEnd(), arrayValues.size());
+
+                ScopedValueSetter<bool> updating(isUpdating, true);
+                for (auto i = changedRange.getStart(); i < end; i++) {
+                    arrayValues[i]->setValue(vec[i].w_float);
+                }
+                return;
+            }
+        }
+
         clear();
         arrayValues.clear();
         
@@ -797,6 +1005,9 @@ public:
 private:
     void valueChanged(Value& v) override
     {
+        if (isUpdating)
+            return;
+
         if (auto ptr = array.get<t_fake_garray>()) {
             auto* vec = ((t_word*)garray_vec(ptr.cast<t_garray>()));
             
@@ -806,6 +1017,10 @@ private:
                 if(v.refersToSameSourceAs(value))
                 {
                     vec[i].w_float = getValue<float>(value);
+
+                    auto const changeCounter = pd->arrayChanges.markChanged(array.getRawUnchecked<void>(), i, i + 1);
+                    if (lastArrayChange == changeCounter - 1)
+                        lastArrayChange = changeCounter;
                     break;
                 }
             }
@@ -814,6 +1029,9 @@ private:
     
     OwnedArray<Value> arrayValues;
     pd::WeakReference array;
+    pd::Instance* pd;
+    uint32 lastArrayChange = 0;
+    bool isUpdating = false;
 };
 
 class ArrayEditorDialog : public Component {
@@ -1250,6 +1468,11 @@ public:
         switch(symbol)
         {
             case hash("redraw"): {
+                // pd doesn't tell us which part of the array was redrawn, so all views need to check the whole array
+                for (auto* graph : graphs) {
+                    pd->arrayChanges.markChanged(graph->arr.getRawUnchecked<void>());
+                }
+
                 updateGraphs();
                 if (dialog) {
                     dialog->updateGraphs();
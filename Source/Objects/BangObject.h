@@ -4,8 +4,14 @@
  // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
  */
 
-class BangObject final : public ObjectBase {
+class BangObject final : public ObjectBase
+    , public GuiRefreshScheduler::Client {
+
+    SharedResourcePointer<GuiRefreshScheduler> refreshScheduler;
+
     uint32_t lastBang = 0;
+    uint32_t releaseTime = 0;
+    bool isWaitingForRelease = false;
 
     Value bangInterrupt = SynchronousValue(100.0f);
     Value bangHold = SynchronousValue(40.0f);
@@ -32,6 +38,11 @@ public:
         iemHelper.addIemParameters(objectParameters, true, true, 17, 7);
     }
 
+    ~BangObject() override
+    {
+        refreshScheduler->removeClient(this);
+    }
+
     void update() override
     {
         if (auto bng = ptr.get<t_bng>()) {
@@ -93,8 +104,8 @@ public:
             return;
 
         //startEdition();
-        pd->enqueueFunctionAsync<t_pd>(ptr, [](t_pd* bng){
-            pd_bang(bng);
+        pd->enqueueCommand(ptr, [](void* bng, float, float) {
+            pd_bang(static_cast<t_pd*>(bng));
         });
         //stopEdition();
 
@@ -135,7 +146,7 @@ public:
             return;
 
         bangState = true;
-        repaint();
+        cnv->repaintCoordinator.repaint(this);
 
         auto currentTime = Time::getCurrentTime().getMillisecondCounter();
         auto timeSinceLast = currentTime - lastBang;
@@ -150,19 +161,28 @@ public:
         }
 
         lastBang = currentTime;
+        releaseTime = currentTime + holdTime;
+
+        // Turn the flash off from the shared refresh timer, instead of starting a timer for every bang
+        // This also needs to happen when we're not visible, otherwise the bang would still be lit when it comes back into view
+        if (!isWaitingForRelease) {
+            isWaitingForRelease = true;
+            refreshScheduler->addClient(this, this, 0, false);
+        }
+    }
+
+    void refresh() override
+    {
+        if (Time::getMillisecondCounter() < releaseTime)
+            return;
 
-        auto deletionChecker = SafePointer(this);
-        Timer::callAfterDelay(holdTime,
-            [deletionChecker, this]() mutable {
-                // First check if this object still exists
-                if (!deletionChecker)
-                    return;
-
-                if (bangState) {
-                    bangState = false;
-                    repaint();
-                }
-            });
+        isWaitingForRelease = false;
+        refreshScheduler->removeClient(this);
+
+        if (bangState) {
+            bangState = false;
+            cnv->repaintCoordinator.repaint(this);
+        }
     }
 
     void updateSizeProperty() override
@@ -12,7 +12,7 @@ class CommentObject final : public ObjectBase
 
     Value sizeProperty = SynchronousValue();
         
-    TextLayout textLayout;
+    std::shared_ptr<TextLayout const> textLayout = std::make_shared<TextLayout const>();
     hash32 layoutTextHash = 0;
     int lastTextWidth = 0;
     int32 lastColourARGB = 0;
@@ -36,6 +36,11 @@ public:
         return true;
     }
 
+    bool canBeBufferedToImage() override
+    {
+        return editor == nullptr;
+    }
+
     void update() override
     {
         objectText = getText().trimEnd();
@@ -53,7 +58,7 @@ public:
         
         if (!editor) {
             auto textArea = border.subtractedFrom(getLocalBounds());
-            textLayout.draw(g, textArea.toFloat());
+            textLayout->draw(g, textArea.toFloat());
         }
     }
 
@@ -98,6 +103,7 @@ public:
 
             setSymbol(objectText);
             repaint();
+            object->updateBufferedToImage();
         }
     }
 
@@ -129,6 +135,7 @@ public:
 
             resized();
             repaint();
+            object->updateBufferedToImage();
         }
     }
 
@@ -139,12 +146,12 @@ public:
             int x = 0, y = 0, w, h;
             if (auto obj = ptr.get<t_gobj>()) {
                 auto* cnvPtr = cnv->patch.getPointer().get();
-                if (!cnvPtr) return {x, y, getTextObjectWidth(), std::max<int>(textLayout.getHeight() + 6, 21)};
+                if (!cnvPtr) return {x, y, getTextObjectWidth(), std::max<int>(textLayout->getHeight() + 6, 21)};
         
                 pd::Interface::getObjectBounds(cnvPtr, obj.get(), &x, &y, &w, &h);
             }
 
-            return {x, y, getTextObjectWidth(), std::max<int>(textLayout.getHeight() + 6, 21)};
+            return {x, y, getTextObjectWidth(), std::max<int>(textLayout->getHeight() + 6, 21)};
         }
             
         int getTextObjectWidth()
@@ -185,13 +192,7 @@ public:
             auto colour = object->findColour(PlugDataColour::canvasTextColourId);
             if(layoutTextHash != currentLayoutHash || colour.getARGB() != lastColourARGB || textWidth != lastTextWidth)
             {
-                auto attributedText = AttributedString(objText);
-                attributedText.setColour(colour);
-                attributedText.setJustification(Justification::centredLeft);
-                attributedText.setFont(Font(15));
-                
-                textLayout = TextLayout();
-                textLayout.createLayout(attributedText, textWidth);
+                textLayout = TextLayoutCache::getLayout(objText, Font(15), colour, Justification::centredLeft, textWidth);
                 layoutTextHash = currentLayoutHash;
                 lastColourARGB = colour.getARGB();
                 lastTextWidth = textWidth;
@@ -15,8 +15,33 @@ class GraphOnParent final : public ObjectBase {
     Value yRange = SynchronousValue();
     Value sizeProperty = SynchronousValue();
 
+    // Turns off the cached image of the graph while the user is clicking or dragging inside of it
+    // Every mouse drag would otherwise redraw the cached image and then the graph, instead of only the graph
+    struct InteractionListener : public MouseListener {
+        explicit InteractionListener(GraphOnParent* graph)
+            : parent(graph)
+        {
+        }
+
+        void mouseDown(MouseEvent const& e) override
+        {
+            parent->setInteracting(true);
+        }
+
+        void mouseUp(MouseEvent const& e) override
+        {
+            parent->setInteracting(false);
+        }
+
+        GraphOnParent* parent;
+    };
+
+    bool isInteracting = false;
+    InteractionListener interactionListener = InteractionListener(this);
+
     pd::Patch::Ptr subpatch;
     std::unique_ptr<Canvas> canvas;
+    bool canvasCreationPending = false;
 
 public:
     // Graph On Parent
@@ -186,13 +211,9 @@ public:
 
     void updateCanvas()
     {
-        if (!canvas) {
-            canvas = std::make_unique<Canvas>(cnv->editor, subpatch, this);
-
-            // Make sure that the graph doesn't become the current canvas
-            cnv->patch.setCurrent();
-            cnv->editor->updateCommandStatus();
-        }
+        // The contents of the graph are only created once it gets drawn, see paint()
+        if (!canvas)
+            return;
 
         auto b = getPatch()->getBounds() + canvas->canvasOrigin;
         canvas->setBounds(-b.getX(), -b.getY(), b.getWidth() + b.getX(), b.getHeight() + b.getY());
@@ -210,9 +231,48 @@ public:
         canvas->updateDrawables();
     }
 
+    void createCanvas()
+    {
+        canvas = std::make_unique<Canvas>(cnv->editor, subpatch, this);
+
+        // Make sure that the graph doesn't become the current canvas
+        cnv->patch.setCurrent();
+        cnv->editor->updateCommandStatus();
+
+        canvas->addMouseListener(&interactionListener, true);
+
+        updateCanvas();
+
+        // Now that the contents exist, the object can draw them from a cached image
+        object->updateBufferedToImage();
+    }
+
+    // The contents of the graph are drawn from a cached image, which only gets redrawn when an object inside of it repaints
+    // Graphs are mostly used for control panels that rarely change, so this saves us from painting all nested objects on every repaint of the parent canvas
+    bool canBeBufferedToImage() override
+    {
+        return canvas != nullptr && !isInteracting;
+    }
+
+    void setInteracting(bool interacting)
+    {
+        isInteracting = interacting;
+        object->updateBufferedToImage();
+    }
+
     // override to make transparent
     void paint(Graphics& g) override
     {
+        // Creating all objects inside a graph is expensive, so we wait until the graph is actually on screen.
+        // This keeps graphs that are scrolled out of view, or nested inside other graphs, from slowing down opening a patch
+        if (!canvas && !canvasCreationPending) {
+            canvasCreationPending = true;
+            MessageManager::callAsync([_this = SafePointer(this)]() {
+                if (_this && !_this->canvas)
+                    _this->createCanvas();
+            });
+        }
+
         // Strangly, the title goes below the graph content in pd
         if (!getValue<bool>(hideNameAndArgs) && getText() != "graph") {
             auto text = getText();
@@ -40,27 +40,12 @@ ImplementationBase::~ImplementationBase() = default;
 
 Canvas* ImplementationBase::getMainCanvas(t_canvas* patchPtr, bool alsoSearchRoot) const
 {
-    auto editors = pd->getEditors();
-
-    for (auto* editor : editors) {
-        for (auto* cnv : editor->canvases) {
-            auto glist = cnv->patch.getPointer();
-            if (glist && glist.get() == patchPtr) {
-                return cnv;
-            }
-        }
+    if (auto* cnv = pd->getCanvasForPatch(patchPtr)) {
+        return cnv;
     }
 
     if (alsoSearchRoot) {
-        patchPtr = glist_getcanvas(patchPtr);
-        for (auto* editor : editors) {
-            for (auto* cnv : editor->canvases) {
-                auto glist = cnv->patch.getPointer();
-                if (glist && glist.get() == patchPtr) {
-                    return cnv;
-                }
-            }
-        }
+        return pd->getCanvasForPatch(glist_getcanvas(patchPtr));
     }
 
     return nullptr;
@@ -179,66 +164,124 @@ ObjectImplementationManager::ObjectImplementationManager(pd::Instance* processor
 
 void ObjectImplementationManager::handleAsyncUpdate()
 {
-    Array<std::pair<t_canvas*, t_gobj*>> allImplementations;
-
     pd->setThis();
 
+    std::vector<t_canvas*> rootPatches;
+
     pd->lockAudioThread();
     for (auto* cnv = pd_getcanvaslist(); cnv; cnv = cnv->gl_next) {
-        for (auto* object : getImplementationsForPatch(cnv)) {
-            allImplementations.add({ cnv, object });
-        }
+        rootPatches.push_back(cnv);
     }
     pd->unlockAudioThread();
 
-    // Remove unused object implementations
-    for (auto it = objectImplementations.cbegin(); it != objectImplementations.cend();) {
-        auto& [ptr, implementation] = *it;
-
-        auto found = std::find_if(allImplementations.begin(), allImplementations.end(), [ptr = ptr](auto const& toCompare) {
-            return std::get<1>(toCompare) == ptr;
-        });
-
-        if (found == allImplementations.end()) {
-            objectImplementations.erase(it++);
+    // Remove the implementations of patches that have been closed
+    for (auto it = implementationsByRootPatch.begin(); it != implementationsByRootPatch.end();) {
+        if (std::find(rootPatches.begin(), rootPatches.end(), it->first) == rootPatches.end()) {
+            for (auto* obj : it->second) {
+                objectImplementations.erase(obj);
+            }
+            it = implementationsByRootPatch.erase(it);
         } else {
             it++;
         }
     }
 
-    for (auto& [cnv, obj] : allImplementations) {
-        if (!objectImplementations.count(obj)) {
+    // Only rescan the patches that have changed, or that we haven't seen before
+    for (auto* rootPatch : rootPatches) {
+        if (allPatchesChanged || changedRootPatches.count(rootPatch) || !implementationsByRootPatch.count(rootPatch)) {
+            updateImplementationsForRootPatch(rootPatch);
+        }
+    }
+
+    changedRootPatches.clear();
+    allPatchesChanged = false;
+}
+
+void ObjectImplementationManager::updateImplementationsForRootPatch(t_canvas* rootPatch)
+{
+    Array<t_gobj*> implementations;
+
+    // Only hold the audio lock while reading from pd, not while creating and updating the implementations
+    pd->lockAudioThread();
 
+    // The patch could have been closed since we collected the list of patches
+    bool patchExists = false;
+    for (auto* cnv = pd_getcanvaslist(); cnv; cnv = cnv->gl_next) {
+        if (cnv == rootPatch) {
+            patchExists = true;
+            break;
+        }
+    }
+
+    if (patchExists) {
+        getImplementationsForPatch(rootPatch, implementations);
+    }
+
+    pd->unlockAudioThread();
+
+    std::unordered_set<t_gobj*> currentImplementations;
+    currentImplementations.reserve(implementations.size());
+    for (auto* obj : implementations) {
+        currentImplementations.insert(obj);
+    }
+
+    // Remove unused object implementations
+    if (auto previous = implementationsByRootPatch.find(rootPatch); previous != implementationsByRootPatch.end()) {
+        for (auto* obj : previous->second) {
+            if (!currentImplementations.count(obj)) {
+                objectImplementations.erase(obj);
+            }
+        }
+    }
+
+    if (!patchExists) {
+        implementationsByRootPatch.erase(rootPatch);
+        return;
+    }
+
+    for (auto* obj : implementations) {
+        auto& implementation = objectImplementations[obj];
+        if (!implementation) {
             auto const name = String::fromUTF8(pd::Interface::getObjectClassName(&obj->g_pd));
 
-            objectImplementations[obj] = std::unique_ptr<ImplementationBase>(ImplementationBase::createImplementation(name, obj, cnv, pd));
+            implementation = std::unique_ptr<ImplementationBase>(ImplementationBase::createImplementation(name, obj, rootPatch, pd));
         }
 
-        objectImplementations[obj]->update();
+        implementation->update();
     }
+
+    implementationsByRootPatch[rootPatch] = std::vector<t_gobj*>(implementations.begin(), implementations.end());
 }
 
-void ObjectImplementationManager::updateObjectImplementations()
+void ObjectImplementationManager::updateObjectImplementations(t_canvas* changedPatch)
 {
+    if (changedPatch) {
+        auto* rootPatch = changedPatch;
+        while (rootPatch->gl_owner) {
+            rootPatch = rootPatch->gl_owner;
+        }
+        changedRootPatches.insert(rootPatch);
+    } else {
+        allPatchesChanged = true;
+    }
+
     triggerAsyncUpdate();
 }
 
-Array<t_gobj*> ObjectImplementationManager::getImplementationsForPatch(t_canvas* patch)
+void ObjectImplementationManager::getImplementationsForPatch(t_canvas* patch, Array<t_gobj*>& implementations)
 {
-    Array<t_gobj*> implementations;
-
     auto* glist = static_cast<t_glist*>(patch);
     for (t_gobj* y = glist->gl_list; y; y = y->g_next) {
 
         auto const* name = pd::Interface::getObjectClassName(&y->g_pd);
 
         if (pd_class(&y->g_pd) == canvas_class) {
-            implementations.addArray(getImplementationsForPatch(reinterpret_cast<t_canvas*>(y)));
+            getImplementationsForPatch(reinterpret_cast<t_canvas*>(y), implementations);
         }
         if (pd_class(&y->g_pd) == clone_class) {
             for (int i = 0; i < clone_get_n(y); i++) {
                 auto* clone = clone_get_instance(y, i);
-                implementations.addArray(getImplementationsForPatch(clone));
+                getImplementationsForPatch(clone, implementations);
                 implementations.add(&clone->gl_obj.te_g);
             }
         }
@@ -246,12 +289,13 @@ Array<t_gobj*> ObjectImplementationManager::getImplementationsForPatch(t_canvas*
             implementations.add(y);
         }
     }
-
-    return implementations;
 }
 
 void ObjectImplementationManager::clearObjectImplementationsForPatch(t_canvas* patch)
 {
+    implementationsByRootPatch.erase(patch);
+    changedRootPatches.erase(patch);
+
     auto* glist = static_cast<t_glist*>(patch);
 
     for (t_gobj* y = glist->gl_list; y; y = y->g_next) {
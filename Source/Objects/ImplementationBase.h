@@ -42,15 +42,24 @@ class ObjectImplementationManager : public AsyncUpdater {
 public:
     explicit ObjectImplementationManager(pd::Instance* pd);
 
-    void updateObjectImplementations();
+    // Rescans the top-level patch that contains changedPatch, or all patches if it's a nullptr
+    // changedPatch has to be locked by the caller
+    void updateObjectImplementations(t_canvas* changedPatch = nullptr);
     void clearObjectImplementationsForPatch(t_canvas* patch);
 
     void handleAsyncUpdate();
 
 private:
-    Array<t_gobj*> getImplementationsForPatch(t_canvas* patch);
+    void updateImplementationsForRootPatch(t_canvas* rootPatch);
+    void getImplementationsForPatch(t_canvas* patch, Array<t_gobj*>& implementations);
 
     PluginProcessor* pd;
 
     std::map<t_gobj*, std::unique_ptr<ImplementationBase>> objectImplementations;
+
+    // Implementations that were found in each top-level patch the last time it was scanned
+    std::unordered_map<t_canvas*, std::vector<t_gobj*>> implementationsByRootPatch;
+
+    std::unordered_set<t_canvas*> changedRootPatches;
+    bool allPatchesChanged = true;
 };
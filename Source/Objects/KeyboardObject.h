@@ -12,6 +12,9 @@ class MIDIKeyboard : public MidiKeyboardComponent {
     bool toggleMode = false;
     int lastKey = -1;
 
+    // Outlines of the octave numbers on the C keys, creating these from the glyphs is much slower than drawing them
+    std::map<int, Path> octaveNumberPaths;
+
 public:
     std::set<int> heldKeys;
     std::set<int> toggledKeys;
@@ -122,6 +125,48 @@ public:
         toggleMode = enableToggleMode;
     }
 
+    // Only repaints the area of a single key, for when a note is turned on or off from pd
+    void repaintNote(int midiNoteNumber)
+    {
+        if (midiNoteNumber < getRangeStart() || midiNoteNumber > getRangeEnd())
+            return;
+
+        repaint(getRectangleForKey(midiNoteNumber).getSmallestIntegerContainer().expanded(1));
+    }
+
+    void lookAndFeelChanged() override
+    {
+        octaveNumberPaths.clear();
+    }
+
+    Path const& getOctaveNumberPath(int octave)
+    {
+        auto it = octaveNumberPaths.find(octave);
+        if (it != octaveNumberPaths.end())
+            return it->second;
+
+        Array<int> glyphs;
+        Array<float> offsets;
+        auto font = Fonts::getCurrentFont();
+        Path p;
+        Path outline;
+        font.getGlyphPositions(String(octave), glyphs, offsets);
+
+        int prev_size = 0;
+        AffineTransform transform;
+        for (auto glyph : glyphs) {
+            font.getTypefacePtr()->getOutlineForGlyph(glyph, p);
+            if (glyphs.size() > 1) {
+                prev_size = outline.getBounds().getWidth();
+            }
+            transform = AffineTransform::scale(20).followedBy(AffineTransform::translation(prev_size, 0.0));
+            outline.addPath(p, transform);
+            p.clear();
+        }
+
+        return octaveNumberPaths[octave] = outline;
+    }
+
     void drawWhiteNote(int midiNoteNumber, Graphics& g, Rectangle<float> area, bool isDown, bool isOver, Colour lineColour, Colour textColour) override
     {
         isDown = heldKeys.count(midiNoteNumber) || toggledKeys.count(midiNoteNumber);
@@ -159,27 +204,9 @@ public:
 
         // draw C octave numbers
         if (!(midiNoteNumber % 12)) {
-            Array<int> glyphs;
-            Array<float> offsets;
-            auto font = Fonts::getCurrentFont();
-            Path p;
-            Path outline;
-            font.getGlyphPositions(String(floor(midiNoteNumber / 12) - 1), glyphs, offsets);
-
+            auto const& outline = getOctaveNumberPath(midiNoteNumber / 12 - 1);
             auto rectangle = area.withTrimmedTop(area.proportionOfHeight(0.8f)).reduced(area.getWidth() / 6.0f);
 
-            int prev_size = 0;
-            AffineTransform transform;
-            for (auto glyph : glyphs) {
-                font.getTypefacePtr()->getOutlineForGlyph(glyph, p);
-                if (glyphs.size() > 1) {
-                    prev_size = outline.getBounds().getWidth();
-                }
-                transform = AffineTransform::scale(20).followedBy(AffineTransform::translation(prev_size, 0.0));
-                outline.addPath(p, transform);
-                p.clear();
-            }
-
             g.setColour(Colour(90, 90, 90));
             g.fillPath(outline, outline.getTransformToScaleToFit(rectangle, true));
         }
@@ -202,7 +229,9 @@ public:
 };
 // ELSE keyboard
 class KeyboardObject final : public ObjectBase
-    , public Timer {
+    , public GuiRefreshScheduler::Client {
+
+    SharedResourcePointer<GuiRefreshScheduler> refreshScheduler;
 
     Value lowC = SynchronousValue();
     Value octaves = SynchronousValue();
@@ -260,7 +289,12 @@ public:
         objectParameters.addParamReceiveSymbol(&receiveSymbol);
         objectParameters.addParamSendSymbol(&sendSymbol);
 
-        startTimer(150);
+        refreshScheduler->addClient(this, this, 150);
+    }
+
+    ~KeyboardObject() override
+    {
+        refreshScheduler->removeClient(this);
     }
 
     void update() override
@@ -412,7 +446,7 @@ public:
         else
             keyboard.heldKeys.erase(midiNoteNumber);
 
-        keyboard.repaint();
+        keyboard.repaintNote(midiNoteNumber);
     }
 
     void notesOn(pd::Atom const atoms[8], int numAtoms, bool isOn)
@@ -422,8 +456,9 @@ public:
                 keyboard.heldKeys.insert(atoms[at].getFloat());
             else
                 keyboard.heldKeys.erase(atoms[at].getFloat());
+
+            keyboard.repaintNote(atoms[at].getFloat());
         }
-        keyboard.repaint();
     }
 
     void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
@@ -487,7 +522,7 @@ public:
         }
     }
 
-    void timerCallback() override
+    void refresh() override
     {
         updateValue();
     }
@@ -22,6 +22,11 @@ class Knob : public Slider {
     int numberOfTicks = 0;
     float arcStart = 63.5f;
 
+    // The range arc only changes with the size or settings of the knob, so we only draw it into an image once
+    Image staticLayer;
+    float staticLayerScale = 0.0f;
+    std::pair<float, float> staticLayerAngles;
+
 public:
     Knob()
         : Slider(Slider::RotaryHorizontalVerticalDrag, Slider::NoTextBox)
@@ -56,9 +61,16 @@ public:
     void showArc(bool show)
     {
         drawArc = show;
+        staticLayer = Image();
         repaint();
     }
 
+    void resized() override
+    {
+        Slider::resized();
+        staticLayer = Image();
+    }
+
     void setArcStart(float newArcStart)
     {
         arcStart = newArcStart;
@@ -79,15 +91,23 @@ public:
 
         startAngle = std::clamp(startAngle, endAngle - MathConstants<float>::twoPi, endAngle + MathConstants<float>::twoPi);
 
+        auto const scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        if (!staticLayer.isValid() || staticLayerScale != scale || staticLayerAngles != std::make_pair(startAngle, endAngle)) {
+            staticLayer = Image(Image::ARGB, std::max(1, roundToInt(getWidth() * scale)), std::max(1, roundToInt(getHeight() * scale)), true);
+            staticLayerScale = scale;
+            staticLayerAngles = { startAngle, endAngle };
+
+            Graphics layer(staticLayer);
+            layer.addTransform(AffineTransform::scale(scale));
+            drawStaticLayer(layer, bounds, startAngle, endAngle, lineThickness);
+        }
+
+        g.drawImage(staticLayer, getLocalBounds().toFloat());
+
         if (drawArc) {
-            // draw range arc
-            g.setColour(arcColour);
             auto arcBounds = bounds.reduced(lineThickness);
             auto arcRadius = arcBounds.getWidth() * 0.5;
             auto arcWidth = (arcRadius - lineThickness) / arcRadius;
-            Path rangeArc;
-            rangeArc.addPieSegment(arcBounds, startAngle, endAngle, arcWidth);
-            g.fillPath(rangeArc);
 
             // draw arc
             auto centre = jmap<double>(arcStart, startAngle, endAngle);
@@ -107,9 +127,24 @@ public:
         g.setColour(fgColour);
         g.strokePath(wiperPath, PathStrokeType(lineThickness, PathStrokeType::JointStyle::curved, PathStrokeType::EndCapStyle::rounded));
 
+        // Ticks go on top of the value arc
         drawTicks(g, bounds, startAngle, endAngle, lineThickness);
     }
 
+    void drawStaticLayer(Graphics& g, Rectangle<float> bounds, float startAngle, float endAngle, float lineThickness)
+    {
+        if (drawArc) {
+            // draw range arc
+            g.setColour(arcColour);
+            auto arcBounds = bounds.reduced(lineThickness);
+            auto arcRadius = arcBounds.getWidth() * 0.5;
+            auto arcWidth = (arcRadius - lineThickness) / arcRadius;
+            Path rangeArc;
+            rangeArc.addPieSegment(arcBounds, startAngle, endAngle, arcWidth);
+            g.fillPath(rangeArc);
+        }
+    }
+
     void setFgColour(Colour newFgColour)
     {
         fgColour = newFgColour;
@@ -119,6 +154,7 @@ public:
     void setArcColour(Colour newOutlineColour)
     {
         arcColour = newOutlineColour;
+        staticLayer = Image();
         repaint();
     }
 
@@ -21,50 +21,141 @@ void pdlua_gfx_mouse_drag(t_pdlua* o, int x, int y);
 void pdlua_gfx_repaint(t_pdlua* o);
 }
 
-struct LuaGuiMessage {
-    
-    t_symbol* symbol;
-    t_atom data[8];
-    int size;
-    
-    LuaGuiMessage() {};
-    
-    LuaGuiMessage(t_symbol* sym, int argc, t_atom* argv)
-    : symbol(sym)
+// Paint command from pdlua, converted from its atoms on the pd thread
+// This way the message thread doesn't have to hash selectors or unpack atoms, and frames can be compared cheaply
+struct LuaGuiCommand {
+    enum Type : uint8 {
+        StartPaint,
+        EndPaint,
+        Resized,
+        SetColour,
+        StrokeLine,
+        FillEllipse,
+        StrokeEllipse,
+        FillRect,
+        StrokeRect,
+        FillRoundedRect,
+        StrokeRoundedRect,
+        DrawText,
+        StartPath,
+        LineTo,
+        QuadTo,
+        CubicTo,
+        ClosePath,
+        FillPath,
+        StrokePath,
+        FillAll,
+        Translate,
+        Scale,
+        ResetTransform,
+        Unknown
+    };
+
+    static constexpr int maxArgs = 8;
+
+    Type type = Unknown;
+    int numArgs = 0;
+    float args[maxArgs] = {};
+    t_symbol* text = nullptr; // The first symbol argument, pd symbols are never freed so we can hold on to this
+
+    LuaGuiCommand() = default;
+
+    LuaGuiCommand(t_symbol* sym, int argc, t_atom* argv)
+        : type(getType(sym))
+        , numArgs(std::min(argc, maxArgs))
     {
-        size = std::min(argc, 8);
-        std::copy(argv, argv + size, data);
+        for (int i = 0; i < numArgs; i++) {
+            if (argv[i].a_type == A_FLOAT) {
+                args[i] = atom_getfloat(argv + i);
+            } else if (argv[i].a_type == A_SYMBOL && !text) {
+                text = atom_getsymbol(argv + i);
+            }
+        }
     }
-    
-    LuaGuiMessage(LuaGuiMessage const& other) noexcept
+
+    bool operator==(LuaGuiCommand const& other) const
     {
-        symbol = other.symbol;
-        size = other.size;
-        std::copy(other.data, other.data + other.size, data);
+        return type == other.type && numArgs == other.numArgs && text == other.text && std::equal(args, args + numArgs, other.args);
     }
-    
-    LuaGuiMessage& operator=(LuaGuiMessage const& other) noexcept
+
+    String getText() const
     {
-        // Check for self-assignment
-        if (this != &other) {
-            symbol = other.symbol;
-            size = other.size;
-            std::copy(other.data, other.data + other.size, data);
+        return text ? String::fromUTF8(text->s_name) : String(args[0]);
+    }
+
+    static Type getType(t_symbol* sym)
+    {
+        switch (hash(sym->s_name)) {
+        case hash("lua_start_paint"):
+            return StartPaint;
+        case hash("lua_end_paint"):
+            return EndPaint;
+        case hash("lua_resized"):
+            return Resized;
+        case hash("lua_set_color"):
+            return SetColour;
+        case hash("lua_stroke_line"):
+        case hash("lua_draw_line"):
+            return StrokeLine;
+        case hash("lua_fill_ellipse"):
+            return FillEllipse;
+        case hash("lua_stroke_ellipse"):
+            return StrokeEllipse;
+        case hash("lua_fill_rect"):
+            return FillRect;
+        case hash("lua_stroke_rect"):
+            return StrokeRect;
+        case hash("lua_fill_rounded_rect"):
+            return FillRoundedRect;
+        case hash("lua_stroke_rounded_rect"):
+            return StrokeRoundedRect;
+        case hash("lua_draw_text"):
+            return DrawText;
+        case hash("lua_start_path"):
+            return StartPath;
+        case hash("lua_line_to"):
+            return LineTo;
+        case hash("lua_quad_to"):
+            return QuadTo;
+        case hash("lua_cubic_to"):
+            return CubicTo;
+        case hash("lua_close_path"):
+            return ClosePath;
+        case hash("lua_fill_path"):
+            return FillPath;
+        case hash("lua_stroke_path"):
+            return StrokePath;
+        case hash("lua_fill_all"):
+            return FillAll;
+        case hash("lua_translate"):
+            return Translate;
+        case hash("lua_scale"):
+            return Scale;
+        case hash("lua_reset_transform"):
+            return ResetTransform;
+        default:
+            return Unknown;
         }
-        
-        return *this;
     }
 };
 
-class LuaObject : public ObjectBase, public Timer {
+class LuaObject : public ObjectBase, public GuiRefreshScheduler::Client {
+
+    SharedResourcePointer<GuiRefreshScheduler> refreshScheduler;
     
-    std::unique_ptr<Graphics> graphics;
     Colour currentColour;
     Path currentPath;
     Image drawBuffer;
     Image image;
     bool isSelected = false;
-    moodycamel::ReaderWriterQueue<LuaGuiMessage> guiQueue = moodycamel::ReaderWriterQueue<LuaGuiMessage>(40);
+
+    // Commands of the frame that pdlua is currently sending, and of the last frame that we rendered
+    // If a frame is the same as the last one, we keep showing the image we already have
+    std::vector<LuaGuiCommand> currentFrame;
+    std::vector<LuaGuiCommand> lastFrame;
+    float lastFrameScale = 0.0f;
+
+    moodycamel::ReaderWriterQueue<LuaGuiCommand> guiQueue = moodycamel::ReaderWriterQueue<LuaGuiCommand>(1024);
     
     std::unique_ptr<Component> textEditor;
     std::unique_ptr<Dialog> saveDialog;
@@ -80,11 +171,14 @@ public:
         }
         
         cnv->zoomScale.addListener(this);
-        startTimerHz(60); // Check for paint messages at 60hz (but we only really repaint when needed)
+        // Check for paint messages at 60hz (but we only really repaint when needed)
+        // This has to keep running when we're not visible, otherwise paint messages pile up
+        refreshScheduler->addClient(this, this, 16, false);
     }
     
     ~LuaObject()
     {
+        refreshScheduler->removeClient(this);
         if(auto pdlua = ptr.get<t_pdlua>())
         {
             pdlua->gfx.plugdata_callback_target = NULL;
@@ -129,36 +223,36 @@ public:
     
     void mouseDown(MouseEvent const& e) override
     {
-        pd->enqueueFunctionAsync<t_pdlua>(ptr, [x = e.x, y = e.y](t_pdlua* pdlua){
-            pdlua_gfx_mouse_down(pdlua, x, y);
-        });
+        pd->enqueueCommand(ptr, [](void* pdlua, float x, float y) {
+            pdlua_gfx_mouse_down(static_cast<t_pdlua*>(pdlua), x, y);
+        }, e.x, e.y);
     }
     
     void mouseDrag(MouseEvent const& e) override
     {
-        pd->enqueueFunctionAsync<t_pdlua>(ptr, [x = e.x, y = e.y](t_pdlua* pdlua){
-            pdlua_gfx_mouse_drag(pdlua, x, y);
-        });
+        pd->enqueueCommand(ptr, [](void* pdlua, float x, float y) {
+            pdlua_gfx_mouse_drag(static_cast<t_pdlua*>(pdlua), x, y);
+        }, e.x, e.y);
     }
     
     void mouseMove(MouseEvent const& e) override
     {
-        pd->enqueueFunctionAsync<t_pdlua>(ptr, [x = e.x, y = e.y](t_pdlua* pdlua){
-            pdlua_gfx_mouse_move(pdlua, x, y);
-        });
+        pd->enqueueCommand(ptr, [](void* pdlua, float x, float y) {
+            pdlua_gfx_mouse_move(static_cast<t_pdlua*>(pdlua), x, y);
+        }, e.x, e.y);
     }
     
     void mouseUp(MouseEvent const& e) override
     {
-        pd->enqueueFunctionAsync<t_pdlua>(ptr, [x = e.x, y = e.y](t_pdlua* pdlua){
-            pdlua_gfx_mouse_up(pdlua, x, y);
-        });
+        pd->enqueueCommand(ptr, [](void* pdlua, float x, float y) {
+            pdlua_gfx_mouse_up(static_cast<t_pdlua*>(pdlua), x, y);
+        }, e.x, e.y);
     }
     
     void sendRepaintMessage()
     {
-        pd->enqueueFunctionAsync<t_pdlua>(ptr, [](t_pdlua* pdlua){
-            pdlua_gfx_repaint(pdlua);
+        pd->enqueueCommand(ptr, [](void* pdlua, float, float) {
+            pdlua_gfx_repaint(static_cast<t_pdlua*>(pdlua));
         });
     }
     
@@ -180,170 +274,154 @@ public:
         }
     }
     
-    void timerCallback() override
+    void refresh() override
     {
-        LuaGuiMessage guiMessage;
-        while(guiQueue.try_dequeue(guiMessage))
+        LuaGuiCommand command;
+        while(guiQueue.try_dequeue(command))
         {
-            handleGuiMessage(guiMessage);
+            handleGuiCommand(command);
         }
 
         if(isSelected != object->isSelected())
         {
             isSelected = object->isSelected();
+            
+            // The selection outline isn't part of the commands, so the next frame needs to be drawn even if they are the same
+            lastFrame.clear();
             sendRepaintMessage();
         }
     }
     
-    void handleGuiMessage(LuaGuiMessage& message)
+    void handleGuiCommand(LuaGuiCommand const& command)
     {
-        pd::Atom atoms[8];
-        int numAtoms = message.size;
-        for (int at = 0; at < numAtoms; at++) {
-            atoms[at] = pd::Atom(message.data + at);
-        }
-        auto hashsym = hash(message.symbol->s_name);
-        
-        // First check functions that don't need an active graphics context, of modify the active graphics context
-        switch(hashsym)
+        switch(command.type)
         {
-            case hash("lua_start_paint"): {
-                auto scale = getValue<float>(cnv->zoomScale) * 2.0f; // Multiply by 2 for hi-dpi screens
-                drawBuffer = Image(Image::PixelFormat::ARGB, getWidth() * scale, getHeight() * scale, true);
-                graphics = std::make_unique<Graphics>(drawBuffer);
-                graphics->addTransform(AffineTransform::scale(scale)); // for hi-dpi displays
-                graphics->saveState();
+            case LuaGuiCommand::StartPaint: {
+                currentFrame.clear();
                 return;
             }
-            case hash("lua_end_paint"): {
-                graphics.reset(nullptr);
-                image = drawBuffer.createCopy();
-                repaint();
+            case LuaGuiCommand::EndPaint: {
+                renderFrame();
                 return;
             }
-            case hash("lua_resized"): {
-                if (numAtoms >= 2) {
+            case LuaGuiCommand::Resized: {
+                if (command.numArgs >= 2) {
                     if (auto pdlua = ptr.get<t_pdlua>()) {
-                        pdlua->gfx.width = atoms[0].getFloat();
-                        pdlua->gfx.height = atoms[1].getFloat();
+                        pdlua->gfx.width = command.args[0];
+                        pdlua->gfx.height = command.args[1];
                     }
                     object->updateBounds();
                 }
                 return;
             }
+            case LuaGuiCommand::Unknown:
+                return;
+            default:
+                currentFrame.push_back(command);
+                return;
         }
+    }
+    
+    // Renders the commands of the frame that pdlua just finished, unless it's the same as what we're already showing
+    void renderFrame()
+    {
+        auto scale = getValue<float>(cnv->zoomScale) * 2.0f; // Multiply by 2 for hi-dpi screens
+        auto const width = static_cast<int>(getWidth() * scale);
+        auto const height = static_cast<int>(getHeight() * scale);
         
-        if(!graphics) return;
+        if(currentFrame == lastFrame && scale == lastFrameScale && image.getWidth() == width && image.getHeight() == height)
+            return;
         
-        // Functions that do need an active graphics context
-        switch (hashsym) {
-            case hash("lua_set_color"): {
-                if (numAtoms >= 3) {
-                    Colour color(static_cast<uint8>(atoms[0].getFloat()),
-                                 static_cast<uint8>(atoms[1].getFloat()),
-                                 static_cast<uint8>(atoms[2].getFloat()));
-                    
-                    currentColour = color.withAlpha(numAtoms >= 4 ? atoms[3].getFloat() : 1.0f);
-                    graphics->setColour(currentColour);
-                }
-                break;
+        // Reuse the image we drew into two frames ago, if the size didn't change
+        if(drawBuffer.getWidth() != width || drawBuffer.getHeight() != height) {
+            drawBuffer = Image(Image::PixelFormat::ARGB, width, height, true);
+        }
+        else {
+            drawBuffer.clear(drawBuffer.getBounds());
+        }
+        
+        {
+            Graphics g(drawBuffer);
+            g.addTransform(AffineTransform::scale(scale)); // for hi-dpi displays
+            g.saveState();
+            
+            for(auto const& command : currentFrame) {
+                renderCommand(g, command);
             }
-            case hash("lua_stroke_line"): {
-                if (numAtoms >= 4) {
-                    float x1 = atoms[0].getFloat();
-                    float y1 = atoms[1].getFloat();
-                    float x2 = atoms[2].getFloat();
-                    float y2 = atoms[3].getFloat();
-                    float lineThickness = atoms[4].getFloat();
+        }
+        
+        std::swap(image, drawBuffer);
+        std::swap(lastFrame, currentFrame);
+        lastFrameScale = scale;
+        repaint();
+    }
+    
+    void renderCommand(Graphics& g, LuaGuiCommand const& command)
+    {
+        auto const* args = command.args;
+        auto const numArgs = command.numArgs;
+        
+        switch (command.type) {
+            case LuaGuiCommand::SetColour: {
+                if (numArgs >= 3) {
+                    Colour color(static_cast<uint8>(args[0]),
+                                 static_cast<uint8>(args[1]),
+                                 static_cast<uint8>(args[2]));
                     
-                    graphics->drawLine(x1, y1, x2, y2, lineThickness);
+                    currentColour = color.withAlpha(numArgs >= 4 ? args[3] : 1.0f);
+                    g.setColour(currentColour);
                 }
                 break;
             }
-            case hash("lua_fill_ellipse"): {
-                if (numAtoms >= 3) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    graphics->fillEllipse(Rectangle<float>(x, y, w, h));
+            case LuaGuiCommand::StrokeLine: {
+                if (numArgs >= 4) {
+                    g.drawLine(args[0], args[1], args[2], args[3], args[4]);
                 }
                 break;
             }
-            case hash("lua_stroke_ellipse"): {
-                if (numAtoms >= 4) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    float lineThickness = atoms[4].getFloat();
-                    graphics->drawEllipse(Rectangle<float>(x, y, w, h), lineThickness);
+            case LuaGuiCommand::FillEllipse: {
+                if (numArgs >= 3) {
+                    g.fillEllipse(Rectangle<float>(args[0], args[1], args[2], args[3]));
                 }
                 break;
             }
-            case hash("lua_fill_rect"): {
-                if (numAtoms >= 4) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    graphics->fillRect(Rectangle<float>(x, y, w, h));
+            case LuaGuiCommand::StrokeEllipse: {
+                if (numArgs >= 4) {
+                    g.drawEllipse(Rectangle<float>(args[0], args[1], args[2], args[3]), args[4]);
                 }
                 break;
             }
-            case hash("lua_stroke_rect"): {
-                if (numAtoms >= 5) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    float lineThickness = atoms[4].getFloat();
-                    graphics->drawRect(Rectangle<float>(x, y, w, h), lineThickness);
+            case LuaGuiCommand::FillRect: {
+                if (numArgs >= 4) {
+                    g.fillRect(Rectangle<float>(args[0], args[1], args[2], args[3]));
                 }
                 break;
             }
-            case hash("lua_fill_rounded_rect"): {
-                if (numAtoms >= 4) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    float cornerRadius = atoms[4].getFloat();
-                    graphics->fillRoundedRectangle(Rectangle<float>(x, y, w, h), cornerRadius);
+            case LuaGuiCommand::StrokeRect: {
+                if (numArgs >= 5) {
+                    g.drawRect(Rectangle<float>(args[0], args[1], args[2], args[3]), args[4]);
                 }
                 break;
             }
-
-            case hash("lua_stroke_rounded_rect"): {
-                if (numAtoms >= 6) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    float w = atoms[2].getFloat();
-                    float h = atoms[3].getFloat();
-                    float cornerRadius = atoms[4].getFloat();
-                    float lineThickness = atoms[5].getFloat();
-                    graphics->drawRoundedRectangle(Rectangle<float>(x, y, w, h), cornerRadius, lineThickness);
+            case LuaGuiCommand::FillRoundedRect: {
+                if (numArgs >= 4) {
+                    g.fillRoundedRectangle(Rectangle<float>(args[0], args[1], args[2], args[3]), args[4]);
                 }
                 break;
             }
-            case hash("lua_draw_line"): {
-                if (numAtoms >= 4) {
-                    float x1 = atoms[0].getFloat();
-                    float y1 = atoms[1].getFloat();
-                    float x2 = atoms[2].getFloat();
-                    float y2 = atoms[3].getFloat();
-                    float lineThickness = atoms[4].getFloat();
-                    graphics->drawLine(x1, y1, x2, y2, lineThickness);
+            case LuaGuiCommand::StrokeRoundedRect: {
+                if (numArgs >= 6) {
+                    g.drawRoundedRectangle(Rectangle<float>(args[0], args[1], args[2], args[3]), args[4], args[5]);
                 }
                 break;
             }
-            case hash("lua_draw_text"): {
-                if (numAtoms >= 4) {
-                    auto text = AttributedString(atoms[0].toString());
-                    float x = atoms[1].getFloat();
-                    float y = atoms[2].getFloat();
-                    float w = atoms[3].getFloat();
-                    float fontHeight = atoms[4].getFloat();
+            case LuaGuiCommand::DrawText: {
+                if (numArgs >= 4) {
+                    auto text = AttributedString(command.getText());
+                    float x = args[1];
+                    float y = args[2];
+                    float w = args[3];
+                    float fontHeight = args[4];
                     
                     text.setFont(Font(fontHeight));
                     text.setColour(currentColour);
@@ -351,96 +429,78 @@ public:
                     
                     TextLayout layout;
                     layout.createLayout(text, w);
-                    layout.draw(*graphics, {x, y, w, layout.getHeight()});
+                    layout.draw(g, {x, y, w, layout.getHeight()});
                 }
                 break;
             }
-            case hash("lua_start_path"): {
-                if (numAtoms >= 2) {
-                    currentPath = Path();
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    currentPath.startNewSubPath(x, y);
+            case LuaGuiCommand::StartPath: {
+                if (numArgs >= 2) {
+                    currentPath.clear();
+                    currentPath.startNewSubPath(args[0], args[1]);
                 }
                 break;
             }
-            case hash("lua_line_to"): {
-                if (numAtoms >= 2) {
-                    float x = atoms[0].getFloat();
-                    float y = atoms[1].getFloat();
-                    currentPath.lineTo(x, y);
+            case LuaGuiCommand::LineTo: {
+                if (numArgs >= 2) {
+                    currentPath.lineTo(args[0], args[1]);
                 }
                 break;
             }
-            case hash("lua_quad_to"): {
-                if (numAtoms >= 4) { // Assuming quad_to takes 3 arguments
-                    float x1 = atoms[0].getFloat();
-                    float y1 = atoms[1].getFloat();
-                    float x2 = atoms[2].getFloat();
-                    float y2 = atoms[3].getFloat();
-                    currentPath.quadraticTo(x1, y1, x2, y2);
+            case LuaGuiCommand::QuadTo: {
+                if (numArgs >= 4) {
+                    currentPath.quadraticTo(args[0], args[1], args[2], args[3]);
                 }
                 break;
             }
-            case hash("lua_cubic_to"): {
-                if (numAtoms >= 6) { // Assuming cubic_to takes 4 arguments
-                    float x1 = atoms[0].getFloat();
-                    float y1 = atoms[1].getFloat();
-                    float x2 = atoms[2].getFloat();
-                    float y2 = atoms[3].getFloat();
-                    float x3 = atoms[4].getFloat();
-                    float y3 = atoms[5].getFloat();
-                    currentPath.cubicTo(x1, y1, x2, y2, x3, y3);
+            case LuaGuiCommand::CubicTo: {
+                if (numArgs >= 6) {
+                    currentPath.cubicTo(args[0], args[1], args[2], args[3], args[4], args[5]);
                 }
                 break;
             }
-            case hash("lua_close_path"): {
+            case LuaGuiCommand::ClosePath: {
                 currentPath.closeSubPath();
                 break;
             }
-            case hash("lua_fill_path"): {
-                graphics->fillPath(currentPath);
+            case LuaGuiCommand::FillPath: {
+                g.fillPath(currentPath);
                 break;
             }
-            case hash("lua_stroke_path"): {
-                if (numAtoms >= 1) {
-                    graphics->strokePath(currentPath, PathStrokeType(atoms[0].getFloat()));
+            case LuaGuiCommand::StrokePath: {
+                if (numArgs >= 1) {
+                    g.strokePath(currentPath, PathStrokeType(args[0]));
                 }
                 break;
             }
-            case hash("lua_fill_all"): {
+            case LuaGuiCommand::FillAll: {
                 auto colour = currentColour;
                 
-                graphics->fillRoundedRectangle(getLocalBounds().toFloat(), Corners::objectCornerRadius);
+                g.fillRoundedRectangle(getLocalBounds().toFloat(), Corners::objectCornerRadius);
                 
                 auto outlineColour = object->findColour(isSelected ? PlugDataColour::objectSelectedOutlineColourId : objectOutlineColourId);
-                graphics->setColour(outlineColour);
-                graphics->drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), Corners::objectCornerRadius, 1.0f);
+                g.setColour(outlineColour);
+                g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), Corners::objectCornerRadius, 1.0f);
                 
-                graphics->setColour(colour);
+                g.setColour(colour);
                 
                 break;
             }
                 
-            case hash("lua_translate"): {
-                if (numAtoms >= 2) {
-                    float tx = atoms[0].getFloat();
-                    float ty = atoms[1].getFloat();
-                    graphics->addTransform(AffineTransform::translation(tx, ty));
+            case LuaGuiCommand::Translate: {
+                if (numArgs >= 2) {
+                    g.addTransform(AffineTransform::translation(args[0], args[1]));
                 }
                 break;
             }
-            case hash("lua_scale"): {
-                if (numAtoms >= 2) {
-                    float sx = atoms[0].getFloat();
-                    float sy = atoms[1].getFloat();
-                    graphics->addTransform(AffineTransform::scale(sx, sy));
+            case LuaGuiCommand::Scale: {
+                if (numArgs >= 2) {
+                    g.addTransform(AffineTransform::scale(args[0], args[1]));
                 }
                 break;
             }
-            case hash("lua_reset_transform"): {
-                graphics->restoreState();
-                graphics->saveState();
+            case LuaGuiCommand::ResetTransform: {
+                g.restoreState();
+                g.saveState();
                 break;
             }
             default:
@@ -14,7 +14,7 @@ class MessageObject final : public ObjectBase
 
     String objectText;
     
-    TextLayout textLayout;
+    std::shared_ptr<TextLayout const> textLayout = std::make_shared<TextLayout const>();
     hash32 layoutTextHash = 0;
     int lastTextWidth = 0;
     int32 lastColourARGB = 0;
@@ -47,12 +47,12 @@ public:
          int x = 0, y = 0, w, h;
          if (auto obj = ptr.get<t_gobj>()) {
              auto* cnvPtr = cnv->patch.getPointer().get();
-             if (!cnvPtr) return {x, y, getTextObjectWidth(), std::max<int>(textLayout.getHeight() + 6, 21)};
+             if (!cnvPtr) return {x, y, getTextObjectWidth(), std::max<int>(textLayout->getHeight() + 6, 21)};
      
              pd::Interface::getObjectBounds(cnvPtr, obj.get(), &x, &y, &w, &h);
          }
 
-         return {x, y, getTextObjectWidth(), std::max<int>(textLayout.getHeight() + 6, 21)};
+         return {x, y, getTextObjectWidth(), std::max<int>(textLayout->getHeight() + 6, 21)};
      }
          
      int getTextObjectWidth()
@@ -99,13 +99,7 @@ public:
          auto colour = object->findColour(PlugDataColour::canvasTextColourId);
          if(layoutTextHash != currentLayoutHash || colour.getARGB() != lastColourARGB || textWidth != lastTextWidth)
          {
-             auto attributedText = AttributedString(objText);
-             attributedText.setColour(colour);
-             attributedText.setJustification(Justification::centredLeft);
-             attributedText.setFont(Font(15));
-             
-             textLayout = TextLayout();
-             textLayout.createLayout(attributedText, textWidth);
+             textLayout = TextLayoutCache::getLayout(objText, Font(15), colour, Justification::centredLeft, textWidth);
              layoutTextHash = currentLayoutHash;
              lastColourARGB = colour.getARGB();
              lastTextWidth = textWidth;
@@ -168,7 +162,7 @@ public:
         // Draw text
         if (!editor) {
             auto textArea = border.subtractedFrom(getLocalBounds().withTrimmedRight(5));
-            textLayout.draw(g, textArea.toFloat());
+            textLayout->draw(g, textArea.toFloat());
         }
     }
 
@@ -185,6 +185,15 @@ public:
         repaint();
     }
 
+    bool receiveObjectFloat(float newValue) override
+    {
+        // The label won't repaint if the text stays the same
+        value = std::clamp(newValue, ::getValue<float>(min), ::getValue<float>(max));
+        input.setText(input.formatNumber(value), dontSendNotification);
+
+        return true;
+    }
+
     void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
     {
         switch (symbol) {
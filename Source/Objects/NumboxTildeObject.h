@@ -7,7 +7,9 @@
 #include "Components/DraggableNumber.h"
 
 class NumboxTildeObject final : public ObjectBase
-    , public Timer {
+    , public GuiRefreshScheduler::Client {
+
+    SharedResourcePointer<GuiRefreshScheduler> refreshScheduler;
 
     DraggableNumber input;
 
@@ -53,7 +55,7 @@ public:
             }
         };
 
-        startTimer(nextInterval);
+        refreshScheduler->addClient(this, this, nextInterval);
         repaint();
 
         objectParameters.addParamSize(&sizeProperty);
@@ -262,15 +264,26 @@ public:
         g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), Corners::objectCornerRadius, 1.0f);
     }
 
-    void timerCallback() override
+    ~NumboxTildeObject() override
+    {
+        refreshScheduler->removeClient(this);
+    }
+
+    void refresh() override
     {
-        auto val = getValue();
+        // Don't wait for the audio thread, if it's busy we'll just update next time
+        std::optional<float> val;
+        if (auto nbx = ptr.tryGet<t_fake_numbox>()) {
+            mode = nbx->x_outmode;
+            nextInterval = nbx->x_rate;
+            val = nbx->x_in_val;
+        }
 
-        if (!mode) {
-            input.setText(input.formatNumber(val), dontSendNotification);
+        if (val && !mode) {
+            input.setText(input.formatNumber(*val), dontSendNotification);
         }
 
-        startTimer(nextInterval);
+        refreshScheduler->setInterval(this, nextInterval);
     }
 
     float getValue()
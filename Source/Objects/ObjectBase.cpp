@@ -41,6 +41,11 @@ void canvas_click(t_canvas* x, t_floatarg xpos, t_floatarg ypos, t_floatarg shif
 #include "Sidebar/Sidebar.h"
 
 #include "IEMHelper.h"
+#include "Utility/DisplaySnapshot.h"
+#include "Utility/GuiRefreshScheduler.h"
+#include "Utility/TextLayoutCache.h"
+#include "Utility/ArraySoundFileLoader.h"
+#include "Utility/ImageFileCache.h"
 #include "AtomHelper.h"
 
 #include "TextObject.h"
@@ -193,6 +198,24 @@ void ObjectBase::initialise()
     }
 }
 
+void ObjectBase::setSuspended(bool shouldBeSuspended)
+{
+    if (suspended == shouldBeSuspended)
+        return;
+
+    suspended = shouldBeSuspended;
+
+    if (suspended) {
+        pd->unregisterMessageListener(ptr.getRawUnchecked<void>(), this);
+    } else {
+        pd->registerMessageListener(ptr.getRawUnchecked<void>(), this);
+
+        // We might have missed messages, so read back the current state from pd
+        update();
+        object->updateBounds();
+    }
+}
+
 void ObjectBase::objectMovedOrResized(bool resized)
 {
     auto objectBounds = object->getObjectBounds();
@@ -447,18 +470,18 @@ void ObjectBase::stopEdition()
         return;
 
     edited = false;
+
+    // Values from this edit can still be queued for the audio thread, they need to arrive before the edit ends to be part of the same undo step
+    pd->lockAudioThread();
+    pd->sendCommandsFromQueue(false);
     pd->sendMessage("gui", "mouse", { 0.f });
+    pd->unlockAudioThread();
 }
 
 void ObjectBase::sendFloatValue(float newValue)
 {
-    t_atom atom;
-    SETFLOAT(&atom, newValue);
-
-    if (auto obj = ptr.get<t_pd>()) {
-        pd_typedmess(obj.get(), cnv->patch.instance->generateSymbol("set"), 1, &atom);
-        pd_bang(obj.get());
-    }
+    // Sent at the start of the next block without taking the audio lock, so dragging a slider doesn't compete with the audio thread
+    cnv->patch.instance->sendFloatAsync(ptr, newValue, true);
 }
 
 ObjectBase* ObjectBase::createGui(pd::WeakReference ptr, Object* parent)
@@ -711,6 +734,18 @@ void ObjectBase::receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int n
     receiveObjectMessage(symHash, atoms, numAtoms);
 }
 
+void ObjectBase::receiveFloat(t_symbol* symbol, float value)
+{
+    object->triggerOverlayActiveState();
+
+    if (receiveObjectFloat(value))
+        return;
+
+    pd::Atom atoms[8];
+    atoms[0] = pd::Atom(value);
+    receiveObjectMessage(hash("float"), atoms, 1);
+}
+
 void ObjectBase::setParameterExcludingListener(Value& parameter, var const& value)
 {
     parameter.removeListener(&propertyUndoListener);
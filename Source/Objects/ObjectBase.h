@@ -79,6 +79,9 @@ public:
 
     virtual bool isTransparent() { return false; };
 
+    // Objects that only change when they repaint can be drawn from a cached image
+    virtual bool canBeBufferedToImage() { return false; }
+
     bool hitTest(int x, int y) override;
 
     // Some objects need to show/hide iolets when send/receive symbols are set
@@ -102,6 +105,10 @@ public:
 
     virtual void tabChanged() { }
 
+    // Stops listening to messages from pd while the canvas is suspended, and catches up with the state in pd when resumed
+    void setSuspended(bool shouldBeSuspended);
+    bool isSuspended() const { return suspended; }
+
     virtual bool canOpenFromMenu();
     virtual void openFromMenu();
 
@@ -129,6 +136,9 @@ public:
     // Called whenever the object receives a pd message
     virtual void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) {};
 
+    // Called when the object receives a single float from pd. Return true if you handled it, otherwise it will be passed on to receiveObjectMessage
+    virtual bool receiveObjectFloat(float value) { return false; };
+
     // Close any tabs with opened subpatchers
     void closeOpenedSubpatchers();
     void openSubpatch();
@@ -137,6 +147,7 @@ public:
     bool click(Point<int> position, bool shift, bool alt);
 
     void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms) override;
+    void receiveFloat(t_symbol* symbol, float value) override;
 
     static ObjectBase* createGui(pd::WeakReference ptr, Object* parent);
 
@@ -168,6 +179,8 @@ public:
     ObjectParameters objectParameters;
 
 protected:
+    bool suspended = false;
+
     // Set parameter without triggering valueChanged
     void setParameterExcludingListener(Value& parameter, var const& value);
     void setParameterExcludingListener(Value& parameter, var const& value, Value::Listener* otherListener);
@@ -98,14 +98,7 @@ public:
             bool locked = getValue<bool>(object->locked) || getValue<bool>(object->commandLocked);
             auto colour = object->findColour((locked && mouseIsOver) ? PlugDataColour::objectSelectedOutlineColourId : PlugDataColour::canvasTextColourId);
             
-            auto attributedText = AttributedString(objText);
-            attributedText.setColour(colour);
-            attributedText.setJustification(Justification::centredLeft);
-            attributedText.setFont(Font(15));
-            attributedText.setColour(colour);
-            
-            textLayout = TextLayout();
-            textLayout.createLayout(attributedText, textWidth);
+            textLayout = TextLayoutCache::getLayout(objText, Font(15), colour, Justification::centredLeft, textWidth);
             layoutTextHash = currentLayoutHash;
             lastColourARGB = colour.getARGB();
             lastTextWidth = textWidth;
@@ -126,12 +119,12 @@ public:
         int x = 0, y = 0, w, h;
         if (auto obj = ptr.get<t_gobj>()) {
             auto* cnvPtr = cnv->patch.getPointer().get();
-            if (!cnvPtr) return {x, y, getTextObjectWidth(), std::max<int>(textLayout.getHeight() + 6, 21)};
+            if (!cnvPtr) return {x, y, getTextObjectWidth(), std::max<int>(textLayout->getHeight() + 6, 21)};
     
             pd::Interface::getObjectBounds(cnvPtr, obj.get(), &x, &y, &w, &h);
         }
 
-        return {x, y, getTextObjectWidth(), std::max<int>(textLayout.getHeight() + 6, 21)};
+        return {x, y, getTextObjectWidth(), std::max<int>(textLayout->getHeight() + 6, 21)};
     }
 
     void setPdBounds(Rectangle<int> b) override
@@ -183,7 +176,7 @@ public:
 
         if (!editor) {
             auto textArea = border.subtractedFrom(getLocalBounds());
-            textLayout.draw(g, textArea.toFloat());
+            textLayout->draw(g, textArea.toFloat());
         }
     }
 
@@ -18,6 +18,8 @@ class PictureObject final : public ObjectBase {
     File imageFile;
     Image img;
 
+    SharedResourcePointer<ImageFileCache> imageCache;
+
 public:
     PictureObject(pd::WeakReference ptr, Object* object)
         : ObjectBase(ptr, object)
@@ -122,7 +124,7 @@ public:
 
     void paint(Graphics& g) override
     {
-        if (imageFile.existsAsFile()) {
+        if (img.isValid()) {
             g.drawImageAt(img, 0, 0);
         } else {
             Fonts::drawText(g, "?", getLocalBounds(), object->findColour(PlugDataColour::canvasTextColourId), 30, Justification::centred);
@@ -255,11 +257,24 @@ public:
         auto* rawFileName = fileNameString.toRawUTF8();
         auto* rawPath = pathString.toRawUTF8();
 
-        img = ImageFileFormat::loadFrom(imageFile);
-
         if (auto pic = ptr.get<t_fake_pic>()) {
             pic->x_filename = pd->generateSymbol(rawFileName);
             pic->x_fullname = pd->generateSymbol(rawPath);
+        }
+
+        // The previous image stays visible until the new one is decoded
+        imageCache->loadImage(imageFile, [_this = SafePointer(this), file = imageFile](Image image) {
+            // Ignore images that finished decoding after another file was opened
+            if (_this && _this->imageFile == file)
+                _this->setImage(image);
+        });
+    }
+
+    void setImage(Image const& image)
+    {
+        img = image;
+
+        if (auto pic = ptr.get<t_fake_pic>()) {
             pic->x_width = img.getWidth();
             pic->x_height = img.getHeight();
 
@@ -109,6 +109,17 @@ public:
         }
     }
 
+    bool receiveObjectFloat(float value) override
+    {
+        auto const newSelected = static_cast<int>(std::clamp<float>(value, 0.0f, numItems - 1));
+        if (newSelected != selected) {
+            selected = newSelected;
+            repaint();
+        }
+
+        return true;
+    }
+
     void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
     {
         switch (symbol) {
@@ -40,6 +40,10 @@ public:
     t_template* parentTempl;
     pd::WeakReference scalar;
 
+    std::unordered_map<t_symbol*, int> floatFieldOnsets;
+    std::array<float, 19> lastViewState = {};
+    MemoryBlock lastWords;
+
     DrawableTemplate(t_scalar* object, t_word* scalarData, t_template* scalarTemplate, t_template* parentTemplate, Canvas* cnv, t_float x, t_float y)
         : pd(cnv->pd)
         , canvas(cnv)
@@ -105,11 +109,11 @@ public:
 
     /* getting and setting values via fielddescs -- note confusing names;
      the above are setting up the fielddesc itself. */
-    static t_float fielddesc_getfloat(t_fake_fielddesc* f, t_template* templ, t_word* wp, int loud)
+    t_float fielddesc_getfloat(t_fake_fielddesc* f, t_template* t, t_word* wp, int loud)
     {
         if (f->fd_type == A_FLOAT) {
             if (f->fd_var)
-                return (template_getfloat(templ, f->fd_un.fd_varsym, wp, loud));
+                return getFloatField(t, f->fd_un.fd_varsym, wp, loud);
             else
                 return (f->fd_un.fd_float);
         } else {
@@ -117,6 +121,74 @@ public:
         }
     }
 
+    t_float fielddesc_getcoord(t_fielddesc* f, t_template* t, t_word* wp, int loud)
+    {
+        auto* fd = reinterpret_cast<t_fake_fielddesc*>(f);
+        if (fd->fd_type == A_FLOAT && fd->fd_var)
+            return fielddesc_cvttocoord(f, getFloatField(t, fd->fd_un.fd_varsym, wp, loud));
+
+        return fielddesc_getfloat(fd, t, wp, loud);
+    }
+
+    // Same as template_getfloat, but remembers where the field is in our template
+    // template_getfloat searches through all fields of the template by name, which gets slow when a patch draws thousands of scalars
+    t_float getFloatField(t_template* t, t_symbol* fieldName, t_word* wp, int loud)
+    {
+        if (t != templ)
+            return template_getfloat(t, fieldName, wp, loud);
+
+        auto it = floatFieldOnsets.find(fieldName);
+        if (it == floatFieldOnsets.end()) {
+            int onset, type;
+            t_symbol* arraytype;
+            if (!template_find_field(templ, fieldName, &onset, &type, &arraytype) || type != DT_FLOAT) {
+                // Let pd report the error, once
+                template_getfloat(templ, fieldName, wp, loud);
+                onset = -1;
+            }
+            it = floatFieldOnsets.emplace(fieldName, onset).first;
+        }
+
+        if (it->second < 0)
+            return 0;
+
+        return ((t_word*)((char*)wp + it->second))->w_float;
+    }
+
+    // Returns false if the scalar's data and the coordinate system of the canvas are still the same as the last time this was called
+    // In that case, the geometry we built last time is still correct
+    // The visibility is passed separately, because the drawing instruction can also hide itself with a constant ("vis 0"), which isn't in the scalar's data
+    bool hasChangedSinceLastUpdate(float visibility)
+    {
+        auto* glist = canvas->patch.getPointer().get();
+        if (!glist || !templ)
+            return true;
+
+        auto viewState = std::array<float, 19> {
+            visibility,
+            baseX, baseY,
+            static_cast<float>(canvas->canvasOrigin.x), static_cast<float>(canvas->canvasOrigin.y),
+            glist->gl_x1, glist->gl_x2, glist->gl_y1, glist->gl_y2,
+            static_cast<float>(glist->gl_pixwidth), static_cast<float>(glist->gl_pixheight),
+            static_cast<float>(glist->gl_screenx1), static_cast<float>(glist->gl_screenx2),
+            static_cast<float>(glist->gl_screeny1), static_cast<float>(glist->gl_screeny2),
+            static_cast<float>(glist->gl_xmargin + glist->gl_ymargin * 4096),
+            static_cast<float>(glist_getzoom(glist)),
+            static_cast<float>(glist_getfont(glist)),
+            static_cast<float>(getValue<bool>(canvas->isGraphChild) + canvas->isGraph * 2)
+        };
+
+        auto const numBytes = static_cast<size_t>(templ->t_n) * sizeof(t_word);
+        auto changed = viewState != lastViewState || lastWords.getSize() != numBytes || std::memcmp(lastWords.getData(), data, numBytes) != 0;
+
+        if (changed) {
+            lastViewState = viewState;
+            lastWords.replaceAll(data, numBytes);
+        }
+
+        return changed;
+    }
+
     static int rangecolor(int n) /* 0 to 9 in 5 steps */
     {
         int n2 = (n == 9 ? 8 : n); /* 0 to 8 */
@@ -243,6 +315,9 @@ public:
             scalar_getbasexy(s, &baseX, &baseY);
         }
 
+        if (!hasChangedSinceLastUpdate(fielddesc_getfloat(&x->x_vis, templ, data, 0)))
+            return;
+
         if (!fielddesc_getfloat(&x->x_vis, templ, data, 0)) {
             setPath(Path());
             return;
@@ -409,6 +484,13 @@ public:
 
         auto* x = reinterpret_cast<t_fake_drawnumber*>(object);
 
+        // The contents of a text field are not stored in the scalar's words, so we can't tell if those have changed
+        int fieldOnset, fieldType;
+        t_symbol* fieldArrayType;
+        auto isTextField = template_find_field(templ, x->x_fieldname, &fieldOnset, &fieldType, &fieldArrayType) && fieldType == DT_TEXT;
+        if (!isTextField && !hasChangedSinceLastUpdate(fielddesc_getfloat(&x->x_vis, templ, data, 0)))
+            return;
+
         if (!fielddesc_getfloat(&x->x_vis, templ, data, 0)) {
             setText("");
             return;
@@ -547,7 +629,7 @@ public:
         }; */
     }
 
-    static int readOwnerTemplate(t_fake_plot* x,
+    int readOwnerTemplate(t_fake_plot* x,
         t_word* data, t_template* ownertemplate,
         t_symbol** elemtemplatesymp, t_array** arrayp,
         t_float* linewidthp, t_float* xlocp, t_float* xincp, t_float* ylocp,
@@ -6,10 +6,20 @@
 
 template<typename S>
 class ScopeBase : public ObjectBase
-    , public Timer {
+    , public pd::Instance::DisplaySource
+    , public GuiRefreshScheduler::Client {
 
-    std::vector<float> x_buffer;
-    std::vector<float> y_buffer;
+    SharedResourcePointer<GuiRefreshScheduler> refreshScheduler;
+
+    // Preallocated for the largest snapshot, numPoints tells how much of it is in use
+    std::vector<float> x_buffer = std::vector<float>(DisplaySnapshot::maxPoints);
+    std::vector<float> y_buffer = std::vector<float>(DisplaySnapshot::maxPoints);
+    int numPoints = 0;
+    Path waveform;
+
+    // The audio thread publishes a decimated copy of the scope buffer here, so we never have to lock to read it
+    TripleBuffer<DisplaySnapshot> snapshots;
+    std::atomic<bool> snapshotRequested = false;
 
     Value gridColour = SynchronousValue();
     Value triggerMode = SynchronousValue();
@@ -41,7 +51,43 @@ public:
 
         objectParameters.addParamReceiveSymbol(&receiveSymbol);
 
-        startTimerHz(25);
+        pd->registerDisplaySource(this);
+        refreshScheduler->addClient(this, this, 40);
+    }
+
+    ~ScopeBase() override
+    {
+        refreshScheduler->removeClient(this);
+        pd->unregisterDisplaySource(this);
+    }
+
+    // Called from the audio thread, only when the GUI has asked for a new frame
+    void publishDisplayData() override
+    {
+        if (!snapshotRequested.exchange(false))
+            return;
+
+        auto* scope = ptr.getRaw<S>();
+        if (!scope)
+            return;
+
+        auto& snapshot = snapshots.getWriteBuffer();
+        auto const bufsize = std::clamp<int>(scope->x_bufsize, 0, SCOPE_MAXBUFSIZE * 4);
+
+        snapshot.rangeMin = scope->x_min;
+        snapshot.rangeMax = scope->x_max;
+        snapshot.mode = scope->x_xymode;
+
+        // In XY mode, the points of both signals need to stay paired up
+        if (snapshot.mode == 3) {
+            snapshot.numPoints = DisplaySnapshot::subsample(scope->x_xbuflast, bufsize, snapshot.x);
+            DisplaySnapshot::subsample(scope->x_ybuflast, bufsize, snapshot.y);
+        } else {
+            snapshot.numPoints = DisplaySnapshot::decimate(scope->x_xbuflast, bufsize, snapshot.x);
+            DisplaySnapshot::decimate(scope->x_ybuflast, bufsize, snapshot.y);
+        }
+
+        snapshots.publish();
     }
 
     void updateSizeProperty() override
@@ -136,20 +182,9 @@ public:
         }
 
         // skip drawing waveform if buffer is empty
-        if (!(y_buffer.empty() || x_buffer.empty())) {
-            Point<float> lastPoint = Point<float>(x_buffer[0], y_buffer[0]);
-            Point<float> newPoint;
-
+        if (numPoints > 1) {
             g.setColour(Colour::fromString(primaryColour.toString()));
-
-            Path p;
-            for (size_t i = 1; i < y_buffer.size(); i++) {
-                newPoint = Point<float>(x_buffer[i], y_buffer[i]);
-                Line segment(lastPoint, newPoint);
-                p.addLineSegment(segment, 1.0f);
-                lastPoint = newPoint;
-            }
-            g.fillPath(p);
+            g.strokePath(waveform, PathStrokeType(1.0f));
         }
 
         bool selected = object->isSelected() && !cnv->isGraph;
@@ -159,64 +194,102 @@ public:
         g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), Corners::objectCornerRadius, 1.0f);
     }
 
-    void timerCallback() override
+    void refresh() override
     {
-        int bufsize = 0, mode = 0;
-        float min = 0.0f, max = 1.0f;
-
         if (object->iolets.size() == 3)
             object->iolets[2]->setVisible(false);
 
-        if (auto scope = ptr.get<S>()) {
-            bufsize = scope->x_bufsize;
-            min = scope->x_min;
-            max = scope->x_max;
-            mode = scope->x_xymode;
-
-            if (x_buffer.size() != bufsize) {
-                x_buffer.resize(bufsize);
-                y_buffer.resize(bufsize);
-            }
+        // Ask the audio thread for the next frame, and draw the last one it published (if there is a new one)
+        snapshotRequested = true;
 
-            std::copy(scope->x_xbuflast, scope->x_xbuflast + bufsize, x_buffer.data());
-            std::copy(scope->x_ybuflast, scope->x_ybuflast + bufsize, y_buffer.data());
-        }
+        auto const* snapshot = snapshots.read();
+        if (!snapshot)
+            return;
+
+        auto const mode = snapshot->mode;
+        auto min = snapshot->rangeMin;
+        auto max = snapshot->rangeMax;
+
+        numPoints = std::min(snapshot->numPoints, DisplaySnapshot::maxPoints);
+
+        std::copy(snapshot->x, snapshot->x + numPoints, x_buffer.data());
+        std::copy(snapshot->y, snapshot->y + numPoints, y_buffer.data());
 
         if (min > max) {
-            auto temp = max;
-            max = min;
-            min = temp;
+            std::swap(min, max);
         }
 
-        float oldx = 0, oldy = 0;
-        float dx = (getWidth() - 2) / (float)bufsize;
-        float dy = (getHeight() - 2) / (float)bufsize;
-
         float waveAreaHeight = getHeight() - 2;
         float waveAreaWidth = getWidth() - 2;
 
-        for (int n = 0; n < bufsize; n++) {
-            switch (mode) {
-            case 1:
-                y_buffer[n] = jmap<float>(x_buffer[n], min, max, waveAreaHeight, 2.f);
-                x_buffer[n] = oldx;
-                oldx += dx;
-                break;
-            case 2:
-                x_buffer[n] = jmap<float>(y_buffer[n], min, max, 2.f, waveAreaWidth);
-                y_buffer[n] = oldy;
-                oldy += dy;
-                break;
-            case 3:
-                x_buffer[n] = jmap<float>(x_buffer[n], min, max, 2.f, waveAreaWidth);
-                y_buffer[n] = jmap<float>(y_buffer[n], min, max, waveAreaHeight, 2.f);
-                break;
-            default:
-                break;
+        switch (mode) {
+        case 1:
+            numPoints = decimateToPixels(x_buffer.data(), numPoints, getWidth() - 2);
+            mapRange(x_buffer.data(), y_buffer.data(), numPoints, min, max, waveAreaHeight, 2.f);
+            fillRamp(x_buffer.data(), numPoints, (getWidth() - 2) / static_cast<float>(numPoints));
+            break;
+        case 2:
+            numPoints = decimateToPixels(y_buffer.data(), numPoints, getHeight() - 2);
+            mapRange(y_buffer.data(), x_buffer.data(), numPoints, min, max, 2.f, waveAreaWidth);
+            fillRamp(y_buffer.data(), numPoints, (getHeight() - 2) / static_cast<float>(numPoints));
+            break;
+        case 3:
+            mapRange(x_buffer.data(), x_buffer.data(), numPoints, min, max, 2.f, waveAreaWidth);
+            mapRange(y_buffer.data(), y_buffer.data(), numPoints, min, max, waveAreaHeight, 2.f);
+            break;
+        default:
+            break;
+        }
+
+        waveform.clear();
+        if (numPoints > 1) {
+            waveform.preallocateSpace(numPoints * 3);
+            waveform.startNewSubPath(x_buffer[0], y_buffer[0]);
+            for (int n = 1; n < numPoints; n++) {
+                waveform.lineTo(x_buffer[n], y_buffer[n]);
             }
         }
 
-        repaint();
+        cnv->repaintCoordinator.repaint(this);
+    }
+
+    // Same as jmap, for a whole buffer at once
+    static void mapRange(float const* source, float* destination, int numValues, float sourceMin, float sourceMax, float targetMin, float targetMax)
+    {
+        if (approximatelyEqual(sourceMin, sourceMax)) {
+            FloatVectorOperations::fill(destination, (targetMin + targetMax) * 0.5f, numValues);
+            return;
+        }
+
+        auto const scale = (targetMax - targetMin) / (sourceMax - sourceMin);
+        FloatVectorOperations::multiply(destination, source, scale, numValues);
+        FloatVectorOperations::add(destination, targetMin - sourceMin * scale, numValues);
+    }
+
+    // Fills the buffer with evenly spaced positions, starting at 0
+    static void fillRamp(float* destination, int numValues, float step)
+    {
+        for (int n = 0; n < numValues; n++) {
+            destination[n] = n * step;
+        }
+    }
+
+    // If there are more points than we can show, store the min and max of every pixel in place, so peaks stay visible
+    static int decimateToPixels(float* values, int numValues, int numPixels)
+    {
+        if (numPixels <= 0 || numValues <= numPixels * 2)
+            return numValues;
+
+        for (int pixel = 0; pixel < numPixels; pixel++) {
+            // The bins are at least 2 values wide, so we never overwrite values that we still need to read
+            auto const start = pixel * numValues / numPixels;
+            auto const end = (pixel + 1) * numValues / numPixels;
+            auto const range = FloatVectorOperations::findMinAndMax(values + start, end - start);
+            values[pixel * 2] = range.getStart();
+            values[pixel * 2 + 1] = range.getEnd();
+        }
+
+        return numPixels * 2;
     }
 
     void valueChanged(Value& v) override
@@ -214,6 +214,17 @@ public:
         }
     }
 
+    bool receiveObjectFloat(float newValue) override
+    {
+        // Compare with the slider instead of value, since that doesn't follow mouse drags
+        value = newValue;
+        if (static_cast<float>(slider.getValue()) != newValue) {
+            slider.setValue(value, dontSendNotification);
+        }
+
+        return true;
+    }
+
     void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
     {
         switch (symbol) {
@@ -59,56 +59,10 @@ public:
             }));
     }
 
-    void setText(String text)
+    void setText(String const& text)
     {
-        // remove repeating spaces
-        while (text.contains("  ")) {
-            text = text.replace("  ", " ");
-        }
-        text = text.replace("\r ", "\r");
-        text = text.replace(";\r", ";");
-        text = text.replace("\r;", ";");
-        text = text.replace(" ;", ";");
-        text = text.replace("; ", ";");
-        text = text.replaceCharacters("\r", " ");
-        text = text.trimStart();
-        auto lines = StringArray::fromTokens(text, ";", "\"");
-        auto atoms = std::vector<t_atom>();
-        atoms.reserve(lines.size());
-
-        int count = 0;
-        for (auto const& line : lines) {
-            count++;
-            auto words = StringArray::fromTokens(line, " ", "\"");
-            for (auto const& word : words) {
-                atoms.emplace_back();
-                // check if string is a valid number
-                auto charptr = word.getCharPointer();
-                auto ptr = charptr;
-                CharacterFunctions::readDoubleValue(ptr); // Remove double value from string
-                if (ptr - charptr == word.getNumBytesAsUTF8() && ptr - charptr != 0) {
-                    SETFLOAT(&atoms.back(), word.getFloatValue());
-                } else {
-                    SETSYMBOL(&atoms.back(), pd->generateSymbol(word));
-                }
-            }
-
-            if (count != lines.size()) {
-                atoms.emplace_back();
-                SETSYMBOL(&atoms.back(), pd->generateSymbol(";"));
-            }
-        }
-
         if (auto qlist = ptr.get<t_fake_qlist>()) {
-
-            auto& textbuf = qlist->x_textbuf;
-
-            binbuf_clear(textbuf.b_binbuf);
-
-            t_binbuf* z = binbuf_new();
-            binbuf_restore(z, atoms.size(), atoms.data());
-            binbuf_add(textbuf.b_binbuf, binbuf_getnatom(z), binbuf_getvec(z));
-            binbuf_free(z);
+            pd::Interface::setBinbufText(qlist->x_textbuf.b_binbuf, text);
         }
     }
 
@@ -127,15 +81,7 @@ public:
     String getText() override
     {
         if (auto textDefine = ptr.get<t_fake_text_define>()) {
-            auto& textbuf = textDefine->x_textbuf;
-            auto* binbuf = textbuf.b_binbuf;
-
-            char* bufp;
-            int lenp;
-
-            binbuf_gettext(binbuf, &bufp, &lenp);
-
-            return String::fromUTF8(bufp, lenp);
+            return pd::Interface::getBinbufText(textDefine->x_textbuf.b_binbuf);
         }
 
         return {};
@@ -218,56 +164,10 @@ public:
             }));
     }
 
-    void setText(String text)
+    void setText(String const& text)
     {
-
-        // remove repeating spaces
-        while (text.contains("  ")) {
-            text = text.replace("  ", " ");
-        }
-        text = text.replace("\r ", "\r");
-        text = text.replace(";\r", ";");
-        text = text.replace("\r;", ";");
-        text = text.replace(" ;", ";");
-        text = text.replace("; ", ";");
-        text = text.replaceCharacters("\r", " ");
-        text = text.trimStart();
-        auto lines = StringArray::fromTokens(text, ";", "\"");
-        auto atoms = std::vector<t_atom>();
-        atoms.reserve(lines.size());
-
-        int count = 0;
-        for (auto const& line : lines) {
-            count++;
-            auto words = StringArray::fromTokens(line, " ", "\"");
-            for (auto const& word : words) {
-                atoms.emplace_back();
-                // check if string is a valid number
-                auto charptr = word.getCharPointer();
-                auto ptr = charptr;
-                CharacterFunctions::readDoubleValue(ptr);
-                if (ptr - charptr == word.getNumBytesAsUTF8() && ptr - charptr != 0) {
-                    SETFLOAT(&atoms.back(), word.getFloatValue());
-                } else {
-                    SETSYMBOL(&atoms.back(), pd->generateSymbol(word));
-                }
-            }
-
-            if (count != lines.size()) {
-                atoms.emplace_back();
-                SETSYMBOL(&atoms.back(), pd->generateSymbol(";"));
-            }
-        }
-
         if (auto textDefine = ptr.get<t_fake_text_define>()) {
-            auto& textbuf = textDefine->x_textbuf;
-
-            binbuf_clear(textbuf.b_binbuf);
-
-            t_binbuf* z = binbuf_new();
-            binbuf_restore(z, atoms.size(), atoms.data());
-            binbuf_add(textbuf.b_binbuf, binbuf_getnatom(z), binbuf_getvec(z));
-            binbuf_free(z);
+            pd::Interface::setBinbufText(textDefine->x_textbuf.b_binbuf, text);
         }
     }
 
@@ -286,15 +186,7 @@ public:
     String getText() override
     {
         if (auto textDefine = ptr.get<t_fake_text_define>()) {
-            auto& textbuf = textDefine->x_textbuf;
-            auto* binbuf = textbuf.b_binbuf;
-
-            char* bufp;
-            int lenp;
-
-            binbuf_gettext(binbuf, &bufp, &lenp);
-
-            return String::fromUTF8(bufp, lenp);
+            return pd::Interface::getBinbufText(textDefine->x_textbuf.b_binbuf);
         }
 
         return {};
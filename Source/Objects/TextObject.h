@@ -201,7 +201,7 @@ protected:
     std::unique_ptr<TextEditor> editor;
     BorderSize<int> border = BorderSize<int>(1, 7, 1, 2);
     
-    TextLayout textLayout;
+    std::shared_ptr<TextLayout const> textLayout = std::make_shared<TextLayout const>();
     hash32 layoutTextHash = 0;
     int lastTextWidth = 0;
     int32 lastColourARGB = 0;
@@ -251,10 +251,15 @@ public:
 
         if (!editor) {
             auto textArea = border.subtractedFrom(getLocalBounds());
-            textLayout.draw(g, textArea.toFloat());
+            textLayout->draw(g, textArea.toFloat());
         }
     }
 
+    bool canBeBufferedToImage() override
+    {
+        return editor == nullptr;
+    }
+
     void paintOverChildren(Graphics& g) override
     {
         bool selected = object->isSelected() && !cnv->isGraph;
@@ -294,12 +299,12 @@ public:
         int x = 0, y = 0, w, h;
         if (auto obj = ptr.get<t_gobj>()) {
             auto* cnvPtr = cnv->patch.getPointer().get();
-            if (!cnvPtr) return {x, y, getTextObjectWidth(), std::max<int>(textLayout.getHeight() + 6, 21)};
+            if (!cnvPtr) return {x, y, getTextObjectWidth(), std::max<int>(textLayout->getHeight() + 6, 21)};
     
             pd::Interface::getObjectBounds(cnvPtr, obj.get(), &x, &y, &w, &h);
         }
 
-        return {x, y, getTextObjectWidth(), std::max<int>(textLayout.getHeight() + 6, 21)};
+        return {x, y, getTextObjectWidth(), std::max<int>(textLayout->getHeight() + 6, 21)};
     }
         
     virtual int getTextObjectWidth()
@@ -349,13 +354,7 @@ public:
         auto colour = object->findColour(PlugDataColour::canvasTextColourId);
         if(layoutTextHash != currentLayoutHash || colour.getARGB() != lastColourARGB || textWidth != lastTextWidth)
         {
-            auto attributedText = AttributedString(objText);
-            attributedText.setColour(colour);
-            attributedText.setJustification(Justification::centredLeft);
-            attributedText.setFont(Font(15));
-            
-            textLayout = TextLayout();
-            textLayout.createLayout(attributedText, textWidth);
+            textLayout = TextLayoutCache::getLayout(objText, Font(15), colour, Justification::centredLeft, textWidth);
             layoutTextHash = currentLayoutHash;
             lastColourARGB = colour.getARGB();
             lastTextWidth = textWidth;
@@ -429,6 +428,7 @@ public:
             outgoingEditor.reset();
 
             repaint();
+            object->updateBufferedToImage();
 
             // update if the name has changed, or if pdobject is unassigned
             if (changed) {
@@ -471,6 +471,7 @@ public:
 
             resized();
             repaint();
+            object->updateBufferedToImage();
         }
     }
 
@@ -150,6 +150,14 @@ public:
         repaint();
     }
 
+    bool receiveObjectFloat(float newValue) override
+    {
+        if (newValue != value)
+            setToggleStateFromFloat(newValue);
+
+        return true;
+    }
+
     void receiveObjectMessage(hash32 symbol, pd::Atom const atoms[8], int numAtoms) override
     {
         switch (symbol) {
@@ -161,7 +161,8 @@ public:
     {
         switch (symbol) {
         case hash("float"): {
-            repaint();
+            // pd sends a new level for every block, so only repaint once per frame
+            cnv->repaintCoordinator.repaint(this);
             break;
         }
         default: {
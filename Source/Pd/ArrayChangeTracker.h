@@ -0,0 +1,81 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+#pragma once
+
+namespace pd {
+
+// Keeps a change counter and the changed range of samples for every array that we know was written to
+// Array views remember the last counter they have seen, so they can skip reading the array if nothing changed,
+// or only read back the part that changed if the writer told us which samples it wrote to
+class ArrayChangeTracker {
+public:
+    static constexpr size_t wholeArray = std::numeric_limits<size_t>::max();
+
+    // Marks a range of samples of an array as changed, and returns the new change counter of that array
+    // If the writer doesn't know which samples changed, the whole array is marked as changed
+    uint32 markChanged(void* array, size_t start = 0, size_t end = wholeArray)
+    {
+        SpinLock::ScopedLockType lock(changesLock);
+
+        auto& changes = arrayChanges[array];
+        changes.counter++;
+        changes.history[changes.counter % historySize] = { start, end };
+        return changes.counter;
+    }
+
+    // Returns the range of samples that changed since the counter that the caller saw last, and updates that counter
+    // Returns an empty range if nothing changed, or the whole array if we don't know exactly what changed
+    Range<size_t> getChangesSince(void* array, uint32& lastSeenCounter)
+    {
+        SpinLock::ScopedLockType lock(changesLock);
+
+        auto it = arrayChanges.find(array);
+        auto const counter = it != arrayChanges.end() ? it->second.counter : initialCounter;
+        auto const numChanges = counter - lastSeenCounter;
+        bool const isFirstRead = lastSeenCounter == 0;
+        lastSeenCounter = counter;
+
+        if (numChanges == 0)
+            return {};
+
+        // Views that didn't read the array before need to read everything, and so do views that missed too many changes to remember
+        if (isFirstRead || numChanges >= historySize || it == arrayChanges.end())
+            return { 0, wholeArray };
+
+        auto const& changes = it->second;
+
+        size_t start = wholeArray, end = 0;
+        for (uint32 i = 0; i < numChanges; i++) {
+            auto const& change = changes.history[(changes.counter - i) % historySize];
+            start = std::min(start, change.first);
+            end = std::max(end, change.second);
+        }
+
+        return { start, end };
+    }
+
+    void clear(void* array)
+    {
+        SpinLock::ScopedLockType lock(changesLock);
+        arrayChanges.erase(array);
+    }
+
+private:
+    static constexpr uint32 historySize = 16;
+
+    // Starts at 1, so that views that haven't read the array yet (with a last seen counter of 0) will always read everything
+    static constexpr uint32 initialCounter = 1;
+
+    struct Changes {
+        uint32 counter = initialCounter;
+        std::array<std::pair<size_t, size_t>, historySize> history;
+    };
+
+    SpinLock changesLock;
+    std::unordered_map<void*, Changes> arrayChanges;
+};
+
+}
@@ -0,0 +1,222 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Utility/Config.h"
+
+extern "C" {
+#include <m_pd.h>
+#include <g_canvas.h>
+#include <m_imp.h>
+}
+
+#include "Instance.h"
+#include "BusIndex.h"
+#include "Interface.h"
+
+namespace pd {
+
+// Which bus an object class uses, and how
+static std::optional<std::pair<BusIndex::Kind, BusIndex::Role>> getBusType(String const& className)
+{
+    using Kind = BusIndex::Kind;
+    using Role = BusIndex::Role;
+
+    static std::unordered_map<String, std::pair<Kind, Role>> const busTypes = {
+        { "s", { Kind::Message, Role::Sender } },
+        { "send", { Kind::Message, Role::Sender } },
+        { "r", { Kind::Message, Role::Receiver } },
+        { "receive", { Kind::Message, Role::Receiver } },
+        { "s~", { Kind::Signal, Role::Sender } },
+        { "send~", { Kind::Signal, Role::Sender } },
+        { "r~", { Kind::Signal, Role::Receiver } },
+        { "receive~", { Kind::Signal, Role::Receiver } },
+        { "throw~", { Kind::Throw, Role::Sender } },
+        { "catch~", { Kind::Throw, Role::Receiver } },
+        { "v", { Kind::Value, Role::Shared } },
+        { "value", { Kind::Value, Role::Shared } },
+    };
+
+    if (auto it = busTypes.find(className); it != busTypes.end())
+        return it->second;
+
+    return std::nullopt;
+}
+
+static t_canvas* getRootCanvas(t_canvas* canvas)
+{
+    while (canvas->gl_owner)
+        canvas = canvas->gl_owner;
+    return canvas;
+}
+
+BusIndex::BusIndex(Instance* parentInstance)
+    : instance(parentInstance)
+{
+}
+
+void BusIndex::objectChanged(t_gobj* object, t_canvas* canvas)
+{
+    if (!isValid)
+        return;
+
+    objectRemoved(object);
+    if (isValid)
+        addObject(object, canvas);
+}
+
+void BusIndex::objectRemoved(t_gobj* object)
+{
+    if (!isValid)
+        return;
+
+    // We don't keep track of what's inside a subpatch, so we can't remove that
+    if (pd_class(&object->g_pd) == canvas_class) {
+        invalidate();
+        return;
+    }
+
+    entries.erase(object);
+}
+
+void BusIndex::addObject(t_gobj* object, t_canvas* canvas)
+{
+    if (pd_class(&object->g_pd) == canvas_class) {
+        auto* subpatch = reinterpret_cast<t_canvas*>(object);
+        for (auto* y = subpatch->gl_list; y; y = y->g_next) {
+            addObject(y, subpatch);
+        }
+        return;
+    }
+
+    auto* textObject = pd::Interface::checkObject(object);
+    if (!textObject || textObject->te_type != T_OBJECT || !textObject->te_binbuf)
+        return;
+
+    auto const argc = binbuf_getnatom(textObject->te_binbuf);
+    auto* argv = binbuf_getvec(textObject->te_binbuf);
+    if (argc < 2 || argv[0].a_type != A_SYMBOL)
+        return;
+
+    auto const type = String::fromUTF8(atom_getsymbol(argv)->s_name);
+    auto busType = getBusType(type);
+    if (!busType)
+        return;
+
+    // Without a name argument, sends and receives are connected through an inlet instead
+    // Names like $0-foo are expanded the same way the object did, otherwise different abstraction instances would share a bus
+    t_symbol* name = nullptr;
+    if (argv[1].a_type == A_DOLLSYM) {
+        name = canvas_realizedollar(canvas, argv[1].a_w.w_symbol);
+    } else if (argv[1].a_type == A_DOLLAR) {
+        name = canvas_realizedollar(canvas, gensym(("$" + String(argv[1].a_w.w_index)).toRawUTF8()));
+    }
+
+    String busName;
+    if (name) {
+        busName = String::fromUTF8(name->s_name);
+    } else {
+        char nameBuffer[MAXPDSTRING];
+        atom_string(argv + 1, nameBuffer, MAXPDSTRING);
+        busName = String::fromUTF8(nameBuffer);
+    }
+
+    entries.erase(object);
+    entries.emplace(object, Entry { WeakReference(object, instance), busType->first, busType->second, busName, type, canvas, getRootCanvas(canvas) });
+}
+
+void BusIndex::update()
+{
+    instance->lockAudioThread();
+
+    std::vector<t_canvas*> currentRootCanvases;
+    for (auto* x = pd_getcanvaslist(); x; x = x->gl_next) {
+        currentRootCanvases.push_back(x);
+    }
+
+    if (currentRootCanvases != rootCanvases)
+        invalidate();
+
+    for (auto it = entries.begin(); isValid && it != entries.end();) {
+        if (it->second.reference.isValid())
+            ++it;
+        else
+            it = entries.erase(it);
+    }
+
+    if (!isValid) {
+        entries.clear();
+        for (auto* canvas : currentRootCanvases) {
+            for (auto* y = canvas->gl_list; y; y = y->g_next) {
+                addObject(y, canvas);
+            }
+        }
+        rootCanvases = currentRootCanvases;
+        isValid = true;
+    }
+
+    instance->unlockAudioThread();
+}
+
+std::map<BusIndex::BusKey, std::vector<BusIndex::User>> BusIndex::getAllBuses()
+{
+    update();
+
+    std::map<BusKey, std::vector<User>> buses;
+    for (auto const& [object, entry] : entries) {
+        buses[{ entry.kind, entry.name }].push_back({ object, entry.canvas, entry.rootCanvas, entry.type, entry.role });
+    }
+
+    return buses;
+}
+
+std::vector<BusIndex::User> BusIndex::getUsers(Kind kind, String const& name)
+{
+    update();
+
+    std::vector<User> users;
+    for (auto const& [object, entry] : entries) {
+        if (entry.kind == kind && entry.name == name)
+            users.push_back({ object, entry.canvas, entry.rootCanvas, entry.type, entry.role });
+    }
+
+    return users;
+}
+
+std::set<t_canvas*> BusIndex::getConnectedPatches(t_canvas* rootCanvas)
+{
+    std::set<t_canvas*> connectedPatches;
+    for (auto const& [key, users] : getAllBuses()) {
+        auto const usedByPatch = std::any_of(users.begin(), users.end(), [rootCanvas](User const& user) { return user.rootCanvas == rootCanvas; });
+        if (!usedByPatch)
+            continue;
+
+        for (auto const& user : users) {
+            if (user.rootCanvas != rootCanvas)
+                connectedPatches.insert(user.rootCanvas);
+        }
+    }
+
+    return connectedPatches;
+}
+
+String BusIndex::getKindName(Kind kind)
+{
+    switch (kind) {
+    case Kind::Message:
+        return "send/receive";
+    case Kind::Signal:
+        return "send~/receive~";
+    case Kind::Throw:
+        return "throw~/catch~";
+    case Kind::Value:
+        return "value";
+    }
+
+    return {};
+}
+
+} // namespace pd
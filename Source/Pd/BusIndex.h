@@ -0,0 +1,83 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+#pragma once
+
+#include <map>
+#include <set>
+#include "WeakReference.h"
+
+namespace pd {
+
+class Instance;
+
+// Index of the named buses in an instance: [send]/[receive], [send~]/[receive~], [throw~]/[catch~] and [value]
+// Creating, renaming and removing objects updates it per object. Anything we can't follow that closely, like pasting,
+// undo or opening a patch, makes it scan all patches again on the next query
+// Bus names are stored with $0 and arguments expanded, so every abstraction instance has its own buses, just like in Pd
+// Only use from the message thread
+class BusIndex {
+public:
+    enum class Kind {
+        Message,
+        Signal,
+        Throw,
+        Value
+    };
+
+    enum class Role {
+        Sender,
+        Receiver,
+        Shared
+    };
+
+    struct User {
+        t_gobj* object;
+        t_canvas* canvas;     // The canvas that contains the object
+        t_canvas* rootCanvas; // The patch it's part of
+        String type;          // The name of the object, like "s" or "throw~"
+        Role role;
+    };
+
+    using BusKey = std::pair<Kind, String>;
+
+    explicit BusIndex(Instance* instance);
+
+    // Called by Patch when it edits a patch
+    void objectChanged(t_gobj* object, t_canvas* canvas);
+    void objectRemoved(t_gobj* object);
+
+    void invalidate() { isValid = false; }
+
+    std::map<BusKey, std::vector<User>> getAllBuses();
+    std::vector<User> getUsers(Kind kind, String const& name);
+
+    // Other patches that this patch sends to or receives from over a bus, so they can't be processed independently
+    std::set<t_canvas*> getConnectedPatches(t_canvas* rootCanvas);
+
+    static String getKindName(Kind kind);
+
+private:
+    struct Entry {
+        WeakReference reference; // Objects can also be deleted by Pd itself, for example with dynamic patching
+        Kind kind;
+        Role role;
+        String name;
+        String type;
+        t_canvas* canvas;
+        t_canvas* rootCanvas;
+    };
+
+    // Scans all patches again if we lost track of them, and drops objects that were deleted without telling us
+    void update();
+    void addObject(t_gobj* object, t_canvas* canvas);
+
+    Instance* instance;
+    std::unordered_map<t_gobj*, Entry> entries;
+    std::vector<t_canvas*> rootCanvases;
+    bool isValid = false;
+};
+
+} // namespace pd
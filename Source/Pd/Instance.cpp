@@ -8,6 +8,8 @@
 
 #include "Utility/Config.h"
 #include "Utility/Fonts.h"
+#include "Utility/RealtimeSafety.h"
+#include "Utility/Tracing.h"
 #include "Dialogs/Dialogs.h"
 
 #include <algorithm>
@@ -15,7 +17,9 @@
 #include "Patch.h"
 #include "MessageListener.h"
 #include "Objects/ImplementationBase.h"
+#include "Objects/AllGuis.h"
 #include "Utility/SettingsFile.h"
+#include "Utility/MidiDeviceManager.h"
 
 extern "C" {
 
@@ -27,96 +31,119 @@ extern "C" {
 #include "z_print_util.h"
 
 EXTERN int sys_load_lib(t_canvas* canvas, char const* classname);
+EXTERN t_glist* clone_get_instance(t_gobj* x, int n);
+EXTERN int clone_get_n(t_gobj* x);
 
 struct pd::Instance::internal {
 
+    // Only floats and symbols are kept, like pd::Atom does, see HookMessage::getAtoms
+    static void copyAtoms(t_atom const* source, int argc, t_atom* destination)
+    {
+        for (int i = 0; i < argc; i++) {
+            if (source[i].a_type == A_FLOAT || source[i].a_type == A_SYMBOL)
+                destination[i] = source[i];
+            else
+                SETFLOAT(destination + i, 0);
+        }
+    }
+
+    // Stores a message from Pd in the preallocated hook queue, so we don't allocate on the audio thread
+    static void enqueueMessage(pd::Instance* ptr, char const* recv, t_symbol* selector, int argc, t_atom* argv)
+    {
+        HookMessage message;
+        message.type = HookMessage::PdMessage;
+        message.destination = gensym(recv);
+        message.selector = selector;
+        message.numAtoms = argc;
+        message.overflowAtoms = nullptr;
+
+        // Rare case: doesn't fit inside a HookMessage, so we have to allocate
+        // It still goes through the same queue, so it stays in order with the other messages
+        if (argc > HookMessage::maxAtoms) {
+            message.overflowAtoms = new t_atom[argc];
+            copyAtoms(argv, argc, message.overflowAtoms);
+        } else {
+            copyAtoms(argv, argc, message.atoms);
+        }
+
+        ptr->enqueueHookMessage(message);
+    }
+
+    static void enqueueMidi(pd::Instance* ptr, HookMessage::Type type, int channel, int firstValue, int secondValue = 0)
+    {
+        HookMessage message;
+        message.type = type;
+        message.numAtoms = 0;
+        message.overflowAtoms = nullptr;
+        message.midi[0] = channel + 1;
+        message.midi[1] = firstValue;
+        message.midi[2] = secondValue;
+        message.sampleOffset = ptr->tickOffset;
+        ptr->enqueueHookMessage(message);
+    }
+
     static void instance_multi_bang(pd::Instance* ptr, char const* recv)
     {
-        ptr->enqueueFunctionAsync([ptr, recv]() { ptr->processMessage({ String("bang"), String::fromUTF8(recv) }); });
+        enqueueMessage(ptr, recv, &s_bang, 0, nullptr);
     }
 
     static void instance_multi_float(pd::Instance* ptr, char const* recv, float f)
     {
-        ptr->enqueueFunctionAsync([ptr, recv, f]() mutable { ptr->processMessage({ String("float"), String::fromUTF8(recv), std::vector<Atom>(1, { f }) }); });
+        t_atom atom;
+        SETFLOAT(&atom, f);
+        enqueueMessage(ptr, recv, &s_float, 1, &atom);
     }
 
     static void instance_multi_symbol(pd::Instance* ptr, char const* recv, char const* sym)
     {
-        ptr->enqueueFunctionAsync([ptr, recv, sym]() mutable { ptr->processMessage({ String("symbol"), String::fromUTF8(recv), std::vector<Atom>(1, ptr->generateSymbol(sym)) }); });
+        t_atom atom;
+        SETSYMBOL(&atom, gensym(sym));
+        enqueueMessage(ptr, recv, &s_symbol, 1, &atom);
     }
 
     static void instance_multi_list(pd::Instance* ptr, char const* recv, int argc, t_atom* argv)
     {
-        Message mess { String("list"), String::fromUTF8(recv), std::vector<Atom>(argc) };
-        for (int i = 0; i < argc; ++i) {
-            if (argv[i].a_type == A_FLOAT)
-                mess.list[i] = Atom(atom_getfloat(argv + i));
-            else if (argv[i].a_type == A_SYMBOL)
-                mess.list[i] = Atom(atom_getsymbol(argv + i));
-        }
-
-        ptr->enqueueFunctionAsync([ptr, mess]() mutable { ptr->processMessage(mess); });
+        enqueueMessage(ptr, recv, &s_list, argc, argv);
     }
 
     static void instance_multi_message(pd::Instance* ptr, char const* recv, char const* msg, int argc, t_atom* argv)
     {
-        Message mess { msg, String::fromUTF8(recv), std::vector<Atom>(argc) };
-        for (int i = 0; i < argc; ++i) {
-            if (argv[i].a_type == A_FLOAT)
-                mess.list[i] = Atom(atom_getfloat(argv + i));
-            else if (argv[i].a_type == A_SYMBOL)
-                mess.list[i] = Atom(atom_getsymbol(argv + i));
-        }
-        ptr->enqueueFunctionAsync([ptr, mess]() mutable { ptr->processMessage(std::move(mess)); });
+        enqueueMessage(ptr, recv, gensym(msg), argc, argv);
     }
 
     static void instance_multi_noteon(pd::Instance* ptr, int channel, int pitch, int velocity)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, pitch, velocity]() mutable {
-            ptr->receiveNoteOn(channel + 1, pitch, velocity);
-        });
+        enqueueMidi(ptr, HookMessage::NoteOn, channel, pitch, velocity);
     }
 
     static void instance_multi_controlchange(pd::Instance* ptr, int channel, int controller, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, controller, value]() mutable {
-            ptr->receiveControlChange(channel + 1, controller, value);
-        });
+        enqueueMidi(ptr, HookMessage::ControlChange, channel, controller, value);
     }
 
     static void instance_multi_programchange(pd::Instance* ptr, int channel, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, value]() mutable {
-            ptr->receiveProgramChange(channel + 1, value);
-        });
+        enqueueMidi(ptr, HookMessage::ProgramChange, channel, value);
     }
 
     static void instance_multi_pitchbend(pd::Instance* ptr, int channel, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, value]() mutable {
-            ptr->receivePitchBend(channel + 1, value);
-        });
+        enqueueMidi(ptr, HookMessage::PitchBend, channel, value);
     }
 
     static void instance_multi_aftertouch(pd::Instance* ptr, int channel, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, value]() mutable {
-            ptr->receiveAftertouch(channel + 1, value);
-        });
+        enqueueMidi(ptr, HookMessage::Aftertouch, channel, value);
     }
 
     static void instance_multi_polyaftertouch(pd::Instance* ptr, int channel, int pitch, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, pitch, value]() mutable {
-            ptr->receivePolyAftertouch(channel + 1, pitch, value);
-        });
+        enqueueMidi(ptr, HookMessage::PolyAftertouch, channel, pitch, value);
     }
 
     static void instance_multi_midibyte(pd::Instance* ptr, int port, int byte)
     {
-        ptr->enqueueFunctionAsync([ptr, port, byte]() mutable {
-            ptr->receiveMidiByte(port + 1, byte);
-        });
+        enqueueMidi(ptr, HookMessage::MidiByte, port, byte);
     }
 
     static void instance_multi_print(pd::Instance* ptr, void* object, char const* s)
@@ -138,6 +165,10 @@ Instance::Instance(String const& symbol)
 
 Instance::~Instance()
 {
+    // Don't lose patches that are still being saved
+    while (patchSaveThread.getNumJobs() > 0)
+        Thread::sleep(1);
+
     pd_free(static_cast<t_pd*>(messageReceiver));
     pd_free(static_cast<t_pd*>(midiReceiver));
     pd_free(static_cast<t_pd*>(printReceiver));
@@ -147,8 +178,22 @@ Instance::~Instance()
     // JYG added this
     pd_free(static_cast<t_pd*>(dataBufferReceiver));
 
+    HookMessage message;
+    while (hookQueue.try_dequeue(message)) {
+        delete[] message.overflowAtoms;
+    }
+
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
+    if (clipboardContents)
+        binbuf_free(clipboardContents);
     libpd_free_instance(static_cast<t_pdinstance*>(instance));
+
+    // References that outlive the instance keep their slot, but they won't find the object anymore
+    for (auto& [ptr, slot] : pdWeakReferences) {
+        slot->alive.store(false, std::memory_order_release);
+        slot->release();
+    }
+    pdWeakReferences.clear();
 }
 
 // ag: Stuff to be done after unpacking the library data on first launch.
@@ -158,6 +203,12 @@ void Instance::initialisePd(String& pdlua_version)
 
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
 
+    midiInSymbol = gensym("#midiin");
+    pdSymbol = gensym("pd");
+    paramSymbol = gensym("param");
+    paramChangeSymbol = gensym("param_change");
+    dataBufferSymbol = gensym("to_daw_databuffer");
+
     setup_lock(
         static_cast<void const*>(&audioLock),
         [](void* lock) {
@@ -173,16 +224,14 @@ void Instance::initialisePd(String& pdlua_version)
         },
         [](void* instance, void* ref, void* weakref) {
             auto** reference_state = reinterpret_cast<pd_weak_reference**>(weakref);
-            *reference_state = new pd_weak_reference(true);
-            static_cast<pd::Instance*>(instance)->registerWeakReference(ref, *reference_state);
+            *reference_state = static_cast<pd::Instance*>(instance)->acquireWeakReference(ref);
         },
         [](void* instance, void* ref, void* weakref) {
             auto** reference_state = reinterpret_cast<pd_weak_reference**>(weakref);
-            static_cast<pd::Instance*>(instance)->unregisterWeakReference(ref, *reference_state);
-            delete *reference_state;
+            (*reference_state)->release();
         },
         [](void* ref) -> int {
-            return ((pd_weak_reference*)ref)->load();
+            return static_cast<pd_weak_reference*>(ref)->isAlive();
         });
 
     midiReceiver = pd::Setup::createMIDIHook(this, reinterpret_cast<t_plugdata_noteonhook>(internal::instance_multi_noteon), reinterpret_cast<t_plugdata_controlchangehook>(internal::instance_multi_controlchange), reinterpret_cast<t_plugdata_programchangehook>(internal::instance_multi_programchange),
@@ -202,8 +251,6 @@ void Instance::initialisePd(String& pdlua_version)
     parameterChangeReceiver = pd::Setup::createReceiver(this, "param_change", reinterpret_cast<t_plugdata_banghook>(internal::instance_multi_bang), reinterpret_cast<t_plugdata_floathook>(internal::instance_multi_float), reinterpret_cast<t_plugdata_symbolhook>(internal::instance_multi_symbol),
         reinterpret_cast<t_plugdata_listhook>(internal::instance_multi_list), reinterpret_cast<t_plugdata_messagehook>(internal::instance_multi_message));
 
-    atoms = malloc(sizeof(t_atom) * 512);
-
     // Register callback when pd's gui changes
     // Needs to be done on pd's thread
     auto gui_trigger = [](void* instance, char const* name, int argc, t_atom* argv) {
@@ -255,9 +302,7 @@ void Instance::initialisePd(String& pdlua_version)
         }
         case hash("cyclone_editor_append"): {
             auto ptr = (unsigned long)argv->a_w.w_gpointer;
-            auto text = String::fromUTF8(atom_getsymbol(argv + 1)->s_name);
-
-            static_cast<Instance*>(instance)->addTextToTextEditor(ptr, text);
+            static_cast<Instance*>(instance)->addTextToTextEditor(ptr, atom_getsymbol(argv + 1)->s_name);
             break;
         }
         }
@@ -315,7 +360,13 @@ void Instance::initialisePd(String& pdlua_version)
 
 int Instance::getBlockSize() const
 {
-    return libpd_blocksize();
+    return blockSize;
+}
+
+// Processing multiple Pd blocks at once means we have less overhead from handling messages and MIDI in between blocks
+void Instance::setBlockSize(int numSamples)
+{
+    blockSize = std::max<int>(DEFDACBLKSIZE, (numSamples / DEFDACBLKSIZE) * DEFDACBLKSIZE);
 }
 
 void Instance::prepareDSP(int const nins, int const nouts, double const samplerate, int const blockSize)
@@ -331,6 +382,11 @@ void Instance::startDSP()
     libpd_message("pd", "dsp", 1, &av);
 }
 
+bool Instance::isDSPRunning() const
+{
+    return static_cast<t_pdinstance*>(instance)->pd_dspstate != 0;
+}
+
 void Instance::releaseDSP()
 {
     t_atom av;
@@ -339,10 +395,143 @@ void Instance::releaseDSP()
     libpd_message("pd", "dsp", 1, &av);
 }
 
-void Instance::performDSP(float const* inputs, float* outputs)
+// Same as libpd_process_raw, except it takes non-interleaved channel pointers
+// This allows us to pass in the host buffer directly, instead of copying it to a contiguous buffer first
+// Processes getBlockSize() samples, which can be multiple Pd ticks
+// If midiInput is set, its events will be sent right before the Pd tick they fall into
+void Instance::performDSP(float const* const* inputs, int numInputs, float* const* outputs, int numOutputs, MidiBuffer const* midiInput)
 {
+    Tracing::ScopedEvent traceEvent("performDSP");
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
-    libpd_process_raw(inputs, outputs);
+
+    auto const tickSize = static_cast<size_t>(DEFDACBLKSIZE);
+    auto const numTicks = getBlockSize() / DEFDACBLKSIZE;
+    auto const pdInputs = STUFF->st_inchannels;
+    auto const pdOutputs = STUFF->st_outchannels;
+
+    auto const lockStartTicks = Time::getHighResolutionTicks();
+    sys_lock();
+    lockWaitTicks += Time::getHighResolutionTicks() - lockStartTicks;
+    sys_pollgui();
+
+    // Pd reallocates the chain whenever it's rebuilt, and setting the channels of a dac~ rebuilds it as well
+    // Patch edits are checked too, in case the new chain ended up at the same address with the same size
+    if (pd_this->pd_dspchain != lastDspChain || pd_this->pd_dspchainsize != lastDspChainSize || patchEdited.load()) {
+        lastDspChain = pd_this->pd_dspchain;
+        lastDspChainSize = pd_this->pd_dspchainsize;
+        updateChannelUsage();
+        dspChainChanged();
+
+        // adc~ never writes into the input buffer, so unused inputs only need to be cleared once
+        for (int ch = 0; ch < pdInputs; ch++) {
+            if (!isInputChannelUsed(ch))
+                std::fill(STUFF->st_soundin + ch * tickSize, STUFF->st_soundin + (ch + 1) * tickSize, 0.0f);
+        }
+    }
+
+    for (int tick = 0; tick < numTicks; tick++) {
+        auto const offset = tick * tickSize;
+        tickOffset = static_cast<int>(offset);
+
+        if (midiInput)
+            sendMidiEvents(*midiInput, tickOffset, DEFDACBLKSIZE);
+
+        for (int ch = 0; ch < pdInputs; ch++) {
+            if (!isInputChannelUsed(ch))
+                continue;
+
+            auto* soundIn = STUFF->st_soundin + ch * tickSize;
+            if (ch < numInputs) {
+                std::copy(inputs[ch] + offset, inputs[ch] + offset + tickSize, soundIn);
+            } else {
+                std::fill(soundIn, soundIn + tickSize, 0.0f);
+            }
+        }
+
+        // dac~ adds to the output buffer, so it has to be cleared before every tick
+        for (int ch = 0; ch < pdOutputs; ch++) {
+            if (isOutputChannelUsed(ch))
+                std::fill(STUFF->st_soundout + ch * tickSize, STUFF->st_soundout + (ch + 1) * tickSize, 0.0f);
+        }
+
+        sched_tick();
+
+        for (int ch = 0; ch < std::min(pdOutputs, numOutputs); ch++) {
+            if (isOutputChannelUsed(ch)) {
+                auto* soundOut = STUFF->st_soundout + ch * tickSize;
+                std::copy(soundOut, soundOut + tickSize, outputs[ch] + offset);
+            } else {
+                // The host buffer still contains the input, since we process in-place
+                std::fill(outputs[ch] + offset, outputs[ch] + offset + tickSize, 0.0f);
+            }
+        }
+    }
+
+    tickOffset = 0;
+
+    for (auto* source : displaySources) {
+        source->publishDisplayData();
+    }
+
+    sys_unlock();
+}
+
+bool Instance::isInputChannelUsed(int channel) const
+{
+    return channel >= maxTrackedChannels || usedInputChannels[channel];
+}
+
+bool Instance::isOutputChannelUsed(int channel) const
+{
+    return channel >= maxTrackedChannels || usedOutputChannels[channel];
+}
+
+// Recursive, so we don't need a std::function on the audio thread
+template<size_t NumChannels>
+static void findUsedChannels(t_glist* glist, std::bitset<NumChannels>& inputs, std::bitset<NumChannels>& outputs)
+{
+    // Every instance has its own symbol table, so class names have to be compared as strings
+    auto* dspSymbol = gensym("dsp");
+
+    // adc~ and dac~ share the same layout, with 1-based channel numbers
+    auto markChannels = [](t_gobj* object, std::bitset<NumChannels>& channels) {
+        auto* dac = reinterpret_cast<t_fake_dac*>(object);
+        for (int i = 0; i < dac->x_n; i++) {
+            auto const channel = static_cast<int>(dac->x_vec[i]) - 1;
+            if (isPositiveAndBelow(channel, static_cast<int>(NumChannels)))
+                channels.set(channel);
+        }
+    };
+
+    for (auto* y = glist->gl_list; y; y = y->g_next) {
+        auto* objectClass = pd_class(&y->g_pd);
+        auto const* className = objectClass->c_name->s_name;
+        if (std::strcmp(className, "dac~") == 0) {
+            markChannels(y, outputs);
+        } else if (std::strcmp(className, "adc~") == 0) {
+            markChannels(y, inputs);
+        } else if (std::strcmp(className, "clone") == 0) {
+            for (int i = 0; i < clone_get_n(y); i++) {
+                findUsedChannels(clone_get_instance(y, i), inputs, outputs);
+            }
+        } else if (objectClass == canvas_class) {
+            findUsedChannels(reinterpret_cast<t_glist*>(y), inputs, outputs);
+        } else if (objectClass->c_externdir && *objectClass->c_externdir->s_name && zgetfn(&y->g_pd, dspSymbol)) {
+            // Externals that were loaded from disk could read or write the sound buffers directly, so we assume they use all channels
+            inputs.set();
+            outputs.set();
+        }
+    }
+}
+
+void Instance::updateChannelUsage()
+{
+    usedInputChannels.reset();
+    usedOutputChannels.reset();
+
+    for (auto* x = pd_getcanvaslist(); x; x = x->gl_next) {
+        findUsedChannels(x, usedInputChannels, usedOutputChannels);
+    }
 }
 
 void Instance::sendNoteOn(int const channel, int const pitch, int const velocity) const
@@ -399,13 +588,72 @@ void Instance::sendMidiByte(int const port, int const byte) const
     libpd_midibyte(port, byte);
 }
 
+// Calls Pd's MIDI input functions directly, instead of the libpd wrappers that lock and unlock for every single message
+void Instance::sendMidiEvents(MidiBuffer const& events, int startSample, int numSamples)
+{
+    if (events.isEmpty())
+        return;
+
+    libpd_set_instance(static_cast<t_pdinstance*>(instance));
+
+    sys_lock();
+
+    for (auto it = events.findNextSamplePosition(startSample); it != events.cend(); ++it) {
+        auto const event = *it;
+        if (event.samplePosition - startSample >= numSamples)
+            break;
+
+        int port;
+        auto message = MidiDeviceManager::convertFromSysExFormat(event.getMessage(), port);
+
+        auto channel = message.getChannel() - 1;
+
+        if (message.isNoteOn()) {
+            inmidi_noteon(port, channel, message.getNoteNumber(), message.getVelocity());
+        } else if (message.isNoteOff()) {
+            inmidi_noteon(port, channel, message.getNoteNumber(), 0);
+        } else if (message.isController()) {
+            inmidi_controlchange(port, channel, message.getControllerNumber(), message.getControllerValue());
+        } else if (message.isPitchWheel()) {
+            inmidi_pitchbend(port, channel, message.getPitchWheelValue());
+        } else if (message.isChannelPressure()) {
+            inmidi_aftertouch(port, channel, message.getChannelPressureValue());
+        } else if (message.isAftertouch()) {
+            inmidi_polyaftertouch(port, channel, message.getNoteNumber(), message.getAfterTouchValue());
+        } else if (message.isProgramChange()) {
+            inmidi_programchange(port, channel, message.getProgramChangeNumber());
+        } else if (message.isSysEx()) {
+            for (int i = 0; i < message.getSysExDataSize(); ++i) {
+                inmidi_sysex(port, static_cast<int>(message.getSysExData()[i]));
+            }
+        } else if (message.isMidiClock() || message.isMidiStart() || message.isMidiStop() || message.isMidiContinue() || message.isActiveSense() || (message.getRawDataSize() == 1 && message.getRawData()[0] == 0xff)) {
+            for (int i = 0; i < message.getRawDataSize(); ++i) {
+                inmidi_realtimein(port, static_cast<int>(message.getRawData()[i]));
+            }
+        }
+
+        // Raw bytes only end up at [midiin], don't bother if there aren't any
+        if (midiInSymbol->s_thing) {
+            for (int i = 0; i < message.getRawDataSize(); i++) {
+                inmidi_byte(port, static_cast<int>(message.getRawData()[i]));
+            }
+        }
+    }
+
+    sys_unlock();
+}
+
 void Instance::sendBang(char const* receiver) const
 {
     if (!ProjectInfo::isStandalone && !instance)
         return;
 
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
-    libpd_bang(receiver);
+
+    sys_lock();
+    if (auto* destination = generateSymbol(receiver)->s_thing)
+        pd_bang(destination);
+    sys_unlock();
 }
 
 void Instance::sendFloat(char const* receiver, float const value) const
@@ -415,7 +663,10 @@ void Instance::sendFloat(char const* receiver, float const value) const
 
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
 
-    libpd_float(receiver, value);
+    sys_lock();
+    if (auto* destination = generateSymbol(receiver)->s_thing)
+        pd_float(destination, value);
+    sys_unlock();
 }
 
 void Instance::sendSymbol(char const* receiver, char const* symbol) const
@@ -424,66 +675,61 @@ void Instance::sendSymbol(char const* receiver, char const* symbol) const
         return;
 
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
-    libpd_symbol(receiver, symbol);
+
+    sys_lock();
+    if (auto* destination = generateSymbol(receiver)->s_thing)
+        pd_symbol(destination, generateSymbol(symbol));
+    sys_unlock();
 }
 
-void Instance::sendList(char const* receiver, std::vector<Atom> const& list) const
+void Instance::sendList(char const* receiver, std::span<Atom const> list) const
 {
-    auto* argv = static_cast<t_atom*>(atoms);
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
-    for (size_t i = 0; i < list.size(); ++i) {
-        if (list[i].isFloat())
-            libpd_set_float(argv + i, list[i].getFloat());
-        else
-            libpd_set_symbol(argv + i, list[i].getSymbol()->s_name);
-    }
-    libpd_list(receiver, static_cast<int>(list.size()), argv);
+
+    sys_lock();
+    if (auto* destination = generateSymbol(receiver)->s_thing)
+        pd_list(destination, &s_list, static_cast<int>(list.size()), Atom::toAtoms(list.data()));
+    sys_unlock();
 }
 
-void Instance::sendTypedMessage(void* object, char const* msg, std::vector<Atom> const& list) const
+void Instance::sendTypedMessage(void* object, char const* msg, std::span<Atom const> list) const
 {
     if (!object)
         return;
 
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
 
-    auto* argv = static_cast<t_atom*>(atoms);
-
-    for (size_t i = 0; i < list.size(); ++i) {
-        if (list[i].isFloat())
-            libpd_set_float(argv + i, list[i].getFloat());
-        else
-            libpd_set_symbol(argv + i, list[i].getSymbol()->s_name);
-    }
-
-    pd_typedmess(static_cast<t_pd*>(object), generateSymbol(msg), static_cast<int>(list.size()), argv);
+    pd_typedmess(static_cast<t_pd*>(object), generateSymbol(msg), static_cast<int>(list.size()), Atom::toAtoms(list.data()));
 }
 
-void Instance::sendMessage(char const* receiver, char const* msg, std::vector<Atom> const& list) const
+void Instance::sendMessage(char const* receiver, char const* msg, std::span<Atom const> list) const
 {
     sendTypedMessage(generateSymbol(receiver)->s_thing, msg, list);
 }
 
-void Instance::processMessage(Message mess)
+void Instance::sendMessage(char const* receiver, char const* msg, std::initializer_list<Atom> list) const
+{
+    sendTypedMessage(generateSymbol(receiver)->s_thing, msg, std::span<Atom const>(list.begin(), list.size()));
+}
+
+void Instance::processMessage(t_symbol* destination, t_symbol* selector, std::span<pd::Atom const> list)
 {
-    if (mess.destination == "pd") {
-        receiveSysMessage(mess.selector, mess.list);
+    if (destination == pdSymbol) {
+        receiveSysMessage(selector, list);
     }
-    if (mess.destination == "param" && mess.list.size() >= 2) {
-        if (!mess.list[0].isSymbol() || !mess.list[1].isFloat())
+    if (destination == paramSymbol && list.size() >= 2) {
+        if (!list[0].isSymbol() || !list[1].isFloat())
             return;
-        auto name = mess.list[0].toString();
-        float value = mess.list[1].getFloat();
-        performParameterChange(0, name, value);
-    } else if (mess.destination == "param_change" && mess.list.size() >= 2) {
-        if (!mess.list[0].isSymbol() || !mess.list[1].isFloat())
+        float value = list[1].getFloat();
+        performParameterChange(0, list[0].getSymbol(), value);
+    } else if (destination == paramChangeSymbol && list.size() >= 2) {
+        if (!list[0].isSymbol() || !list[1].isFloat())
             return;
-        auto name = mess.list[0].toString();
-        int state = mess.list[1].getFloat() != 0;
-        performParameterChange(1, name, state);
+        int state = list[1].getFloat() != 0;
+        performParameterChange(1, list[0].getSymbol(), state);
         // JYG added This
-    } else if (mess.destination == "to_daw_databuffer") {
-        fillDataBuffer(mess.list);
+    } else if (destination == dataBufferSymbol) {
+        fillDataBuffer(list);
     }
 }
 
@@ -491,16 +737,7 @@ void Instance::processSend(dmessage mess)
 {
     if (auto obj = mess.object.get<t_pd>()) {
         if (mess.selector == "list") {
-            auto* argv = static_cast<t_atom*>(atoms);
-            for (size_t i = 0; i < mess.list.size(); ++i) {
-                if (mess.list[i].isFloat())
-                    SETFLOAT(argv + i, mess.list[i].getFloat());
-                else if (mess.list[i].isSymbol()) {
-                    SETSYMBOL(argv + i, mess.list[i].getSymbol());
-                } else
-                    SETFLOAT(argv + i, 0.0);
-            }
-            pd_list(obj.get(), generateSymbol("list"), static_cast<int>(mess.list.size()), argv);
+            pd_list(obj.get(), generateSymbol("list"), static_cast<int>(mess.list.size()), mess.list.getAtoms());
         } else if (mess.selector == "float" && !mess.list.empty() && mess.list[0].isFloat()) {
             pd_float(obj.get(), mess.list[0].getFloat());
         } else if (mess.selector == "symbol" && !mess.list.empty() && mess.list[0].isSymbol()) {
@@ -523,51 +760,129 @@ void Instance::unregisterMessageListener(void* object, MessageListener* messageL
     messageDispatcher->removeMessageListener(object, messageListener);
 }
 
-void Instance::registerWeakReference(void* ptr, pd_weak_reference* ref)
+// The map holds one reference to each slot until the object is freed, so the slot is reused by any new references to the same object
+pd_weak_reference* Instance::acquireWeakReference(void* ptr)
+{
+    std::lock_guard<std::mutex> lock(weakReferenceMutex);
+
+    auto*& slot = pdWeakReferences[ptr];
+    if (!slot)
+        slot = new pd_weak_reference();
+
+    slot->retain();
+    return slot;
+}
+
+void Instance::clearWeakReferences(void* ptr)
 {
-    weakReferenceMutex.lock();
-    pdWeakReferences[ptr].push_back(ref);
-    weakReferenceMutex.unlock();
+    pd_weak_reference* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(weakReferenceMutex);
+        auto it = pdWeakReferences.find(ptr);
+        if (it == pdWeakReferences.end())
+            return;
+
+        slot = it->second;
+        pdWeakReferences.erase(it);
+    }
+
+    // Arrays are referenced by the views that track their changes, so this is where we find out that one was deleted
+    // This also happens for all arrays in a patch when it's closed
+    arrayChanges.clear(ptr);
+
+    slot->alive.store(false, std::memory_order_release);
+    slot->release();
 }
 
-void Instance::unregisterWeakReference(void* ptr, pd_weak_reference const* ref)
+void Instance::enqueueFunctionAsync(std::function<void(void)> const& fn)
 {
-    weakReferenceMutex.lock();
+    functionQueue.enqueue(fn);
+}
 
-    auto& refs = pdWeakReferences[ptr];
+Instance::MessageQueueStatistics Instance::getMessageQueueStatistics() const
+{
+    return { messageDispatcher->getNumEnqueuedMessages(), messageDispatcher->getNumDroppedMessages(), messageDispatcher->getNumCoalescedMessages(), messageDispatcher->getMaxQueueDepth(), messageDispatcher->getQueueCapacity() };
+}
 
-    auto it = std::find(refs.begin(), refs.end(), ref);
+void Instance::setMessageProfilingEnabled(bool enabled)
+{
+    messageDispatcher->setProfilingEnabled(enabled);
+}
 
-    if (it != refs.end()) {
-        pdWeakReferences[ptr].erase(it);
-    }
+int64 Instance::getMessageCount(void* target) const
+{
+    return messageDispatcher->getMessageCount(target);
+}
 
-    weakReferenceMutex.unlock();
+void Instance::registerDisplaySource(DisplaySource* source)
+{
+    lockAudioThread();
+    displaySources.push_back(source);
+    unlockAudioThread();
 }
 
-void Instance::clearWeakReferences(void* ptr)
+void Instance::unregisterDisplaySource(DisplaySource* source)
 {
-    weakReferenceMutex.lock();
-    for (auto* ref : pdWeakReferences[ptr]) {
-        *ref = false;
+    lockAudioThread();
+    displaySources.erase(std::remove(displaySources.begin(), displaySources.end(), source), displaySources.end());
+    unlockAudioThread();
+}
+
+void Instance::enqueueCommand(WeakReference const& target, CommandCallback callback, float x, float y)
+{
+    if (target.getRawUnchecked<void>())
+        commandQueue.enqueue({ callback, target, x, y });
+}
+
+void Instance::enqueueHookMessage(HookMessage const& message)
+{
+    // try_enqueue never allocates: if the queue is full, we drop the message and report it later
+    if (!hookQueue.try_enqueue(message)) {
+        delete[] message.overflowAtoms;
+        numDroppedHookMessages++;
     }
-    pdWeakReferences.erase(ptr);
-    weakReferenceMutex.unlock();
 }
 
-void Instance::enqueueFunctionAsync(std::function<void(void)> const& fn)
+void Instance::processHookMessage(HookMessage const& message)
 {
-    functionQueue.enqueue(fn);
+    auto& midi = message.midi;
+    switch (message.type) {
+    case HookMessage::PdMessage:
+        processMessage(message.destination, message.selector, message.getAtoms());
+        delete[] message.overflowAtoms;
+        break;
+    case HookMessage::NoteOn:
+        receiveNoteOn(midi[0], midi[1], midi[2], message.sampleOffset);
+        break;
+    case HookMessage::ControlChange:
+        receiveControlChange(midi[0], midi[1], midi[2], message.sampleOffset);
+        break;
+    case HookMessage::ProgramChange:
+        receiveProgramChange(midi[0], midi[1], message.sampleOffset);
+        break;
+    case HookMessage::PitchBend:
+        receivePitchBend(midi[0], midi[1], message.sampleOffset);
+        break;
+    case HookMessage::Aftertouch:
+        receiveAftertouch(midi[0], midi[1], message.sampleOffset);
+        break;
+    case HookMessage::PolyAftertouch:
+        receivePolyAftertouch(midi[0], midi[1], midi[2], message.sampleOffset);
+        break;
+    case HookMessage::MidiByte:
+        receiveMidiByte(midi[0], midi[1], message.sampleOffset);
+        break;
+    }
 }
 
-void Instance::sendDirectMessage(void* object, String const& msg, std::vector<Atom>&& list)
+void Instance::sendDirectMessage(void* object, String const& msg, AtomList&& list)
 {
     lockAudioThread();
     processSend(dmessage(this, object, String(), msg, std::move(list)));
     unlockAudioThread();
 }
 
-void Instance::sendDirectMessage(void* object, std::vector<Atom>&& list)
+void Instance::sendDirectMessage(void* object, AtomList&& list)
 {
     lockAudioThread();
     processSend(dmessage(this, object, String(), "list", std::move(list)));
@@ -578,25 +893,102 @@ void Instance::sendDirectMessage(void* object, String const& msg)
 {
 
     lockAudioThread();
-    processSend(dmessage(this, object, String(), "symbol", std::vector<Atom>(1, generateSymbol(msg))));
+    processSend(dmessage(this, object, String(), "symbol", AtomList { generateSymbol(msg) }));
     unlockAudioThread();
 }
 
 void Instance::sendDirectMessage(void* object, float const msg)
 {
     lockAudioThread();
-    processSend(dmessage(this, object, String(), "float", std::vector<Atom>(1, msg)));
+    processSend(dmessage(this, object, String(), "float", AtomList { msg }));
     unlockAudioThread();
 }
 
-void Instance::sendMessagesFromQueue()
+void Instance::sendFloatAsync(WeakReference const& target, float value, bool setAndBang)
+{
+    if (!target.getRawUnchecked<void>())
+        return;
+
+    CommandCallback callback;
+    if (setAndBang) {
+        callback = [](void* object, float value, float) {
+            t_atom atom;
+            SETFLOAT(&atom, value);
+            pd_typedmess(static_cast<t_pd*>(object), gensym("set"), 1, &atom);
+            pd_bang(static_cast<t_pd*>(object));
+        };
+    } else {
+        callback = [](void* object, float value, float) {
+            pd_float(static_cast<t_pd*>(object), value);
+        };
+    }
+
+    // The value goes through the same queue as the other commands, so it keeps its order. Older values for the same target are skipped once this one is queued
+    commandQueue.enqueue({ callback, target, value, 0.0f, target.nextValueSerial() });
+
+    // Without audio callbacks, nothing would send it
+    if (Time::getMillisecondCounter() - lastQueueDrainTime.load() > maxQueueDrainInterval) {
+        lockAudioThread();
+        sendCommandsFromQueue(false);
+        unlockAudioThread();
+    }
+}
+
+void Instance::sendMessagesFromQueue(bool withTimeBudget)
+{
+    Tracing::ScopedEvent traceEvent("sendMessagesFromQueue");
+    processHookMessages();
+    sendCommandsFromQueue(withTimeBudget);
+}
+
+void Instance::processHookMessages()
 {
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
 
+    HookMessage message;
+    while (hookQueue.try_dequeue(message)) {
+        processHookMessage(message);
+    }
+
+    if (auto numDropped = numDroppedHookMessages.exchange(0)) {
+        logWarning("Message queue from Pd is full, dropped " + String(numDropped) + " messages");
+    }
+}
+
+void Instance::sendCommandsFromQueue(bool withTimeBudget)
+{
+    libpd_set_instance(static_cast<t_pdinstance*>(instance));
+
+    // Only spend a quarter of the block duration on commands from the GUI
+    // Anything left over stays in the queue for the next block, so a large amount of GUI actions can't make us miss a deadline
+    auto const budget = Time::secondsToHighResolutionTicks(0.25 * getBlockSize() / std::max(1.0f, sys_getsr()));
+    auto const startTime = Time::getHighResolutionTicks();
+    auto const withinBudget = [startTime, budget, withTimeBudget]() {
+        return !withTimeBudget || Time::getHighResolutionTicks() - startTime < budget;
+    };
+
+    Command command { nullptr, WeakReference(this), 0.0f, 0.0f };
+    while (withinBudget() && commandQueue.try_dequeue(command)) {
+        numMessagesProcessed++;
+
+        // A newer value for the same target is already queued
+        if (command.valueSerial && !command.target.isLatestValueSerial(command.valueSerial))
+            continue;
+
+        sys_lock();
+        if (command.target.isValid()) {
+            command.callback(command.target.getRawUnchecked<void>(), command.x, command.y);
+        }
+        sys_unlock();
+    }
+
     std::function<void(void)> callback;
-    while (functionQueue.try_dequeue(callback)) {
+    while (withinBudget() && functionQueue.try_dequeue(callback)) {
+        numMessagesProcessed++;
         callback();
     }
+
+    lastQueueDrainTime = Time::getMillisecondCounter();
 }
 
 String Instance::getExtraInfo(File const& toOpen)
@@ -611,17 +1003,9 @@ String Instance::getExtraInfo(File const& toOpen)
 
 Patch::Ptr Instance::openPatch(File const& toOpen)
 {
-    t_canvas* cnv = nullptr;
-
-    String dirname = toOpen.getParentDirectory().getFullPathName().replace("\\", "/");
-    auto const* dir = dirname.toRawUTF8();
-
-    String filename = toOpen.getFileName();
-    auto const* file = filename.toRawUTF8();
-
     setThis();
 
-    cnv = static_cast<t_canvas*>(pd::Interface::createCanvas(file, dir));
+    auto* cnv = patchCache.openCanvas(toOpen);
 
     return new Patch(pd::WeakReference(cnv, this), this, true, toOpen);
 }
@@ -634,7 +1018,16 @@ void Instance::setThis() const
 t_symbol* Instance::generateSymbol(char const* symbol) const
 {
     setThis();
-    return gensym(symbol);
+
+    // Check the cache first, so we don't need to walk Pd's symbol table for symbols we use often
+    auto& slot = symbolCache[hash(symbol) & (symbolCacheSize - 1)];
+    auto* cached = slot.load(std::memory_order_relaxed);
+    if (cached && std::strcmp(cached->s_name, symbol) == 0)
+        return cached;
+
+    auto* result = gensym(symbol);
+    slot.store(result, std::memory_order_relaxed);
+    return result;
 }
 
 t_symbol* Instance::generateSymbol(String const& symbol) const
@@ -668,12 +1061,17 @@ void Instance::muteConsole(bool shouldMute)
     consoleMute = shouldMute;
 }
 
-std::deque<std::tuple<void*, String, int, int, int>>& Instance::getConsoleMessages()
+void Instance::setPrintConsoleToStdout(bool shouldPrint)
+{
+    consoleHandler.printToStdout = shouldPrint;
+}
+
+ConsoleMessageRing& Instance::getConsoleMessages()
 {
     return consoleHandler.consoleMessages;
 }
 
-std::deque<std::tuple<void*, String, int, int, int>>& Instance::getConsoleHistory()
+ConsoleMessageRing& Instance::getConsoleHistory()
 {
     return consoleHandler.consoleHistory;
 }
@@ -758,6 +1156,7 @@ bool Instance::loadLibrary(String const& libraryToLoad)
 
 void Instance::lockAudioThread()
 {
+    RealtimeSafety::reportViolation("locking the audio lock");
     audioLock.enter();
 }
 
@@ -775,9 +1174,9 @@ void Instance::unlockAudioThread()
     audioLock.exit();
 }
 
-void Instance::updateObjectImplementations()
+void Instance::updateObjectImplementations(t_canvas* changedPatch)
 {
-    objectImplementations->updateObjectImplementations();
+    objectImplementations->updateObjectImplementations(changedPatch);
 }
 
 void Instance::clearObjectImplementationsForPatch(pd::Patch* p)
@@ -11,87 +11,89 @@ extern "C" {
 #include <s_inter.h>
 }
 
+#include <bitset>
+#include <span>
 #include <concurrentqueue.h>
 #include <readerwriterqueue.h>
 #include "Utility/StringUtils.h"
+#include "Utility/ConsoleMessageRing.h"
 #include "Patch.h"
 #include "Ofelia.h"
+#include "ArrayChangeTracker.h"
+#include "BusIndex.h"
+#include "PatchCache.h"
 
 class ObjectImplementationManager;
 
+namespace juce {
+class MidiBuffer;
+}
+
 namespace pd {
 
+// Has the same layout as a t_atom, so arrays of atoms can be passed to Pd without converting them
+// Atoms that are neither a float nor a symbol are stored as a float 0
 class Atom {
 public:
     // The default constructor.
     inline Atom()
-        : type(FLOAT)
-        , value(0)
-        , symbol()
     {
+        SETFLOAT(&atom, 0);
     }
 
-    static std::vector<pd::Atom> fromAtoms(int ac, t_atom* av)
+    static std::vector<pd::Atom> fromAtoms(int ac, t_atom const* av)
     {
-        auto array = std::vector<pd::Atom>();
-        array.reserve(ac);
-
-        for (int i = 0; i < ac; ++i) {
-            if (av[i].a_type == A_FLOAT) {
-                array.emplace_back(atom_getfloat(av + i));
-            } else if (av[i].a_type == A_SYMBOL) {
-                array.emplace_back(atom_getsymbol(av + i));
-            } else {
-                array.emplace_back();
-            }
-        }
+        return std::vector<pd::Atom>(av, av + ac);
+    }
 
-        return array;
+    // Pd never modifies the arguments of a message, so they can be passed as they are
+    static t_atom* toAtoms(Atom const* atoms)
+    {
+        return const_cast<t_atom*>(reinterpret_cast<t_atom const*>(atoms));
     }
 
     // The float constructor.
     inline Atom(float val)
-        : type(FLOAT)
-        , value(val)
-        , symbol()
     {
+        SETFLOAT(&atom, val);
     }
 
     inline Atom(t_symbol* sym)
-        : type(SYMBOL)
-        , value(0)
-        , symbol(sym)
     {
+        SETSYMBOL(&atom, sym);
     }
 
-    inline Atom(t_atom* atom)
+    inline Atom(t_atom const* a)
     {
-        if (atom->a_type == A_FLOAT) {
-            type = FLOAT;
-            value = atom->a_w.w_float;
-        } else if (atom->a_type == A_SYMBOL) {
-            type = SYMBOL;
-            symbol = atom->a_w.w_symbol;
+        if (a->a_type == A_FLOAT || a->a_type == A_SYMBOL) {
+            atom = *a;
+        } else {
+            SETFLOAT(&atom, 0);
         }
     }
 
+    inline Atom(t_atom const& a)
+        : Atom(&a)
+    {
+    }
+
     // Check if the atom is a float.
     inline bool isFloat() const
     {
-        return type == FLOAT;
+        return atom.a_type == A_FLOAT;
     }
 
     // Check if the atom is a string.
     inline bool isSymbol() const
     {
-        return type == SYMBOL;
+        return atom.a_type == A_SYMBOL;
     }
 
     // Get the float value.
     inline float getFloat() const
     {
         jassert(isFloat());
-        return value;
+        return static_cast<float>(atom.a_w.w_float);
     }
 
     // Get the string.
@@ -99,63 +101,151 @@ public:
     {
         jassert(isSymbol());
 
-        return symbol;
+        return atom.a_w.w_symbol;
     }
 
     // Get the string.
     inline String toString() const
     {
-        if (type == FLOAT) {
-            return String(value);
+        if (isFloat()) {
+            return String(getFloat());
         } else {
-            return String::fromUTF8(symbol->s_name);
+            return String::fromUTF8(atom.a_w.w_symbol->s_name);
         }
     }
 
     // Compare two atoms.
     inline bool operator==(Atom const& other) const
     {
-        if (type == SYMBOL) {
-            return other.type == SYMBOL && symbol == other.symbol;
+        if (isSymbol()) {
+            return other.isSymbol() && atom.a_w.w_symbol == other.atom.a_w.w_symbol;
         } else {
-            return other.type == FLOAT && value == other.value;
+            return other.isFloat() && atom.a_w.w_float == other.atom.a_w.w_float;
         }
     }
 
 private:
-    enum Type {
-        FLOAT,
-        SYMBOL
-    };
-    Type type = FLOAT;
-    float value = 0;
-    t_symbol* symbol;
+    t_atom atom;
+};
+
+static_assert(sizeof(Atom) == sizeof(t_atom) && std::is_standard_layout_v<Atom>);
+
+// List of atoms that keeps up to 8 atoms inline, like the messages in MessageDispatcher
+// Almost all messages between the GUI and Pd are this small, so they don't need to allocate
+class AtomList {
+public:
+    static constexpr size_t inlineSize = 8;
+
+    AtomList() = default;
+
+    AtomList(std::initializer_list<Atom> list)
+    {
+        assign(list.begin(), list.size());
+    }
+
+    AtomList(std::vector<Atom> const& list)
+    {
+        assign(list.data(), list.size());
+    }
+
+    // Large lists take over the memory of the vector, instead of copying
+    AtomList(std::vector<Atom>&& list)
+    {
+        if (list.size() > inlineSize) {
+            numAtoms = list.size();
+            heapAtoms = std::move(list);
+        } else {
+            assign(list.data(), list.size());
+        }
+    }
+
+    AtomList(int argc, t_atom const* argv)
+    {
+        numAtoms = static_cast<size_t>(std::max(argc, 0));
+        if (numAtoms > inlineSize)
+            heapAtoms.assign(argv, argv + numAtoms);
+        else
+            std::copy(argv, argv + numAtoms, inlineAtoms);
+    }
+
+    Atom const* data() const { return numAtoms > inlineSize ? heapAtoms.data() : inlineAtoms; }
+
+    // Pointer to the atoms as Pd's atom type, see Atom::toAtoms
+    t_atom* getAtoms() const { return Atom::toAtoms(data()); }
+
+    size_t size() const { return numAtoms; }
+    bool empty() const { return numAtoms == 0; }
+
+    Atom const* begin() const { return data(); }
+    Atom const* end() const { return data() + numAtoms; }
+
+    Atom const& operator[](size_t index) const { return data()[index]; }
+
+private:
+    void assign(Atom const* atoms, size_t size)
+    {
+        numAtoms = size;
+        if (numAtoms > inlineSize)
+            heapAtoms.assign(atoms, atoms + size);
+        else
+            std::copy(atoms, atoms + size, inlineAtoms);
+    }
+
+    Atom inlineAtoms[inlineSize];
+    std::vector<Atom> heapAtoms;
+    size_t numAtoms = 0;
 };
 
 class MessageListener;
 class MessageDispatcher;
 class Patch;
 class Instance {
-    struct Message {
-        String selector;
-        String destination;
-        std::vector<pd::Atom> list;
+    // Trivially copyable version of a message or MIDI event coming from one of Pd's hooks
+    // This allows us to store them in a preallocated queue, instead of allocating a std::function for every message
+    struct HookMessage {
+        enum Type {
+            PdMessage,
+            NoteOn,
+            ControlChange,
+            ProgramChange,
+            PitchBend,
+            Aftertouch,
+            PolyAftertouch,
+            MidiByte
+        };
+
+        static constexpr int maxAtoms = 8;
+
+        Type type;
+        t_symbol* destination;
+        t_symbol* selector;
+        t_atom atoms[maxAtoms];
+        int numAtoms;
+        t_atom* overflowAtoms; // Allocated for messages with more than maxAtoms atoms, freed once the message is processed
+        int midi[3];
+        int sampleOffset;
+
+        // Only floats and symbols are stored, so the atoms can be read as pd::Atom without copying them
+        std::span<pd::Atom const> getAtoms() const
+        {
+            return { reinterpret_cast<pd::Atom const*>(overflowAtoms ? overflowAtoms : atoms), static_cast<size_t>(numAtoms) };
+        }
     };
 
     struct dmessage {
 
-        dmessage(pd::Instance* instance, void* ref, String dest, String sel, std::vector<pd::Atom> atoms)
+        dmessage(pd::Instance* instance, void* ref, String dest, String sel, AtomList&& atoms)
             : object(ref, instance)
             , destination(dest)
             , selector(sel)
-            , list(atoms)
+            , list(std::move(atoms))
         {
         }
 
         WeakReference object;
         String destination;
         String selector;
-        std::vector<pd::Atom> list;
+        AtomList list;
     };
 
 public:
@@ -167,8 +257,15 @@ public:
     void prepareDSP(int nins, int nouts, double samplerate, int blockSize);
     void startDSP();
     void releaseDSP();
-    void performDSP(float const* inputs, float* outputs);
+    bool isDSPRunning() const;
+    void performDSP(float const* const* inputs, int numInputs, float* const* outputs, int numOutputs, MidiBuffer const* midiInput = nullptr);
     int getBlockSize() const;
+    void setBlockSize(int numSamples);
+
+    // Whether an adc~ reads from, or a dac~ writes to this channel, as of the last time Pd rebuilt its DSP chain
+    // performDSP doesn't copy the other channels, unused outputs are filled with silence
+    bool isInputChannelUsed(int channel) const;
+    bool isOutputChannelUsed(int channel) const;
 
     void sendNoteOn(int channel, int const pitch, int velocity) const;
     void sendControlChange(int channel, int const controller, int value) const;
@@ -180,24 +277,30 @@ public:
     void sendSysRealTime(int port, int byte) const;
     void sendMidiByte(int port, int byte) const;
 
-    virtual void receiveNoteOn(int channel, int pitch, int velocity) = 0;
-    virtual void receiveControlChange(int channel, int controller, int value) = 0;
-    virtual void receiveProgramChange(int channel, int value) = 0;
-    virtual void receivePitchBend(int channel, int value) = 0;
-    virtual void receiveAftertouch(int channel, int value) = 0;
-    virtual void receivePolyAftertouch(int channel, int pitch, int value) = 0;
-    virtual void receiveMidiByte(int port, int byte) = 0;
+    // Sends all events in the buffer (or in the given range of it) to Pd while only taking the audio lock once
+    void sendMidiEvents(MidiBuffer const& events, int startSample = 0, int numSamples = std::numeric_limits<int>::max());
+
+    // The sample offset is the position of the Pd tick that generated the event, relative to the start of the performDSP block
+    virtual void receiveNoteOn(int channel, int pitch, int velocity, int sampleOffset) = 0;
+    virtual void receiveControlChange(int channel, int controller, int value, int sampleOffset) = 0;
+    virtual void receiveProgramChange(int channel, int value, int sampleOffset) = 0;
+    virtual void receivePitchBend(int channel, int value, int sampleOffset) = 0;
+    virtual void receiveAftertouch(int channel, int value, int sampleOffset) = 0;
+    virtual void receivePolyAftertouch(int channel, int pitch, int value, int sampleOffset) = 0;
+    virtual void receiveMidiByte(int port, int byte, int sampleOffset) = 0;
 
     virtual void createPanel(int type, char const* snd, char const* location, char const* callbackName, int openMode = -1);
 
     void sendBang(char const* receiver) const;
     void sendFloat(char const* receiver, float value) const;
     void sendSymbol(char const* receiver, char const* symbol) const;
-    void sendList(char const* receiver, std::vector<pd::Atom> const& list) const;
-    void sendMessage(char const* receiver, char const* msg, std::vector<pd::Atom> const& list) const;
-    void sendTypedMessage(void* object, char const* msg, std::vector<Atom> const& list) const;
+    // The atoms are passed to Pd as they are, without copying them
+    void sendList(char const* receiver, std::span<pd::Atom const> list) const;
+    void sendMessage(char const* receiver, char const* msg, std::span<pd::Atom const> list) const;
+    void sendMessage(char const* receiver, char const* msg, std::initializer_list<pd::Atom> list) const;
+    void sendTypedMessage(void* object, char const* msg, std::span<pd::Atom const> list) const;
 
-    virtual void addTextToTextEditor(unsigned long ptr, String text) { }
+    virtual void addTextToTextEditor(unsigned long ptr, char const* text) { }
     virtual void showTextEditor(unsigned long ptr, Rectangle<int> bounds, String title) { }
 
     virtual void receivePrint(String const& message) {};
@@ -217,13 +320,13 @@ public:
     virtual void receiveMessage(String const& dest, String const& msg, std::vector<pd::Atom> const& list)
     {
     }
-    virtual void receiveSysMessage(String const& selector, std::vector<pd::Atom> const& list) {};
+    virtual void receiveSysMessage(t_symbol* selector, std::span<pd::Atom const> list) {};
 
     void registerMessageListener(void* object, MessageListener* messageListener);
     void unregisterMessageListener(void* object, MessageListener* messageListener);
 
-    void registerWeakReference(void* ptr, pd_weak_reference* ref);
-    void unregisterWeakReference(void* ptr, pd_weak_reference const* ref);
+    // Returns the shared slot for this object with its count incremented, release it when done
+    pd_weak_reference* acquireWeakReference(void* ptr);
     void clearWeakReferences(void* ptr);
 
     static void registerLuaClass(const char* object);
@@ -236,32 +339,57 @@ public:
     virtual void titleChanged() { }
 
     void enqueueFunctionAsync(std::function<void(void)> const& fn);
-    
-    // Enqueue a message to an pd::WeakReference
-    // This will first check if the weakreference is valid before triggering the callback
-    template<typename T>
-    void enqueueFunctionAsync(WeakReference& ref, std::function<void(T*)> const& fn)
-    {
-        functionQueue.enqueue([ref, fn](){
-            if(auto obj = ref.get<T>())
-            {
-                fn(obj.get());
-            }
-        });
-    }
 
-    void sendDirectMessage(void* object, String const& msg, std::vector<Atom>&& list);
-    void sendDirectMessage(void* object, std::vector<pd::Atom>&& list);
+    // Objects that publish display data from the audio thread
+    // publishDisplayData is called at the end of every performDSP call, while holding the audio lock
+    struct DisplaySource {
+        virtual ~DisplaySource() = default;
+        virtual void publishDisplayData() = 0;
+    };
+
+    // Statistics of the queue that passes messages from Pd to the GUI
+    struct MessageQueueStatistics {
+        int64 numEnqueued;
+        int64 numDropped;
+        int64 numCoalesced;
+        int maxDepth;
+        int capacity;
+    };
+
+    MessageQueueStatistics getMessageQueueStatistics() const;
+
+    // Counts the messages that every object or connection sends to the GUI, see MessageDispatcher::setProfilingEnabled
+    void setMessageProfilingEnabled(bool enabled);
+    int64 getMessageCount(void* target) const;
+
+    void registerDisplaySource(DisplaySource* source);
+    void unregisterDisplaySource(DisplaySource* source);
+
+    // Commands are a cheaper alternative to enqueueFunctionAsync for frequent GUI interactions
+    // They consist of a plain function pointer, a target object and two arguments, so they don't need any allocation
+    // The callback will only be called if the target object still exists
+    using CommandCallback = void (*)(void* target, float x, float y);
+    void enqueueCommand(WeakReference const& target, CommandCallback callback, float x = 0.0f, float y = 0.0f);
+
+    void sendDirectMessage(void* object, String const& msg, AtomList&& list);
+    void sendDirectMessage(void* object, AtomList&& list);
     void sendDirectMessage(void* object, String const& msg);
     void sendDirectMessage(void* object, float msg);
 
-    void updateObjectImplementations();
+    // Asynchronous alternative to sendDirectMessage, for values that GUI objects send at mouse rate
+    // Doesn't take the audio lock, the value is sent at the start of the next block. If a target gets more values before that, only the last one is sent
+    // If no blocks are being processed, it's sent right away under the audio lock
+    // With setAndBang, the value is sent as "set" followed by a bang, like ObjectBase::sendFloatValue
+    void sendFloatAsync(WeakReference const& target, float value, bool setAndBang = false);
+
+    // Pass the patch that changed, so only that patch needs to be rescanned
+    void updateObjectImplementations(t_canvas* changedPatch = nullptr);
     void clearObjectImplementationsForPatch(pd::Patch* p);
 
-    virtual void performParameterChange(int type, String const& name, float value) { }
+    virtual void performParameterChange(int type, t_symbol* name, float value) { }
 
     // JYG added this
-    virtual void fillDataBuffer(std::vector<pd::Atom> const& list) { }
+    virtual void fillDataBuffer(std::span<pd::Atom const> list) { }
     virtual void parseDataBuffer(XmlElement const& xml) { }
 
     void logMessage(String const& message);
@@ -269,11 +397,24 @@ public:
     void logWarning(String const& message);
     void muteConsole(bool shouldMute);
 
-    std::deque<std::tuple<void*, String, int, int, int>>& getConsoleMessages();
-    std::deque<std::tuple<void*, String, int, int, int>>& getConsoleHistory();
+    // Also prints everything that ends up in the console to stdout, for running without an editor
+    void setPrintConsoleToStdout(bool shouldPrint);
+
+    ConsoleMessageRing& getConsoleMessages();
+    ConsoleMessageRing& getConsoleHistory();
+
+    // With a time budget, only a part of the block duration is spent on commands from the GUI
+    // This also handles the messages and MIDI that Pd sent to plugdata, so only call it from the thread that processes audio
+    void sendMessagesFromQueue(bool withTimeBudget = true);
 
-    void sendMessagesFromQueue();
-    void processMessage(Message mess);
+    // Only sends what the GUI queued, for draining the queues outside of the audio callback
+    // Messages from Pd stay queued for the audio thread, because the MIDI handlers write into its output buffer
+    void sendCommandsFromQueue(bool withTimeBudget = true);
+
+    // Handles the messages and MIDI from Pd's hooks, needs the audio lock
+    void processHookMessages();
+
+    void processMessage(t_symbol* destination, t_symbol* selector, std::span<pd::Atom const> list);
     void processSend(dmessage mess);
 
     String getExtraInfo(File const& toOpen);
@@ -286,10 +427,16 @@ public:
 
     virtual void reloadAbstractions(File changedPatch, t_glist* except) = 0;
 
+    // Called from performDSP, while holding the audio lock, after Pd rebuilt its DSP chain
+    virtual void dspChainChanged() { }
+
     void setThis() const;
     t_symbol* generateSymbol(String const& symbol) const;
     t_symbol* generateSymbol(char const* symbol) const;
 
+    // This is the same lock that Pd's sys_lock uses around DSP, so holding it from the message thread will block the audio thread
+    // TODO: preparing graph edits off-thread and swapping them in at block boundaries would avoid that
+    // but Pd edits glists in place and rebuilds its single DSP chain inside canvas_update_dsp, so that would mean duplicating the whole graph
     void lockAudioThread();
     bool tryLockAudioThread();
     void unlockAudioThread();
@@ -298,7 +445,6 @@ public:
 
     void* instance = nullptr;
     void* patch = nullptr;
-    void* atoms = nullptr;
     void* messageReceiver = nullptr;
     void* parameterReceiver = nullptr;
     void* parameterChangeReceiver = nullptr;
@@ -312,17 +458,115 @@ public:
 
     bool isPerformingGlobalSync = false;
     CriticalSection const audioLock;
-    std::recursive_mutex weakReferenceMutex;
+
+    // What the audio thread had to deal with since the last call to resetBlockActivity, so we can find out why a block took too long
+    // Only the patch edit flag is set from other threads
+    int64 lockWaitTicks = 0;
+    int numMessagesProcessed = 0;
+    std::atomic<bool> patchEdited = false;
+
+    void resetBlockActivity()
+    {
+        lockWaitTicks = 0;
+        numMessagesProcessed = 0;
+        patchEdited = false;
+    }
+
+    // Whether the GUI has sent anything that the audio thread still needs to process
+    bool hasPendingMessages() const
+    {
+        return functionQueue.size_approx() > 0 || commandQueue.size_approx() > 0;
+    }
+
+    // Change counters for arrays, so array views only need to read back what changed
+    ArrayChangeTracker arrayChanges;
+
+    // Senders and receivers of all named buses, for finding references and seeing which patches depend on each other
+    BusIndex busIndex = BusIndex(this);
+
+    // Oldest undo steps of a patch are removed when it has more than this
+    std::atomic<int> maxUndoSteps = 250;
+
+    // Tokenised contents of large patch files, so opening them again is faster
+    PatchCache patchCache;
+
+    // Every pd::Patch of this instance, so queued callbacks can reach them without holding a reference
+    // Patches add and remove themselves, only access this while holding the audio lock
+    std::vector<Patch*> patchObjects;
+
+    // The last selection that was copied in this instance, and the text we put on the system clipboard for it
+    // If the clipboard still contains that text, pasting uses these atoms instead of parsing the text again. Only access this with the audio lock
+    t_binbuf* clipboardContents = nullptr;
+    String clipboardText;
+
+    // Writes large patches to disk, see Patch::saveInBackground
+    ThreadPool patchSaveThread = ThreadPool(1);
 
 private:
-    std::unordered_map<void*, std::vector<pd_weak_reference*>> pdWeakReferences;
+    // Only locked when a reference is created from a raw pointer, or when an object is freed
+    std::mutex weakReferenceMutex;
+    std::unordered_map<void*, pd_weak_reference*> pdWeakReferences;
 
     std::unique_ptr<ObjectImplementationManager> objectImplementations;
 
     moodycamel::ConcurrentQueue<std::function<void(void)>> functionQueue = moodycamel::ConcurrentQueue<std::function<void(void)>>(4096);
 
+    std::vector<DisplaySource*> displaySources;
+
+    // The command keeps a reference to its target, so we can check if it's still alive without looking it up
+    struct Command {
+        CommandCallback callback;
+        WeakReference target;
+        float x, y;
+        uint32 valueSerial = 0; // Only set by sendFloatAsync
+    };
+
+    moodycamel::ConcurrentQueue<Command> commandQueue = moodycamel::ConcurrentQueue<Command>(4096);
+
+    // When the queue wasn't drained for this long, we assume the audio callback has stopped
+    static constexpr uint32 maxQueueDrainInterval = 250;
+    std::atomic<uint32> lastQueueDrainTime = 0;
+
+    // Preallocated for 8192 messages and enough producers, so enqueueing never needs to allocate
+    moodycamel::ConcurrentQueue<HookMessage> hookQueue = moodycamel::ConcurrentQueue<HookMessage>(8192, 0, 8);
+    std::atomic<int> numDroppedHookMessages = 0;
+
+    void enqueueHookMessage(HookMessage const& message);
+    void processHookMessage(HookMessage const& message);
+
     std::unique_ptr<FileChooser> openChooser;
     std::atomic<bool> consoleMute;
+
+    // Offset of the Pd tick that is currently being processed inside performDSP
+    int tickOffset = 0;
+
+    // Called from performDSP whenever the DSP chain was rebuilt, looks for adc~ and dac~ objects in all patches
+    void updateChannelUsage();
+
+    // Channels above this are always treated as used
+    static constexpr int maxTrackedChannels = 64;
+    std::bitset<maxTrackedChannels> usedInputChannels;
+    std::bitset<maxTrackedChannels> usedOutputChannels;
+    t_int* lastDspChain = nullptr;
+    int lastDspChainSize = -1;
+
+    // Pd only forwards raw MIDI bytes to [midiin] objects, so we can skip them if nothing is bound to this
+    t_symbol* midiInSymbol = nullptr;
+
+    // Receivers that processMessage handles, so it can compare symbols instead of strings
+    t_symbol* pdSymbol = nullptr;
+    t_symbol* paramSymbol = nullptr;
+    t_symbol* paramChangeSymbol = nullptr;
+    t_symbol* dataBufferSymbol = nullptr;
+
+    // The number of samples we process per performDSP call, always a multiple of Pd's block size (64)
+    std::atomic<int> blockSize = 64;
+
+    // Direct-mapped cache of symbols we looked up before, indexed by the hash of the name
+    // Pd never frees symbols, so the pointers stay valid and slots can be overwritten from any thread without locking
+    static constexpr int symbolCacheSize = 4096;
+    mutable std::array<std::atomic<t_symbol*>, symbolCacheSize> symbolCache {};
+
     static inline std::set<hash32> luaClasses = std::set<hash32>(); // Keep track of class names that correspond to pdlua objects
     
 protected:
@@ -333,101 +577,154 @@ protected:
     struct ConsoleHandler : public Timer {
         Instance* instance;
 
+        bool printToStdout = false;
+
         ConsoleHandler(Instance* parent)
             : instance(parent)
+            , pendingFifo(pendingBufferSize)
+            , pendingBuffer(pendingBufferSize)
             , fastStringWidth(Font(14))
         {
         }
 
         void timerCallback() override
         {
-            auto item = std::tuple<void*, String, bool>();
+            // Stop before reading, so any message that gets posted while we read will start the timer again
+            stopTimer();
+
             int numReceived = 0;
             bool newWarning = false;
 
-            while (pendingMessages.try_dequeue(item)) {
-                auto& [object, message, type] = item;
-                addMessage(object, message, type);
+            PendingHeader header;
+            while (pendingFifo.getNumReady() >= static_cast<int>(sizeof(PendingHeader))) {
+                readPending(&header, sizeof(PendingHeader));
+                readPending(pendingText, header.textSize);
+
+                consoleMessages.addRepeats(header.repeatsOfPrevious);
+                addMessage(header.object, pendingText, header.textSize, header.type);
+                lastReceivedSequence = header.sequence;
+
+                numReceived++;
+                newWarning = newWarning || header.type;
+            }
+
+            // Collect repeats of the last message, but only if the pd thread hasn't posted a newer message that we haven't read yet
+            auto state = repeatState.load();
+            if ((state >> 32) == lastReceivedSequence && (state & 0xffffffff) && repeatState.compare_exchange_strong(state, static_cast<uint64>(lastReceivedSequence) << 32)) {
+                consoleMessages.addRepeats(static_cast<int>(state & 0xffffffff));
+                numReceived++;
+            }
 
+            if (auto numSuppressed = numSuppressedMessages.exchange(0)) {
+                addMessage(nullptr, String(numSuppressed) + " console messages were dropped, because they were posted too quickly", true);
                 numReceived++;
-                newWarning = newWarning || type;
+                newWarning = true;
             }
 
             // Check if any item got assigned
             if (numReceived) {
                 instance->updateConsole(numReceived, newWarning);
             }
-
-            stopTimer();
         }
 
-        void addMessage(void* object, String const& message, bool type)
+        void addMessage(void* object, char const* text, int textSize, int type)
         {
-            if (consoleMessages.size()) {
-                auto& [lastObject, lastMessage, lastType, lastLength, numMessages] = consoleMessages.back();
-                if (object == lastObject && message == lastMessage && type == lastType) {
-                    numMessages++;
-                } else {
-                    consoleMessages.emplace_back(object, message, type, fastStringWidth.getStringWidth(message) + 8, 1);
-                }
-            } else {
-                consoleMessages.emplace_back(object, message, type, fastStringWidth.getStringWidth(message) + 8, 1);
+            if (printToStdout) {
+                std::cout << (type ? "error: " : "");
+                std::cout.write(text, textSize);
+                std::cout << std::endl;
             }
 
-            if (consoleMessages.size() > 800)
-                consoleMessages.pop_front();
+            consoleMessages.add(object, type, text, textSize, fastStringWidth.getStringWidth(text, textSize) + 8);
         }
 
-        void logMessage(void* object, String const& message)
+        void addMessage(void* object, String const& message, int type)
         {
+            addMessage(object, message.toRawUTF8(), static_cast<int>(message.getNumBytesAsUTF8()), type);
+        }
+
+        // Can be called from any thread: messages from other threads are passed on to the message thread without allocating
+        // Repeats of the same message are only counted, and if messages come in faster than the console can read them, they get dropped
+        void postMessage(void* object, char const* text, int textSize, int type)
+        {
+            textSize = std::min(textSize, ConsoleMessageRing::maxMessageSize);
+
             if (MessageManager::getInstance()->isThisTheMessageThread()) {
-                addMessage(object, message, false);
-                instance->updateConsole(1, false);
+                addMessage(object, text, textSize, type);
+                instance->updateConsole(1, type);
+                return;
+            }
+
+            // Pd posts from the audio thread, but hosts and worker threads can log errors too, and the fifo only allows one writer
+            SpinLock::ScopedLockType lock(postLock);
+
+            if (object == lastPostedObject && type == lastPostedType && textSize == lastPostedSize && std::memcmp(lastPostedText, text, textSize) == 0) {
+                repeatState.fetch_add(1);
             } else {
-                pendingMessages.enqueue({ object, message, false });
-                startTimer(10);
+                if (pendingFifo.getFreeSpace() < static_cast<int>(sizeof(PendingHeader)) + textSize) {
+                    numSuppressedMessages.fetch_add(1);
+                    return;
+                }
+
+                // Start a new sequence, and pass on the repeats we counted for the previous message
+                lastPostedSequence++;
+                auto const previousState = repeatState.exchange(static_cast<uint64>(lastPostedSequence) << 32);
+
+                PendingHeader header = { object, type, textSize, static_cast<int>(previousState & 0xffffffff), lastPostedSequence };
+                writePending(header, text, textSize);
+
+                lastPostedObject = object;
+                lastPostedType = type;
+                lastPostedSize = textSize;
+                std::memcpy(lastPostedText, text, textSize);
             }
+
+            if (!isTimerRunning())
+                startTimer(10);
+        }
+
+        void postMessage(void* object, String const& message, int type)
+        {
+            postMessage(object, message.toRawUTF8(), static_cast<int>(message.getNumBytesAsUTF8()), type);
+        }
+
+        void logMessage(void* object, String const& message)
+        {
+            postMessage(object, message, false);
         }
 
         void logWarning(void* object, String const& warning)
         {
-            if (MessageManager::getInstance()->isThisTheMessageThread()) {
-                addMessage(object, warning, true);
-                instance->updateConsole(1, true);
-            } else {
-                pendingMessages.enqueue({ object, warning, true });
-                startTimer(10);
-            }
+            postMessage(object, warning, true);
         }
 
         void logError(void* object, String const& error)
         {
-            if (MessageManager::getInstance()->isThisTheMessageThread()) {
-                addMessage(object, error, true);
-                instance->updateConsole(1, true);
-            } else {
-                pendingMessages.enqueue({ object, error, true });
-                startTimer(10);
-            }
+            postMessage(object, error, true);
         }
 
         void processPrint(void* object, char const* message)
         {
-            std::function<void(String const)> forwardMessage =
-                [this, object](String const& message) {
-                    if (message.startsWith("error")) {
-                        logError(object, message.substring(7));
-                    } else if (message.startsWith("verbose(0):") || message.startsWith("verbose(1):")) {
-                        logError(object, message.substring(12));
-                    } else {
-                        if (message.startsWith("verbose(")) {
-                            logMessage(object, message.substring(12));
-                        } else {
-                            logMessage(object, message);
-                        }
-                    }
+            auto forwardMessage = [this, object](char const* line, int length) {
+                auto startsWith = [line, length](char const* prefix) {
+                    auto const prefixLength = static_cast<int>(strlen(prefix));
+                    return length >= prefixLength && strncmp(line, prefix, prefixLength) == 0;
+                };
+                auto skip = [line, length](int numChars) {
+                    return line + std::min(numChars, length);
                 };
 
+                if (startsWith("error")) {
+                    postMessage(object, skip(7), std::max(0, length - 7), true);
+                } else if (startsWith("verbose(0):") || startsWith("verbose(1):")) {
+                    postMessage(object, skip(12), std::max(0, length - 12), true);
+                } else if (startsWith("verbose(")) {
+                    postMessage(object, skip(12), std::max(0, length - 12), false);
+                } else {
+                    postMessage(object, line, length, false);
+                }
+            };
+
             static int length = 0;
             printConcatBuffer[length] = '\0';
 
@@ -437,7 +734,7 @@ protected:
                 strncat(printConcatBuffer, message, d);
 
                 // Send concatenated line to plugdata!
-                forwardMessage(String::fromUTF8(printConcatBuffer));
+                forwardMessage(printConcatBuffer, 2048 - 1);
 
                 message += d;
                 len -= d;
@@ -452,18 +749,69 @@ protected:
                 printConcatBuffer[length - 1] = '\0';
 
                 // Send concatenated line to plugdata!
-                forwardMessage(String::fromUTF8(printConcatBuffer));
+                forwardMessage(printConcatBuffer, length - 1);
 
                 length = 0;
             }
         }
 
-        std::deque<std::tuple<void*, String, int, int, int>> consoleMessages;
-        std::deque<std::tuple<void*, String, int, int, int>> consoleHistory;
+        ConsoleMessageRing consoleMessages;
+        ConsoleMessageRing consoleHistory;
 
         char printConcatBuffer[2048];
 
-        moodycamel::ReaderWriterQueue<std::tuple<void*, String, bool>> pendingMessages;
+    private:
+        struct PendingHeader {
+            void* object;
+            int type;
+            int textSize;
+            int repeatsOfPrevious;
+            uint32 sequence;
+        };
+
+        // The header and the text are written in one go, so the message thread never reads a header without its text
+        void writePending(PendingHeader const& header, char const* text, int textSize)
+        {
+            auto const totalSize = static_cast<int>(sizeof(PendingHeader)) + textSize;
+            auto const scope = pendingFifo.write(totalSize);
+
+            auto const copyTo = [this, &scope](int offset, char const* source, int size) {
+                auto const sizeInFirst = std::clamp(scope.blockSize1 - offset, 0, size);
+                std::copy(source, source + sizeInFirst, pendingBuffer.data() + scope.startIndex1 + offset);
+                std::copy(source + sizeInFirst, source + size, pendingBuffer.data() + scope.startIndex2 + std::max(0, offset - scope.blockSize1));
+            };
+
+            copyTo(0, reinterpret_cast<char const*>(&header), sizeof(PendingHeader));
+            copyTo(sizeof(PendingHeader), text, textSize);
+        }
+
+        void readPending(void* data, int numBytes)
+        {
+            auto* bytes = static_cast<char*>(data);
+            auto const scope = pendingFifo.read(numBytes);
+            std::copy(pendingBuffer.data() + scope.startIndex1, pendingBuffer.data() + scope.startIndex1 + scope.blockSize1, bytes);
+            std::copy(pendingBuffer.data() + scope.startIndex2, pendingBuffer.data() + scope.startIndex2 + scope.blockSize2, bytes + scope.blockSize1);
+        }
+
+        static constexpr int pendingBufferSize = 1 << 16;
+
+        // Messages from other threads, as a header followed by the UTF-8 text
+        AbstractFifo pendingFifo;
+        std::vector<char> pendingBuffer;
+        char pendingText[ConsoleMessageRing::maxMessageSize];
+
+        // Upper 32 bits: sequence number of the last posted message, lower 32 bits: number of times it was repeated since
+        std::atomic<uint64> repeatState = 0;
+        std::atomic<int> numSuppressedMessages = 0;
+        uint32 lastReceivedSequence = 0;
+
+        // Only accessed while holding postLock
+        SpinLock postLock;
+        void* lastPostedObject = nullptr;
+        int lastPostedType = -1;
+        int lastPostedSize = -1;
+        uint32 lastPostedSequence = 0;
+        char lastPostedText[ConsoleMessageRing::maxMessageSize];
 
         StringUtils fastStringWidth; // For formatting console messages more quickly
     };
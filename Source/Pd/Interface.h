@@ -42,6 +42,8 @@ extern void canvas_savetemplatesto(t_canvas* x, t_binbuf* b, int wholething);
 extern void canvas_saveto(t_canvas* x, t_binbuf* b);
 extern void set_class_prefix(t_symbol*);
 extern void clear_class_loadsym();
+extern void glob_setfilename(void* dummy, t_symbol* filesym, t_symbol* dirsym);
+extern void pd_doloadbang(void);
 }
 
 namespace pd {
@@ -58,6 +60,45 @@ struct Interface {
         return cnv;
     }
 
+    // Same as createCanvas, but evaluates a binbuf we have already read, instead of reading the file
+    static t_canvas* createCanvasFromBinbuf(t_binbuf* binbuf, char const* name, char const* path)
+    {
+        auto const dspState = canvas_suspend_dsp();
+
+        auto* boundX = s__X.s_thing;
+        auto* boundN = s__N.s_thing;
+        auto* boundA = gensym("#A")->s_thing;
+        s__X.s_thing = nullptr;
+        s__N.s_thing = &pd_canvasmaker;
+        gensym("#A")->s_thing = nullptr;
+
+        glob_setfilename(nullptr, gensym(name), gensym(path));
+        binbuf_eval(binbuf, nullptr, 0, nullptr);
+        glob_setfilename(nullptr, &s_, &s_);
+
+        // Pop the toplevel canvas, and any subpatch an incomplete file left open
+        t_canvas* cnv = nullptr;
+        t_pd* popped = nullptr;
+        while (s__X.s_thing && popped != s__X.s_thing) {
+            popped = s__X.s_thing;
+            cnv = reinterpret_cast<t_canvas*>(popped);
+            vmess(popped, gensym("pop"), const_cast<char*>("i"), 1);
+        }
+
+        pd_doloadbang();
+
+        gensym("#A")->s_thing = boundA;
+        s__N.s_thing = boundN;
+        s__X.s_thing = boundX;
+        canvas_resume_dsp(dspState);
+
+        if (cnv) {
+            canvas_vis(cnv, 1.f);
+            canvas_rename(cnv, gensym(name), gensym(path));
+        }
+        return cnv;
+    }
+
     static char const* getObjectClassName(t_pd* ptr)
     {
         return class_getname(pd_class(ptr));
@@ -70,6 +111,25 @@ struct Interface {
         binbuf_gettext(ptr->te_binbuf, text, size);
     }
 
+    // Reads the whole binbuf as text in one go
+    static String getBinbufText(t_binbuf* b)
+    {
+        char* text = nullptr;
+        int size = 0;
+        binbuf_gettext(b, &text, &size);
+
+        auto result = String::fromUTF8(text, size);
+        freebytes(text, size);
+        return result;
+    }
+
+    // Replaces the binbuf's contents by parsing the text in one go, the same way Pd parses patch files
+    // Semicolons, commas, numbers and escapes are handled by Pd, and newlines count as whitespace
+    static void setBinbufText(t_binbuf* b, String const& text)
+    {
+        binbuf_text(b, text.toRawUTF8(), text.getNumBytesAsUTF8());
+    }
+
     static void getObjectBounds(t_canvas* cnv, t_gobj* ptr, int* x, int* y, int* w, int* h)
     {
         *x = 0;
@@ -110,6 +170,23 @@ struct Interface {
         }
     }
 
+    static void removeFromSearchPath(char const* path)
+    {
+        t_namelist** link = &STUFF->st_searchpath;
+        while (*link) {
+            auto* item = *link;
+            if (!strcmp(item->nl_string, path)) {
+                *link = item->nl_next;
+
+                // namelist_free frees everything after this item too
+                item->nl_next = nullptr;
+                namelist_free(item);
+                return;
+            }
+            link = &item->nl_next;
+        }
+    }
+
     static t_object* checkObject(t_pd* obj)
     {
         if (!obj)
@@ -260,6 +337,12 @@ struct Interface {
 
         binbuf_text(libpd_this_instance()->pd_gui->i_editor->copy_binbuf, buf, len);
 
+        pasteCopyBuffer(cnv);
+    }
+
+    // Pastes whatever is in Pd's copy buffer
+    static void pasteCopyBuffer(t_canvas* cnv)
+    {
         canvas_setcurrent(cnv);
         pd_typedmess((t_pd*)cnv, gensym("paste"), 0, nullptr);
         canvas_unsetcurrent(cnv);
@@ -323,26 +406,44 @@ struct Interface {
      body (and which is called recursively.) */
     static void saveToFile(t_canvas* cnv, t_symbol* filename, t_symbol* dir)
     {
-        t_binbuf* b = binbuf_new();
-        canvas_savetemplatesto(cnv, b, 1);
-        canvas_saveto(cnv, b);
+        t_binbuf* b = getPatchContents(cnv);
         errno = 0;
-        if (binbuf_write(b, filename->s_name, dir->s_name, 0))
+        if (!writePatchContents(b, filename->s_name, dir->s_name))
             post("%s/%s: %s", dir->s_name, filename->s_name,
                 (errno ? strerror(errno) : "write failed"));
         else {
-            /* if not an abstraction, reset title bar and directory */
-            if (!cnv->gl_owner) {
-                canvas_rename(cnv, filename, dir);
-                /* update window list in case Save As changed the window name */
-                canvas_updatewindowlist();
-            }
+            patchSaved(cnv, filename, dir);
             post("saved to: %s/%s", dir->s_name, filename->s_name);
-            canvas_dirty(cnv, 0);
         }
         binbuf_free(b);
     }
 
+    // Snapshot of everything that gets saved to the patch file, free it with binbuf_free
+    static t_binbuf* getPatchContents(t_canvas* cnv)
+    {
+        t_binbuf* b = binbuf_new();
+        canvas_savetemplatesto(cnv, b, 1);
+        canvas_saveto(cnv, b);
+        return b;
+    }
+
+    // Only uses the binbuf, so this doesn't need the pd lock
+    static bool writePatchContents(t_binbuf* b, char const* filename, char const* dir)
+    {
+        return !binbuf_write(b, filename, dir, 0);
+    }
+
+    static void patchSaved(t_canvas* cnv, t_symbol* filename, t_symbol* dir)
+    {
+        /* if not an abstraction, reset title bar and directory */
+        if (!cnv->gl_owner) {
+            canvas_rename(cnv, filename, dir);
+            /* update window list in case Save As changed the window name */
+            canvas_updatewindowlist();
+        }
+        canvas_dirty(cnv, 0);
+    }
+
     static t_gobj* createObject(t_canvas* cnv, t_symbol* s, int argc, t_atom* argv)
     {
         canvas_setcurrent(cnv);
@@ -437,6 +538,145 @@ struct Interface {
         return count;
     }
 
+    // Removes the oldest undo steps until at most maxSteps can be undone, returns the number of removed actions
+    // Redo steps after the current position don't count. Sequences are removed as a whole, and the step we're currently at is always kept
+    static int trimUndoQueue(t_canvas* cnv, int maxSteps)
+    {
+        auto* undo = canvas_undo_get(cnv);
+        if (!undo || !undo->u_queue || undo->u_doing)
+            return 0;
+
+        // Count the steps up to the current position, a sequence is one step. The first action is a placeholder
+        int numUndoSteps = 0;
+        int sequenceDepth = 0;
+        for (auto* action = undo->u_queue; action != undo->u_last && action->next;) {
+            action = action->next;
+            if (action->type == UNDO_SEQUENCE_START)
+                sequenceDepth++;
+            else if (action->type == UNDO_SEQUENCE_END)
+                sequenceDepth--;
+
+            if (sequenceDepth == 0)
+                numUndoSteps++;
+        }
+
+        if (numUndoSteps <= maxSteps)
+            return 0;
+
+        int numRemoved = 0;
+        int numRemovedSteps = 0;
+        auto* first = undo->u_queue->next;
+        while (first && numUndoSteps - numRemovedSteps > maxSteps) {
+            // Find the end of this step
+            auto* last = first;
+            if (first->type == UNDO_SEQUENCE_START) {
+                int depth = 0;
+                for (; last; last = last->next) {
+                    if (last->type == UNDO_SEQUENCE_START)
+                        depth++;
+                    else if (last->type == UNDO_SEQUENCE_END && --depth == 0)
+                        break;
+                }
+            }
+
+            if (!last)
+                break;
+
+            // Don't remove something we can still undo into, or actions we don't know how to free
+            bool canRemove = true;
+            for (auto* action = first; canRemove; action = action->next) {
+                canRemove = action != undo->u_last && canFreeUndoAction(action);
+                if (action == last)
+                    break;
+            }
+            if (!canRemove)
+                break;
+
+            auto* next = last->next;
+            for (auto* action = first;;) {
+                auto* nextAction = action->next;
+                numRemoved++;
+                freeUndoAction(cnv, action);
+                if (action == last)
+                    break;
+                action = nextAction;
+            }
+
+            undo->u_queue->next = next;
+            if (next)
+                next->prev = undo->u_queue;
+            first = next;
+            numRemovedSteps++;
+        }
+
+        return numRemoved;
+    }
+
+    static bool canFreeUndoAction(t_undo_action* action)
+    {
+        switch (action->type) {
+        case UNDO_CONNECT:
+        case UNDO_DISCONNECT:
+        case UNDO_CUT:
+        case UNDO_MOTION:
+        case UNDO_PASTE:
+        case UNDO_APPLY:
+        case UNDO_ARRANGE:
+        case UNDO_CANVAS_APPLY:
+        case UNDO_CREATE:
+        case UNDO_RECREATE:
+        case UNDO_FONT:
+        case UNDO_SEQUENCE_START:
+        case UNDO_SEQUENCE_END:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Releases the data of an undo action the same way pd does when it clears the redo steps
+    static void freeUndoAction(t_canvas* cnv, t_undo_action* action)
+    {
+        switch (action->type) {
+        case UNDO_CONNECT:
+            canvas_undo_connect(cnv, action->data, UNDO_FREE);
+            break;
+        case UNDO_DISCONNECT:
+            canvas_undo_disconnect(cnv, action->data, UNDO_FREE);
+            break;
+        case UNDO_CUT:
+            canvas_undo_cut(cnv, action->data, UNDO_FREE);
+            break;
+        case UNDO_MOTION:
+            canvas_undo_move(cnv, action->data, UNDO_FREE);
+            break;
+        case UNDO_PASTE:
+            canvas_undo_paste(cnv, action->data, UNDO_FREE);
+            break;
+        case UNDO_APPLY:
+            canvas_undo_apply(cnv, action->data, UNDO_FREE);
+            break;
+        case UNDO_ARRANGE:
+            canvas_undo_arrange(cnv, action->data, UNDO_FREE);
+            break;
+        case UNDO_CANVAS_APPLY:
+            canvas_undo_canvas_apply(cnv, action->data, UNDO_FREE);
+            break;
+        case UNDO_CREATE:
+            canvas_undo_create(cnv, action->data, UNDO_FREE);
+            break;
+        case UNDO_RECREATE:
+            canvas_undo_recreate(cnv, action->data, UNDO_FREE);
+            break;
+        case UNDO_FONT:
+            canvas_undo_font(cnv, action->data, UNDO_FREE);
+            break;
+        default:
+            break;
+        }
+        freebytes(action, sizeof(*action));
+    }
+
     static int canUndo(t_canvas* cnv)
     {
         t_undo* udo = canvas_undo_get(cnv);
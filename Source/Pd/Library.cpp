@@ -13,6 +13,7 @@
 #include <BinaryData.h>
 
 #include "Utility/OSUtils.h"
+#include "Utility/SettingsFile.h"
 
 extern "C" {
 #include <m_pd.h>
@@ -26,6 +27,7 @@ extern "C" {
 #include "Library.h"
 #include "Instance.h"
 #include "Pd/Interface.h"
+#include "Pd/LibraryLoader.h"
 
 struct _canvasenvironment {
     t_symbol* ce_dir;    /* directory patch lives in */
@@ -39,9 +41,12 @@ namespace pd {
 
 void Library::updateLibrary()
 {
-    auto settingsTree = ValueTree::fromXml(ProjectInfo::appDataDir.getChildFile(".settings").loadFileAsString());
-    auto pathTree = settingsTree.getChildWithName("Paths");
+    // SettingsFile keeps the parsed settings in memory, and notifies us when the paths change
+    auto pathTree = SettingsFile::getInstance()->getPathsTree();
 
+    StringArray objects;
+
+    // Only hold the lock while we copy the class table, scanning the search paths can take seconds on slow drives
     sys_lock();
 
     // Get available objects directly from pd
@@ -50,8 +55,6 @@ void Library::updateLibrary()
     auto* mlist = static_cast<t_methodentry*>(libpd_get_class_methods(o));
     t_methodentry* m;
 
-    allObjects.clear();
-
     int i;
     for (i = o->c_nmethod, m = mlist; i--; m++) {
         if (!m || !m->me_name)
@@ -59,72 +62,307 @@ void Library::updateLibrary()
 
         auto newName = String::fromUTF8(m->me_name->s_name);
         if (!(newName.startsWith("else/") || newName.startsWith("cyclone/") || newName.endsWith("_aliased"))) {
-            allObjects.add(newName);
+            objects.add(newName);
         }
     }
 
-    // Find patches in our search tree
+    sys_unlock();
+
+    // Objects from startup libraries that will be loaded when they're first used
+    objects.addArray(LibraryLoader::getInstance()->getDeferredObjects());
+
+    StringArray searchPaths;
     for (auto path : pathTree) {
-        auto filePath = path.getProperty("Path").toString();
+        searchPaths.add(path.getProperty("Path").toString());
+    }
 
-        auto file = File(filePath);
-        if (!file.exists() || !file.isDirectory())
-            continue;
+    objectSearchThread.addJob([this, objects, searchPaths]() mutable {
+        // Find patches in our search tree
+        objects.addArray(index->scanSearchPaths(searchPaths));
+
+        // These can't be created by name in Pd, but plugdata allows it
+        objects.add("graph");
+        objects.add("garray");
+
+        // These aren't in there but should be
+        objects.add("float");
+        objects.add("symbol");
+        objects.add("list");
+
+        // Sorted and without duplicates, so autocomplete can find all names with a prefix with a binary search
+        objects.sort(false);
+        auto const numUnique = static_cast<int>(std::unique(objects.begin(), objects.end()) - objects.begin());
+        objects.removeRange(numUnique, objects.size() - numUnique);
+
+        {
+            std::lock_guard<std::recursive_mutex> lock(libraryLock);
+            allObjects.swapWith(objects);
+            allObjectsVersion++;
+            searchIndex.reset();
+            browserIndex.reset();
+        }
+
+        // Have it ready before the object browser gets opened
+        getBrowserIndex();
+    });
+}
 
-        for (auto const& file : OSUtils::iterateDirectory(file, false, true)) {
-            if (file.hasFileExtension("pd")) {
-                auto filename = file.getFileNameWithoutExtension();
-                if (!filename.startsWith("help-") || filename.endsWith("-help")) {
-                    allObjects.add(filename);
+LibraryIndex::LibraryIndex()
+{
+    watcher.addFolder(ProjectInfo::appDataDir);
+    watcher.addListener(this);
+
+    scanHelpFiles();
+}
+
+void LibraryIndex::scanHelpFiles()
+{
+    // Changes tend to come in bursts, like when the documentation is extracted, no need to scan for each of them
+    if (helpFileScanPending.exchange(true))
+        return;
+
+    helpFileScanThread.addJob([this]() {
+        helpFileScanPending = false;
+
+        auto files = std::make_shared<std::unordered_set<String>>();
+        for (auto const& path : Library::helpPaths) {
+            for (auto const& file : OSUtils::iterateDirectory(path, true, true)) {
+                auto const fileName = file.getFileName();
+                if (fileName.endsWith("-help.pd") || fileName.startsWith("help-")) {
+                    files->insert(file.getFullPathName());
                 }
             }
         }
+
+        std::lock_guard<std::mutex> lock(helpFilesLock);
+        helpFiles = files;
+    });
+}
+
+File LibraryIndex::findHelpPatch(File const& directory, StringArray const& fileNames)
+{
+    auto const isInHelpPaths = std::any_of(Library::helpPaths.begin(), Library::helpPaths.end(), [&directory](File const& path) {
+        return directory == path || directory.isAChildOf(path);
+    });
+
+    std::shared_ptr<std::unordered_set<String> const> cachedFiles;
+    if (isInHelpPaths) {
+        std::lock_guard<std::mutex> lock(helpFilesLock);
+        cachedFiles = helpFiles;
     }
 
-    // These can't be created by name in Pd, but plugdata allows it
-    allObjects.add("graph");
-    allObjects.add("garray");
-    
+    for (auto const& fileName : fileNames) {
+        auto file = directory.getChildFile(fileName);
+        // Until the first scan is done, we still need to check the disk
+        if (cachedFiles ? cachedFiles->count(file.getFullPathName()) > 0 : file.existsAsFile())
+            return file;
+    }
 
-    // These aren't in there but should be
-    allObjects.add("float");
-    allObjects.add("symbol");
-    allObjects.add("list");
+    return {};
+}
 
-    sys_unlock();
+StringArray LibraryIndex::scanSearchPaths(StringArray const& searchPaths)
+{
+    // All instances update their library when the app directory changes, the first scan to get here reads what changed,
+    // and the others will find everything in the index already
+    std::lock_guard<std::mutex> lock(indexLock);
+
+    if (!objectIndex.isValid()) {
+        FileInputStream istream(objectIndexFile);
+        objectIndex = istream.openedOk() ? ValueTree::readFromStream(istream) : ValueTree();
+        if (!objectIndex.hasType("ObjectIndex"))
+            objectIndex = ValueTree("ObjectIndex");
+    }
+
+    StringArray changedFiles;
+    {
+        std::lock_guard<std::mutex> changedFilesGuard(changedFilesLock);
+        changedFiles.swapWith(pendingFileChanges);
+    }
+
+    // Only the directories and files that changed since the last time need to be read again
+    auto newIndex = ValueTree("ObjectIndex");
+    bool indexChanged = false;
+    StringArray abstractions;
+    for (auto const& filePath : searchPaths) {
+        auto directory = File(filePath);
+        if (!directory.exists() || !directory.isDirectory())
+            continue;
+
+        auto entry = indexDirectory(directory, objectIndex.getChildWithProperty("Path", filePath), changedFiles, indexChanged);
+        for (auto object : entry) {
+            abstractions.add(object.getProperty("Name").toString());
+        }
+        newIndex.appendChild(entry, nullptr);
+    }
+
+    if (indexChanged || newIndex.getNumChildren() != objectIndex.getNumChildren()) {
+        MemoryOutputStream ostream;
+        newIndex.writeToStream(ostream);
+        objectIndexFile.getParentDirectory().createDirectory();
+        objectIndexFile.replaceWithData(ostream.getData(), ostream.getDataSize());
+    }
+    objectIndex = newIndex;
+
+    return abstractions;
 }
 
-Library::Library(pd::Instance* instance)
+ValueTree LibraryIndex::indexDirectory(File const& directory, ValueTree const& cachedEntry, StringArray const& changedFiles, bool& indexChanged)
 {
-    MemoryInputStream instream(BinaryData::Documentation_bin, BinaryData::Documentation_binSize, false);
-    documentationTree = ValueTree::readFromStream(instream);
+    // Adding, removing or renaming a file changes the modification time of its directory, so if that didn't change, we can reuse the whole entry
+    // Files reported by the file system watcher make us list the directory again anyway, in case the time didn't change enough to notice
+    auto const directoryModified = directory.getLastModificationTime().toMilliseconds();
+    auto const hasChangedFiles = std::any_of(changedFiles.begin(), changedFiles.end(), [&directory](String const& path) {
+        return File(path).getParentDirectory() == directory;
+    });
+
+    if (cachedEntry.isValid() && static_cast<int64>(cachedEntry.getProperty("Modified")) == directoryModified && !hasChangedFiles) {
+        return cachedEntry.createCopy();
+    }
+
+    indexChanged = true;
 
-    for (auto object : documentationTree) {
-        auto categories = object.getChildWithName("categories");
-        if (!categories.isValid())
+    auto entry = ValueTree("Directory");
+    entry.setProperty("Path", directory.getFullPathName(), nullptr);
+    entry.setProperty("Modified", directoryModified, nullptr);
+
+    for (auto const& file : OSUtils::iterateDirectory(directory, false, true)) {
+        if (!file.hasFileExtension("pd"))
+            continue;
+
+        auto filename = file.getFileNameWithoutExtension();
+        if (filename.startsWith("help-") && !filename.endsWith("-help"))
             continue;
 
-        for (auto category : categories) {
-            allCategories.addIfNotAlreadyThere(category.getProperty("name").toString());
+        auto object = ValueTree("Object");
+        object.setProperty("File", file.getFullPathName(), nullptr);
+        object.setProperty("Name", filename, nullptr);
+        entry.appendChild(object, nullptr);
+    }
+
+    return entry;
+}
+
+void LibraryIndex::fileChanged(File const file, FileSystemWatcher::FileSystemEvent event)
+{
+    if (file.hasFileExtension("pd")) {
+        std::lock_guard<std::mutex> lock(changedFilesLock);
+        pendingFileChanges.addIfNotAlreadyThere(file.getFullPathName());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(directoryListingsLock);
+        directoryListings.erase(file.getParentDirectory().getFullPathName());
+    }
+
+    // Settings and autosave files can't be help patches
+    if (!file.isHidden() && !file.getFileName().startsWith("."))
+        scanHelpFiles();
+}
+
+// Read-only view of Documentation.bin, which is generated by Resources/Scripts/parse_documentation.py
+// It starts with a table of all objects, sorted by the hash of their name, that points to the documentation of each object in JUCE's ValueTree format
+// The data lives in the binary itself, so all plugin instances share it, and we only decode the objects that are asked for
+class DocumentationStore {
+public:
+    static DocumentationStore const& getInstance()
+    {
+        static DocumentationStore store;
+        return store;
+    }
+
+    ValueTree getObjectInfo(String const& name) const
+    {
+        auto const hash = hashName(name);
+
+        // Find the first entry with this hash
+        int low = 0, high = numObjects;
+        while (low < high) {
+            auto const mid = (low + high) / 2;
+            if (getEntryHash(mid) < hash)
+                low = mid + 1;
+            else
+                high = mid;
         }
+
+        // Different names could have the same hash
+        for (int i = low; i < numObjects && getEntryHash(i) == hash; i++) {
+            auto const* entry = data + headerSize + i * entrySize;
+            auto const offset = ByteOrder::littleEndianInt(entry + 8);
+            auto const size = ByteOrder::littleEndianInt(entry + 12);
+            if (static_cast<size_t>(offset) + size > dataSize)
+                break;
+
+            auto info = ValueTree::readFromData(data + offset, size);
+            if (info.getProperty("name").toString() == name)
+                return info;
+        }
+
+        return {};
     }
 
-    watcher.addFolder(ProjectInfo::appDataDir);
-    watcher.addListener(this);
+    StringArray const& getCategories() const
+    {
+        return categories;
+    }
 
-    // Paths to search
-    // First, only search vanilla, then search all documentation
-    // Lastly, check the deken folder
-    helpPaths = {
-        ProjectInfo::appDataDir.getChildFile("Documentation"),
-        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("5.reference"),
-        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("9.else"),
-        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("10.cyclone"),
-        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("11.heavylib"),
-        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("13.pdlua"),
-        ProjectInfo::appDataDir.getChildFile("Extra"),
-        ProjectInfo::appDataDir.getChildFile("Externals")
-    };
+private:
+    DocumentationStore()
+        : data(BinaryData::Documentation_bin)
+        , dataSize(static_cast<size_t>(BinaryData::Documentation_binSize))
+    {
+        if (dataSize < headerSize || String(CharPointer_UTF8(data), 4) != "PDDC" || ByteOrder::littleEndianInt(data + 4) != formatVersion) {
+            jassertfalse; // Documentation.bin is out of date, run parse_documentation.py
+            return;
+        }
+
+        auto const objects = static_cast<int>(ByteOrder::littleEndianInt(data + 8));
+        auto const numCategories = static_cast<int>(ByteOrder::littleEndianInt(data + 12));
+
+        auto categoriesStart = headerSize + static_cast<size_t>(objects) * entrySize;
+        if (categoriesStart > dataSize)
+            return;
+
+        numObjects = objects;
+
+        auto const* category = data + categoriesStart;
+        for (int i = 0; i < numCategories && category < data + dataSize; i++) {
+            auto length = strnlen(category, data + dataSize - category);
+            categories.add(String::fromUTF8(category, static_cast<int>(length)));
+            category += length + 1;
+        }
+    }
+
+    // 64-bit FNV-1a, must match the one in parse_documentation.py
+    static uint64 hashName(String const& name)
+    {
+        uint64 hash = 0xcbf29ce484222325ull;
+        for (auto const* c = name.toRawUTF8(); *c; c++) {
+            hash ^= static_cast<uint8>(*c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    uint64 getEntryHash(int index) const
+    {
+        return ByteOrder::littleEndianInt64(data + headerSize + index * entrySize);
+    }
+
+    static constexpr size_t headerSize = 16;
+    static constexpr size_t entrySize = 16;
+    static constexpr uint32 formatVersion = 1;
+
+    char const* data;
+    size_t dataSize;
+    int numObjects = 0;
+    StringArray categories;
+};
+
+Library::Library(pd::Instance* instance)
+{
+    // The index only records which files changed, every library still needs to update itself
+    index->watcher.addListener(this);
 
     // This is unfortunately necessary to make Windows LV2 turtle dump work
     // Let's hope its not harmful
@@ -139,29 +377,57 @@ Library::Library(pd::Instance* instance)
 StringArray Library::autocomplete(String const& query, File const& patchDirectory) const
 {
     StringArray result;
-    result.ensureStorageAllocated(20);
+    result.ensureStorageAllocated(maxAutocompleteResults);
 
     if (patchDirectory.isDirectory()) {
-        for (auto const& file : OSUtils::iterateDirectory(patchDirectory, false, true, 20)) {
-            auto filename = file.getFileNameWithoutExtension();
-            if (file.hasFileExtension("pd") && filename.startsWith(query) && !filename.startsWith("help-") && !filename.endsWith("-help")) {
+        for (auto const& filename : index->getPatchDirectoryAbstractions(patchDirectory)) {
+            if (result.size() >= maxAutocompleteResults)
+                break;
+
+            if (filename.startsWith(query))
                 result.add(filename);
-            }
         }
     }
 
-    for (auto const& str : allObjects) {
-        if (result.size() >= 20)
+    // allObjects is sorted, so all names that start with the query are next to each other
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
+    auto const numFromPatchDirectory = result.size();
+    for (auto it = std::lower_bound(allObjects.begin(), allObjects.end(), query); it != allObjects.end() && it->startsWith(query); ++it) {
+        if (result.size() >= maxAutocompleteResults)
             break;
 
-        if (str.startsWith(query)) {
-            result.addIfNotAlreadyThere(str);
-        }
+        // Only the names from the patch directory can be duplicates, since allObjects is deduplicated
+        if (!std::any_of(result.begin(), result.begin() + numFromPatchDirectory, [it](String const& name) { return name == *it; }))
+            result.add(*it);
     }
 
     return result;
 }
 
+StringArray LibraryIndex::getPatchDirectoryAbstractions(File const& directory)
+{
+    // Adding, removing or renaming files changes the modification time of the directory, so we only need to list it again when that changed
+    auto const modified = directory.getLastModificationTime().toMilliseconds();
+
+    std::lock_guard<std::mutex> lock(directoryListingsLock);
+    auto& listing = directoryListings[directory.getFullPathName()];
+    if (listing.isValid && listing.modified == modified)
+        return listing.abstractions;
+
+    listing.abstractions.clear();
+    for (auto const& file : OSUtils::iterateDirectory(directory, false, true, maxFilesToList)) {
+        auto filename = file.getFileNameWithoutExtension();
+        if (file.hasFileExtension("pd") && !filename.startsWith("help-") && !filename.endsWith("-help")) {
+            listing.abstractions.add(filename);
+        }
+    }
+    listing.abstractions.sort(false);
+    listing.modified = modified;
+    listing.isValid = true;
+
+    return listing.abstractions;
+}
+
 void Library::getExtraSuggestions(int currentNumSuggestions, String const& query, std::function<void(StringArray)> const& callback)
 {
 
@@ -169,50 +435,140 @@ void Library::getExtraSuggestions(int currentNumSuggestions, String const& query
     if (currentNumSuggestions > maxSuggestions)
         return;
 
-    objectSearchThread.addJob([this, callback, query]() mutable {
-        StringArray result;
-        StringArray matches;
+    // Every keystroke starts a new query, only the latest one is still relevant
+    auto const queryId = ++latestQueryId;
 
-        for (const auto& object : getAllObjects()) {
-            auto info = getObjectInfo(object);
+    objectSearchThread.addJob([this, callback, query, queryId]() mutable {
+        if (queryId != latestQueryId)
+            return;
 
-            auto description = info.getProperty("description").toString();
+        auto result = searchObjects(query, maxExtraSuggestions);
 
-            auto iolets = info.getChildWithName("iolets");
-            auto arguments = info.getChildWithName("arguments");
+        if (queryId != latestQueryId)
+            return;
 
-            if (description.contains(query) || object.contains(query)) {
-                matches.addIfNotAlreadyThere(object);
-            }
+        MessageManager::callAsync([callback, result]() {
+            callback(result);
+        });
+    });
+}
 
-            for (auto arg : arguments) {
-                auto argDescription = arg.getProperty("description").toString();
-                if (argDescription.contains(query)) {
-                    matches.addIfNotAlreadyThere(object);
-                }
-            }
+StringArray Library::tokenize(String const& text)
+{
+    return StringArray::fromTokens(text.toLowerCase(), " \t\r\n.,;:()[]{}<>\"'/=+*!?", "");
+}
 
-            for (auto iolet : iolets) {
-                auto ioletDescription = iolet.getProperty("description").toString();
-                if (description.contains(query)) {
-                    matches.addIfNotAlreadyThere(object);
-                }
-            }
+std::shared_ptr<Library::SearchIndex const> Library::getSearchIndex()
+{
+    // Reading the documentation of every object takes a while, so the index is built without holding the lock
+    StringArray objects;
+    int version;
+    {
+        std::lock_guard<std::recursive_mutex> lock(libraryLock);
+        if (searchIndex)
+            return searchIndex;
+
+        objects = allObjects;
+        version = allObjectsVersion;
+    }
+
+    auto index = std::make_shared<SearchIndex>();
+    auto addTokens = [&index](String const& text, int object, int weight) {
+        for (auto const& token : tokenize(text)) {
+            if (token.isNotEmpty())
+                index->entries.push_back({ token, object, weight });
         }
+    };
 
-        matches.sort(true);
-        result.addArray(matches);
-        matches.clear();
+    for (auto const& name : objects) {
+        auto const object = index->objects.size();
+        index->objects.add(name);
 
-        MessageManager::callAsync([callback, result]() {
-            callback(result);
-        });
+        addTokens(name, object, nameWeight);
+
+        auto info = getObjectInfo(name);
+        if (!info.isValid())
+            continue;
+
+        addTokens(info.getProperty("description").toString(), object, descriptionWeight);
+
+        for (auto argument : info.getChildWithName("arguments")) {
+            addTokens(argument.getProperty("description").toString(), object, detailWeight);
+        }
+        for (auto iolet : info.getChildWithName("iolets")) {
+            addTokens(iolet.getProperty("tooltip").toString(), object, detailWeight);
+        }
+    }
+
+    std::sort(index->entries.begin(), index->entries.end(), [](auto const& a, auto const& b) { return a.token < b.token; });
+
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
+    if (version != allObjectsVersion)
+        return index;
+
+    // Another thread could have built it in the meantime
+    if (!searchIndex)
+        searchIndex = index;
+    return searchIndex;
+}
+
+StringArray Library::searchObjects(String const& query, int maxResults)
+{
+    auto const queryTokens = tokenize(query);
+    if (queryTokens.isEmpty())
+        return {};
+
+    auto const index = getSearchIndex();
+    auto const& entries = index->entries;
+
+    // Every word of the query has to match the start of a word in the name or documentation
+    // Objects score higher when the word matches completely, and when it matches the name rather than the documentation
+    std::unordered_map<int, int> scores;
+    for (int i = 0; i < queryTokens.size(); i++) {
+        auto const& queryToken = queryTokens[i];
+
+        std::unordered_map<int, int> tokenScores;
+        auto it = std::lower_bound(entries.begin(), entries.end(), queryToken, [](auto const& entry, String const& token) { return entry.token < token; });
+        for (; it != entries.end() && it->token.startsWith(queryToken); ++it) {
+            auto const score = it->token.length() == queryToken.length() ? it->weight * 2 : it->weight;
+            auto& tokenScore = tokenScores[it->object];
+            tokenScore = std::max(tokenScore, score);
+        }
+
+        if (i == 0) {
+            scores = std::move(tokenScores);
+            continue;
+        }
+
+        for (auto scoreIt = scores.begin(); scoreIt != scores.end();) {
+            auto tokenScore = tokenScores.find(scoreIt->first);
+            if (tokenScore == tokenScores.end()) {
+                scoreIt = scores.erase(scoreIt);
+            } else {
+                scoreIt->second += tokenScore->second;
+                ++scoreIt;
+            }
+        }
+    }
+
+    auto ranked = std::vector<std::pair<int, int>>(scores.begin(), scores.end());
+    std::sort(ranked.begin(), ranked.end(), [&index](auto const& a, auto const& b) {
+        if (a.second != b.second)
+            return a.second > b.second;
+        return index->objects[a.first] < index->objects[b.first];
     });
+
+    StringArray result;
+    for (int i = 0; i < std::min<int>(maxResults, ranked.size()); i++) {
+        result.add(index->objects[ranked[i].first]);
+    }
+
+    return result;
 }
 
 ValueTree Library::getObjectInfo(String const& name)
 {
-    return documentationTree.getChildWithProperty("name", name);
+    return DocumentationStore::getInstance().getObjectInfo(name);
 }
 
 std::array<StringArray, 2> Library::parseIoletTooltips(ValueTree const& iolets, String const& name, int numIn, int numOut)
@@ -268,14 +624,81 @@ std::array<StringArray, 2> Library::parseIoletTooltips(ValueTree const& iolets,
     return result;
 }
 
+std::array<StringArray, 2> const& Library::getIoletTooltips(String const& type, String const& text, int numIn, int numOut)
+{
+    auto [typeIter, isNewType] = ioletTooltipCache.try_emplace(type);
+    auto& cached = typeIter->second;
+    if (isNewType) {
+        for (auto iolet : getObjectInfo(type).getChildWithName("iolets")) {
+            if (iolet.getProperty("tooltip").toString().contains("$arg"))
+                cached.usesArguments = true;
+        }
+    }
+
+    auto key = String(numIn) + ":" + String(numOut);
+    if (cached.usesArguments)
+        key += ":" + text.fromFirstOccurrenceOf(" ", false, false);
+
+    auto it = cached.tooltips.find(key);
+    if (it == cached.tooltips.end())
+        it = cached.tooltips.emplace(key, parseIoletTooltips(getObjectInfo(type).getChildWithName("iolets"), text, numIn, numOut)).first;
+
+    return it->second;
+}
+
 StringArray Library::getAllObjects()
 {
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
     return allObjects;
 }
 
 StringArray Library::getAllCategories()
 {
-    return allCategories;
+    return DocumentationStore::getInstance().getCategories();
+}
+
+std::shared_ptr<Library::BrowserIndex const> Library::getBrowserIndex()
+{
+    // Reading the documentation of every object takes a while, so the index is built without holding the lock
+    StringArray objects;
+    int version;
+    {
+        std::lock_guard<std::recursive_mutex> lock(libraryLock);
+        if (browserIndex)
+            return browserIndex;
+
+        objects = allObjects;
+        version = allObjectsVersion;
+    }
+
+    auto index = std::make_shared<BrowserIndex>();
+    auto& allCategory = index->objectsByCategory["All"];
+    for (auto const& name : objects) {
+        // Also include undocumented objects
+        allCategory.add(name);
+
+        auto info = getObjectInfo(name);
+        if (!info.isValid())
+            continue;
+
+        index->descriptions[name] = info.getProperty("description").toString();
+        for (auto category : info.getChildWithName("categories")) {
+            index->objectsByCategory[category.getProperty("name").toString()].add(name);
+        }
+    }
+
+    for (auto& [category, categoryObjects] : index->objectsByCategory) {
+        categoryObjects.sort(true);
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(libraryLock);
+    if (version != allObjectsVersion)
+        return index;
+
+    // Another thread could have built it in the meantime
+    if (!browserIndex)
+        browserIndex = index;
+    return browserIndex;
 }
 
 void Library::filesystemChanged()
@@ -329,17 +752,10 @@ File Library::findHelpfile(t_gobj* obj, File const& parentPatchFile) const
         patchHelpPaths.add(helpDir.isNotEmpty() ? path.getChildFile(helpDir) : path);
     }
 
-    String firstName = helpName + "-help.pd";
-    String secondName = "help-" + helpName + ".pd";
+    auto const helpFileNames = StringArray { helpName + "-help.pd", "help-" + helpName + ".pd" };
 
-    auto findHelpPatch = [&firstName, &secondName](File const& searchDir) -> File {
-        for (const auto& file : OSUtils::iterateDirectory(searchDir, false, true)) {
-            auto pathName = file.getFullPathName().replace("\\", "/").trimCharactersAtEnd("/");
-            if (pathName.endsWith("/" + firstName) || pathName.endsWith("/" + secondName)) {
-                return file;
-            }
-        }
-        return {};
+    auto findHelpPatch = [this, &helpFileNames](File const& searchDir) -> File {
+        return index->findHelpPatch(searchDir, helpFileNames);
     };
 
     for (auto& path : patchHelpPaths) {
@@ -7,12 +7,70 @@
 #pragma once
 
 #include <m_pd.h>
+#include <unordered_set>
 #include "Utility/FileSystemWatcher.h"
 #include "Utility/Config.h"
 
 namespace pd {
 
 class Instance;
+
+// Library state that's the same for all plugin instances in the process: the watcher on the app data directory,
+// the index of abstractions in the search paths, and the cached listings of patch directories
+// Use through a SharedResourcePointer
+class LibraryIndex : public FileSystemWatcher::Listener {
+public:
+    LibraryIndex();
+
+    // Finds the names of the abstractions in the search paths, only the directories that changed since the last call are listed again
+    StringArray scanSearchPaths(StringArray const& searchPaths);
+
+    // Abstractions in a patch's directory, these are cached until the directory changes
+    StringArray getPatchDirectoryAbstractions(File const& directory);
+
+    // Looks for a help patch with one of these file names in a directory
+    // Inside the help paths this uses the cached list of help patches, so it doesn't need to touch the disk
+    File findHelpPatch(File const& directory, StringArray const& fileNames);
+
+    void fileChanged(File const file, FileSystemWatcher::FileSystemEvent event) override;
+
+    FileSystemWatcher watcher;
+
+private:
+    ValueTree indexDirectory(File const& directory, ValueTree const& cachedEntry, StringArray const& changedFiles, bool& indexChanged);
+
+    // Index of the abstractions in the search paths, stored on disk so we only need to read what changed since the last time
+    static inline File const objectIndexFile = ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("ObjectIndex.bin");
+    ValueTree objectIndex;
+    std::mutex indexLock;
+
+    // Files reported by the file system watcher, their directories will be listed again on the next scan
+    std::mutex changedFilesLock;
+    StringArray pendingFileChanges;
+
+    struct DirectoryListing {
+        StringArray abstractions;
+        int64 modified = 0;
+        bool isValid = false;
+    };
+
+    std::unordered_map<String, DirectoryListing> directoryListings;
+    std::mutex directoryListingsLock;
+
+    static constexpr int maxFilesToList = 2000;
+
+    // Full paths of all help patches in the help paths, this is scanned again in the background when something in the app directory changes
+    void scanHelpFiles();
+    std::shared_ptr<std::unordered_set<String> const> helpFiles;
+    std::mutex helpFilesLock;
+    std::atomic<bool> helpFileScanPending = false;
+
+    // Declared last, so it finishes scanning before the index is deleted
+    ThreadPool helpFileScanThread = ThreadPool(1);
+};
+
+// Objects that can be created in a pd instance, and their documentation
+// Only the class table is specific to the instance, everything else comes from the shared LibraryIndex
 class Library : public FileSystemWatcher::Listener {
 
 public:
@@ -20,6 +78,7 @@ public:
 
     ~Library() override
     {
+        index->watcher.removeListener(this);
         appDirChanged = nullptr;
         objectSearchThread.removeAllJobs(true, -1);
     }
@@ -29,8 +88,15 @@ public:
     StringArray autocomplete(String const& query, File const& patchDirectory) const;
     void getExtraSuggestions(int currentNumSuggestions, String const& query, std::function<void(StringArray)> const& callback);
 
+    // Finds objects by their name and documentation, with the best matches first
+    StringArray searchObjects(String const& query, int maxResults);
+
     static std::array<StringArray, 2> parseIoletTooltips(ValueTree const& iolets, String const& name, int numIn, int numOut);
 
+    // Same as parseIoletTooltips for the documentation of this object type, but cached by the number of iolets
+    // The arguments are only part of the key if the documentation refers to them with $arg. Only call this from the message thread
+    std::array<StringArray, 2> const& getIoletTooltips(String const& type, String const& text, int numIn, int numOut);
+
     void filesystemChanged() override;
 
     File findHelpfile(t_gobj* obj, File const& parentPatchFile) const;
@@ -40,7 +106,28 @@ public:
     StringArray getAllObjects();
     StringArray getAllCategories();
 
-    Array<File> helpPaths;
+    // Descriptions of all objects, and the objects of every category sorted by name, the "All" category has every object
+    // It's built on the library thread after every update, so the object browser doesn't have to decode all documentation when it opens
+    struct BrowserIndex {
+        std::unordered_map<String, String> descriptions;
+        std::unordered_map<String, StringArray> objectsByCategory;
+    };
+
+    std::shared_ptr<BrowserIndex const> getBrowserIndex();
+
+    // Paths to search
+    // First, only search vanilla, then search all documentation
+    // Lastly, check the deken folder
+    static inline Array<File> const helpPaths = {
+        ProjectInfo::appDataDir.getChildFile("Documentation"),
+        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("5.reference"),
+        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("9.else"),
+        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("10.cyclone"),
+        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("11.heavylib"),
+        ProjectInfo::appDataDir.getChildFile("Documentation").getChildFile("13.pdlua"),
+        ProjectInfo::appDataDir.getChildFile("Extra"),
+        ProjectInfo::appDataDir.getChildFile("Externals")
+    };
 
     std::function<void()> appDirChanged;
 
@@ -57,15 +144,48 @@ public:
     static inline StringArray objectOrigins = { "vanilla", "ELSE", "cyclone", "heavylib", "pdlua" };
 
 private:
+    // Inverted index over the words in the names and documentation of all objects
+    // It's built on the first search after the library was updated, and never changed after that, so it can be shared between threads
+    struct SearchIndex {
+        struct Entry {
+            String token;
+            int object;
+            int weight;
+        };
+
+        std::vector<Entry> entries; // Sorted by token, so we can find all tokens that start with a word
+        StringArray objects;
+    };
+
+    std::shared_ptr<SearchIndex const> getSearchIndex();
+    static StringArray tokenize(String const& text);
+
+    static constexpr int nameWeight = 8;
+    static constexpr int descriptionWeight = 3;
+    static constexpr int detailWeight = 1;
+    static constexpr int maxExtraSuggestions = 100;
+
+    std::shared_ptr<SearchIndex const> searchIndex;
+    std::shared_ptr<BrowserIndex const> browserIndex;
+    std::atomic<int> latestQueryId = 0;
+
+    struct IoletTooltips {
+        bool usesArguments = false;
+        std::unordered_map<String, std::array<StringArray, 2>> tooltips;
+    };
+
+    std::unordered_map<String, IoletTooltips> ioletTooltipCache;
+
     StringArray allObjects;
-    StringArray allCategories;
+    mutable std::recursive_mutex libraryLock;
 
-    std::recursive_mutex libraryLock;
+    // Changes whenever allObjects is replaced, so an index that was built from an older list isn't published
+    int allObjectsVersion = 0;
 
-    FileSystemWatcher watcher;
-    ThreadPool objectSearchThread = ThreadPool(1);
+    static constexpr int maxAutocompleteResults = 20;
 
-    ValueTree documentationTree;
+    SharedResourcePointer<LibraryIndex> index;
+    ThreadPool objectSearchThread = ThreadPool(1);
 };
 
 } // namespace pd
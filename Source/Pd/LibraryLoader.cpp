@@ -0,0 +1,185 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Utility/Config.h"
+
+extern "C" {
+#include <m_pd.h>
+#include <g_canvas.h>
+#include <m_imp.h>
+#include <s_stuff.h>
+#include <z_libpd.h>
+}
+
+#include "LibraryLoader.h"
+
+namespace pd {
+
+JUCE_IMPLEMENT_SINGLETON(LibraryLoader)
+
+LibraryLoader::LibraryLoader()
+{
+    if (auto tree = ValueTree::fromXml(manifestFile.loadFileAsString()); tree.isValid() && tree.hasType("LibraryManifest")) {
+        manifest = tree;
+    }
+
+    sys_register_loader(loader);
+}
+
+LibraryLoader::~LibraryLoader()
+{
+    clearSingletonInstance();
+}
+
+bool LibraryLoader::loadLibrary(String const& name, int64 modified)
+{
+    // Deferring is disabled, or we can't find the library on disk, so there's nothing to defer or record
+    if (modified == 0)
+        return sys_load_lib(nullptr, name.toRawUTF8());
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto entry = manifest.getChildWithProperty("Name", name);
+
+        // We can only defer libraries that didn't change since the manifest was recorded
+        if (entry.isValid() && static_cast<int64>(entry.getProperty("Modified")) == modified) {
+            for (auto object : entry) {
+                deferredClasses[object.getProperty("Name").toString()] = name;
+            }
+            return true;
+        }
+    }
+
+    auto const classesBefore = getObjectMakerNames();
+    if (!sys_load_lib(nullptr, name.toRawUTF8()))
+        return false;
+
+    StringArray newClasses;
+    for (auto const& className : getObjectMakerNames()) {
+        if (!classesBefore.contains(className))
+            newClasses.add(className);
+    }
+
+    // Nothing new means it was already loaded, or it's built into plugdata, there's nothing to defer then
+    if (newClasses.isEmpty())
+        return true;
+
+    std::lock_guard<std::mutex> guard(lock);
+    manifest.removeChild(manifest.getChildWithProperty("Name", name), nullptr);
+
+    auto entry = ValueTree("Library");
+    entry.setProperty("Name", name, nullptr);
+    entry.setProperty("Modified", modified, nullptr);
+    for (auto const& className : newClasses) {
+        auto object = ValueTree("Object");
+        object.setProperty("Name", className, nullptr);
+        entry.appendChild(object, nullptr);
+    }
+    manifest.appendChild(entry, nullptr);
+
+    saveManifest();
+    return true;
+}
+
+StringArray LibraryLoader::getDeferredObjects()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    StringArray objects;
+    objects.ensureStorageAllocated(static_cast<int>(deferredClasses.size()));
+    for (auto const& [className, library] : deferredClasses) {
+        objects.add(className);
+    }
+    return objects;
+}
+
+// pd calls this for every search path when it can't find a class
+int LibraryLoader::loader(t_canvas* canvas, char const* className, char const* path)
+{
+    // Loading the library calls the loaders again, with the name of the library
+    static thread_local bool isLoading = false;
+    if (isLoading)
+        return 0;
+
+    // pd keeps calling the loader after the loader itself is deleted at shutdown
+    auto* instance = getInstanceWithoutCreating();
+    if (!instance)
+        return 0;
+
+    String library;
+    {
+        std::lock_guard<std::mutex> guard(instance->lock);
+        auto it = instance->deferredClasses.find(String::fromUTF8(className));
+        if (it == instance->deferredClasses.end())
+            return 0;
+        library = it->second;
+    }
+
+    isLoading = true;
+    sys_load_lib(canvas, library.toRawUTF8());
+    isLoading = false;
+
+    // Other instances still need to load the library themselves, so we keep the deferred classes around
+    return zgetfn(&pd_objectmaker, gensym(className)) != nullptr;
+}
+
+StringArray LibraryLoader::getObjectMakerNames()
+{
+    StringArray names;
+
+    t_class* o = pd_objectmaker;
+    auto* mlist = static_cast<t_methodentry*>(libpd_get_class_methods(o));
+    t_methodentry* m;
+
+    int i;
+    for (i = o->c_nmethod, m = mlist; i--; m++) {
+        if (m && m->me_name)
+            names.add(String::fromUTF8(m->me_name->s_name));
+    }
+
+    return names;
+}
+
+StringArray LibraryLoader::getSearchPaths()
+{
+    StringArray paths;
+    for (auto* path = STUFF->st_searchpath; path; path = path->nl_next) {
+        paths.add(String::fromUTF8(path->nl_string));
+    }
+    return paths;
+}
+
+int64 LibraryLoader::getLibraryModificationTime(String const& name, StringArray const& searchPaths)
+{
+    int64 modified = 0;
+
+    // Libraries are either directly in a search path, or in a folder with the library's name
+    for (auto const& path : searchPaths) {
+        auto const searchPath = File(path);
+        for (auto const& directory : { searchPath, searchPath.getChildFile(name) }) {
+            if (!directory.isDirectory())
+                continue;
+
+            for (auto const& file : directory.findChildFiles(File::findFiles, false, name + ".*")) {
+                if (!file.hasFileExtension("pd;pd_lua;lua;txt;md"))
+                    modified = std::max(modified, file.getLastModificationTime().toMilliseconds());
+            }
+        }
+    }
+
+    return modified;
+}
+
+void LibraryLoader::saveManifest()
+{
+    writeThread.addJob([xml = manifest.toXmlString()]() {
+        manifestFile.getParentDirectory().createDirectory();
+        manifestFile.replaceWithText(xml);
+    });
+}
+
+}
@@ -0,0 +1,63 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+
+namespace pd {
+
+// Loads the startup libraries from the settings only once a patch creates one of their objects
+// The first time a library is loaded, we record which classes it adds in appDataDir/Cache/LibraryManifest.xml
+// After that, we only remember its class names, and pd asks our loader for them when it can't create an object
+// Libraries can also register loaders or do other work in their setup, so deferring is only done when enabled in the settings
+// pd's list of loaders is shared by all instances, so there is only one LibraryLoader in the process
+class LibraryLoader : public DeletedAtShutdown {
+public:
+    ~LibraryLoader() override;
+
+    // Loads a library into the current instance. With a modification time from getLibraryModificationTime, loading is deferred if the manifest
+    // for the library is still valid, otherwise we record which classes it adds. With 0, it's loaded right away without touching the manifest
+    // Only use while holding the audio lock
+    bool loadLibrary(String const& name, int64 modified);
+
+    // The search paths that pd looks for libraries in, only use while holding the audio lock
+    static StringArray getSearchPaths();
+
+    // Latest modification time of the library's binaries in the search paths, or 0 if we can't find them
+    // This scans the file system, so call it without holding the audio lock
+    static int64 getLibraryModificationTime(String const& name, StringArray const& searchPaths);
+
+    // Names of the classes from libraries that haven't been loaded yet, so they can still be autocompleted
+    StringArray getDeferredObjects();
+
+private:
+    LibraryLoader();
+
+    static int loader(t_canvas* canvas, char const* className, char const* path);
+
+    static StringArray getObjectMakerNames();
+
+    void saveManifest();
+
+    struct StringHash {
+        size_t operator()(String const& s) const { return static_cast<size_t>(s.hashCode64()); }
+    };
+
+    std::mutex lock;
+    ValueTree manifest = ValueTree("LibraryManifest");
+    std::unordered_map<String, String, StringHash> deferredClasses;
+
+    static inline File const manifestFile = ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("LibraryManifest.xml");
+
+    // Declared last, so pending writes finish before the loader is deleted
+    ThreadPool writeThread = ThreadPool(1);
+
+public:
+    JUCE_DECLARE_SINGLETON(LibraryLoader, false)
+};
+
+}
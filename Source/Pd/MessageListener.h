@@ -6,6 +6,7 @@
 #pragma once
 
 #include "Instance.h"
+#include "Utility/Tracing.h"
 
 // These is an assertion inside readerwriterqueue that doesn't apply to us
 // (it doesn't like it when we enqueue from two differen threads, but there is always only 1 thread that has exclusive action to enqueue, so it should be fine
@@ -20,6 +21,15 @@ class MessageListener {
 public:
     virtual void receiveMessage(t_symbol* symbol, pd::Atom const atoms[8], int numAtoms) = 0;
 
+    // Messages that only contain a float are by far the most common (values of GUI objects), so they take a shorter path
+    // Override this to handle them without unpacking atoms, by default they are forwarded to receiveMessage
+    virtual void receiveFloat(t_symbol* symbol, float value)
+    {
+        pd::Atom atoms[8];
+        atoms[0] = pd::Atom(value);
+        receiveMessage(symbol, atoms, 1);
+    }
+
     JUCE_DECLARE_WEAK_REFERENCEABLE(MessageListener)
 };
 
@@ -70,32 +80,63 @@ class MessageDispatcher : private AsyncUpdater {
     };
 
 public:
+    // The queue has a fixed size: if the GUI falls behind, new messages get dropped instead of allocating more memory on the audio thread
+    // We still coalesce messages on the GUI side, so only the latest value for every target and selector will be shown
+    explicit MessageDispatcher(int queueSize = defaultQueueSize)
+        : messageQueue(queueSize)
+        , capacity(queueSize)
+    {
+    }
+
+    // Not thread-safe, only call this when no messages can be enqueued or dispatched
+    void setQueueSize(int queueSize)
+    {
+        messageQueue = moodycamel::ReaderWriterQueue<Message>(queueSize);
+        capacity = queueSize;
+    }
+
     void enqueueMessage(void* target, t_symbol* symbol, int argc, t_atom* argv)
     {
-        messageQueue.enqueue({ target, symbol, argc, argv });
+        if (suspended.load(std::memory_order_relaxed))
+            return;
+
+        if (!messageQueue.try_enqueue({ target, symbol, argc, argv })) {
+            numDroppedMessages++;
+            return;
+        }
+
+        numEnqueuedMessages++;
+
+        // Only the audio thread writes this, so we don't need a compare-exchange
+        auto depth = static_cast<int>(messageQueue.size_approx());
+        if (depth > maxQueueDepth.load(std::memory_order_relaxed))
+            maxQueueDepth.store(depth, std::memory_order_relaxed);
     }
 
     void addMessageListener(void* object, pd::MessageListener* messageListener)
     {
         ScopedLock lock(messageListenerLock);
-        messageListeners[object].insert(juce::WeakReference(messageListener));
+        auto& listeners = messageListeners[object];
+        if (std::find(listeners.begin(), listeners.end(), messageListener) == listeners.end())
+            listeners.emplace_back(messageListener);
     }
 
     void removeMessageListener(void* object, MessageListener* messageListener)
     {
         ScopedLock lock(messageListenerLock);
 
-        if (!messageListeners.count(object))
+        auto listenersIter = messageListeners.find(object);
+        if (listenersIter == messageListeners.end())
             return;
 
-        auto& listeners = messageListeners[object];
+        auto& listeners = listenersIter->second;
         auto it = std::find(listeners.begin(), listeners.end(), messageListener);
 
         if (it != listeners.end())
             listeners.erase(it);
 
         if (listeners.empty())
-            messageListeners.erase(object);
+            messageListeners.erase(listenersIter);
     }
 
     void dispatch()
@@ -105,53 +146,195 @@ public:
         }
     }
 
+    // Number of messages that were replaced by a newer message to the same target and selector, before the GUI got to them
+    int64 getNumCoalescedMessages() const
+    {
+        return numCoalescedMessages;
+    }
+
+    int64 getNumEnqueuedMessages() const
+    {
+        return numEnqueuedMessages;
+    }
+
+    int64 getNumDroppedMessages() const
+    {
+        return numDroppedMessages;
+    }
+
+    int getMaxQueueDepth() const
+    {
+        return maxQueueDepth;
+    }
+
+    int getQueueCapacity() const
+    {
+        return capacity;
+    }
+
+    // While suspended, messages for the GUI are ignored instead of queued. Used while rendering offline, where the GUI
+    // can't keep up and nobody is watching it anyway
+    void setSuspended(bool shouldBeSuspended)
+    {
+        suspended.store(shouldBeSuspended, std::memory_order_relaxed);
+    }
+
+    static constexpr int defaultQueueSize = 32768;
+
+    // When profiling is enabled, we count how many messages every target has received, including the ones that get coalesced
+    // This helps to find runaway message loops. Only use these from the message thread
+    void setProfilingEnabled(bool enabled)
+    {
+        profilingEnabled = enabled;
+        if (!enabled)
+            messageCounts.clear();
+    }
+
+    int64 getMessageCount(void* target) const
+    {
+        auto it = messageCounts.find(target);
+        return it != messageCounts.end() ? it->second : 0;
+    }
+
 private:
+    // Slot in the open-addressing table we use to keep only the latest message for every target/selector pair
+    struct Slot {
+        Message message;
+        int numMessages = 0;
+        bool used = false;
+    };
+
+    static size_t hashKey(void* target, t_symbol* symbol)
+    {
+        auto hash = reinterpret_cast<size_t>(target) >> 3;
+        hash ^= (reinterpret_cast<size_t>(symbol) >> 3) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+
+    size_t probe(std::vector<Slot> const& table, void* target, t_symbol* symbol) const
+    {
+        auto const mask = table.size() - 1;
+        auto index = hashKey(target, symbol) & mask;
+        while (table[index].used && (table[index].message.target != target || table[index].message.symbol != symbol)) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    // Keep the table at most half full, so probing stays short
+    void growIfNeeded()
+    {
+        if ((usedSlots.size() + 1) * 2 <= slots.size())
+            return;
+
+        auto oldSlots = std::move(slots);
+        slots = std::vector<Slot>(oldSlots.size() * 2);
+
+        for (auto& index : usedSlots) {
+            auto& oldSlot = oldSlots[index];
+            index = probe(slots, oldSlot.message.target, oldSlot.message.symbol);
+            slots[index] = oldSlot;
+        }
+    }
+
     void handleAsyncUpdate() override
     {
+        Tracing::ScopedEvent traceEvent("MessageDispatcher");
         Message incomingMessage;
-        std::map<size_t, Message> uniqueMessages;
 
         while (messageQueue.try_dequeue(incomingMessage)) {
-            auto hash = reinterpret_cast<size_t>(incomingMessage.target) ^ reinterpret_cast<size_t>(incomingMessage.symbol);
-            uniqueMessages[hash] = std::move(incomingMessage);
+            growIfNeeded();
+
+            auto index = probe(slots, incomingMessage.target, incomingMessage.symbol);
+            auto& slot = slots[index];
+            if (slot.used) {
+                numCoalescedMessages++;
+                slot.numMessages++;
+            } else {
+                slot.used = true;
+                slot.numMessages = 1;
+                usedSlots.push_back(index);
+            }
+
+            slot.message = incomingMessage;
         }
 
-        // Collect MessageListeners that have been deallocated for later removal
-        std::vector<std::pair<void*, std::set<juce::WeakReference<pd::MessageListener>>::iterator>> nullListeners;
+        for (auto index : usedSlots) {
+            auto& slot = slots[index];
+            slot.used = false;
 
-        for (auto& [hash, message] : uniqueMessages) {
+            auto& message = slot.message;
 
-            if (messageListeners.find(message.target) == messageListeners.end())
-                continue;
+            if (profilingEnabled)
+                messageCounts[message.target] += slot.numMessages;
 
-            for (auto it = messageListeners.at(message.target).begin(); it != messageListeners.at(message.target).end(); ++it) {
-                if (it->wasObjectDeleted())
-                    continue;
+            auto listenersIter = messageListeners.find(message.target);
+            if (listenersIter == messageListeners.end())
+                continue;
 
-                auto listener = it->get();
+            auto symbol = message.symbol ? message.symbol : gensym(""); // TODO: fix instance issues!
+            auto const isSingleFloat = message.size == 1 && message.data[0].a_type == A_FLOAT && std::strcmp(symbol->s_name, "float") == 0;
 
-                pd::Atom atoms[8];
+            pd::Atom atoms[8];
+            if (!isSingleFloat) {
                 for (int at = 0; at < message.size; at++) {
                     atoms[at] = pd::Atom(message.data + at);
                 }
-                auto symbol = message.symbol ? message.symbol : gensym(""); // TODO: fix instance issues!
+            }
 
-                if (listener)
-                    listener->receiveMessage(symbol, atoms, message.size);
+            // Listeners might add or remove listeners in their callback, so iterate over a copy
+            listenersToNotify.assign(listenersIter->second.begin(), listenersIter->second.end());
+
+            bool hasDeletedListeners = false;
+            for (auto& listener : listenersToNotify) {
+                auto* l = listener.get();
+                if (!l)
+                    hasDeletedListeners = true;
+                else if (isSingleFloat)
+                    l->receiveFloat(symbol, message.data[0].a_w.w_float);
                 else
-                    nullListeners.push_back({ message.target, it });
+                    l->receiveMessage(symbol, atoms, message.size);
             }
-        }
 
-        for (int i = nullListeners.size() - 1; i >= 0; i--) {
-            auto& [target, iterator] = nullListeners[i];
-            messageListeners[target].erase(iterator);
+            if (hasDeletedListeners) {
+                removeDeletedListeners(message.target);
+            }
         }
+
+        usedSlots.clear();
+        listenersToNotify.clear();
     }
 
-    moodycamel::ReaderWriterQueue<Message> messageQueue = moodycamel::ReaderWriterQueue<Message>(32768);
-    std::map<void*, std::set<juce::WeakReference<MessageListener>>> messageListeners;
+    void removeDeletedListeners(void* target)
+    {
+        auto listenersIter = messageListeners.find(target);
+        if (listenersIter == messageListeners.end())
+            return;
+
+        auto& listeners = listenersIter->second;
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [](auto const& listener) { return listener.wasObjectDeleted(); }), listeners.end());
+
+        if (listeners.empty())
+            messageListeners.erase(listenersIter);
+    }
+
+    std::vector<Slot> slots = std::vector<Slot>(1024);
+    std::vector<size_t> usedSlots;
+    std::vector<juce::WeakReference<MessageListener>> listenersToNotify;
+    int64 numCoalescedMessages = 0;
+
+    moodycamel::ReaderWriterQueue<Message> messageQueue;
+    int capacity;
+
+    std::atomic<int64> numEnqueuedMessages = 0;
+    std::atomic<int64> numDroppedMessages = 0;
+    std::atomic<int> maxQueueDepth = 0;
+    std::atomic<bool> suspended = false;
+    std::unordered_map<void*, std::vector<juce::WeakReference<MessageListener>>> messageListeners;
     CriticalSection messageListenerLock;
+
+    bool profilingEnabled = false;
+    std::unordered_map<void*, int64> messageCounts;
 };
 
 }
@@ -20,6 +20,7 @@ extern "C" {
 #include <m_imp.h>
 
 #include <utility>
+#include <charconv>
 
 #include "g_undo.h"
 
@@ -35,10 +36,20 @@ Patch::Patch(pd::WeakReference patchPtr, Instance* parentInstance, bool ownsPatc
     , ptr(patchPtr)
 {
     jassert(parentInstance);
+
+    instance->lockAudioThread();
+    instance->patchObjects.push_back(this);
+    instance->unlockAudioThread();
 }
 
 Patch::~Patch()
 {
+    if (instance) {
+        instance->lockAudioThread();
+        instance->patchObjects.erase(std::remove(instance->patchObjects.begin(), instance->patchObjects.end(), this), instance->patchObjects.end());
+        instance->unlockAudioThread();
+    }
+
     // Only close the patch if this is a top-level patch
     // Otherwise, this is a subpatcher and it will get cleaned up by Pd
     // when the object is deleted
@@ -100,14 +111,60 @@ void Patch::savePatch(File const& location)
         untitledPatchNum = 0;
         canvas_dirty(patch.get(), 0);
 
-        pd::Interface::saveToFile(patch.get(), file, dir);
-
-        instance->reloadAbstractions(location, patch.get());
+        if (!saveInBackground(patch.get(), location, file, dir)) {
+            pd::Interface::saveToFile(patch.get(), file, dir);
+            instance->reloadAbstractions(location, patch.get());
+        }
     }
 
     currentFile = location;
 }
 
+bool Patch::saveInBackground(t_glist* patch, File const& location, t_symbol* file, t_symbol* dir)
+{
+    // Most patches are written faster than we can hand them to another thread
+    // Patches with a lot of saved array contents can take long enough to convert to text that it blocks the UI
+    auto* contents = pd::Interface::getPatchContents(patch);
+    if (binbuf_getnatom(contents) < minBackgroundSaveAtoms) {
+        binbuf_free(contents);
+        return false;
+    }
+
+    // The contents are a snapshot, so the patch can be edited again while we're writing. If writing fails, it's marked as dirty again
+    pd::Interface::patchSaved(patch, file, dir);
+
+    instance->patchSaveThread.addJob([contents, location, file, dir, instance = juce::WeakReference<Instance>(instance), patch, patchRef = pd::WeakReference(patch, instance)]() {
+        auto const saved = pd::Interface::writePatchContents(contents, file->s_name, dir->s_name);
+        binbuf_free(contents);
+
+        MessageManager::callAsync([saved, location, instance, patch, patchRef]() {
+            if (!instance)
+                return;
+
+            if (saved) {
+                instance->logMessage("saved to: " + location.getFullPathName());
+                instance->reloadAbstractions(location, patch);
+                return;
+            }
+
+            instance->logError("Couldn't save patch to: " + location.getFullPathName());
+
+            // Otherwise the patch would look saved, and closing it wouldn't ask to save it
+            instance->lockAudioThread();
+            if (auto cnv = patchRef.get<t_glist>()) {
+                canvas_dirty(cnv.get(), 1);
+                for (auto* patchObject : instance->patchObjects) {
+                    if (patchObject->getUncheckedPointer() == cnv.get())
+                        patchObject->updateDirtyState();
+                }
+            }
+            instance->unlockAudioThread();
+        });
+    });
+
+    return true;
+}
+
 t_glist* Patch::getRoot()
 {
     if (auto patch = ptr.get<t_canvas>()) {
@@ -142,6 +199,9 @@ void Patch::updateUndoRedoState()
         canPatchRedo = pd::Interface::canRedo(patch.get());
         isPatchDirty = patch->gl_dirty;
 
+        // Long sessions would otherwise keep growing the undo history, and walking it for the size gets slower too
+        pd::Interface::trimUndoQueue(patch.get(), instance->maxUndoSteps.load());
+
         auto undoSize = pd::Interface::getUndoSize(patch.get());
         if (undoQueueSize != undoSize) {
             undoQueueSize = undoSize;
@@ -151,6 +211,13 @@ void Patch::updateUndoRedoState()
     }
 }
 
+void Patch::updateDirtyState()
+{
+    if (auto patch = ptr.get<t_glist>()) {
+        isPatchDirty = patch->gl_dirty;
+    }
+}
+
 void Patch::savePatch()
 {
     String fullPathname = currentFile.getParentDirectory().getFullPathName();
@@ -164,13 +231,14 @@ void Patch::savePatch()
         untitledPatchNum = 0;
         canvas_dirty(patch.get(), 0);
 
+        if (saveInBackground(patch.get(), currentFile, file, dir))
+            return;
+
         pd::Interface::saveToFile(patch.get(), file, dir);
     }
 
     MessageManager::callAsync([this, patch = ptr.getRaw<t_glist>()]() {
-        sys_lock();
         instance->reloadAbstractions(currentFile, patch);
-        sys_unlock();
     });
 }
 
@@ -225,6 +293,7 @@ std::vector<pd::WeakReference> Patch::getObjects()
 
 t_gobj* Patch::createObject(int x, int y, String const& name)
 {
+    instance->patchEdited = true;
 
     StringArray tokens;
     tokens.addTokens(name, false);
@@ -300,7 +369,10 @@ t_gobj* Patch::createObject(int x, int y, String const& name)
 
     if (auto patch = ptr.get<t_glist>()) {
         setCurrent();
-        return pd::Interface::createObject(patch.get(), typesymbol, argc, argv.data());
+        auto* object = pd::Interface::createObject(patch.get(), typesymbol, argc, argv.data());
+        if (object)
+            instance->busIndex.objectChanged(object, patch.get());
+        return object;
     }
 
     return nullptr;
@@ -315,115 +387,240 @@ t_gobj* Patch::renameObject(t_object* obj, String const& name)
     String newName = tokens.joinIntoString(" ");
 
     if (auto patch = ptr.get<t_glist>()) {
+        instance->patchEdited = true;
         setCurrent();
 
+        instance->busIndex.objectRemoved(&obj->te_g);
         pd::Interface::renameObject(patch.get(), &obj->te_g, newName.toRawUTF8(), newName.getNumBytesAsUTF8());
-        return pd::Interface::getNewest(patch.get());
+
+        auto* newest = pd::Interface::getNewest(patch.get());
+        if (newest)
+            instance->busIndex.objectChanged(newest, patch.get());
+        return newest;
     }
 
     return nullptr;
 }
 
+// Nested scopes get a state of 0 from canvas_suspend_dsp, so only the outermost one restarts DSP
+Patch::ScopedDspSuspend::ScopedDspSuspend()
+    : dspState(canvas_suspend_dsp())
+{
+}
+
+Patch::ScopedDspSuspend::~ScopedDspSuspend()
+{
+    canvas_resume_dsp(dspState);
+}
+
+Patch::ScopedBatchEdit::ScopedBatchEdit(Instance* pd)
+    : instance(pd)
+{
+    instance->setThis();
+    instance->lockAudioThread();
+    dspSuspend.emplace();
+}
+
+Patch::ScopedBatchEdit::~ScopedBatchEdit()
+{
+    instance->setThis();
+    dspSuspend.reset();
+    instance->unlockAudioThread();
+}
+
 void Patch::copy(std::vector<t_gobj*> const& objects)
 {
     if (auto patch = ptr.get<t_glist>()) {
         int size;
         char const* text = pd::Interface::copy(patch.get(), &size, objects);
         auto copied = String::fromUTF8(text, size);
+
+        // Keep the atoms, so we don't need to parse the text again if it's pasted in plugdata
+        auto* copyBuffer = libpd_this_instance()->pd_gui->i_editor->copy_binbuf;
+        if (!instance->clipboardContents)
+            instance->clipboardContents = binbuf_new();
+        binbuf_clear(instance->clipboardContents);
+        binbuf_add(instance->clipboardContents, binbuf_getnatom(copyBuffer), binbuf_getvec(copyBuffer));
+        instance->clipboardText = copied;
+
         MessageManager::callAsync([copied]() mutable { SystemClipboard::copyTextToClipboard(copied); });
     }
 }
 
+// Moves the top-level objects so their top-left corner ends up at the position
+// This is a single pass over the UTF-8 text that remembers where the coordinates are, so we can write the translated text without tokenising it again
 String Patch::translatePatchAsString(String const& patchAsString, Point<int> position)
 {
-    int minX = std::numeric_limits<int>::max();
-    int minY = std::numeric_limits<int>::max();
+    struct Coordinate {
+        size_t start;
+        size_t length;
+        int value;
+    };
 
-    int canvasDepth = 0;
+    std::vector<Coordinate> coordinates;
 
-    auto isObject = [](StringArray& tokens) {
-        return tokens[0] == "#X" && tokens[1] != "connect" && tokens[1] != "f" && tokens[2].containsOnly("-0123456789") && tokens[3].containsOnly("-0123456789");
+    auto const text = std::string_view(patchAsString.toRawUTF8(), patchAsString.getNumBytesAsUTF8());
+    auto const isSeparator = [](char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ';' || c == ',';
     };
-
-    // blank message objects have a comma after their position: "#X msg 0 0, f 9;"
-    // this normally isn't an issue, but because they are blank, the comma is next to the number token and doesn't get parsed correctly
-    auto isMsg = [](StringArray& tokens) {
-        return tokens[0] == "#X" && tokens[1] == "msg";
+    auto const isNumber = [](std::string_view token) {
+        return !token.empty() && token.find_first_not_of("-0123456789") == std::string_view::npos;
     };
-
-    auto isStartingCanvas = [](StringArray& tokens) {
-        return tokens[0] == "#N" && tokens[1] == "canvas" && tokens[2].containsOnly("-0123456789") && tokens[3].containsOnly("-0123456789") && tokens[4].containsOnly("-0123456789") && tokens[5].containsOnly("-0123456789");
+    auto const toInt = [](std::string_view token) {
+        int value = 0;
+        std::from_chars(token.data(), token.data() + token.size(), value);
+        return value;
     };
 
-    auto isEndingCanvas = [](StringArray& tokens) {
-        return tokens[0] == "#X" && tokens[1] == "restore" && tokens[2].containsOnly("-0123456789") && tokens[3].containsOnly("-0123456789");
-    };
+    int minX = std::numeric_limits<int>::max();
+    int minY = std::numeric_limits<int>::max();
+    int canvasDepth = 0;
+
+    // We only need to look at the first 6 tokens of every statement
+    std::array<std::string_view, 6> tokens;
+    std::array<size_t, 6> offsets;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        tokens.fill({});
+
+        // Read the tokens up to the end of the statement
+        // Commas are separators too, blank message boxes have one right after their position: "#X msg 0 0, f 9;"
+        int numTokens = 0;
+        while (pos < text.size()) {
+            auto const c = text[pos];
+            if (c == ';') {
+                pos++;
+                break;
+            }
+            if (isSeparator(c)) {
+                pos++;
+                continue;
+            }
+
+            auto const start = pos;
+            while (pos < text.size() && !isSeparator(text[pos])) {
+                pos += text[pos] == '\\' ? 2 : 1; // Escaped characters are part of the token
+            }
+            pos = std::min(pos, text.size());
 
-    for (auto& line : StringArray::fromLines(patchAsString)) {
+            if (numTokens < static_cast<int>(tokens.size())) {
+                tokens[numTokens] = text.substr(start, pos - start);
+                offsets[numTokens] = start;
+            }
+            numTokens++;
+        }
 
-        line = line.upToLastOccurrenceOf(";", false, false);
+        auto const addCoordinates = [&]() {
+            auto const x = toInt(tokens[2]);
+            auto const y = toInt(tokens[3]);
+            coordinates.push_back({ offsets[2], tokens[2].size(), x });
+            coordinates.push_back({ offsets[3], tokens[3].size(), y });
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+        };
 
-        auto tokens = StringArray::fromTokens(line, true);
+        auto const hasPosition = isNumber(tokens[2]) && isNumber(tokens[3]);
 
-        if (isStartingCanvas(tokens)) {
+        if (tokens[0] == "#N" && tokens[1] == "canvas" && hasPosition && isNumber(tokens[4]) && isNumber(tokens[5])) {
             canvasDepth++;
         }
 
-        if (canvasDepth == 0) {
-            if (isObject(tokens)) {
-                minX = std::min(minX, tokens[2].getIntValue());
-                minY = std::min(minY, tokens[3].getIntValue());
-            } else if (isMsg(tokens)) {
-                minX = std::min(minX, tokens[2].getIntValue());
-                minY = std::min(minY, tokens[3].removeCharacters(",").getIntValue());
-            }
+        if (canvasDepth == 0 && tokens[0] == "#X" && tokens[1] != "connect" && tokens[1] != "f" && hasPosition) {
+            addCoordinates();
         }
 
-        if (isEndingCanvas(tokens)) {
-            if (canvasDepth == 1) {
-                minX = std::min(minX, tokens[2].getIntValue());
-                minY = std::min(minY, tokens[3].getIntValue());
-            }
+        // The position of a subpatch is in the line that closes it
+        if (tokens[0] == "#X" && tokens[1] == "restore" && hasPosition) {
+            if (canvasDepth == 1)
+                addCoordinates();
             canvasDepth--;
         }
     }
 
-    canvasDepth = 0;
-    auto toPaste = StringArray::fromLines(patchAsString);
-    for (auto& line : toPaste) {
-        line = line.upToLastOccurrenceOf(";", false, false);
-        auto tokens = StringArray::fromTokens(line, true);
-        if (isStartingCanvas(tokens)) {
+    if (coordinates.empty())
+        return patchAsString;
+
+    // Copy the text between the coordinates, and write the translated coordinates in their place
+    std::string result;
+    result.reserve(text.size() + coordinates.size() * 4);
+
+    size_t copied = 0;
+    for (size_t i = 0; i < coordinates.size(); i++) {
+        auto const& coordinate = coordinates[i];
+        auto const isX = (i % 2) == 0;
+
+        result.append(text.substr(copied, coordinate.start - copied));
+        result += std::to_string(coordinate.value - (isX ? minX : minY) + (isX ? position.x : position.y));
+        copied = coordinate.start + coordinate.length;
+    }
+    result.append(text.substr(copied));
+
+    return String::fromUTF8(result.data(), static_cast<int>(result.size()));
+}
+
+void Patch::translatePatchContents(t_binbuf* contents, Point<int> position)
+{
+    auto* atoms = binbuf_getvec(contents);
+    auto const numAtoms = binbuf_getnatom(contents);
+
+    auto* hashX = gensym("#X");
+    auto* hashN = gensym("#N");
+
+    std::vector<int> coordinates; // Index of the x coordinate, y comes right after it
+    t_float minX = std::numeric_limits<t_float>::max();
+    t_float minY = std::numeric_limits<t_float>::max();
+    int canvasDepth = 0;
+
+    int statementStart = 0;
+    for (int i = 0; i <= numAtoms; i++) {
+        if (i < numAtoms && atoms[i].a_type != A_SEMI)
+            continue;
+
+        auto* statement = atoms + statementStart;
+        auto const length = i - statementStart;
+        auto const startIndex = statementStart;
+        statementStart = i + 1;
+
+        auto const isSymbol = [statement, length](int index, t_symbol* sym) {
+            return index < length && statement[index].a_type == A_SYMBOL && statement[index].a_w.w_symbol == sym;
+        };
+        auto const isFloat = [statement, length](int index) {
+            return index < length && statement[index].a_type == A_FLOAT;
+        };
+
+        if (length < 4 || statement[0].a_type != A_SYMBOL || statement[1].a_type != A_SYMBOL)
+            continue;
+
+        auto* type = statement[1].a_w.w_symbol;
+        auto const hasPosition = isFloat(2) && isFloat(3);
+
+        auto const addCoordinates = [&]() {
+            coordinates.push_back(startIndex + 2);
+            minX = std::min(minX, statement[2].a_w.w_float);
+            minY = std::min(minY, statement[3].a_w.w_float);
+        };
+
+        if (isSymbol(0, hashN) && type == gensym("canvas") && hasPosition && isFloat(4) && isFloat(5)) {
             canvasDepth++;
         }
 
-        if (canvasDepth == 0) {
-            if (isObject(tokens)) {
-                tokens.set(2, String(tokens[2].getIntValue() - minX + position.x));
-                tokens.set(3, String(tokens[3].getIntValue() - minY + position.y));
-                line = tokens.joinIntoString(" ");
-            } else if (isMsg(tokens)) {
-                tokens.set(2, String(tokens[2].getIntValue() - minX + position.x));
-                tokens.set(3, String(tokens[3].removeCharacters(",").getIntValue() - minY + position.y) + ",");
-                line = tokens.joinIntoString(" ");
-            }
+        if (canvasDepth == 0 && isSymbol(0, hashX) && type != gensym("connect") && type != gensym("f") && hasPosition) {
+            addCoordinates();
         }
 
-        if (isEndingCanvas(tokens)) {
-            if (canvasDepth == 1) {
-                tokens.set(2, String(tokens[2].getIntValue() - minX + position.x));
-                tokens.set(3, String(tokens[3].getIntValue() - minY + position.y));
-            }
-
-            line = tokens.joinIntoString(" ");
-
+        // The position of a subpatch is in the line that closes it
+        if (isSymbol(0, hashX) && type == gensym("restore") && hasPosition) {
+            if (canvasDepth == 1)
+                addCoordinates();
             canvasDepth--;
         }
-
-        line += ";";
     }
 
-    return toPaste.joinIntoString("\n");
+    for (auto index : coordinates) {
+        atoms[index].a_w.w_float += position.x - minX;
+        atoms[index + 1].a_w.w_float += position.y - minY;
+    }
 }
 
 void Patch::paste(Point<int> position)
@@ -431,9 +628,25 @@ void Patch::paste(Point<int> position)
     auto text = SystemClipboard::getTextFromClipboard();
 
     // for some reason when we paste into PD, we need to apply a translation?
-    auto translatedObjects = translatePatchAsString(text, position.translated(1540, 1540));
+    auto const pastePosition = position.translated(1540, 1540);
 
     if (auto patch = ptr.get<t_glist>()) {
+        instance->patchEdited = true;
+        instance->busIndex.invalidate();
+
+        ScopedDspSuspend dspSuspend;
+
+        // Copied from this instance, and nothing else has been put on the clipboard since
+        if (instance->clipboardContents && text == instance->clipboardText) {
+            auto* copyBuffer = libpd_this_instance()->pd_gui->i_editor->copy_binbuf;
+            binbuf_clear(copyBuffer);
+            binbuf_add(copyBuffer, binbuf_getnatom(instance->clipboardContents), binbuf_getvec(instance->clipboardContents));
+            translatePatchContents(copyBuffer, pastePosition);
+            pd::Interface::pasteCopyBuffer(patch.get());
+            return;
+        }
+
+        auto translatedObjects = translatePatchAsString(text, pastePosition);
         pd::Interface::paste(patch.get(), translatedObjects.toRawUTF8());
     }
 }
@@ -441,6 +654,8 @@ void Patch::paste(Point<int> position)
 void Patch::duplicate(std::vector<t_gobj*> const& objects)
 {
     if (auto patch = ptr.get<t_glist>()) {
+        instance->patchEdited = true;
+        instance->busIndex.invalidate();
         setCurrent();
         pd::Interface::duplicateSelection(patch.get(), objects);
     }
@@ -476,6 +691,7 @@ bool Patch::canConnect(t_object* src, int nout, t_object* sink, int nin)
 void Patch::createConnection(t_object* src, int nout, t_object* sink, int nin)
 {
     if (auto patch = ptr.get<t_glist>()) {
+        instance->patchEdited = true;
         setCurrent();
         pd::Interface::createConnection(patch.get(), src, nout, sink, nin);
     }
@@ -484,6 +700,7 @@ void Patch::createConnection(t_object* src, int nout, t_object* sink, int nin)
 t_outconnect* Patch::createAndReturnConnection(t_object* src, int nout, t_object* sink, int nin)
 {
     if (auto patch = ptr.get<t_glist>()) {
+        instance->patchEdited = true;
         setCurrent();
         return pd::Interface::createConnection(patch.get(), src, nout, sink, nin);
     }
@@ -494,6 +711,7 @@ t_outconnect* Patch::createAndReturnConnection(t_object* src, int nout, t_object
 void Patch::removeConnection(t_object* src, int nout, t_object* sink, int nin, t_symbol* connectionPath)
 {
     if (auto patch = ptr.get<t_glist>()) {
+        instance->patchEdited = true;
         setCurrent();
         pd::Interface::removeConnection(patch.get(), src, nout, sink, nin, connectionPath);
     }
@@ -535,6 +753,10 @@ void Patch::finishRemove()
 void Patch::removeObjects(std::vector<t_gobj*> const& objects)
 {
     if (auto patch = ptr.get<t_glist>()) {
+        instance->patchEdited = true;
+        for (auto* object : objects) {
+            instance->busIndex.objectRemoved(object);
+        }
         setCurrent();
         pd::Interface::removeObjects(patch.get(), objects);
     }
@@ -559,11 +781,16 @@ void Patch::endUndoSequence(String const& name)
 void Patch::undo()
 {
     if (auto patch = ptr.get<t_glist>()) {
+        instance->patchEdited = true;
         setCurrent();
         auto x = patch.get();
         glist_noselect(x);
         libpd_this_instance()->pd_gui->i_editor->canvas_undo_already_set_move = 0;
 
+        instance->busIndex.invalidate();
+
+        // Undoing a large action can create or remove many objects, we only want to rebuild the DSP chain once
+        ScopedDspSuspend dspSuspend;
         pd::Interface::undo(patch.get());
 
         updateUndoRedoString();
@@ -573,11 +800,15 @@ void Patch::undo()
 void Patch::redo()
 {
     if (auto patch = ptr.get<t_glist>()) {
+        instance->patchEdited = true;
         setCurrent();
         auto x = patch.get();
         glist_noselect(x);
         libpd_this_instance()->pd_gui->i_editor->canvas_undo_already_set_move = 0;
 
+        instance->busIndex.invalidate();
+
+        ScopedDspSuspend dspSuspend;
         pd::Interface::redo(patch.get());
 
         updateUndoRedoString();
@@ -25,6 +25,33 @@ class Patch : public ReferenceCountedObject {
 public:
     using Ptr = ReferenceCountedObjectPtr<Patch>;
 
+    // While one of these exists, Pd doesn't rebuild its DSP chain after every object, connection or undo step
+    // The chain is rebuilt once when the outermost one ends. Only use this while holding the audio lock of the current instance
+    class ScopedDspSuspend {
+    public:
+        ScopedDspSuspend();
+        ~ScopedDspSuspend();
+
+    private:
+        int dspState;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedDspSuspend)
+    };
+
+    // Groups a sequence of edits: the audio lock is taken once for all of them, and Pd only rebuilds its DSP chain when the batch ends
+    // Use this for operations on large selections, the patch functions can be used as usual in the meantime
+    class ScopedBatchEdit {
+    public:
+        explicit ScopedBatchEdit(Instance* instance);
+        ~ScopedBatchEdit();
+
+    private:
+        Instance* instance;
+        std::optional<ScopedDspSuspend> dspSuspend;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBatchEdit)
+    };
+
     Patch(pd::WeakReference ptr, Instance* instance, bool ownsPatch, File currentFile = File());
 
     ~Patch();
@@ -57,6 +84,9 @@ public:
 
     static String translatePatchAsString(String const& clipboardContent, Point<int> position);
 
+    // Same as translatePatchAsString, but for atoms that are already parsed
+    static void translatePatchContents(t_binbuf* contents, Point<int> position);
+
     t_glist* getRoot();
 
     void copy(std::vector<t_gobj*> const& objects);
@@ -89,6 +119,7 @@ public:
     void setCurrentFile(File newFile);
 
     void updateUndoRedoState();
+    void updateDirtyState();
 
     bool objectWasDeleted(t_gobj* ptr) const;
     bool connectionWasDeleted(t_outconnect* ptr) const;
@@ -107,6 +138,12 @@ public:
         return ptr.get<t_canvas>();
     }
 
+    // Only for use as an identifier, this pointer might already be deleted
+    t_canvas* getUncheckedPointer() const
+    {
+        return ptr.getRawUnchecked<t_canvas>();
+    }
+
     // Gets the objects of the patch.
     std::vector<pd::WeakReference> getObjects();
 
@@ -130,6 +167,11 @@ public:
     void updateUndoRedoString();
 
 private:
+    // Writes the patch file on a background thread if the patch is large, returns false if it should be saved right away
+    bool saveInBackground(t_glist* patch, File const& location, t_symbol* file, t_symbol* dir);
+
+    static constexpr int minBackgroundSaveAtoms = 100000;
+
     std::atomic<bool> canPatchUndo;
     std::atomic<bool> canPatchRedo;
     std::atomic<bool> isPatchDirty;
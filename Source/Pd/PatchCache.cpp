@@ -0,0 +1,244 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Utility/Config.h"
+
+extern "C" {
+#include <m_pd.h>
+#include <g_canvas.h>
+#include <m_imp.h>
+}
+
+#include "PatchCache.h"
+#include "Interface.h"
+
+namespace pd {
+
+enum class CachedAtomType : uint8 {
+    Float,
+    Symbol,
+    Semicolon,
+    Comma,
+    Dollar,
+    DollarSymbol
+};
+
+t_canvas* PatchCache::openCanvas(File const& file)
+{
+    auto const dirname = file.getParentDirectory().getFullPathName().replace("\\", "/");
+    auto const filename = file.getFileName();
+
+    // .pat and .mxt files are converted while reading, leave those to pd
+    if (!file.hasFileExtension("pd") || file.getSize() < minCachedFileSize)
+        return Interface::createCanvas(filename.toRawUTF8(), dirname.toRawUTF8());
+
+    auto const cacheFile = getCacheFile(file);
+
+    auto* binbuf = readCache(cacheFile, file);
+    if (binbuf) {
+        // Hits update the modification time of the entry, so trimCache knows which entries are least recently used
+        writeThread.addJob([cacheFile]() {
+            cacheFile.setLastModificationTime(Time::getCurrentTime());
+        });
+    } else {
+        MemoryBlock content;
+        if (!file.loadFileAsData(content))
+            return Interface::createCanvas(filename.toRawUTF8(), dirname.toRawUTF8());
+
+        binbuf = binbuf_new();
+        binbuf_text(binbuf, static_cast<char const*>(content.getData()), static_cast<size_t>(content.getSize()));
+        writeCache(cacheFile, file, binbuf);
+    }
+
+    auto* cnv = Interface::createCanvasFromBinbuf(binbuf, filename.toRawUTF8(), dirname.toRawUTF8());
+    binbuf_free(binbuf);
+    return cnv;
+}
+
+File PatchCache::getCacheFile(File const& patchFile) const
+{
+    return cacheDir.getChildFile(String::toHexString(patchFile.getFullPathName().hashCode64()) + ".bin");
+}
+
+t_binbuf* PatchCache::readCache(File const& cacheFile, File const& patchFile) const
+{
+    FileInputStream stream(cacheFile);
+    if (!stream.openedOk())
+        return nullptr;
+
+    if (static_cast<uint32>(stream.readInt()) != cacheMagic || static_cast<uint32>(stream.readInt()) != cacheVersion)
+        return nullptr;
+
+    // Different path with the same hash, or an outdated entry
+    if (stream.readString() != patchFile.getFullPathName() || stream.readInt64() != patchFile.getLastModificationTime().toMilliseconds() || stream.readInt64() != patchFile.getSize())
+        return nullptr;
+
+    auto const numSymbols = stream.readInt();
+    if (numSymbols < 0)
+        return nullptr;
+
+    std::vector<t_symbol*> symbols(static_cast<size_t>(numSymbols));
+    for (auto& symbol : symbols) {
+        if (stream.isExhausted())
+            return nullptr;
+
+        symbol = gensym(stream.readString().toRawUTF8());
+    }
+
+    auto const readSymbol = [&stream, &symbols]() -> t_symbol* {
+        auto const index = stream.readInt();
+        return isPositiveAndBelow(index, static_cast<int>(symbols.size())) ? symbols[index] : nullptr;
+    };
+
+    auto const numAtoms = stream.readInt();
+    if (numAtoms < 0)
+        return nullptr;
+
+    std::vector<t_atom> atoms(static_cast<size_t>(numAtoms));
+    for (auto& atom : atoms) {
+        if (stream.isExhausted())
+            return nullptr;
+
+        switch (static_cast<CachedAtomType>(stream.readByte())) {
+        case CachedAtomType::Float:
+            SETFLOAT(&atom, stream.readFloat());
+            break;
+        case CachedAtomType::Symbol: {
+            auto* symbol = readSymbol();
+            if (!symbol)
+                return nullptr;
+            SETSYMBOL(&atom, symbol);
+            break;
+        }
+        case CachedAtomType::Semicolon:
+            SETSEMI(&atom);
+            break;
+        case CachedAtomType::Comma:
+            SETCOMMA(&atom);
+            break;
+        case CachedAtomType::Dollar:
+            SETDOLLAR(&atom, stream.readInt());
+            break;
+        case CachedAtomType::DollarSymbol: {
+            auto* symbol = readSymbol();
+            if (!symbol)
+                return nullptr;
+            SETDOLLSYM(&atom, symbol);
+            break;
+        }
+        default:
+            return nullptr;
+        }
+    }
+
+    auto* binbuf = binbuf_new();
+    binbuf_add(binbuf, numAtoms, atoms.data());
+    return binbuf;
+}
+
+void PatchCache::writeCache(File const& cacheFile, File const& patchFile, t_binbuf* binbuf)
+{
+    auto const numAtoms = binbuf_getnatom(binbuf);
+    auto const* atoms = binbuf_getvec(binbuf);
+
+    // Every distinct symbol gets an index, the atoms refer to that
+    std::unordered_map<t_symbol*, int> symbolIndices;
+    std::vector<t_symbol*> symbols;
+    for (int i = 0; i < numAtoms; i++) {
+        auto const& atom = atoms[i];
+        switch (atom.a_type) {
+        case A_SYMBOL:
+        case A_DOLLSYM:
+            if (symbolIndices.try_emplace(atom.a_w.w_symbol, static_cast<int>(symbols.size())).second)
+                symbols.push_back(atom.a_w.w_symbol);
+            break;
+        case A_FLOAT:
+        case A_SEMI:
+        case A_COMMA:
+        case A_DOLLAR:
+            break;
+        default:
+            // Text parsing shouldn't produce any other atom types, don't cache something we can't restore
+            return;
+        }
+    }
+
+    // Serialise while we hold the lock, the file itself is written in the background
+    auto data = std::make_shared<MemoryOutputStream>();
+    data->writeInt(static_cast<int>(cacheMagic));
+    data->writeInt(static_cast<int>(cacheVersion));
+    data->writeString(patchFile.getFullPathName());
+    data->writeInt64(patchFile.getLastModificationTime().toMilliseconds());
+    data->writeInt64(patchFile.getSize());
+
+    data->writeInt(static_cast<int>(symbols.size()));
+    for (auto* symbol : symbols) {
+        data->writeString(String::fromUTF8(symbol->s_name));
+    }
+
+    data->writeInt(numAtoms);
+    for (int i = 0; i < numAtoms; i++) {
+        auto const& atom = atoms[i];
+        switch (atom.a_type) {
+        case A_FLOAT:
+            data->writeByte(static_cast<char>(CachedAtomType::Float));
+            data->writeFloat(atom.a_w.w_float);
+            break;
+        case A_SYMBOL:
+            data->writeByte(static_cast<char>(CachedAtomType::Symbol));
+            data->writeInt(symbolIndices[atom.a_w.w_symbol]);
+            break;
+        case A_SEMI:
+            data->writeByte(static_cast<char>(CachedAtomType::Semicolon));
+            break;
+        case A_COMMA:
+            data->writeByte(static_cast<char>(CachedAtomType::Comma));
+            break;
+        case A_DOLLAR:
+            data->writeByte(static_cast<char>(CachedAtomType::Dollar));
+            data->writeInt(atom.a_w.w_index);
+            break;
+        case A_DOLLSYM:
+            data->writeByte(static_cast<char>(CachedAtomType::DollarSymbol));
+            data->writeInt(symbolIndices[atom.a_w.w_symbol]);
+            break;
+        default:
+            break;
+        }
+    }
+
+    writeThread.addJob([cacheFile, data]() {
+        cacheFile.getParentDirectory().createDirectory();
+        cacheFile.replaceWithData(data->getData(), data->getDataSize());
+        trimCache();
+    });
+}
+
+void PatchCache::trimCache()
+{
+    auto entries = cacheDir.findChildFiles(File::findFiles, false, "*.bin");
+
+    int64 totalSize = 0;
+    for (auto const& entry : entries) {
+        totalSize += entry.getSize();
+    }
+
+    if (totalSize <= maxCacheSize)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](File const& a, File const& b) { return a.getLastModificationTime() < b.getLastModificationTime(); });
+
+    for (auto const& entry : entries) {
+        if (totalSize <= maxCacheSize)
+            break;
+
+        totalSize -= entry.getSize();
+        entry.deleteFile();
+    }
+}
+
+}
@@ -0,0 +1,42 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+#pragma once
+
+namespace pd {
+
+// Keeps the tokenised contents of large patch files in appDataDir/Cache/Patches, so re-opening them doesn't need to parse the text again
+// An entry is only used if the path, modification time and size of the file still match, so a hit doesn't need to read the patch file at all
+// Every symbol is stored once, so reading an entry only calls gensym once per distinct symbol
+// The least recently used entries are removed once the cache gets bigger than maxCacheSize
+// Only use while holding the audio lock
+class PatchCache {
+public:
+    // Opens a toplevel canvas for a patch file, from the cache if possible
+    t_canvas* openCanvas(File const& file);
+
+private:
+    t_binbuf* readCache(File const& cacheFile, File const& patchFile) const;
+    void writeCache(File const& cacheFile, File const& patchFile, t_binbuf* binbuf);
+
+    File getCacheFile(File const& patchFile) const;
+
+    // Removes the least recently used entries until the cache fits in maxCacheSize, called on the write thread
+    static void trimCache();
+
+    // Small patches parse faster than we can check the cache
+    static constexpr int64 minCachedFileSize = 256 * 1024;
+    static constexpr int64 maxCacheSize = 64 * 1024 * 1024;
+
+    static constexpr uint32 cacheMagic = 0x50444243; // "PDBC"
+    static constexpr uint32 cacheVersion = 2;
+
+    static inline File const cacheDir = ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("Patches");
+
+    // Declared last, so pending writes finish before the cache is deleted
+    ThreadPool writeThread = ThreadPool(1);
+};
+
+}
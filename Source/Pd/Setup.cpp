@@ -156,6 +156,74 @@ static void plugdata_print(void* object, char const* message)
     }
 }
 
+// [param~]: outputs a DAW parameter as a signal
+// The processor sends a new value before every Pd block, we ramp towards it over the block, so there is no need for [line~]
+static t_class* param_tilde_class;
+
+typedef struct _param_tilde {
+    t_object x_obj;
+    t_symbol* x_sym;
+    t_float x_target;
+    t_sample x_value;
+} t_param_tilde;
+
+static void param_tilde_float(t_param_tilde* x, t_float f)
+{
+    x->x_target = f;
+}
+
+static t_int* param_tilde_perform(t_int* w)
+{
+    t_param_tilde* x = (t_param_tilde*)(w[1]);
+    t_sample* out = (t_sample*)(w[2]);
+    int n = (int)(w[3]);
+
+    t_sample const target = x->x_target;
+    if (x->x_value == target) {
+        while (n--)
+            *out++ = target;
+    } else {
+        t_sample value = x->x_value;
+        t_sample const increment = (target - value) / n;
+        while (--n)
+            *out++ = (value += increment);
+        *out = target;
+        x->x_value = target;
+    }
+
+    return w + 4;
+}
+
+static void param_tilde_dsp(t_param_tilde* x, t_signal** sp)
+{
+    dsp_add(param_tilde_perform, 3, x, sp[0]->s_vec, (t_int)sp[0]->s_n);
+}
+
+// Takes the parameter name, or its number for parameters that still have their default name
+static void* param_tilde_new(t_symbol* s, int argc, t_atom* argv)
+{
+    t_param_tilde* x = (t_param_tilde*)pd_new(param_tilde_class);
+
+    std::string name = "param1";
+    if (argc > 0 && argv[0].a_type == A_SYMBOL) {
+        name = atom_getsymbol(argv)->s_name;
+    } else if (argc > 0 && argv[0].a_type == A_FLOAT) {
+        name = "param" + std::to_string((int)atom_getfloat(argv));
+    }
+
+    x->x_sym = gensym((name + "~").c_str());
+    x->x_target = 0;
+    x->x_value = 0;
+    pd_bind(&x->x_obj.ob_pd, x->x_sym);
+    outlet_new(&x->x_obj, &s_signal);
+    return x;
+}
+
+static void param_tilde_free(t_param_tilde* x)
+{
+    pd_unbind(&x->x_obj.ob_pd, x->x_sym);
+}
+
 extern "C" {
 
 void pd_init();
@@ -718,6 +786,11 @@ int Setup::initialisePd()
         plugdata_print_class = class_new(gensym("plugdata_print"), (t_newmethod)NULL, (t_method)NULL,
             sizeof(t_plugdata_print), CLASS_DEFAULT, A_NULL, 0);
 
+        param_tilde_class = class_new(gensym("param~"), (t_newmethod)param_tilde_new, (t_method)param_tilde_free,
+            sizeof(t_param_tilde), CLASS_NOINLET, A_GIMME, 0);
+        class_addfloat(param_tilde_class, param_tilde_float);
+        class_addmethod(param_tilde_class, (t_method)param_tilde_dsp, gensym("dsp"), A_CANT, 0);
+
         int i;
         t_atom zz[ndefaultfont + 2];
         SETSYMBOL(zz, gensym("."));
@@ -18,7 +18,8 @@ pd::WeakReference::WeakReference(void* p, Instance* instance)
     : ptr(p)
     , pd(instance)
 {
-    pd->registerWeakReference(ptr, &weakRef);
+    if (ptr)
+        weakRef = pd->acquireWeakReference(ptr);
 }
 
 pd::WeakReference::WeakReference(Instance* instance)
@@ -27,22 +28,20 @@ pd::WeakReference::WeakReference(Instance* instance)
 {
 }
 
+// Copies share the slot of the original, so this doesn't need the instance's lock
 pd::WeakReference::WeakReference(WeakReference const& toCopy)
     : ptr(toCopy.ptr)
     , pd(toCopy.pd)
+    , weakRef(toCopy.weakRef)
 {
-    pd->weakReferenceMutex.lock();
-
-    weakRef = toCopy.weakRef.load();
-    pd->registerWeakReference(ptr, &weakRef);
-
-    pd->weakReferenceMutex.unlock();
+    if (weakRef)
+        weakRef->retain();
 }
 
 pd::WeakReference::~WeakReference()
 {
-    if (pd)
-        pd->unregisterWeakReference(ptr, &weakRef);
+    if (weakRef)
+        weakRef->release();
 }
 
 pd::WeakReference& pd::WeakReference::operator=(pd::WeakReference const& other)
@@ -50,22 +49,25 @@ pd::WeakReference& pd::WeakReference::operator=(pd::WeakReference const& other)
     bool valid = other.ptr && other.pd;
     if (valid && this != &other) // Check for self-assignment
     {
-        pd = other.pd;
-
-        pd->weakReferenceMutex.lock();
-        pd->unregisterWeakReference(ptr, &other.weakRef);
+        // Retain first, in case both already share the same slot
+        if (other.weakRef)
+            other.weakRef->retain();
+        if (weakRef)
+            weakRef->release();
 
-        // Use atomic exchange to safely copy the weakRef value
-        weakRef.store(other.weakRef.load());
+        pd = other.pd;
         ptr = other.ptr;
-
-        pd->registerWeakReference(ptr, &weakRef);
-        pd->weakReferenceMutex.unlock();
+        weakRef = other.weakRef;
     }
 
     return *this;
 }
 
+bool pd::WeakReference::tryLock() const
+{
+    return pd && pd->tryLockAudioThread();
+}
+
 void pd::WeakReference::setThis() const
 {
     if (pd)
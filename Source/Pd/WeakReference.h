@@ -11,7 +11,31 @@
 
 #include <m_pd.h>
 
-using pd_weak_reference = std::atomic<bool>;
+// One slot per referenced Pd object, shared by all weak references to it
+// The instance holds one reference to the slot while the object is alive, so copying a weak reference only has to increment the count
+struct pd_weak_reference {
+    std::atomic<bool> alive = true;
+    std::atomic<int> refCount = 1;
+
+    // Increased for every value Instance::sendFloatAsync queues for this object, so it can skip values that were replaced before they were sent
+    std::atomic<uint32_t> latestValueSerial = 0;
+
+    bool isAlive() const
+    {
+        return alive.load(std::memory_order_acquire);
+    }
+
+    void retain()
+    {
+        refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        if (refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+};
 
 namespace pd {
 
@@ -42,32 +66,42 @@ struct WeakReference {
     template<typename T>
     struct Ptr {
 
-        Ptr(T* pointer, pd_weak_reference const& ref)
+        Ptr(T* pointer, pd_weak_reference const* ref)
             : weakRef(ref)
             , ptr(pointer)
+            , locked(true)
         {
             sys_lock();
         }
 
+        // For when we already tried to lock: if that failed, this Ptr will act like a null pointer
+        Ptr(T* pointer, pd_weak_reference const* ref, bool hasLock)
+            : weakRef(ref)
+            , ptr(hasLock ? pointer : nullptr)
+            , locked(hasLock)
+        {
+        }
+
         ~Ptr()
         {
-            sys_unlock();
+            if (locked)
+                sys_unlock();
         }
 
         operator bool() const
         {
-            return weakRef && (ptr != nullptr);
+            return isAlive() && (ptr != nullptr);
         }
 
         T* get()
         {
-            return weakRef ? ptr : nullptr;
+            return isAlive() ? ptr : nullptr;
         }
 
         template<typename C>
         C* cast()
         {
-            return weakRef ? reinterpret_cast<C*>(ptr) : nullptr;
+            return isAlive() ? reinterpret_cast<C*>(ptr) : nullptr;
         }
 
         T* operator->()
@@ -75,8 +109,14 @@ struct WeakReference {
             return ptr;
         }
 
-        pd_weak_reference const& weakRef;
+        bool isAlive() const
+        {
+            return weakRef && weakRef->isAlive();
+        }
+
+        pd_weak_reference const* weakRef;
         T* ptr;
+        bool const locked;
 
         JUCE_DECLARE_NON_COPYABLE(Ptr)
     };
@@ -88,11 +128,20 @@ struct WeakReference {
         return Ptr<T>(reinterpret_cast<T*>(ptr), weakRef);
     }
 
+    // Same as get(), but doesn't wait if the audio thread is holding the lock
+    // In that case, the result evaluates to false. This is meant for GUI polling, which can keep showing the last state instead
+    template<typename T>
+    Ptr<T> tryGet() const
+    {
+        setThis();
+        return Ptr<T>(reinterpret_cast<T*>(ptr), weakRef, tryLock());
+    }
+
     template<typename T>
     T* getRaw() const
     {
         setThis();
-        return weakRef ? reinterpret_cast<T*>(ptr) : nullptr;
+        return weakRef && weakRef->isAlive() ? reinterpret_cast<T*>(ptr) : nullptr;
     }
 
     template<typename T>
@@ -103,13 +152,26 @@ struct WeakReference {
 
     bool isValid()
     {
-        return weakRef && ptr != nullptr;
+        return weakRef && weakRef->isAlive() && ptr != nullptr;
+    }
+
+    // See Instance::sendFloatAsync
+    uint32_t nextValueSerial() const
+    {
+        return weakRef ? ++weakRef->latestValueSerial : 0;
+    }
+
+    bool isLatestValueSerial(uint32_t serial) const
+    {
+        return weakRef && weakRef->latestValueSerial.load() == serial;
     }
 
 private:
+    bool tryLock() const;
+
     void* ptr;
     Instance* pd;
-    pd_weak_reference weakRef = true;
+    pd_weak_reference* weakRef = nullptr;
 };
 
 }
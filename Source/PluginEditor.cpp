@@ -30,6 +30,7 @@
 #include "Object.h"
 #include "PluginMode.h"
 #include "Components/TouchSelectionHelper.h"
+#include "Heavy/HeavyCompiler.h"
 
 class ZoomLabel : public TextButton
     , public Timer {
@@ -138,6 +139,10 @@ PluginEditor::PluginEditor(PluginProcessor& p)
     theme.referTo(settingsFile->getPropertyAsValue("theme"));
     theme.addListener(this);
 
+    hardwareRendering.referTo(settingsFile->getPropertyAsValue("hardware_rendering"));
+    hardwareRendering.addListener(this);
+    setHardwareRendering(getValue<bool>(hardwareRendering));
+
     if (!settingsFile->hasProperty("hvcc_mode"))
         settingsFile->setProperty("hvcc_mode", false);
     hvccMode.referTo(settingsFile->getPropertyAsValue("hvcc_mode"));
@@ -282,8 +287,12 @@ PluginEditor::PluginEditor(PluginProcessor& p)
 
 PluginEditor::~PluginEditor()
 {
+    // Detach first, so the render thread stops before any of our child components are deleted
+    setHardwareRendering(false);
+
     pd->savePatchTabPositions();
     theme.removeListener(this);
+    hardwareRendering.removeListener(this);
 
     if (auto* window = dynamic_cast<PlugDataWindow*>(getTopLevelComponent())) {
         ProjectInfo::closeWindow(window); // Make sure plugdatawindow gets cleaned up
@@ -893,6 +902,38 @@ void PluginEditor::valueChanged(Value& v)
         pd->setTheme(theme.toString());
         getTopLevelComponent()->repaint();
     }
+    if (v.refersToSameSourceAs(hardwareRendering)) {
+        setHardwareRendering(getValue<bool>(hardwareRendering));
+    }
+}
+
+void PluginEditor::setHardwareRendering(bool enabled)
+{
+    if (!enabled) {
+        if (openGLContext) {
+            openGLContext->detach();
+            openGLContext.reset();
+            repaint();
+        }
+        return;
+    }
+
+    if (openGLContext)
+        return;
+
+    openGLContext = std::make_unique<OpenGLContext>();
+    openGLContext->setComponentPaintingEnabled(true);
+    openGLContext->setContinuousRepainting(false);
+    openGLContext->attachTo(*this);
+
+    // The native context is created asynchronously. If that didn't work, fall back to software rendering
+    ::Timer::callAfterDelay(1000, [_this = SafePointer(this)]() {
+        if (!_this || !_this->openGLContext || !_this->isShowing() || _this->openGLContext->getRawContext())
+            return;
+
+        _this->pd->logWarning("Failed to create an OpenGL context, falling back to software rendering");
+        _this->hardwareRendering = false;
+    });
 }
 
 void PluginEditor::modifierKeysChanged(ModifierKeys const& modifiers)
@@ -968,7 +1009,13 @@ void PluginEditor::handleAsyncUpdate()
 void PluginEditor::updateCommandStatus()
 {
     // Make sure patches update their undo/redo state information soon
-    pd->updatePatchUndoRedoState();
+    // We only show it for the canvases that are visible, other patches update once their tab is opened
+    Array<pd::Patch::Ptr> visiblePatches;
+    for (auto* split : splitView.splits) {
+        if (auto* cnv = split->getTabComponent()->getCurrentCanvas())
+            visiblePatches.addIfNotAlreadyThere(cnv->refCountedPatch);
+    }
+    pd->updatePatchUndoRedoState(visiblePatches);
     AsyncUpdater::triggerAsyncUpdate();
 }
 
@@ -1515,14 +1562,12 @@ bool PluginEditor::perform(InvocationInfo const& info)
     }
     case CommandIDs::ConnectionPathfind: {
         cnv = getCurrentCanvas();
-        cnv->patch.startUndoSequence("ConnectionPathFind");
 
+        // Paths are found asynchronously, the ConnectionPathUpdater waits for all of them and applies them in one undo sequence
         for (auto* con : cnv->getSelectionOfType<Connection>()) {
             con->applyBestPath();
         }
 
-        cnv->patch.endUndoSequence("ConnectionPathFind");
-
         return true;
     }
     case CommandIDs::ZoomIn: {
@@ -1790,69 +1835,44 @@ bool PluginEditor::highlightSearchTarget(void* target, bool openNewTabIfNeeded)
     if (!targetCanvas)
         return false;
 
+    auto const highlightObject = [target](Canvas* cnv) {
+        auto* found = cnv->getObjectForPointer(static_cast<t_gobj*>(target));
 
-    for (auto* cnv : canvases) {
-        if (cnv->patch.getPointer().get() == targetCanvas) {
-            Object* found = nullptr;
-            for (auto* object : cnv->objects) {
-                if (object->getPointer() == target) {
-                    found = object;
-                    break;
-                }
-            }
-            
-            if (found) {
-                
-                cnv->deselectAll();
-                cnv->setSelected(found, true);
-                
-                auto* viewport = cnv->viewport.get();
-                auto scale = getValue<float>(cnv->zoomScale);
-                auto pos = found->getBounds().getCentre() * scale;
-
-                pos.x -= viewport->getViewWidth() * 0.5f;
-                pos.y -= viewport->getViewHeight() * 0.5f;
-
-                viewport->setViewPosition(pos);
-                cnv->getTabbar()->setCurrentTabIndex(cnv->getTabIndex());
-
-                
-                return true;
-            }
+        // While a large patch loads, the object might not have been created yet. The canvas highlights it once it's done
+        if (!found) {
+            if (cnv->isLoading)
+                cnv->pendingSearchTarget = target;
+            return cnv->isLoading;
         }
+
+        cnv->deselectAll();
+        cnv->setSelected(found, true);
+
+        auto* viewport = cnv->viewport.get();
+        auto scale = getValue<float>(cnv->zoomScale);
+        auto pos = found->getBounds().getCentre() * scale;
+
+        pos.x -= viewport->getViewWidth() * 0.5f;
+        pos.y -= viewport->getViewHeight() * 0.5f;
+
+        viewport->setViewPosition(pos);
+        cnv->getTabbar()->setCurrentTabIndex(cnv->getTabIndex());
+        return true;
+    };
+
+    for (auto* cnv : canvases) {
+        if (cnv->patch.getPointer().get() == targetCanvas && highlightObject(cnv))
+            return true;
     }
-    
-    if(openNewTabIfNeeded) {
+
+    if (openNewTabIfNeeded) {
         auto* patch = new pd::Patch(pd::WeakReference(targetCanvas, pd), pd, false);
         auto* cnv = canvases.add(new Canvas(this, patch));
         addTab(cnv);
-        
-        Object* found = nullptr;
-        for (auto* object : cnv->objects) {
-            if (object->getPointer() == target) {
-                found = object;
-                break;
-            }
-        }
-        
-        if (found) {
-            
-            cnv->deselectAll();
-            cnv->setSelected(found, true);
-            
-            auto* viewport = cnv->viewport.get();
-            auto scale = getValue<float>(cnv->zoomScale);
-            auto pos = found->getBounds().getCentre() * scale;
-            
-            pos.x -= viewport->getViewWidth() * 0.5f;
-            pos.y -= viewport->getViewHeight() * 0.5f;
-            
-            viewport->setViewPosition(pos);
-            cnv->getTabbar()->setCurrentTabIndex(cnv->getTabIndex());
-        }
-        
+
+        highlightObject(cnv);
         return true;
     }
-    
+
     return false;
 }
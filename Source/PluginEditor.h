@@ -7,6 +7,7 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_opengl/juce_opengl.h>
 
 #include "Utility/Fonts.h"
 #include "Utility/RateReducer.h" // TODO: move to impl
@@ -35,6 +36,7 @@ class Palettes;
 class Autosave;
 class PluginMode;
 class TouchSelectionHelper;
+class HeavyCompiler;
 class PluginEditor : public AudioProcessorEditor
     , public Value::Listener
     , public ApplicationCommandTarget
@@ -131,6 +133,7 @@ public:
     std::unique_ptr<PluginMode> pluginMode;
 
     Value theme;
+    Value hardwareRendering;
 
     Value hvccMode;
     Value autoconnect;
@@ -151,15 +154,23 @@ public:
     ComponentBoundsConstrainer& pluginConstrainer;
 
     std::unique_ptr<Autosave> autosave;
+
+    // Created the first time a subpatch is compiled
+    std::unique_ptr<HeavyCompiler> heavyCompiler;
+
     ApplicationCommandManager commandManager;
     
     inline static ObjectThemeManager objectManager;
     static ObjectThemeManager* getObjectManager() { return &objectManager; };
 
 private:
-    
+    void setHardwareRendering(bool enabled);
+
     std::unique_ptr<TouchSelectionHelper> touchSelectionHelper;
 
+    // When hardware rendering is enabled, the whole editor is drawn by JUCE's OpenGL renderer instead of the software renderer
+    std::unique_ptr<OpenGLContext> openGLContext;
+
     // Used by standalone to handle dragging the window
     WindowDragger windowDragger;
 
@@ -110,6 +110,8 @@ public:
         cnv->presentationMode = true;
         cnv->presentationMode.getValueSource().sendChangeMessage(true);
 
+        cnv->setPluginModeView(true);
+
         cnv->viewport->setViewedComponent(nullptr);
 
         addAndMakeVisible(content);
@@ -183,6 +185,7 @@ public:
             cnv->setTopLeftPosition(originalCanvasPos);
             cnv->locked = originalLockedMode;
             cnv->presentationMode = originalPresentationMode;
+            cnv->setPluginModeView(false);
         }
 
         editor->parentSizeChanged();
@@ -5,6 +5,8 @@
  */
 #include <clocale>
 #include <memory>
+#include <bit>
+#include <mutex>
 
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_basics/juce_audio_basics.h>
@@ -12,15 +14,18 @@
 
 #include "PluginProcessor.h"
 #include "Pd/Library.h"
+#include "Pd/LibraryLoader.h"
 
 #include "Utility/Config.h"
 #include "Utility/Fonts.h"
 #include "Utility/SettingsFile.h"
 #include "Utility/PluginParameter.h"
 #include "Utility/OSUtils.h"
-#include "Utility/AudioSampleRingBuffer.h"
+#include "Utility/AudioPeakMeter.h"
 #include "Utility/MidiDeviceManager.h"
-#include "Dialogs/ConnectionMessageDisplay.h"
+#include "Utility/RealtimeSafety.h"
+#include "Utility/Tracing.h"
+#include "Utility/StartupTimer.h"
 
 #include "Utility/Presets.h"
 #include "Canvas.h"
@@ -29,6 +34,7 @@
 #include "LookAndFeel.h"
 #include "Tabbar/Tabbar.h"
 #include "Object.h"
+#include "Objects/ObjectBase.h"
 #include "Statusbar.h"
 
 #include "Dialogs/Dialogs.h"
@@ -37,6 +43,9 @@
 extern "C" {
 #include "../Libraries/cyclone/shared/common/file.h"
 EXTERN char* pd_version;
+
+t_glist* clone_get_instance(t_gobj*, int);
+int clone_get_n(t_gobj*);
 }
 
 AudioProcessor::BusesProperties PluginProcessor::buildBusesProperties()
@@ -80,34 +89,62 @@ PluginProcessor::PluginProcessor()
     , pd::Instance("plugdata")
     , internalSynth(std::make_unique<InternalSynth>())
 {
+    StartupTimer startupTimer;
+
     // Make sure to use dots for decimal numbers, pd requires that
     std::setlocale(LC_ALL, "C");
 
+    tailLength.addListener(this);
+
     {
         MessageManagerLock const mmLock; // Do we need this? Isn't this already on the messageManager?
 
         LookAndFeel::setDefaultLookAndFeel(&lnf.get());
+    }
+
+    // Initialise directory structure, this doesn't need the message manager
+    initialiseFilesystem();
+    startupTimer.phaseFinished("filesystem");
+
+    {
+        MessageManagerLock const mmLock;
 
-        // Initialise directory structure and settings file
-        initialiseFilesystem();
         settingsFile = SettingsFile::getInstance()->initialise();
+        startupTimer.phaseFinished("settings");
     }
 
     statusbarSource = std::make_unique<StatusbarSource>();
 
+    deadlineMonitor.onOverrun = [this](String const& message) {
+        logWarning(message);
+    };
+
     auto* volumeParameter = new PlugDataParameter(this, "volume", 0.8f, true, 0, 0.0f, 1.0f);
     addParameter(volumeParameter);
+    parameterRenamed(volumeParameter, String(), volumeParameter->getTitle());
     volume = volumeParameter->getValuePointer();
 
     // XML tree for storing additional data in DAW session
     extraData = std::make_unique<XmlElement>("ExtraData");
 
     // General purpose automation parameters you can get by using "receive param1" etc.
+    // All of them are always registered, since hosts expect the same parameter list for the same plugin. Only as many as the settings ask for
+    // are offered for automation, the rest stay hidden until a session or the automation panel enables them
+    // That only declutters the host's automation lists, hosts still scan and poll all of them
+    numExposedParameters = jlimit(1, numParameters, settingsFile->getProperty<int>("exposed_parameters"));
     for (int n = 0; n < numParameters; n++) {
         auto* parameter = new PlugDataParameter(this, "param" + String(n + 1), 0.0f, false, n + 1, 0.0f, 1.0f);
+        parameter->setExposed(n < numExposedParameters);
         addParameter(parameter);
+        parameterRenamed(parameter, String(), parameter->getTitle());
     }
 
+    // Make sure all parameters get sent to pd once
+    for (int n = 0; n < getParameters().size(); n++) {
+        flagParameterChanged(n);
+    }
+    startupTimer.phaseFinished("parameters");
+
     // Make sure that the parameter valuetree has a name, to prevent assertion failures
     // parameters.replaceState(ValueTree("plugdata"));
 
@@ -127,9 +164,6 @@ PluginProcessor::PluginProcessor()
     midiBufferOut.ensureSize(2048);
     midiBufferInternalSynth.ensureSize(2048);
 
-    atoms_playhead.reserve(3);
-    atoms_playhead.resize(1);
-
     sendMessagesFromQueue();
 
     auto themeName = settingsFile->getProperty<String>("theme");
@@ -143,11 +177,23 @@ PluginProcessor::PluginProcessor()
 
     setTheme(themeName, true);
     settingsFile->saveSettings();
+    startupTimer.phaseFinished("theme");
 
     oversampling = settingsFile->getProperty<int>("oversampling");
 
     setProtectedMode(settingsFile->getProperty<int>("protected"));
+    playheadResendInterval = settingsFile->getProperty<int>("playhead_resend_interval");
+    maxUndoSteps = std::max(1, settingsFile->getProperty<int>("max_undo_steps"));
+    sampleAccurateMidi = settingsFile->getProperty<int>("sample_accurate_midi");
+    messageDispatcher->setQueueSize(std::max(1024, settingsFile->getProperty<int>("gui_message_queue_size")));
     enableInternalSynth = settingsFile->getProperty<int>("internal_synth");
+    internalSynth->setRenderOnWorkerThread(settingsFile->getProperty<int>("internal_synth_worker_thread"));
+    internalSynth->setMaxVoices(settingsFile->getProperty<int>("internal_synth_voices"));
+
+    // Shared by all instances, so they don't each start their own threads
+    // Only the internal synth submits work to them, so plugins don't start any
+    if (ProjectInfo::isStandalone)
+        RealtimeWorkerPool::getInstance()->setCoreBudget(settingsFile->getProperty<int>("realtime_worker_threads"));
 
     auto currentThemeTree = settingsFile->getCurrentTheme();
 
@@ -156,15 +202,57 @@ PluginProcessor::PluginProcessor()
     initialisePd(pdlua_version);
     logMessage(pdlua_version);
 
+    // The parameters were named before we could create symbols
+    {
+        SpinLock::ScopedLockType lock(parameterIndexLock);
+        for (auto const& [name, parameter] : parametersByName) {
+            parametersBySymbol[generateSymbol(name)] = parameter;
+        }
+    }
+    startupTimer.phaseFinished("pd");
+
     updateSearchPaths();
+    startupTimer.phaseFinished("search paths");
 
     objectLibrary = std::make_unique<pd::Library>(this);
+    startupTimer.phaseFinished("library");
 
     setLatencySamples(pd::Instance::getBlockSize());
+
+    // Called on the renderer's thread, while the audio thread doesn't touch Pd
+    // If something else holds the audio lock, it could be waiting for the renderer to stop, so try again later
+    anticipatoryRenderer.renderBlock = [this](float* const* outputs) -> MidiBuffer const* {
+        if (!tryLockAudioThread())
+            return nullptr;
+
+        audioAdvancement = 0;
+        midiByteIndex = 0;
+        midiByteBuffer[0] = 0;
+        midiByteBuffer[1] = 0;
+        midiByteBuffer[2] = 0;
+        midiBufferOut.clear();
+
+        setThis();
+        performDSP(nullptr, 0, outputs, static_cast<int>(channelPointers.size()));
+
+        // The MIDI handlers write into midiBufferOut, so Pd's MIDI output ends up in this block
+        processHookMessages();
+        unlockAudioThread();
+
+        messageDispatcher->dispatch();
+        return &midiBufferOut;
+    };
+
+    auto const startupReport = startupTimer.getReport();
+    logMessage(startupReport);
+    Logger::writeToLog(startupReport);
 }
 
 PluginProcessor::~PluginProcessor()
 {
+    if (ProjectInfo::isStandalone && isNonRealtime())
+        RealtimeWorkerPool::getInstance()->setRenderingOffline(false);
+
     // Deleting the pd instance in ~PdInstance() will also free all the Pd patches
     patches.clear();
 }
@@ -176,37 +264,23 @@ void PluginProcessor::initialiseFilesystem()
     auto deken = homeDir.getChildFile("Externals");
     auto patches = homeDir.getChildFile("Patches");
 
-    // Check if the abstractions directory exists, if not, unzip it from binaryData
-    if (!homeDir.exists() || !versionDataDir.exists()) {
-
-        // Binary data shouldn't be too big, then the compiler will run out of memory
-        // To prevent this, we split the binarydata into multiple files, and add them back together here
-        std::vector<char> allData;
-        int i = 0;
-        while (true) {
-            int size;
-            auto* resource = BinaryData::getNamedResource((String("Filesystem_") + String(i) + "_zip").toRawUTF8(), size);
-
-            if (!resource) {
-                break;
-            }
+    // Binary data shouldn't be too big, then the compiler will run out of memory
+    // To prevent this, we split the binarydata into multiple files, the extractor reads them as one zip file
+    FilesystemExtractor::Chunks chunks;
+    while (true) {
+        int size;
+        auto* resource = BinaryData::getNamedResource((String("Filesystem_") + String(static_cast<int>(chunks.size())) + "_zip").toRawUTF8(), size);
 
-            allData.insert(allData.end(), resource, resource + size);
-            i++;
+        if (!resource) {
+            break;
         }
 
-        MemoryInputStream memstream(allData.data(), allData.size(), false);
-
-        homeDir.createDirectory();
-
-        auto file = ZipFile(memstream);
-        file.uncompressTo(homeDir);
-
-        // Create filesystem for this specific version
-        versionDataDir.getParentDirectory().createDirectory();
-        versionDataDir.createDirectory();
-        homeDir.getChildFile("plugdata_version").moveFileTo(versionDataDir);
+        chunks.emplace_back(resource, size);
     }
+
+    // Unzips the abstractions and other files Pd needs if they're not there, help files are unpacked in the background
+    versionDataDir.getParentDirectory().createDirectory();
+    filesystemExtractor->extract(homeDir, versionDataDir, std::move(chunks));
     if (!deken.exists()) {
         deken.createDirectory();
     }
@@ -214,82 +288,105 @@ void PluginProcessor::initialiseFilesystem()
         patches.createDirectory();
     }
 
-    auto testTonePatch = homeDir.getChildFile("testtone.pd");
-    auto cpuTestPatch = homeDir.getChildFile("load-meter.pd");
-
-    if (testTonePatch.exists())
-        testTonePatch.deleteFile();
-    if (cpuTestPatch.exists())
-        cpuTestPatch.deleteFile();
-
-    File(versionDataDir.getChildFile("./Documentation/7.stuff/tools/testtone.pd")).copyFileTo(testTonePatch);
-    File(versionDataDir.getChildFile("./Documentation/7.stuff/tools/load-meter.pd")).copyFileTo(cpuTestPatch);
-
-    // We want to recreate these symlinks so that they link to the abstractions/docs for the current plugdata version
-    homeDir.getChildFile("Abstractions").deleteFile();
-    homeDir.getChildFile("Documentation").deleteFile();
-    homeDir.getChildFile("Extra").deleteFile();
-
-    // We always want to update the symlinks in case an older version of plugdata was used
-#if JUCE_WINDOWS
-    // Get paths that need symlinks
-    auto abstractionsPath = versionDataDir.getChildFile("Abstractions").getFullPathName().replaceCharacters("/", "\\");
-    auto documentationPath = versionDataDir.getChildFile("Documentation").getFullPathName().replaceCharacters("/", "\\");
-    auto extraPath = versionDataDir.getChildFile("Extra").getFullPathName().replaceCharacters("/", "\\");
-    auto dekenPath = deken.getFullPathName();
-    auto patchesPath = patches.getFullPathName();
-
-    // Create NTFS directory junctions
-    OSUtils::createJunction(homeDir.getChildFile("Abstractions").getFullPathName().replaceCharacters("/", "\\").toStdString(), abstractionsPath.toStdString());
-    OSUtils::createJunction(homeDir.getChildFile("Documentation").getFullPathName().replaceCharacters("/", "\\").toStdString(), documentationPath.toStdString());
-    OSUtils::createJunction(homeDir.getChildFile("Extra").getFullPathName().replaceCharacters("/", "\\").toStdString(), extraPath.toStdString());
-
-#elif JUCE_IOS
-    // This is not ideal but on iOS, it seems to be the only way to make it work...
-    versionDataDir.getChildFile("Abstractions").copyDirectoryTo(homeDir.getChildFile("Abstractions"));
-    versionDataDir.getChildFile("Documentation").copyDirectoryTo(homeDir.getChildFile("Documentation"));
-    versionDataDir.getChildFile("Extra").copyDirectoryTo(homeDir.getChildFile("Extra"));
+    // Every plugin instance goes through here, but the files and links only need to be checked once per process
+    static std::once_flag linksUpdated;
+    std::call_once(linksUpdated, [&homeDir, &versionDataDir]() {
+        auto const updateCopy = [](File const& source, File const& target) {
+            if (target.existsAsFile() && target.getSize() == source.getSize() && target.hasIdenticalContentTo(source))
+                return;
+
+            target.deleteFile();
+            source.copyFileTo(target);
+        };
+
+        updateCopy(versionDataDir.getChildFile("./Documentation/7.stuff/tools/testtone.pd"), homeDir.getChildFile("testtone.pd"));
+        updateCopy(versionDataDir.getChildFile("./Documentation/7.stuff/tools/load-meter.pd"), homeDir.getChildFile("load-meter.pd"));
+
+        // The links should point to the abstractions/docs for the current plugdata version, in case an older version of plugdata was used
+        for (auto const& name : { "Abstractions", "Documentation", "Extra" }) {
+            auto const target = versionDataDir.getChildFile(name);
+            auto const link = homeDir.getChildFile(name);
+
+#if JUCE_IOS
+            // This is not ideal but on iOS, it seems to be the only way to make it work...
+            // The copied folder gets a version file, so we only copy it again when the version changed
+            auto const versionFile = link.getChildFile(".plugdata_version");
+            if (link.isDirectory() && versionFile.loadFileAsString() == ProjectInfo::versionString)
+                continue;
+
+            link.deleteRecursively();
+            target.copyDirectoryTo(link);
+            versionFile.replaceWithText(ProjectInfo::versionString);
 #else
-    versionDataDir.getChildFile("Abstractions").createSymbolicLink(homeDir.getChildFile("Abstractions"), true);
-    versionDataDir.getChildFile("Documentation").createSymbolicLink(homeDir.getChildFile("Documentation"), true);
-    versionDataDir.getChildFile("Extra").createSymbolicLink(homeDir.getChildFile("Extra"), true);
-#endif
+            if (link.isSymbolicLink() && link.getLinkedTarget() == target)
+                continue;
 
-    internalSynth->extractSoundfont();
+            link.deleteFile();
+#    if JUCE_WINDOWS
+            // Create NTFS directory junctions
+            OSUtils::createJunction(link.getFullPathName().replaceCharacters("/", "\\").toStdString(), target.getFullPathName().replaceCharacters("/", "\\").toStdString());
+#    else
+            target.createSymbolicLink(link, true);
+#    endif
+#endif
+        }
+    });
 }
 
-void PluginProcessor::updateSearchPaths()
+// All instances use the same settings, so the list of search paths only has to be built once per change
+StringArray PluginProcessor::getSharedSearchPaths(ValueTree const& pathTree)
 {
-    // Reload pd search paths from settings
-    auto pathTree = settingsFile->getPathsTree();
+    static std::mutex cacheMutex;
+    static String cachedKey;
+    static StringArray cachedPaths;
 
-    setThis();
+    StringArray userPaths;
+    for (auto child : pathTree) {
+        userPaths.add(child.getProperty("Path").toString());
+    }
+    auto const externalPaths = DekenInterface::getExternalPaths();
 
-    lockAudioThread();
+    auto const key = userPaths.joinIntoString("\n") + "\n\n" + externalPaths.joinIntoString("\n");
 
-    // Get pd's search paths
-    char* p[1024];
-    int numItems;
-    pd::Interface::getSearchPaths(p, &numItems);
-    auto currentPaths = StringArray(p, numItems);
+    std::lock_guard lock(cacheMutex);
+    if (key == cachedKey && !cachedPaths.isEmpty())
+        return cachedPaths;
 
     auto paths = pd::Library::defaultPaths;
-
-    for (auto child : pathTree) {
-        auto path = child.getProperty("Path").toString().replace("\\", "/");
-        paths.addIfNotAlreadyThere(path);
+    for (auto const& path : userPaths) {
+        paths.addIfNotAlreadyThere(path.replace("\\", "/"));
     }
 
+    StringArray result;
     for (auto const& path : paths) {
-        if (currentPaths.contains(path.getFullPathName()))
-            continue;
-        libpd_add_to_search_path(path.getFullPathName().toRawUTF8());
+        result.add(path.getFullPathName());
+    }
+    for (auto const& path : externalPaths) {
+        result.add(path.replace("\\", "/"));
     }
+    result.removeDuplicates(false);
 
-    for (auto const& path : DekenInterface::getExternalPaths()) {
-        if (currentPaths.contains(path))
-            continue;
-        libpd_add_to_search_path(path.replace("\\", "/").toRawUTF8());
+    cachedKey = key;
+    cachedPaths = result;
+    return result;
+}
+
+void PluginProcessor::updateSearchPaths()
+{
+    // Reload pd search paths from settings
+    auto const paths = getSharedSearchPaths(settingsFile->getPathsTree());
+
+    // Only touch the paths that changed since the last update
+    StringArray pathsToRemove;
+    for (auto const& path : appliedSearchPaths) {
+        if (!paths.contains(path))
+            pathsToRemove.add(path);
+    }
+
+    StringArray pathsToAdd;
+    for (auto const& path : paths) {
+        if (!appliedSearchPaths.contains(path))
+            pathsToAdd.add(path);
     }
 
     auto librariesTree = settingsFile->getLibrariesTree();
@@ -300,20 +397,66 @@ void PluginProcessor::updateSearchPaths()
         }
     }
 
-    // Load startup libraries that the user defined in settings
+    StringArray libraries;
     for (auto library : librariesTree) {
+        libraries.addIfNotAlreadyThere(library.getProperty("Name").toString());
+    }
 
-        auto const libName = library.getProperty("Name").toString();
+    // Libraries can't be unloaded, so we only need to load the new ones
+    StringArray librariesToLoad;
+    for (auto const& libName : libraries) {
+        if (!loadedLibraries.contains(libName))
+            librariesToLoad.add(libName);
+    }
 
-        // Load the library: this must be done after updating paths
-        // If the library is already loaded, it will return true
-        // This will load the libraries directly instead of on restart, not sure if Pd does that but it's actually nice
-        if (!loadLibrary(libName)) {
-            logError("Failed to load library: " + libName);
-        }
+    if (pathsToRemove.isEmpty() && pathsToAdd.isEmpty() && librariesToLoad.isEmpty())
+        return;
+
+    setThis();
+
+    lockAudioThread();
+
+    for (auto const& path : pathsToRemove) {
+        pd::Interface::removeFromSearchPath(path.toRawUTF8());
+    }
+
+    for (auto const& path : pathsToAdd) {
+        libpd_add_to_search_path(path.toRawUTF8());
     }
 
+    // If enabled, libraries we've seen before are only loaded once a patch uses one of their objects
+    auto const deferLibraries = settingsFile->getProperty<bool>("defer_library_loading");
+    auto const librarySearchPaths = deferLibraries ? pd::LibraryLoader::getSearchPaths() : StringArray();
+
     unlockAudioThread();
+
+    // Finding out if a library changed scans the file system, so we don't hold the audio lock for that
+    std::vector<int64> libraryModificationTimes;
+    for (auto const& libName : librariesToLoad) {
+        libraryModificationTimes.push_back(deferLibraries ? pd::LibraryLoader::getLibraryModificationTime(libName, librarySearchPaths) : 0);
+    }
+
+    lockAudioThread();
+
+    // Load startup libraries that the user defined in settings
+    // This must be done after updating paths
+    StringArray failedLibraries;
+    for (int i = 0; i < librariesToLoad.size(); i++) {
+        if (!pd::LibraryLoader::getInstance()->loadLibrary(librariesToLoad[i], libraryModificationTimes[i]))
+            failedLibraries.add(librariesToLoad[i]);
+    }
+
+    unlockAudioThread();
+
+    // Failed libraries are retried on the next reload, in case the paths changed
+    for (auto const& libName : librariesToLoad) {
+        if (failedLibraries.contains(libName))
+            logError("Failed to load library: " + libName);
+        else
+            loadedLibraries.add(libName);
+    }
+
+    appliedSearchPaths = paths;
 }
 
 String const PluginProcessor::getName() const
@@ -365,7 +508,9 @@ void PluginProcessor::setCurrentProgram(int index)
         MemoryOutputStream data;
         Base64::convertFromBase64(data, Presets::presets[index].second);
         if (data.getDataSize() > 0) {
+            // Patches that are the same in both presets aren't reloaded, so for presets of the same patch we only apply the parameter values and extra data
             setStateInformation(data.getData(), static_cast<int>(data.getDataSize()));
+            fadeInAfterProgramChange = true;
             lastSetProgram = index;
         }
     }
@@ -401,6 +546,68 @@ void PluginProcessor::setOversampling(int amount)
     suspendProcessing(false);
 }
 
+void PluginProcessor::setRenderAhead(bool enabled)
+{
+    if (renderAheadEnabled == enabled)
+        return;
+
+    suspendProcessing(true);
+
+    renderAheadEnabled = enabled;
+
+    if (AudioProcessor::getSampleRate() > 0)
+        prepareToPlay(AudioProcessor::getSampleRate(), AudioProcessor::getBlockSize());
+
+    suspendProcessing(false);
+}
+
+void PluginProcessor::setAutoSleep(bool enabled)
+{
+    if (dspSleepDetector.isEnabled() == enabled)
+        return;
+
+    dspSleepDetector.setEnabled(enabled);
+    updateHostDisplay(ChangeDetails().withNonParameterStateChanged(true));
+}
+
+void PluginProcessor::valueChanged(Value& v)
+{
+    if (v.refersToSameSourceAs(tailLength)) {
+        dspSleepDetector.setSleepDelay(getValue<float>(tailLength));
+    }
+}
+
+void PluginProcessor::setOversamplingFilter(int filterType)
+{
+    if (oversamplingFilter == filterType)
+        return;
+
+    oversamplingFilter = filterType;
+
+    suspendProcessing(true);
+    prepareToPlay(AudioProcessor::getSampleRate(), AudioProcessor::getBlockSize());
+    suspendProcessing(false);
+}
+
+void PluginProcessor::setPdBlockSize(int newBlockSize)
+{
+    if (Instance::getBlockSize() == newBlockSize)
+        return;
+
+    suspendProcessing(true);
+
+    Instance::setBlockSize(newBlockSize);
+
+    // If we need to use the FIFO, it will add one Pd block of latency, so make sure we report at least that
+    if (getLatencySamples() < Instance::getBlockSize())
+        setLatencySamples(Instance::getBlockSize());
+
+    if (AudioProcessor::getSampleRate() > 0)
+        prepareToPlay(AudioProcessor::getSampleRate(), AudioProcessor::getBlockSize());
+
+    suspendProcessing(false);
+}
+
 void PluginProcessor::setProtectedMode(bool enabled)
 {
     protectedMode = enabled;
@@ -408,47 +615,105 @@ void PluginProcessor::setProtectedMode(bool enabled)
 
 void PluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
+    // Make sure Pd isn't rendering ahead while we prepare it
+    anticipatoryRenderer.stop();
+
     float oversampleFactor = 1 << oversampling;
     auto maxChannels = std::max(getTotalNumInputChannels(), getTotalNumOutputChannels());
+    auto const pdBlockSize = static_cast<size_t>(Instance::getBlockSize());
+    auto const blockSize = static_cast<int>(pdBlockSize);
 
-    prepareDSP(getTotalNumInputChannels(), getTotalNumOutputChannels(), sampleRate * oversampleFactor, samplesPerBlock * oversampleFactor);
+    // Hosts call this a lot, for example when starting the transport. If nothing changed since last time,
+    // Pd's DSP chain, the oversampler and the buffers we prepared are still valid, and only need to be cleared
+    auto const configuration = DspConfiguration { sampleRate, samplesPerBlock, getTotalNumInputChannels(), getTotalNumOutputChannels(), blockSize, oversampling, oversamplingFilter, renderAheadEnabled, enableInternalSynth };
+    auto const needsRebuild = !(configuration == preparedConfiguration) || !oversampler;
+    preparedConfiguration = configuration;
 
-    oversampler = std::make_unique<dsp::Oversampling<float>>(std::max(1, maxChannels), oversampling, dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, false);
+    dspSleepDetector.prepare(sampleRate);
 
-    oversampler->initProcessing(samplesPerBlock);
+    if (needsRebuild) {
+        prepareDSP(getTotalNumInputChannels(), getTotalNumOutputChannels(), sampleRate * oversampleFactor, samplesPerBlock * oversampleFactor);
 
-    if (enableInternalSynth && ProjectInfo::isStandalone) {
-        internalSynth->prepare(sampleRate, samplesPerBlock, maxChannels);
-    }
+        auto filterType = oversamplingFilter ? dsp::Oversampling<float>::filterHalfBandFIREquiripple : dsp::Oversampling<float>::filterHalfBandPolyphaseIIR;
+        oversampler = std::make_unique<dsp::Oversampling<float>>(std::max(1, maxChannels), oversampling, filterType, false, true);
 
-    audioAdvancement = 0;
-    auto const pdBlockSize = static_cast<size_t>(Instance::getBlockSize());
-    audioBufferIn.setSize(maxChannels, pdBlockSize);
-    audioBufferOut.setSize(maxChannels, pdBlockSize);
+        oversampler->initProcessing(samplesPerBlock);
 
-    audioVectorIn.resize(maxChannels * pdBlockSize, 0.0f);
-    audioVectorOut.resize(maxChannels * pdBlockSize, 0.0f);
+        // Only replace the part of the latency that came from oversampling, the rest is set by the user
+        auto newOversamplingLatency = oversampling > 0 ? static_cast<int>(oversampler->getLatencyInSamples()) : 0;
+        if (newOversamplingLatency != oversamplingLatency) {
+            setLatencySamples(std::max(0, getLatencySamples() - oversamplingLatency + newOversamplingLatency));
+            oversamplingLatency = newOversamplingLatency;
+        }
 
-    midiBufferIn.clear();
-    midiBufferOut.clear();
+        if (enableInternalSynth && ProjectInfo::isStandalone) {
+            internalSynth->prepare(sampleRate, samplesPerBlock, maxChannels);
+        }
+
+        channelPointers.resize(maxChannels, nullptr);
 
-    // If the block size is a multiple of 64 and we are not a plugin, we can optimise the process loop
-    // Audio plugins can choose to send in a smaller block size when automation is happening
-    variableBlockSize = !ProjectInfo::isStandalone || samplesPerBlock < pdBlockSize || samplesPerBlock % pdBlockSize != 0;
+        // If the block size is a multiple of 64 and we are not a plugin, we can optimise the process loop
+        // Audio plugins can choose to send in a smaller block size when automation is happening
+        variableBlockSize = !ProjectInfo::isStandalone || samplesPerBlock < pdBlockSize || samplesPerBlock % pdBlockSize != 0;
 
-    if (variableBlockSize) {
-        inputFifo = std::make_unique<AudioMidiFifo>(maxChannels, std::max<int>(pdBlockSize, samplesPerBlock) * 3);
-        outputFifo = std::make_unique<AudioMidiFifo>(maxChannels, std::max<int>(pdBlockSize, samplesPerBlock) * 3);
+        if (variableBlockSize) {
+            auto const maxSamplesPerBlock = samplesPerBlock * static_cast<int>(oversampleFactor);
+            inputFifo.prepare(maxChannels, blockSize, maxSamplesPerBlock);
+            outputFifo.prepare(maxChannels, blockSize, maxSamplesPerBlock);
+        }
+
+        // Rendering ahead adds the depth of its ring to the reported latency, it doesn't work together with oversampling
+        usingRenderAhead = renderAheadEnabled && oversampling == 0;
+        auto const newRenderAheadLatency = usingRenderAhead ? (std::max(blockSize * renderAheadBlocks, samplesPerBlock * 2) + blockSize - 1) / blockSize * blockSize : 0;
+        if (newRenderAheadLatency != renderAheadLatency) {
+            setLatencySamples(std::max(0, getLatencySamples() - renderAheadLatency + newRenderAheadLatency));
+            renderAheadLatency = newRenderAheadLatency;
+        }
+
+        if (usingRenderAhead) {
+            inputFifo.prepare(maxChannels, blockSize, samplesPerBlock);
+            renderAheadBlock.setSize(maxChannels, blockSize);
+        }
+    } else {
+        oversampler->reset();
+        inputFifo.clear();
+        outputFifo.clear();
     }
 
+    // Starts with a ring of silence again, either way
+    if (usingRenderAhead)
+        anticipatoryRenderer.prepare(maxChannels, blockSize, renderAheadLatency, samplesPerBlock);
+
+    audioAdvancement = 0;
+
+    midiBufferIn.clear();
+    midiBufferOut.clear();
+
     midiByteIndex = 0;
     midiByteBuffer[0] = 0;
     midiByteBuffer[1] = 0;
     midiByteBuffer[2] = 0;
 
+    // Resolve all playhead symbols once, instead of going through gensym for every message
+    auto* playheadReceiver = generateSymbol("_playhead");
+    char const* playheadSelectors[NumPlayheadMessages] = { "playing", "recording", "looping", "edittime", "framerate", "bpm", "lastbar", "timesig", "position" };
+    for (int i = 0; i < NumPlayheadMessages; i++) {
+        auto& state = playheadState[i];
+        state.receiver = i == PlayheadPosition ? generateSymbol("playhead") : playheadReceiver;
+        state.selector = generateSymbol(playheadSelectors[i]);
+        state.numAtoms = 0;
+        state.needsUpdate = true;
+    }
+    playheadBlocksSinceResend = 0;
+
     cpuLoadMeasurer.reset(sampleRate, samplesPerBlock);
+    deadlineMonitor.prepareToPlay(sampleRate);
 
-    startDSP();
+    // Switching DSP on while it's already running would make Pd rebuild the chain
+    // We ask Pd instead of remembering it ourselves, since a patch can also switch DSP off with [; pd dsp 0(
+    if (needsRebuild || !isDSPRunning()) {
+        startDSP();
+    }
 
     statusbarSource->setSampleRate(sampleRate);
     statusbarSource->setBufferSize(samplesPerBlock);
@@ -461,9 +726,39 @@ void PluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 
 void PluginProcessor::releaseResources()
 {
+    anticipatoryRenderer.stop();
     releaseDSP();
 }
 
+void PluginProcessor::setNonRealtime(bool shouldBeNonRealtime) noexcept
+{
+    if (shouldBeNonRealtime != isNonRealtime()) {
+        // Nothing is drawn while rendering offline, so don't let the GUI messages pile up
+        messageDispatcher->setSuspended(shouldBeNonRealtime);
+        if (ProjectInfo::isStandalone)
+            RealtimeWorkerPool::getInstance()->setRenderingOffline(shouldBeNonRealtime);
+
+        if (!shouldBeNonRealtime) {
+            // Let the GUI catch up with everything that happened during the render
+            MessageManager::callAsync([this]() {
+                for (auto* editor : getEditors()) {
+                    for (auto* cnv : editor->canvases) {
+                        cnv->synchronise();
+
+                        // Synchronising skips objects whose pd state didn't change, but their values can still be stale
+                        for (auto* object : cnv->objects) {
+                            if (object->gui)
+                                object->gui->update();
+                        }
+                    }
+                }
+            });
+        }
+    }
+
+    AudioProcessor::setNonRealtime(shouldBeNonRealtime);
+}
+
 bool PluginProcessor::isBusesLayoutSupported(BusesLayout const& layouts) const
 {
 #if JUCE_IOS
@@ -521,39 +816,95 @@ void PluginProcessor::settingsFileReloaded()
         setTheme(newTheme);
     }
 
+    // Search paths and libraries are updated through searchPathsChanged, only if they changed
+}
+
+void PluginProcessor::searchPathsChanged()
+{
     updateSearchPaths();
-    if(objectLibrary) objectLibrary->updateLibrary();
+    if (objectLibrary)
+        objectLibrary->updateLibrary();
 }
 
 
 void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
 {
     ScopedNoDenormals noDenormals;
+    RealtimeSafety::ScopedRealtimeSection realtimeSection;
+    Tracing::ScopedEvent traceEvent("processBlock");
     AudioProcessLoadMeasurer::ScopedTimer cpuTimer(cpuLoadMeasurer, buffer.getNumSamples());
+    deadlineMonitor.blockStarted();
+
+    // MIDI output is scheduled relative to the start of the block
+    auto const blockStartTime = Time::getMillisecondCounterHiRes();
 
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
-    setThis();
-    sendPlayhead();
-    sendParameters();
+    if (ProjectInfo::isStandalone) {
+        ProjectInfo::getMidiDeviceManager()->readMidiInput(midiMessages, buffer.getNumSamples(), getSampleRate());
+    }
 
     for (int i = totalNumInputChannels; i < totalNumOutputChannels; ++i) {
         buffer.clear(i, 0, buffer.getNumSamples());
     }
 
-    auto targetBlock = dsp::AudioBlock<float>(buffer);
-    auto blockOut = oversampling > 0 ? oversampler->processSamplesUp(targetBlock) : targetBlock;
-
     auto hasMidiInEvents = hasRealEvents(midiMessages);
 
-    midiBufferIn.clear();
-    midiBufferOut.clear();
+    // Needs to be checked before sendParameters, which clears the changed parameters
+    auto const hasTransportActivity = dspSleepDetector.hasTransportActivity(getPlayHead());
+    auto const hasActivity = hasTransportActivity || hasMidiInEvents || hasChangedParameters() || hasPendingMessages() || patchEdited.load() || !DspSleepDetector::isSilent(buffer, totalNumInputChannels);
+
+    // Nothing from outside reaches Pd in this block, so what the renderer computed ahead of time is still valid
+    // A playing or changed transport counts as input, since the patch could be synced to it
+    auto inputFree = usingRenderAhead && !isNonRealtime() && !hasTransportActivity && !hasMidiInEvents && !hasChangedParameters() && numParameterRamps == 0 && !hasPendingMessages() && !patchEdited.load();
+    for (int ch = 0; inputFree && ch < totalNumInputChannels; ch++) {
+        inputFree = !isInputChannelUsed(ch);
+    }
+
+    if (!dspSleepDetector.shouldProcess(hasActivity)) {
+        // What was rendered ahead is stale by the time we wake up
+        if (usingRenderAhead)
+            anticipatoryRenderer.reset();
+        else
+            anticipatoryRenderer.stopPrerendering();
+        buffer.clear();
+        midiMessages.clear();
+        statusbarSource->setDspSleeping(true);
+        if (!isNonRealtime())
+            deadlineMonitor.blockFinished(buffer.getNumSamples(), { lockWaitTicks, numMessagesProcessed, patchEdited.load() });
+        resetBlockActivity();
+        return;
+    }
 
-    if (variableBlockSize) {
-        processVariable(blockOut, midiMessages);
+    statusbarSource->setDspSleeping(false);
+
+    setThis();
+
+    // Take over from the renderer before anything reaches Pd. In input-free blocks the playhead didn't change, so there's nothing new to send
+    if (!inputFree)
+        anticipatoryRenderer.stopPrerendering();
+
+    if (!anticipatoryRenderer.isPrerendering())
+        sendPlayhead();
+
+    // With a variable block size, the last Pd block of this buffer may only run in the next one
+    collectParameterChanges(buffer.getNumSamples() * (1 << oversampling) / Instance::getBlockSize());
+
+    auto targetBlock = dsp::AudioBlock<float>(buffer);
+    auto blockOut = oversampling > 0 ? oversampler->processSamplesUp(targetBlock) : targetBlock;
+
+    if (usingRenderAhead) {
+        processAhead(blockOut, midiMessages, inputFree);
     } else {
-        processConstant(blockOut, midiMessages);
+        midiBufferIn.clear();
+        midiBufferOut.clear();
+
+        if (variableBlockSize) {
+            processVariable(blockOut, midiMessages);
+        } else {
+            processConstant(blockOut, midiMessages);
+        }
     }
 
     auto hasMidiOutEvents = hasRealEvents(midiMessages);
@@ -589,26 +940,40 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
     else
         mappedTargetGain = jmap(targetGain, 0.8f, 1.0f, 1.0f, 2.0f);
 
+    // Fade in from silence after switching presets, this uses the same ramp time as the volume control
+    if (fadeInAfterProgramChange.exchange(false))
+        smoothedGain.setCurrentAndTargetValue(0.0f);
+
     // apply smoothing to the main volume control
     smoothedGain.setTargetValue(mappedTargetGain);
     smoothedGain.applyGain(buffer, buffer.getNumSamples());
 
-    statusbarSource->process(hasMidiInEvents, hasMidiOutEvents, totalNumOutputChannels);
-    statusbarSource->setCPUUsage(cpuLoadMeasurer.getLoadAsPercentage());
-    statusbarSource->peakBuffer.write(buffer);
+    // The meters aren't shown while rendering offline
+    if (!isNonRealtime()) {
+        statusbarSource->process(hasMidiInEvents, hasMidiOutEvents, totalNumOutputChannels);
+        statusbarSource->setCPUUsage(cpuLoadMeasurer.getLoadAsPercentage());
+        statusbarSource->peakMeter.write(buffer);
+    }
+
+    // Offline renders have no deadline, a slow block there isn't an overrun
+    if (!isNonRealtime())
+        deadlineMonitor.blockFinished(buffer.getNumSamples(), { lockWaitTicks, numMessagesProcessed, patchEdited.load() });
+    auto const hadActivity = hasActivity || hasMidiOutEvents || numMessagesProcessed > 0;
+    resetBlockActivity();
 
     if (ProjectInfo::isStandalone) {
-        for (auto bufferIterator : midiMessages) {
-            auto* midiDeviceManager = ProjectInfo::getMidiDeviceManager();
+        auto* midiDeviceManager = ProjectInfo::getMidiDeviceManager();
+        auto const numOutputDevices = midiDeviceManager->getNumOutputDevices();
 
+        for (auto bufferIterator : midiMessages) {
             int device;
             auto message = MidiDeviceManager::convertFromSysExFormat(bufferIterator.getMessage(), device);
 
-            if (enableInternalSynth && (device > midiDeviceManager->getOutputDevices().size() || device == 0)) {
+            if (enableInternalSynth && (device > numOutputDevices || device == 0)) {
                 midiBufferInternalSynth.addEvent(message, 0);
             }
-            if (isPositiveAndBelow(device, midiDeviceManager->getOutputDevices().size() + 1)) {
-                midiDeviceManager->sendMidiOutputMessage(device, message);
+            if (isPositiveAndBelow(device, numOutputDevices + 1)) {
+                midiDeviceManager->sendMidiOutputMessage(device, message, blockStartTime, bufferIterator.samplePosition, getSampleRate());
             }
         }
 
@@ -621,41 +986,53 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
             internalSynth->prepare(getSampleRate(), AudioProcessor::getBlockSize(), std::max(totalNumInputChannels, totalNumOutputChannels));
         }
         midiBufferInternalSynth.clear();
+        statusbarSource->addInternalSynthTime(internalSynth->takeRenderTime());
     }
 
     if (protectedMode && buffer.getNumChannels() > 0) {
 
-        // Take out inf and NaN values
+        // Take out inf and NaN values, and find the peak so the limiter can be skipped for quiet blocks
+        float peak = 0.0f;
         auto* const* writePtr = buffer.getArrayOfWritePointers();
         for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
-            for (int n = 0; n < buffer.getNumSamples(); n++) {
-                if (!std::isfinite(writePtr[ch][n])) {
-                    writePtr[ch][n] = 0.0f;
-                }
-            }
+            peak = std::max(peak, Limiter::sanitise(writePtr[ch], buffer.getNumSamples()));
         }
 
         auto block = dsp::AudioBlock<float>(buffer);
-        limiter.process(block);
+        limiter.process(block, peak);
     }
+
+    dspSleepDetector.blockProcessed(hadActivity, DspSleepDetector::isSilent(buffer, totalNumOutputChannels), buffer.getNumSamples());
 }
 
 
-void PluginProcessor::updatePatchUndoRedoState()
+void PluginProcessor::updatePatchUndoRedoState(Array<pd::Patch::Ptr> const& patchesToUpdate)
 {
+    // Only capture the canvases: if the callback held the last reference to a closed patch, it would be closed on the audio thread
+    std::vector<t_canvas*> canvasesToUpdate;
+    for (auto& patch : patchesToUpdate) {
+        canvasesToUpdate.push_back(patch->getUncheckedPointer());
+    }
+
+    auto updateState = [this, canvasesToUpdate]() {
+        lockAudioThread();
+        for (auto* patch : patchObjects) {
+            // The dirty flag is cheap to read, and the save prompt and autosave need it for patches that aren't visible too
+            patch->updateDirtyState();
+
+            if (std::find(canvasesToUpdate.begin(), canvasesToUpdate.end(), patch->getUncheckedPointer()) != canvasesToUpdate.end())
+                patch->updateUndoRedoState();
+        }
+        unlockAudioThread();
+    };
+
     if(isSuspended())
     {
-        for (auto& patch : patches) {
-            patch->updateUndoRedoState();
-        }
+        updateState();
         return;
     }
         
-    enqueueFunctionAsync([this](){
-        for (auto& patch : patches) {
-            patch->updateUndoRedoState();
-        }
-    });
+    enqueueFunctionAsync(updateState);
 }
 void PluginProcessor::processConstant(dsp::AudioBlock<float> buffer, MidiBuffer& midiMessages)
 {
@@ -671,37 +1048,40 @@ void PluginProcessor::processConstant(dsp::AudioBlock<float> buffer, MidiBuffer&
         midiBufferOut.clear();
     }
 
+    auto const numChannels = static_cast<int>(buffer.getNumChannels());
+
     for (int block = 0; block < numBlocks; block++) {
-        for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
-            // Copy the channel data into the vector
-            juce::FloatVectorOperations::copy(
-                audioVectorIn.data() + (ch * blockSize),
-                buffer.getChannelPointer(ch) + audioAdvancement,
-                blockSize);
+        // Pd copies the input into its own buffer before processing, so we can let it read from and write to the host buffer in-place
+        for (int ch = 0; ch < numChannels; ch++) {
+            channelPointers[ch] = buffer.getChannelPointer(ch) + audioAdvancement;
         }
 
         setThis();
+        sendParameters();
 
         midiBufferIn.clear();
-        midiBufferIn.addEvents(midiMessages, audioAdvancement, blockSize, 0);
-        sendMidiBuffer();
+        midiBufferIn.addEvents(midiMessages, audioAdvancement, blockSize, -audioAdvancement);
 
         // Process audio
-        performDSP(audioVectorIn.data(), audioVectorOut.data());
-
-        sendMessagesFromQueue();
-
-        if (connectionListener && plugdata_debugging_enabled())
-            connectionListener->updateSignalData();
+        // TODO: all root patches share a single Pd instance, which means they share one DSP chain (and the global sys_lock)
+        // Running independent patches on worker threads would require giving each of them its own t_pdinstance
+        auto const dspStartTime = Time::getHighResolutionTicks();
+        if (sampleAccurateMidi && acceptsMidi()) {
+            performDSP(channelPointers.data(), numChannels, channelPointers.data(), numChannels, &midiBufferIn);
+        } else {
+            sendMidiBuffer();
+            performDSP(channelPointers.data(), numChannels, channelPointers.data(), numChannels);
+        }
 
-        messageDispatcher->dispatch();
+        auto const dspEndTime = Time::getHighResolutionTicks();
 
-        for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
-            // Use FloatVectorOperations to copy the vector data into the audioBuffer
-            juce::FloatVectorOperations::copy(
-                buffer.getChannelPointer(ch) + audioAdvancement,
-                audioVectorOut.data() + (ch * blockSize),
-                blockSize);
+        // When rendering offline there's no deadline to keep, and the GUI is suspended
+        if (isNonRealtime()) {
+            sendMessagesFromQueue(false);
+        } else {
+            sendMessagesFromQueue();
+            messageDispatcher->dispatch();
+            statusbarSource->addProcessingTime(dspEndTime - dspStartTime, Time::getHighResolutionTicks() - dspEndTime);
         }
 
         audioAdvancement += blockSize;
@@ -714,24 +1094,17 @@ void PluginProcessor::processConstant(dsp::AudioBlock<float> buffer, MidiBuffer&
 void PluginProcessor::processVariable(dsp::AudioBlock<float> buffer, MidiBuffer& midiMessages)
 {
     auto const pdBlockSize = Instance::getBlockSize();
-    auto const numChannels = buffer.getNumChannels();
+    auto const numChannels = static_cast<int>(channelPointers.size());
 
-    inputFifo->writeAudioAndMidi(buffer, midiMessages);
+    inputFifo.write(buffer, midiMessages);
     midiMessages.clear();
 
-    audioAdvancement = 0; // Always has to be 0 if we use the AudioMidiFifo!
+    audioAdvancement = 0; // Always has to be 0 if we use the fifo!
 
-    while (inputFifo->getNumSamplesAvailable() >= pdBlockSize) {
+    while (inputFifo.getNumSamplesAvailable() >= pdBlockSize && outputFifo.getNumSamplesFree() >= pdBlockSize) {
         midiBufferIn.clear();
-        inputFifo->readAudioAndMidi(audioBufferIn, midiBufferIn);
-
-        for (int channel = 0; channel < audioBufferIn.getNumChannels(); ++channel) {
-            // Copy the channel data into the vector
-            juce::FloatVectorOperations::copy(
-                audioVectorIn.data() + (channel * pdBlockSize),
-                audioBufferIn.getReadPointer(channel),
-                pdBlockSize);
-        }
+        auto const* const* inputs = inputFifo.readBlock(midiBufferIn);
+        auto* const* outputs = outputFifo.getBlockWritePointers();
 
         if (producesMidi()) {
             midiByteIndex = 0;
@@ -742,36 +1115,114 @@ void PluginProcessor::processVariable(dsp::AudioBlock<float> buffer, MidiBuffer&
         }
 
         setThis();
-
-        sendMidiBuffer();
+        sendParameters();
 
         // Process audio
-        performDSP(audioVectorIn.data(), audioVectorOut.data());
-
-        sendMessagesFromQueue();
-
-        if (connectionListener && plugdata_debugging_enabled())
-            connectionListener->updateSignalData();
+        auto const dspStartTime = Time::getHighResolutionTicks();
+        if (sampleAccurateMidi && acceptsMidi()) {
+            performDSP(inputs, numChannels, outputs, numChannels, &midiBufferIn);
+        } else {
+            sendMidiBuffer();
+            performDSP(inputs, numChannels, outputs, numChannels);
+        }
 
-        messageDispatcher->dispatch();
+        auto const dspEndTime = Time::getHighResolutionTicks();
 
-        for (int channel = 0; channel < numChannels; ++channel) {
-            // Use FloatVectorOperations to copy the vector data into the audioBuffer
-            juce::FloatVectorOperations::copy(
-                audioBufferOut.getWritePointer(channel),
-                audioVectorOut.data() + (channel * pdBlockSize),
-                pdBlockSize);
+        // When rendering offline there's no deadline to keep, and the GUI is suspended
+        if (isNonRealtime()) {
+            sendMessagesFromQueue(false);
+        } else {
+            sendMessagesFromQueue();
+            messageDispatcher->dispatch();
+            statusbarSource->addProcessingTime(dspEndTime - dspStartTime, Time::getHighResolutionTicks() - dspEndTime);
         }
 
-        outputFifo->writeAudioAndMidi(audioBufferOut, midiBufferOut);
+        outputFifo.finishedWritingBlock(midiBufferOut);
     }
     
     // When the amount of samples availabble is larger than (2 * pdBlockSize) - buffer.getNumSamples(), we know for sure that we'll have enough samples to process the next block as well
-    auto numAvailable = outputFifo->getNumSamplesAvailable();
+    auto numAvailable = outputFifo.getNumSamplesAvailable();
     auto enough = std::max<int>((2 * pdBlockSize) - static_cast<int>(buffer.getNumSamples()), static_cast<int>(buffer.getNumSamples()));
     if (numAvailable >= enough) {
-        outputFifo->readAudioAndMidi(buffer, midiMessages);
+        outputFifo.read(buffer, midiMessages);
+    }
+}
+
+// Goes through the ring of the anticipatory renderer. While the patch gets no input, the renderer's thread keeps the ring filled,
+// and we only copy from it. Otherwise we take over, and render the input through the input fifo into the ring ourselves
+void PluginProcessor::processAhead(dsp::AudioBlock<float> buffer, MidiBuffer& midiMessages, bool inputFree)
+{
+    auto const pdBlockSize = Instance::getBlockSize();
+    auto const numChannels = static_cast<int>(channelPointers.size());
+    auto const numSamples = static_cast<int>(buffer.getNumSamples());
+    auto* const* outputs = renderAheadBlock.getArrayOfWritePointers();
+
+    auto const renderLive = [this, numChannels, outputs](float const* const* inputs, int numInputs) {
+        audioAdvancement = 0;
+        midiByteIndex = 0;
+        midiByteBuffer[0] = 0;
+        midiByteBuffer[1] = 0;
+        midiByteBuffer[2] = 0;
+        midiBufferOut.clear();
+
+        setThis();
+        sendParameters();
+
+        auto const dspStartTime = Time::getHighResolutionTicks();
+        if (sampleAccurateMidi && acceptsMidi()) {
+            performDSP(inputs, numInputs, outputs, numChannels, &midiBufferIn);
+        } else {
+            sendMidiBuffer();
+            performDSP(inputs, numInputs, outputs, numChannels);
+        }
+
+        auto const dspEndTime = Time::getHighResolutionTicks();
+        sendMessagesFromQueue();
+        messageDispatcher->dispatch();
+        statusbarSource->addProcessingTime(dspEndTime - dspStartTime, Time::getHighResolutionTicks() - dspEndTime);
+
+        anticipatoryRenderer.write(outputs, Instance::getBlockSize(), midiBufferOut);
+    };
+
+    if (!anticipatoryRenderer.isPrerendering()) {
+        inputFifo.write(buffer, midiMessages);
+
+        while (inputFifo.getNumSamplesAvailable() >= pdBlockSize) {
+            midiBufferIn.clear();
+            auto const* const* inputs = inputFifo.readBlock(midiBufferIn);
+            renderLive(inputs, numChannels);
+        }
+    }
+
+    // The renderer's thread fell behind, render the rest here. The patch had no input, so we don't need any
+    while (anticipatoryRenderer.getNumSamplesAvailable() < numSamples) {
+        anticipatoryRenderer.stopPrerendering();
+        midiBufferIn.clear();
+        renderLive(nullptr, 0);
+    }
+
+    midiMessages.clear();
+    anticipatoryRenderer.read(buffer, midiMessages);
+
+    if (inputFree)
+        anticipatoryRenderer.startPrerendering();
+}
+
+void PluginProcessor::setPlayheadValue(PlayheadMessage type, std::initializer_list<float> values)
+{
+    auto& state = playheadState[type];
+
+    int i = 0;
+    for (auto const value : values) {
+        if (i >= state.numAtoms || atom_getfloat(state.atoms + i) != value)
+            state.needsUpdate = true;
+
+        SETFLOAT(state.atoms + i, value);
+        i++;
     }
+
+    state.needsUpdate = state.needsUpdate || state.numAtoms != i;
+    state.numAtoms = i;
 }
 
 void PluginProcessor::sendPlayhead()
@@ -783,136 +1234,175 @@ void PluginProcessor::sendPlayhead()
 
     auto infos = playhead->getPosition();
 
-    setThis();
-    if (infos.hasValue()) {
-        atoms_playhead[0] = static_cast<float>(infos->getIsPlaying());
-        sendMessage("_playhead", "playing", atoms_playhead);
+    if (!infos.hasValue())
+        return;
 
-        atoms_playhead[0] = static_cast<float>(infos->getIsRecording());
-        sendMessage("_playhead", "recording", atoms_playhead);
+    setPlayheadValue(PlayheadPlaying, { static_cast<float>(infos->getIsPlaying()) });
+    setPlayheadValue(PlayheadRecording, { static_cast<float>(infos->getIsRecording()) });
 
-        atoms_playhead[0] = static_cast<float>(infos->getIsLooping());
+    auto loopPoints = infos->getLoopPoints();
+    if (loopPoints.hasValue()) {
+        setPlayheadValue(PlayheadLooping, { static_cast<float>(infos->getIsLooping()), static_cast<float>(loopPoints->ppqStart), static_cast<float>(loopPoints->ppqEnd) });
+    } else {
+        setPlayheadValue(PlayheadLooping, { static_cast<float>(infos->getIsLooping()), 0.0f, 0.0f });
+    }
 
-        auto loopPoints = infos->getLoopPoints();
-        if (loopPoints.hasValue()) {
-            atoms_playhead.emplace_back(static_cast<float>(loopPoints->ppqStart));
-            atoms_playhead.emplace_back(static_cast<float>(loopPoints->ppqEnd));
-        } else {
-            atoms_playhead.emplace_back(0.0f);
-            atoms_playhead.emplace_back(0.0f);
-        }
-        sendMessage("_playhead", "looping", atoms_playhead);
+    if (infos->getEditOriginTime().hasValue()) {
+        setPlayheadValue(PlayheadEditTime, { static_cast<float>(*infos->getEditOriginTime()) });
+    }
 
-        if (infos->getEditOriginTime().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getEditOriginTime());
-            sendMessage("_playhead", "edittime", atoms_playhead);
-        }
+    if (infos->getFrameRate().hasValue()) {
+        setPlayheadValue(PlayheadFrameRate, { static_cast<float>(infos->getFrameRate()->getEffectiveRate()) });
+    }
 
-        if (infos->getFrameRate().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(infos->getFrameRate()->getEffectiveRate());
-            sendMessage("_playhead", "framerate", atoms_playhead);
-        }
+    if (infos->getBpm().hasValue()) {
+        setPlayheadValue(PlayheadBpm, { static_cast<float>(*infos->getBpm()) });
+    }
 
-        if (infos->getBpm().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getBpm());
-            sendMessage("_playhead", "bpm", atoms_playhead);
-        }
+    if (infos->getPpqPositionOfLastBarStart().hasValue()) {
+        setPlayheadValue(PlayheadLastBar, { static_cast<float>(*infos->getPpqPositionOfLastBarStart()) });
+    }
 
-        if (infos->getPpqPositionOfLastBarStart().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getPpqPositionOfLastBarStart());
-            sendMessage("_playhead", "lastbar", atoms_playhead);
-        }
+    if (infos->getTimeSignature().hasValue()) {
+        setPlayheadValue(PlayheadTimeSig, { static_cast<float>(infos->getTimeSignature()->numerator), static_cast<float>(infos->getTimeSignature()->denominator) });
+    }
 
-        if (infos->getTimeSignature().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(infos->getTimeSignature()->numerator);
-            atoms_playhead.emplace_back(static_cast<float>(infos->getTimeSignature()->denominator));
-            sendMessage("_playhead", "timesig", atoms_playhead);
-        }
+    auto ppq = infos->getPpqPosition().hasValue() ? static_cast<float>(*infos->getPpqPosition()) : 0.0f;
+    auto samples = infos->getTimeInSamples().hasValue() ? static_cast<float>(*infos->getTimeInSamples()) : 0.0f;
+    auto seconds = infos->getTimeInSeconds().hasValue() ? static_cast<float>(*infos->getTimeInSeconds()) : 0.0f;
+    setPlayheadValue(PlayheadPosition, { ppq, samples, seconds });
 
-        if (infos->getPpqPosition().hasValue()) {
+    // Every once in a while, resend everything, so that newly opened patches will also receive the current state
+    auto const resendInterval = playheadResendInterval.load();
+    bool const forceResend = resendInterval > 0 && ++playheadBlocksSinceResend >= resendInterval;
+    if (forceResend)
+        playheadBlocksSinceResend = 0;
 
-            atoms_playhead[0] = static_cast<float>(*infos->getPpqPosition());
-        } else {
-            atoms_playhead[0] = 0.0f;
-        }
+    bool locked = false;
+    for (auto& state : playheadState) {
+        if (!state.numAtoms || !(state.needsUpdate || forceResend))
+            continue;
 
-        if (infos->getTimeInSamples().hasValue()) {
-            atoms_playhead[1] = static_cast<float>(*infos->getTimeInSamples());
-        } else {
-            atoms_playhead[1] = 0.0f;
+        if (!locked) {
+            setThis();
+            lockAudioThread();
+            locked = true;
         }
 
-        if (infos->getTimeInSeconds().hasValue()) {
-            atoms_playhead.emplace_back(static_cast<float>(*infos->getTimeInSeconds()));
-        } else {
-            atoms_playhead.emplace_back(0.0f);
+        if (auto* receiver = state.receiver->s_thing) {
+            pd_typedmess(receiver, state.selector, state.numAtoms, state.atoms);
         }
-
-        sendMessage("playhead", "position", atoms_playhead);
-        atoms_playhead.resize(1);
+        state.needsUpdate = false;
     }
+
+    if (locked)
+        unlockAudioThread();
 }
 
-void PluginProcessor::sendParameters()
+void PluginProcessor::flagParameterChanged(int index)
 {
-    for (auto* param : getParameters()) {
-        // We used to do dynamic_cast here, but since it gets called very often and param is always PlugDataParameter, we use reinterpret_cast now
-        auto* pldParam = reinterpret_cast<PlugDataParameter*>(param);
-        if (!pldParam->isEnabled())
-            continue;
+    if (isPositiveAndBelow(index, getParameters().size()))
+        changedParameters[index / 64].fetch_or(uint64(1) << (index % 64));
+}
+
+void PluginProcessor::collectParameterChanges(int numPdBlocks)
+{
+    auto const& parameters = getParameters();
+
+    // Ramps that didn't finish in the last buffer continue from where they are now
+    for (int i = 0; i < numParameterRamps; i++) {
+        flagParameterChanged(parameterRamps[i].parameter->getParameterIndex());
+    }
+
+    numParameterRamps = 0;
+    parameterRampBlock = 0;
+    parameterRampLength = std::max(numPdBlocks, 1);
+
+    for (int word = 0; word < changedParameters.size(); word++) {
+        // Only load the bits once, so that parameters that change while we're sending will be picked up next block
+        auto changed = changedParameters[word].exchange(0);
+
+        while (changed) {
+            auto const bit = std::countr_zero(changed);
+            auto const index = word * 64 + bit;
+            changed &= changed - 1;
+
+            // We used to do dynamic_cast here, but since it gets called very often and param is always PlugDataParameter, we use reinterpret_cast now
+            auto* pldParam = reinterpret_cast<PlugDataParameter*>(parameters.getUnchecked(index));
+            if (!pldParam->isEnabled())
+                continue;
+
+            auto newvalue = pldParam->getUnscaledValue();
+            if (approximatelyEqual(pldParam->getLastValue(), newvalue))
+                continue;
 
-        auto newvalue = pldParam->getUnscaledValue();
-        if (!approximatelyEqual(pldParam->getLastValue(), newvalue)) {
-            auto title = pldParam->getTitle();
-            sendFloat(title.toRawUTF8(), pldParam->getUnscaledValue());
-            pldParam->setLastValue(newvalue);
+            // Discrete parameters jump to their new value in the first block
+            auto const start = pldParam->isDiscrete() ? newvalue : pldParam->getLastValue();
+            parameterRamps[numParameterRamps++] = { pldParam, start, newvalue };
         }
     }
 }
 
-void PluginProcessor::sendMidiBuffer()
+// Called before every Pd block, sends the parameter values interpolated towards where the host wants them at the end of the buffer
+void PluginProcessor::sendParameters()
 {
-    if (acceptsMidi()) {
-        for (auto const& event : midiBufferIn) {
+    if (numParameterRamps == 0 && !resendSignalParameters)
+        return;
 
-            int device;
-            auto message = MidiDeviceManager::convertFromSysExFormat(event.getMessage(), device);
-
-            auto channel = message.getChannel() + (device << 4);
-
-            if (message.isNoteOn()) {
-                sendNoteOn(channel, message.getNoteNumber(), message.getVelocity());
-            } else if (message.isNoteOff()) {
-                sendNoteOn(channel, message.getNoteNumber(), 0);
-            } else if (message.isController()) {
-                sendControlChange(channel, message.getControllerNumber(), message.getControllerValue());
-            } else if (message.isPitchWheel()) {
-                sendPitchBend(channel, message.getPitchWheelValue() - 8192);
-            } else if (message.isChannelPressure()) {
-                sendAfterTouch(channel, message.getChannelPressureValue());
-            } else if (message.isAftertouch()) {
-                sendPolyAfterTouch(channel, message.getNoteNumber(), message.getAfterTouchValue());
-            } else if (message.isProgramChange()) {
-                sendProgramChange(channel, message.getProgramChangeNumber());
-            } else if (message.isSysEx()) {
-                for (int i = 0; i < message.getSysExDataSize(); ++i) {
-                    sendSysEx(device, static_cast<int>(message.getSysExData()[i]));
-                }
-            } else if (message.isMidiClock() || message.isMidiStart() || message.isMidiStop() || message.isMidiContinue() || message.isActiveSense() || (message.getRawDataSize() == 1 && message.getRawData()[0] == 0xff)) {
-                for (int i = 0; i < message.getRawDataSize(); ++i) {
-                    sendSysRealTime(device, static_cast<int>(message.getRawData()[i]));
-                }
+    setThis();
+    lockAudioThread();
+
+    // New [param~] objects don't know the current value yet
+    if (resendSignalParameters) {
+        resendSignalParameters = false;
+        for (auto* param : getParameters()) {
+            auto* pldParam = reinterpret_cast<PlugDataParameter*>(param);
+            if (!pldParam->isEnabled())
+                continue;
+
+            if (auto* receiver = pldParam->getSignalReceiverSymbol()->s_thing) {
+                pd_float(receiver, pldParam->getLastValue());
             }
+        }
+    }
+
+    if (parameterRampBlock < parameterRampLength) {
+        parameterRampBlock++;
+        auto const position = static_cast<float>(parameterRampBlock) / static_cast<float>(parameterRampLength);
 
-            for (int i = 0; i < message.getRawDataSize(); i++) {
-                sendMidiByte(device, static_cast<int>(message.getRawData()[i]));
+        for (int i = 0; i < numParameterRamps; i++) {
+            auto& [pldParam, start, target] = parameterRamps[i];
+            auto const value = parameterRampBlock == parameterRampLength ? target : start + (target - start) * position;
+
+            if (approximatelyEqual(pldParam->getLastValue(), value))
+                continue;
+
+            if (auto* receiver = pldParam->getReceiverSymbol()->s_thing) {
+                pd_float(receiver, value);
+            }
+            if (auto* receiver = pldParam->getSignalReceiverSymbol()->s_thing) {
+                pd_float(receiver, value);
             }
+            pldParam->setLastValue(value);
         }
+    }
+
+    // All parameters reached their target
+    if (parameterRampBlock == parameterRampLength)
+        numParameterRamps = 0;
+
+    unlockAudioThread();
+}
+
+void PluginProcessor::dspChainChanged()
+{
+    resendSignalParameters = true;
+}
+
+void PluginProcessor::sendMidiBuffer()
+{
+    if (acceptsMidi()) {
+        sendMidiEvents(midiBufferIn);
         midiBufferIn.clear();
     }
 }
@@ -959,41 +1449,22 @@ void PluginProcessor::getStateInformation(MemoryBlock& destData)
 
     savePatchTabPositions();
 
-    // Store pure-data and parameter state
-    MemoryOutputStream ostream(destData, false);
-
-    ostream.writeInt(patches.size());
-
-    // Save path and content for patch
-    lockAudioThread();
-
-    auto presetDir = ProjectInfo::appDataDir.getChildFile("Extra").getChildFile("Presets");
-
     auto patchesTree = new XmlElement("Patches");
 
     for (auto const& patch : patches) {
-
+        // Only hold the audio lock while we serialise one patch, so the audio thread can get in between patches
+        lockAudioThread();
         auto content = patch->getCanvasContent();
-        auto patchFile = patch->getCurrentFile().getFullPathName();
-
-        // Write legacy format
-        ostream.writeString(content);
-        ostream.writeString(patchFile);
+        unlockAudioThread();
 
         auto* patchTree = new XmlElement("Patch");
-        // Write new format
         patchTree->setAttribute("Content", content);
-        patchTree->setAttribute("Location", patchFile);
+        patchTree->setAttribute("Location", patch->getCurrentFile().getFullPathName());
         patchTree->setAttribute("PluginMode", patch->openInPluginMode);
         patchTree->setAttribute("SplitIndex", patch->splitViewIndex);
 
         patchesTree->addChildElement(patchTree);
     }
-    unlockAudioThread();
-
-    ostream.writeInt(getLatencySamples());
-    ostream.writeInt(oversampling);
-    ostream.writeFloat(getValue<float>(tailLength));
 
     auto xml = XmlElement("plugdata_save");
     xml.setAttribute("Version", PLUGDATA_VERSION);
@@ -1001,8 +1472,12 @@ void PluginProcessor::getStateInformation(MemoryBlock& destData)
     // In the future, we're gonna load everything from xml, to make it easier to add new properties
     // By putting this here, we can prepare for making this change without breaking existing DAW saves
     xml.setAttribute("Oversampling", oversampling);
+    xml.setAttribute("OversamplingFilter", oversamplingFilter);
+    xml.setAttribute("BlockSize", Instance::getBlockSize());
     xml.setAttribute("Latency", getLatencySamples());
     xml.setAttribute("TailLength", getValue<float>(tailLength));
+    xml.setAttribute("AutoSleep", dspSleepDetector.isEnabled());
+    xml.setAttribute("RenderAhead", renderAheadEnabled);
     xml.setAttribute("Legacy", false);
 
     // TODO: make multi-window friendly
@@ -1030,8 +1505,21 @@ void PluginProcessor::getStateInformation(MemoryBlock& destData)
     MemoryBlock xmlBlock;
     copyXmlToBinary(xml, xmlBlock);
 
-    ostream.writeInt(static_cast<int>(xmlBlock.getSize()));
-    ostream.write(xmlBlock.getData(), xmlBlock.getSize());
+    // Store pure-data and parameter state
+    // Big states are compressed, patches with saved arrays compress very well
+    auto const shouldCompress = xmlBlock.getSize() > minCompressedStateSize;
+
+    MemoryOutputStream ostream(destData, false);
+    ostream.writeInt(compactStateMagic);
+    ostream.writeInt(compactStateVersion);
+    ostream.writeInt(shouldCompress ? compressedStateFlag : 0);
+
+    if (shouldCompress) {
+        GZIPCompressorOutputStream gzip(ostream, 3);
+        gzip.write(xmlBlock.getData(), xmlBlock.getSize());
+    } else {
+        ostream.write(xmlBlock.getData(), xmlBlock.getSize());
+    }
 
     // then detach extraData XmlElement from temporary tree xml for later re-use
     if (extraDataStored) {
@@ -1044,49 +1532,58 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
     if (sizeInBytes == 0)
         return;
     
-    // Don't clear tabs if there is no editor open before loading state, if we don't check this it will not load properly in some DAWs
-    if(getEditors().size()) {
-        // Close any opened patches
-        MessageManager::callAsync([this]() {
-            for (auto* editor : getEditors()) {
-                for (auto split : editor->splitView.splits) {
-                    split->getTabComponent()->clearTabs();
-                }
-                editor->canvases.clear();
-            }
-        });
-    }
-
     MemoryInputStream istream(data, sizeInBytes, false);
     
     lockAudioThread();
 
     setThis();
-    patches.clear();
 
-    int numPatches = istream.readInt();
+    Array<std::pair<String, File>> legacyPatches;
+    int legacyLatency = 0;
+    int legacyOversampling = 0;
+    float legacyTail = 0.0f;
+    std::unique_ptr<XmlElement> xmlState;
 
-    Array<std::pair<String, File>> patches;
+    if (istream.readInt() == compactStateMagic) {
+        auto const version = istream.readInt();
+        auto const flags = istream.readInt();
 
-    for (int i = 0; i < numPatches; i++) {
-        auto state = istream.readString();
-        auto path = istream.readString();
+        MemoryBlock xmlBlock;
+        if (flags & compressedStateFlag) {
+            GZIPDecompressorInputStream gzip(istream);
+            gzip.readIntoMemoryBlock(xmlBlock);
+        } else {
+            istream.readIntoMemoryBlock(xmlBlock);
+        }
 
-        auto presetDir = ProjectInfo::appDataDir.getChildFile("Extra").getChildFile("Presets");
-        path = path.replace("${PRESET_DIR}", presetDir.getFullPathName());
-        patches.add({ state, File(path) });
-    }
+        // A future version could be saved by a newer plugdata, we can still read the xml if the layout didn't change
+        ignoreUnused(version);
+        xmlState = getXmlFromBinary(xmlBlock.getData(), static_cast<int>(xmlBlock.getSize()));
+    } else {
+        // Legacy format, which has all patches twice
+        istream.setPosition(0);
+
+        int numPatches = istream.readInt();
 
-    auto legacyLatency = istream.readInt();
-    auto legacyOversampling = istream.readInt();
-    auto legacyTail = istream.readFloat();
+        for (int i = 0; i < numPatches; i++) {
+            auto state = istream.readString();
+            auto path = istream.readString();
+
+            auto presetDir = ProjectInfo::appDataDir.getChildFile("Extra").getChildFile("Presets");
+            path = path.replace("${PRESET_DIR}", presetDir.getFullPathName());
+            legacyPatches.add({ state, File(path) });
+        }
 
-    auto xmlSize = istream.readInt();
+        legacyLatency = istream.readInt();
+        legacyOversampling = istream.readInt();
+        legacyTail = istream.readFloat();
 
-    auto* xmlData = new char[xmlSize];
-    istream.read(xmlData, xmlSize);
+        auto xmlSize = istream.readInt();
 
-    std::unique_ptr<XmlElement> xmlState(getXmlFromBinary(xmlData, xmlSize));
+        MemoryBlock xmlBlock;
+        istream.readIntoMemoryBlock(xmlBlock, xmlSize);
+        xmlState = getXmlFromBinary(xmlBlock.getData(), static_cast<int>(xmlBlock.getSize()));
+    }
 
     auto openPatch = [this](String const& content, File const& location, bool pluginMode = false, int splitIndex = 0) {
         if (location.getFullPathName().isNotEmpty() && location.existsAsFile()) {
@@ -1115,47 +1612,120 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
     };
 
     if (xmlState) {
+        struct PatchState {
+            String content;
+            File location;
+            bool pluginMode = false;
+            int splitIndex = 0;
+        };
+
+        Array<PatchState> patchStates;
+
         // If xmltree contains new patch format, use that
         if (auto* patchTree = xmlState->getChildByName("Patches")) {
             for (auto p : patchTree->getChildWithTagNameIterator("Patch")) {
-                auto content = p->getStringAttribute("Content");
                 auto location = p->getStringAttribute("Location");
-                auto pluginMode = p->getBoolAttribute("PluginMode");
-
-                int splitIndex = 0;
-                if (p->hasAttribute("SplitIndex")) {
-                    splitIndex = p->getIntAttribute("SplitIndex");
-                }
 
                 auto presetDir = ProjectInfo::versionDataDir.getChildFile("Extra").getChildFile("Presets");
                 location = location.replace("${PRESET_DIR}", presetDir.getFullPathName());
 
-                openPatch(content, location, pluginMode, splitIndex);
+                patchStates.add({ p->getStringAttribute("Content"), File(location), p->getBoolAttribute("PluginMode"), p->getIntAttribute("SplitIndex", 0) });
             }
         }
         // Otherwise, load from legacy format
         else {
-            for (auto& [content, location] : patches) {
-                openPatch(content, location);
+            for (auto& [content, location] : legacyPatches) {
+                patchStates.add({ content, location });
+            }
+        }
+
+        // DAWs often send us the state we already have, like when a project is opened or a preset is selected again
+        // Patches that are still the same stay open, we only reload the ones that changed
+        Array<pd::Patch::Ptr> unchangedPatches;
+        Array<bool> isUnchanged;
+        isUnchanged.insertMultiple(0, false, patchStates.size());
+        for (auto const& patch : patches) {
+            auto const contentHash = patch->getCanvasContent().hashCode64();
+            for (int i = 0; i < patchStates.size(); i++) {
+                auto const& state = patchStates.getReference(i);
+                // Patches that were loaded from their content instead of a file don't have a current file
+                auto const expectedFile = state.location.existsAsFile() ? state.location : File();
+                if (!isUnchanged[i] && expectedFile == patch->getCurrentFile() && state.pluginMode == patch->openInPluginMode && state.splitIndex == patch->splitViewIndex && state.content.hashCode64() == contentHash) {
+                    isUnchanged.set(i, true);
+                    unchangedPatches.add(patch);
+                    break;
+                }
             }
         }
 
+        patches.removeIf([&unchangedPatches](pd::Patch::Ptr const& patch) { return !unchangedPatches.contains(patch); });
+
+        // Don't clear tabs if there is no editor open before loading state, if we don't check this it will not load properly in some DAWs
+        if (getEditors().size()) {
+            MessageManager::callAsync([this, unchangedPatches]() {
+                for (auto* editor : getEditors()) {
+                    // Close any opened patches
+                    if (unchangedPatches.isEmpty()) {
+                        for (auto split : editor->splitView.splits) {
+                            split->getTabComponent()->clearTabs();
+                        }
+                        editor->canvases.clear();
+                        continue;
+                    }
+
+                    // Close the tabs of the patches we reloaded, including their subpatches
+                    Array<Canvas*> canvasesToClose;
+                    lockAudioThread();
+                    for (auto* cnv : editor->canvases) {
+                        auto* root = cnv->patch.getPointer().get();
+                        while (root && root->gl_owner)
+                            root = root->gl_owner;
+
+                        auto const isUnchanged = std::any_of(unchangedPatches.begin(), unchangedPatches.end(), [root](pd::Patch::Ptr const& patch) { return root && patch->getPointer().get() == root; });
+                        if (!isUnchanged)
+                            canvasesToClose.add(cnv);
+                    }
+                    unlockAudioThread();
+
+                    for (auto* cnv : canvasesToClose) {
+                        editor->closeTab(cnv);
+                    }
+                }
+            });
+        }
+
+        for (int i = 0; i < patchStates.size(); i++) {
+            if (isUnchanged[i])
+                continue;
+
+            auto const& state = patchStates.getReference(i);
+            openPatch(state.content, state.location, state.pluginMode, state.splitIndex);
+        }
+
         jassert(xmlState);
 
         PlugDataParameter::loadStateInformation(*xmlState, getParameters());
 
         auto versionString = String("0.6.1"); // latest version that didn't have version inside the daw state
 
+        // Needs to happen before restoring latency, since changing the block size can increase the latency
+        setPdBlockSize(xmlState->getIntAttribute("BlockSize", Instance::getBlockSize()));
+
         if (!xmlState->hasAttribute("Legacy") || xmlState->getBoolAttribute("Legacy")) {
             setLatencySamples(legacyLatency);
             setOversampling(legacyOversampling);
             tailLength = legacyTail;
         } else {
+            setOversamplingFilter(xmlState->getIntAttribute("OversamplingFilter", 0));
             setOversampling(xmlState->getDoubleAttribute("Oversampling"));
             setLatencySamples(xmlState->getDoubleAttribute("Latency"));
             tailLength = xmlState->getDoubleAttribute("TailLength");
         }
 
+        dspSleepDetector.setSleepDelay(getValue<float>(tailLength));
+        dspSleepDetector.setEnabled(xmlState->getBoolAttribute("AutoSleep", false));
+        setRenderAhead(xmlState->getBoolAttribute("RenderAhead", false));
+
         if (xmlState->hasAttribute("Version")) {
             versionString = xmlState->getStringAttribute("Version");
         }
@@ -1181,8 +1751,6 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
 
     unlockAudioThread();
 
-    delete[] xmlData;
-
     MessageManager::callAsync([this]() {
         for (auto* editor : getEditors()) {
             editor->sidebar->updateAutomationParameters();
@@ -1216,6 +1784,8 @@ pd::Patch::Ptr PluginProcessor::loadPatch(File const& patchFile, PluginEditor* e
         }
     }
 
+    auto const loadStartTime = Time::getMillisecondCounterHiRes();
+
     // Stop the audio callback when loading a new patch
     // TODO: why though?
     lockAudioThread();
@@ -1233,7 +1803,7 @@ pd::Patch::Ptr PluginProcessor::loadPatch(File const& patchFile, PluginEditor* e
     auto* patch = patches.getLast().get();
 
     if (editor) {
-        MessageManager::callAsync([this, patch, splitIndex, _editor = Component::SafePointer<PluginEditor>(editor)]() mutable {
+        MessageManager::callAsync([this, patch, splitIndex, loadStartTime, _editor = Component::SafePointer<PluginEditor>(editor)]() mutable {
             if (!_editor)
                 return;
             // There are some subroutines that get called when we create a canvas, that will lock the audio thread
@@ -1244,6 +1814,8 @@ pd::Patch::Ptr PluginProcessor::loadPatch(File const& patchFile, PluginEditor* e
 
             unlockAudioThread();
 
+            cnv->repaintCoordinator.measureTimeToFirstFrame(loadStartTime);
+
             _editor->addTab(cnv, splitIndex);
         });
     }
@@ -1284,9 +1856,33 @@ void PluginProcessor::setTheme(String themeToUse, bool force)
     lnf->setTheme(themeTree);
 
     for (auto* editor : getEditors()) {
-        editor->sendLookAndFeelChange();
+        notifyLookAndFeelChange(editor);
         editor->getTopLevelComponent()->repaint();
-        editor->repaint();
+    }
+}
+
+// Like Component::sendLookAndFeelChange, but without repainting every component separately
+// On large patches those repaints add up to thousands of dirty regions, so we repaint the whole window at once instead
+// Components that are buffered to an image invalidate that image in lookAndFeelChanged, since the window repaint doesn't
+void PluginProcessor::notifyLookAndFeelChange(Component* component)
+{
+    Component::SafePointer<Component> safePointer(component);
+
+    component->lookAndFeelChanged();
+    if (!safePointer)
+        return;
+
+    component->colourChanged();
+    if (!safePointer)
+        return;
+
+    for (int i = component->getNumChildComponents(); --i >= 0;) {
+        notifyLookAndFeelChange(component->getChildComponent(i));
+
+        if (!safePointer)
+            return;
+
+        i = std::min(i, component->getNumChildComponents());
     }
 }
 
@@ -1310,65 +1906,70 @@ Colour PluginProcessor::getTextColour()
     return lnf->findColour(PlugDataColour::toolbarTextColourId);
 }
 
-void PluginProcessor::receiveNoteOn(int const channel, int const pitch, int const velocity)
+int PluginProcessor::getMidiOutputPosition(int const sampleOffset) const
+{
+    return audioAdvancement + (sampleAccurateMidi ? sampleOffset : 0);
+}
+
+void PluginProcessor::receiveNoteOn(int const channel, int const pitch, int const velocity, int const sampleOffset)
 {
     auto device = (channel - 1) >> 4;
     auto deviceChannel = channel - (device * 16);
 
     if (velocity == 0) {
-        midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::noteOff(deviceChannel, pitch, uint8(0)), device), audioAdvancement);
+        midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::noteOff(deviceChannel, pitch, uint8(0)), device), getMidiOutputPosition(sampleOffset));
     } else {
-        midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::noteOn(deviceChannel, pitch, static_cast<uint8>(velocity)), device), audioAdvancement);
+        midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::noteOn(deviceChannel, pitch, static_cast<uint8>(velocity)), device), getMidiOutputPosition(sampleOffset));
     }
 }
 
-void PluginProcessor::receiveControlChange(int const channel, int const controller, int const value)
+void PluginProcessor::receiveControlChange(int const channel, int const controller, int const value, int const sampleOffset)
 {
     auto device = channel >> 4;
     auto deviceChannel = channel - (device * 16);
 
-    midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::controllerEvent(deviceChannel, controller, value), device), audioAdvancement);
+    midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::controllerEvent(deviceChannel, controller, value), device), getMidiOutputPosition(sampleOffset));
 }
 
-void PluginProcessor::receiveProgramChange(int const channel, int const value)
+void PluginProcessor::receiveProgramChange(int const channel, int const value, int const sampleOffset)
 {
     auto device = channel >> 4;
     auto deviceChannel = channel - (device * 16);
 
-    midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::programChange(deviceChannel, value), device), audioAdvancement);
+    midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::programChange(deviceChannel, value), device), getMidiOutputPosition(sampleOffset));
 }
 
-void PluginProcessor::receivePitchBend(int const channel, int const value)
+void PluginProcessor::receivePitchBend(int const channel, int const value, int const sampleOffset)
 {
     auto device = channel >> 4;
     auto deviceChannel = channel - (device * 16);
 
-    midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::pitchWheel(deviceChannel, value + 8192), device), audioAdvancement);
+    midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::pitchWheel(deviceChannel, value + 8192), device), getMidiOutputPosition(sampleOffset));
 }
 
-void PluginProcessor::receiveAftertouch(int const channel, int const value)
+void PluginProcessor::receiveAftertouch(int const channel, int const value, int const sampleOffset)
 {
     auto device = channel >> 4;
     auto deviceChannel = channel - (device * 16);
 
-    midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::channelPressureChange(deviceChannel, value), device), audioAdvancement);
+    midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::channelPressureChange(deviceChannel, value), device), getMidiOutputPosition(sampleOffset));
 }
 
-void PluginProcessor::receivePolyAftertouch(int const channel, int const pitch, int const value)
+void PluginProcessor::receivePolyAftertouch(int const channel, int const pitch, int const value, int const sampleOffset)
 {
     auto device = channel >> 4;
     auto deviceChannel = channel - (device * 16);
 
-    midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::aftertouchChange(deviceChannel, pitch, value), device), audioAdvancement);
+    midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::aftertouchChange(deviceChannel, pitch, value), device), getMidiOutputPosition(sampleOffset));
 }
 
-void PluginProcessor::receiveMidiByte(int const port, int const byte)
+void PluginProcessor::receiveMidiByte(int const port, int const byte, int const sampleOffset)
 {
     auto device = port >> 4;
 
     if (midiByteIsSysex) {
         if (byte == 0xf7) {
-            midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::createSysExMessage(midiByteBuffer, static_cast<int>(midiByteIndex)), device), audioAdvancement);
+            midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage::createSysExMessage(midiByteBuffer, static_cast<int>(midiByteIndex)), device), getMidiOutputPosition(sampleOffset));
             midiByteIndex = 0;
             midiByteIsSysex = false;
         } else {
@@ -1382,22 +1983,22 @@ void PluginProcessor::receiveMidiByte(int const port, int const byte)
     } else {
         // Handle single-byte messages
         if (midiByteIndex == 0 && byte >= 0xf8 && byte <= 0xff) {
-            midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage(static_cast<uint8>(byte)), device), audioAdvancement);
+            midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage(static_cast<uint8>(byte)), device), getMidiOutputPosition(sampleOffset));
         }
         // Handle 3-byte messages
         else {
             midiByteBuffer[midiByteIndex++] = static_cast<uint8>(byte);
             if (midiByteIndex >= 3) {
-                midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage(midiByteBuffer, 3), device), audioAdvancement);
+                midiBufferOut.addEvent(MidiDeviceManager::convertToSysExFormat(MidiMessage(midiByteBuffer, 3), device), getMidiOutputPosition(sampleOffset));
                 midiByteIndex = 0;
             }
         }
     }
 }
 
-void PluginProcessor::receiveSysMessage(String const& selector, std::vector<pd::Atom> const& list)
+void PluginProcessor::receiveSysMessage(t_symbol* selector, std::span<pd::Atom const> list)
 {
-    switch (hash(selector)) {
+    switch (hash(selector->s_name)) {
     case hash("open"): {
         if (list.size() >= 2) {
             auto filename = list[0].toString();
@@ -1429,10 +2030,27 @@ void PluginProcessor::receiveSysMessage(String const& selector, std::vector<pd::
             });
         break;
     }
+    case hash("trace"): {
+        // [; pd trace 1( starts recording a trace, [; pd trace 0( stops and exports it
+        if (list.empty() || list[0].getFloat() != 0.0f) {
+            Tracing::setRecording(true);
+            logMessage("Recording trace");
+        } else if (Tracing::isRecording()) {
+            MessageManager::callAsync([this]() {
+                auto traceFile = Tracing::getDefaultTraceFile();
+                if (Tracing::exportToFile(traceFile)) {
+                    logMessage("Saved trace to " + traceFile.getFullPathName());
+                } else {
+                    logError("Failed to save trace to " + traceFile.getFullPathName());
+                }
+            });
+        }
+        break;
+    }
     case hash("quit"):
     case hash("verifyquit"): {
         if (ProjectInfo::isStandalone) {
-            bool askToSave = hash(selector) == hash("verifyquit");
+            bool askToSave = hash(selector->s_name) == hash("verifyquit");
             MessageManager::callAsync(
                 [this, askToSave]() mutable {
                     // TODO: make multi-window friendly
@@ -1448,10 +2066,33 @@ void PluginProcessor::receiveSysMessage(String const& selector, std::vector<pd::
     }
 }
 
-void PluginProcessor::addTextToTextEditor(unsigned long ptr, String text)
+void PluginProcessor::addTextToTextEditor(unsigned long ptr, char const* text)
 {
-    Dialogs::appendTextToTextEditorDialog(textEditorDialogs[ptr].get(), text);
+    // Editors get their contents in many small chunks, so we collect them and add them in one go
+    bool needsUpdate;
+    {
+        ScopedLock lock(pendingEditorTextLock);
+        needsUpdate = pendingEditorText.empty();
+        pendingEditorText[ptr].write(text, strlen(text));
+    }
+
+    if (needsUpdate) {
+        MessageManager::callAsync([this]() {
+            std::map<unsigned long, MemoryOutputStream> pending;
+            {
+                ScopedLock lock(pendingEditorTextLock);
+                pending.swap(pendingEditorText);
+            }
+
+            for (auto& [editorPtr, editorText] : pending) {
+                if (auto it = textEditorDialogs.find(editorPtr); it != textEditorDialogs.end()) {
+                    Dialogs::appendTextToTextEditorDialog(it->second.get(), editorText.toUTF8());
+                }
+            }
+        });
+    }
 }
+
 void PluginProcessor::showTextEditor(unsigned long ptr, Rectangle<int> bounds, String title)
 {
     static std::unique_ptr<Dialog> saveDialog = nullptr;
@@ -1470,55 +2111,15 @@ void PluginProcessor::showTextEditor(unsigned long ptr, Rectangle<int> bounds, S
                     pd_typedmess(reinterpret_cast<t_pd*>(ptr), gensym("clear"), 0, NULL);
                     unlockAudioThread();
 
-                    // remove repeating spaces
-                    text = text.replace("\r ", "\r");
-                    text = text.replace(";\r", ";");
-                    text = text.replace("\r;", ";");
-                    text = text.replace(" ;", ";");
-                    text = text.replace("; ", ";");
-                    text = text.replace(",", " , ");
-                    text = text.replaceCharacters("\r", " ");
-
-                    while (text.contains("  ")) {
-                        text = text.replace("  ", " ");
-                    }
-                    text = text.trimStart();
-                    auto lines = StringArray::fromTokens(text, ";", "\"");
-
-                    int count = 0;
-                    for (auto const& line : lines) {
-                        count++;
-                        auto words = StringArray::fromTokens(line, " ", "\"");
-
-                        auto atoms = std::vector<t_atom>();
-                        atoms.reserve(words.size() + 1);
-
-                        for (auto const& word : words) {
-                            atoms.emplace_back();
-                            // check if string is a valid number
-                            auto charptr = word.getCharPointer();
-                            auto ptr = charptr;
-                            CharacterFunctions::readDoubleValue(ptr); // Removes double value from char*
-                            if (*charptr == ',') {
-                                SETCOMMA(&atoms.back());
-                            } else if (ptr - charptr == word.getNumBytesAsUTF8() && ptr - charptr != 0) {
-                                SETFLOAT(&atoms.back(), word.getFloatValue());
-                            } else {
-                                SETSYMBOL(&atoms.back(), generateSymbol(word));
-                            }
-                        }
-
-                        if (count != lines.size()) {
-                            atoms.emplace_back();
-                            SETSEMI(&atoms.back());
-                        }
-
-                        lockAudioThread();
+                    // Parse the whole text at once, and send it as a single line
+                    auto* contents = binbuf_new();
+                    pd::Interface::setBinbufText(contents, text);
 
-                        pd_typedmess(reinterpret_cast<t_pd*>(ptr), gensym("addline"), atoms.size(), atoms.data());
+                    lockAudioThread();
+                    pd_typedmess(reinterpret_cast<t_pd*>(ptr), gensym("addline"), binbuf_getnatom(contents), binbuf_getvec(contents));
+                    unlockAudioThread();
 
-                        unlockAudioThread();
-                    }
+                    binbuf_free(contents);
 
                     t_atom fake_path;
                     SETSYMBOL(&fake_path, generateSymbol(title.toRawUTF8()));
@@ -1539,48 +2140,70 @@ void PluginProcessor::showTextEditor(unsigned long ptr, Rectangle<int> bounds, S
     }));
 }
 
-void PluginProcessor::performParameterChange(int type, String const& name, float value)
+void PluginProcessor::performParameterChange(int type, t_symbol* name, float value)
 {
+    auto* pldParam = findParameter(name);
+    if (!pldParam || !pldParam->isEnabled())
+        return;
+
     // Type == 1 means it sets the change gesture state
     if (type) {
-        for (auto* param : getParameters()) {
-            auto* pldParam = dynamic_cast<PlugDataParameter*>(param);
-
-            if (!pldParam->isEnabled() || pldParam->getTitle() != name)
-                continue;
+        if (pldParam->getGestureState() == value) {
+            logMessage("parameter change " + String::fromUTF8(name->s_name) + (value ? " already started" : " not started"));
+        } else {
+            pldParam->setGestureState(value);
+        }
+    } else { // otherwise set parameter value
+        // Send new value to DAW
+        pldParam->setUnscaledValueNotifyingHost(value);
 
-            if (pldParam->getGestureState() == value) {
-                logMessage("parameter change " + name + (value ? " already started" : " not started"));
-            } else if (pldParam->isEnabled() && pldParam->getTitle() == name) {
-                pldParam->setGestureState(value);
+        if (ProjectInfo::isStandalone) {
+            for (auto* editor : getEditors()) {
+                editor->sidebar->updateAutomationParameters();
             }
         }
-    } else { // otherwise set parameter value
-        for (auto* param : getParameters()) {
-            auto* pldParam = dynamic_cast<PlugDataParameter*>(param);
-            if (!pldParam->isEnabled() || pldParam->getTitle() != name)
-                continue;
+    }
+}
 
-            // Update values in automation panel
-            // if (pldParam->getLastValue() == value)
-            //    return;
+PlugDataParameter* PluginProcessor::findParameter(String const& name)
+{
+    SpinLock::ScopedLockType lock(parameterIndexLock);
+    auto it = parametersByName.find(name);
+    return it != parametersByName.end() ? it->second : nullptr;
+}
 
-            // pldParam->setLastValue(value);
+PlugDataParameter* PluginProcessor::findParameter(t_symbol* name)
+{
+    // Every parameter name is in here, so a symbol we can't find isn't a parameter
+    SpinLock::ScopedLockType lock(parameterIndexLock);
+    auto it = parametersBySymbol.find(name);
+    return it != parametersBySymbol.end() ? it->second : nullptr;
+}
 
-            // Send new value to DAW
-            pldParam->setUnscaledValueNotifyingHost(value);
+void PluginProcessor::parameterRenamed(PlugDataParameter* parameter, String const& oldName, String const& newName)
+{
+    // Symbols can only be created once the Pd instance exists, the constructor adds them after that
+    auto* oldSymbol = instance && oldName.isNotEmpty() ? generateSymbol(oldName) : nullptr;
+    auto* newSymbol = instance ? generateSymbol(newName) : nullptr;
 
-            if (ProjectInfo::isStandalone) {
-                for (auto* editor : getEditors()) {
-                    editor->sidebar->updateAutomationParameters();
-                }
-            }
-        }
-    }
+    SpinLock::ScopedLockType lock(parameterIndexLock);
+
+    // Another parameter could have had the same name, if an old session contained duplicates
+    auto it = parametersByName.find(oldName);
+    if (it != parametersByName.end() && it->second == parameter)
+        parametersByName.erase(it);
+
+    parametersByName[newName] = parameter;
+
+    if (auto symbolIt = parametersBySymbol.find(oldSymbol); oldSymbol && symbolIt != parametersBySymbol.end() && symbolIt->second == parameter)
+        parametersBySymbol.erase(symbolIt);
+
+    if (newSymbol)
+        parametersBySymbol[newSymbol] = parameter;
 }
 
 // JYG added this
-void PluginProcessor::fillDataBuffer(std::vector<pd::Atom> const& vec)
+void PluginProcessor::fillDataBuffer(std::span<pd::Atom const> vec)
 {
     if (!vec[0].isSymbol()) {
         logMessage("databuffer accepts only lists beginning with a Symbol atom");
@@ -1598,7 +2221,27 @@ void PluginProcessor::fillDataBuffer(std::vector<pd::Atom> const& vec)
                 extraData->removeChildElement(list, true);
         }
         XmlElement* list = extraData->createNewChildElement(child_name);
-        if (list) {
+        if (list && vec.size() > maxAtomsPerAttribute) {
+            // Large lists, like tables or sequences, are stored as one binary blob instead of an attribute per atom
+            // If everything after the name is a float, we can store them as raw floats
+            auto const onlyFloats = std::all_of(vec.begin() + 1, vec.end(), [](pd::Atom const& atom) { return atom.isFloat(); });
+
+            MemoryOutputStream blob;
+            for (size_t i = 1; i < vec.size(); ++i) {
+                if (onlyFloats) {
+                    blob.writeFloat(vec[i].getFloat());
+                } else if (vec[i].isFloat()) {
+                    blob.writeByte('f');
+                    blob.writeFloat(vec[i].getFloat());
+                } else {
+                    blob.writeByte('s');
+                    blob.writeString(vec[i].isSymbol() ? String(vec[i].toString()) : String("unknown"));
+                }
+            }
+
+            list->setAttribute("string1", child_name);
+            list->setAttribute(onlyFloats ? "floats" : "atoms", Base64::toBase64(blob.getData(), blob.getDataSize()));
+        } else if (list) {
             for (size_t i = 0; i < vec.size(); ++i) {
                 if (vec[i].isFloat()) {
                     list->setAttribute(String("float") + String(i + 1), vec[i].getFloat());
@@ -1628,6 +2271,31 @@ void PluginProcessor::parseDataBuffer(XmlElement const& xml)
         for (int i = 0; i < nlists; ++i) {
             XmlElement const* list = extra_data->getChildElement(i);
             if (list) {
+                // Large lists are stored as a binary blob after the name, see fillDataBuffer
+                if (list->hasAttribute("floats") || list->hasAttribute("atoms")) {
+                    auto const onlyFloats = list->hasAttribute("floats");
+                    MemoryOutputStream blob;
+                    Base64::convertFromBase64(blob, list->getStringAttribute(onlyFloats ? "floats" : "atoms"));
+
+                    vec.clear();
+                    vec.emplace_back(generateSymbol(list->getStringAttribute("string1")));
+                    if (onlyFloats)
+                        vec.reserve(blob.getDataSize() / sizeof(float) + 1);
+
+                    MemoryInputStream stream(blob.getData(), blob.getDataSize(), false);
+                    while (!stream.isExhausted()) {
+                        if (onlyFloats || stream.readByte() == 'f') {
+                            vec.emplace_back(stream.readFloat());
+                        } else {
+                            vec.emplace_back(generateSymbol(stream.readString()));
+                        }
+                    }
+
+                    sendList("from_daw_databuffer", vec);
+                    loaded = true;
+                    continue;
+                }
+
                 int const natoms = list->getNumAttributes();
                 vec.resize(natoms);
 
@@ -1660,6 +2328,28 @@ void PluginProcessor::updateConsole(int numMessages, bool newWarning)
     }
 }
 
+void PluginProcessor::registerCanvas(Canvas* cnv, t_canvas* patchPtr)
+{
+    openCanvases.emplace(patchPtr, cnv);
+}
+
+void PluginProcessor::unregisterCanvas(Canvas* cnv, t_canvas* patchPtr)
+{
+    auto [first, last] = openCanvases.equal_range(patchPtr);
+    for (auto it = first; it != last; ++it) {
+        if (it->second == cnv) {
+            openCanvases.erase(it);
+            return;
+        }
+    }
+}
+
+Canvas* PluginProcessor::getCanvasForPatch(t_canvas* patchPtr) const
+{
+    auto it = openCanvases.find(patchPtr);
+    return it != openCanvases.end() ? it->second : nullptr;
+}
+
 Array<PluginEditor*> PluginProcessor::getEditors() const
 {
     Array<PluginEditor*> editors;
@@ -1678,35 +2368,92 @@ Array<PluginEditor*> PluginProcessor::getEditors() const
 
 void PluginProcessor::reloadAbstractions(File changedPatch, t_glist* except)
 {
+    // Multiple saves of the same file will only cause a single reload
+    pendingAbstractionReloads[changedPatch.getFullPathName()] = { changedPatch, except };
+    abstractionReloadTimer.startTimer(AbstractionReloadTimer::debounceTime);
+}
+
+void PluginProcessor::performAbstractionReload()
+{
+    if (pendingAbstractionReloads.empty())
+        return;
+
+    auto reloads = std::move(pendingAbstractionReloads);
+    pendingAbstractionReloads.clear();
+
+    sys_lock();
     setThis();
 
-    // Ensure that all messages are dequeued before we start deleting objects
-    sendMessagesFromQueue();
+    // Ensure that all commands are dequeued before we start deleting objects
+    sendCommandsFromQueue();
 
     isPerformingGlobalSync = true;
 
-    pd::Patch::reloadPatch(changedPatch, except);
+    auto const isReloadedAbstraction = [&reloads](t_glist* glist) {
+        if (!canvas_isabstraction(glist))
+            return false;
+
+        auto path = File(String::fromUTF8(canvas_getdir(glist)->s_name)).getChildFile(String::fromUTF8(glist->gl_name->s_name)).withFileExtension("pd");
+        return reloads.count(path.getFullPathName()) > 0;
+    };
 
-    for (auto* editor : getEditors()) {
+    std::function<bool(t_glist*)> containsReloadedAbstraction = [&](t_glist* glist) {
+        for (t_gobj* y = glist->gl_list; y; y = y->g_next) {
+            // The instances of a clone are abstractions too, but they're not in the gl_list
+            if (pd_class(&y->g_pd) == clone_class) {
+                for (int i = 0; i < clone_get_n(y); i++) {
+                    auto* instance = clone_get_instance(y, i);
+                    if (isReloadedAbstraction(instance) || containsReloadedAbstraction(instance))
+                        return true;
+                }
+                continue;
+            }
+
+            if (pd_class(&y->g_pd) != canvas_class)
+                continue;
 
-        // Synchronising can potentially delete some other canvases, so make sure we use a safepointer
-        Array<Component::SafePointer<Canvas>> canvases;
+            auto* subpatch = reinterpret_cast<t_glist*>(y);
+            if (isReloadedAbstraction(subpatch) || containsReloadedAbstraction(subpatch))
+                return true;
+        }
+        return false;
+    };
 
-        for (auto* canvas : editor->canvases) {
-            canvases.add(canvas);
+    // Find the canvases that will be affected by the reload before we reload, because reloading will delete the reloaded abstractions
+    // Synchronising can potentially delete some other canvases, so make sure we use a safepointer
+    Array<Component::SafePointer<Canvas>> affectedCanvases;
+    for (auto& [patch, cnv] : openCanvases) {
+        bool affected = containsReloadedAbstraction(patch);
+        for (auto* glist = patch; glist && !affected; glist = glist->gl_owner) {
+            affected = isReloadedAbstraction(glist);
         }
 
-        for (auto& cnv : canvases) {
-            if (cnv.getComponent()) {
-                cnv->synchronise();
-                cnv->handleUpdateNowIfNeeded();
-            }
+        if (affected)
+            affectedCanvases.add(cnv);
+    }
+
+    // Every reloaded abstraction instance would otherwise rebuild the DSP chain
+    {
+        pd::Patch::ScopedDspSuspend dspSuspend;
+        for (auto& [path, reload] : reloads) {
+            pd::Patch::reloadPatch(reload.first, reload.second);
+        }
+    }
+
+    for (auto& cnv : affectedCanvases) {
+        if (cnv.getComponent()) {
+            cnv->synchronise();
+            cnv->handleUpdateNowIfNeeded();
         }
+    }
 
+    for (auto* editor : getEditors()) {
         editor->updateCommandStatus();
     }
 
     isPerformingGlobalSync = false;
+
+    sys_unlock();
 }
 
 void PluginProcessor::titleChanged()
@@ -12,7 +12,12 @@
 #include "Utility/Config.h"
 #include "Utility/Limiter.h"
 #include "Utility/SettingsFile.h"
-#include <Utility/AudioMidiFifo.h>
+#include "Utility/PdBlockFifo.h"
+#include "Utility/AnticipatoryRenderer.h"
+#include "Utility/DeadlineMonitor.h"
+#include "Utility/DspSleepDetector.h"
+#include "Utility/RealtimeWorkerPool.h"
+#include "Utility/FilesystemExtractor.h"
 
 #include "Pd/Instance.h"
 #include "Pd/Patch.h"
@@ -24,11 +29,13 @@ class Library;
 class InternalSynth;
 class SettingsFile;
 class StatusbarSource;
+class PlugDataParameter;
 struct PlugDataLook;
 class PluginEditor;
-class ConnectionMessageDisplay;
+class Canvas;
 class PluginProcessor : public AudioProcessor
-    , public pd::Instance, public SettingsFileListener {
+    , public pd::Instance, public SettingsFileListener
+    , public Value::Listener {
 public:
     PluginProcessor();
 
@@ -37,9 +44,13 @@ public:
     static AudioProcessor::BusesProperties buildBusesProperties();
 
     void setOversampling(int amount);
+    void setOversamplingFilter(int filterType);
+    void setAutoSleep(bool enabled);
+    void setPdBlockSize(int blockSize);
     void setProtectedMode(bool enabled);
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
+    void setNonRealtime(bool shouldBeNonRealtime) noexcept override;
 
 #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported(BusesLayout const& layouts) const override;
@@ -66,24 +77,32 @@ public:
     void getStateInformation(MemoryBlock& destData) override;
     void setStateInformation(void const* data, int sizeInBytes) override;
 
-    void receiveNoteOn(int channel, int pitch, int const velocity) override;
-    void receiveControlChange(int channel, int controller, int value) override;
-    void receiveProgramChange(int channel, int value) override;
-    void receivePitchBend(int channel, int value) override;
-    void receiveAftertouch(int channel, int value) override;
-    void receivePolyAftertouch(int channel, int pitch, int value) override;
-    void receiveMidiByte(int port, int byte) override;
-    void receiveSysMessage(String const& selector, std::vector<pd::Atom> const& list) override;
-
-    void addTextToTextEditor(unsigned long ptr, String text) override;
+    // The state starts with this instead of the number of patches in the legacy format
+    static constexpr int compactStateMagic = 0x50445354; // "PDST"
+    static constexpr int compactStateVersion = 1;
+    static constexpr int compressedStateFlag = 1;
+    static constexpr size_t minCompressedStateSize = 64 * 1024;
+
+    void receiveNoteOn(int channel, int pitch, int const velocity, int sampleOffset) override;
+    void receiveControlChange(int channel, int controller, int value, int sampleOffset) override;
+    void receiveProgramChange(int channel, int value, int sampleOffset) override;
+    void receivePitchBend(int channel, int value, int sampleOffset) override;
+    void receiveAftertouch(int channel, int value, int sampleOffset) override;
+    void receivePolyAftertouch(int channel, int pitch, int value, int sampleOffset) override;
+    void receiveMidiByte(int port, int byte, int sampleOffset) override;
+    void receiveSysMessage(t_symbol* selector, std::span<pd::Atom const> list) override;
+
+    void addTextToTextEditor(unsigned long ptr, char const* text) override;
     void showTextEditor(unsigned long ptr, Rectangle<int> bounds, String title) override;
 
     void updateConsole(int numMessages, bool newWarning) override;
 
     void reloadAbstractions(File changedPatch, t_glist* except) override;
+    void performAbstractionReload();
 
     void processConstant(dsp::AudioBlock<float>, MidiBuffer&);
     void processVariable(dsp::AudioBlock<float>, MidiBuffer&);
+    void processAhead(dsp::AudioBlock<float>, MidiBuffer&, bool inputFree);
 
     bool canAddBus(bool isInput) const override
     {
@@ -97,34 +116,56 @@ public:
     }
 
     void savePatchTabPositions();
-    void updatePatchUndoRedoState();
+    void updatePatchUndoRedoState(Array<pd::Patch::Ptr> const& patchesToUpdate);
         
     void settingsFileReloaded() override;
+    void searchPathsChanged() override;
+    void valueChanged(Value& v) override;
 
     void initialiseFilesystem();
     void updateSearchPaths();
+    static StringArray getSharedSearchPaths(ValueTree const& pathTree);
 
     void sendMidiBuffer();
     void sendPlayhead();
+    void collectParameterChanges(int numPdBlocks);
     void sendParameters();
+    void flagParameterChanged(int index);
+
+    void dspChainChanged() override;
 
     bool isInPluginMode();
 
     Array<PluginEditor*> getEditors() const;
 
-    void performParameterChange(int type, String const& name, float value) override;
+    // Keeps track of the canvas for every open patch, so we can find them without searching through all editors
+    void registerCanvas(Canvas* cnv, t_canvas* patchPtr);
+    void unregisterCanvas(Canvas* cnv, t_canvas* patchPtr);
+    Canvas* getCanvasForPatch(t_canvas* patchPtr) const;
+
+    void performParameterChange(int type, t_symbol* name, float value) override;
+
+    // Finds a parameter by its name without searching through all of them, or returns nullptr
+    // The index is kept up to date by PlugDataParameter::setName, it's safe to use from any thread
+    PlugDataParameter* findParameter(String const& name);
+    PlugDataParameter* findParameter(t_symbol* name);
+    void parameterRenamed(PlugDataParameter* parameter, String const& oldName, String const& newName);
 
     // Jyg added this
-    void fillDataBuffer(std::vector<pd::Atom> const& list) override;
+    void fillDataBuffer(std::span<pd::Atom const> list) override;
     void parseDataBuffer(XmlElement const& xml) override;
     std::unique_ptr<XmlElement> extraData;
 
+    // Lists longer than this are stored in extraData as a base64 blob
+    static constexpr size_t maxAtomsPerAttribute = 16;
+
     pd::Patch::Ptr loadPatch(String patch, PluginEditor* editor, int splitIndex = 0);
     pd::Patch::Ptr loadPatch(File const& patch, PluginEditor* editor, int splitIndex = 0);
 
     void titleChanged() override;
 
     void setTheme(String themeToUse, bool force = false);
+    static void notifyLookAndFeelChange(Component* component);
 
     Colour getForegroundColour() override;
     Colour getBackgroundColour() override;
@@ -152,16 +193,24 @@ public:
 
     // Just so we never have to deal with deleting the default LnF
     SharedResourcePointer<PlugDataLook> lnf;
+    SharedResourcePointer<FilesystemExtractor> filesystemExtractor;
 
     static inline constexpr int numParameters = 512;
+    int numExposedParameters = numParameters;
     static inline constexpr int numInputBuses = 16;
     static inline constexpr int numOutputBuses = 16;
 
     // Protected mode value will decide if we apply clipping to output and remove non-finite numbers
     std::atomic<bool> protectedMode = true;
 
+    // When enabled, MIDI is sent to and from Pd at the position of the 64-sample tick it belongs to, instead of at the start of the Pd block
+    std::atomic<bool> sampleAccurateMidi = true;
+
     // Zero means no oversampling
     std::atomic<int> oversampling = 0;
+
+    // 0 = polyphase IIR (low latency), 1 = FIR equiripple (linear phase, higher latency)
+    std::atomic<int> oversamplingFilter = 0;
     int lastLeftTab = -1;
     int lastRightTab = -1;
 
@@ -169,7 +218,17 @@ public:
     std::atomic<bool> enableInternalSynth = false;
 
     OwnedArray<PluginEditor> openedEditors;
-    Component::SafePointer<ConnectionMessageDisplay> connectionListener;
+
+    // Keeps track of blocks that took longer than the host's buffer period
+    DeadlineMonitor deadlineMonitor;
+
+    // Stops running Pd's DSP while the instance is idle, if enabled in the DAW settings
+    DspSleepDetector dspSleepDetector;
+
+    // While the patch doesn't consume any input (audio, MIDI, parameters, the playhead or the GUI), render it ahead on a background thread
+    // This adds a fixed amount of latency, also while the patch does get input and is rendered live
+    void setRenderAhead(bool enabled);
+    bool isRenderAheadEnabled() const { return renderAheadEnabled; }
 
 private:
     SmoothedValue<float, ValueSmoothingTypes::Linear> smoothedGain;
@@ -177,14 +236,13 @@ private:
     int audioAdvancement = 0;
 
     bool variableBlockSize = false;
-    AudioBuffer<float> audioBufferIn;
-    AudioBuffer<float> audioBufferOut;
 
-    std::vector<float> audioVectorIn;
-    std::vector<float> audioVectorOut;
+    // Channel pointers into the host buffer, offset by the current Pd block
+    std::vector<float*> channelPointers;
 
-    std::unique_ptr<AudioMidiFifo> inputFifo;
-    std::unique_ptr<AudioMidiFifo> outputFifo;
+    // Only used with a variable block size, Pd processes directly from the input fifo into the output fifo
+    PdBlockFifo inputFifo;
+    PdBlockFifo outputFifo;
 
     MidiBuffer midiBufferIn;
     MidiBuffer midiBufferOut;
@@ -192,24 +250,145 @@ private:
 
     AudioProcessLoadMeasurer cpuLoadMeasurer;
 
+    // Search paths and libraries that updateSearchPaths added to this instance, so settings reloads only apply what changed
+    StringArray appliedSearchPaths;
+    StringArray loadedLibraries;
+
+    int getMidiOutputPosition(int sampleOffset) const;
+
     bool midiByteIsSysex = false;
     uint8 midiByteBuffer[512] = { 0 };
     size_t midiByteIndex = 0;
 
-    std::vector<pd::Atom> atoms_playhead;
+    // Cached state for every playhead message, so we only need to send values that changed
+    enum PlayheadMessage {
+        PlayheadPlaying = 0,
+        PlayheadRecording,
+        PlayheadLooping,
+        PlayheadEditTime,
+        PlayheadFrameRate,
+        PlayheadBpm,
+        PlayheadLastBar,
+        PlayheadTimeSig,
+        PlayheadPosition,
+        NumPlayheadMessages
+    };
+
+    struct PlayheadState {
+        t_symbol* receiver = nullptr;
+        t_symbol* selector = nullptr;
+        t_atom atoms[3];
+        int numAtoms = 0;
+        bool needsUpdate = true;
+    };
+
+    void setPlayheadValue(PlayheadMessage type, std::initializer_list<float> values);
+
+    std::array<PlayheadState, NumPlayheadMessages> playheadState;
+    int playheadBlocksSinceResend = 0;
+    std::atomic<int> playheadResendInterval = 32;
+
+    // One bit per parameter (including volume), set whenever a parameter value changes
+    // This way, sendParameters only has to look at parameters that were actually touched
+    std::array<std::atomic<uint64>, (numParameters + 64) / 64> changedParameters;
+
+    // Host parameter changes are spread over the Pd blocks of a buffer, so automation isn't stepped at the host's buffer size
+    struct ParameterRamp {
+        PlugDataParameter* parameter;
+        float start;
+        float target;
+    };
+
+    std::array<ParameterRamp, numParameters + 1> parameterRamps;
+    int numParameterRamps = 0;
+    int parameterRampBlock = 0;
+    int parameterRampLength = 1;
+
+    // Set when the DSP chain changed, so new [param~] objects get the current values
+    bool resendSignalParameters = false;
+
+    // Name index for findParameter. The symbol map is kept up to date on rename, so lookups from the audio thread never insert or fall back to the names
+    // Parameters that are renamed before the Pd instance exists get their symbols once it's initialised
+    SpinLock parameterIndexLock;
+    std::unordered_map<String, PlugDataParameter*> parametersByName;
+    std::unordered_map<t_symbol*, PlugDataParameter*> parametersBySymbol;
+
+    bool hasChangedParameters() const
+    {
+        return std::any_of(changedParameters.begin(), changedParameters.end(), [](auto const& word) { return word.load(std::memory_order_relaxed) != 0; });
+    }
 
     int lastSetProgram = 0;
 
+    // Set when switching presets, so the output fades in again instead of jumping to the new sound
+    std::atomic<bool> fadeInAfterProgramChange = false;
+
     Limiter limiter;
     std::unique_ptr<dsp::Oversampling<float>> oversampler;
 
+    // Latency that was added to the reported latency by the oversampling filters
+    int oversamplingLatency = 0;
+
+    // What prepareToPlay last prepared for, if that didn't change it doesn't need to rebuild anything
+    struct DspConfiguration {
+        double sampleRate = 0.0;
+        int samplesPerBlock = 0;
+        int numInputs = 0;
+        int numOutputs = 0;
+        int pdBlockSize = 0;
+        int oversampling = 0;
+        int oversamplingFilter = 0;
+        bool renderAhead = false;
+        bool internalSynth = false;
+
+        bool operator==(DspConfiguration const& other) const = default;
+    };
+
+    DspConfiguration preparedConfiguration;
+
     std::map<unsigned long, std::unique_ptr<Component>> textEditorDialogs;
 
+    // Text sent to the editors since the last time they were updated
+    CriticalSection pendingEditorTextLock;
+    std::map<unsigned long, MemoryOutputStream> pendingEditorText;
+
+    std::unordered_multimap<t_canvas*, Canvas*> openCanvases;
+
+    // Saving a file can happen many times in a short period (for example when an external editor saves it),
+    // so we wait until the saves have settled and then reload every changed abstraction at once
+    struct AbstractionReloadTimer : public Timer {
+        explicit AbstractionReloadTimer(PluginProcessor& p)
+            : processor(p)
+        {
+        }
+
+        void timerCallback() override
+        {
+            stopTimer();
+            processor.performAbstractionReload();
+        }
+
+        PluginProcessor& processor;
+        static constexpr int debounceTime = 150;
+    };
+
+    AbstractionReloadTimer abstractionReloadTimer { *this };
+    std::map<String, std::pair<File, t_glist*>> pendingAbstractionReloads;
+
     static inline String const else_version = "ELSE v1.0-rc10";
     static inline String const cyclone_version = "cyclone v0.8-0";
     static inline String const heavylib_version = "heavylib v0.3.1";
     // this gets updated with live version data later
     static String pdlua_version;
 
+    bool renderAheadEnabled = false;
+    bool usingRenderAhead = false;
+    int renderAheadLatency = 0;
+    AudioBuffer<float> renderAheadBlock;
+    static constexpr int renderAheadBlocks = 8;
+
+    // Declared last, so its thread stops before anything it renders with is deleted
+    AnticipatoryRenderer anticipatoryRenderer;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginProcessor)
 };
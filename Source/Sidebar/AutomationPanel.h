@@ -68,11 +68,7 @@ public:
         settingsButton.setTooltip("Expand settings");
 
         settingsButton.onClick = [this]() mutable {
-            bool toggleState = settingsButton.getToggleState();
-
-            rangeProperty.setVisible(toggleState);
-            modeProperty.setVisible(toggleState);
-
+            setExpanded(settingsButton.getToggleState());
             getParentComponent()->resized();
         };
 
@@ -172,11 +168,6 @@ public:
         };
 
         nameLabel.onEditorHide = [this]() {
-            StringArray allNames;
-            for (auto* param : pd->getParameters()) {
-                allNames.add(dynamic_cast<PlugDataParameter*>(param)->getTitle());
-            }
-
             auto newName = nameLabel.getText(true);
             auto character = newName[0];
 
@@ -184,8 +175,9 @@ public:
             if ((character == '_' || character == '-'
                     || (character >= 'a' && character <= 'z')
                     || (character >= 'A' && character <= 'Z'))
-                && newName.containsOnly("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890_-") && !allNames.contains(newName) && newName.isNotEmpty()) {
-                param->setName(nameLabel.getText(true));
+                && newName.containsOnly("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890_-") && !isNameTaken(newName) && newName.isNotEmpty()) {
+                onRename(lastName, newName);
+                param->setName(newName);
                 param->notifyDAW();
             } else {
                 nameLabel.setText(lastName, dontSendNotification);
@@ -206,6 +198,13 @@ public:
         update();
     }
 
+    void setExpanded(bool expanded)
+    {
+        settingsButton.setToggleState(expanded, dontSendNotification);
+        rangeProperty.setVisible(expanded);
+        modeProperty.setVisible(expanded);
+    }
+
     void update()
     {
         lastName = param->getTitle();
@@ -370,6 +369,10 @@ public:
 
     std::function<void(AutomationItem*)> onDelete = [](AutomationItem*) {};
 
+    // Checked against the name index of the panel, so renaming doesn't have to look at all parameters
+    std::function<bool(String const&)> isNameTaken = [](String const&) { return false; };
+    std::function<void(String const&, String const&)> onRename = [](String const&, String const&) {};
+
     SmallIconButton deleteButton;
     ExpandButton settingsButton;
 
@@ -565,7 +568,7 @@ public:
                 if (!param->isEnabled()) {
                     param->setEnabled(true);
                     param->setName(getNewParameterName());
-                    param->setIndex(rows.size());
+                    param->setIndex(static_cast<int>(rows.size()));
                     param->notifyDAW();
                     break;
                 }
@@ -595,7 +598,7 @@ public:
     {
         if (draggedItem) {
             for (int p = 0; p < rows.size(); p++) {
-                rows[p]->param->setIndex(p);
+                rows[p].param->setIndex(p);
             }
             draggedItem = nullptr;
             shouldAnimate = true;
@@ -621,13 +624,19 @@ public:
         draggedItem->setTopLeftPosition(dragPos - accumulatedOffsetY);
         viewportPosY -= autoScrollOffset.getY();
 
-        int idx = rows.indexOf(draggedItem);
-        if (idx > 0 && draggedItem->getBounds().getCentreY() < rows[idx - 1]->getBounds().getCentreY() && rows[idx - 1]->isEnabled()) {
-            rows.swap(idx, idx - 1);
+        // Rows that aren't visible don't have a component, so we compare with the layout instead
+        auto it = std::find_if(rows.begin(), rows.end(), [this](Row const& row) { return row.item.get() == draggedItem.getComponent(); });
+        if (it == rows.end())
+            return;
+
+        auto idx = static_cast<int>(std::distance(rows.begin(), it));
+        auto const centreY = draggedItem->getBounds().getCentreY();
+        if (idx > 0 && centreY < rows[idx - 1].bounds.getCentreY() && rows[idx - 1].param->isEnabled()) {
+            std::swap(rows[idx], rows[idx - 1]);
             shouldAnimate = true;
             resized();
-        } else if (idx < rows.size() - 1 && draggedItem->getBounds().getCentreY() > rows[idx + 1]->getBounds().getCentreY() && rows[idx + 1]->isEnabled()) {
-            rows.swap(idx, idx + 1);
+        } else if (idx < static_cast<int>(rows.size()) - 1 && centreY > rows[idx + 1].bounds.getCentreY() && rows[idx + 1].param->isEnabled()) {
+            std::swap(rows[idx], rows[idx + 1]);
             shouldAnimate = true;
             resized();
         }
@@ -635,10 +644,10 @@ public:
 
     String getNewParameterName()
     {
-        StringArray takenNames;
-        for (auto* row : rows) {
-            if (row->isEnabled()) {
-                takenNames.add(row->param->getTitle());
+        std::unordered_set<String> takenNames;
+        for (auto& row : rows) {
+            if (row.param->isEnabled()) {
+                takenNames.insert(row.param->getTitle());
             }
         }
 
@@ -665,53 +674,20 @@ public:
     void updateSliders()
     {
         rows.clear();
+        parameterNames.clear();
 
         for (auto* param : getParameters()) {
+            parameterNames.insert(param->getTitle());
+
             if (param->isEnabled()) {
-                auto* slider = rows.add(new AutomationItem(param, parentComponent, pd));
-                addAndMakeVisible(slider);
-
-                slider->reorderButton.addMouseListener(this, false);
-
-                slider->onDelete = [this](AutomationItem* toDelete) {
-                    StringArray paramNames;
-
-                    for (auto* param : getParameters()) {
-                        if (param != toDelete->param) {
-                            paramNames.add(param->getTitle());
-                        }
-                    }
-
-                    auto toDeleteIdx = rows.indexOf(toDelete);
-                    for (int i = toDeleteIdx; i < rows.size(); i++) {
-                        rows[i]->param->setIndex(rows[i]->param->getIndex() - 1);
-                    }
-
-                    auto newParamName = String("param");
-                    int i = 1;
-                    while (paramNames.contains(newParamName + String(i))) {
-                        i++;
-                    }
-                    newParamName += String(i);
-
-                    toDelete->param->setEnabled(false);
-                    toDelete->param->setName(newParamName);
-                    toDelete->param->setValue(0.0f);
-                    toDelete->param->setRange(0.0f, 1.0f);
-                    toDelete->param->setMode(PlugDataParameter::Float);
-                    toDelete->param->notifyDAW();
-
-                    updateSliders();
-                };
+                rows.push_back({ param });
             }
         }
 
-        std::sort(rows.begin(), rows.end(), [](auto* a, auto* b) {
-            return a->param->getIndex() < b->param->getIndex();
+        std::sort(rows.begin(), rows.end(), [](auto& a, auto& b) {
+            return a.param->getIndex() < b.param->getIndex();
         });
 
-        addParameterButton.toFront(false);
-
         checkMaxNumParameters();
         parentComponent->resized();
         resized();
@@ -719,43 +695,125 @@ public:
 
     void checkMaxNumParameters()
     {
-        addParameterButton.setVisible(rows.size() < PluginProcessor::numParameters);
+        addParameterButton.setVisible(rows.size() < pd->numExposedParameters);
     }
 
+    // Only the rows that are (nearly) visible in the viewport have a component, the others are created when they're scrolled into view
     void resized() override
     {
         auto& animator = Desktop::getInstance().getAnimator();
 
+        auto visibleArea = Rectangle<int>();
+        if (auto* viewport = findParentComponentOfClass<Viewport>()) {
+            auto viewArea = viewport->getViewArea();
+            visibleArea = viewArea.expanded(0, viewArea.getHeight() / 2);
+        }
+
         int y = 2;
         int width = getWidth();
-        for (int p = 0; p < rows.size(); p++) {
-            int height = rows[p]->getItemHeight();
-            if (rows[p] != draggedItem) {
-                auto bounds = Rectangle<int>(0, y, width, height);
-                if (shouldAnimate) {
-                    animator.animateComponent(rows[p], bounds, 1.0f, 200, false, 3.0f, 0.0f);
+        for (auto& row : rows) {
+            if (row.item)
+                row.expanded = row.item->settingsButton.getToggleState();
+
+            int height = getRowHeight(row);
+            row.bounds = Rectangle<int>(0, y, width, height);
+            y += height;
+
+            auto const isDragged = row.item && row.item.get() == draggedItem.getComponent();
+            if (!isDragged && !visibleArea.intersects(row.bounds)) {
+                row.item.reset();
+                continue;
+            }
+
+            auto const isNew = row.item == nullptr;
+            if (isNew)
+                createItem(row);
+
+            if (!isDragged) {
+                if (shouldAnimate && !isNew) {
+                    animator.animateComponent(row.item.get(), row.bounds, 1.0f, 200, false, 3.0f, 0.0f);
                 } else {
-                    animator.cancelAnimation(rows[p], false);
-                    rows[p]->setBounds(bounds);
+                    animator.cancelAnimation(row.item.get(), false);
+                    row.item->setBounds(row.bounds);
                 }
             }
-            y += height;
         }
 
         shouldAnimate = false;
         addParameterButton.setBounds(0, y, getWidth(), 28);
+        addParameterButton.toFront(false);
     }
 
     int getTotalHeight() const
     {
         int y = 30;
-        for (int p = 0; p < rows.size(); p++) {
-            y += rows[p]->getItemHeight();
+        for (auto& row : rows) {
+            y += getRowHeight(row);
         }
 
         return y;
     }
 
+    struct Row {
+        PlugDataParameter* param;
+        bool expanded = false;
+        Rectangle<int> bounds;
+        std::unique_ptr<AutomationItem> item;
+    };
+
+    static int getRowHeight(Row const& row)
+    {
+        return row.expanded ? 110 : 56;
+    }
+
+    void createItem(Row& row)
+    {
+        row.item = std::make_unique<AutomationItem>(row.param, parentComponent, pd);
+        auto* slider = row.item.get();
+        slider->setExpanded(row.expanded);
+        addAndMakeVisible(slider);
+
+        slider->reorderButton.addMouseListener(this, false);
+
+        slider->isNameTaken = [this](String const& name) {
+            return parameterNames.contains(name);
+        };
+
+        slider->onRename = [this](String const& oldName, String const& newName) {
+            parameterNames.erase(oldName);
+            parameterNames.insert(newName);
+        };
+
+        slider->onDelete = [this](AutomationItem* toDelete) {
+            auto toDeleteIdx = std::find_if(rows.begin(), rows.end(), [toDelete](Row const& row) { return row.item.get() == toDelete; }) - rows.begin();
+            for (auto i = toDeleteIdx; i < static_cast<long>(rows.size()); i++) {
+                rows[i].param->setIndex(rows[i].param->getIndex() - 1);
+            }
+
+            parameterNames.erase(toDelete->param->getTitle());
+
+            auto newParamName = String("param");
+            int i = 1;
+            while (parameterNames.contains(newParamName + String(i))) {
+                i++;
+            }
+            newParamName += String(i);
+
+            toDelete->param->setEnabled(false);
+            toDelete->param->setName(newParamName);
+            toDelete->param->setValue(0.0f);
+            toDelete->param->setRange(0.0f, 1.0f);
+            toDelete->param->setMode(PlugDataParameter::Float);
+            toDelete->param->notifyDAW();
+
+            // Deletes the item, so we have to do this last
+            MessageManager::callAsync([_this = SafePointer(this)]() {
+                if (_this)
+                    _this->updateSliders();
+            });
+        };
+    }
+
     SafePointer<AutomationItem> draggedItem;
     DraggedItemDropShadow draggedItemDropShadow;
     Point<int> mouseDownPos;
@@ -766,9 +824,12 @@ public:
 
     PluginProcessor* pd;
     Component* parentComponent;
-    OwnedArray<AutomationItem> rows;
+    std::vector<Row> rows;
     AddParameterButton addParameterButton;
 
+    // Names of all parameters, enabled or not, so renaming can check if a name is taken without going through all of them
+    std::unordered_set<String> parameterNames;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AutomationComponent)
 };
 
@@ -793,6 +854,8 @@ public:
 
     void scrollBarMoved(ScrollBar* scrollBarThatHasMoved, double newRangeStart) override
     {
+        // Creates the rows that were scrolled into view
+        sliders.resized();
         repaint();
     }
 
@@ -815,9 +878,9 @@ public:
 
             sliders.updateSliders();
 
-            for (int p = 0; p < sliders.rows.size(); p++) {
-                auto* param = dynamic_cast<PlugDataParameter*>(pd->getParameters()[p + 1]);
-                sliders.rows[p]->slider.setValue(param->getUnscaledValue());
+            for (auto& row : sliders.rows) {
+                if (row.item)
+                    row.item->slider.setValue(row.param->getUnscaledValue());
             }
 
         } else {
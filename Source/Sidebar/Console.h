@@ -153,134 +153,31 @@ public:
         repaint();
     }
 
+    // Draws only the messages that are in view, instead of having a component for every message
+    // The row layout is cached, and only rebuilt when the messages, the filter or the width change
     class ConsoleComponent : public Component {
-        class ConsoleMessage : public Component {
-
-            ConsoleComponent& console;
-
-        public:
-            int idx;
-
-            ConsoleMessage(int index, ConsoleComponent& parent)
-                : console(parent)
-                , idx(index)
-            {
-                parent.addAndMakeVisible(this);
-            }
-
-            void mouseDown(MouseEvent const& e)
-            {
-                if (!e.mods.isShiftDown() && !e.mods.isCommandDown()) {
-                    console.selectedItems.clear();
-                }
-
-                auto& [object, message, type, length, repeats] = console.pd->getConsoleMessages()[idx];
-                if (e.mods.isPopupMenu()) {
-                    
-                    
-                    PopupMenu menu;
-                    menu.addItem("Copy", [this]() { console.copySelectionToClipboard(); });
-                    menu.addItem("Show origin", object != nullptr, false, [this, target = object]() {
-                        auto* editor = findParentComponentOfClass<PluginEditor>();
-                        editor->highlightSearchTarget(target, true);
-                    });
-                    menu.showMenuAsync(PopupMenu::Options());
-                }
-
-                console.selectedItems.addIfNotAlreadyThere(SafePointer(this));
-                console.repaint();
-            }
-            
-            void paint(Graphics& g)
-            {
-                auto isSelected = console.selectedItems.contains(this);
-                auto showMessages = getValue<bool>(console.settingsValues[2]);
-                auto showErrors = getValue<bool>(console.settingsValues[3]);
-
-                if (isSelected) {
-                    // Draw selected background
-                    g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
-                    PlugDataLook::fillSmoothedRectangle(g, getLocalBounds().reduced(0, 1).toFloat().withTrimmedTop(0.5f), Corners::defaultCornerRadius);
-
-                    for (auto& item : console.selectedItems) {
-
-                        if (!item.getComponent())
-                            return;
-                        // Draw connected on top
-                        if (item->idx == idx - 1) {
-                            g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
-                            g.fillRect(getLocalBounds().toFloat().withTrimmedBottom(5));
-
-                            g.setColour(findColour(PlugDataColour::outlineColourId));
-                            g.drawLine(10, 0, getWidth() - 10, 0);
-                        }
-
-                        // Draw connected on bottom
-                        if (item->idx == idx + 1) {
-                            g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
-                            g.fillRect(getLocalBounds().toFloat().withTrimmedTop(5));
-                        }
-                    }
-                }
-
-                // Get console message
-                auto& [object, message, type, length, repeats] = console.pd->getConsoleMessages()[idx];
-
-                // Check if message type should be visible
-                if ((type == 0 && !showMessages) || (type == 1 && !showErrors)) {
-                    return;
-                }
-
-                // Approximate number of lines from string length and current width
-                auto totalLength = length + calculateRepeatOffset(repeats);
-                auto numLines = StringUtils::getNumLines(console.getWidth(), totalLength);
-
-                auto textColour = findColour(isSelected ? PlugDataColour::sidebarActiveTextColourId : PlugDataColour::sidebarTextColourId);
-
-                if (type == 1)
-                    textColour = Colours::orange;
-                else if (type == 2)
-                    textColour = Colours::red;
-
-                auto bounds = getLocalBounds().reduced(8, 2);
-                if (repeats > 1) {
-
-                    auto repeatIndicatorBounds = bounds.removeFromLeft(calculateRepeatOffset(repeats)).toFloat().translated(-4, 0.25);
-                    repeatIndicatorBounds = repeatIndicatorBounds.withSizeKeepingCentre(repeatIndicatorBounds.getWidth(), 21);
-
-                    auto circleColour = findColour(PlugDataColour::sidebarActiveBackgroundColourId);
-                    auto backgroundColour = findColour(PlugDataColour::sidebarBackgroundColourId);
-                    auto contrast = isSelected ? 1.5f : 0.5f;
-
-                    circleColour = Colour(circleColour.getRed() + (circleColour.getRed() - backgroundColour.getRed()) * contrast,
-                        circleColour.getGreen() + (circleColour.getGreen() - backgroundColour.getGreen()) * contrast,
-                        circleColour.getBlue() + (circleColour.getBlue() - backgroundColour.getBlue()) * contrast);
-
-                    g.setColour(circleColour);
-                    auto circleBounds = repeatIndicatorBounds.reduced(2);
-                    g.fillRoundedRectangle(circleBounds, circleBounds.getHeight() / 2.0f);
-
-                    Fonts::drawText(g, String(repeats), repeatIndicatorBounds, findColour(PlugDataColour::sidebarTextColourId), 12, Justification::centred);
-                }
-
-                // Draw text
-                Fonts::drawFittedText(g, message, bounds.translated(0, -1), textColour, numLines, 0.9f, 14);
-            }
-        };
-
         std::array<Value, 5>& settingsValues;
         Viewport& viewport;
 
         pd::Instance* pd; // instance to get console messages from
+
+        // Message index and top of every row that passes the filter, rowTops has an extra entry for the bottom of the last row
+        std::vector<int> rowMessages;
+        std::vector<int> rowTops;
+        int layoutWidth = -1;
+        bool layoutDirty = true;
+
     public:
-        std::deque<std::unique_ptr<ConsoleMessage>> messages;
-        Array<SafePointer<ConsoleMessage>> selectedItems;
+        // Selected messages, by their position in the ring plus the ring's removed count, so they stay the same while old messages fall out
+        std::set<int64> selectedItems;
 
         ConsoleComponent(pd::Instance* instance, std::array<Value, 5>& b, Viewport& v)
             : settingsValues(b)
             , viewport(v)
             , pd(instance)
         {
+            rowMessages.reserve(ConsoleMessageRing::maxMessages);
+            rowTops.reserve(ConsoleMessageRing::maxMessages + 1);
             setWantsKeyboardFocus(true);
             repaint();
         }
@@ -293,11 +190,14 @@ public:
 
         void copySelectionToClipboard()
         {
+            auto& consoleMessages = pd->getConsoleMessages();
+            auto const firstId = consoleMessages.getNumRemoved();
+
             String textToCopy;
-            for (auto& item : selectedItems) {
-                if (!item.getComponent())
-                    continue;
-                textToCopy += std::get<1>(pd->getConsoleMessages()[item->idx]) + "\n";
+            for (auto id : selectedItems) {
+                auto const index = static_cast<int>(id - firstId);
+                if (isPositiveAndBelow(index, consoleMessages.size()))
+                    textToCopy += consoleMessages.getText(index) + "\n";
             }
 
             SystemClipboard::copyTextToClipboard(textToCopy.trimEnd());
@@ -316,21 +216,9 @@ public:
 
         void update()
         {
-            while (messages.size() > pd->getConsoleMessages().size() || messages.size() >= 800) {
-                messages.pop_front();
-
-                // Make sure we don't trigger a repaint for all messages when the console is full
-                for (auto const& message : messages) {
-                    message->idx--;
-                }
-            }
-
-            while (messages.size() < pd->getConsoleMessages().size()) {
-                messages.push_back(std::make_unique<ConsoleMessage>(messages.size(), *this));
-            }
-
+            layoutDirty = true;
             setSize(getWidth(), std::max<int>(getTotalHeight(), viewport.getHeight()));
-            resized();
+            repaint();
 
             if (getValue<bool>(settingsValues[4])) {
                 viewport.setViewPositionProportionately(0.0f, 1.0f);
@@ -339,37 +227,27 @@ public:
 
         void clear()
         {
-            pd->getConsoleHistory().insert(pd->getConsoleHistory().end(), pd->getConsoleMessages().begin(), pd->getConsoleMessages().end());
+            selectedItems.clear();
+            pd->getConsoleHistory().append(pd->getConsoleMessages());
             pd->getConsoleMessages().clear();
             update();
         }
 
         void restore()
         {
-            pd->getConsoleMessages().insert(pd->getConsoleMessages().begin(), pd->getConsoleHistory().begin(), pd->getConsoleHistory().end());
-            pd->getConsoleHistory().clear();
+            selectedItems.clear();
+            auto& history = pd->getConsoleHistory();
+            history.append(pd->getConsoleMessages());
+            std::swap(history, pd->getConsoleMessages());
+            history.clear();
             update();
         }
 
         // Get total height of messages, also taking multi-line messages into account
         int getTotalHeight()
         {
-            auto showMessages = getValue<bool>(settingsValues[2]);
-            auto showErrors = getValue<bool>(settingsValues[3]);
-            auto totalHeight = 0;
-
-            for (auto& [object, message, type, length, repeats] : pd->getConsoleMessages()) {
-                auto totalLength = length + calculateRepeatOffset(repeats);
-                auto numLines = StringUtils::getNumLines(getWidth(), totalLength);
-                auto height = numLines * 13 + 12;
-
-                if ((type == 0 && !showMessages) || (type == 1 && !showErrors))
-                    continue;
-
-                totalHeight += std::max(0, height);
-            }
-
-            return totalHeight + 8;
+            updateLayout();
+            return rowTops.back() + 4;
         }
 
         static int calculateRepeatOffset(int numRepeats)
@@ -383,34 +261,176 @@ public:
 
         void mouseDown(MouseEvent const& e) override
         {
-            selectedItems.clear();
+            auto const row = getRowAt(e.y);
+            if (!isPositiveAndBelow(row, static_cast<int>(rowMessages.size())) || !getRowBounds(row).contains(e.getPosition())) {
+                selectedItems.clear();
+                repaint();
+                return;
+            }
+
+            if (!e.mods.isShiftDown() && !e.mods.isCommandDown()) {
+                selectedItems.clear();
+            }
+
+            auto& consoleMessages = pd->getConsoleMessages();
+            auto const index = rowMessages[row];
+            if (index >= consoleMessages.size())
+                return;
+
+            selectedItems.insert(consoleMessages.getNumRemoved() + index);
+
+            if (e.mods.isPopupMenu()) {
+                auto const object = consoleMessages[index].object;
+
+                PopupMenu menu;
+                menu.addItem("Copy", [this]() { copySelectionToClipboard(); });
+                menu.addItem("Show origin", object != nullptr, false, [this, target = object]() {
+                    auto* editor = findParentComponentOfClass<PluginEditor>();
+                    editor->highlightSearchTarget(target, true);
+                });
+                menu.showMenuAsync(PopupMenu::Options());
+            }
+
             repaint();
         }
 
         void resized() override
         {
+            if (layoutWidth != getWidth())
+                repaint();
+        }
+
+        void paint(Graphics& g) override
+        {
+            updateLayout();
+
+            auto& consoleMessages = pd->getConsoleMessages();
+            auto const firstId = consoleMessages.getNumRemoved();
+            auto const numRows = static_cast<int>(rowMessages.size());
+
+            auto isRowSelected = [this, firstId, numRows](int row) {
+                return isPositiveAndBelow(row, numRows) && selectedItems.contains(firstId + rowMessages[row]);
+            };
+
+            auto const clip = g.getClipBounds();
+            for (int row = std::max(getRowAt(clip.getY()), 0); row < numRows && rowTops[row] < clip.getBottom(); row++) {
+                auto const index = rowMessages[row];
+
+                // The ring can change before the next update
+                if (index >= consoleMessages.size())
+                    break;
+
+                paintMessage(g, getRowBounds(row), index, isRowSelected(row), isRowSelected(row - 1), isRowSelected(row + 1));
+            }
+        }
+
+    private:
+        void updateLayout()
+        {
+            if (!layoutDirty && layoutWidth == getWidth())
+                return;
+
+            layoutDirty = false;
+            layoutWidth = getWidth();
+
             auto showMessages = getValue<bool>(settingsValues[2]);
             auto showErrors = getValue<bool>(settingsValues[3]);
 
+            rowMessages.clear();
+            rowTops.clear();
+
             int totalHeight = 4;
-            for (int row = 0; row < static_cast<int>(pd->getConsoleMessages().size()); row++) {
-                if (row >= messages.size())
-                    break;
+            auto& consoleMessages = pd->getConsoleMessages();
+            for (int i = 0; i < consoleMessages.size(); i++) {
+                auto const& [object, type, length, repeats, textStart, textSize] = consoleMessages[i];
 
-                auto& [object, message, type, length, repeats] = pd->getConsoleMessages()[row];
+                if ((type == 0 && !showMessages) || (type == 1 && !showErrors))
+                    continue;
 
                 auto totalLength = length + calculateRepeatOffset(repeats);
-                auto numLines = StringUtils::getNumLines(getWidth(), totalLength);
-                auto height = numLines * 13 + 12;
+                auto numLines = StringUtils::getNumLines(layoutWidth, totalLength);
 
-                if ((type == 0 && !showMessages) || (type == 1 && !showErrors))
-                    continue;
+                rowMessages.push_back(i);
+                rowTops.push_back(totalHeight);
+                totalHeight += std::max(0, numLines * 13 + 12);
+            }
+
+            rowTops.push_back(totalHeight);
+        }
+
+        // Row that contains y, -1 above the first row and the number of rows below the last row
+        int getRowAt(int y)
+        {
+            updateLayout();
+            return static_cast<int>(std::upper_bound(rowTops.begin(), rowTops.end(), y) - rowTops.begin()) - 1;
+        }
+
+        Rectangle<int> getRowBounds(int row) const
+        {
+            int rightMargin = viewport.canScrollVertically() ? 13 : 11;
+            return { 6, rowTops[row], getWidth() - rightMargin, rowTops[row + 1] - rowTops[row] };
+        }
+
+        void paintMessage(Graphics& g, Rectangle<int> rowBounds, int index, bool isSelected, bool previousSelected, bool nextSelected)
+        {
+            if (isSelected) {
+                // Draw selected background
+                g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+                PlugDataLook::fillSmoothedRectangle(g, rowBounds.reduced(0, 1).toFloat().withTrimmedTop(0.5f), Corners::defaultCornerRadius);
+
+                // Draw connected on top
+                if (previousSelected) {
+                    g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+                    g.fillRect(rowBounds.toFloat().withTrimmedBottom(5));
+
+                    g.setColour(findColour(PlugDataColour::outlineColourId));
+                    g.drawLine(rowBounds.getX() + 10, rowBounds.getY(), rowBounds.getRight() - 10, rowBounds.getY());
+                }
+
+                // Draw connected on bottom
+                if (nextSelected) {
+                    g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+                    g.fillRect(rowBounds.toFloat().withTrimmedTop(5));
+                }
+            }
+
+            auto& consoleMessages = pd->getConsoleMessages();
+            auto const& [object, type, length, repeats, textStart, textSize] = consoleMessages[index];
+
+            // Approximate number of lines from string length and current width
+            auto totalLength = length + calculateRepeatOffset(repeats);
+            auto numLines = StringUtils::getNumLines(getWidth(), totalLength);
 
-                int rightMargin = viewport.canScrollVertically() ? 13 : 11;
-                messages[row]->setBounds(6, totalHeight, getWidth() - rightMargin, height);
+            auto textColour = findColour(isSelected ? PlugDataColour::sidebarActiveTextColourId : PlugDataColour::sidebarTextColourId);
 
-                totalHeight += height;
+            if (type == 1)
+                textColour = Colours::orange;
+            else if (type == 2)
+                textColour = Colours::red;
+
+            auto bounds = rowBounds.reduced(8, 2);
+            if (repeats > 1) {
+
+                auto repeatIndicatorBounds = bounds.removeFromLeft(calculateRepeatOffset(repeats)).toFloat().translated(-4, 0.25);
+                repeatIndicatorBounds = repeatIndicatorBounds.withSizeKeepingCentre(repeatIndicatorBounds.getWidth(), 21);
+
+                auto circleColour = findColour(PlugDataColour::sidebarActiveBackgroundColourId);
+                auto backgroundColour = findColour(PlugDataColour::sidebarBackgroundColourId);
+                auto contrast = isSelected ? 1.5f : 0.5f;
+
+                circleColour = Colour(circleColour.getRed() + (circleColour.getRed() - backgroundColour.getRed()) * contrast,
+                    circleColour.getGreen() + (circleColour.getGreen() - backgroundColour.getGreen()) * contrast,
+                    circleColour.getBlue() + (circleColour.getBlue() - backgroundColour.getBlue()) * contrast);
+
+                g.setColour(circleColour);
+                auto circleBounds = repeatIndicatorBounds.reduced(2);
+                g.fillRoundedRectangle(circleBounds, circleBounds.getHeight() / 2.0f);
+
+                Fonts::drawText(g, String(repeats), repeatIndicatorBounds, findColour(PlugDataColour::sidebarTextColourId), 12, Justification::centred);
             }
+
+            // Draw text, we only create the String here so we don't need to do it for messages that are not on screen
+            Fonts::drawFittedText(g, consoleMessages.getText(index), bounds.translated(0, -1), textColour, numLines, 0.9f, 14);
         }
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConsoleComponent)
@@ -77,7 +77,7 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DocumentBrowserSettings)
 };
 
-class DocumentationBrowser : public Component, public FileDragAndDropTarget, private FileSystemWatcher::Listener,  private Thread, public KeyListener {
+class DocumentationBrowser : public Component, public FileDragAndDropTarget, private FileSystemWatcher::Listener,  private Thread, private Timer, public KeyListener {
 
 public:
     explicit DocumentationBrowser(PluginProcessor* processor)
@@ -94,7 +94,15 @@ public:
         searchInput.setBackgroundColour(PlugDataColour::sidebarActiveBackgroundColourId);
         searchInput.addKeyListener(this);
         searchInput.onTextChange = [this]() {
-            fileList.setFilterString(searchInput.getText());
+            if (searchInput.isEmpty()) {
+                stopTimer();
+                latestQueryId++;
+                fileList.setFilterString("");
+                return;
+            }
+
+            // Wait for the user to stop typing before we search
+            startTimer(150);
         };
         
         fsWatcher.addListener(this);
@@ -121,6 +129,9 @@ public:
             DragAndDropContainer::performExternalDragDropOfFiles({ tree.getProperty("Path") }, false, this, nullptr);
         };
         
+        // Show the files from last time right away, while we check what changed
+        loadCachedTree();
+
         updateContent();
         addAndMakeVisible(fileList);
     }
@@ -129,6 +140,41 @@ public:
     {
         stopThread(-1);
     }
+
+    void timerCallback() override
+    {
+        stopTimer();
+
+        auto const query = searchInput.getText();
+        auto const queryId = ++latestQueryId;
+
+        std::shared_ptr<SearchableFiles const> files;
+        {
+            ScopedLock lock(searchableFilesLock);
+            files = searchableFiles;
+        }
+
+        if (!files)
+            return;
+
+        searchPool.addJob([_this = SafePointer(this), files, query, queryId]() {
+            auto matchingPaths = std::make_shared<std::unordered_set<String>>();
+            for (auto const& [name, path] : *files) {
+                if (name.containsIgnoreCase(query))
+                    matchingPaths->insert(path);
+            }
+
+            MessageManager::callAsync([_this, matchingPaths, query, queryId]() {
+                // Don't show the results of a query that was already replaced by a newer one
+                if (!_this || queryId != _this->latestQueryId)
+                    return;
+
+                _this->fileList.setFilter(query, [matchingPaths](ValueTree const& node) {
+                    return matchingPaths->count(node.getProperty("Path").toString()) > 0;
+                });
+            });
+        });
+    }
     
     bool isInterestedInFileDrag(StringArray const& files) override
    {
@@ -147,6 +193,12 @@ public:
     
    void updateContent()
    {
+       {
+           ScopedLock lock(changedDirectoriesLock);
+           changedDirectories.clear();
+       }
+       needsFullScan = true;
+
        fsWatcher.removeAllFolders();
        fsWatcher.addFolder(File(pd->settingsFile->getProperty<String>("browser_path")));
        startThread(Thread::Priority::background);
@@ -162,7 +214,22 @@ public:
        return false;
    }
 
-    
+
+    void fileChanged(File const file, FileSystemWatcher::FileSystemEvent event) override
+    {
+        // We write our own cache in there, don't respond to that
+        if (file.isAChildOf(cachedTreeFile.getParentDirectory()))
+            return;
+
+        // Only the directory that contains the file needs to be read again
+        {
+            ScopedLock lock(changedDirectoriesLock);
+            changedDirectories.addIfNotAlreadyThere(file.getParentDirectory().getFullPathName());
+        }
+
+        FileSystemWatcher::Listener::fileChanged(file, event);
+    }
+
     void filesystemChanged() override
     {
         if(isVisible())
@@ -230,23 +297,137 @@ public:
     
     void run() override
     {
-        auto tree = generateDirectoryValueTree(File(pd->settingsFile->getProperty<String>("browser_path")));
-        if(tree.isValid()) {
-            MessageManager::callAsync([_this = SafePointer(this), tree](){
-                if(_this) {
-                    _this->fileTree = tree;
-                    _this->fileList.setValueTree(tree);
+        auto const rootDirectory = File(pd->settingsFile->getProperty<String>("browser_path"));
+
+        StringArray directoriesToUpdate;
+        {
+            ScopedLock lock(changedDirectoriesLock);
+            directoriesToUpdate.swapWith(changedDirectories);
+        }
+
+        // Try to only read the directories that changed, we read everything when the browser path changed, or when we can't find a directory in the tree
+        ValueTree tree;
+        if (!needsFullScan.exchange(false) && indexedTree.isValid() && indexedTree.getProperty("Path").toString() == rootDirectory.getFullPathName()) {
+            tree = indexedTree.createCopy();
+            for (auto const& directory : directoriesToUpdate) {
+                if (!updateDirectory(tree, File(directory))) {
+                    tree = ValueTree();
+                    break;
                 }
-            });
+            }
         }
+
+        if (!tree.isValid())
+            tree = generateDirectoryValueTree(rootDirectory);
+
+        if (threadShouldExit() || !tree.isValid())
+            return;
+
+        indexedTree = tree;
+        updateSearchableFiles(tree);
+
+        MemoryOutputStream ostream;
+        tree.writeToStream(ostream);
+        cachedTreeFile.getParentDirectory().createDirectory();
+        cachedTreeFile.replaceWithData(ostream.getData(), ostream.getDataSize());
+
+        MessageManager::callAsync([_this = SafePointer(this), tree](){
+            if(_this) {
+                _this->fileTree = tree;
+                _this->fileList.setValueTree(tree);
+
+                // Changes that came in while we were reading
+                ScopedLock lock(_this->changedDirectoriesLock);
+                if (!_this->changedDirectories.isEmpty())
+                    _this->startThread(Thread::Priority::background);
+            }
+        });
+    }
+
+    // Replaces a directory in the tree with what's on disk now, returns false if the directory isn't in the tree
+    bool updateDirectory(ValueTree& tree, File const& directory)
+    {
+        auto node = findNodeForPath(tree, directory.getFullPathName());
+        if (!node.isValid())
+            return false;
+
+        auto parent = node.getParent();
+        if (!parent.isValid()) {
+            // It's the root directory
+            tree = generateDirectoryValueTree(directory);
+            return tree.isValid();
+        }
+
+        auto const index = parent.indexOf(node);
+        parent.removeChild(index, nullptr);
+
+        auto newNode = generateDirectoryValueTree(directory);
+        if (newNode.isValid())
+            parent.addChild(newNode, index, nullptr);
+
+        return true;
+    }
+
+    static ValueTree findNodeForPath(ValueTree const& tree, String const& path)
+    {
+        if (tree.getProperty("Path").toString() == path)
+            return tree;
+
+        if (!path.startsWith(tree.getProperty("Path").toString()))
+            return {};
+
+        for (auto child : tree) {
+            if (child.hasType("Folder")) {
+                if (auto found = findNodeForPath(child, path); found.isValid())
+                    return found;
+            }
+        }
+
+        return {};
+    }
+
+    // Flat list of names and paths in the tree, so searching doesn't need to touch the tree that's being displayed
+    void updateSearchableFiles(ValueTree const& tree)
+    {
+        auto files = std::make_shared<SearchableFiles>();
+
+        std::function<void(ValueTree const&)> addNode = [&files, &addNode](ValueTree const& node) {
+            files->emplace_back(node.getProperty("Name").toString(), node.getProperty("Path").toString());
+            for (auto child : node) {
+                addNode(child);
+            }
+        };
+
+        for (auto child : tree) {
+            addNode(child);
+        }
+
+        ScopedLock lock(searchableFilesLock);
+        searchableFiles = files;
+    }
+
+    void loadCachedTree()
+    {
+        FileInputStream istream(cachedTreeFile);
+        if (!istream.openedOk())
+            return;
+
+        auto tree = ValueTree::readFromStream(istream);
+        if (!tree.hasType("Folder") || tree.getProperty("Path").toString() != pd->settingsFile->getProperty<String>("browser_path"))
+            return;
+
+        fileTree = tree;
+        fileList.setValueTree(tree);
+        updateSearchableFiles(tree);
     }
     
     ValueTree generateDirectoryValueTree(const File& directory) {
         
         static File versionDataDir = ProjectInfo::appDataDir.getChildFile("Versions");
         static File toolchainDir = ProjectInfo::appDataDir.getChildFile("Toolchain");
+        static File cacheDir = cachedTreeFile.getParentDirectory();
         
-        if (threadShouldExit() || !directory.exists() || !directory.isDirectory() || directory == versionDataDir || directory == toolchainDir)
+        if (threadShouldExit() || !directory.exists() || !directory.isDirectory() || directory == versionDataDir || directory == toolchainDir || directory == cacheDir)
         {
             return ValueTree();
         }
@@ -406,4 +587,22 @@ private:
     SearchEditor searchInput;
     
     bool isDraggingFile = false;
+
+    // The last tree read by the browser thread, only used on that thread
+    ValueTree indexedTree;
+    std::atomic<bool> needsFullScan = true;
+
+    // Directories reported by the file system watcher since the last update
+    CriticalSection changedDirectoriesLock;
+    StringArray changedDirectories;
+
+    static inline File const cachedTreeFile = ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("DocumentationBrowser.bin");
+
+    using SearchableFiles = std::vector<std::pair<String, String>>;
+    std::shared_ptr<SearchableFiles const> searchableFiles;
+    CriticalSection searchableFilesLock;
+    int latestQueryId = 0;
+
+    // Declared last, so it finishes searching before the browser is deleted
+    ThreadPool searchPool = ThreadPool(1);
 };
@@ -40,6 +40,10 @@ class Inspector : public Component {
     Array<ObjectParameters> properties;
     OwnedArray<PropertyRedirector> redirectors;
 
+    // The components that are showing, in the order of the parameters they control, owned by the panel
+    Array<PropertiesPanelProperty*> propertyComponents;
+    String currentLayout;
+
 public:
     Inspector()
     {
@@ -116,8 +120,6 @@ public:
 
         StringArray names = { "Dimensions", "General", "Appearance", "Label", "Extra" };
 
-        panel.clear();
-
         auto parameterIsInAllObjects = [&objectParameters](ObjectParameter& param, Array<Value*>& values) {
             auto& [name1, type1, category1, value1, options1, defaultVal1, customComponent1] = param;
 
@@ -142,19 +144,25 @@ public:
             return isInAllObjects;
         };
 
-        redirectors.clear();
+        // Find the properties to show, and the values they should control
+        struct ShownProperty {
+            int category;
+            ObjectParameter parameter;
+            Value* value;
+        };
+
+        std::vector<ShownProperty> shownProperties;
+        OwnedArray<PropertyRedirector> newRedirectors;
+        String layout;
+        bool hasCustomComponents = false;
 
         for (int i = 0; i < 4; i++) {
-            Array<PropertiesPanelProperty*> panels;
             for (auto& parameter : objectParameters[0].getParameters()) {
                 auto& [name, type, category, value, options, defaultVal, customComponentFn] = parameter;
 
                 if (customComponentFn && objectParameters.size() == 1 && static_cast<int>(category) == i) {
-                    if (auto* customComponent = customComponentFn()) {
-                        panel.addSection("", { customComponent });
-                    } else {
-                        continue;
-                    }
+                    shownProperties.push_back({ i, parameter, nullptr });
+                    hasCustomComponents = true;
                 } else if (customComponentFn) {
                     continue;
                 } else if (static_cast<int>(category) == i) {
@@ -164,15 +172,52 @@ public:
                         continue;
 
                     else if (objectParameters.size() == 1) {
-                        auto newPanel = createPanel(type, name, value, options);
-                        newPanel->setPreferredHeight(26);
-                        panels.add(newPanel);
+                        shownProperties.push_back({ i, parameter, value });
                     } else {
-                        auto* redirector = redirectors.add(new PropertyRedirector(value, otherValues));
-                        auto newPanel = createPanel(type, name, &redirector->baseValue, options);
-                        newPanel->setPreferredHeight(26);
-                        panels.add(newPanel);
+                        auto* redirector = newRedirectors.add(new PropertyRedirector(value, otherValues));
+                        shownProperties.push_back({ i, parameter, &redirector->baseValue });
+                    }
+
+                    layout << i << ":" << name << ":" << static_cast<int>(type) << ":" << options.joinIntoString(",") << ";";
+                }
+            }
+        }
+
+        // When the selection shows the same properties as before, we only have to attach the existing components to the new values
+        if (!hasCustomComponents && layout == currentLayout && shownProperties.size() == static_cast<size_t>(propertyComponents.size())) {
+            bool rebound = true;
+            for (int i = 0; i < propertyComponents.size() && rebound; i++) {
+                rebound = propertyComponents[i]->bindToValue(*shownProperties[i].value);
+            }
+
+            if (rebound) {
+                redirectors.swapWith(newRedirectors);
+                return;
+            }
+        }
+
+        panel.clear();
+        propertyComponents.clear();
+        redirectors.swapWith(newRedirectors);
+        currentLayout = hasCustomComponents ? String() : layout;
+
+        for (int i = 0; i < 4; i++) {
+            Array<PropertiesPanelProperty*> panels;
+            for (auto& [category, parameter, value] : shownProperties) {
+                if (category != i)
+                    continue;
+
+                auto& [name, type, parameterCategory, parameterValue, options, defaultVal, customComponentFn] = parameter;
+
+                if (customComponentFn) {
+                    if (auto* customComponent = customComponentFn()) {
+                        panel.addSection("", { customComponent });
                     }
+                } else {
+                    auto newPanel = createPanel(type, name, value, options);
+                    newPanel->setPreferredHeight(26);
+                    panels.add(newPanel);
+                    propertyComponents.add(newPanel);
                 }
             }
             if (!panels.isEmpty()) {
@@ -54,6 +54,8 @@ PaletteItem::PaletteItem(PluginEditor* e, PaletteDraggableList* parent, ValueTre
         inlets = iolets.first;
         outlets = iolets.second;
     }
+
+    prepareDragAndDropImage(&editor->offlineRenderer);
 }
 
 PaletteItem::~PaletteItem()
@@ -330,7 +332,7 @@ std::pair<std::vector<bool>, std::vector<bool>> PaletteItem::countIolets(String
 
     // In case the patch contains a single object, we need to use a different method to find the number and kind inlets and outlets
     if (lines.size() == 1) {
-        auto offlineObjectRenderer = editor->offlineRenderer;
+        auto& offlineObjectRenderer = editor->offlineRenderer;
         return offlineObjectRenderer.countIolets(lines[0]);
     }
 
@@ -16,17 +16,17 @@ public:
         String const icon;
         String const description;
 
-        SearchPanelSettingsButton(String iconString, String descriptionString)
+        SearchPanelSettingsButton(String iconString, String descriptionString, String settingName)
             : icon(std::move(iconString))
             , description(std::move(descriptionString))
         {
             setClickingTogglesState(true);
 
-            auto sortLayerOrder = SettingsFile::getInstance()->getProperty<bool>("search_order");
-            setToggleState(sortLayerOrder, dontSendNotification);
+            auto settingValue = SettingsFile::getInstance()->getProperty<bool>(settingName);
+            setToggleState(settingValue, dontSendNotification);
 
-            onClick = [this](){
-                SettingsFile::getInstance()->setProperty("search_order", var(getToggleState()));
+            onClick = [this, settingName](){
+                SettingsFile::getInstance()->setProperty(settingName, var(getToggleState()));
             };
         }
 
@@ -50,25 +50,28 @@ public:
     SearchPanelSettings()
     {
         addAndMakeVisible(sortLayerOrder);
+        addAndMakeVisible(showBuses);
 
-        setSize(150, 28);
+        setSize(170, 56);
     };
 
     void resized() override
     {
         auto buttonBounds = getLocalBounds();
 
-        int buttonHeight = buttonBounds.getHeight();
+        int buttonHeight = buttonBounds.getHeight() / 2;
 
         sortLayerOrder.setBounds(buttonBounds.removeFromTop(buttonHeight));
+        showBuses.setBounds(buttonBounds.removeFromTop(buttonHeight));
     }
 private:
-    SearchPanelSettingsButton sortLayerOrder = SearchPanelSettingsButton(Icons::AutoScroll, "Display layer order");
+    SearchPanelSettingsButton sortLayerOrder = SearchPanelSettingsButton(Icons::AutoScroll, "Display layer order", "search_order");
+    SearchPanelSettingsButton showBuses = SearchPanelSettingsButton(Icons::ConnectionStyle, "Show send/receive", "search_buses");
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SearchPanelSettings);
 };
 
-class SearchPanel : public Component, public KeyListener, public Timer
+class SearchPanel : public Component, public KeyListener, public Timer, public SettingsFileListener
 {
 public:
     explicit SearchPanel(PluginEditor* pluginEditor) : editor(pluginEditor)
@@ -111,6 +114,15 @@ public:
         patchTree.clearValueTree();
     }
     
+    void propertyChanged(String const& name, var const& value) override
+    {
+        if (name == "search_buses") {
+            showBuses = static_cast<bool>(value);
+            lastEntries.clear();
+            updateResults();
+        }
+    }
+
     void timerCallback() override
     {
         auto* cnv = editor->getCurrentCanvas();
@@ -182,12 +194,32 @@ public:
     void updateResults()
     {
         auto* cnv = editor->getCurrentCanvas();
-        if(cnv) {
-            cnv->pd->lockAudioThread(); // It locks inside of this anyway, so we might as well lock around it to prevent constantly locking/unlocking
-            auto tree = generatePatchTree(cnv->refCountedPatch);
-            patchTree.setValueTree(tree);
-            cnv->pd->unlockAudioThread();
+        if(!cnv)
+            return;
+
+        if (showBuses) {
+            // Edits we can't follow per object invalidate the index, and for the rest it doesn't need the audio lock
+            patchTree.setValueTree(createBusTree(cnv->pd->busIndex.getAllBuses()));
+            return;
         }
+
+        // Only copy what we need while holding the audio lock, the tree is built after releasing it
+        std::vector<SearchEntry> entries;
+        entries.reserve(lastEntries.size());
+
+        cnv->pd->lockAudioThread();
+        cnv->refCountedPatch->setCurrent();
+        if (auto patch = cnv->refCountedPatch->getPointer()) {
+            collectEntries(patch.get(), nullptr, 0, entries);
+        }
+        cnv->pd->unlockAudioThread();
+
+        // The canvas asks for an update after every sync, but most syncs don't change anything we show
+        if (entries == lastEntries && patchTree.getValueTree().isValid())
+            return;
+
+        lastEntries = std::move(entries);
+        patchTree.setValueTree(createPatchTree(lastEntries));
     }
     
     void grabFocus()
@@ -206,53 +238,103 @@ public:
         patchTree.setBounds(tableBounds);
     }
 
-    ValueTree generatePatchTree(pd::Patch::Ptr patch, void* topLevel = nullptr)
-    {
-        ValueTree patchTree("Patch");
-        for (auto objectPtr : patch->getObjects()) {
-            if (auto object = objectPtr.get<t_pd>()) {
-                auto* top = topLevel ? topLevel : object.get();
-                String type = pd::Interface::getObjectClassName(object.get());
-
-                if (!pd::Interface::checkObject(object.get()))
-                    continue;
+    // Everything we show about an object in the search results, in the order of the patch, with subpatch contents following the subpatch
+    struct SearchEntry {
+        void* object;
+        void* topLevel;
+        String text;
+        int x, y;
+        int depth;
+        bool isSubpatch;
+        bool isAbstraction;
+
+        bool operator==(SearchEntry const& other) const
+        {
+            return object == other.object && topLevel == other.topLevel && x == other.x && y == other.y && depth == other.depth && isSubpatch == other.isSubpatch && isAbstraction == other.isAbstraction && text == other.text;
+        }
+    };
 
-                char* objectText;
-                int len;
-                pd::Interface::getObjectText(object.cast<t_text>(), &objectText, &len);
+    // Must be called while holding the audio lock
+    static void collectEntries(t_canvas* cnv, void* topLevel, int depth, std::vector<SearchEntry>& entries)
+    {
+        for (t_gobj* y = cnv->gl_list; y; y = y->g_next) {
+            auto* object = pd::Interface::checkObject(y);
+            if (!object)
+                continue;
+
+            char* objectText;
+            int len;
+            pd::Interface::getObjectText(object, &objectText, &len);
+            auto text = String::fromUTF8(objectText, len);
+            freebytes(objectText, static_cast<size_t>(len));
+
+            int x, yPos, w, h;
+            pd::Interface::getObjectBounds(cnv, y, &x, &yPos, &w, &h);
+
+            auto* top = topLevel ? topLevel : y;
+            auto const isSubpatch = pd_class(&y->g_pd) == canvas_class;
+            entries.push_back({ y, top, text, x, yPos, depth, isSubpatch, isSubpatch && canvas_isabstraction(reinterpret_cast<t_canvas*>(y)) });
+
+            if (isSubpatch)
+                collectEntries(reinterpret_cast<t_canvas*>(y), top, depth + 1, entries);
+        }
+    }
 
-                int x, y, w, h;
-                pd::Interface::getObjectBounds(patch->getPointer().get(), object.cast<t_gobj>(), &x, &y, &w, &h);
+    static ValueTree createPatchTree(std::vector<SearchEntry> const& entries)
+    {
+        ValueTree root("Patch");
+
+        // The subpatches we're currently in, the contents of a subpatch always directly follow it
+        std::vector<ValueTree> parents = { root };
+        for (auto const& entry : entries) {
+            parents.resize(entry.depth + 1);
+
+            ValueTree element("Object");
+            element.setProperty("Name", entry.isSubpatch ? entry.text : entry.text.upToFirstOccurrenceOf(" ", false, false), nullptr);
+            // Also search the arguments, so comments and send/receive names can be found
+            element.setProperty("SearchText", entry.text, nullptr);
+            element.setProperty("RightText", " (" + String(entry.x) + ":" + String(entry.y) + ")", nullptr);
+            element.setProperty("Icon", entry.isAbstraction ? Icons::File : Icons::Object, nullptr);
+            element.setProperty("Object", reinterpret_cast<int64>(entry.object), nullptr);
+            element.setProperty("TopLevel", reinterpret_cast<int64>(entry.topLevel), nullptr);
+
+            parents.back().appendChild(element, nullptr);
+
+            if (entry.isSubpatch)
+                parents.push_back(element);
+        }
 
-                auto name = String::fromUTF8(objectText, len);
-                auto positionText = " (" + String(x) + ":" + String(y) + ")";
+        return root;
+    }
 
+    // All named buses of the instance, with the objects that use them
+    static ValueTree createBusTree(std::map<pd::BusIndex::BusKey, std::vector<pd::BusIndex::User>> const& buses)
+    {
+        ValueTree root("Patch");
+        for (auto const& [key, users] : buses) {
+            ValueTree bus("Object");
+            bus.setProperty("Name", key.second, nullptr);
+            bus.setProperty("RightText", " " + pd::BusIndex::getKindName(key.first), nullptr);
+            bus.setProperty("Icon", Icons::ConnectionStyle, nullptr);
+
+            for (auto const& user : users) {
                 ValueTree element("Object");
-                if (type == "canvas" || type == "graph") {
-                    pd::Patch::Ptr subpatch = new pd::Patch(objectPtr, editor->pd, false);
-                    ValueTree subpatchTree = generatePatchTree(subpatch, top);
-                    element.copyPropertiesAndChildrenFrom(subpatchTree, nullptr);
-
-                    element.setProperty("Name", name, nullptr);
-                    element.setProperty("RightText", positionText, nullptr);
-                    element.setProperty("Icon", canvas_isabstraction(subpatch->getPointer().get()) ? Icons::File : Icons::Object, nullptr);
-                    element.setProperty("Object", reinterpret_cast<int64>(object.cast<void>()), nullptr);
-                    element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
-                } else {
-                    element.setProperty("Name", name.upToFirstOccurrenceOf(" ", false, false), nullptr);
-                    element.setProperty("RightText", positionText, nullptr);
-                    element.setProperty("Icon", Icons::Object, nullptr);
-                    element.setProperty("Object", reinterpret_cast<int64>(object.cast<void>()), nullptr);
-                    element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
-                }
-
-                patchTree.appendChild(element, nullptr);
+                element.setProperty("Name", user.type + " " + key.second, nullptr);
+                element.setProperty("RightText", user.role == pd::BusIndex::Role::Sender ? " (send)" : (user.role == pd::BusIndex::Role::Receiver ? " (receive)" : ""), nullptr);
+                element.setProperty("Icon", Icons::Object, nullptr);
+                element.setProperty("Object", reinterpret_cast<int64>(user.object), nullptr);
+                element.setProperty("TopLevel", reinterpret_cast<int64>(user.object), nullptr);
+                bus.appendChild(element, nullptr);
             }
+
+            root.appendChild(bus, nullptr);
         }
 
-        return patchTree;
+        return root;
     }
 
+    bool showBuses = SettingsFile::getInstance()->getProperty<bool>("search_buses");
+    std::vector<SearchEntry> lastEntries;
     SafePointer<Canvas> currentCanvas;
     PluginEditor* editor;
     ValueTreeViewerComponent patchTree = ValueTreeViewerComponent("(Subpatch)");
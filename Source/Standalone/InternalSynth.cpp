@@ -5,6 +5,7 @@
  */
 
 #include "InternalSynth.h"
+#include "Utility/RealtimeWorkerPool.h"
 
 #if PLUGDATA_STANDALONE
 #    include <FluidLite/include/fluidlite.h>
@@ -12,6 +13,137 @@
 #    include <StandaloneBinaryData.h>
 #endif
 
+#if PLUGDATA_STANDALONE
+// Lets fluidsynth read the soundfont from a memory-mapped file, instead of through stdio
+// The OS pages the file in as fluidsynth parses it, without going through stdio's buffers first
+namespace {
+// fluidsynth's FLUID_OK and FLUID_FAILED, which live in a private header
+constexpr int soundfontReadOk = 0;
+constexpr int soundfontReadFailed = -1;
+
+struct MappedSoundfont {
+    MemoryMappedFile file;
+    int64 position = 0;
+};
+
+void* openMappedSoundfont(fluid_fileapi_t*, char const* filename)
+{
+    auto mapped = std::unique_ptr<MappedSoundfont>(new MappedSoundfont { MemoryMappedFile(File(String::fromUTF8(filename)), MemoryMappedFile::readOnly) });
+    if (mapped->file.getData() == nullptr)
+        return nullptr;
+
+    return mapped.release();
+}
+
+int readMappedSoundfont(void* buffer, int count, void* handle)
+{
+    auto* mapped = static_cast<MappedSoundfont*>(handle);
+    auto const size = static_cast<int64>(mapped->file.getSize());
+    if (count < 0 || mapped->position + count > size)
+        return soundfontReadFailed;
+
+    std::memcpy(buffer, addBytesToPointer(mapped->file.getData(), mapped->position), static_cast<size_t>(count));
+    mapped->position += count;
+    return soundfontReadOk;
+}
+
+int seekMappedSoundfont(void* handle, long offset, int origin)
+{
+    auto* mapped = static_cast<MappedSoundfont*>(handle);
+    auto const size = static_cast<int64>(mapped->file.getSize());
+    auto const base = origin == SEEK_CUR ? mapped->position : (origin == SEEK_END ? size : 0);
+    auto const newPosition = base + offset;
+    if (newPosition < 0 || newPosition > size)
+        return soundfontReadFailed;
+
+    mapped->position = newPosition;
+    return soundfontReadOk;
+}
+
+int closeMappedSoundfont(void* handle)
+{
+    delete static_cast<MappedSoundfont*>(handle);
+    return soundfontReadOk;
+}
+
+long tellMappedSoundfont(void* handle)
+{
+    return static_cast<long>(static_cast<MappedSoundfont*>(handle)->position);
+}
+
+// Doesn't have a free function, so fluidsynth won't try to delete it along with the loader
+fluid_fileapi_t mappedSoundfontApi = {
+    .data = nullptr,
+    .free = nullptr,
+    .fopen = openMappedSoundfont,
+    .fread = readMappedSoundfont,
+    .fseek = seekMappedSoundfont,
+    .fclose = closeMappedSoundfont,
+    .ftell = tellMappedSoundfont,
+};
+}
+#endif
+
+// Renders the synth on the shared worker pool, while Pd's DSP for the next block runs on the audio thread
+// Each callback picks up the block that was rendered during the previous one, and hands over the MIDI for the next
+class InternalSynth::WorkerRenderer {
+public:
+    explicit WorkerRenderer(InternalSynth& internalSynth)
+        : synth(internalSynth)
+    {
+        midiMessages.ensureSize(2048);
+    }
+
+    ~WorkerRenderer()
+    {
+        waitUntilIdle();
+    }
+
+    void process(AudioBuffer<float>& buffer, MidiBuffer const& midi)
+    {
+        waitUntilIdle();
+
+        // The synth's buffer now holds the block rendered during the previous callback
+        auto const numSamples = std::min(numRenderedSamples, buffer.getNumSamples());
+        for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
+            buffer.addFrom(ch, 0, synth.internalBuffer, ch, 0, numSamples);
+        }
+
+        midiMessages.clear();
+        midiMessages.addEvents(midi, 0, -1, 0);
+        numSamplesToRender = buffer.getNumSamples();
+
+        RealtimeWorkerPool::getInstance()->submit(renderTask, [](void* context) {
+            auto* renderer = static_cast<WorkerRenderer*>(context);
+            renderer->synth.render(renderer->numSamplesToRender, renderer->midiMessages);
+            renderer->numRenderedSamples = renderer->numSamplesToRender;
+        }, this);
+    }
+
+    // Rendering happens in parallel with Pd's DSP, so by the time the next callback needs it, it's usually long done
+    void waitUntilIdle()
+    {
+        RealtimeWorkerPool::getInstance()->wait(renderTask);
+    }
+
+    // Drop the block that is still waiting to be picked up, after the synth was re-initialised or we switched back to rendering inline
+    void discardRenderedBlock()
+    {
+        waitUntilIdle();
+        numRenderedSamples = 0;
+    }
+
+private:
+    InternalSynth& synth;
+
+    // Only touched by the thread that doesn't own the block at the time, the task group hands it over
+    MidiBuffer midiMessages;
+    int numSamplesToRender = 0;
+    int numRenderedSamples = 0;
+
+    RealtimeWorkerPool::TaskGroup renderTask;
+};
+
 // InternalSynth is an internal General MIDI synthesizer that can be used as a MIDI output device
 // The goal is to get something similar to the "AU DLS Synth" in Max/MSP on macOS, but cross-platform
 // Since fluidsynth is alraedy included for the sfont~ object, we can reuse it here to read a GM soundfont
@@ -21,12 +153,15 @@ InternalSynth::InternalSynth()
 #ifndef PLUGDATA_STANDALONE
     ignoreUnused(synth);
     ignoreUnused(settings);
+#else
+    workerRenderer = std::make_unique<WorkerRenderer>(*this);
 #endif
 }
 
 InternalSynth::~InternalSynth()
 {
 #ifdef PLUGDATA_STANDALONE
+    workerRenderer.reset();
     stopThread(6000);
 
     if (ready) {
@@ -41,13 +176,26 @@ InternalSynth::~InternalSynth()
 void InternalSynth::extractSoundfont()
 {
 #ifdef PLUGDATA_STANDALONE
-    // Unpack soundfont
-    if (!soundFont.existsAsFile()) {
-        soundFont.getParentDirectory().createDirectory();
-        FileOutputStream ostream(soundFont);
-        ostream.write(StandaloneBinaryData::GeneralUser_GS_sf3, StandaloneBinaryData::GeneralUser_GS_sf3Size);
+    auto const* data = StandaloneBinaryData::GeneralUser_GS_sf3;
+    auto const size = static_cast<int64>(StandaloneBinaryData::GeneralUser_GS_sf3Size);
+
+    // Only unpack the soundfont if it's missing or different from the one we ship
+    // Comparing maps the file into memory, which also means it's paged in already by the time fluidsynth reads it
+    if (soundFont.getSize() == size) {
+        MemoryMappedFile existingFile(soundFont, MemoryMappedFile::readOnly);
+        if (existingFile.getData() && std::memcmp(existingFile.getData(), data, static_cast<size_t>(size)) == 0)
+            return;
+    }
+
+    soundFont.getParentDirectory().createDirectory();
+
+    // Write to a temporary file first, so another standalone instance that's loading it never sees half a soundfont
+    TemporaryFile temporaryFile(soundFont);
+    if (FileOutputStream ostream(temporaryFile.getFile()); ostream.openedOk()) {
+        ostream.write(data, static_cast<size_t>(size));
         ostream.flush();
     }
+    temporaryFile.overwriteTargetFileWithTemporary();
 #endif
 }
 
@@ -58,6 +206,9 @@ void InternalSynth::run()
 
     unprepareLock.lock();
 
+    // The soundfont is only unpacked once the synth is first used, so it doesn't slow down startup
+    extractSoundfont();
+
     // Fluidlite does not like setups with <2 channels
     internalBuffer.setSize(std::max(2, lastNumChannels.load()), lastBlockSize);
     internalBuffer.clear();
@@ -75,6 +226,11 @@ void InternalSynth::run()
         fluid_settings_setnum(settings, "synth.sample-rate", lastSampleRate);
         synth = new_fluid_synth(settings); // Create fluidsynth instance:
 
+        // Tried before the default loader, which reads the soundfont through stdio
+        auto* loader = new_fluid_defsfloader();
+        loader->fileapi = &mappedSoundfontApi;
+        fluid_synth_add_sfloader(synth, loader);
+
         // Load the soundfont
         int ret = fluid_synth_sfload(synth, pathName.toRawUTF8(), 0);
 
@@ -94,6 +250,9 @@ void InternalSynth::unprepare()
 {
 #ifdef PLUGDATA_STANDALONE
 
+    // The render thread could still be using the synth
+    workerRenderer->discardRenderedBlock();
+
     unprepareLock.lock();
 
     if (ready) {
@@ -128,6 +287,7 @@ void InternalSynth::prepare(int sampleRate, int blockSize, int numChannels)
         lastBlockSize = blockSize;
         lastNumChannels = numChannels;
 
+        workerRenderer->discardRenderedBlock();
         startThread();
     }
 
@@ -143,6 +303,33 @@ void InternalSynth::process(AudioBuffer<float>& buffer, MidiBuffer& midiMessages
         return;
     }
 
+    if (renderOnWorkerThread) {
+        workerRenderer->process(buffer, midiMessages);
+        return;
+    }
+
+    workerRenderer->discardRenderedBlock();
+    render(buffer.getNumSamples(), midiMessages);
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
+        buffer.addFrom(ch, 0, internalBuffer, ch, 0, buffer.getNumSamples());
+    }
+
+#endif
+}
+
+void InternalSynth::render(int numSamples, MidiBuffer const& midiMessages)
+{
+#ifdef PLUGDATA_STANDALONE
+
+    auto const startTime = Time::getHighResolutionTicks();
+
+    // Lowering the limit turns off the voices above it
+    auto const voiceLimit = maxNumVoices.load();
+    if (fluid_synth_get_polyphony(synth) != voiceLimit) {
+        fluid_synth_set_polyphony(synth, voiceLimit);
+    }
+
     // Pass MIDI messages to fluidsynth
     for (auto const& event : midiMessages) {
         auto const message = event.getMessage();
@@ -176,15 +363,31 @@ void InternalSynth::process(AudioBuffer<float>& buffer, MidiBuffer& midiMessages
     }
 
     // Run audio through fluidsynth
-    fluid_synth_process(synth, buffer.getNumSamples(), internalBuffer.getNumChannels(), const_cast<float**>(internalBuffer.getArrayOfReadPointers()), internalBuffer.getNumChannels(), const_cast<float**>(internalBuffer.getArrayOfWritePointers()));
+    fluid_synth_process(synth, numSamples, internalBuffer.getNumChannels(), const_cast<float**>(internalBuffer.getArrayOfReadPointers()), internalBuffer.getNumChannels(), const_cast<float**>(internalBuffer.getArrayOfWritePointers()));
 
-    for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
-        buffer.addFrom(ch, 0, internalBuffer, ch, 0, buffer.getNumSamples());
-    }
+    renderTicks.fetch_add(Time::getHighResolutionTicks() - startTime, std::memory_order_relaxed);
 
+#else
+    ignoreUnused(numSamples, midiMessages);
 #endif
 }
 
+void InternalSynth::setRenderOnWorkerThread(bool shouldRenderOnWorkerThread)
+{
+    renderOnWorkerThread = shouldRenderOnWorkerThread;
+}
+
+void InternalSynth::setMaxVoices(int maxVoices)
+{
+    // fluidsynth can't go over the polyphony it was created with, which defaults to 256
+    maxNumVoices = jlimit(1, 256, maxVoices);
+}
+
+int64 InternalSynth::takeRenderTime()
+{
+    return renderTicks.exchange(0, std::memory_order_relaxed);
+}
+
 bool InternalSynth::isReady()
 {
 #ifndef PLUGDATA_STANDALONE
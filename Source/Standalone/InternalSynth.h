@@ -35,7 +35,20 @@ public:
 
     bool isReady();
 
+    // Renders on a separate thread, in parallel with Pd's DSP, at the cost of one block of latency
+    void setRenderOnWorkerThread(bool shouldRenderOnWorkerThread);
+
+    // Limits how many voices fluidsynth plays at once, new notes will steal the oldest voices
+    void setMaxVoices(int maxVoices);
+
+    // Time spent rendering since the last call, in high resolution ticks
+    int64 takeRenderTime();
+
 private:
+    void render(int numSamples, MidiBuffer const& midiMessages);
+
+    class WorkerRenderer;
+
     File soundFont = ProjectInfo::versionDataDir.getChildFile("Extra").getChildFile("GS").getChildFile("GeneralUser_GS.sf3");
 
     // Fluidsynth state
@@ -50,4 +63,10 @@ private:
     std::atomic<int> lastNumChannels = 0;
 
     AudioBuffer<float> internalBuffer;
+
+    std::atomic<bool> renderOnWorkerThread = false;
+    std::atomic<int> maxNumVoices = 256;
+    std::atomic<int64> renderTicks = 0;
+
+    std::unique_ptr<WorkerRenderer> workerRenderer;
 };
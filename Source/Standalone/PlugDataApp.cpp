@@ -87,9 +87,8 @@ public:
         auto file = File(tokens[0].unquoted());
         if (file.existsAsFile()) {
             auto* pd = dynamic_cast<PluginProcessor*>(pluginHolder->processor.get());
-            auto* editor = dynamic_cast<PluginEditor*>(mainWindow->mainComponent->getEditor());
-            if (pd && editor && file.existsAsFile()) {
-                auto* editor = dynamic_cast<PluginEditor*>(mainWindow->mainComponent->getEditor());
+            auto* editor = getMainEditor();
+            if (pd && (editor || isHeadless) && file.existsAsFile()) {
                 pd->loadPatch(file, editor);
                 SettingsFile::getInstance()->addToRecentlyOpened(file);
             }
@@ -102,6 +101,18 @@ public:
 
         pluginHolder = std::make_unique<StandalonePluginHolder>(appProperties.getUserSettings(), false, "");
 
+        // Headless mode only runs the patches, for installations where nobody looks at the screen
+        // No editor gets created at all, so there are no canvases or meters taking up CPU and GPU time
+        auto const argumentTokens = StringArray::fromTokens(arguments, true);
+        isHeadless = argumentTokens.contains("--headless") || argumentTokens.contains("-nogui");
+        if (isHeadless) {
+            if (auto* pd = dynamic_cast<PluginProcessor*>(pluginHolder->processor.get()))
+                pd->setPrintConsoleToStdout(true);
+
+            parseSystemArguments(arguments);
+            return;
+        }
+
         mainWindow = new PlugDataWindow(pluginHolder->processor->createEditorIfNeeded());
 
         mainWindow->setVisible(true);
@@ -137,6 +148,14 @@ public:
         mainWindow->setBoundsConstrained(getWindowScreenBounds());
     }
 
+    PluginEditor* getMainEditor()
+    {
+        if (!mainWindow)
+            return nullptr;
+
+        return dynamic_cast<PluginEditor*>(mainWindow->mainComponent->getEditor());
+    }
+
     void shutdown() override
     {
         mainWindow = nullptr;
@@ -176,7 +195,7 @@ public:
             auto toOpen = File(String(nl->nl_string).unquoted());
             if (toOpen.existsAsFile() && toOpen.hasFileExtension("pd")) {
 
-                auto* editor = dynamic_cast<PluginEditor*>(mainWindow->mainComponent->getEditor());
+                auto* editor = getMainEditor();
                 if (auto* pd = dynamic_cast<PluginProcessor*>(pluginHolder->processor.get())) {
                     pd->loadPatch(toOpen, editor);
                     SettingsFile::getInstance()->addToRecentlyOpened(toOpen);
@@ -197,8 +216,7 @@ public:
             auto toOpen = File(arg);
             if (toOpen.existsAsFile() && toOpen.hasFileExtension("pd") && !openedPatches.contains(toOpen.getFullPathName())) {
                 auto* pd = dynamic_cast<PluginProcessor*>(pluginHolder->processor.get());
-                auto* editor = dynamic_cast<PluginEditor*>(mainWindow->mainComponent->getEditor());
-                pd->loadPatch(toOpen, editor);
+                pd->loadPatch(toOpen, getMainEditor());
                 SettingsFile::getInstance()->addToRecentlyOpened(toOpen);
             }
         }
@@ -238,7 +256,8 @@ public:
 
 protected:
     ApplicationProperties appProperties;
-    PlugDataWindow* mainWindow;
+    PlugDataWindow* mainWindow = nullptr;
+    bool isHeadless = false;
 };
 
 void PlugDataWindow::closeAllPatches()
@@ -34,6 +34,7 @@
 #include "Utility/SettingsFile.h"
 #include "Utility/RateReducer.h"
 #include "Utility/MidiDeviceManager.h"
+#include "Utility/RealtimeThreadSettings.h"
 #include "../PluginEditor.h"
 
 // For each OS, we have a different approach to rendering the window shadow
@@ -65,7 +66,8 @@ public:
     {
         auto deviceIndex = midiDeviceManager.getMidiInputDeviceIndex(input->getIdentifier());
         if (deviceIndex >= 0) {
-            getMidiMessageCollector().addMessageToQueue(MidiDeviceManager::convertToSysExFormat(message, deviceIndex));
+            // Bypasses the MidiMessageCollector, which squeezes everything since the last callback into the block
+            midiDeviceManager.enqueueMidiInput(deviceIndex, message);
         }
     }
 
@@ -98,6 +100,11 @@ public:
         : settings(settingsToUse, takeOwnershipOfSettings)
         , channelConfiguration(channels)
     {
+        auto* settingsFile = SettingsFile::getInstance();
+        for (int role = 0; role < RealtimeThreadSettings::NumRoles; role++) {
+            auto const threadRole = static_cast<RealtimeThreadSettings::Role>(role);
+            RealtimeThreadSettings::getInstance().setThreadSettings(threadRole, settingsFile->getProperty<int>(RealtimeThreadSettings::getSettingName(threadRole, "priority")), settingsFile->getProperty<String>(RealtimeThreadSettings::getSettingName(threadRole, "cores")));
+        }
 
         createPlugin();
 
@@ -336,6 +343,9 @@ private:
 
     CallbackMaxSizeEnforcer maxSizeEnforcer { *this };
 
+    // Only used by the audio thread
+    RealtimeThreadSettings::ThreadState audioThreadState;
+
     void audioDeviceIOCallbackWithContext(float const* const* inputChannelData,
         int numInputChannels,
         float* const* outputChannelData,
@@ -343,6 +353,8 @@ private:
         int numSamples,
         AudioIODeviceCallbackContext const& context) override
     {
+        RealtimeThreadSettings::getInstance().applyToCurrentThread(RealtimeThreadSettings::AudioCallback, audioThreadState);
+
         player.audioDeviceIOCallbackWithContext(inputChannelData,
             numInputChannels,
             outputChannelData,
@@ -353,6 +365,8 @@ private:
 
     void audioDeviceAboutToStart(AudioIODevice* device) override
     {
+        // The new device could call us from a different thread
+        audioThreadState = {};
         player.audioDeviceAboutToStart(device);
     }
 
@@ -584,7 +598,7 @@ public:
             localPath.addRoundedRectangle(b.toFloat().reduced(22.0f), Corners::windowCornerRadius);
 
             int radius = isActiveWindow() ? 22 : 17;
-            StackShadow::renderDropShadow(g, localPath, Colour(0, 0, 0).withAlpha(0.6f), radius, { 0, 2 });
+            StackShadow::renderDropShadow(*this, g, localPath, Colour(0, 0, 0).withAlpha(0.6f), radius, { 0, 2 });
         }
     }
 #endif
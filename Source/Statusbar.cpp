@@ -452,7 +452,11 @@ public:
         auto currentMappingMode = SettingsFile::getInstance()->getPropertyAsValue("cpu_meter_mapping_mode").getValue();
         buttons[currentMappingMode]->setToggleState(true, dontSendNotification);
 
-        setSize(212, 177);
+        breakdownLabel.setFont(Fonts::getCurrentFont().withHeight(13.0f));
+        breakdownLabel.setJustificationType(Justification::topLeft);
+        addAndMakeVisible(breakdownLabel);
+
+        setSize(212, 239);
     }
 
     ~CPUMeterPopup()
@@ -472,6 +476,13 @@ public:
         linear.setBounds(b.removeFromLeft(buttonWidth));
         logA.setBounds(b.removeFromLeft(buttonWidth).expanded(1, 0));
         logB.setBounds(b.removeFromLeft(buttonWidth).expanded(1, 0));
+
+        breakdownLabel.setBounds(getLocalBounds().withTop(b.getBottom() + 4).reduced(4, 0));
+    }
+
+    void setBreakdown(String const& breakdown)
+    {
+        breakdownLabel.setText(breakdown, dontSendNotification);
     }
 
     std::function<void()> getUpdateFunc()
@@ -503,6 +514,7 @@ private:
 
     Label fastGraphTitle;
     Label slowGraphTitle;
+    Label breakdownLabel;
     std::unique_ptr<CPUHistoryGraph> cpuGraph;
     std::unique_ptr<CPUHistoryGraph> cpuGraphLongHistory;
 
@@ -544,9 +556,108 @@ public:
         cpuUsageToDraw = round(lastCpuUsage);
         cpuUsageLongHistory.push(lastCpuUsage);
         updateCPUGraphLong();
+        updateMessageQueueTooltip();
+        updateBreakdown();
         repaint();
     }
 
+    // Shows how much time goes to Pd's DSP, to messages from the GUI, and to painting the current canvas
+    // All root patches share one DSP chain in Pd, so we can't split the DSP time per patch
+    void updateBreakdown()
+    {
+        auto* editor = findParentComponentOfClass<PluginEditor>();
+        if (!editor)
+            return;
+
+        auto breakdownText = "Pd DSP: " + String(cpuBreakdown.dspUsage, 1) + "%\nGUI messages: " + String(cpuBreakdown.messageQueueUsage, 1) + "%";
+        if (cpuBreakdown.internalSynthUsage > 0.0f)
+            breakdownText += "\nInternal synth: " + String(cpuBreakdown.internalSynthUsage, 1) + "%";
+
+        if (auto* cnv = editor->getCurrentCanvas()) {
+            auto const& statistics = cnv->repaintCoordinator.getStatistics();
+            auto const currentTime = Time::getMillisecondCounterHiRes();
+
+            // Statistics can be reset by the canvas. Either way, we start a new interval, and can only show the frame rate once it's complete
+            if (cnv != lastCanvas || statistics.numFrames < lastNumFrames) {
+                lastCanvas = cnv;
+            } else if (auto const elapsedSeconds = (currentTime - lastStatisticsTime) / 1000.0; elapsedSeconds > 0.0) {
+                auto const numFrames = statistics.numFrames - lastNumFrames;
+                auto const paintTimeMs = statistics.paintTimeMs - lastPaintTimeMs;
+
+                breakdownText += "\nCanvas frames: " + String(roundToInt(numFrames / elapsedSeconds)) + "/s";
+                if (numFrames > 0)
+                    breakdownText += ", " + String(paintTimeMs / numFrames, 2) + "ms per frame";
+            }
+
+            lastNumFrames = statistics.numFrames;
+            lastPaintTimeMs = statistics.paintTimeMs;
+            lastStatisticsTime = currentTime;
+
+            if (auto const timeToFirstFrame = cnv->repaintCoordinator.getTimeToFirstFrame(); timeToFirstFrame > 0.0)
+                breakdownText += "\nOpened in " + String(timeToFirstFrame, 1) + "ms";
+        }
+
+        updateBreakdownText(breakdownText);
+    }
+
+    void cpuBreakdownChanged(StatusbarSource::CPUBreakdown breakdown) override
+    {
+        cpuBreakdown = breakdown;
+    }
+
+    // Show how the message queue from Pd to the GUI is holding up, this helps to debug patches that flood the GUI
+    void updateMessageQueueTooltip()
+    {
+        auto* editor = findParentComponentOfClass<PluginEditor>();
+        if (!editor)
+            return;
+
+        auto stats = editor->pd->getMessageQueueStatistics();
+        auto messagesPerSecond = stats.numEnqueued - lastNumEnqueuedMessages;
+        lastNumEnqueuedMessages = stats.numEnqueued;
+
+        auto deadlineSummary = editor->pd->deadlineMonitor.getSummary();
+        if (deadlineSummary.isNotEmpty())
+            deadlineSummary = "\n" + deadlineSummary;
+
+        setTooltip("CPU usage\nGUI messages: " + String(messagesPerSecond) + "/s, " + String(stats.numCoalesced) + " coalesced, " + String(stats.numDropped) + " dropped\nMax queue depth: " + String(stats.maxDepth) + "/" + String(stats.capacity) + deadlineSummary + getBusiestObjects(editor));
+    }
+
+    // While debugging is enabled, messages over connections are counted, so we can show which objects on the current canvas send the most messages
+    // This makes it easy to find runaway message loops
+    String getBusiestObjects(PluginEditor* editor)
+    {
+        auto* cnv = editor->getCurrentCanvas();
+        if (!cnv || !plugdata_debugging_enabled()) {
+            lastMessageCounts.clear();
+            return {};
+        }
+
+        std::unordered_map<Object*, int64> messageRates;
+        std::unordered_map<Connection*, int64> messageCounts;
+        for (auto* connection : cnv->connections) {
+            auto count = connection->getMessageCount();
+            auto lastCount = lastMessageCounts.find(connection);
+            auto rate = count - (lastCount != lastMessageCounts.end() ? lastCount->second : count);
+            messageCounts[connection] = count;
+
+            if (rate > 0 && connection->outobj)
+                messageRates[connection->outobj.get()] += rate;
+        }
+        lastMessageCounts = std::move(messageCounts);
+
+        auto busiest = std::vector<std::pair<Object*, int64>>(messageRates.begin(), messageRates.end());
+        std::sort(busiest.begin(), busiest.end(), [](auto const& a, auto const& b) { return a.second > b.second; });
+
+        String result;
+        for (int i = 0; i < std::min<int>(busiest.size(), 3); i++) {
+            auto text = busiest[i].first->gui ? busiest[i].first->gui->getText() : String();
+            result += "\n" + text.upToFirstOccurrenceOf("\n", false, false).substring(0, 32) + ": " + String(busiest[i].second) + " messages/s";
+        }
+
+        return busiest.empty() ? String() : "\nBusiest objects:" + result;
+    }
+
     bool hitTest(int x, int y) override
     {
         return getLocalBounds().contains(x, y);
@@ -566,12 +677,17 @@ public:
             auto cpuHistory = std::make_unique<CPUMeterPopup>(cpuUsage, cpuUsageLongHistory);
             updateCPUGraph = cpuHistory->getUpdateFunc();
             updateCPUGraphLong = cpuHistory->getUpdateFuncLongHistory();
+            updateBreakdownText = [popup = cpuHistory.get()](String const& text) {
+                popup->setBreakdown(text);
+            };
+            updateBreakdown();
             auto editor = findParentComponentOfClass<PluginEditor>();
             auto bounds = editor->getLocalArea(this, getLocalBounds());
 
             cpuHistory->onClose = [this]() {
                 updateCPUGraph = []() { return; };
                 updateCPUGraphLong = []() { return; };
+                updateBreakdownText = [](String const&) { return; };
                 repaint();
             };
 
@@ -601,6 +717,7 @@ public:
 
     std::function<void()> updateCPUGraph = []() { return; };
     std::function<void()> updateCPUGraphLong = []() { return; };
+    std::function<void(String const&)> updateBreakdownText = [](String const&) { return; };
 
     static inline SafePointer<CallOutBox> currentCalloutBox = nullptr;
     bool isCallOutBoxActive = false;
@@ -609,6 +726,14 @@ public:
     CircularBuffer<float> cpuUsage = CircularBuffer<float>(256);
     CircularBuffer<float> cpuUsageLongHistory = CircularBuffer<float>(512);
     int cpuUsageToDraw = 0;
+    int64 lastNumEnqueuedMessages = 0;
+    std::unordered_map<Connection*, int64> lastMessageCounts;
+
+    StatusbarSource::CPUBreakdown cpuBreakdown;
+    Canvas* lastCanvas = nullptr;
+    int64 lastNumFrames = 0;
+    double lastPaintTimeMs = 0.0;
+    double lastStatisticsTime = 0.0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CPUMeter);
 };
@@ -646,12 +771,14 @@ Statusbar::Statusbar(PluginProcessor* processor)
     debugButton.getToggleStateValue().referTo(SettingsFile::getInstance()->getPropertyAsValue("debug_connections"));
     debugButton.onClick = [this]() {
         set_plugdata_debugging_enabled(debugButton.getToggleState());
+        pd->setMessageProfilingEnabled(debugButton.getToggleState());
         // Recreate the DSP graph with the new optimisations
         pd->lockAudioThread();
         canvas_update_dsp();
         pd->unlockAudioThread();
     };
     set_plugdata_debugging_enabled(debugButton.getToggleState());
+    pd->setMessageProfilingEnabled(debugButton.getToggleState());
     addAndMakeVisible(debugButton);
 
     powerButton.setTooltip("Enable/disable DSP");
@@ -858,6 +985,12 @@ void Statusbar::audioProcessedChanged(bool audioProcessed)
     powerButton.setColour(TextButton::textColourOnId, colour);
 }
 
+void Statusbar::dspSleepChanged(bool sleeping)
+{
+    powerButton.setTooltip(sleeping ? "DSP is sleeping until there's activity" : "Enable/disable DSP");
+    powerButton.setAlpha(sleeping ? 0.5f : 1.0f);
+}
+
 StatusbarSource::StatusbarSource()
     : numChannels(0)
 {
@@ -896,7 +1029,7 @@ void StatusbarSource::process(bool hasMidiInput, bool hasMidiOutput, int channel
 void StatusbarSource::prepareToPlay(int nChannels)
 {
     numChannels = nChannels;
-    peakBuffer.reset(sampleRate, bufferSize, nChannels);
+    peakMeter.reset(sampleRate, nChannels);
 }
 
 void StatusbarSource::timerCallback()
@@ -923,12 +1056,44 @@ void StatusbarSource::timerCallback()
             listener->audioProcessedChanged(hasProcessedAudio);
     }
 
-    auto peak = peakBuffer.getPeak();
+    auto isSleeping = dspSleeping.load(std::memory_order_relaxed);
+    if (isSleeping != dspSleepingState) {
+        dspSleepingState = isSleeping;
+        for (auto* listener : listeners)
+            listener->dspSleepChanged(isSleeping);
+    }
+
+    auto peak = peakMeter.getPeak();
 
     for (auto* listener : listeners) {
         listener->audioLevelChanged(peak);
         listener->cpuUsageChanged(cpuUsage);
     }
+
+    // Update the breakdown twice per second, more often would mostly show noise
+    auto const now = Time::getHighResolutionTicks();
+    auto const elapsed = now - lastBreakdownTime;
+    if (Time::highResolutionTicksToSeconds(elapsed) >= 0.5) {
+        auto const currentDspTicks = dspTicks.load(std::memory_order_relaxed);
+        auto const currentMessageQueueTicks = messageQueueTicks.load(std::memory_order_relaxed);
+        auto const currentInternalSynthTicks = internalSynthTicks.load(std::memory_order_relaxed);
+
+        CPUBreakdown breakdown;
+        if (lastBreakdownTime != 0) {
+            breakdown.dspUsage = 100.0f * static_cast<float>(currentDspTicks - lastDspTicks) / static_cast<float>(elapsed);
+            breakdown.messageQueueUsage = 100.0f * static_cast<float>(currentMessageQueueTicks - lastMessageQueueTicks) / static_cast<float>(elapsed);
+            breakdown.internalSynthUsage = 100.0f * static_cast<float>(currentInternalSynthTicks - lastInternalSynthTicks) / static_cast<float>(elapsed);
+        }
+
+        lastBreakdownTime = now;
+        lastDspTicks = currentDspTicks;
+        lastMessageQueueTicks = currentMessageQueueTicks;
+        lastInternalSynthTicks = currentInternalSynthTicks;
+
+        for (auto* listener : listeners) {
+            listener->cpuBreakdownChanged(breakdown);
+        }
+    }
 }
 
 void StatusbarSource::addListener(Listener* l)
@@ -945,3 +1110,19 @@ void StatusbarSource::setCPUUsage(float cpu)
 {
     cpuUsage = cpu;
 }
+
+void StatusbarSource::addProcessingTime(int64 dspTime, int64 messageQueueTime)
+{
+    dspTicks.fetch_add(dspTime, std::memory_order_relaxed);
+    messageQueueTicks.fetch_add(messageQueueTime, std::memory_order_relaxed);
+}
+
+void StatusbarSource::addInternalSynthTime(int64 renderTime)
+{
+    internalSynthTicks.fetch_add(renderTime, std::memory_order_relaxed);
+}
+
+void StatusbarSource::setDspSleeping(bool sleeping)
+{
+    dspSleeping.store(sleeping, std::memory_order_relaxed);
+}
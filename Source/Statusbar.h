@@ -10,7 +10,7 @@
 #include "LookAndFeel.h"
 #include "Utility/SettingsFile.h"
 #include "Utility/ModifierKeyListener.h"
-#include "Utility/AudioSampleRingBuffer.h"
+#include "Utility/AudioPeakMeter.h"
 #include "Components/Buttons.h"
 
 class Canvas;
@@ -24,12 +24,21 @@ class OversampleSelector;
 class StatusbarSource : public Timer {
 
 public:
+    // Percentage of real time the audio thread spent in each part of processing
+    struct CPUBreakdown {
+        float dspUsage = 0.0f;
+        float messageQueueUsage = 0.0f;
+        float internalSynthUsage = 0.0f;
+    };
+
     struct Listener {
         virtual void midiReceivedChanged(bool midiReceived) { ignoreUnused(midiReceived); }
         virtual void midiSentChanged(bool midiSent) { ignoreUnused(midiSent); }
         virtual void audioProcessedChanged(bool audioProcessed) { ignoreUnused(audioProcessed); }
         virtual void audioLevelChanged(Array<float> peak) { ignoreUnused(peak); }
         virtual void cpuUsageChanged(float newCpuUsage) { ignoreUnused(newCpuUsage); }
+        virtual void cpuBreakdownChanged(CPUBreakdown breakdown) { ignoreUnused(breakdown); }
+        virtual void dspSleepChanged(bool sleeping) { ignoreUnused(sleeping); }
         virtual void timerCallback() { }
     };
 
@@ -50,7 +59,16 @@ public:
 
     void setCPUUsage(float cpuUsage);
 
-    AudioSampleRingBuffer peakBuffer;
+    // Called from the audio thread, with the time spent in Pd's DSP and in processing messages from the GUI
+    void addProcessingTime(int64 dspTime, int64 messageQueueTime);
+
+    // Time the internal GM synth spent rendering, which could be on its own thread
+    void addInternalSynthTime(int64 renderTime);
+
+    // Called from the audio thread when DSP goes to sleep or wakes up again
+    void setDspSleeping(bool sleeping);
+
+    AudioPeakMeter peakMeter;
 
 private:
     std::atomic<int> lastMidiReceivedTime = 0;
@@ -59,6 +77,15 @@ private:
     std::atomic<float> level[2] = { 0 };
     std::atomic<float> peakHold[2] = { 0 };
     std::atomic<float> cpuUsage;
+    std::atomic<int64> dspTicks = 0;
+    std::atomic<int64> messageQueueTicks = 0;
+    std::atomic<int64> internalSynthTicks = 0;
+    std::atomic<bool> dspSleeping = false;
+
+    int64 lastBreakdownTime = 0;
+    int64 lastDspTicks = 0;
+    int64 lastMessageQueueTicks = 0;
+    int64 lastInternalSynthTicks = 0;
 
     int numChannels;
     int bufferSize;
@@ -68,6 +95,7 @@ private:
     bool midiReceivedState = false;
     bool midiSentState = false;
     bool audioProcessedState = false;
+    bool dspSleepingState = false;
     std::vector<Listener*> listeners;
 };
 
@@ -87,6 +115,8 @@ public:
 
     void audioProcessedChanged(bool audioProcessed) override;
 
+    void dspSleepChanged(bool sleeping) override;
+
     bool wasLocked = false; // Make sure it doesn't re-lock after unlocking (because cmd is still down)
 
     std::unique_ptr<LevelMeter> levelMeter;
@@ -0,0 +1,232 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <readerwriterqueue.h>
+#include "RealtimeThreadSettings.h"
+
+// Renders Pd ahead of time on a background thread, for patches that don't consume any input
+// The audio callback only has to copy the rendered output, which gives a lot of headroom against spikes in the patch
+// Whenever the patch does get input, the audio thread stops the background thread and renders into the same ring itself
+// The ring is kept at a fixed depth in both modes, so the latency stays the same, and is reported to the host
+// Only one side renders at a time: the audio thread hands rendering over with startPrerendering and takes it back with stopPrerendering
+class AnticipatoryRenderer : private Thread {
+public:
+    AnticipatoryRenderer()
+        : Thread("Pd pre-renderer")
+    {
+    }
+
+    ~AnticipatoryRenderer() override
+    {
+        stop();
+    }
+
+    // Renders one Pd block without input, called from the background thread. Returns the MIDI output of the block,
+    // or nullptr if it can't render right now. It shouldn't wait for locks, stopPrerendering waits for it to return
+    std::function<MidiBuffer const*(float* const* outputs)> renderBlock;
+
+    // Latency is the depth of the ring, in samples
+    void prepare(int numChannels, int newPdBlockSize, int newLatency, int maxHostBlockSize)
+    {
+        stop();
+
+        pdBlockSize = newPdBlockSize;
+        latency = newLatency;
+
+        auto const size = latency + maxHostBlockSize + pdBlockSize * 2;
+        ring.setSize(numChannels, size);
+        ring.clear();
+        fifo.setTotalSize(size);
+        fifo.reset();
+
+        block.setSize(numChannels, pdBlockSize);
+        blockPointers.resize(numChannels, nullptr);
+        for (int ch = 0; ch < numChannels; ch++) {
+            blockPointers[ch] = block.getWritePointer(ch);
+        }
+
+        midiEvents = moodycamel::ReaderWriterQueue<MidiEvent>(maxMidiEvents);
+        fillWithSilence();
+
+        startThread(Thread::Priority::high);
+    }
+
+    // Audio thread: drops everything that was rendered ahead, and starts over with a ring of silence
+    // Call this when the plugin goes to sleep, otherwise it would play stale audio and MIDI once it wakes up
+    void reset()
+    {
+        stopPrerendering();
+
+        // Nothing was rendered or read since the last reset
+        if (samplesRead == 0 && fifo.getNumReady() == samplesWritten)
+            return;
+
+        while (midiEvents.pop()) { }
+        fifo.reset();
+        fillWithSilence();
+    }
+
+    void stop()
+    {
+        prerendering.store(false);
+        stopThread(1000);
+    }
+
+    int getLatency() const { return latency; }
+    int getNumSamplesAvailable() const { return fifo.getNumReady(); }
+
+    bool isPrerendering() const
+    {
+        return prerendering.load();
+    }
+
+    // Audio thread: let the background thread render from now on
+    void startPrerendering()
+    {
+        prerendering.store(true);
+    }
+
+    // Audio thread: take over rendering. If the background thread is in the middle of a block, this waits for it
+    void stopPrerendering()
+    {
+        prerendering.store(false);
+        while (rendering.load())
+            std::this_thread::yield();
+    }
+
+    // Audio thread: adds a block that was rendered live, MIDI event positions are relative to the start of the block
+    void write(float const* const* outputs, int numSamples, MidiBuffer const& midi)
+    {
+        jassert(!isPrerendering());
+        addToRing(outputs, numSamples, midi);
+    }
+
+    // Audio thread: copies the next samples out of the ring, and adds the MIDI events for them
+    void read(dsp::AudioBlock<float>& destination, MidiBuffer& midi)
+    {
+        auto const numSamples = static_cast<int>(destination.getNumSamples());
+        jassert(fifo.getNumReady() >= numSamples);
+
+        auto const endTime = samplesRead + numSamples;
+        MidiEvent* event;
+        while ((event = midiEvents.peek()) && event->time < endTime) {
+            midi.addEvent(event->data, event->size, static_cast<int>(std::max<int64>(event->time - samplesRead, 0)));
+            midiEvents.pop();
+        }
+
+        auto const numChannels = std::min<int>(ring.getNumChannels(), static_cast<int>(destination.getNumChannels()));
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(numSamples, start1, size1, start2, size2);
+        for (int ch = 0; ch < numChannels; ch++) {
+            auto* dst = destination.getChannelPointer(ch);
+            FloatVectorOperations::copy(dst, ring.getReadPointer(ch, start1), size1);
+            if (size2 > 0)
+                FloatVectorOperations::copy(dst + size1, ring.getReadPointer(ch, start2), size2);
+        }
+        fifo.finishedRead(size1 + size2);
+        samplesRead += size1 + size2;
+    }
+
+private:
+    // Start with a full ring of silence, that's where the latency comes from
+    void fillWithSilence()
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(latency, start1, size1, start2, size2);
+        ring.clear(start1, size1);
+        if (size2 > 0)
+            ring.clear(start2, size2);
+        fifo.finishedWrite(size1 + size2);
+
+        samplesWritten = size1 + size2;
+        samplesRead = 0;
+    }
+
+    struct MidiEvent {
+        int64 time; // In samples since the renderer was prepared
+        uint8 data[16];
+        int size;
+    };
+
+    void run() override
+    {
+        RealtimeThreadSettings::ThreadState threadState;
+        while (!threadShouldExit()) {
+            // Renders the same kind of work as the DSP workers, so it gets their priority and cores
+            RealtimeThreadSettings::getInstance().applyToCurrentThread(RealtimeThreadSettings::DspWorker, threadState);
+            if (!renderAhead())
+                wait(1);
+        }
+    }
+
+    // Renders one block if prerendering and the ring isn't at its depth yet
+    bool renderAhead()
+    {
+        if (!prerendering.load() || fifo.getNumReady() + pdBlockSize > latency)
+            return false;
+
+        // Check again after announcing that we're rendering, stopPrerendering might have been called in between
+        rendering.store(true);
+        if (!prerendering.load()) {
+            rendering.store(false);
+            return false;
+        }
+
+        auto const* midi = renderBlock(blockPointers.data());
+        if (midi)
+            addToRing(blockPointers.data(), pdBlockSize, *midi);
+
+        rendering.store(false);
+        return midi != nullptr;
+    }
+
+    void addToRing(float const* const* source, int numSamples, MidiBuffer const& midi)
+    {
+        for (auto const metadata : midi) {
+            // Short messages fit, also when the standalone wraps them with their device. The queue doesn't grow, so this won't allocate
+            if (metadata.numBytes > static_cast<int>(sizeof(MidiEvent::data)))
+                continue;
+
+            MidiEvent event { samplesWritten + metadata.samplePosition, {}, metadata.numBytes };
+            std::copy(metadata.data, metadata.data + metadata.numBytes, event.data);
+            midiEvents.try_enqueue(event);
+        }
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+        jassert(size1 + size2 == numSamples);
+
+        for (int ch = 0; ch < ring.getNumChannels(); ch++) {
+            FloatVectorOperations::copy(ring.getWritePointer(ch, start1), source[ch], size1);
+            if (size2 > 0)
+                FloatVectorOperations::copy(ring.getWritePointer(ch, start2), source[ch] + size1, size2);
+        }
+        fifo.finishedWrite(size1 + size2);
+        samplesWritten += size1 + size2;
+    }
+
+    static constexpr size_t maxMidiEvents = 4096;
+
+    AbstractFifo fifo = AbstractFifo(1);
+    AudioBuffer<float> ring;
+    AudioBuffer<float> block;
+    std::vector<float*> blockPointers;
+    moodycamel::ReaderWriterQueue<MidiEvent> midiEvents;
+
+    // samplesWritten is only touched by the side that is rendering, the handover through the atomics below orders it
+    // samplesRead is only touched by the audio thread, in read() and when resetting
+    int64 samplesWritten = 0;
+    int64 samplesRead = 0;
+
+    int pdBlockSize = 64;
+    int latency = 0;
+
+    std::atomic<bool> prerendering = false;
+    std::atomic<bool> rendering = false;
+};
@@ -0,0 +1,133 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Loads a soundfile into a pd array on a background thread
+// If the format allows it, the file is memory-mapped instead of read into memory first
+// The samples are copied into the array in chunks through the instance's function queue, so neither the message thread
+// nor the audio thread have to wait for the whole file to be read
+class ArraySoundFileLoader : private Thread {
+public:
+    ArraySoundFileLoader(pd::Instance* instance, pd::WeakReference array, File fileToLoad, std::function<void(bool)> onDone)
+        : Thread("Soundfile loader")
+        , pd(instance)
+        , arr(std::move(array))
+        , file(std::move(fileToLoad))
+        , onLoadingFinished(std::move(onDone))
+    {
+        startThread();
+    }
+
+    ~ArraySoundFileLoader() override
+    {
+        stopThread(-1);
+    }
+
+    static bool isSoundFile(File const& file)
+    {
+        return file.hasFileExtension("wav;aif;aiff;flac;ogg;mp3");
+    }
+
+private:
+    void run() override
+    {
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<AudioFormatReader> reader;
+        if (auto* format = formatManager.findFormatForFileExtension(file.getFileExtension())) {
+            // Only wav and aiff can be memory-mapped, for other formats this returns nullptr
+            auto mappedReader = std::unique_ptr<MemoryMappedAudioFormatReader>(format->createMemoryMappedReader(file));
+            if (mappedReader && mappedReader->mapEntireFile()) {
+                reader = std::move(mappedReader);
+            }
+        }
+
+        if (!reader) {
+            reader.reset(formatManager.createReaderFor(file));
+        }
+
+        if (!reader || reader->lengthInSamples <= 0) {
+            finish(false);
+            return;
+        }
+
+        // pd stores array sizes as an int
+        auto const length = std::min<int64>(reader->lengthInSamples, std::numeric_limits<int>::max());
+
+        pd->enqueueFunctionAsync([array = arr, length]() {
+            if (auto ptr = array.get<t_garray>()) {
+                garray_resize_long(ptr.get(), static_cast<long>(length));
+            }
+        });
+
+        AudioBuffer<float> buffer(1, chunkSize);
+        for (int64 position = 0; position < length; position += chunkSize) {
+            // Don't let the queue fill up with chunks faster than the audio thread copies them, that would defeat the memory-mapping
+            while (numPendingChunks->load() >= maxPendingChunks) {
+                if (threadShouldExit())
+                    return;
+                wait(2);
+            }
+
+            if (threadShouldExit())
+                return;
+
+            auto const numSamples = static_cast<int>(std::min<int64>(chunkSize, length - position));
+            reader->read(&buffer, 0, numSamples, position, true, false);
+
+            auto chunk = std::vector<float>(buffer.getReadPointer(0), buffer.getReadPointer(0) + numSamples);
+
+            (*numPendingChunks)++;
+            pd->enqueueFunctionAsync([array = arr, position, chunk = std::move(chunk), pendingChunks = numPendingChunks]() {
+                (*pendingChunks)--;
+
+                auto ptr = array.get<t_garray>();
+                if (!ptr)
+                    return;
+
+                auto const arraySize = static_cast<int64>(garray_getarray(ptr.get())->a_n);
+                auto* words = ((t_word*)garray_vec(ptr.get()));
+                auto const numToWrite = std::min<int64>(static_cast<int64>(chunk.size()), arraySize - std::min(position, arraySize));
+                for (int64 n = 0; n < numToWrite; n++) {
+                    words[position + n].w_float = chunk[n];
+                }
+            });
+        }
+
+        pd->enqueueFunctionAsync([instance = pd, array = arr]() {
+            if (auto ptr = array.get<t_fake_garray>()) {
+                instance->arrayChanges.markChanged(ptr.get());
+
+                // Notifies the patch: redraws all views of this array, and marks the patch as modified in case the array saves its contents
+                garray_redraw(ptr.cast<t_garray>());
+                canvas_dirty(glist_getcanvas(ptr->x_glist), 1);
+            }
+        });
+
+        finish(true);
+    }
+
+    void finish(bool success)
+    {
+        MessageManager::callAsync([onDone = onLoadingFinished, success]() {
+            if (onDone)
+                onDone(success);
+        });
+    }
+
+    static constexpr int chunkSize = 65536;
+    static constexpr int maxPendingChunks = 8;
+
+    pd::Instance* pd;
+    pd::WeakReference arr;
+    File file;
+    std::function<void(bool)> onLoadingFinished;
+
+    // Shared with the queued chunks, since the loader could be deleted before they are processed
+    std::shared_ptr<std::atomic<int>> numPendingChunks = std::make_shared<std::atomic<int>>(0);
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+
+// Peak meter for the statusbar level meter
+// The audio thread finds the peak of every block and publishes it once per window, so it never has to wait for the GUI
+// The GUI only needs to read one atomic per channel to get the last window's peak
+class AudioPeakMeter {
+public:
+    AudioPeakMeter()
+    {
+    }
+
+    void reset(double sourceSampleRate, int numChannels)
+    {
+        sampleRate = sourceSampleRate;
+        windowSize = std::max(1, static_cast<int>(sampleRate / 60));
+        numMeteredChannels = std::clamp(numChannels, 0, maxChannels);
+        samplesInWindow = 0;
+
+        for (int ch = 0; ch < maxChannels; ch++) {
+            windowPeak[ch] = 0.0f;
+            peak[ch].store(0.0f);
+        }
+    }
+
+    // Called from the audio thread
+    void write(AudioBuffer<float>& samples)
+    {
+        auto const numSamples = samples.getNumSamples();
+        auto const numChannels = std::min(numMeteredChannels.load(), samples.getNumChannels());
+
+        for (int ch = 0; ch < numChannels; ch++) {
+            auto range = FloatVectorOperations::findMinAndMax(samples.getReadPointer(ch), numSamples);
+            windowPeak[ch] = std::max({ windowPeak[ch], std::abs(range.getStart()), std::abs(range.getEnd()) });
+        }
+
+        samplesInWindow += numSamples;
+        if (samplesInWindow >= windowSize) {
+            for (int ch = 0; ch < maxChannels; ch++) {
+                peak[ch].store(windowPeak[ch], std::memory_order_relaxed);
+                windowPeak[ch] = 0.0f;
+            }
+            samplesInWindow = 0;
+        }
+    }
+
+    Array<float> getPeak()
+    {
+        if (sampleRate == 0)
+            return { 0.0f, 0.0f };
+
+        Array<float> result;
+        for (int ch = 0; ch < numMeteredChannels; ch++) {
+            result.add(std::sqrt(peak[ch].load(std::memory_order_relaxed)));
+        }
+        return result;
+    }
+
+private:
+    // The level meter only displays two channels
+    static constexpr int maxChannels = 2;
+
+    // Only accessed by the audio thread
+    float windowPeak[maxChannels] = { 0.0f };
+    int samplesInWindow = 0;
+    int windowSize = 1;
+
+    std::atomic<float> peak[maxChannels] = { 0.0f };
+    std::atomic<int> numMeteredChannels = 0;
+    std::atomic<double> sampleRate = 0;
+};
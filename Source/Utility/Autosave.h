@@ -1,6 +1,7 @@
 #pragma once
 #include <readerwriterqueue.h>
 #include "Dialogs/Dialogs.h"
+#include "Utility/Tracing.h"
 
 class Autosave : public Timer
     , public AsyncUpdater
@@ -8,12 +9,25 @@ class Autosave : public Timer
 
     static inline File const autoSaveFile = ProjectInfo::appDataDir.getChildFile(".autosave");
     static inline ValueTree autoSaveTree = ValueTree("Autosave");
+
+    // Autosaves are appended to the journal, and only written to the autosave file once the journal gets too big
+    // All instances write to the same files
+    static inline File const journalFile = ProjectInfo::appDataDir.getChildFile(".autosave_journal");
+    static inline CriticalSection fileLock;
+    static constexpr int64 maxJournalSize = 8 * 1024 * 1024;
+    static constexpr int maxAutosaves = 15;
     Value autosaveInterval;
     Value autosaveEnabled;
 
     PluginProcessor* pd;
     moodycamel::ReaderWriterQueue<std::pair<String, String>> autoSaveQueue;
 
+    // Patches that still need to be saved in the current autosave round
+    // They're saved one per audio block, so a session with many big patches doesn't serialise all of them in the same block
+    // Only the canvases are stored: if the audio thread released the last reference to a closed patch, it would be closed there
+    std::vector<pd::WeakReference> patchesToSave;
+    Array<ValueTree> unwrittenRecords;
+
 public:
     Autosave(PluginProcessor* procesor)
         : pd(procesor)
@@ -28,6 +42,8 @@ public:
                 autoSaveTree = ValueTree("Autosave");
         }
 
+        replayJournal();
+
         autosaveEnabled.referTo(SettingsFile::getInstance()->getPropertyAsValue("autosave_enabled"));
 
         // autosave timer trigger
@@ -67,6 +83,17 @@ public:
         }
     }
 
+    // Number of autosaved patches, and the size of their content, which we keep in memory
+    static std::pair<int, size_t> getAutosaveSize()
+    {
+        size_t numBytes = 0;
+        for (auto const& patch : autoSaveTree) {
+            numBytes += patch.getProperty("Patch").toString().getNumBytesAsUTF8();
+        }
+
+        return { autoSaveTree.getNumChildren(), numBytes };
+    }
+
 private:
     void valueChanged(Value& v) override
     {
@@ -81,35 +108,58 @@ private:
         if (!getValue<bool>(autosaveEnabled))
             return;
 
-        pd->enqueueFunctionAsync([this]() {
-            save();
+        // The previous round is still going
+        if (!patchesToSave.empty())
+            return;
+
+        for (auto& patch : pd->patches) {
+            // Simple way to filter out plugdata default patches which we don't want to save.
+            if (patch->isDirty() && !isInternalPatch(patch->getPatchFile())) {
+                if (auto cnv = patch->getPointer())
+                    patchesToSave.emplace_back(cnv.get(), pd);
+            }
+        }
+
+        saveNextPatch();
+    }
+
+    void saveNextPatch()
+    {
+        if (patchesToSave.empty())
+            return;
+
+        // Serialising needs to happen on the audio thread, but we only do one patch at a time
+        // handleAsyncUpdate queues the next one after this one is done
+        pd->enqueueFunctionAsync([this, canvas = patchesToSave.front()]() {
+            save(canvas);
         });
+        patchesToSave.erase(patchesToSave.begin());
     }
 
-    void save()
+    void save(pd::WeakReference const& canvas)
     {
-        for (auto& patch : pd->patches) {
-            if (!patch->isDirty())
-                continue;
+        Tracing::ScopedEvent traceEvent("Autosave");
 
+        // The patch could have been closed since it was queued
+        pd->lockAudioThread();
+        if (auto cnv = canvas.get<t_canvas>()) {
             // Check if patch is a root canvas
             bool isRootCanvas = false;
             for (auto* x = pd_getcanvaslist(); x; x = x->gl_next) {
-                if (x == patch->getPointer().get()) {
+                if (x == cnv.get()) {
                     isRootCanvas = true;
                     break;
                 }
             }
-            if (!isRootCanvas)
-                continue;
 
-            auto patchFile = patch->getPatchFile();
-
-            // Simple way to filter out plugdata default patches which we don't want to save.
-            if (!isInternalPatch(patchFile)) {
-                autoSaveQueue.enqueue({ patchFile.getFullPathName(), patch->getCanvasContent() });
+            for (auto* patch : pd->patchObjects) {
+                if (isRootCanvas && patch->getUncheckedPointer() == cnv.get()) {
+                    autoSaveQueue.enqueue({ patch->getPatchFile().getFullPathName(), patch->getCanvasContent() });
+                    break;
+                }
             }
         }
+        pd->unlockAudioThread();
 
         triggerAsyncUpdate();
     }
@@ -126,49 +176,132 @@ private:
         while (autoSaveQueue.try_dequeue(pathAndContent)) {
             auto& [path, content] = pathAndContent;
 
-            // Make sure we get current time in the correct format used by the OS for file modification time
-            auto tempFile = File::createTempFile("temp_time_test");
-            tempFile.create();
-            auto time = tempFile.getCreationTime().toMilliseconds();
-            tempFile.deleteFile();
-
+            // Patches can stay dirty for a long time without changing, no need to save them again
+            auto const hash = String::toHexString(content.hashCode64());
             auto existingPatch = autoSaveTree.getChildWithProperty("Path", path);
+            if (existingPatch.isValid() && existingPatch.getProperty("Hash").toString() == hash)
+                continue;
 
-            if (existingPatch.isValid()) {
-                existingPatch.setProperty("Patch", Base64::toBase64(content), nullptr);
-                existingPatch.setProperty("LastModified", (int64)time, nullptr);
-            } else {
-                ValueTree newAutoSave = ValueTree("Save");
-                newAutoSave.setProperty("Path", path, nullptr);
-                newAutoSave.setProperty("Patch", Base64::toBase64(content), nullptr);
-                newAutoSave.setProperty("LastModified", (int64)time, nullptr);
-                autoSaveTree.addChild(newAutoSave, 0, nullptr);
-
-                if (autoSaveTree.getNumChildren() > 15) {
-                    int64 oldestTime = std::numeric_limits<int64>::max();
-                    int oldestIdx = -1;
-                    int currentIdx = 0;
-                    for (auto autoSave : autoSaveTree) {
-                        auto modifiedTime = static_cast<int64>(autoSave.getProperty("LastModified"));
-                        if (modifiedTime < oldestTime) {
-                            oldestTime = modifiedTime;
-                            oldestIdx = currentIdx;
-                        }
-                        currentIdx++;
-                    }
-                    if (oldestIdx >= 0) {
-                        autoSaveTree.removeChild(oldestIdx, nullptr);
-                    }
+            ValueTree record("Save");
+            record.setProperty("Path", path, nullptr);
+            record.setProperty("Patch", Base64::toBase64(content), nullptr);
+            record.setProperty("LastModified", Time::currentTimeMillis(), nullptr);
+            record.setProperty("Hash", hash, nullptr);
+
+            applyRecord(record);
+            unwrittenRecords.add(record.createCopy());
+        }
+
+        // Write once, after the last patch of this round
+        if (!patchesToSave.empty()) {
+            saveNextPatch();
+            return;
+        }
+
+        if (unwrittenRecords.isEmpty())
+            return;
+
+        writeThread.addJob([records = std::move(unwrittenRecords), snapshot = autoSaveTree.createCopy()]() {
+            ScopedLock lock(fileLock);
+
+            // Once the journal gets too big, write everything to the autosave file and start a new journal
+            if (journalFile.getSize() > maxJournalSize) {
+                MemoryOutputStream ostream;
+                snapshot.writeToStream(ostream);
+                if (autoSaveFile.replaceWithData(ostream.getData(), ostream.getDataSize()))
+                    journalFile.deleteFile();
+                return;
+            }
+
+            FileOutputStream ostream(journalFile);
+            if (!ostream.openedOk())
+                return;
+
+            for (auto const& record : records) {
+                MemoryOutputStream compressed;
+                {
+                    GZIPCompressorOutputStream gzip(compressed);
+                    record.writeToStream(gzip);
+                }
+
+                ostream.writeInt(static_cast<int>(compressed.getDataSize()));
+                ostream.write(compressed.getData(), compressed.getDataSize());
+            }
+        });
+        unwrittenRecords.clear();
+    }
+
+    // Adds or replaces an autosaved patch, and removes the oldest one if we have too many
+    static void applyRecord(ValueTree const& record)
+    {
+        auto existingPatch = autoSaveTree.getChildWithProperty("Path", record.getProperty("Path"));
+        if (existingPatch.isValid()) {
+            existingPatch.copyPropertiesFrom(record, nullptr);
+            return;
+        }
+
+        autoSaveTree.addChild(record.createCopy(), 0, nullptr);
+
+        if (autoSaveTree.getNumChildren() > maxAutosaves) {
+            int64 oldestTime = std::numeric_limits<int64>::max();
+            int oldestIdx = -1;
+            int currentIdx = 0;
+            for (auto autoSave : autoSaveTree) {
+                auto modifiedTime = static_cast<int64>(autoSave.getProperty("LastModified"));
+                if (modifiedTime < oldestTime) {
+                    oldestTime = modifiedTime;
+                    oldestIdx = currentIdx;
                 }
+                currentIdx++;
+            }
+            if (oldestIdx >= 0) {
+                autoSaveTree.removeChild(oldestIdx, nullptr);
             }
         }
+    }
+
+    // Applies the autosaves that were written to the journal after the autosave file
+    static void replayJournal()
+    {
+        ScopedLock lock(fileLock);
+
+        // End of the last complete record
+        int64 validSize = 0;
+        {
+            FileInputStream istream(journalFile);
+            if (!istream.openedOk())
+                return;
+
+            while (!istream.isExhausted()) {
+                auto const size = istream.readInt();
 
-        autoSaveFile.replaceWithText("");
-        FileOutputStream ostream(autoSaveFile);
-        autoSaveTree.writeToStream(ostream);
+                // The last record could be incomplete if we crashed while writing it
+                MemoryBlock compressed;
+                if (size <= 0 || istream.readIntoMemoryBlock(compressed, size) != static_cast<size_t>(size))
+                    break;
+
+                validSize = istream.getPosition();
+
+                MemoryInputStream compressedStream(compressed, false);
+                GZIPDecompressorInputStream gzip(compressedStream);
+                auto record = ValueTree::readFromStream(gzip);
+                if (record.hasType("Save"))
+                    applyRecord(record);
+            }
+        }
+
+        // Cut off the incomplete record, otherwise new records would be appended after it, and we'd never get to them
+        if (validSize < journalFile.getSize()) {
+            FileOutputStream ostream(journalFile);
+            if (ostream.openedOk() && ostream.setPosition(validSize))
+                ostream.truncate();
+        }
     }
 
     friend class AutosaveHistoryComponent;
+
+    // Declared last, so it finishes writing before the rest is deleted
+    ThreadPool writeThread = ThreadPool(1);
 };
 
 class AutosaveHistoryComponent : public Component {
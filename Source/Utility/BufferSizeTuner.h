@@ -0,0 +1,127 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <juce_audio_devices/juce_audio_devices.h>
+#include "Utility/DeadlineMonitor.h"
+
+// Finds the smallest buffer size of the current audio device at which the patch still leaves enough headroom
+// Starting from the smallest size, each one runs for a warmup period while we keep track of the slowest block, relative to the buffer period
+// The first size where no block took more than (1 - headroom) of its period is kept, if none of them manage that we go back to the original size
+class BufferSizeTuner : private Timer {
+public:
+    BufferSizeTuner(AudioDeviceManager& audioDeviceManager, DeadlineMonitor& monitor)
+        : deviceManager(audioDeviceManager)
+        , deadlineMonitor(monitor)
+    {
+    }
+
+    ~BufferSizeTuner() override
+    {
+        cancel();
+    }
+
+    // Headroom is the part of each buffer period that should stay unused, the callback gets a description of the result
+    void start(float headroomToKeep, std::function<void(String const&)> onFinished)
+    {
+        cancel();
+
+        auto* device = deviceManager.getCurrentAudioDevice();
+        if (!device) {
+            onFinished("Buffer size auto-tune: no audio device is open");
+            return;
+        }
+
+        candidates = device->getAvailableBufferSizes();
+        candidates.sort();
+        originalBufferSize = device->getCurrentBufferSizeSamples();
+        headroom = jlimit(0.0f, 0.9f, headroomToKeep);
+        finishCallback = std::move(onFinished);
+        currentCandidate = -1;
+
+        tryNextCandidate();
+    }
+
+    bool isRunning() const
+    {
+        return isTimerRunning();
+    }
+
+    // Goes back to the buffer size we started with
+    void cancel()
+    {
+        if (!isTimerRunning())
+            return;
+
+        stopTimer();
+        setBufferSize(originalBufferSize);
+    }
+
+private:
+    void tryNextCandidate()
+    {
+        currentCandidate++;
+        if (currentCandidate >= candidates.size()) {
+            stopTimer();
+            setBufferSize(originalBufferSize);
+            finishCallback("Buffer size auto-tune: no buffer size kept " + String(roundToInt(headroom * 100.0f)) + "% headroom, staying at " + String(originalBufferSize) + " samples");
+            return;
+        }
+
+        setBufferSize(candidates[currentCandidate]);
+        measuringStartTime = Time::getMillisecondCounter() + settleTimeMs;
+        peakLoad = 0.0f;
+        startTimer(100);
+    }
+
+    void timerCallback() override
+    {
+        auto const now = Time::getMillisecondCounter();
+        auto const blockLoad = deadlineMonitor.takePeakBlockLoad();
+
+        // Reopening the device gives a few slow blocks, those shouldn't count
+        if (now < measuringStartTime)
+            return;
+
+        peakLoad = std::max(peakLoad, blockLoad);
+
+        // No need to wait for the whole warmup once it's clear this size is too small
+        if (peakLoad > 1.0f - headroom) {
+            tryNextCandidate();
+            return;
+        }
+
+        if (now - measuringStartTime >= warmupTimeMs) {
+            stopTimer();
+            finishCallback("Buffer size auto-tune: using " + String(candidates[currentCandidate]) + " samples, slowest block took " + String(roundToInt(peakLoad * 100.0f)) + "% of its period");
+        }
+    }
+
+    void setBufferSize(int bufferSize)
+    {
+        auto setup = deviceManager.getAudioDeviceSetup();
+        if (setup.bufferSize == bufferSize)
+            return;
+
+        setup.bufferSize = bufferSize;
+        deviceManager.setAudioDeviceSetup(setup, true);
+    }
+
+    static constexpr uint32 settleTimeMs = 500;
+    static constexpr uint32 warmupTimeMs = 3000;
+
+    AudioDeviceManager& deviceManager;
+    DeadlineMonitor& deadlineMonitor;
+
+    Array<int> candidates;
+    int currentCandidate = -1;
+    int originalBufferSize = 0;
+    float headroom = 0.3f;
+    float peakLoad = 0.0f;
+    uint32 measuringStartTime = 0;
+    std::function<void(String const&)> finishCallback;
+};
@@ -36,7 +36,12 @@ struct ProjectInfo {
     static bool isMidiEffect() noexcept;
     static bool canUseSemiTransparentWindows();
 
+    // Externals in here are compiled for one float size, so the double precision build keeps its own folder
+#if PD_FLOATSIZE == 64
+    static inline File const appDataDir = File::getSpecialLocation(File::SpecialLocationType::userDocumentsDirectory).getChildFile("plugdata-double");
+#else
     static inline File const appDataDir = File::getSpecialLocation(File::SpecialLocationType::userDocumentsDirectory).getChildFile("plugdata");
+#endif
 
     static inline String const versionSuffix = "-3";
     static inline File const versionDataDir = appDataDir.getChildFile("Versions").getChildFile(ProjectInfo::versionString + versionSuffix);
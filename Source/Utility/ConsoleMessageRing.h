@@ -0,0 +1,160 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Fixed-capacity storage for console messages
+// The text of all messages lives in one preallocated UTF-8 arena that is reused as old messages fall out,
+// so adding messages never allocates. A String is only created when a message actually gets drawn or copied
+class ConsoleMessageRing {
+public:
+    struct Message {
+        void* object = nullptr;
+        int type = 0;
+        int length = 0; // approximate width in pixels, when drawn on a single line
+        int repeats = 0;
+        int textStart = 0;
+        int textSize = 0;
+    };
+
+    static constexpr int maxMessages = 800;
+    static constexpr int arenaSize = 1 << 18;
+    static constexpr int maxMessageSize = 4096;
+
+    ConsoleMessageRing()
+        : messages(maxMessages)
+        , arena(arenaSize)
+    {
+    }
+
+    int size() const
+    {
+        return numMessages;
+    }
+
+    bool empty() const
+    {
+        return numMessages == 0;
+    }
+
+    // Index 0 is the oldest message
+    Message& operator[](int index)
+    {
+        return messages[(firstMessage + index) % maxMessages];
+    }
+
+    Message const& operator[](int index) const
+    {
+        return messages[(firstMessage + index) % maxMessages];
+    }
+
+    String getText(Message const& message) const
+    {
+        return String::fromUTF8(arena.data() + message.textStart, message.textSize);
+    }
+
+    String getText(int index) const
+    {
+        return getText((*this)[index]);
+    }
+
+    // Number of messages that fell out of the ring or were cleared, so numRemoved + index identifies a message while it's in the ring
+    int64 getNumRemoved() const
+    {
+        return numRemoved;
+    }
+
+    // Adds a message, or adds to the repeat counter of the last message if it has the same text
+    void add(void* object, int type, char const* text, int textSize, int length, int repeats = 1)
+    {
+        textSize = std::min(textSize, maxMessageSize);
+
+        if (numMessages) {
+            auto& last = (*this)[numMessages - 1];
+            if (last.object == object && last.type == type && last.textSize == textSize && std::memcmp(arena.data() + last.textStart, text, textSize) == 0) {
+                last.repeats += repeats;
+                return;
+            }
+        }
+
+        if (numMessages == maxMessages)
+            removeOldest();
+
+        auto const textStart = allocateText(textSize);
+        std::memcpy(arena.data() + textStart, text, textSize);
+        writePosition = textStart + textSize;
+
+        messages[(firstMessage + numMessages) % maxMessages] = { object, type, length, repeats, textStart, textSize };
+        numMessages++;
+    }
+
+    void addRepeats(int repeats)
+    {
+        if (numMessages)
+            (*this)[numMessages - 1].repeats += repeats;
+    }
+
+    // Copies all messages of another ring to the end of this one, dropping the oldest messages if we run out of space
+    void append(ConsoleMessageRing const& other)
+    {
+        for (int i = 0; i < other.size(); i++) {
+            auto const& message = other[i];
+            add(message.object, message.type, other.arena.data() + message.textStart, message.textSize, message.length, message.repeats);
+        }
+    }
+
+    void removeOldest()
+    {
+        if (!numMessages)
+            return;
+
+        firstMessage = (firstMessage + 1) % maxMessages;
+        numMessages--;
+        numRemoved++;
+
+        if (!numMessages)
+            clear();
+    }
+
+    void clear()
+    {
+        numRemoved += numMessages;
+        firstMessage = 0;
+        numMessages = 0;
+        writePosition = 0;
+    }
+
+private:
+    // Finds space for the text of a new message, removing the oldest messages until it fits
+    int allocateText(int textSize)
+    {
+        while (numMessages) {
+            auto const oldestStart = (*this)[0].textStart;
+            if (writePosition > oldestStart) {
+                // The used part of the arena doesn't wrap around, so there is free space at the end and at the start
+                if (writePosition + textSize <= arenaSize)
+                    return writePosition;
+                if (textSize <= oldestStart)
+                    return 0;
+            } else if (writePosition + textSize <= oldestStart) {
+                // The used part of the arena wraps around, so the only free space is in between
+                return writePosition;
+            }
+
+            removeOldest();
+        }
+
+        return 0;
+    }
+
+    std::vector<Message> messages;
+    std::vector<char> arena;
+
+    int firstMessage = 0;
+    int numMessages = 0;
+    int writePosition = 0;
+    int64 numRemoved = 0;
+};
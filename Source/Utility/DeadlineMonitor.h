@@ -0,0 +1,170 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <juce_events/juce_events.h>
+#include <readerwriterqueue.h>
+
+// Detects audio blocks that took longer than the host's buffer period, which will usually be heard as a dropout
+// For every overrun we remember what else was going on during that block, so we can tell what caused it
+// The audio thread only pushes overruns into a preallocated queue, the message thread collects them into a history and logs them
+class DeadlineMonitor : private Timer {
+public:
+    enum Cause {
+        WaitedForLock = 1 << 0,   // The message thread was holding the audio lock
+        MessageBacklog = 1 << 1,  // Lots of messages from the GUI were processed during this block
+        PatchEdited = 1 << 2,     // The patch was edited, which means Pd had to rebuild the DSP chain
+    };
+
+    // What happened during a block, filled in by the audio thread while processing
+    struct BlockActivity {
+        int64 lockWaitTicks = 0;
+        int numMessagesProcessed = 0;
+        bool patchEdited = false;
+    };
+
+    struct Overrun {
+        int64 timeMillis;
+        float blockMs;
+        float deadlineMs;
+        float lockWaitMs;
+        int numMessagesProcessed;
+        int causes;
+
+        String getDescription() const
+        {
+            StringArray causeNames;
+            if (causes & WaitedForLock)
+                causeNames.add("waited " + String(lockWaitMs, 1) + "ms for the audio lock");
+            if (causes & MessageBacklog)
+                causeNames.add("processed " + String(numMessagesProcessed) + " GUI messages");
+            if (causes & PatchEdited)
+                causeNames.add("patch was edited");
+
+            auto description = String(blockMs, 1) + "ms of " + String(deadlineMs, 1) + "ms";
+            return causeNames.isEmpty() ? description : description + " (" + causeNames.joinIntoString(", ") + ")";
+        }
+    };
+
+    std::function<void(String const&)> onOverrun = [](String const&) { };
+
+    DeadlineMonitor()
+    {
+        startTimer(500);
+    }
+
+    void prepareToPlay(double sampleRate)
+    {
+        hostSampleRate = sampleRate;
+    }
+
+    // Called from the audio thread
+    void blockStarted()
+    {
+        blockStartTicks = Time::getHighResolutionTicks();
+    }
+
+    // Called from the audio thread
+    void blockFinished(int numSamples, BlockActivity const& activity)
+    {
+        if (hostSampleRate <= 0.0)
+            return;
+
+        auto const blockSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - blockStartTicks);
+        auto const deadlineSeconds = numSamples / hostSampleRate;
+
+        // Only the audio thread raises this, so a plain load and store is enough
+        auto const blockLoad = static_cast<float>(blockSeconds / deadlineSeconds);
+        if (blockLoad > peakBlockLoad.load(std::memory_order_relaxed))
+            peakBlockLoad.store(blockLoad, std::memory_order_relaxed);
+
+        if (blockSeconds <= deadlineSeconds)
+            return;
+
+        auto const lockWaitSeconds = Time::highResolutionTicksToSeconds(activity.lockWaitTicks);
+
+        int causes = 0;
+        if (lockWaitSeconds > deadlineSeconds * 0.1)
+            causes |= WaitedForLock;
+        if (activity.numMessagesProcessed > messageBacklogThreshold)
+            causes |= MessageBacklog;
+        if (activity.patchEdited)
+            causes |= PatchEdited;
+
+        // If the queue is full, the message thread is too busy to collect them, we'll just lose this one
+        overrunQueue.try_enqueue({ Time::currentTimeMillis(), static_cast<float>(blockSeconds * 1000.0), static_cast<float>(deadlineSeconds * 1000.0), static_cast<float>(lockWaitSeconds * 1000.0), activity.numMessagesProcessed, causes });
+    }
+
+    int getNumOverruns() const
+    {
+        return numOverruns;
+    }
+
+    // Time the slowest block since the last call took, relative to the buffer period
+    float takePeakBlockLoad()
+    {
+        return peakBlockLoad.exchange(0.0f, std::memory_order_relaxed);
+    }
+
+    // Short summary of the most recent overruns, for tooltips
+    String getSummary(int maxOverrunsToShow = 3) const
+    {
+        if (history.empty())
+            return {};
+
+        auto const now = Time::currentTimeMillis();
+
+        String summary = "Missed deadlines: " + String(numOverruns);
+        for (int i = 0; i < std::min<int>(maxOverrunsToShow, history.size()); i++) {
+            auto const& overrun = history[history.size() - 1 - i];
+            auto const secondsAgo = (now - overrun.timeMillis) / 1000;
+            summary += "\n" + String(secondsAgo) + "s ago: " + overrun.getDescription();
+        }
+
+        return summary;
+    }
+
+private:
+    void timerCallback() override
+    {
+        Overrun overrun;
+        int numNewOverruns = 0;
+        Overrun worstOverrun {};
+
+        while (overrunQueue.try_dequeue(overrun)) {
+            history.push_back(overrun);
+            if (history.size() > maxHistorySize)
+                history.pop_front();
+
+            if (numNewOverruns == 0 || overrun.blockMs > worstOverrun.blockMs)
+                worstOverrun = overrun;
+
+            numNewOverruns++;
+        }
+
+        if (numNewOverruns == 0)
+            return;
+
+        numOverruns += numNewOverruns;
+
+        // Log at most one line per timer callback, so a patch that keeps missing its deadline can't flood the console
+        auto const prefix = numNewOverruns == 1 ? String("Audio block missed its deadline: ") : String(numNewOverruns) + " audio blocks missed their deadline, worst: ";
+        onOverrun(prefix + worstOverrun.getDescription());
+    }
+
+    static constexpr int messageBacklogThreshold = 64;
+    static constexpr size_t maxHistorySize = 64;
+
+    double hostSampleRate = 0.0;
+    int64 blockStartTicks = 0;
+    std::atomic<float> peakBlockLoad = 0.0f;
+
+    moodycamel::ReaderWriterQueue<Overrun> overrunQueue = moodycamel::ReaderWriterQueue<Overrun>(128);
+
+    std::deque<Overrun> history;
+    int numOverruns = 0;
+};
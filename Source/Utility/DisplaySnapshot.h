@@ -0,0 +1,88 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Lock-free triple buffer, used to pass display data from the audio thread to the message thread without either side ever waiting
+// The writer always has a free buffer to write into, and the reader always gets the most recently published buffer
+template<typename T>
+class TripleBuffer {
+public:
+    // Only call from the writing thread
+    T& getWriteBuffer()
+    {
+        return buffers[writeIndex];
+    }
+
+    void publish()
+    {
+        writeIndex = shared.exchange(writeIndex | newDataFlag) & indexMask;
+    }
+
+    // Only call from the reading thread. Returns nullptr if nothing new was published since the last read
+    T const* read()
+    {
+        if (!(shared.load() & newDataFlag))
+            return nullptr;
+
+        readIndex = shared.exchange(readIndex) & indexMask;
+        return &buffers[readIndex];
+    }
+
+private:
+    static constexpr int newDataFlag = 4;
+    static constexpr int indexMask = 3;
+
+    T buffers[3];
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> shared = 2;
+};
+
+// Fixed-size frame of display data for up to two signals, so it can be passed around without allocating
+struct DisplaySnapshot {
+    static constexpr int maxPoints = 1024;
+
+    float x[maxPoints];
+    float y[maxPoints];
+    int numPoints = 0;
+
+    // Extra state that the display needs, so it doesn't have to read it from the pd object
+    float rangeMin = -1.0f;
+    float rangeMax = 1.0f;
+    int mode = 0;
+
+    // Reduces the signal to maxPoints points, by storing the min and max value of every range of samples, so peaks stay visible
+    static int decimate(float const* input, int numSamples, float* output)
+    {
+        if (numSamples <= maxPoints) {
+            std::copy(input, input + numSamples, output);
+            return numSamples;
+        }
+
+        constexpr int numBins = maxPoints / 2;
+        for (int bin = 0; bin < numBins; bin++) {
+            auto const start = bin * numSamples / numBins;
+            auto const end = (bin + 1) * numSamples / numBins;
+            auto const range = FloatVectorOperations::findMinAndMax(input + start, end - start);
+            output[bin * 2] = range.getStart();
+            output[bin * 2 + 1] = range.getEnd();
+        }
+
+        return maxPoints;
+    }
+
+    // Reduces the signal to maxPoints points by skipping samples, for when points of two signals need to stay paired (like XY plots)
+    static int subsample(float const* input, int numSamples, float* output)
+    {
+        auto const numOutput = std::min(numSamples, maxPoints);
+        for (int i = 0; i < numOutput; i++) {
+            output[i] = input[i * numSamples / numOutput];
+        }
+
+        return numOutput;
+    }
+};
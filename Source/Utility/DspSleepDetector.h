@@ -0,0 +1,121 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Decides when an idle instance can stop running Pd's DSP, which saves a lot of CPU in DAW sessions with many silent instances
+// An instance goes to sleep after its inputs and outputs have been silent without any MIDI, parameter, transport or GUI activity for the tail length,
+// and wakes up in the first block with activity
+// Everything except setting the options is called from the audio thread
+class DspSleepDetector {
+public:
+    void setEnabled(bool shouldBeEnabled)
+    {
+        enabled = shouldBeEnabled;
+    }
+
+    bool isEnabled() const
+    {
+        return enabled;
+    }
+
+    // The tail length of the plugin, we never sleep sooner than minimumSleepDelay
+    void setSleepDelay(float seconds)
+    {
+        sleepDelay = std::max(seconds, minimumSleepDelay);
+    }
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        wakeUp();
+    }
+
+    bool isSleeping() const
+    {
+        return sleeping.load(std::memory_order_relaxed);
+    }
+
+    // Called at the start of every block, returns whether the block needs to be processed
+    bool shouldProcess(bool hasActivity)
+    {
+        if (!enabled || hasActivity)
+            wakeUp();
+
+        return !isSleeping();
+    }
+
+    // Called after every processed block
+    void blockProcessed(bool hadActivity, bool outputIsSilent, int numSamples)
+    {
+        if (hadActivity || !outputIsSilent) {
+            silentSamples = 0;
+            return;
+        }
+
+        silentSamples += numSamples;
+        if (enabled && silentSamples >= static_cast<int64>(sleepDelay.load() * sampleRate))
+            sleeping.store(true, std::memory_order_relaxed);
+    }
+
+    // Patches can follow the transport, so it counts as activity while it's playing, and whenever its state changes
+    bool hasTransportActivity(AudioPlayHead* playhead)
+    {
+        if (!playhead)
+            return false;
+
+        auto const position = playhead->getPosition();
+        if (!position.hasValue())
+            return false;
+
+        auto const timeSignature = position->getTimeSignature().orFallback(AudioPlayHead::TimeSignature());
+        auto const state = TransportState { position->getIsPlaying(), position->getIsRecording(), position->getIsLooping(), position->getBpm().orFallback(0.0), timeSignature.numerator, timeSignature.denominator };
+
+        auto const changed = state != lastTransportState;
+        lastTransportState = state;
+        return changed || state.playing;
+    }
+
+    static bool isSilent(AudioBuffer<float> const& buffer, int numChannels)
+    {
+        for (int ch = 0; ch < std::min(numChannels, buffer.getNumChannels()); ch++) {
+            if (buffer.getMagnitude(ch, 0, buffer.getNumSamples()) > silenceThreshold)
+                return false;
+        }
+
+        return true;
+    }
+
+private:
+    struct TransportState {
+        bool playing = false;
+        bool recording = false;
+        bool looping = false;
+        double bpm = 0.0;
+        int numerator = 0;
+        int denominator = 0;
+
+        bool operator==(TransportState const&) const = default;
+    };
+
+    void wakeUp()
+    {
+        silentSamples = 0;
+        sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    // -100 dB
+    static constexpr float silenceThreshold = 1e-5f;
+    static constexpr float minimumSleepDelay = 1.0f;
+
+    std::atomic<bool> enabled = false;
+    std::atomic<float> sleepDelay = minimumSleepDelay;
+    std::atomic<bool> sleeping = false;
+
+    double sampleRate = 44100.0;
+    int64 silentSamples = 0;
+    TransportState lastTransportState;
+};
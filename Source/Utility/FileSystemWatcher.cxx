@@ -25,13 +25,16 @@ For more information visit www.rabiensoftware.com
  #include <unistd.h>
  #include <sys/stat.h>
  #include <sys/time.h>
+ #include <poll.h>
 #endif
 
+#include <unordered_map>
+
 #if JUCE_MAC
 class FileSystemWatcher::Impl
 {
 public:
-    Impl (FileSystemWatcher& o, File f) : owner (o), folder (f)
+    Impl (FileSystemWatcher& o, File f, bool watchRecursively) : owner (o), folder (f), recursive (watchRecursively)
     {
         NSString* newPath = [NSString stringWithUTF8String:folder.getFullPathName().toRawUTF8()];
 
@@ -78,6 +81,11 @@ public:
             FSEventStreamEventFlags evt = eventFlags[i];
 
             File path = String::fromUTF8 (file);
+
+            // FSEvents always watches the whole tree
+            if (! impl->recursive && path.getParentDirectory() != impl->folder)
+                continue;
+
             if (evt & kFSEventStreamEventFlagItemModified)
                 impl->owner.fileChanged (path, FileSystemEvent::fileUpdated);
             else if (evt & kFSEventStreamEventFlagItemRemoved)
@@ -91,6 +99,7 @@ public:
 
     FileSystemWatcher& owner;
     const File folder;
+    const bool recursive;
 
     NSArray* paths;
     FSEventStreamRef stream;
@@ -101,118 +110,169 @@ public:
 #ifdef JUCE_LINUX
 #define BUF_LEN (10 * (sizeof(struct inotify_event) + NAME_MAX + 1))
 
+// inotify only watches a single directory, so for recursive watching we add a watch for every subdirectory
+// and for new directories as they are created
 class FileSystemWatcher::Impl : public Thread,
                                 private AsyncUpdater
 {
 public:
     struct Event
     {
-        Event () {}
-        Event (Event& other) = default;
-        Event (Event&& other) = default;
-
         File file;
         FileSystemEvent fsEvent;
-
-        bool operator== (const Event& other) const
-        {
-            return file == other.file && fsEvent == other.fsEvent;
-        }
     };
 
-    Impl (FileSystemWatcher& o, File f)
-      : Thread ("FileSystemWatcher::Impl"), owner (o), folder (f)
+    Impl (FileSystemWatcher& o, File f, bool watchRecursively)
+      : Thread ("FileSystemWatcher::Impl"), owner (o), folder (f), recursive (watchRecursively)
     {
-        fd = inotify_init();
+        fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
 
-        wd = inotify_add_watch (fd,
-                                folder.getFullPathName().toRawUTF8(),
-                                IN_ATTRIB | IN_CREATE | IN_DELETE | IN_DELETE_SELF |
-                                IN_MODIFY | IN_MOVE_SELF | IN_MOVED_TO | IN_MOVED_FROM);
-
-        startThread();
+        if (fd >= 0)
+            startThread();
     }
 
-    ~Impl()
+    ~Impl() override
     {
-        shouldQuit = true;
-        signalThreadShouldExit();
-        inotify_rm_watch (fd, wd);
-        close (fd);
+        cancelPendingUpdate();
+        stopThread (1000);
 
-        waitForThreadToExit (1000);
+        if (fd >= 0)
+            close (fd);
     }
 
     void run() override
     {
-        char buf[BUF_LEN];
+        // Adding the watches for a large tree takes a while, so we do that here instead of on the message thread
+        addWatch (folder);
 
-        const struct inotify_event* iNotifyEvent;
-        char* ptr;
+        alignas (struct inotify_event) char buf[BUF_LEN];
 
-        while (!shouldQuit)
+        while (! threadShouldExit())
         {
-            int numRead = read (fd, buf, BUF_LEN);
+            // Poll with a timeout, so we can check if the thread should exit
+            pollfd pfd { fd, POLLIN, 0 };
+            if (poll (&pfd, 1, 100) <= 0)
+                continue;
+
+            auto numRead = read (fd, buf, BUF_LEN);
 
-            if (numRead <= 0 || threadShouldExit())
-                break;
+            if (numRead <= 0)
+                continue;
 
-            for (ptr = buf; ptr < buf + numRead; ptr += sizeof(struct inotify_event) + iNotifyEvent->len)
+            Array<Event> newEvents;
+
+            for (char* ptr = buf; ptr < buf + numRead;)
             {
-                iNotifyEvent = (const struct inotify_event*)ptr;
-                Event e;
+                auto const* iNotifyEvent = (const struct inotify_event*)ptr;
+                ptr += sizeof (struct inotify_event) + iNotifyEvent->len;
+
+                // We lost events, let listeners know that something in the folder changed
+                if (iNotifyEvent->mask & IN_Q_OVERFLOW)
+                {
+                    newEvents.add ({ folder, FileSystemEvent::fileUpdated });
+                    continue;
+                }
+
+                auto watch = watches.find (iNotifyEvent->wd);
+                if (watch == watches.end())
+                    continue;
+
+                if (iNotifyEvent->mask & IN_IGNORED)
+                {
+                    watches.erase (watch);
+                    continue;
+                }
+
+                // Events for the watched directory itself
+                if (iNotifyEvent->len == 0)
+                    continue;
 
-                e.file = File {folder.getFullPathName() + '/' + iNotifyEvent->name};
+                Event e;
+                e.file = watch->second.getChildFile (String::fromUTF8 (iNotifyEvent->name));
 
                      if (iNotifyEvent->mask & IN_CREATE)      e.fsEvent = FileSystemEvent::fileCreated;
-                else if (iNotifyEvent->mask & IN_CLOSE_WRITE) e.fsEvent = FileSystemEvent::fileUpdated;
                 else if (iNotifyEvent->mask & IN_MOVED_FROM)  e.fsEvent = FileSystemEvent::fileRenamedOldName;
                 else if (iNotifyEvent->mask & IN_MOVED_TO)    e.fsEvent = FileSystemEvent::fileRenamedNewName;
                 else if (iNotifyEvent->mask & IN_DELETE)      e.fsEvent = FileSystemEvent::fileDeleted;
+                else                                          e.fsEvent = FileSystemEvent::fileUpdated;
 
-                ScopedLock sl(lock);
-                
-                bool duplicateEvent = false;
-                for (auto existing : events)
-                {
-                    if (e == existing)
-                    {
-                        duplicateEvent = true;
-                        break;
-                    }
-                }
+                // New directories need a watch too, files could already have been created inside before we add it
+                if (recursive && (iNotifyEvent->mask & IN_ISDIR) && (iNotifyEvent->mask & (IN_CREATE | IN_MOVED_TO)))
+                    addWatch (e.file, true);
 
-                if (! duplicateEvent)
-                    events.add (std::move (e));
+                newEvents.add (std::move (e));
             }
 
-            ScopedLock sl (lock);
-            if (events.size() > 0)
+            if (newEvents.size() > 0)
+            {
+                ScopedLock sl (lock);
+                events.addArray (newEvents);
                 triggerAsyncUpdate();
+            }
         }
     }
 
     void handleAsyncUpdate() override
     {
-        if(shouldQuit) return;
-
-        ScopedLock sl (lock);
+        Array<Event> eventsToSend;
+        {
+            ScopedLock sl (lock);
+            eventsToSend.swapWith (events);
+        }
 
-        for (auto& e : events)
+        for (auto& e : eventsToSend)
             owner.fileChanged (e.file, e.fsEvent);
+    }
 
-        events.clear();
+    void addWatch (File const& directory, bool isNewDirectory = false)
+    {
+        // Only wait for the file to be closed, IN_MODIFY would send an event for every write
+        auto wd = inotify_add_watch (fd, directory.getFullPathName().toRawUTF8(),
+                                     IN_ATTRIB | IN_CREATE | IN_DELETE | IN_CLOSE_WRITE |
+                                     IN_MOVED_TO | IN_MOVED_FROM);
+        if (wd < 0)
+            return;
+
+        watches[wd] = directory;
+
+        if (! recursive)
+            return;
+
+        for (auto const& child : directory.findChildFiles (File::findDirectories, false, "*", File::FollowSymlinks::noCycles))
+        {
+            if (threadShouldExit())
+                return;
+
+            addWatch (child, isNewDirectory);
+        }
+
+        // Files that were created in a new directory before we started watching it
+        if (isNewDirectory)
+        {
+            Array<Event> newEvents;
+            for (auto const& child : directory.findChildFiles (File::findFiles, false))
+                newEvents.add ({ child, FileSystemEvent::fileCreated });
+
+            if (newEvents.size() > 0)
+            {
+                ScopedLock sl (lock);
+                events.addArray (newEvents);
+                triggerAsyncUpdate();
+            }
+        }
     }
 
-    std::atomic<bool> shouldQuit = false;
     FileSystemWatcher& owner;
-    File folder;
+    const File folder;
+    const bool recursive;
 
     CriticalSection lock;
     Array<Event> events;
 
+    // Only used on the watcher thread
+    std::unordered_map<int, File> watches;
+
     int fd;
-    int wd;
 };
 #endif
 
@@ -232,8 +292,8 @@ public:
         }
     };
 
-    Impl (FileSystemWatcher& o, File f)
-      : Thread ("FileSystemWatcher::Impl"), owner (o), folder (f)
+    Impl (FileSystemWatcher& o, File f, bool watchRecursively)
+      : Thread ("FileSystemWatcher::Impl"), owner (o), folder (f), recursive (watchRecursively)
     {
         WCHAR path[_MAX_PATH] = {0};
         wcsncpy_s (path, folder.getFullPathName().toWideCharPointer(), _MAX_PATH - 1);
@@ -270,7 +330,7 @@ public:
         while (! threadShouldExit())
         {
             memset (buffer, 0, heapSize);
-            BOOL success = ReadDirectoryChangesW (folderHandle, buffer, heapSize, true,
+            BOOL success = ReadDirectoryChangesW (folderHandle, buffer, heapSize, recursive,
                 FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_CREATION,
                 &bytesOut, nullptr, nullptr);
 
@@ -305,18 +365,8 @@ public:
                             break;
                     }
 
-                    bool duplicateEvent = false;
-                    for (auto existing : events)
-                    {
-                        if (e == existing)
-                        {
-                            duplicateEvent = true;
-                            break;
-                        }
-                    }
-
-                    if (! duplicateEvent)
-                        events.add (e);
+                    // Duplicates are coalesced by the FileSystemWatcher
+                    events.add (e);
 
                     if (fni->NextEntryOffset > 0)
                         rawData += fni->NextEntryOffset;
@@ -332,16 +382,19 @@ public:
 
     void handleAsyncUpdate() override
     {
-        ScopedLock sl (lock);
+        Array<Event> eventsToSend;
+        {
+            ScopedLock sl (lock);
+            eventsToSend.swapWith (events);
+        }
 
-        for (auto e : events)
+        for (auto& e : eventsToSend)
             owner.fileChanged (e.file, e.fsEvent);
-
-        events.clear();
     }
 
     FileSystemWatcher& owner;
     const File folder;
+    const bool recursive;
 
     CriticalSection lock;
     Array<Event> events;
@@ -355,7 +408,7 @@ public:
 class FileSystemWatcher::Impl
 {
 public:
-    Impl (FileSystemWatcher& o, File f) : owner (o), folder (f)
+    Impl (FileSystemWatcher& o, File f, bool) : owner (o), folder (f)
     {
     }
 
@@ -375,15 +428,16 @@ FileSystemWatcher::FileSystemWatcher()
 
 FileSystemWatcher::~FileSystemWatcher()
 {
+    stopTimer();
 }
 
-void FileSystemWatcher::addFolder (const File& folder)
+void FileSystemWatcher::addFolder (const File& folder, bool recursive)
 {
     // You can only listen to folders that exist
     jassert (folder.isDirectory());
 
     if ( ! getWatchedFolders().contains (folder))
-        watched.add (new Impl (*this, folder));
+        watched.add (new Impl (*this, folder, recursive));
 }
 
 void FileSystemWatcher::removeFolder (const File& folder)
@@ -416,8 +470,70 @@ void FileSystemWatcher::removeListener (Listener* listener)
 void FileSystemWatcher::fileChanged (const File& file, FileSystemEvent fsEvent)
 {
     if(file.getFileName().endsWith(".autosave")) return;
-    
-    listeners.call (&FileSystemWatcher::Listener::fileChanged, file, fsEvent);
+
+    auto const path = file.getFullPathName();
+    auto pending = pendingEvents.find (path);
+
+    if (pending == pendingEvents.end())
+    {
+        pendingEvents.emplace (path, fsEvent);
+        pendingFiles.add (file);
+    }
+    else
+    {
+        pending->second = coalesceEvents (pending->second, fsEvent);
+    }
+
+    // Wait until the events stop coming in, but don't keep the listeners waiting forever while something keeps writing
+    auto const now = Time::getMillisecondCounter();
+    if (! isTimerRunning())
+        firstPendingEventTime = now;
+
+    if (now - firstPendingEventTime >= maxDebounceTime)
+        timerCallback();
+    else
+        startTimer (debounceTime);
+}
+
+std::optional<FileSystemWatcher::FileSystemEvent> FileSystemWatcher::coalesceEvents (std::optional<FileSystemEvent> previous, FileSystemEvent next)
+{
+    if (! previous)
+        return next;
+
+    auto const wasCreated = *previous == fileCreated || *previous == fileRenamedNewName;
+    auto const wasDeleted = *previous == fileDeleted || *previous == fileRenamedOldName;
+    auto const isDeleted = next == fileDeleted || next == fileRenamedOldName;
+    auto const isCreated = next == fileCreated || next == fileRenamedNewName;
+
+    // Still new to the listeners
+    if (wasCreated && next == fileUpdated)
+        return previous;
+
+    // Listeners never need to know this file existed
+    if (*previous == fileCreated && isDeleted)
+        return std::nullopt;
+
+    // The file was replaced
+    if (wasDeleted && isCreated)
+        return fileUpdated;
+
+    return next;
+}
+
+void FileSystemWatcher::timerCallback()
+{
+    stopTimer();
+
+    auto files = std::move (pendingFiles);
+    auto events = std::move (pendingEvents);
+    pendingFiles.clear();
+    pendingEvents.clear();
+
+    for (auto const& file : files)
+    {
+        if (auto event = events[file.getFullPathName()])
+            listeners.call (&FileSystemWatcher::Listener::fileChanged, file, *event);
+    }
 }
 
 Array<File> FileSystemWatcher::getWatchedFolders()
@@ -7,6 +7,9 @@ For more information visit www.rabiensoftware.com
 
 #pragma once
 
+#include <optional>
+#include <unordered_map>
+
 #if JUCE_MAC || JUCE_WINDOWS || JUCE_LINUX || JUCE_BSD || JUCE_IOS
 
 /**
@@ -17,17 +20,20 @@ For more information visit www.rabiensoftware.com
     created, modified, deleted or renamed in the watched
     folder.
 
-    FileSystemWatcher will also recursively watch all subfolders on
-    macOS and windows and will not on Linux.
+    FileSystemWatcher can also recursively watch all subfolders.
+
+    Events are collected until the file system has been quiet for a
+    moment, and events for the same file are combined, so tools that
+    write many files at once only cause one batch of callbacks.
 
  */
-class FileSystemWatcher {
+class FileSystemWatcher : private Timer {
 public:
     FileSystemWatcher();
-    ~FileSystemWatcher();
+    ~FileSystemWatcher() override;
 
-    /** Adds a folder to be watched */
-    void addFolder(File const& folder);
+    /** Adds a folder to be watched, optionally including all of its subfolders */
+    void addFolder(File const& folder, bool recursive = true);
 
     /** Removes a folder from being watched */
     void removeFolder(File const& folder);
@@ -91,6 +97,23 @@ private:
 
     void fileChanged(File const& file, FileSystemEvent fsEvent);
 
+    void timerCallback() override;
+
+    // Combines two events for the same file, nullopt means the listeners don't need to hear about it
+    static std::optional<FileSystemEvent> coalesceEvents(std::optional<FileSystemEvent> previous, FileSystemEvent next);
+
+    struct StringHash {
+        size_t operator()(String const& s) const { return static_cast<size_t>(s.hashCode64()); }
+    };
+
+    // Events waiting to be sent, in the order the files first changed
+    Array<File> pendingFiles;
+    std::unordered_map<String, std::optional<FileSystemEvent>, StringHash> pendingEvents;
+    uint32 firstPendingEventTime = 0;
+
+    static constexpr int debounceTime = 100;
+    static constexpr uint32 maxDebounceTime = 1000;
+
     ListenerList<Listener> listeners;
 
     OwnedArray<Impl> watched;
@@ -0,0 +1,238 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Unpacks plugdata's filesystem zip into the data directory for this version
+// The zip is split over several binary resources, which we read through a stream that spans all of them instead of copying them into one block
+// Entries are extracted in parallel. Everything Pd needs to start is extracted right away, the help files are unpacked in the background afterwards
+// Use through a SharedResourcePointer, so all plugin instances share the background extraction
+class FilesystemExtractor {
+public:
+    using Chunks = std::vector<std::pair<char const*, int>>;
+
+    ~FilesystemExtractor()
+    {
+        // Stops between entries, the next instance will pick up where we left off
+        documentationPool.removeAllJobs(true, 5000);
+    }
+
+    // Blocks until the files Pd needs are there, and starts unpacking the help files if that hasn't happened yet
+    void extract(File const& homeDir, File const& versionDataDir, Chunks chunks)
+    {
+        // Another instance could still be unpacking the help files from it
+        if (!zipFile && !chunks.empty())
+            zipFile = std::make_unique<ZipFile>(new ChunkedInputSource(std::move(chunks)), true);
+
+        homeDir.createDirectory();
+
+        if (!versionDataDir.exists()) {
+            if (!zipFile)
+                return;
+
+            // Unpack next to the final location first, so a crash during extraction doesn't leave an incomplete version directory
+            auto partialDir = versionDataDir.getSiblingFile(versionDataDir.getFileName() + ".partial");
+            partialDir.deleteRecursively();
+            partialDir.createDirectory();
+
+            ThreadPool pool(std::max(1, SystemStats::getNumCpus()));
+            WaitableEvent finished;
+            bool extracted = false;
+            extractEntries(pool, partialDir, [](String const& path) { return !isDocumentation(path); }, [&finished, &extracted](bool succeeded) {
+                extracted = succeeded;
+                finished.signal();
+            });
+            finished.wait();
+
+            // Don't install an incomplete version directory, we'll try again on the next launch
+            if (!extracted) {
+                partialDir.deleteRecursively();
+                return;
+            }
+
+            partialDir.moveFileTo(versionDataDir);
+        }
+
+        auto const marker = versionDataDir.getChildFile(documentationMarker);
+        if (marker.existsAsFile()) {
+            documentationReady = true;
+            return;
+        }
+
+        if (!zipFile || documentationPool.getNumJobs() > 0)
+            return;
+
+        // The library's file watcher picks up the help files as they appear
+        extractEntries(documentationPool, versionDataDir, isDocumentation, [marker](bool succeeded) {
+            if (succeeded) {
+                marker.create();
+                documentationReady = true;
+            }
+        });
+    }
+
+    // False while the help files are still being unpacked
+    static bool isDocumentationReady()
+    {
+        return documentationReady;
+    }
+
+private:
+    // Reads the chunks as if they were one block of memory, each entry that's extracted in parallel gets its own stream
+    class ChunkedInputStream : public InputStream {
+    public:
+        ChunkedInputStream(Chunks const& chunksToRead, std::vector<int64> const& chunkStarts, int64 length)
+            : chunks(chunksToRead)
+            , starts(chunkStarts)
+            , totalLength(length)
+        {
+        }
+
+        int64 getTotalLength() override { return totalLength; }
+        bool isExhausted() override { return position >= totalLength; }
+        int64 getPosition() override { return position; }
+
+        bool setPosition(int64 newPosition) override
+        {
+            position = jlimit<int64>(0, totalLength, newPosition);
+            return true;
+        }
+
+        int read(void* destBuffer, int maxBytesToRead) override
+        {
+            auto* dest = static_cast<char*>(destBuffer);
+            int numRead = 0;
+            while (numRead < maxBytesToRead && position < totalLength) {
+                auto const chunk = static_cast<size_t>(std::upper_bound(starts.begin(), starts.end(), position) - starts.begin() - 1);
+                auto const offsetInChunk = position - starts[chunk];
+                auto const numToCopy = static_cast<int>(std::min<int64>(maxBytesToRead - numRead, chunks[chunk].second - offsetInChunk));
+
+                std::memcpy(dest + numRead, chunks[chunk].first + offsetInChunk, static_cast<size_t>(numToCopy));
+                numRead += numToCopy;
+                position += numToCopy;
+            }
+            return numRead;
+        }
+
+    private:
+        Chunks const& chunks;
+        std::vector<int64> const& starts;
+        int64 totalLength;
+        int64 position = 0;
+    };
+
+    class ChunkedInputSource : public InputSource {
+    public:
+        explicit ChunkedInputSource(Chunks chunksToRead)
+            : chunks(std::move(chunksToRead))
+        {
+            for (auto const& [data, size] : chunks) {
+                starts.push_back(totalLength);
+                totalLength += size;
+            }
+        }
+
+        InputStream* createInputStream() override { return new ChunkedInputStream(chunks, starts, totalLength); }
+        InputStream* createInputStreamFor(String const&) override { return nullptr; }
+        int64 hashCode() const override { return static_cast<int64>(reinterpret_cast<pointer_sized_int>(chunks.empty() ? nullptr : chunks[0].first)); }
+
+    private:
+        Chunks chunks;
+        std::vector<int64> starts;
+        int64 totalLength = 0;
+    };
+
+    // The test tone and load meter patches are copied out of the documentation at startup, so those are needed right away
+    static bool isDocumentation(String const& path)
+    {
+        return path.startsWith("Documentation/") && !path.startsWith("Documentation/7.stuff/tools/");
+    }
+
+    // The zip contains a single "plugdata_version" folder, which becomes the version data directory
+    static String getRelativePath(ZipFile::ZipEntry const& entry)
+    {
+        auto const path = entry.filename.replaceCharacter('\\', '/');
+        return path.startsWith("plugdata_version/") ? path.fromFirstOccurrenceOf("plugdata_version/", false, false) : path;
+    }
+
+    struct Extraction {
+        std::vector<int> files;
+        std::atomic<int> nextFile = 0;
+        std::atomic<int> numJobsRunning = 0;
+        std::atomic<bool> failed = false;
+        std::function<void(bool)> onFinished;
+    };
+
+    // Extracts the matching entries on all threads of the pool, the callback is called from the last job to finish
+    // It won't be called if the pool was stopped before all jobs could start, the extraction is incomplete in that case anyway
+    void extractEntries(ThreadPool& pool, File const& targetDir, std::function<bool(String const&)> const& filter, std::function<void(bool)> onFinished)
+    {
+        auto extraction = std::make_shared<Extraction>();
+        extraction->onFinished = std::move(onFinished);
+
+        for (int i = 0; i < zipFile->getNumEntries(); i++) {
+            auto const path = getRelativePath(*zipFile->getEntry(i));
+            if (path.isEmpty() || !filter(path))
+                continue;
+
+            // Create all folders up front, threads creating the same folder at the same time would trip each other up
+            if (path.endsWithChar('/')) {
+                targetDir.getChildFile(path).createDirectory();
+            } else {
+                targetDir.getChildFile(path).getParentDirectory().createDirectory();
+                extraction->files.push_back(i);
+            }
+        }
+
+        auto const numJobs = pool.getNumThreads();
+        extraction->numJobsRunning = numJobs;
+        for (int job = 0; job < numJobs; job++) {
+            pool.addJob([this, extraction, targetDir]() {
+                auto const numFiles = static_cast<int>(extraction->files.size());
+                for (int i = extraction->nextFile++; i < numFiles; i = extraction->nextFile++) {
+                    if (ThreadPoolJob::getCurrentThreadPoolJob()->shouldExit()) {
+                        extraction->failed = true;
+                        break;
+                    }
+                    if (!extractFile(extraction->files[i], targetDir))
+                        extraction->failed = true;
+                }
+
+                if (--extraction->numJobsRunning == 0)
+                    extraction->onFinished(!extraction->failed);
+            });
+        }
+    }
+
+    bool extractFile(int index, File const& targetDir)
+    {
+        auto const* entry = zipFile->getEntry(index);
+        auto const target = targetDir.getChildFile(getRelativePath(*entry));
+
+        // Left over from an extraction that was stopped halfway
+        if (target.existsAsFile() && target.getSize() == entry->uncompressedSize)
+            return true;
+
+        auto input = std::unique_ptr<InputStream>(zipFile->createStreamForEntry(index));
+        if (!input)
+            return false;
+
+        target.deleteFile();
+        FileOutputStream output(target);
+        if (!output.openedOk())
+            return false;
+
+        return output.writeFromInputStream(*input, -1) == entry->uncompressedSize && output.getStatus().wasOk();
+    }
+
+    static constexpr char const* documentationMarker = ".documentation_unpacked";
+    static inline std::atomic<bool> documentationReady = false;
+
+    std::unique_ptr<ZipFile> zipFile;
+
+    // Declared last, so it's stopped before the zip file is deleted
+    ThreadPool documentationPool = ThreadPool(2);
+};
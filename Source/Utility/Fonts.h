@@ -48,6 +48,8 @@ struct Fonts {
         tabularTypeface = Typeface::createSystemTypefaceFor(BinaryData::InterTabular_ttf, BinaryData::InterTabular_ttfSize);
 
         instance = this;
+
+        glyphCacheWarmer = std::make_unique<GlyphCacheWarmer>(*this);
     }
 
     static Font getCurrentFont() { return Font(instance->currentTypeface); }
@@ -188,6 +190,72 @@ struct Fonts {
     }
 
 private:
+    // JUCE rasterises glyphs the first time they are drawn at a certain size, which makes the first zoom into a large patch stutter
+    // This draws the printable ASCII characters at the common UI sizes and zoom levels in the background, so they end up in JUCE's glyph cache
+    // The cache is process-wide, so all editors benefit from it
+    // Typefaces aren't thread-safe, so we warm up one size at a time on the message thread, between other work
+    class GlyphCacheWarmer : private Timer {
+    public:
+        explicit GlyphCacheWarmer(Fonts& fonts)
+        {
+            for (auto height : { 12.0f, 13.0f, 14.0f, 15.0f }) {
+                for (auto typeface : { fonts.defaultTypeface, fonts.semiBoldTypeface, fonts.boldTypeface, fonts.monoTypeface }) {
+                    sizesToWarm.push_back({ typeface, height, 1.0f });
+                }
+            }
+
+            // Zooming scales the object text, which uses the regular font
+            for (int zoom = 5; zoom <= 20; zoom++) {
+                if (zoom != 10)
+                    sizesToWarm.push_back({ fonts.defaultTypeface, 15.0f, zoom / 10.0f });
+            }
+
+            startTimer(15);
+        }
+
+    private:
+        struct GlyphSize {
+            Typeface::Ptr typeface;
+            float height;
+            float zoom;
+        };
+
+        void timerCallback() override
+        {
+            if (sizesToWarm.empty()) {
+                scratchImage = Image();
+                stopTimer();
+                return;
+            }
+
+            if (displayScale == 0.0f) {
+                auto const* display = Desktop::getInstance().getDisplays().getPrimaryDisplay();
+                displayScale = display ? static_cast<float>(display->scale) : 1.0f;
+            }
+
+            auto const [typeface, height, zoom] = sizesToWarm.back();
+            sizesToWarm.pop_back();
+
+            // Draw through the same scaling transform as a zoomed canvas would, so the glyphs end up in the cache at the same size
+            Graphics g(scratchImage);
+            g.addTransform(AffineTransform::scale(zoom * displayScale));
+            g.setFont(Font(typeface).withHeight(height));
+            g.setColour(Colours::black);
+            g.drawSingleLineText(printableCharacters, 0, static_cast<int>(height));
+        }
+
+        std::vector<GlyphSize> sizesToWarm;
+        float displayScale = 0.0f;
+
+        // Only the software renderer uses JUCE's glyph cache
+        // Wide enough to fit the whole line at the largest size, glyphs outside of the clip region might not be rendered
+        Image scratchImage = Image(Image::SingleChannel, 4096, 128, false, SoftwareImageType());
+
+        static inline String const printableCharacters = " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+    };
+
+    std::unique_ptr<GlyphCacheWarmer> glyphCacheWarmer;
+
     // This is effectively a singleton because it's loaded through SharedResourcePointer
     static inline Fonts* instance = nullptr;
 
@@ -0,0 +1,121 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Runs all periodic GUI updates of objects from a single timer, instead of every object running its own
+// Objects that are not visible on screen (hidden tabs, scrolled out of view) are skipped,
+// and if a refresh pass takes longer than our budget, all refresh rates are reduced until the load goes down again
+// Use it through a SharedResourcePointer, so all plugin instances share the same timer
+class GuiRefreshScheduler : private Timer {
+public:
+    struct Client {
+        virtual ~Client() = default;
+        virtual void refresh() = 0;
+    };
+
+    // If onlyWhenVisible is false, the client will keep refreshing when it's not on screen, for clients that need to keep draining a queue
+    void addClient(Client* client, Component* component, int intervalMs, bool onlyWhenVisible = true)
+    {
+        entries.push_back({ client, component, intervalMs, 0.0, onlyWhenVisible });
+
+        if (!isTimerRunning())
+            startTimerHz(refreshRate);
+    }
+
+    void removeClient(Client* client)
+    {
+        // Clients might remove themselves while we are refreshing, so we only clear them here and clean up later
+        for (auto& entry : entries) {
+            if (entry.client == client)
+                entry.client = nullptr;
+        }
+
+        if (!isRefreshing)
+            removeClearedEntries();
+    }
+
+    void setInterval(Client* client, int intervalMs)
+    {
+        for (auto& entry : entries) {
+            if (entry.client == client)
+                entry.intervalMs = intervalMs;
+        }
+    }
+
+private:
+    struct Entry {
+        Client* client;
+        Component::SafePointer<Component> component;
+        int intervalMs;
+        double lastRefreshTime;
+        bool onlyWhenVisible;
+    };
+
+    static bool isVisibleOnScreen(Component* component)
+    {
+        if (!component || !component->isShowing())
+            return false;
+
+        // Check if the component is scrolled out of view
+        if (auto* viewport = component->findParentComponentOfClass<Viewport>()) {
+            return viewport->getLocalArea(component, component->getLocalBounds()).intersects(viewport->getLocalBounds());
+        }
+
+        return true;
+    }
+
+    void timerCallback() override
+    {
+        auto const startTime = Time::getMillisecondCounterHiRes();
+
+        isRefreshing = true;
+        for (size_t i = 0; i < entries.size(); i++) {
+            auto& entry = entries[i];
+            if (!entry.client || startTime - entry.lastRefreshTime < entry.intervalMs * slowdownFactor)
+                continue;
+
+            if (entry.onlyWhenVisible ? !isVisibleOnScreen(entry.component) : !entry.component)
+                continue;
+
+            entry.lastRefreshTime = startTime;
+            entry.client->refresh();
+        }
+        isRefreshing = false;
+
+        removeClearedEntries();
+
+        if (entries.empty()) {
+            stopTimer();
+            return;
+        }
+
+        // Adapt the refresh rates to how long this pass took
+        auto const elapsed = Time::getMillisecondCounterHiRes() - startTime;
+        if (elapsed > frameBudgetMs) {
+            slowdownFactor = std::min(slowdownFactor * 2, maxSlowdownFactor);
+            numFastFrames = 0;
+        } else if (slowdownFactor > 1 && elapsed < frameBudgetMs / 4.0 && ++numFastFrames > refreshRate) {
+            // Only speed up again after a second of low load, to prevent bouncing between rates
+            slowdownFactor /= 2;
+            numFastFrames = 0;
+        }
+    }
+
+    void removeClearedEntries()
+    {
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [](Entry const& entry) { return entry.client == nullptr; }), entries.end());
+    }
+
+    static constexpr int refreshRate = 60;
+    static constexpr double frameBudgetMs = 8.0;
+    static constexpr int maxSlowdownFactor = 8;
+
+    std::vector<Entry> entries;
+    int slowdownFactor = 1;
+    int numFastFrames = 0;
+    bool isRefreshing = false;
+};
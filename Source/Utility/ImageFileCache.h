@@ -0,0 +1,103 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Decodes image files on a background thread, and keeps the most recently used images around
+// Patches that keep switching between the same pictures (like animations) only need to decode each of them once
+// Use through a SharedResourcePointer, so all objects share the same cache
+class ImageFileCache {
+public:
+    // If the image is cached, the callback is called immediately, otherwise it's called on the message thread once the image is decoded
+    // The image will be invalid if the file couldn't be loaded
+    void loadImage(File const& file, std::function<void(Image)> callback)
+    {
+        auto const key = file.getFullPathName() + ":" + String(file.getLastModificationTime().toMilliseconds());
+
+        Image cachedImage;
+        {
+            ScopedLock lock(cacheLock);
+            auto it = entries.find(key);
+            if (it != entries.end()) {
+                // Move to the front, so it's the last to be removed
+                leastRecentlyUsed.splice(leastRecentlyUsed.begin(), leastRecentlyUsed, it->second);
+                cachedImage = it->second->second;
+            }
+        }
+
+        if (cachedImage.isValid()) {
+            callback(cachedImage);
+            return;
+        }
+
+        // Native images belong to the message thread's graphics context, so the worker only hands over a software image,
+        // which is converted to a native image and cached once we're back on the message thread
+        decodePool.addJob([cache = juce::WeakReference<ImageFileCache>(this), file, key, callback]() {
+            auto image = SoftwareImageType().convert(ImageFileFormat::loadFrom(file));
+
+            MessageManager::callAsync([cache, key, callback, image]() {
+                auto nativeImage = NativeImageType().convert(image);
+                if (auto* imageCache = cache.get())
+                    imageCache->addToCache(key, nativeImage);
+
+                callback(nativeImage);
+            });
+        });
+    }
+
+    // Number of cached images, and the memory they use
+    std::pair<int, size_t> getCacheSize()
+    {
+        ScopedLock lock(cacheLock);
+        return { static_cast<int>(leastRecentlyUsed.size()), cachedBytes };
+    }
+
+private:
+    void addToCache(String const& key, Image const& image)
+    {
+        if (!image.isValid())
+            return;
+
+        ScopedLock lock(cacheLock);
+
+        // Two requests for the same image could have been decoding at the same time
+        if (entries.contains(key))
+            return;
+
+        leastRecentlyUsed.emplace_front(key, image);
+        entries[key] = leastRecentlyUsed.begin();
+        cachedBytes += getImageSize(image);
+
+        while (cachedBytes > maxCachedBytes && leastRecentlyUsed.size() > 1) {
+            cachedBytes -= getImageSize(leastRecentlyUsed.back().second);
+            entries.erase(leastRecentlyUsed.back().first);
+            leastRecentlyUsed.pop_back();
+        }
+    }
+
+    static size_t getImageSize(Image const& image)
+    {
+        return static_cast<size_t>(image.getWidth()) * static_cast<size_t>(image.getHeight()) * 4;
+    }
+
+    struct StringHash {
+        size_t operator()(String const& s) const { return static_cast<size_t>(s.hashCode64()); }
+    };
+
+    using Entry = std::pair<String, Image>;
+
+    std::list<Entry> leastRecentlyUsed;
+    std::unordered_map<String, std::list<Entry>::iterator, StringHash> entries;
+    size_t cachedBytes = 0;
+    CriticalSection cacheLock;
+
+    static constexpr size_t maxCachedBytes = 128 * 1024 * 1024;
+
+    // Declared last, so it finishes decoding before the cache is deleted
+    ThreadPool decodePool = ThreadPool(2);
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(ImageFileCache)
+};
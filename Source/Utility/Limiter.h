@@ -10,8 +10,49 @@ class Limiter {
 public:
     Limiter() = default;
 
-    void process(dsp::AudioBlock<float>& block) noexcept
+    // Replaces inf and NaN values with zeroes, and returns the peak magnitude of the remaining samples
+    // This works on the bit representation of the samples, so the compiler can vectorise it
+    static float sanitise(float* data, int numSamples) noexcept
     {
+        uint32 peakBits = 0;
+        for (int i = 0; i < numSamples; i++) {
+            uint32 bits;
+            std::memcpy(&bits, data + i, sizeof(float));
+
+            // An exponent with all bits set means inf or NaN
+            auto const magnitude = bits & 0x7fffffffu;
+            auto const isFinite = magnitude < 0x7f800000u;
+
+            bits = isFinite ? bits : 0u;
+            std::memcpy(data + i, &bits, sizeof(float));
+
+            // For positive floats, the integer ordering is the same as the float ordering
+            peakBits = std::max(peakBits, isFinite ? magnitude : 0u);
+        }
+
+        float peak;
+        std::memcpy(&peak, &peakBits, sizeof(float));
+        return peak;
+    }
+
+    void process(dsp::AudioBlock<float>& block, float blockPeak) noexcept
+    {
+        // If the signal has been well under the threshold for a while, the compressors won't apply any gain
+        // and clipping does nothing, so we can skip processing entirely
+        if (blockPeak < bypassThreshold) {
+            if (quietSamples >= bypassHoldSamples)
+                return;
+
+            quietSamples += static_cast<int>(block.getNumSamples());
+            if (quietSamples >= bypassHoldSamples) {
+                // Their envelope will have decayed below the threshold by now, resetting them makes sure they start from silence again
+                reset();
+                return;
+            }
+        } else {
+            quietSamples = 0;
+        }
+
         firstStageCompressor.process(dsp::ProcessContextReplacing<float>(block));
         secondStageCompressor.process(dsp::ProcessContextReplacing<float>(block));
 
@@ -26,6 +67,8 @@ public:
         jassert(spec.numChannels > 0);
 
         sampleRate = spec.sampleRate;
+        bypassHoldSamples = static_cast<int>(sampleRate * 2.0);
+        quietSamples = 0;
 
         firstStageCompressor.prepare(spec);
         secondStageCompressor.prepare(spec);
@@ -59,4 +102,9 @@ private:
 
     double sampleRate = 44100.0;
     float releaseTime = 100.0;
+
+    // Safely below the -8dB threshold of the first stage
+    float const bypassThreshold = Decibels::decibelsToGain(-12.0f);
+    int bypassHoldSamples = 88200;
+    int quietSamples = 0;
 };
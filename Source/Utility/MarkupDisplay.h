@@ -201,8 +201,7 @@ public:
         if (links.size() && !attributedString.getText().isEmpty()) { // if we have a link, and the block contains text
             if (event.position.getDistanceFrom(mouseDownPosition) > 20)
                 return;
-            TextLayout layout;
-            layout.createLayout(attributedString, getWidth());
+            auto& layout = getLayout(getWidth());
             // Look for clickable links
             for (auto& [link, start, end] : links) {
                 int offset = 0;
@@ -371,7 +370,21 @@ protected:
 
     AttributedString attributedString;
 
+    // Lays out the text, and keeps the layout until it's needed at a different width
+    // Blocks are only parsed once, so the text itself never changes
+    TextLayout& getLayout(float width)
+    {
+        if (width != layoutWidth) {
+            layout.createLayout(attributedString, width);
+            layoutWidth = width;
+        }
+        return layout;
+    }
+
 private:
+    TextLayout layout;
+    float layoutWidth = -1.0f;
+
     Array<std::tuple<String, int, int>> links;
     Point<float> mouseDownPosition;
 };
@@ -385,16 +398,12 @@ public:
 
     float getHeightRequired(float width) override
     {
-        TextLayout layout;
-        layout.createLayout(attributedString, width);
-        return layout.getHeight();
+        return getLayout(width).getHeight();
     }
 
     void paint(Graphics& g) override
     {
-        TextLayout layout;
-        layout.createLayout(attributedString, getWidth());
-        layout.draw(g, getLocalBounds().toFloat());
+        getLayout(getWidth()).draw(g, getLocalBounds().toFloat());
     }
 
 private:
@@ -428,9 +437,7 @@ public:
 
     float getHeightRequired(float width) override
     {
-        TextLayout layout;
-        layout.createLayout(attributedString, width - iconsize - 2 * (margin + linewidth));
-        return jmax(layout.getHeight(), (float)iconsize);
+        return jmax(getLayout(width - iconsize - 2 * (margin + linewidth)).getHeight(), (float)iconsize);
     }
 
     void paint(Graphics& g) override
@@ -462,7 +469,8 @@ public:
         // draw lines left and right
         g.fillRect(Rectangle<int>(iconsize, 0, linewidth, getHeight()));
         g.fillRect(Rectangle<int>(getWidth() - linewidth, 0, linewidth, getHeight()));
-        attributedString.draw(g, Rectangle<float>(iconsize + margin + linewidth, 0, getWidth() - iconsize - 2 * (margin + linewidth), getHeight()));
+        auto textWidth = getWidth() - iconsize - 2 * (margin + linewidth);
+        getLayout(textWidth).draw(g, Rectangle<float>(iconsize + margin + linewidth, 0, textWidth, getHeight()));
     }
 
 private:
@@ -794,15 +802,13 @@ public:
 
     float getHeightRequired(float width) override
     {
-        TextLayout layout;
-        layout.createLayout(attributedString, width - indent - gap);
-        return layout.getHeight();
+        return getLayout(width - indent - gap).getHeight();
     }
 
     void paint(Graphics& g) override
     {
         label.draw(g, getLocalBounds().withTrimmedLeft(indent).toFloat());
-        attributedString.draw(g, getLocalBounds().withTrimmedLeft(indent + gap).toFloat());
+        getLayout(getWidth() - indent - gap).draw(g, getLocalBounds().withTrimmedLeft(indent + gap).toFloat());
     }
 
 private:
@@ -878,51 +884,75 @@ public:
     // clear the background
     void resized() override
     {
+        viewport.setBounds(getLocalBounds());
+        if (!document)
+            return;
+
         // let's keep the relative vertical position
         double relativeScrollPosition = static_cast<double>(viewport.getViewPositionY()) / content.getHeight();
-        // compute content height
-        int h = margin;
-        for (int i = 0; i < blocks.size(); i++) {
-            int bh;
-            bh = blocks[i]->getHeightRequired(getWidth() - 2 * margin) + 5; // just to be on the safe side
-            if (blocks[i]->canExtendBeyondMargin()) {
-                blocks[i]->setBounds(0, h, getWidth(), bh);
-            } else {
-                blocks[i]->setBounds(margin, h, getWidth() - 2 * margin, bh + 10);
+        // the blocks only need a new layout if the width changed
+        if (document->width != getWidth()) {
+            auto& blocks = document->blocks;
+            int h = margin;
+            for (int i = 0; i < blocks.size(); i++) {
+                int bh;
+                bh = blocks[i]->getHeightRequired(getWidth() - 2 * margin) + 5; // just to be on the safe side
+                if (blocks[i]->canExtendBeyondMargin()) {
+                    blocks[i]->setBounds(0, h, getWidth(), bh);
+                } else {
+                    blocks[i]->setBounds(margin, h, getWidth() - 2 * margin, bh + 10);
+                }
+                h += bh;
             }
-            h += bh;
+            document->width = getWidth();
+            document->height = h;
         }
         // set new bounds
-        viewport.setBounds(getLocalBounds());
-        content.setBounds(0, 0, getWidth(), h + margin);
+        content.setBounds(0, 0, getWidth(), document->height + margin);
         // set vertical scroll position
         int newScrollY = static_cast<int>(relativeScrollPosition * content.getHeight());
         viewport.setViewPosition(0, newScrollY);
     }
 
-    void setFont(Font font) { this->font = font; };
-    void setMargin(int m) { margin = m; };
-    void setColours(StringPairArray c) { colours = c; };
+    void setFont(Font font)
+    {
+        this->font = font;
+        clearCache();
+    };
+    void setMargin(int m)
+    {
+        margin = m;
+        clearCache();
+    };
+    void setColours(StringPairArray c)
+    {
+        colours = c;
+        clearCache();
+    };
     void setTableColours(Colour bg, Colour bgHeader)
     {
         tableBG = bg;
         tableBGHeader = bgHeader;
+        clearCache();
     };
     void setTableMargins(int margin, int gap)
     {
         tableMargin = margin;
         tableGap = gap;
+        clearCache();
     };
     void setListIndents(int indentPerSpace, int labelGap)
     {
         this->indentPerSpace = indentPerSpace;
         this->labelGap = labelGap;
+        clearCache();
     };
     void setAdmonitionSizes(int iconsize, int admargin, int adlinewidth)
     {
         this->iconsize = iconsize;
         this->admargin = admargin;
         this->adlinewidth = adlinewidth;
+        clearCache();
     };
 
     static String convertFromMarkdown(String md)
@@ -995,10 +1025,60 @@ public:
         return bml;
     }
 
-    void setMarkupString(String s)
+    void setMarkupString(String const& s) { showDocument(s, false); }
+    void setMarkdownString(String const& md) { showDocument(md, true); }
+
+    void setFileSource(FileSource* fs) { fileSource = fs; }
+
+private:
+    // A parsed document, and the width its blocks were last laid out for
+    struct Document {
+        OwnedArray<Block> blocks;
+        int width = -1;
+        int height = 0;
+    };
+
+    // Shows a document, it's only parsed the first time it's shown
+    void showDocument(String const& text, bool isMarkdown)
+    {
+        auto const key = text.hashCode64() ^ static_cast<int64>(isMarkdown);
+
+        content.removeAllChildren();
+
+        auto it = documents.find(key);
+        if (it == documents.end()) {
+            if (documents.size() >= maxCachedDocuments) {
+                clearCache();
+            }
+
+            it = documents.emplace(key, std::make_unique<Document>()).first;
+            parseDocument(isMarkdown ? convertFromMarkdown(text) : text, it->second->blocks);
+        }
+
+        document = it->second.get();
+        for (auto* block : document->blocks) {
+            content.addAndMakeVisible(block);
+        }
+
+        resized();
+    }
+
+    // Forgets all documents except for the one that's showing, because the settings they were parsed with changed
+    void clearCache()
     {
-        blocks.clear();
+        for (auto it = documents.begin(); it != documents.end();) {
+            if (it->second.get() != document)
+                it = documents.erase(it);
+            else
+                ++it;
+        }
+
+        if (document)
+            document->width = -1;
+    }
 
+    void parseDocument(String const& s, OwnedArray<Block>& blocks)
+    {
         StringArray lines;
         lines.addLines(s);
 
@@ -1012,7 +1092,6 @@ public:
                     line = b->consumeLink(line); // ...preprocess line...
                 }
                 b->parseItemMarkup(line, font, indentPerSpace, labelGap); // ...parse it...
-                content.addAndMakeVisible(b);                             // ...add the object to content component...
                 blocks.add(b);                                            // ...and the block list...
                 li++;                                                     // ...and go to next line.
             } else if (AdmonitionBlock::isAdmonitionLine(line)) {         // if we find an admonition...
@@ -1022,7 +1101,6 @@ public:
                     line = b->consumeLink(line);                          // ...preprocess line...
                 }
                 b->parseAdmonitionMarkup(line, font, iconsize, admargin, adlinewidth); // ...parse it...
-                content.addAndMakeVisible(b);                                          // ...add the object to content component...
                 blocks.add(b);                                                         // ...and the block list...
                 li++;                                                                  // ...and go to next line.
             } else if (ImageBlock::isImageLine(line)) {                                // if we find an image...
@@ -1031,7 +1109,6 @@ public:
                     line = b->consumeLink(line);                                       // ...preprocess line...
                 }
                 b->parseImageMarkup(line, fileSource);      // ...parse it...
-                content.addAndMakeVisible(b);               // ...add the object to content component...
                 blocks.add(b);                              // ...and the block list...
                 li++;                                       // ...and go to next line.
             } else if (ImageBlock::isHTMLImageLine(line)) { // if we find an image...
@@ -1040,7 +1117,6 @@ public:
                     line = b->consumeLink(line);            // ...preprocess line...
                 }
                 b->parseHTMLImageMarkup(line, fileSource);    // ...parse it...
-                content.addAndMakeVisible(b);                 // ...add the object to content component...
                 blocks.add(b);                                // ...and the block list...
                 li++;                                         // ...and go to next line.
             } else if (TableBlock::isTableLine(line)) {       // if we find a table...
@@ -1054,14 +1130,12 @@ public:
                     line = lines[++li];                       // ...and read next line.
                 }
                 b->parseMarkup(tlines, font);       // ...parse the collected lines...
-                content.addAndMakeVisible(b);       // ...add the object to content component...
                 blocks.add(b);                      // ...and the block list.
             } else if (Block::containsLink(line)) { // ...if we got here and there's a link...
                 TextBlock* b = new TextBlock();     // ...set up a new text block object...
                 b->setColours(&colours);            // ...set its colours...
                 line = b->consumeLink(line);        // ...preprocess line...
                 b->parseMarkup(line, font);         // ...parse markup...
-                content.addAndMakeVisible(b);       // ...add the object to content component...
                 blocks.add(b);                      // ...and the block list...
                 li++;                               // ...and go to next line.
             } else {                                // otherwise we assume that we have a text block
@@ -1081,18 +1155,11 @@ public:
                 TextBlock* b = new TextBlock(); // set up a new text block object...
                 b->setColours(&colours);        // ...set its colours...
                 b->parseMarkup(blines, font);   // ...parse markup...
-                content.addAndMakeVisible(b);   // ...add the object to content component...
                 blocks.add(b);                  // ...and the block list.
             }
         }
-
-        resized();
     }
-    void setMarkdownString(String md) { setMarkupString(convertFromMarkdown(md)); }
-
-    void setFileSource(FileSource* fs) { fileSource = fs; }
 
-private:
     StringPairArray colours;       // colour palette
     Colour bg;                     // background colour
     Colour tableBG, tableBGHeader; // table background colours
@@ -1100,7 +1167,7 @@ private:
     int indentPerSpace, labelGap;  // list item indents
     BouncingViewport viewport;     // a viewport to scroll the content
     Component content;             // a component with the content
-    OwnedArray<Block> blocks;      // representation of the document as blocks
+    Document* document = nullptr;  // the document that's showing
     int margin;                    // content margin in pixels
     int iconsize;                  // admonition icon size in pixels
     int admargin;                  // admonition margin in pixels
@@ -1108,6 +1175,9 @@ private:
     FileSource* fileSource;        // data source for image files, etc.
     Font font;                     // default font for regular text
 
+    std::unordered_map<int64, std::unique_ptr<Document>> documents; // documents that were parsed before, by their text
+    static constexpr int maxCachedDocuments = 32;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MarkupDisplayComponent)
 };
 
@@ -0,0 +1,121 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include "Utility/Config.h"
+#include "MemoryReport.h"
+#include "PluginEditor.h"
+#include "PluginProcessor.h"
+#include "Canvas.h"
+#include "Autosave.h"
+#include "ImageFileCache.h"
+
+extern "C" {
+#include <m_pd.h>
+#include <m_imp.h>
+#include <g_canvas.h>
+#include <g_undo.h>
+
+t_glist* clone_get_instance(t_gobj*, int);
+int clone_get_n(t_gobj*);
+}
+
+namespace {
+
+struct PatchUsage {
+    int numObjects = 0;
+    int numSubpatches = 0;
+    int numArrays = 0;
+    int numCloneInstances = 0;
+    int numUndoActions = 0;
+    size_t objectBytes = 0;
+    size_t arrayBytes = 0;
+};
+
+void addPatchUsage(t_glist* glist, PatchUsage& usage)
+{
+    for (auto* y = glist->gl_list; y; y = y->g_next) {
+        auto* objectClass = pd_class(&y->g_pd);
+        usage.numObjects++;
+        usage.objectBytes += objectClass->c_size;
+
+        if (objectClass == canvas_class) {
+            usage.numSubpatches++;
+            addPatchUsage(reinterpret_cast<t_glist*>(y), usage);
+        } else if (objectClass == garray_class) {
+            auto* array = garray_getarray(reinterpret_cast<t_garray*>(y));
+            usage.numArrays++;
+            usage.arrayBytes += static_cast<size_t>(array->a_n) * static_cast<size_t>(array->a_elemsize);
+        } else if (objectClass->c_name == gensym("clone")) {
+            auto const numInstances = clone_get_n(y);
+            for (int i = 0; i < numInstances; i++) {
+                usage.numCloneInstances++;
+                addPatchUsage(clone_get_instance(y, i), usage);
+            }
+        }
+    }
+}
+
+String formatBytes(size_t numBytes)
+{
+    if (numBytes >= 1024 * 1024)
+        return String(static_cast<double>(numBytes) / (1024.0 * 1024.0), 1) + " MB";
+    if (numBytes >= 1024)
+        return String(static_cast<double>(numBytes) / 1024.0, 1) + " KB";
+
+    return String(numBytes) + " B";
+}
+
+}
+
+String MemoryReport::create(PluginEditor* editor)
+{
+    auto* pd = editor->pd;
+    String report;
+
+    report << "Pd patches\n";
+
+    pd->setThis();
+    pd->lockAudioThread();
+    for (auto* x = pd_getcanvaslist(); x; x = x->gl_next) {
+        PatchUsage usage;
+        addPatchUsage(x, usage);
+
+        for (auto* action = canvas_undo_get(x)->u_queue; action; action = action->next) {
+            usage.numUndoActions++;
+        }
+
+        report << "  " << String::fromUTF8(x->gl_name->s_name) << ": "
+               << usage.numObjects << " objects (" << formatBytes(usage.objectBytes) << "), "
+               << usage.numSubpatches << " subpatches, "
+               << usage.numArrays << " arrays (" << formatBytes(usage.arrayBytes) << "), "
+               << usage.numCloneInstances << " clone instances, "
+               << usage.numUndoActions << " undo actions\n";
+    }
+    pd->unlockAudioThread();
+
+    report << "\nOpen canvases\n";
+    for (auto* cnv : editor->canvases) {
+        report << "  " << cnv->patch.getTitle() << ": " << cnv->objects.size() << " objects, " << cnv->connections.size() << " connections\n";
+    }
+
+    auto const [numPreviews, previewBytes] = editor->offlineRenderer.getPreviewCacheSize();
+    auto const [numImages, imageBytes] = SharedResourcePointer<ImageFileCache>()->getCacheSize();
+    auto const [numAutosaved, autosaveBytes] = Autosave::getAutosaveSize();
+
+    report << "\nCaches\n";
+    report << "  Object previews: " << numPreviews << " (" << formatBytes(previewBytes) << ")\n";
+    report << "  Picture images: " << numImages << " (" << formatBytes(imageBytes) << ")\n";
+    report << "  Autosaved patches: " << numAutosaved << " (" << formatBytes(autosaveBytes) << ")\n";
+
+    // The console buffers have a fixed size, so they can't grow, but it's still useful to see how full they are
+    report << "\nConsole\n";
+    report << "  Messages: " << pd->getConsoleMessages().size() << "/" << ConsoleMessageRing::maxMessages << "\n";
+    report << "  History: " << pd->getConsoleHistory().size() << "/" << ConsoleMessageRing::maxMessages << "\n";
+
+    return report;
+}
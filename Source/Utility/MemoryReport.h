@@ -0,0 +1,17 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+class PluginEditor;
+
+// Creates a text report of what is using memory, to help find out why long-running sessions keep growing
+// The Pd side is listed per root patch (objects, arrays, clone instances and undo history), the plugdata side per open canvas,
+// followed by the caches and the console
+// Pd's allocations are estimated from the sizes of the objects and arrays we can find, not measured
+struct MemoryReport {
+    static juce::String create(PluginEditor* editor);
+};
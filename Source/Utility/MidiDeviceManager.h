@@ -7,82 +7,84 @@
 #pragma once
 #include <juce_audio_utils/juce_audio_utils.h>
 #include "Standalone/InternalSynth.h"
+#include "Utility/RealtimeThreadSettings.h"
 
 class MidiDeviceManager : public ChangeListener
-    , public AsyncUpdater {
+    , public AsyncUpdater
+    , private Thread {
 
 public:
-    // Helper functions to encode/decode regular MIDI events into a sysex event
+    // Helper functions to wrap regular MIDI events into a sysex event together with the index of the device they come from or go to
     // The reason we do this, is that we want to append extra information to the MIDI event when it comes in from pd or the device, but JUCE won't allow this
     // We still want to be able to use handy JUCE stuff for MIDI timing, so we treat every MIDI event as sysex
-    static std::vector<uint16_t> encodeSysExData(std::vector<uint8_t> const& data)
+    //
+    // Layout: 0xF0, flags and the upper bits of the device, the lower 7 bits of the device, the message, 0xF7
+    // Wrapped sysex messages are stored without their own 0xF0 and 0xF7, so the message can never contain the end byte
+    // This keeps channel messages at 7 bytes or less, which MidiMessage stores without allocating, so this is safe to use on the audio thread
+    static constexpr uint8 sysExWrapperFlag = 0x40;
+    static constexpr int maxWrappedDevice = (1 << 13) - 1;
+
+    static MidiMessage convertToSysExFormat(MidiMessage const& m, int device)
     {
-        std::vector<uint16_t> encodedData;
-        for (auto& value : data) {
-            if (value == 0xF0 || value == 0xF7) {
-                // If the value is 0xF0 or 0xF7, encode them in the higher 8 bits. 0xF0 and 0xF8 are already at the top end, so we only need to shift them by 1 position to put it outside of MIDI range. We can't shift by 8, the sysex bytes could still be recognised as sysex bytes!
-                encodedData.push_back(static_cast<uint16_t>(value) << 1);
-            } else {
-                // Otherwise, just cast the 8-bit value to a 16-bit value
-                encodedData.push_back(static_cast<uint16_t>(value));
-            }
+        if (!ProjectInfo::isStandalone)
+            return m;
+
+        jassert(isPositiveAndBelow(device, maxWrappedDevice + 1));
+
+        auto const* data = m.getRawData();
+        auto size = m.getRawDataSize();
+        uint8 flags = 0;
+        if (m.isSysEx()) {
+            data = m.getSysExData();
+            size = m.getSysExDataSize();
+            flags = sysExWrapperFlag;
         }
-        return encodedData;
-    }
 
-    static std::vector<uint8_t> decodeSysExData(std::vector<uint16_t> const& encodedData)
-    {
-        std::vector<uint8_t> decodeData;
-        for (auto& value : encodedData) {
-            auto upperByte = value >> 1;
-            if (upperByte == 0xF0 || upperByte == 0xF7) {
-                decodeData.push_back(upperByte);
-            } else {
-                // Extract the lower 8 bits to obtain the original 8-bit data
-                decodeData.push_back(static_cast<uint8_t>(value));
-            }
-        }
-        return decodeData;
-    }
+        auto const header = std::array<uint8, 3> { 0xF0, static_cast<uint8>(flags | ((device >> 7) & 0x3F)), static_cast<uint8>(device & 0x7F) };
 
-    static MidiMessage convertToSysExFormat(MidiMessage m, int device)
-    {
-        if (ProjectInfo::isStandalone) {
-            // We append the device index so we can use it as a selector later
-            auto const* data = static_cast<uint8 const*>(m.getRawData());
-            auto message = std::vector<uint8>(data, data + m.getRawDataSize());
-            message.push_back(device);
-            auto encodedMessage = encodeSysExData(message);
-
-            // Temporarily convert all messages to sysex so we can add as much data as we want
-            return MidiMessage::createSysExMessage(static_cast<void*>(encodedMessage.data()), encodedMessage.size() * sizeof(uint16_t)).withTimeStamp(m.getTimeStamp());
+        // Short messages are put together on the stack, only long sysex messages need another buffer
+        std::array<uint8, 8> shortMessage;
+        HeapBlock<uint8> longMessage;
+        auto* wrapped = shortMessage.data();
+        if (size + 4 > static_cast<int>(shortMessage.size())) {
+            longMessage.malloc(size + 4);
+            wrapped = longMessage.get();
         }
 
-        return m;
+        std::copy(header.begin(), header.end(), wrapped);
+        std::copy(data, data + size, wrapped + 3);
+        wrapped[size + 3] = 0xF7;
+
+        return MidiMessage(wrapped, size + 4, m.getTimeStamp());
     }
 
-    static MidiMessage convertFromSysExFormat(MidiMessage m, int& device)
+    static MidiMessage convertFromSysExFormat(MidiMessage const& m, int& device)
     {
-        if (ProjectInfo::isStandalone) {
-            auto const* sysexData = reinterpret_cast<uint16_t const*>(m.getSysExData());
-            auto sysexDataSize = m.getSysExDataSize() / sizeof(uint16_t);
-            auto midiMessage = decodeSysExData(std::vector<uint16_t>(sysexData, sysexData + sysexDataSize));
+        if (!ProjectInfo::isStandalone || !m.isSysEx() || m.getSysExDataSize() < 2) {
+            device = 0;
+            return m;
+        }
 
-            device = midiMessage.back();
-            midiMessage.pop_back();
+        auto const* data = m.getSysExData();
+        auto const size = m.getSysExDataSize() - 2;
+        device = ((data[0] & 0x3F) << 7) | (data[1] & 0x7F);
 
-            return MidiMessage(midiMessage.data(), midiMessage.size());
-        }
+        if (data[0] & sysExWrapperFlag)
+            return MidiMessage::createSysExMessage(data + 2, size).withTimeStamp(m.getTimeStamp());
 
-        device = 0;
-        return m;
+        if (size <= 0)
+            return MidiMessage();
+
+        return MidiMessage(data + 2, size, m.getTimeStamp());
     }
 
     MidiDeviceManager(MidiInputCallback* inputCallback)
+        : Thread("MIDI output")
     {
 #if !JUCE_WINDOWS && !JUCE_IOS
         if (auto* newOut = MidiOutput::createNewDevice("from plugdata").release()) {
             fromPlugdata.reset(newOut);
+            fromPlugdata->startBackgroundThread();
         }
         if (auto* newIn = MidiInput::createNewDevice("to plugdata", inputCallback).release()) {
             toPlugdata.reset(newIn);
@@ -94,10 +96,13 @@ public:
 
         filteredMidiInputs = filteredMidiOutputs = 0;
         updateMidiDevices();
+
+        startThread(Thread::Priority::highest);
     }
 
     ~MidiDeviceManager()
     {
+        stopThread(1000);
         saveMidiOutputSettings();
         clearInputFilter();
         clearOutputFilter();
@@ -164,6 +169,170 @@ private:
         filteredMidiOutputs = 0;
     }
 
+    // Maps the device index pd uses to the MidiOutput it should go to, so the output thread doesn't need to search for it
+    // Call whenever the enabled outputs change, the lock keeps the output thread from using outputs that are being removed
+    void updateOutputTable()
+    {
+        ScopedLock lock(outputTableLock);
+
+        outputTable.clear();
+        for (auto const& device : getOutputDevices()) {
+            MidiOutput* output = nullptr;
+            if (fromPlugdata && device.identifier == fromPlugdata->getIdentifier()) {
+                output = fromPlugdata.get();
+            } else {
+                for (auto* midiOutput : midiOutputs) {
+                    if (midiOutput->getIdentifier() == device.identifier) {
+                        output = midiOutput;
+                        break;
+                    }
+                }
+            }
+            outputTable.push_back(output);
+        }
+
+        allOutputs.clear();
+        allOutputs.insert(allOutputs.end(), midiOutputs.begin(), midiOutputs.end());
+        if (fromPlugdata && internalOutputEnabled)
+            allOutputs.push_back(fromPlugdata.get());
+
+        numOutputDevices = static_cast<int>(outputTable.size());
+        pendingBlocks.clear();
+    }
+
+    struct OutgoingMessageHeader {
+        int device;
+        int size;
+        int samplePosition;
+        double blockStartTime;
+        double sampleRate;
+    };
+
+    struct IncomingMessageHeader {
+        int device;
+        int size;
+        double arrivalTime;
+    };
+
+    // The header and the data are written in one go, so the reader never sees a header without its data
+    template<typename Header>
+    static bool writeMessage(AbstractFifo& fifo, std::vector<uint8>& queue, Header const& header, uint8 const* data, int numBytes)
+    {
+        auto const totalSize = static_cast<int>(sizeof(Header)) + numBytes;
+        if (fifo.getFreeSpace() < totalSize)
+            return false;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(totalSize, start1, size1, start2, size2);
+
+        auto const copyTo = [&](int offset, uint8 const* source, int size) {
+            auto const sizeInFirst = std::clamp(size1 - offset, 0, size);
+            std::copy(source, source + sizeInFirst, queue.data() + start1 + offset);
+            std::copy(source + sizeInFirst, source + size, queue.data() + start2 + std::max(0, offset - size1));
+        };
+
+        copyTo(0, reinterpret_cast<uint8 const*>(&header), sizeof(Header));
+        copyTo(sizeof(Header), data, numBytes);
+        fifo.finishedWrite(totalSize);
+        return true;
+    }
+
+    // Reads the next message, if it's complete. The data is only copied if it fits in maxBytes, check header.size before using it
+    template<typename Header>
+    static bool readMessage(AbstractFifo& fifo, std::vector<uint8> const& queue, Header& header, uint8* data, int maxBytes)
+    {
+        auto const copyFrom = [&queue](int start1, int size1, int start2, int offset, uint8* destination, int size) {
+            auto const sizeInFirst = std::clamp(size1 - offset, 0, size);
+            std::copy(queue.data() + start1 + offset, queue.data() + start1 + offset + sizeInFirst, destination);
+            std::copy(queue.data() + start2 + std::max(0, offset - size1), queue.data() + start2 + std::max(0, offset - size1) + (size - sizeInFirst), destination + sizeInFirst);
+        };
+
+        int start1, size1, start2, size2;
+        auto const numReady = fifo.getNumReady();
+        if (numReady < static_cast<int>(sizeof(Header)))
+            return false;
+
+        // Look at the header without consuming it
+        fifo.prepareToRead(sizeof(Header), start1, size1, start2, size2);
+        copyFrom(start1, size1, start2, 0, reinterpret_cast<uint8*>(&header), sizeof(Header));
+
+        auto const totalSize = static_cast<int>(sizeof(Header)) + std::max(header.size, 0);
+        if (header.size < 0 || numReady < totalSize)
+            return false;
+
+        fifo.prepareToRead(totalSize, start1, size1, start2, size2);
+        if (header.size <= maxBytes)
+            copyFrom(start1, size1, start2, sizeof(Header), data, header.size);
+
+        fifo.finishedRead(totalSize);
+        return true;
+    }
+
+    void run() override
+    {
+        RealtimeThreadSettings::ThreadState threadState;
+        while (!threadShouldExit()) {
+            RealtimeThreadSettings::getInstance().applyToCurrentThread(RealtimeThreadSettings::MidiOutput, threadState);
+            sendQueuedMessages();
+
+            // Polling instead of notifying keeps the audio thread away from the event's mutex
+            wait(1);
+        }
+    }
+
+    // Hands the queued messages to the MidiOutputs, grouped per block, their background threads send them at the right time
+    void sendQueuedMessages()
+    {
+        ScopedLock lock(outputTableLock);
+
+        double blockStartTime = 0.0;
+        double sampleRate = 0.0;
+        auto const sendBlock = [this, &blockStartTime, &sampleRate]() {
+            for (auto& [output, buffer] : pendingBlocks) {
+                if (!buffer.isEmpty())
+                    output->sendBlockOfMessages(buffer, blockStartTime, sampleRate);
+                buffer.clear();
+            }
+        };
+
+        auto const addToBlock = [this](MidiOutput* output, MidiMessage const& message, int samplePosition) {
+            if (!output)
+                return;
+            for (auto& [pendingOutput, buffer] : pendingBlocks) {
+                if (pendingOutput == output) {
+                    buffer.addEvent(message, samplePosition);
+                    return;
+                }
+            }
+            pendingBlocks.emplace_back(output, MidiBuffer());
+            pendingBlocks.back().second.addEvent(message, samplePosition);
+        };
+
+        OutgoingMessageHeader header;
+        while (readMessage(outputFifo, outputQueue, header, outgoingMessageData, maxOutgoingMessageSize)) {
+            if (header.size > maxOutgoingMessageSize)
+                continue;
+
+            if (header.blockStartTime != blockStartTime || header.sampleRate != sampleRate) {
+                sendBlock();
+                blockStartTime = header.blockStartTime;
+                sampleRate = header.sampleRate;
+            }
+
+            auto const message = MidiMessage(outgoingMessageData, header.size);
+
+            // Device 0 means all devices
+            if (header.device == 0) {
+                for (auto* output : allOutputs)
+                    addToBlock(output, message, header.samplePosition);
+            } else if (isPositiveAndBelow(header.device - 1, static_cast<int>(outputTable.size()))) {
+                addToBlock(outputTable[header.device - 1], message, header.samplePosition);
+            }
+        }
+
+        sendBlock();
+    }
+
 public:
     void updateMidiDevices()
     {
@@ -186,6 +355,7 @@ public:
         midiDeviceMutex.unlock();
         clearInputFilter();
         clearOutputFilter();
+        updateOutputTable();
     }
 
     Array<MidiDeviceInfo> getInputDevicesUnfiltered()
@@ -309,6 +479,7 @@ public:
             if (shouldBeEnabled != internalOutputEnabled)
                 clearOutputFilter();
             internalOutputEnabled = shouldBeEnabled;
+            updateOutputTable();
             saveMidiOutputSettings();
         } else if (toPlugdata && identifier == toPlugdata->getIdentifier()) {
             if (shouldBeEnabled != internalInputEnabled) {
@@ -326,6 +497,8 @@ public:
                 clearInputFilter();
             }
         } else if (shouldBeEnabled != isMidiDeviceEnabled(false, identifier)) {
+            ScopedLock lock(outputTableLock);
+
             clearOutputFilter();
             if (shouldBeEnabled) {
                 auto* device = midiOutputs.add(MidiOutput::openDevice(identifier));
@@ -340,38 +513,74 @@ public:
                 }
             }
 
+            updateOutputTable();
             saveMidiOutputSettings();
         }
     }
 
-    void sendMidiOutputMessage(int device, MidiMessage& message)
+    // Safe to call from the audio thread: queues the message for the MIDI output thread without locking or allocating
+    // The message is sent at the time of its sample position in the block, messages that don't fit in the queue are dropped
+    void sendMidiOutputMessage(int device, MidiMessage const& message, double blockStartTime, int samplePosition, double sampleRate)
     {
-        // Device ID 0 means all devices
-        if (device == 0) {
-            for (auto* midiOutput : midiOutputs) {
-                midiOutput->sendMessageNow(message);
-            }
-            if (fromPlugdata && internalOutputEnabled)
-                fromPlugdata->sendMessageNow(message);
+        auto const size = message.getRawDataSize();
+        if (size <= 0 || size > maxOutgoingMessageSize)
             return;
-        }
 
-        auto idToFind = getOutputDevices()[device - 1].identifier;
-        // The order of midiOutputs is not necessarily the same as that of lastMidiOutputs, that's why we need to check
+        writeMessage(outputFifo, outputQueue, OutgoingMessageHeader { device, size, samplePosition, blockStartTime, sampleRate }, message.getRawData(), size);
+    }
 
-        if (fromPlugdata && idToFind == fromPlugdata->getIdentifier()) {
-            fromPlugdata->sendMessageNow(message);
+    // Called from the MIDI input threads: timestamps the message on arrival, and queues it for the next audio block
+    void enqueueMidiInput(int device, MidiMessage const& message)
+    {
+        auto const arrivalTime = Time::getMillisecondCounterHiRes();
+        auto const size = message.getRawDataSize();
+        if (size <= 0 || size > maxIncomingMessageSize)
+            return;
+
+        // Every input device calls this from its own thread, but the fifo only allows one writer
+        SpinLock::ScopedLockType lock(inputWriteLock);
+        writeMessage(inputFifo, inputQueue, IncomingMessageHeader { device, size, arrivalTime }, message.getRawData(), size);
+    }
+
+    // Called at the start of each audio block: adds the queued input messages to the buffer, in the plugdata sysex format
+    // Messages are delayed by exactly one block, so each one keeps the distance to the block start it arrived at
+    // That gives a constant latency, instead of quantising everything that arrived during the last block to its first sample
+    void readMidiInput(MidiBuffer& buffer, int numSamples, double sampleRate)
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
             return;
+
+        auto const now = Time::getMillisecondCounterHiRes();
+        auto const blockDuration = numSamples * 1000.0 / sampleRate;
+
+        // Audio callbacks don't arrive at perfectly regular intervals, so we loosely follow the time the
+        // driver takes between blocks, instead of the time the callback happened to be called at
+        // When we're too far off (after a dropout, or when the block size changed) we start over
+        auto const expectedBlockTime = inputBlockTime + blockDuration;
+        if (std::abs(now - expectedBlockTime) > blockDuration) {
+            inputBlockTime = now;
+        } else {
+            inputBlockTime = expectedBlockTime + (now - expectedBlockTime) * inputClockSmoothing;
         }
 
-        for (auto* midiOutput : midiOutputs) {
-            if (idToFind == midiOutput->getIdentifier()) {
-                midiOutput->sendMessageNow(message);
-                break;
-            }
+        IncomingMessageHeader header;
+        while (readMessage(inputFifo, inputQueue, header, incomingMessageData, maxIncomingMessageSize)) {
+            if (header.size > maxIncomingMessageSize)
+                continue;
+
+            // Time since the start of the previous block, which is the block the message arrived during
+            auto const position = roundToInt((header.arrivalTime - inputBlockTime + blockDuration) * sampleRate / 1000.0);
+            auto const message = MidiMessage(incomingMessageData, header.size, header.arrivalTime * 0.001);
+            buffer.addEvent(convertToSysExFormat(message, header.device), jlimit(0, numSamples - 1, position));
         }
     }
 
+    // Number of enabled output devices, without copying the device list like getOutputDevices()
+    int getNumOutputDevices() const
+    {
+        return numOutputDevices.load();
+    }
+
     int getMidiInputDeviceIndex(String const& identifier)
     {
         auto devices = getInputDevices();
@@ -404,4 +613,31 @@ private:
 
     Array<MidiDeviceInfo>* filteredMidiInputs;
     Array<MidiDeviceInfo>* filteredMidiOutputs;
+
+    // Outgoing messages from the audio thread, as a header followed by the raw MIDI data
+    static constexpr int outputQueueSize = 1 << 16;
+    static constexpr int maxOutgoingMessageSize = 1024;
+    AbstractFifo outputFifo { outputQueueSize };
+    std::vector<uint8> outputQueue = std::vector<uint8>(outputQueueSize);
+
+    // Only used by the output thread
+    uint8 outgoingMessageData[maxOutgoingMessageSize];
+    std::vector<std::pair<MidiOutput*, MidiBuffer>> pendingBlocks;
+
+    // Incoming messages from the MIDI input threads, in the same format
+    static constexpr int inputQueueSize = 1 << 16;
+    static constexpr int maxIncomingMessageSize = 16384; // Large enough for most SysEx dumps
+    static constexpr double inputClockSmoothing = 0.05;
+    AbstractFifo inputFifo { inputQueueSize };
+    std::vector<uint8> inputQueue = std::vector<uint8>(inputQueueSize);
+    SpinLock inputWriteLock;
+
+    // Only used by the audio thread
+    uint8 incomingMessageData[maxIncomingMessageSize];
+    double inputBlockTime = 0.0;
+
+    CriticalSection outputTableLock;
+    std::vector<MidiOutput*> outputTable;
+    std::vector<MidiOutput*> allOutputs;
+    std::atomic<int> numOutputDevices = 0;
 };
@@ -37,7 +37,23 @@ OfflineObjectRenderer* OfflineObjectRenderer::findParentOfflineObjectRendererFor
 
 ImageWithOffset OfflineObjectRenderer::patchToMaskedImage(String const& patch, float scale, bool makeInvalidImage)
 {
-    auto image = patchToTempImage(patch, scale);
+    return maskImage(patchToTempImage(patch, scale), makeInvalidImage);
+}
+
+void OfflineObjectRenderer::patchToMaskedImageAsync(String const& patch, float scale, bool makeInvalidImage, std::function<void(ImageWithOffset)> callback)
+{
+    previewPool.addJob([this, patch, scale, makeInvalidImage, callback]() {
+        auto image = patchToTempImage(patch, scale);
+
+        // The mask is coloured with the current theme, so we need to do that on the message thread
+        MessageManager::callAsync([image, makeInvalidImage, callback]() {
+            callback(maskImage(image, makeInvalidImage));
+        });
+    });
+}
+
+ImageWithOffset OfflineObjectRenderer::maskImage(ImageWithOffset const& image, bool makeInvalidImage)
+{
     auto width = image.image.getWidth();
     auto height = image.image.getHeight();
     auto output = Image(Image::ARGB, width, height, true);
@@ -63,15 +79,34 @@ ImageWithOffset OfflineObjectRenderer::patchToMaskedImage(String const& patch, f
     return ImageWithOffset(output, image.offset);
 }
 
+// Can be called from both the message thread and the preview thread
 ImageWithOffset OfflineObjectRenderer::patchToTempImage(String const& patch, float scale)
 {
-    static std::unordered_map<String, ImageWithOffset> patchImageCache;
+    auto const key = getPreviewCacheKey(patch, scale);
 
-    auto const patchSHA256 = SHA256(patch.getCharPointer()).toHexString();
-    if (patchImageCache.contains(patchSHA256)) {
-        return patchImageCache[patchSHA256];
+    {
+        ScopedLock lock(previewCacheLock);
+        if (previewCache.contains(key)) {
+            return previewCache[key];
+        }
     }
 
+    ImageWithOffset output;
+    if (!loadPreviewFromDisk(key, output)) {
+        output = renderTempImage(patch, scale);
+        savePreviewToDisk(key, output);
+    }
+
+    ScopedLock lock(previewCacheLock);
+    previewCache.emplace(key, output);
+    return output;
+}
+
+ImageWithOffset OfflineObjectRenderer::renderTempImage(String const& patch, float scale)
+{
+    Array<Rectangle<int>> objectRects;
+    Rectangle<int> totalSize;
+
     pd->setThis();
 
     sys_lock();
@@ -79,8 +114,6 @@ ImageWithOffset OfflineObjectRenderer::patchToTempImage(String const& patch, flo
 
     canvas_create_editor(offlineCnv);
 
-    objectRects.clear();
-    totalSize.setBounds(0, 0, 0, 0);
     int obj_x, obj_y, obj_w, obj_h;
     auto rect = Rectangle<int>();
     pd::Interface::paste(offlineCnv, stripConnections(patch).toRawUTF8());
@@ -115,7 +148,9 @@ ImageWithOffset OfflineObjectRenderer::patchToTempImage(String const& patch, flo
         rect.translate(-totalSize.getX(), -totalSize.getY());
     }
     auto size = Point<int>(totalSize.getWidth(), totalSize.getHeight());
-    Image image(Image::ARGB, totalSize.getWidth() * scale, totalSize.getHeight() * scale, true);
+
+    // This may run on a background thread, so don't use the native image type
+    Image image(Image::ARGB, totalSize.getWidth() * scale, totalSize.getHeight() * scale, true, SoftwareImageType());
     Graphics g(image);
     g.addTransform(AffineTransform::scale(scale));
     g.setColour(Colours::white);
@@ -123,9 +158,56 @@ ImageWithOffset OfflineObjectRenderer::patchToTempImage(String const& patch, flo
         g.fillRoundedRectangle(rect.toFloat(), 5.0f);
     }
 
-    auto output = ImageWithOffset(image, size);
-    patchImageCache.emplace(patchSHA256, output);
-    return output;
+    return ImageWithOffset(image, size);
+}
+
+String OfflineObjectRenderer::getPreviewCacheKey(String const& patch, float scale)
+{
+    // Object sizes can change between versions, so a new version shouldn't use the old previews
+    return SHA256((patch + String(scale) + ProjectInfo::versionString).toUTF8()).toHexString();
+}
+
+bool OfflineObjectRenderer::loadPreviewFromDisk(String const& key, ImageWithOffset& preview)
+{
+    FileInputStream input(previewCacheDir.getChildFile(key + ".preview"));
+    if (!input.openedOk())
+        return false;
+
+    auto offsetX = input.readInt();
+    auto offsetY = input.readInt();
+    auto image = PNGImageFormat().decodeImage(input);
+    if (image.isNull())
+        return false;
+
+    preview = ImageWithOffset(image, { offsetX, offsetY });
+    return true;
+}
+
+void OfflineObjectRenderer::savePreviewToDisk(String const& key, ImageWithOffset const& preview)
+{
+    // An empty patch results in an empty image, which we can't save as png
+    if (preview.image.isNull())
+        return;
+
+    MemoryOutputStream output;
+    output.writeInt(preview.offset.getX());
+    output.writeInt(preview.offset.getY());
+    PNGImageFormat().writeImageToStream(preview.image, output);
+
+    previewCacheDir.createDirectory();
+    previewCacheDir.getChildFile(key + ".preview").replaceWithData(output.getData(), output.getDataSize());
+}
+
+std::pair<int, size_t> OfflineObjectRenderer::getPreviewCacheSize()
+{
+    ScopedLock lock(previewCacheLock);
+
+    size_t numBytes = 0;
+    for (auto& [key, preview] : previewCache) {
+        numBytes += static_cast<size_t>(preview.image.getWidth()) * static_cast<size_t>(preview.image.getHeight()) * 4;
+    }
+
+    return { static_cast<int>(previewCache.size()), numBytes };
 }
 
 bool OfflineObjectRenderer::checkIfPatchIsValid(String const& patch)
@@ -30,17 +30,38 @@ public:
 
     ImageWithOffset patchToMaskedImage(String const& patch, float scale, bool makeInvalidImage = false);
 
+    // Same as patchToMaskedImage, but the objects get created on a background thread
+    // The callback is called on the message thread once the image is ready
+    void patchToMaskedImageAsync(String const& patch, float scale, bool makeInvalidImage, std::function<void(ImageWithOffset)> callback);
+
     bool checkIfPatchIsValid(String const& patch);
 
     std::pair<std::vector<bool>, std::vector<bool>> countIolets(String const& patch);
 
+    // Number of cached previews, and the memory used by their images
+    std::pair<int, size_t> getPreviewCacheSize();
+
 private:
     String stripConnections(String const& patch);
 
     ImageWithOffset patchToTempImage(String const& patch, float scale);
+    ImageWithOffset renderTempImage(String const& patch, float scale);
+
+    static ImageWithOffset maskImage(ImageWithOffset const& image, bool makeInvalidImage);
+
+    static String getPreviewCacheKey(String const& patch, float scale);
+    static bool loadPreviewFromDisk(String const& key, ImageWithOffset& preview);
+    static void savePreviewToDisk(String const& key, ImageWithOffset const& preview);
+
+    // Previews are stored on disk, so we only need to create the objects once for every palette item
+    static inline File const previewCacheDir = ProjectInfo::appDataDir.getChildFile("Cache").getChildFile("Previews");
+
+    std::unordered_map<String, ImageWithOffset> previewCache;
+    CriticalSection previewCacheLock;
 
-    Array<Rectangle<int>> objectRects;
-    Rectangle<int> totalSize;
     t_glist* offlineCnv = nullptr;
     pd::Instance* pd;
+
+    // Declared last, so it finishes its jobs before anything else gets deleted
+    ThreadPool previewPool = ThreadPool(1);
 };
@@ -0,0 +1,207 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Ring buffer of audio and MIDI between the host's block size and Pd's block size
+// The size of the ring is a multiple of Pd's block size, and the Pd side always reads or writes one whole block at a time,
+// so Pd blocks never wrap around and Pd can process directly from and into the ring. Only the host side has to copy, in at most two segments
+// MIDI events are kept in preallocated arrays, sorted by time, so nothing allocates on the audio thread
+// Only use this from the audio thread
+class PdBlockFifo {
+public:
+    void prepare(int numChannels, int newPdBlockSize, int maxHostBlockSize)
+    {
+        pdBlockSize = newPdBlockSize;
+
+        // Round up, so the ring holds a whole number of Pd blocks
+        auto const minimumSize = std::max(pdBlockSize, maxHostBlockSize) * 3;
+        size = (minimumSize + pdBlockSize - 1) / pdBlockSize * pdBlockSize;
+
+        audioBuffer.setSize(numChannels, size);
+        blockPointers.resize(numChannels, nullptr);
+
+        midiEvents.reserve(maxMidiEvents);
+        midiData.reserve(maxMidiBytes);
+
+        clear();
+    }
+
+    void clear()
+    {
+        audioBuffer.clear();
+        readPosition = 0;
+        writePosition = 0;
+        numReady = 0;
+        samplesRead = 0;
+        midiEvents.clear();
+        midiData.clear();
+    }
+
+    int getNumSamplesAvailable() const { return numReady; }
+    int getNumSamplesFree() const { return size - numReady; }
+
+    // Host side: copies the block into the ring, MIDI event positions are relative to the start of the block
+    // If the ring doesn't have enough space, the samples and events that don't fit are dropped
+    void write(dsp::AudioBlock<float> const& source, MidiBuffer const& midi)
+    {
+        jassert(getNumSamplesFree() >= static_cast<int>(source.getNumSamples()));
+        auto const numSamples = std::min(static_cast<int>(source.getNumSamples()), getNumSamplesFree());
+
+        addMidiEvents(midi, samplesRead + numReady, numSamples);
+
+        auto const numChannels = std::min<int>(audioBuffer.getNumChannels(), static_cast<int>(source.getNumChannels()));
+        auto const size1 = std::min(numSamples, size - writePosition);
+        auto const size2 = numSamples - size1;
+
+        for (int ch = 0; ch < numChannels; ch++) {
+            auto const* src = source.getChannelPointer(ch);
+            auto* dst = audioBuffer.getWritePointer(ch);
+            FloatVectorOperations::copy(dst + writePosition, src, size1);
+            if (size2 > 0)
+                FloatVectorOperations::copy(dst, src + size1, size2);
+        }
+
+        advanceWrite(numSamples);
+    }
+
+    // Host side: copies samples out of the ring, and adds the MIDI events for them
+    // If the ring doesn't have enough samples, the rest of the destination is filled with silence
+    void read(dsp::AudioBlock<float>& destination, MidiBuffer& midi)
+    {
+        jassert(getNumSamplesAvailable() >= static_cast<int>(destination.getNumSamples()));
+        auto const numSamples = std::min(static_cast<int>(destination.getNumSamples()), getNumSamplesAvailable());
+
+        if (numSamples < static_cast<int>(destination.getNumSamples()))
+            destination.getSubBlock(static_cast<size_t>(numSamples)).clear();
+
+        takeMidiEvents(midi, numSamples);
+
+        auto const numChannels = std::min<int>(audioBuffer.getNumChannels(), static_cast<int>(destination.getNumChannels()));
+        auto const size1 = std::min(numSamples, size - readPosition);
+        auto const size2 = numSamples - size1;
+
+        for (int ch = 0; ch < numChannels; ch++) {
+            auto const* src = audioBuffer.getReadPointer(ch);
+            auto* dst = destination.getChannelPointer(ch);
+            FloatVectorOperations::copy(dst, src + readPosition, size1);
+            if (size2 > 0)
+                FloatVectorOperations::copy(dst + size1, src, size2);
+        }
+
+        advanceRead(numSamples);
+    }
+
+    // Pd side: takes the next Pd block, the returned pointers stay valid until the next write
+    float const* const* readBlock(MidiBuffer& midi)
+    {
+        jassert(getNumSamplesAvailable() >= pdBlockSize && readPosition % pdBlockSize == 0);
+
+        takeMidiEvents(midi, pdBlockSize);
+
+        for (int ch = 0; ch < audioBuffer.getNumChannels(); ch++) {
+            blockPointers[ch] = audioBuffer.getWritePointer(ch) + readPosition;
+        }
+
+        advanceRead(pdBlockSize);
+        return blockPointers.data();
+    }
+
+    // Pd side: where Pd should write its next block, call finishedWritingBlock when it's done
+    float* const* getBlockWritePointers()
+    {
+        jassert(getNumSamplesFree() >= pdBlockSize && writePosition % pdBlockSize == 0);
+
+        for (int ch = 0; ch < audioBuffer.getNumChannels(); ch++) {
+            blockPointers[ch] = audioBuffer.getWritePointer(ch) + writePosition;
+        }
+
+        return blockPointers.data();
+    }
+
+    void finishedWritingBlock(MidiBuffer const& midi)
+    {
+        addMidiEvents(midi, samplesRead + numReady);
+        advanceWrite(pdBlockSize);
+    }
+
+private:
+    struct MidiEvent {
+        int64 time; // In samples since the fifo was cleared
+        int dataOffset;
+        int dataSize;
+    };
+
+    void advanceWrite(int numSamples)
+    {
+        writePosition = (writePosition + numSamples) % size;
+        numReady += numSamples;
+    }
+
+    void advanceRead(int numSamples)
+    {
+        readPosition = (readPosition + numSamples) % size;
+        numReady -= numSamples;
+        samplesRead += numSamples;
+    }
+
+    // Events are added in the order they happen, so the arrays stay sorted
+    void addMidiEvents(MidiBuffer const& midi, int64 startTime, int numSamples = std::numeric_limits<int>::max())
+    {
+        for (auto const event : midi) {
+            if (event.samplePosition >= numSamples)
+                break;
+
+            if (midiEvents.size() >= maxMidiEvents || midiData.size() + event.numBytes > maxMidiBytes) {
+                // Full, we'd have to allocate
+                jassertfalse;
+                break;
+            }
+
+            midiEvents.push_back({ startTime + event.samplePosition, static_cast<int>(midiData.size()), event.numBytes });
+            midiData.insert(midiData.end(), event.data, event.data + event.numBytes);
+        }
+    }
+
+    // Adds all events in the next numSamples to the buffer, and removes them from the fifo
+    void takeMidiEvents(MidiBuffer& midi, int numSamples)
+    {
+        auto const endTime = samplesRead + numSamples;
+
+        size_t numTaken = 0;
+        while (numTaken < midiEvents.size() && midiEvents[numTaken].time < endTime) {
+            auto const& event = midiEvents[numTaken];
+            midi.addEvent(midiData.data() + event.dataOffset, event.dataSize, static_cast<int>(std::max<int64>(event.time - samplesRead, 0)));
+            numTaken++;
+        }
+
+        if (numTaken == 0)
+            return;
+
+        // Moves the remaining events to the front, this doesn't reallocate
+        auto const numBytesTaken = numTaken < midiEvents.size() ? midiEvents[numTaken].dataOffset : static_cast<int>(midiData.size());
+        midiEvents.erase(midiEvents.begin(), midiEvents.begin() + static_cast<long>(numTaken));
+        midiData.erase(midiData.begin(), midiData.begin() + numBytesTaken);
+        for (auto& event : midiEvents) {
+            event.dataOffset -= numBytesTaken;
+        }
+    }
+
+    static constexpr size_t maxMidiEvents = 4096;
+    static constexpr size_t maxMidiBytes = 65536;
+
+    AudioBuffer<float> audioBuffer;
+    std::vector<float*> blockPointers;
+    int size = 1;
+    int pdBlockSize = 64;
+    int readPosition = 0;
+    int writePosition = 0;
+    int numReady = 0;
+    int64 samplesRead = 0;
+
+    std::vector<MidiEvent> midiEvents;
+    std::vector<uint8> midiData;
+};
@@ -83,7 +83,10 @@ public:
 
     void setName(String const& newName)
     {
+        processor.parameterRenamed(this, name, newName);
         name = newName;
+        receiverSymbol = nullptr;
+        signalReceiverSymbol = nullptr;
     }
 
     String getName(int maximumStringLength) const override
@@ -102,7 +105,14 @@ public:
 
     void setEnabled(bool shouldBeEnabled)
     {
+        auto const wasAutomatable = isAutomatable();
         enabled = shouldBeEnabled;
+        if (shouldBeEnabled)
+            flagChanged();
+
+        // Hosts that read the flags once won't see this until they re-scan, the others are told here
+        if (isAutomatable() != wasAutomatable)
+            notifyDAW();
     }
 
     NormalisableRange<float> const& getNormalisableRange() const override
@@ -126,6 +136,7 @@ public:
     void setUnscaledValueNotifyingHost(float newValue)
     {
         value = std::clamp(newValue, range.start, range.end);
+        flagChanged();
         sendValueChangedMessageToListeners(getValue());
     }
 
@@ -137,6 +148,7 @@ public:
     void setValue(float newValue) override
     {
         value = range.convertFrom0to1(newValue);
+        flagChanged();
     }
 
     float getDefaultValue() const override
@@ -171,9 +183,17 @@ public:
         return enabled;
     }
 
+    // Parameters beyond the number of exposed parameters are still registered, so the parameter list is the same for every instance,
+    // but hosts don't offer them for automation until they're used
+    // This only changes what the host lists for automation: it still scans and polls every registered parameter
+    void setExposed(bool shouldBeExposed)
+    {
+        exposed = shouldBeExposed;
+    }
+
     bool isAutomatable() const override
     {
-        return true;
+        return exposed || enabled;
     }
 
     bool isMetaParameter() const override
@@ -270,6 +290,29 @@ public:
         }
     }
 
+    // Returns the symbol we send this parameter's value to
+    // This gets resolved lazily on the audio thread, so we don't need to convert the name to a symbol every time we send a value
+    t_symbol* getReceiverSymbol()
+    {
+        auto* sym = receiverSymbol.load();
+        if (!sym) {
+            sym = processor.generateSymbol(name);
+            receiverSymbol = sym;
+        }
+        return sym;
+    }
+
+    // [param~] objects listen to the parameter name with a tilde appended
+    t_symbol* getSignalReceiverSymbol()
+    {
+        auto* sym = signalReceiverSymbol.load();
+        if (!sym) {
+            sym = processor.generateSymbol(name + "~");
+            signalReceiverSymbol = sym;
+        }
+        return sym;
+    }
+
     void setLastValue(float v)
     {
         lastValue = v;
@@ -307,6 +350,14 @@ public:
     }
 
 private:
+    // Mark this parameter as changed, so the audio thread will only look at parameters that were actually touched
+    void flagChanged()
+    {
+        auto const parameterIndex = getParameterIndex();
+        if (parameterIndex >= 0)
+            processor.flagParameterChanged(parameterIndex);
+    }
+
     float lastValue = 0.0f;
     float gestureState = 0.0f;
     float const defaultValue;
@@ -315,7 +366,10 @@ private:
     std::atomic<float> value;
     NormalisableRange<float> range;
     String name;
+    std::atomic<t_symbol*> receiverSymbol = nullptr;
+    std::atomic<t_symbol*> signalReceiverSymbol = nullptr;
     std::atomic<bool> enabled = false;
+    bool exposed = true;
 
     Mode mode;
 
@@ -0,0 +1,88 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "RealtimeSafety.h"
+
+#if PLUGDATA_REALTIME_SAFETY_CHECKS
+
+#include <juce_core/juce_core.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace RealtimeSafety {
+
+static thread_local int realtimeSectionDepth = 0;
+static thread_local bool isReporting = false;
+
+// Only print the first violations, after that we just count them. Otherwise the output would be unreadable
+static std::atomic<int> numViolations = 0;
+static constexpr int maxReportedViolations = 32;
+
+ScopedRealtimeSection::ScopedRealtimeSection()
+{
+    realtimeSectionDepth++;
+}
+
+ScopedRealtimeSection::~ScopedRealtimeSection()
+{
+    realtimeSectionDepth--;
+}
+
+bool isInRealtimeSection()
+{
+    return realtimeSectionDepth > 0 && !isReporting;
+}
+
+void reportViolation(char const* description)
+{
+    if (!isInRealtimeSection())
+        return;
+
+    auto const violation = ++numViolations;
+    if (violation > maxReportedViolations) {
+        if (violation % 1000 == 0)
+            std::fprintf(stderr, "[plugdata] %d realtime-safety violations on the audio thread so far\n", violation);
+        return;
+    }
+
+    // Creating the stack trace allocates too, so turn off the checks while reporting
+    isReporting = true;
+    auto const stackTrace = juce::SystemStats::getStackBacktrace();
+    std::fprintf(stderr, "[plugdata] Realtime-safety violation on the audio thread: %s\n%s\n", description, stackTrace.toRawUTF8());
+    isReporting = false;
+}
+
+}
+
+static void* allocate(std::size_t size)
+{
+    RealtimeSafety::reportViolation("memory allocation");
+
+    if (auto* ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+static void deallocate(void* ptr) noexcept
+{
+    if (ptr)
+        RealtimeSafety::reportViolation("memory deallocation");
+
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* ptr) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { deallocate(ptr); }
+
+#endif
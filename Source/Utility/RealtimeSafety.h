@@ -0,0 +1,37 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Realtime-safety checks for the audio thread, enabled with the ENABLE_REALTIME_SAFETY_CHECKS build option
+// While a ScopedRealtimeSection exists on a thread, allocations and the locks we check with reportViolation are reported to stderr, with a stack trace
+// This replaces the global operator new and delete, so other targets that link the plugin shouldn't replace them too
+// Without the build option, all of this compiles to nothing
+namespace RealtimeSafety {
+
+#if PLUGDATA_REALTIME_SAFETY_CHECKS
+
+struct ScopedRealtimeSection {
+    ScopedRealtimeSection();
+    ~ScopedRealtimeSection();
+};
+
+bool isInRealtimeSection();
+
+// Reports that something that isn't realtime-safe happened, if we are in a realtime section
+void reportViolation(char const* description);
+
+#else
+
+struct ScopedRealtimeSection {
+};
+
+inline bool isInRealtimeSection() { return false; }
+inline void reportViolation(char const*) { }
+
+#endif
+
+}
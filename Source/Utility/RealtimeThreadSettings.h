@@ -0,0 +1,132 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#if JUCE_LINUX
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+
+// Lets the standalone run its realtime threads at a fixed SCHED_FIFO priority, pinned to specific cores
+// This is meant for dedicated Linux machines with isolated cores, so GUI load can't preempt audio. On other platforms it does nothing
+// Threads apply the settings themselves by calling applyToCurrentThread() once per cycle, which is only an atomic load when nothing changed
+class RealtimeThreadSettings {
+public:
+    enum Role {
+        AudioCallback = 0,
+        MidiOutput,
+        DspWorker,
+        NumRoles
+    };
+
+    // Kept by each thread, so it knows when it's out of date and what to go back to
+    struct ThreadState {
+        int generation = 0;
+        bool hasOriginalScheduling = false;
+        int originalPolicy = 0;
+        int originalPriority = 0;
+        uint64 originalCoreMask = 0;
+    };
+
+    static RealtimeThreadSettings& getInstance()
+    {
+        static RealtimeThreadSettings instance;
+        return instance;
+    }
+
+    // A priority of 0 leaves the thread's scheduling alone, an empty core list lets it run on its original cores
+    void setThreadSettings(Role role, int priority, String const& cores)
+    {
+        auto& settings = roles[role];
+        settings.priority = jlimit(0, 99, priority);
+        settings.coreMask = parseCoreList(cores);
+        settings.generation++;
+    }
+
+    void applyToCurrentThread(Role role, ThreadState& state)
+    {
+        auto& settings = roles[role];
+        auto const generation = settings.generation.load();
+        if (generation == state.generation)
+            return;
+
+        state.generation = generation;
+
+#if JUCE_LINUX
+        auto const thread = pthread_self();
+
+        if (!state.hasOriginalScheduling) {
+            sched_param param {};
+            pthread_getschedparam(thread, &state.originalPolicy, &param);
+            state.originalPriority = param.sched_priority;
+
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            pthread_getaffinity_np(thread, sizeof(cpus), &cpus);
+            for (int core = 0; core < maxCores; core++) {
+                if (CPU_ISSET(core, &cpus))
+                    state.originalCoreMask |= uint64(1) << core;
+            }
+            state.hasOriginalScheduling = true;
+        }
+
+        // Setting SCHED_FIFO fails without an rtprio limit for the user (in /etc/security/limits.conf), in which case we keep the current priority
+        auto const priority = settings.priority.load();
+        sched_param param {};
+        param.sched_priority = priority > 0 ? priority : state.originalPriority;
+        pthread_setschedparam(thread, priority > 0 ? SCHED_FIFO : state.originalPolicy, &param);
+
+        auto coreMask = settings.coreMask.load();
+        if (coreMask == 0)
+            coreMask = state.originalCoreMask;
+
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int core = 0; core < maxCores; core++) {
+            if (coreMask & (uint64(1) << core))
+                CPU_SET(core, &cpus);
+        }
+        pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+#endif
+    }
+
+    static String getSettingName(Role role, String const& property)
+    {
+        static StringArray const roleNames = { "audio", "midi", "worker" };
+        return "realtime_" + roleNames[role] + "_" + property;
+    }
+
+    // Parses a core list like "2,3" or "2-5" into a bit mask, zero means no cores were given
+    static uint64 parseCoreList(String const& cores)
+    {
+        uint64 mask = 0;
+        for (auto const& range : StringArray::fromTokens(cores, ",", "")) {
+            auto const start = range.upToFirstOccurrenceOf("-", false, false).trim();
+            auto const end = range.contains("-") ? range.fromFirstOccurrenceOf("-", false, false).trim() : start;
+            if (!start.containsOnly("0123456789") || !end.containsOnly("0123456789") || start.isEmpty() || end.isEmpty())
+                continue;
+
+            for (int core = start.getIntValue(); core <= std::min(end.getIntValue(), maxCores - 1); core++) {
+                mask |= uint64(1) << core;
+            }
+        }
+        return mask;
+    }
+
+private:
+    static constexpr int maxCores = 64;
+
+    struct Settings {
+        std::atomic<int> priority = 0;
+        std::atomic<uint64> coreMask = 0;
+        std::atomic<int> generation = 0;
+    };
+
+    Settings roles[NumRoles];
+};
@@ -0,0 +1,12 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Utility/Config.h"
+
+#include "RealtimeWorkerPool.h"
+
+JUCE_IMPLEMENT_SINGLETON(RealtimeWorkerPool)
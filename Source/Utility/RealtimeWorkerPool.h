@@ -0,0 +1,193 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <semaphore>
+#include <concurrentqueue.h>
+#include "RealtimeThreadSettings.h"
+
+// Realtime worker threads shared by all plugdata instances in the process
+// With many instances in a DAW session, per-instance threads would oversubscribe the machine, so the number of workers is one global budget
+// Each instance submits its work for a block to a TaskGroup, and waits for the group before the block ends. While waiting, the
+// submitting thread runs its own queued tasks, so a group always finishes, even when the budget is 0 or all workers are busy with other instances
+// Submitting and waiting don't lock or allocate, only changing the budget and creating a TaskGroup do
+// Workers are only started in the standalone, since only its internal synth submits work
+class RealtimeWorkerPool : public DeletedAtShutdown {
+public:
+    // Work that was submitted together, and has to be finished together
+    // Each group has its own producer token, so its tasks go into space the queue already allocated for it
+    // Only use a group from one thread at a time
+    class TaskGroup {
+    public:
+        TaskGroup()
+            : producerToken(RealtimeWorkerPool::getInstance()->tasks)
+        {
+        }
+
+        bool isFinished() const
+        {
+            return numPending.load(std::memory_order_acquire) == 0;
+        }
+
+    private:
+        friend class RealtimeWorkerPool;
+        std::atomic<int> numPending = 0;
+        moodycamel::ProducerToken producerToken;
+
+        JUCE_DECLARE_NON_COPYABLE(TaskGroup)
+    };
+
+    RealtimeWorkerPool() = default;
+
+    ~RealtimeWorkerPool() override
+    {
+        numOfflineRenders = 0;
+        setCoreBudget(0);
+        clearSingletonInstance();
+    }
+
+    // Number of worker threads, shared by all instances
+    void setCoreBudget(int numThreads)
+    {
+        std::lock_guard lock(workersLock);
+        configuredBudget = jlimit(0, maxWorkers, numThreads);
+        updateWorkers();
+    }
+
+    // While an instance renders offline, there's no deadline to share the machine for, so we use every core until it's done
+    void setRenderingOffline(bool isRenderingOffline)
+    {
+        std::lock_guard lock(workersLock);
+        numOfflineRenders = std::max(0, numOfflineRenders + (isRenderingOffline ? 1 : -1));
+        updateWorkers();
+    }
+
+    int getCoreBudget() const
+    {
+        return coreBudget;
+    }
+
+    // Runs function(context) on one of the workers, the context has to stay alive until the group is finished
+    void submit(TaskGroup& group, void (*function)(void*), void* context)
+    {
+        group.numPending.fetch_add(1, std::memory_order_relaxed);
+
+        if (coreBudget.load(std::memory_order_relaxed) == 0 || !tasks.try_enqueue(group.producerToken, { function, context, &group })) {
+            // No workers, or the queue is full: run it right away
+            runTask({ function, context, &group });
+            return;
+        }
+
+        tasksAvailable.release();
+    }
+
+    // Helps running tasks until all tasks in the group are done
+    // Only tasks from the same group are run on the waiting thread: tasks from other instances expect their own pd_this,
+    // so those are put back for the workers or for the instance that submitted them
+    void wait(TaskGroup& group)
+    {
+        // A task from another group that we took out of the queue, and couldn't put back yet
+        Task foreignTask;
+
+        while (!group.isFinished() || foreignTask.group) {
+            // try_enqueue only uses space that was preallocated for our token. If there's none left, we hold on to the task and try again
+            // The semaphore still counts it, so we don't release it again
+            if (foreignTask.group && tasks.try_enqueue(group.producerToken, foreignTask))
+                foreignTask = {};
+
+            Task task;
+            if (foreignTask.group || !tasks.try_dequeue(task)) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (task.group == &group)
+                runTask(task);
+            else
+                foreignTask = task;
+        }
+    }
+
+    JUCE_DECLARE_SINGLETON(RealtimeWorkerPool, false)
+
+private:
+    // Only call this while holding the workers lock
+    void updateWorkers()
+    {
+        auto numThreads = configuredBudget;
+        if (numOfflineRenders > 0)
+            numThreads = jlimit(0, maxWorkers, std::max(numThreads, SystemStats::getNumCpus() - 1));
+
+        while (workers.size() > numThreads) {
+            workers.getLast()->signalThreadShouldExit();
+            tasksAvailable.release();
+            workers.removeLast(); // Waits for the thread to finish, any tasks it didn't get to stay in the queue
+        }
+
+        while (workers.size() < numThreads) {
+            workers.add(new Worker(*this, workers.size()))->startThread(Thread::Priority::highest);
+        }
+
+        coreBudget = numThreads;
+    }
+
+    struct Task {
+        void (*function)(void*) = nullptr;
+        void* context = nullptr;
+        TaskGroup* group = nullptr;
+    };
+
+    class Worker final : public Thread {
+    public:
+        Worker(RealtimeWorkerPool& workerPool, int index)
+            : Thread("DSP worker " + String(index + 1))
+            , pool(workerPool)
+        {
+        }
+
+        ~Worker() override
+        {
+            stopThread(1000);
+        }
+
+        void run() override
+        {
+            RealtimeThreadSettings::ThreadState threadState;
+            while (!threadShouldExit()) {
+                if (!pool.tasksAvailable.try_acquire_for(std::chrono::milliseconds(100)))
+                    continue;
+
+                RealtimeThreadSettings::getInstance().applyToCurrentThread(RealtimeThreadSettings::DspWorker, threadState);
+
+                Task task;
+                if (pool.tasks.try_dequeue(task))
+                    runTask(task);
+            }
+        }
+
+    private:
+        RealtimeWorkerPool& pool;
+    };
+
+    static void runTask(Task const& task)
+    {
+        task.function(task.context);
+        task.group->numPending.fetch_sub(1, std::memory_order_release);
+    }
+
+    static constexpr int maxWorkers = 64;
+
+    // Preallocated for enough tasks and task groups, so enqueueing with a group's token doesn't need to allocate
+    moodycamel::ConcurrentQueue<Task> tasks = moodycamel::ConcurrentQueue<Task>(1024, 32, 0);
+    std::counting_semaphore<> tasksAvailable { 0 };
+    std::atomic<int> coreBudget = 0;
+
+    std::mutex workersLock;
+    OwnedArray<Worker> workers;
+    int configuredBudget = 0;
+    int numOfflineRenders = 0;
+};
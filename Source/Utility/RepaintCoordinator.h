@@ -0,0 +1,109 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Collects repaint requests for components on a canvas, and invalidates them together once per frame
+// Components that ask for a repaint many times within one frame (hover changes, scopes, arrays being written to)
+// will only be invalidated once, which keeps the list of dirty regions that the peer has to merge short
+// It also measures how long the canvas takes to paint, and how long a patch took to open until it was first drawn,
+// which the statusbar shows in its CPU breakdown
+class RepaintCoordinator : private Timer {
+public:
+    struct Statistics {
+        int64 numRequests = 0;   // Number of repaint requests
+        int64 numRepaints = 0;   // Number of component repaints that were issued for those requests
+        int64 repaintedArea = 0; // Total area of the issued repaints, in canvas pixels
+        int64 numFrames = 0;     // Number of times the canvas was painted
+        double paintTimeMs = 0.0;
+        double maxPaintTimeMs = 0.0;
+    };
+
+    // Repaints the component at the start of the next frame
+    void repaint(Component* component)
+    {
+        statistics.numRequests++;
+
+        if (!pendingComponents.insert(component).second)
+            return;
+
+        pendingRepaints.emplace_back(component);
+
+        if (!isTimerRunning())
+            startTimerHz(refreshRate);
+    }
+
+    // Called by the canvas before it paints itself and after it painted its children
+    void paintStarted()
+    {
+        paintStartTime = Time::getMillisecondCounterHiRes();
+    }
+
+    // Measures the time until the canvas has finished painting for the first time, for example from when a patch started opening
+    void measureTimeToFirstFrame(double startTime)
+    {
+        firstFrameStartTime = startTime;
+    }
+
+    double getTimeToFirstFrame() const
+    {
+        return timeToFirstFrameMs;
+    }
+
+    void paintFinished()
+    {
+        auto const currentTime = Time::getMillisecondCounterHiRes();
+        auto const elapsed = currentTime - paintStartTime;
+
+        if (firstFrameStartTime > 0.0) {
+            timeToFirstFrameMs = currentTime - firstFrameStartTime;
+            firstFrameStartTime = 0.0;
+        }
+        statistics.paintTimeMs += elapsed;
+        statistics.maxPaintTimeMs = std::max(statistics.maxPaintTimeMs, elapsed);
+        statistics.numFrames++;
+    }
+
+    Statistics const& getStatistics() const
+    {
+        return statistics;
+    }
+
+    void resetStatistics()
+    {
+        statistics = Statistics();
+    }
+
+private:
+    void timerCallback() override
+    {
+        stopTimer();
+
+        // Repainting can cause new repaint requests, those will go to the next frame
+        std::vector<Component::SafePointer<Component>> repaints;
+        std::swap(repaints, pendingRepaints);
+        pendingComponents.clear();
+
+        for (auto& component : repaints) {
+            if (!component)
+                continue;
+
+            statistics.numRepaints++;
+            statistics.repaintedArea += static_cast<int64>(component->getWidth()) * component->getHeight();
+            component->repaint();
+        }
+    }
+
+    static constexpr int refreshRate = 60;
+
+    std::vector<Component::SafePointer<Component>> pendingRepaints;
+    std::unordered_set<Component*> pendingComponents;
+
+    Statistics statistics;
+    double paintStartTime = 0.0;
+    double firstFrameStartTime = 0.0;
+    double timeToFirstFrameMs = 0.0;
+};
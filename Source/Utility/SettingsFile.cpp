@@ -48,6 +48,9 @@ SettingsFile* SettingsFile::initialise()
     } else {
         // Or load the settings when they exist already
         settingsTree = ValueTree::fromXml(settingsFile.loadFileAsString());
+
+        String fileWriter;
+        readFileInfo(settingsTree, generation, fileWriter);
     }
 
     // Make sure all the properties exist
@@ -81,7 +84,8 @@ SettingsFile* SettingsFile::initialise()
     saveSettings();
 
     settingsTree.addListener(this);
-    settingsFileWatcher.addFolder(settingsFile.getParentDirectory());
+    // We only care about the settings file itself, not the rest of the app directory
+    settingsFileWatcher.addFolder(settingsFile.getParentDirectory(), false);
     settingsFileWatcher.addListener(this);
 
     return this;
@@ -319,26 +323,51 @@ void SettingsFile::initialiseOverlayTree()
     }
 }
 
-void SettingsFile::reloadSettings()
+void SettingsFile::readFileInfo(ValueTree& tree, int64& fileGeneration, String& fileWriter)
 {
-    if (settingsChangedInternally) {
-        settingsChangedInternally = false;
-        return;
-    }
+    fileGeneration = static_cast<int64>(tree.getProperty("generation", 0));
+    fileWriter = tree.getProperty("writer").toString();
 
-    settingsChangedExternally = true;
+    // These only exist in the file, they shouldn't end up in our settings
+    tree.removeProperty("generation", nullptr);
+    tree.removeProperty("writer", nullptr);
+}
 
+void SettingsFile::reloadSettings()
+{
     jassert(isInitialised);
 
     auto newTree = ValueTree::fromXml(settingsFile.loadFileAsString());
+    if (!newTree.isValid())
+        return;
+
+    int64 fileGeneration;
+    String fileWriter;
+    readFileInfo(newTree, fileGeneration, fileWriter);
+
+    // Ignore our own writes, and files older than the last version we've seen
+    if (fileWriter == writerId || (fileWriter.isNotEmpty() && fileGeneration <= generation))
+        return;
+
+    generation = std::max(generation, fileGeneration);
+
+    if (settingsTree.isEquivalentTo(newTree))
+        return;
 
     // Children shouldn't be overwritten as that would break some valueTree links
+    // Only the children that changed are copied, so listeners only get notified about actual changes
     for (auto child : settingsTree) {
-        child.copyPropertiesAndChildrenFrom(newTree.getChildWithName(child.getType()), nullptr);
+        auto newChild = newTree.getChildWithName(child.getType());
+        if (!child.isEquivalentTo(newChild))
+            child.copyPropertiesAndChildrenFrom(newChild, nullptr);
     }
 
+    // Only sends property change notifications for values that are different
     settingsTree.copyPropertiesFrom(newTree, nullptr);
 
+    // This is what's on disk now, so the timer that our listener callbacks started doesn't need to write it back
+    lastSavedXml = settingsTree.toXmlString();
+
     for (auto* listener : listeners) {
         listener->settingsFileReloaded();
     }
@@ -357,22 +386,38 @@ void SettingsFile::valueTreePropertyChanged(ValueTree& treeWhosePropertyHasChang
         listener->propertyChanged(property.toString(), treeWhosePropertyHasChanged.getProperty(property));
     }
 
-    if (!settingsChangedExternally)
-        settingsChangedInternally = true;
+    if (isSearchPathTree(treeWhosePropertyHasChanged))
+        triggerAsyncUpdate();
+
     startTimer(700);
 }
 
+bool SettingsFile::isSearchPathTree(ValueTree const& tree)
+{
+    return tree == getPathsTree() || tree == getLibrariesTree() || tree.isAChildOf(getPathsTree()) || tree.isAChildOf(getLibrariesTree());
+}
+
+void SettingsFile::handleAsyncUpdate()
+{
+    for (auto* listener : listeners) {
+        listener->searchPathsChanged();
+    }
+}
+
 void SettingsFile::valueTreeChildAdded(ValueTree& parentTree, ValueTree& childWhichHasBeenAdded)
 {
-    if (!settingsChangedExternally)
-        settingsChangedInternally = true;
+    // Paths are usually replaced all at once, so this groups the changes into one notification
+    if (isSearchPathTree(parentTree))
+        triggerAsyncUpdate();
+
     startTimer(700);
 }
 
 void SettingsFile::valueTreeChildRemoved(ValueTree& parentTree, ValueTree& childWhichHasBeenRemoved, int indexFromWhichChildWasRemoved)
 {
-    if (!settingsChangedExternally)
-        settingsChangedInternally = true;
+    if (isSearchPathTree(parentTree))
+        triggerAsyncUpdate();
+
     startTimer(700);
 }
 
@@ -380,13 +425,6 @@ void SettingsFile::timerCallback()
 {
     jassert(isInitialised);
 
-    // Don't save again if we just loaded it from file
-    if (settingsChangedExternally) {
-        settingsChangedExternally = false;
-        stopTimer();
-        return;
-    }
-
     // Save settings to file whenever valuetree state changes
     // Use timer to group changes together
     saveSettings();
@@ -402,9 +440,26 @@ void SettingsFile::setGlobalScale(float newScale)
 void SettingsFile::saveSettings()
 {
     jassert(isInitialised);
-    // Save settings to file
+
+    // Don't touch the file if nothing changed since we last wrote or read it, every write makes all other instances reload
     auto xml = settingsTree.toXmlString();
-    settingsFile.replaceWithText(xml);
+    if (xml == lastSavedXml)
+        return;
+
+    lastSavedXml = xml;
+
+    // The generation is time based, so it also increases when another process wrote the file in the meantime
+    generation = std::max(generation + 1, Time::currentTimeMillis());
+
+    auto fileTree = settingsTree.createCopy();
+    fileTree.setProperty("generation", generation, nullptr);
+    fileTree.setProperty("writer", writerId, nullptr);
+
+    // Write to a temporary file and move it into place, so other instances never read a half-written file
+    TemporaryFile tempFile(settingsFile);
+    if (tempFile.getFile().replaceWithText(fileTree.toXmlString())) {
+        tempFile.overwriteTargetFileWithTemporary();
+    }
 }
 
 void SettingsFile::setProperty(String const& name, var const& value)
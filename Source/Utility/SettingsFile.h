@@ -16,12 +16,16 @@ public:
     virtual void propertyChanged(String const& name, var const& value) { }
 
     virtual void settingsFileReloaded() { }
+
+    // Called when the search paths or libraries changed, either from within plugdata or in the file
+    virtual void searchPathsChanged() { }
 };
 
 // Class that manages the settings file
 class SettingsFile : public ValueTree::Listener
     , public FileSystemWatcher::Listener
     , public Timer
+    , public AsyncUpdater
     , public DeletedAtShutdown {
 public:
     ~SettingsFile() override;
@@ -56,6 +60,7 @@ public:
     void valueTreeChildRemoved(ValueTree& parentTree, ValueTree& childWhichHasBeenRemoved, int indexFromWhichChildWasRemoved) override;
 
     void timerCallback() override;
+    void handleAsyncUpdate() override;
 
     void saveSettings();
 
@@ -94,8 +99,16 @@ private:
 
     File settingsFile = ProjectInfo::appDataDir.getChildFile(".settings");
     ValueTree settingsTree = ValueTree("SettingsTree");
-    bool settingsChangedInternally = false;
-    bool settingsChangedExternally = false;
+
+    // Every write stores a generation and the id of the writer in the file, so other instances can ignore
+    // their own writes and events for versions they have already seen
+    int64 generation = 0;
+    String const writerId = Uuid().toString();
+    String lastSavedXml;
+
+    void readFileInfo(ValueTree& tree, int64& fileGeneration, String& fileWriter);
+
+    bool isSearchPathTree(ValueTree const& tree);
 
     std::vector<std::pair<String, var>> defaultSettings {
         { "browser_path", var(ProjectInfo::appDataDir.getFullPathName()) },
@@ -104,6 +117,17 @@ private:
         { "protected", var(1) },
         { "debug_connections", var(1) },
         { "internal_synth", var(0) },
+        { "internal_synth_worker_thread", var(0) },
+        { "internal_synth_voices", var(256) },
+        { "buffer_autotune_headroom", var(30) },
+        { "realtime_audio_priority", var(0) },
+        { "realtime_audio_cores", var("") },
+        { "realtime_midi_priority", var(0) },
+        { "realtime_midi_cores", var("") },
+        { "realtime_worker_priority", var(0) },
+        { "realtime_worker_cores", var("") },
+        { "realtime_worker_threads", var(2) },
+        { "exposed_parameters", var(512) },
         { "grid_enabled", var(1) },
         { "grid_type", var(6) },
         { "grid_size", var(20) },
@@ -128,6 +152,14 @@ private:
         { "add_object_menu_pinned", var(false) },
         { "autosave_interval", var(120) },
         { "autosave_enabled", var(1) },
+        { "playhead_resend_interval", var(32) },
+        { "sample_accurate_midi", var(1) },
+        { "gui_message_queue_size", var(32768) },
+        { "hardware_rendering", var(false) },
+        { "level_of_detail_zoom", var(50) },
+        { "max_undo_steps", var(250) },
+        { "defer_library_loading", var(false) },
+        { "show_minimap", var(false) },
         { "macos_buttons",
 #if JUCE_MAC
             var(true)
@@ -137,6 +169,7 @@ private:
         },
         // DEFAULT SETTINGS FOR TOGGLES
         { "search_order", var(true) },
+        { "search_buses", var(false) },
     };
 
     StringArray childTrees {
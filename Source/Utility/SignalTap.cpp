@@ -0,0 +1,62 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "SignalTap.h"
+
+#include <m_pd.h>
+#include <m_imp.h>
+#include <g_canvas.h>
+
+static_assert(SignalTap::blockSize == DEFDACBLKSIZE);
+
+SignalTap::SignalTap(pd::Instance* instance, pd::WeakReference connectionToTap, int numBlocksToQueue, int decimationFactor)
+    : pd(instance)
+    , connection(std::move(connectionToTap))
+    , decimation(std::max(decimationFactor, 1))
+    , queue(numBlocksToQueue)
+{
+    pd->registerDisplaySource(this);
+}
+
+SignalTap::~SignalTap()
+{
+    pd->unregisterDisplaySource(this);
+}
+
+bool SignalTap::read(Block& block)
+{
+    return queue.try_dequeue(block);
+}
+
+void SignalTap::clear()
+{
+    Block block;
+    while (queue.try_dequeue(block)) { }
+}
+
+void SignalTap::publishDisplayData()
+{
+    if (!plugdata_debugging_enabled() || ++blockCounter < decimation)
+        return;
+
+    blockCounter = 0;
+
+    // We're already holding the audio lock here, so we don't need to lock again
+    auto* outconnect = connection.getRaw<t_outconnect>();
+    if (!outconnect)
+        return;
+
+    auto* signal = outconnect_get_signal(outconnect);
+    if (!signal || !signal->s_vec)
+        return;
+
+    Block block;
+    block.numChannels = std::min(signal->s_nchans, maxChannels);
+    std::copy(signal->s_vec, signal->s_vec + block.numChannels * blockSize, block.samples);
+
+    // If the reader falls behind, drop the block instead of allocating
+    queue.try_enqueue(std::move(block));
+}
@@ -0,0 +1,45 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <readerwriterqueue.h>
+#include "Pd/Instance.h"
+
+// Copies the signal that flows through a connection, so the GUI can display it
+// Any number of taps can be attached, each one has its own lock-free queue, so neither the audio thread nor the reader ever wait
+// Signals are only kept around by pd while debugging is enabled, otherwise the tap stays empty
+class SignalTap : public pd::Instance::DisplaySource {
+public:
+    static constexpr int maxChannels = 8;
+    static constexpr int blockSize = 64; // DEFDACBLKSIZE
+
+    struct Block {
+        float samples[maxChannels * blockSize];
+        int numChannels = 0;
+    };
+
+    // When decimation is larger than 1, only one of every "decimation" blocks is copied
+    SignalTap(pd::Instance* instance, pd::WeakReference connection, int numBlocksToQueue, int decimation = 1);
+    ~SignalTap() override;
+
+    // Only call from the reading thread. Returns false if there are no more blocks in the queue
+    bool read(Block& block);
+
+    void clear();
+
+private:
+    // Called from the audio thread, while holding the audio lock
+    void publishDisplayData() override;
+
+    pd::Instance* pd;
+    pd::WeakReference connection;
+    int const decimation;
+    int blockCounter = 0;
+
+    moodycamel::ReaderWriterQueue<Block> queue;
+};
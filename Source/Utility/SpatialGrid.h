@@ -0,0 +1,131 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Uniform grid over item bounds, so we can find the items in an area without looking at every item
+// Items are stored in every cell that their bounds touch, and need to be updated whenever their bounds change
+template<typename T>
+class SpatialGrid {
+public:
+    explicit SpatialGrid(int cellSizeToUse = 256)
+        : cellSize(cellSizeToUse)
+    {
+    }
+
+    void insertOrUpdate(T item, Rectangle<int> bounds)
+    {
+        auto const cellRange = getCellRange(bounds);
+
+        auto it = itemCells.find(item);
+        if (it != itemCells.end()) {
+            // Still in the same cells, nothing to do
+            if (it->second.cellRange == cellRange) {
+                it->second.bounds = bounds;
+                return;
+            }
+
+            removeFromCells(item, it->second.cellRange);
+            it->second = { bounds, cellRange };
+        } else {
+            itemCells.emplace(item, ItemInfo { bounds, cellRange });
+        }
+
+        for (int x = cellRange.getX(); x <= cellRange.getRight(); x++) {
+            for (int y = cellRange.getY(); y <= cellRange.getBottom(); y++) {
+                cells[getCellKey(x, y)].push_back(item);
+            }
+        }
+    }
+
+    void remove(T item)
+    {
+        auto it = itemCells.find(item);
+        if (it == itemCells.end())
+            return;
+
+        removeFromCells(item, it->second.cellRange);
+        itemCells.erase(it);
+    }
+
+    // Calls the callback once for every item with bounds that intersect the area
+    template<typename Callback>
+    void forEachItemIn(Rectangle<int> area, Callback&& callback) const
+    {
+        auto const queryRange = getCellRange(area);
+
+        for (int x = queryRange.getX(); x <= queryRange.getRight(); x++) {
+            for (int y = queryRange.getY(); y <= queryRange.getBottom(); y++) {
+                auto cell = cells.find(getCellKey(x, y));
+                if (cell == cells.end())
+                    continue;
+
+                for (auto item : cell->second) {
+                    auto const& info = itemCells.at(item);
+
+                    // Items can be in multiple cells, only report them in the first cell where they overlap with the query
+                    if (x != std::max(info.cellRange.getX(), queryRange.getX()) || y != std::max(info.cellRange.getY(), queryRange.getY()))
+                        continue;
+
+                    if (info.bounds.intersects(area))
+                        callback(item);
+                }
+            }
+        }
+    }
+
+    Array<T> getItemsIn(Rectangle<int> area) const
+    {
+        Array<T> result;
+        forEachItemIn(area, [&result](T item) { result.add(item); });
+        return result;
+    }
+
+private:
+    struct ItemInfo {
+        Rectangle<int> bounds;
+        Rectangle<int> cellRange; // Inclusive range of cells, so the right and bottom are the last cell
+    };
+
+    Rectangle<int> getCellRange(Rectangle<int> bounds) const
+    {
+        auto const x1 = floorDiv(bounds.getX());
+        auto const y1 = floorDiv(bounds.getY());
+        auto const x2 = floorDiv(bounds.getRight());
+        auto const y2 = floorDiv(bounds.getBottom());
+        return { x1, y1, x2 - x1, y2 - y1 };
+    }
+
+    int floorDiv(int value) const
+    {
+        return value >= 0 ? value / cellSize : -((-value + cellSize - 1) / cellSize);
+    }
+
+    static int64 getCellKey(int x, int y)
+    {
+        return (static_cast<int64>(x) << 32) | static_cast<uint32>(y);
+    }
+
+    void removeFromCells(T item, Rectangle<int> cellRange)
+    {
+        for (int x = cellRange.getX(); x <= cellRange.getRight(); x++) {
+            for (int y = cellRange.getY(); y <= cellRange.getBottom(); y++) {
+                auto cell = cells.find(getCellKey(x, y));
+                if (cell == cells.end())
+                    continue;
+
+                auto& items = cell->second;
+                items.erase(std::remove(items.begin(), items.end(), item), items.end());
+                if (items.empty())
+                    cells.erase(cell);
+            }
+        }
+    }
+
+    int const cellSize;
+    std::unordered_map<int64, std::vector<T>> cells;
+    std::unordered_map<T, ItemInfo> itemCells;
+};
@@ -228,11 +228,11 @@ private:
                 shadowPath.addRoundedRectangle(getLocalArea(c, c->getLocalBounds().reduced(shadow.radius * 0.9f)).toFloat(), windowCornerRadius);
 
                 auto radius = c->isActiveWindow() ? shadow.radius * 2.0f : shadow.radius * 1.5f;
-                StackShadow::renderDropShadow(g, shadowPath, shadow.colour, radius, shadow.offset);
+                StackShadow::renderDropShadow(*this, g, shadowPath, shadow.colour, radius, shadow.offset);
             } else {
                 auto shadowPath = Path();
                 shadowPath.addRoundedRectangle(getLocalArea(target, target->getLocalBounds()).toFloat(), shadowCornerRadius);
-                StackShadow::renderDropShadow(g, shadowPath, shadow.colour, shadow.radius, shadow.offset);
+                StackShadow::renderDropShadow(*this, g, shadowPath, shadow.colour, shadow.radius, shadow.offset);
             }
         }
 
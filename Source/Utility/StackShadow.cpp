@@ -1,26 +1,155 @@
-
 #include "StackShadow.h"
 #include <melatonin_blur/melatonin_blur.h>
 
 
 StackShadow::StackShadow()
 {
-    dropShadow = new melatonin::DropShadow();
 }
 
 StackShadow::~StackShadow()
 {
-    delete dropShadow;
+    renderPool.removeAllJobs(true, 1000);
     clearSingletonInstance();
 }
 
 void StackShadow::renderDropShadow(juce::Graphics& g, juce::Path const& path, juce::Colour color, int const radius, juce::Point<int> const offset, int spread)
 {
-    auto dropShadow = StackShadow::getInstance()->dropShadow;
-    dropShadow->setColor(color);
-    dropShadow->setOffset(offset);
-    dropShadow->setRadius(radius);
-    dropShadow->render(g, path);
+    auto const scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    StackShadow::getInstance()->render(nullptr, g, path, { color.getARGB(), radius, offset, scale });
+}
+
+void StackShadow::renderDropShadow(juce::Component& component, juce::Graphics& g, juce::Path const& path, juce::Colour color, int const radius, juce::Point<int> const offset, int spread)
+{
+    auto const scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    StackShadow::getInstance()->render(&component, g, path, { color.getARGB(), radius, offset, scale });
+}
+
+juce::String StackShadow::ShadowSettings::toString() const
+{
+    return juce::String::toHexString(colour) + ":" + juce::String(radius) + ":" + offset.toString() + ":" + juce::String(scale);
+}
+
+juce::Rectangle<float> StackShadow::getShadowArea(juce::Rectangle<float> pathBounds, ShadowSettings const& settings)
+{
+    // Leave enough space around the path for the blur and the offset
+    auto const margin = static_cast<float>(settings.radius * 2 + std::max(std::abs(settings.offset.x), std::abs(settings.offset.y)) + 1);
+    return pathBounds.withZeroOrigin().expanded(margin);
+}
+
+// Renders the shadow of a path that starts at the origin into an image, this is safe to call from any thread
+StackShadow::CachedShadow StackShadow::renderShadowImage(juce::Path const& pathAtOrigin, ShadowSettings const& settings)
+{
+    auto const area = getShadowArea(pathAtOrigin.getBounds(), settings);
+    auto const width = std::max(1, juce::roundToInt(area.getWidth() * settings.scale));
+    auto const height = std::max(1, juce::roundToInt(area.getHeight() * settings.scale));
+
+    juce::Image image(juce::Image::ARGB, width, height, true, juce::SoftwareImageType());
+    {
+        juce::Graphics g(image);
+        g.addTransform(juce::AffineTransform::translation(-area.getX(), -area.getY()).scaled(settings.scale));
+
+        melatonin::DropShadow shadow;
+        shadow.setColor(juce::Colour(settings.colour));
+        shadow.setOffset(settings.offset);
+        shadow.setRadius(settings.radius);
+        shadow.render(g, pathAtOrigin);
+    }
+
+    return { image, area };
+}
+
+void StackShadow::render(juce::Component* component, juce::Graphics& g, juce::Path const& path, ShadowSettings const& settings)
+{
+    auto const pathBounds = path.getBounds();
+
+    auto pathAtOrigin = path;
+    pathAtOrigin.applyTransform(juce::AffineTransform::translation(-pathBounds.getX(), -pathBounds.getY()));
+
+    auto const settingsKey = settings.toString();
+    auto const key = settingsKey + "|" + pathAtOrigin.toString();
+
+    auto const draw = [&g, pathBounds](CachedShadow const& shadow, juce::Rectangle<float> area) {
+        juce::Graphics::ScopedSaveState const saveState(g);
+        g.setOpacity(1.0f);
+        g.drawImage(shadow.image, area + pathBounds.getTopLeft());
+    };
+
+    auto cached = cacheEntries.find(key);
+    if (cached != cacheEntries.end()) {
+        // Move to the front, so it's the last to be removed
+        cache.splice(cache.begin(), cache, cached->second);
+        draw(cached->second->second, cached->second->second.area);
+        return;
+    }
+
+    auto lastShadow = lastShadows.find(settingsKey);
+    if (!component || lastShadow == lastShadows.end()) {
+        auto shadow = renderShadowImage(pathAtOrigin, settings);
+        draw(shadow, shadow.area);
+        addToCache(key, settingsKey, std::move(shadow));
+        return;
+    }
+
+    // Stretch the last shadow with the same settings until the new one is ready
+    draw(lastShadow->second, getShadowArea(pathBounds, settings));
+
+    auto& waitingComponents = pendingShadows[key];
+    bool const isAlreadyRendering = !waitingComponents.empty();
+
+    if (std::find(waitingComponents.begin(), waitingComponents.end(), component) == waitingComponents.end())
+        waitingComponents.emplace_back(component);
+
+    if (isAlreadyRendering)
+        return;
+
+    renderPool.addJob([key, settingsKey, pathAtOrigin, settings]() {
+        auto shadow = renderShadowImage(pathAtOrigin, settings);
+
+        juce::MessageManager::callAsync([key, settingsKey, shadow]() mutable {
+            auto* instance = StackShadow::getInstanceWithoutCreating();
+            if (!instance)
+                return;
+
+            instance->addToCache(key, settingsKey, std::move(shadow));
+
+            auto pending = instance->pendingShadows.find(key);
+            if (pending == instance->pendingShadows.end())
+                return;
+
+            auto components = std::move(pending->second);
+            instance->pendingShadows.erase(pending);
+
+            for (auto& component : components) {
+                if (component)
+                    component->repaint();
+            }
+        });
+    });
+}
+
+void StackShadow::addToCache(juce::String const& key, juce::String const& settingsKey, CachedShadow shadow)
+{
+    auto const getSize = [](CachedShadow const& cachedShadow) {
+        return static_cast<size_t>(cachedShadow.image.getWidth()) * static_cast<size_t>(cachedShadow.image.getHeight()) * 4;
+    };
+
+    auto existing = cacheEntries.find(key);
+    if (existing != cacheEntries.end()) {
+        cachedBytes -= getSize(existing->second->second);
+        cache.erase(existing->second);
+        cacheEntries.erase(existing);
+    }
+
+    lastShadows[settingsKey] = shadow;
+    cachedBytes += getSize(shadow);
+    cache.emplace_front(key, std::move(shadow));
+    cacheEntries[key] = cache.begin();
+
+    while (cache.size() > 1 && (cache.size() > maxCacheEntries || cachedBytes > maxCachedBytes)) {
+        cachedBytes -= getSize(cache.back().second);
+        cacheEntries.erase(cache.back().first);
+        cache.pop_back();
+    }
 }
 
 JUCE_IMPLEMENT_SINGLETON(StackShadow)
@@ -1,12 +1,8 @@
 #pragma once
 
 #include <juce_gui_basics/juce_gui_basics.h>
-
-// This needs to be defined before using namespace JUCE
-namespace melatonin
-{
-    class DropShadow;
-}
+#include <list>
+#include <unordered_map>
 
 struct StackShadow : public juce::DeletedAtShutdown
 {
@@ -15,8 +11,52 @@ struct StackShadow : public juce::DeletedAtShutdown
     ~StackShadow();
     
     static void renderDropShadow(juce::Graphics& g, juce::Path const& path, juce::Colour color, int const radius = 1, juce::Point<int> const offset = { 0, 0 }, int spread = 0);
-    
-    melatonin::DropShadow* dropShadow;
-    
+
+    // Same as above, but if the shadow isn't cached yet, it will be rendered on a background thread
+    // Until it's ready, the last shadow that was rendered with the same settings is stretched to fit, and the component is repainted when it's done
+    // Use this for shadows that change size often, like window and popup shadows while resizing
+    static void renderDropShadow(juce::Component& component, juce::Graphics& g, juce::Path const& path, juce::Colour color, int const radius = 1, juce::Point<int> const offset = { 0, 0 }, int spread = 0);
+
     JUCE_DECLARE_SINGLETON(StackShadow, false)
+
+private:
+    struct ShadowSettings {
+        juce::uint32 colour;
+        int radius;
+        juce::Point<int> offset;
+        float scale;
+
+        juce::String toString() const;
+    };
+
+    struct CachedShadow {
+        juce::Image image;
+        juce::Rectangle<float> area; // Area of the image, relative to the top-left of the path bounds
+    };
+
+    static juce::Rectangle<float> getShadowArea(juce::Rectangle<float> pathBounds, ShadowSettings const& settings);
+    static CachedShadow renderShadowImage(juce::Path const& pathAtOrigin, ShadowSettings const& settings);
+
+    void render(juce::Component* component, juce::Graphics& g, juce::Path const& path, ShadowSettings const& settings);
+    void addToCache(juce::String const& key, juce::String const& settingsKey, CachedShadow shadow);
+
+    struct StringHash {
+        size_t operator()(juce::String const& s) const { return static_cast<size_t>(s.hashCode64()); }
+    };
+
+    using CacheEntry = std::pair<juce::String, CachedShadow>;
+
+    // Shadow images by path shape and shadow settings, with the most recently used at the front
+    std::list<CacheEntry> cache;
+    std::unordered_map<juce::String, std::list<CacheEntry>::iterator, StringHash> cacheEntries;
+    size_t cachedBytes = 0;
+
+    // Last shadow that was rendered for each combination of shadow settings, used while a new shadow is being rendered
+    std::unordered_map<juce::String, CachedShadow, StringHash> lastShadows;
+    std::unordered_map<juce::String, std::vector<juce::Component::SafePointer<juce::Component>>, StringHash> pendingShadows;
+
+    juce::ThreadPool renderPool { 1 };
+
+    static constexpr size_t maxCachedBytes = 64 * 1024 * 1024;
+    static constexpr size_t maxCacheEntries = 128;
 };
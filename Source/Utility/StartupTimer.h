@@ -0,0 +1,41 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Measures how long each phase of startup takes
+// Some hosts time out when scanning plugins, this shows us exactly where the time goes on each platform
+class StartupTimer {
+public:
+    StartupTimer()
+        : startTime(Time::getMillisecondCounterHiRes())
+        , lastPhaseTime(startTime)
+    {
+    }
+
+    // Ends the current phase, the next phase starts right away
+    void phaseFinished(String const& name)
+    {
+        auto const currentTime = Time::getMillisecondCounterHiRes();
+        phases.emplace_back(name, currentTime - lastPhaseTime);
+        lastPhaseTime = currentTime;
+    }
+
+    String getReport() const
+    {
+        StringArray phaseTimes;
+        for (auto const& [name, duration] : phases) {
+            phaseTimes.add(name + " " + String(duration, 1) + "ms");
+        }
+
+        return "Startup took " + String(lastPhaseTime - startTime, 1) + "ms (" + phaseTimes.joinIntoString(", ") + ")";
+    }
+
+private:
+    double startTime;
+    double lastPhaseTime;
+    std::vector<std::pair<String, double>> phases;
+};
@@ -21,13 +21,15 @@ struct StringUtils {
 
     float getStringWidth(String const& text) const
     {
-        float totalWidth = 0.0f;
+        return getStringWidth(text.toRawUTF8(), static_cast<int>(text.getNumBytesAsUTF8()));
+    }
 
-        auto* utf8 = text.toRawUTF8();
-        auto numBytes = text.getNumBytesAsUTF8();
+    float getStringWidth(char const* utf8, int numBytes) const
+    {
+        float totalWidth = 0.0f;
 
         for (int i = 0; i < numBytes; i++) {
-            totalWidth += widths[(int)utf8[i]];
+            totalWidth += widths[static_cast<uint8>(utf8[i])];
         }
 
         // In real text, letters are slightly closer together
@@ -0,0 +1,86 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+// Process-wide cache of text layouts for object boxes, shared by all canvases
+// Patches often contain many boxes with the same text (like [t b b] or [r~ foo]), so we only need to lay out each of them once
+// Only use this from the message thread
+class TextLayoutCache : public DeletedAtShutdown {
+public:
+    ~TextLayoutCache() override
+    {
+        clearSingletonInstance();
+    }
+
+    static std::shared_ptr<TextLayout const> getLayout(String const& text, Font const& font, Colour colour, Justification justification, int width)
+    {
+        return getInstance()->getOrCreateLayout({ text, font.toString(), colour.getARGB(), justification.getFlags(), width }, font);
+    }
+
+    JUCE_DECLARE_SINGLETON(TextLayoutCache, false)
+
+private:
+    struct Key {
+        String text;
+        String font;
+        uint32 colour;
+        int justification;
+        int width;
+
+        bool operator==(Key const& other) const
+        {
+            return width == other.width && colour == other.colour && justification == other.justification && text == other.text && font == other.font;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(Key const& key) const
+        {
+            auto h = static_cast<size_t>(key.text.hashCode64());
+            h = h * 31 + static_cast<size_t>(key.font.hashCode64());
+            h = h * 31 + key.colour;
+            h = h * 31 + static_cast<size_t>(key.justification);
+            h = h * 31 + static_cast<size_t>(key.width);
+            return h;
+        }
+    };
+
+    using Entry = std::pair<Key, std::shared_ptr<TextLayout const>>;
+
+    std::shared_ptr<TextLayout const> getOrCreateLayout(Key const& key, Font const& font)
+    {
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            // Move to the front, so it's the last to be removed
+            leastRecentlyUsed.splice(leastRecentlyUsed.begin(), leastRecentlyUsed, it->second);
+            return it->second->second;
+        }
+
+        auto attributedText = AttributedString(key.text);
+        attributedText.setColour(Colour(key.colour));
+        attributedText.setJustification(key.justification);
+        attributedText.setFont(font);
+
+        auto layout = std::make_shared<TextLayout>();
+        layout->createLayout(attributedText, key.width);
+
+        leastRecentlyUsed.emplace_front(key, layout);
+        entries[key] = leastRecentlyUsed.begin();
+
+        if (leastRecentlyUsed.size() > maxEntries) {
+            entries.erase(leastRecentlyUsed.back().first);
+            leastRecentlyUsed.pop_back();
+        }
+
+        return layout;
+    }
+
+    static constexpr size_t maxEntries = 4096;
+
+    std::list<Entry> leastRecentlyUsed;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> entries;
+};
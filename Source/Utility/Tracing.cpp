@@ -0,0 +1,142 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <juce_events/juce_events.h>
+
+#include "Config.h"
+#include "Tracing.h"
+
+namespace Tracing {
+
+struct Event {
+    char const* name;
+    juce::int64 startTicks;
+    juce::int64 endTicks;
+};
+
+struct ThreadBuffer {
+    static constexpr juce::uint32 capacity = 1 << 15;
+
+    std::vector<Event> events = std::vector<Event>(capacity);
+    std::atomic<juce::uint32> numWritten = 0;
+
+    int threadIndex;
+    juce::String threadName;
+};
+
+// Thread buffers are never deleted, threads that exit will still show up in the next export
+static juce::CriticalSection threadBuffersLock;
+static std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+
+static std::atomic<bool> recording = false;
+static std::atomic<juce::int64> recordingStartTicks = 0;
+
+static ThreadBuffer* getBufferForCurrentThread()
+{
+    static thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer)
+        return buffer;
+
+    auto newBuffer = std::make_unique<ThreadBuffer>();
+
+    if (juce::MessageManager::existsAndIsCurrentThread()) {
+        newBuffer->threadName = "Message thread";
+    } else if (auto* thread = juce::Thread::getCurrentThread()) {
+        newBuffer->threadName = thread->getThreadName();
+    } else {
+        // Threads that aren't JUCE threads are usually the audio thread of the host or the audio device
+        newBuffer->threadName = "Audio thread";
+    }
+
+    juce::ScopedLock lock(threadBuffersLock);
+    newBuffer->threadIndex = static_cast<int>(threadBuffers.size()) + 1;
+    buffer = threadBuffers.emplace_back(std::move(newBuffer)).get();
+    return buffer;
+}
+
+ScopedEvent::~ScopedEvent()
+{
+    if (!name)
+        return;
+
+    auto* buffer = getBufferForCurrentThread();
+    auto const index = buffer->numWritten.load(std::memory_order_relaxed);
+    buffer->events[index % ThreadBuffer::capacity] = { name, startTicks, juce::Time::getHighResolutionTicks() };
+    buffer->numWritten.store(index + 1, std::memory_order_release);
+}
+
+void setRecording(bool shouldRecord)
+{
+    if (shouldRecord && !recording) {
+        juce::ScopedLock lock(threadBuffersLock);
+        for (auto& buffer : threadBuffers) {
+            buffer->numWritten = 0;
+        }
+        recordingStartTicks = juce::Time::getHighResolutionTicks();
+    }
+
+    recording = shouldRecord;
+}
+
+bool isRecording()
+{
+    return recording.load(std::memory_order_relaxed);
+}
+
+bool exportToFile(juce::File const& file)
+{
+    setRecording(false);
+
+    // Events that started before we stopped recording could still be written, give them some time to finish
+    juce::Thread::sleep(20);
+
+    auto const toMicroseconds = [](juce::int64 ticks) {
+        return juce::Time::highResolutionTicksToSeconds(ticks - recordingStartTicks) * 1e6;
+    };
+
+    juce::MemoryOutputStream json;
+    json << "{\"traceEvents\":[";
+
+    bool isFirstEvent = true;
+    auto const addEvent = [&json, &isFirstEvent](juce::String const& event) {
+        if (!isFirstEvent)
+            json << ",";
+        json << "\n" << event;
+        isFirstEvent = false;
+    };
+
+    {
+        juce::ScopedLock lock(threadBuffersLock);
+        for (auto& buffer : threadBuffers) {
+            auto const numWritten = buffer->numWritten.load(std::memory_order_acquire);
+            if (numWritten == 0)
+                continue;
+
+            auto const tid = juce::String(buffer->threadIndex);
+            addEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":" + juce::JSON::toString(buffer->threadName) + "}}");
+
+            auto const first = numWritten > ThreadBuffer::capacity ? numWritten - ThreadBuffer::capacity : 0;
+            for (auto i = first; i < numWritten; i++) {
+                auto const& event = buffer->events[i % ThreadBuffer::capacity];
+                auto const start = toMicroseconds(event.startTicks);
+                auto const duration = toMicroseconds(event.endTicks) - start;
+                addEvent("{\"name\":\"" + juce::String(event.name) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + tid + ",\"ts\":" + juce::String(start, 3) + ",\"dur\":" + juce::String(duration, 3) + "}");
+            }
+        }
+    }
+
+    json << "\n]}\n";
+
+    file.getParentDirectory().createDirectory();
+    return file.replaceWithData(json.getData(), json.getDataSize());
+}
+
+juce::File getDefaultTraceFile()
+{
+    return ProjectInfo::appDataDir.getChildFile("Traces").getChildFile("trace-" + juce::Time::getCurrentTime().formatted("%Y-%m-%d-%H%M%S") + ".json");
+}
+
+}
@@ -0,0 +1,45 @@
+/*
+ // Copyright (c) 2021-2023 Timothy Schoen and Alex Mitchell
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Lightweight trace recorder, for finding out what happened around a glitch when we can't attach a profiler
+// Every thread writes its events into its own ring buffer, so recording an event never locks or allocates
+// (except for the first event on a thread, which creates its buffer)
+// The recording can be exported in the Chrome trace format, which can be opened in Perfetto or chrome://tracing
+namespace Tracing {
+
+void setRecording(bool shouldRecord);
+bool isRecording();
+
+// Stops recording and writes all events that are still in the buffers to a JSON file
+bool exportToFile(juce::File const& file);
+
+// Default location for exported traces, used when tracing is controlled from a patch
+juce::File getDefaultTraceFile();
+
+// Records the time from construction to destruction as an event
+// The name must be a string literal, since we only store the pointer
+class ScopedEvent {
+public:
+    explicit ScopedEvent(char const* eventName)
+        : name(isRecording() ? eventName : nullptr)
+        , startTicks(name ? juce::Time::getHighResolutionTicks() : 0)
+    {
+    }
+
+    ~ScopedEvent();
+
+private:
+    char const* name;
+    juce::int64 startTicks;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedEvent)
+};
+
+}
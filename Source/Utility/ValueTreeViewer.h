@@ -493,8 +493,17 @@ public:
     }
     
     void setFilterString(const String& toFilter)
+    {
+        setFilter(toFilter, [toFilter](ValueTree const& node) {
+            return node.getProperty("Name").toString().containsIgnoreCase(toFilter) || node.getProperty("SearchText").toString().containsIgnoreCase(toFilter);
+        });
+    }
+
+    // Like setFilterString, but the caller decides which nodes match, so the matching itself can be done on another thread
+    void setFilter(const String& toFilter, std::function<bool(ValueTree const&)> matches)
     {
         filterString = toFilter;
+        filterMatches = std::move(matches);
         
         if(filterString.isEmpty())
         {
@@ -544,7 +553,7 @@ private:
     bool searchInNode(ValueTreeNodeComponent* node)
     {
         // Check if the current node matches the filterString
-        bool found = filterString.isEmpty() || node->valueTreeNode.getProperty("Name").toString().containsIgnoreCase(filterString);
+        bool found = filterString.isEmpty() || filterMatches(node->valueTreeNode);
         
         for (auto* child : node->nodes)
         {
@@ -595,6 +604,7 @@ private:
     }
     
     String filterString;
+    std::function<bool(ValueTree const&)> filterMatches;
     String tooltipPrepend;
     ValueTreeOwnerView contentComponent;
     OwnedArray<ValueTreeNodeComponent> nodes;
@@ -77,3 +77,227 @@ TEST_CASE("Create and delete objects", "[name]")
     
     StopApplicationAfter(1500);
 }
+
+// Benchmarks for the canvas operations that get slow in big patches
+// These are hidden from the normal test run, run them with: Tests "[benchmark]" --reporter JSON::out=benchmark.json
+// The size of the generated patches can be set with the PLUGDATA_BENCHMARK_SIZE environment variable
+static int getBenchmarkPatchSize()
+{
+    auto size = SystemStats::getEnvironmentVariable("PLUGDATA_BENCHMARK_SIZE", "1000").getIntValue();
+    return size > 0 ? size : 1000;
+}
+
+// Generates a patch with a mix of plain and GUI objects, each connected to the one before it
+static String generateBenchmarkPatch(int numObjects)
+{
+    StringArray objectTypes = { "osc~ 440", "*~ 0.5", "f", "+ 1", "tgl 15 0 empty empty empty 17 7 0 10 #fcfcfc #000000 #000000 0 1", "floatatom 5 0 0 0 - - - 0" };
+
+    String patch = "#N canvas 0 0 1000 1000 12;\n";
+    for (int i = 0; i < numObjects; i++) {
+        auto type = objectTypes[i % objectTypes.size()];
+        auto position = String(40 + (i % 20) * 90) + " " + String(40 + (i / 20) * 40);
+        patch += type.startsWith("floatatom") ? "#X " + type.replace("floatatom", "floatatom " + position) + ";\n" : "#X obj " + position + " " + type + ";\n";
+    }
+
+    // Only connect objects of the same type, so signal outlets don't end up in control inlets
+    for (int i = objectTypes.size(); i < numObjects; i++) {
+        patch += "#X connect " + String(i - objectTypes.size()) + " 0 " + String(i) + " 0;\n";
+    }
+
+    return patch;
+}
+
+TEST_CASE("Canvas benchmarks", "[.][benchmark]")
+{
+    StartApplication;
+
+    MessageManager::callAsync([=]() {
+        auto const numObjects = getBenchmarkPatchSize();
+        auto const patchText = generateBenchmarkPatch(numObjects);
+
+        BENCHMARK_ADVANCED("Open patch with " + std::to_string(numObjects) + " objects")(Catch::Benchmark::Chronometer meter)
+        {
+            auto patch = editor->pd->loadPatch(patchText, nullptr);
+            std::unique_ptr<Canvas> cnv;
+
+            meter.measure([&]() {
+                cnv = std::make_unique<Canvas>(editor, *patch, nullptr);
+            });
+
+            cnv.reset();
+            editor->pd->patches.removeAllInstancesOf(patch);
+        };
+
+        auto patch = editor->pd->loadPatch(patchText, nullptr);
+        auto cnv = std::make_unique<Canvas>(editor, *patch, nullptr);
+        cnv->setSize(1920, 1080);
+
+        BENCHMARK("Synchronise canvas with " + std::to_string(numObjects) + " objects")
+        {
+            cnv->performSynchronise();
+        };
+
+        BENCHMARK("Paste and undo " + std::to_string(numObjects) + " objects")
+        {
+            SystemClipboard::copyTextToClipboard(patchText);
+            cnv->pasteSelection();
+            cnv->undo();
+        };
+
+        auto renderFrame = [&cnv](float scale) {
+            auto area = cnv->getLocalBounds().withPosition(cnv->canvasOrigin);
+            return cnv->createComponentSnapshot(area, false, scale);
+        };
+
+        BENCHMARK("Drag frame with " + std::to_string(numObjects) + " objects selected")
+        {
+            for (auto* object : cnv->objects) {
+                object->setBufferedToImage(true);
+                object->setTopLeftPosition(object->getPosition().translated(1, 0));
+            }
+            return renderFrame(1.0f);
+        };
+
+        BENCHMARK("Zoomed repaint with " + std::to_string(numObjects) + " objects")
+        {
+            return renderFrame(2.0f);
+        };
+
+        cnv.reset();
+        editor->pd->patches.removeAllInstancesOf(patch);
+    });
+
+    StopApplicationAfter(500);
+}
+
+// DSP regression tests: renders every patch in the corpus offline, without an editor, and compares the output to a stored golden file
+// These are hidden from the normal test run, run them with: Tests "[dsp]"
+// After a change that is supposed to change the output, run them once with PLUGDATA_UPDATE_GOLDEN=1 to write new golden files
+// The corpus can be changed with PLUGDATA_DSP_CORPUS (directories separated by ';'), and the allowed difference per sample with PLUGDATA_DSP_TOLERANCE
+static Array<File> getDSPCorpus()
+{
+    auto corpusDirectories = StringArray::fromTokens(SystemStats::getEnvironmentVariable("PLUGDATA_DSP_CORPUS", String(PLUGDATA_SOURCE_DIR) + "/Resources/Patches"), ";", "");
+
+    Array<File> patches;
+    for (auto const& directory : corpusDirectories) {
+        patches.addArray(File(directory).findChildFiles(File::findFiles, true, "*.pd"));
+    }
+
+    // Sort, so the order doesn't depend on the file system
+    std::sort(patches.begin(), patches.end(), [](File const& a, File const& b) { return a.getFullPathName() < b.getFullPathName(); });
+    return patches;
+}
+
+static File getGoldenFile(File const& patch)
+{
+    return File(PLUGDATA_SOURCE_DIR).getChildFile("Tests").getChildFile("Golden").getChildFile(patch.getParentDirectory().getFileName() + "_" + patch.getFileNameWithoutExtension() + ".wav");
+}
+
+static AudioBuffer<float> renderPatchOffline(PluginProcessor& processor, File const& patchFile, int numChannels, int numSamples, int blockSize)
+{
+    auto patch = processor.loadPatch(patchFile, nullptr);
+    if (!patch)
+        return {};
+
+    AudioBuffer<float> output(numChannels, numSamples);
+    AudioBuffer<float> block(numChannels, blockSize);
+    MidiBuffer midiBuffer;
+
+    for (int position = 0; position < numSamples; position += blockSize) {
+        block.clear();
+        midiBuffer.clear();
+        processor.processBlock(block, midiBuffer);
+
+        auto const numToCopy = std::min(blockSize, numSamples - position);
+        for (int ch = 0; ch < numChannels; ch++) {
+            output.copyFrom(ch, position, block, ch, 0, numToCopy);
+        }
+    }
+
+    processor.patches.removeAllInstancesOf(patch);
+    return output;
+}
+
+static bool writeGoldenFile(File const& file, AudioBuffer<float> const& buffer, double sampleRate)
+{
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+
+    // 32-bit WAV files store floats, so the golden output is exact
+    auto stream = std::unique_ptr<OutputStream>(file.createOutputStream().release());
+    auto writer = std::unique_ptr<AudioFormatWriter>(WavAudioFormat().createWriterFor(stream.get(), sampleRate, buffer.getNumChannels(), 32, {}, 0));
+    if (!writer)
+        return false;
+
+    stream.release(); // The writer owns the stream now
+    return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+static AudioBuffer<float> readGoldenFile(File const& file)
+{
+    auto reader = std::unique_ptr<AudioFormatReader>(WavAudioFormat().createReaderFor(file.createInputStream().release(), true));
+    if (!reader)
+        return {};
+
+    AudioBuffer<float> buffer(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+    reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+    return buffer;
+}
+
+TEST_CASE("DSP regression", "[.][dsp]")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 64;
+    constexpr int numChannels = 2;
+    constexpr int numSamples = static_cast<int>(sampleRate) * 2;
+
+    auto const tolerance = SystemStats::getEnvironmentVariable("PLUGDATA_DSP_TOLERANCE", "1e-6").getFloatValue();
+    auto const updateGolden = SystemStats::getEnvironmentVariable("PLUGDATA_UPDATE_GOLDEN", "0").getIntValue() != 0;
+
+    // The processor needs a MessageManager to exist, but we never run its loop
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    auto processor = std::make_unique<PluginProcessor>();
+    processor->setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    processor->setNonRealtime(true);
+    processor->prepareToPlay(sampleRate, blockSize);
+
+    for (auto const& patchFile : getDSPCorpus()) {
+        DYNAMIC_SECTION(patchFile.getFileName())
+        {
+            auto const output = renderPatchOffline(*processor, patchFile, numChannels, numSamples, blockSize);
+            REQUIRE(output.getNumSamples() == numSamples);
+
+            auto const goldenFile = getGoldenFile(patchFile);
+            if (updateGolden) {
+                REQUIRE(writeGoldenFile(goldenFile, output, sampleRate));
+                continue;
+            }
+
+            // A patch without golden output would pass without checking anything
+            if (!goldenFile.existsAsFile()) {
+                FAIL("No golden output for " + patchFile.getFullPathName() + ", render it with PLUGDATA_UPDATE_GOLDEN=1 and commit it to Tests/Golden");
+            }
+
+            auto const golden = readGoldenFile(goldenFile);
+            REQUIRE(golden.getNumChannels() == numChannels);
+            REQUIRE(golden.getNumSamples() == numSamples);
+
+            float maxDifference = 0.0f;
+            int firstDifference = -1;
+            for (int ch = 0; ch < numChannels; ch++) {
+                for (int i = 0; i < numSamples; i++) {
+                    auto const difference = std::abs(output.getSample(ch, i) - golden.getSample(ch, i));
+                    if (difference > tolerance && (firstDifference < 0 || i < firstDifference))
+                        firstDifference = i;
+                    maxDifference = std::max(maxDifference, difference);
+                }
+            }
+
+            INFO("Max difference: " << maxDifference << ", first sample over tolerance: " << firstDifference);
+            CHECK(maxDifference <= tolerance);
+        }
+    }
+
+    processor->releaseResources();
+}